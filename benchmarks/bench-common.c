@@ -0,0 +1,453 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * bench-common.c -- the common functions of the benchmarks
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "bench-common.h"
+
+/*
+ * bench_now_ns -- the current value of the monotonic clock in nanoseconds
+ */
+uint64_t
+bench_now_ns(void)
+{
+	struct timespec ts;
+
+	(void) clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/*
+ * bench_parse_size -- parse a size with an optional k/m/g suffix
+ */
+int
+bench_parse_size(const char *str, uint64_t *size)
+{
+	char *end;
+
+	errno = 0;
+	unsigned long long val = strtoull(str, &end, 10);
+	if (errno || end == str)
+		return -1;
+
+	switch (*end) {
+	case 'k':
+	case 'K':
+		val <<= 10;
+		end++;
+		break;
+	case 'm':
+	case 'M':
+		val <<= 20;
+		end++;
+		break;
+	case 'g':
+	case 'G':
+		val <<= 30;
+		end++;
+		break;
+	default:
+		break;
+	}
+
+	if (*end != '\0')
+		return -1;
+
+	*size = val;
+
+	return 0;
+}
+
+/*
+ * bench_parse_list -- parse a comma-separated list of sizes
+ */
+int
+bench_parse_list(const char *str, uint64_t vals[BENCH_LIST_MAX])
+{
+	char buf[256];
+	int n = 0;
+
+	if (strlen(str) >= sizeof(buf))
+		return -1;
+	strcpy(buf, str);
+
+	char *saveptr = NULL;
+	for (char *tok = strtok_r(buf, ",", &saveptr); tok != NULL;
+			tok = strtok_r(NULL, ",", &saveptr)) {
+		if (n == BENCH_LIST_MAX || bench_parse_size(tok, &vals[n]))
+			return -1;
+		n++;
+	}
+
+	return n ? n : -1;
+}
+
+/*
+ * bench_rand -- the next value of the xorshift64* generator
+ */
+uint64_t
+bench_rand(uint64_t *seed)
+{
+	uint64_t x = *seed;
+
+	x ^= x >> 12;
+	x ^= x << 25;
+	x ^= x >> 27;
+	*seed = x;
+
+	return x * 0x2545F4914F6CDD1DULL;
+}
+
+/*
+ * bench_lat_init -- initialize the latencies keeping at most capacity samples
+ */
+int
+bench_lat_init(struct bench_lat *lat, uint64_t capacity)
+{
+	memset(lat, 0, sizeof(*lat));
+
+	lat->samples = malloc(capacity * sizeof(*lat->samples));
+	if (lat->samples == NULL)
+		return -1;
+
+	lat->capacity = capacity;
+	lat->seed = (uint64_t)(uintptr_t)lat ^ bench_now_ns();
+	if (lat->seed == 0)
+		lat->seed = 1;
+	bench_lat_reset(lat);
+
+	return 0;
+}
+
+/*
+ * bench_lat_fini -- release the samples of the latencies
+ */
+void
+bench_lat_fini(struct bench_lat *lat)
+{
+	free(lat->samples);
+	lat->samples = NULL;
+	lat->capacity = 0;
+	lat->nsamples = 0;
+}
+
+/*
+ * bench_lat_reset -- forget all the recorded latencies
+ */
+void
+bench_lat_reset(struct bench_lat *lat)
+{
+	lat->count = 0;
+	lat->min = UINT64_MAX;
+	lat->max = 0;
+	lat->sum = 0.0;
+	lat->sumsq = 0.0;
+	lat->nsamples = 0;
+	lat->sorted = 0;
+}
+
+/*
+ * bench_lat_record -- record the latency of an operation
+ */
+void
+bench_lat_record(struct bench_lat *lat, uint64_t ns)
+{
+	lat->count++;
+	if (ns < lat->min)
+		lat->min = ns;
+	if (ns > lat->max)
+		lat->max = ns;
+	lat->sum += (double)ns;
+	lat->sumsq += (double)ns * (double)ns;
+	lat->sorted = 0;
+
+	/* the reservoir sampling (Algorithm R) */
+	if (lat->nsamples < lat->capacity) {
+		lat->samples[lat->nsamples++] = ns;
+		return;
+	}
+
+	uint64_t i = bench_rand(&lat->seed) % lat->count;
+	if (i < lat->capacity)
+		lat->samples[i] = ns;
+}
+
+/*
+ * bench_lat_pick -- move k random samples of lat to its beginning
+ * (a partial Fisher-Yates shuffle)
+ */
+static void
+bench_lat_pick(uint64_t *samples, uint64_t n, uint64_t k, uint64_t *seed)
+{
+	for (uint64_t i = 0; i < k && i < n; i++) {
+		uint64_t j = i + bench_rand(seed) % (n - i);
+		uint64_t tmp = samples[i];
+
+		samples[i] = samples[j];
+		samples[j] = tmp;
+	}
+}
+
+/*
+ * bench_lat_merge -- add the latencies of src to dst
+ */
+void
+bench_lat_merge(struct bench_lat *dst, const struct bench_lat *src)
+{
+	if (src->count == 0)
+		return;
+
+	uint64_t total = dst->count + src->count;
+
+	if (dst->nsamples + src->nsamples <= dst->capacity) {
+		memcpy(dst->samples + dst->nsamples, src->samples,
+				src->nsamples * sizeof(*src->samples));
+		dst->nsamples += src->nsamples;
+	} else {
+		/* both parts of the sample stand for their share of the total */
+		uint64_t k_src = (uint64_t)((double)dst->capacity *
+				(double)src->count / (double)total + 0.5);
+		if (k_src > src->nsamples)
+			k_src = src->nsamples;
+		uint64_t k_dst = dst->capacity - k_src;
+		if (k_dst > dst->nsamples)
+			k_dst = dst->nsamples;
+
+		bench_lat_pick(dst->samples, dst->nsamples, k_dst, &dst->seed);
+
+		/* pick from src at random without modifying it */
+		for (uint64_t i = 0; i < k_src; i++) {
+			uint64_t j = (uint64_t)((double)i * (double)src->nsamples /
+					(double)k_src);
+			dst->samples[k_dst + i] = src->samples[j];
+		}
+		dst->nsamples = k_dst + k_src;
+	}
+
+	dst->count = total;
+	if (src->min < dst->min)
+		dst->min = src->min;
+	if (src->max > dst->max)
+		dst->max = src->max;
+	dst->sum += src->sum;
+	dst->sumsq += src->sumsq;
+	dst->sorted = 0;
+}
+
+/*
+ * bench_lat_avg -- the average latency in nanoseconds
+ */
+double
+bench_lat_avg(const struct bench_lat *lat)
+{
+	return lat->count ? lat->sum / (double)lat->count : 0.0;
+}
+
+/*
+ * bench_lat_stdev -- the standard deviation of the latencies in nanoseconds
+ */
+double
+bench_lat_stdev(const struct bench_lat *lat)
+{
+	if (lat->count < 2)
+		return 0.0;
+
+	double avg = bench_lat_avg(lat);
+	double var = lat->sumsq / (double)lat->count - avg * avg;
+
+	return var > 0.0 ? sqrt(var) : 0.0;
+}
+
+/*
+ * bench_u64_cmp -- compare two uint64_t values (for qsort)
+ */
+static int
+bench_u64_cmp(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *)a;
+	uint64_t y = *(const uint64_t *)b;
+
+	return (x > y) - (x < y);
+}
+
+/*
+ * bench_lat_percentile -- the latency which the given percentage
+ * of the sampled latencies does not exceed
+ */
+uint64_t
+bench_lat_percentile(struct bench_lat *lat, double pct)
+{
+	if (lat->nsamples == 0)
+		return 0;
+
+	if (!lat->sorted) {
+		qsort(lat->samples, lat->nsamples, sizeof(*lat->samples),
+				bench_u64_cmp);
+		lat->sorted = 1;
+	}
+
+	uint64_t rank = (uint64_t)ceil(pct / 100.0 * (double)lat->nsamples);
+	if (rank == 0)
+		rank = 1;
+	if (rank > lat->nsamples)
+		rank = lat->nsamples;
+
+	return lat->samples[rank - 1];
+}
+
+/*
+ * bench_json_open -- open the output file
+ */
+int
+bench_json_open(struct bench_json *js, const char *path)
+{
+	js->nrows = 0;
+	js->nkeys = 0;
+
+	if (strcmp(path, "-") == 0) {
+		js->file = stdout;
+	} else {
+		js->file = fopen(path, "w");
+		if (js->file == NULL) {
+			perror(path);
+			return -1;
+		}
+	}
+
+	(void) fputs("[", js->file);
+
+	return 0;
+}
+
+/*
+ * bench_json_close -- finish the list of rows and close the output file
+ */
+int
+bench_json_close(struct bench_json *js)
+{
+	(void) fputs(js->nrows ? "\n]\n" : "]\n", js->file);
+
+	if (js->file == stdout)
+		return fflush(stdout) ? -1 : 0;
+
+	if (fclose(js->file)) {
+		perror("fclose");
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * bench_json_row_begin -- start a row
+ */
+void
+bench_json_row_begin(struct bench_json *js)
+{
+	(void) fprintf(js->file, "%s\n    {", js->nrows ? "," : "");
+	js->nkeys = 0;
+}
+
+/*
+ * bench_json_row_end -- finish a row
+ */
+void
+bench_json_row_end(struct bench_json *js)
+{
+	(void) fputs("\n    }", js->file);
+	js->nrows++;
+}
+
+/*
+ * bench_json_key -- start a value of the current row
+ */
+static void
+bench_json_key(struct bench_json *js, const char *key)
+{
+	(void) fprintf(js->file, "%s\n        \"%s\": ",
+			js->nkeys ? "," : "", key);
+	js->nkeys++;
+}
+
+/*
+ * bench_json_str -- add a string to the current row
+ */
+void
+bench_json_str(struct bench_json *js, const char *key, const char *val)
+{
+	bench_json_key(js, key);
+	(void) fputc('"', js->file);
+	for (; *val; val++) {
+		if (*val == '"' || *val == '\\')
+			(void) fputc('\\', js->file);
+		(void) fputc(*val, js->file);
+	}
+	(void) fputc('"', js->file);
+}
+
+/*
+ * bench_json_uint -- add an integer to the current row
+ */
+void
+bench_json_uint(struct bench_json *js, const char *key, uint64_t val)
+{
+	bench_json_key(js, key);
+	(void) fprintf(js->file, "%llu", (unsigned long long)val);
+}
+
+/*
+ * bench_json_double -- add a number to the current row
+ */
+void
+bench_json_double(struct bench_json *js, const char *key, double val)
+{
+	bench_json_key(js, key);
+	(void) fprintf(js->file, "%.2f", isfinite(val) ? val : 0.0);
+}
+
+/*
+ * bench_json_lat -- add the lat_* values (in microseconds) to the current row
+ */
+void
+bench_json_lat(struct bench_json *js, struct bench_lat *lat)
+{
+	bench_json_double(js, "lat_min",
+			lat->count ? (double)lat->min / 1000.0 : 0.0);
+	bench_json_double(js, "lat_max", (double)lat->max / 1000.0);
+	bench_json_double(js, "lat_avg", bench_lat_avg(lat) / 1000.0);
+	bench_json_double(js, "lat_stdev", bench_lat_stdev(lat) / 1000.0);
+	bench_json_double(js, "lat_pctl_99.0",
+			(double)bench_lat_percentile(lat, 99.0) / 1000.0);
+	bench_json_double(js, "lat_pctl_99.9",
+			(double)bench_lat_percentile(lat, 99.9) / 1000.0);
+	bench_json_double(js, "lat_pctl_99.99",
+			(double)bench_lat_percentile(lat, 99.99) / 1000.0);
+	bench_json_double(js, "lat_pctl_99.999",
+			(double)bench_lat_percentile(lat, 99.999) / 1000.0);
+}
+
+/*
+ * bench_print_lat -- print a human-readable summary of the latencies
+ */
+void
+bench_print_lat(FILE *file, const char *prefix, struct bench_lat *lat)
+{
+	(void) fprintf(file,
+			"%s lat [usec]: min %.2f avg %.2f max %.2f stdev %.2f 99%% %.2f 99.9%% %.2f\n",
+			prefix,
+			lat->count ? (double)lat->min / 1000.0 : 0.0,
+			bench_lat_avg(lat) / 1000.0,
+			(double)lat->max / 1000.0,
+			bench_lat_stdev(lat) / 1000.0,
+			(double)bench_lat_percentile(lat, 99.0) / 1000.0,
+			(double)bench_lat_percentile(lat, 99.9) / 1000.0);
+}
@@ -0,0 +1,159 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * bench-common.h -- the common functions of the benchmarks
+ */
+
+#ifndef BENCH_COMMON_H
+#define BENCH_COMMON_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+/* the maximum number of values of a comma-separated list of an option */
+#define BENCH_LIST_MAX 32
+
+/* the default number of latency samples kept per thread */
+#define BENCH_LAT_SAMPLES 1000000
+
+/*
+ * bench_now_ns -- the current value of the monotonic clock in nanoseconds
+ */
+uint64_t bench_now_ns(void);
+
+/*
+ * bench_parse_size -- parse a size with an optional k/m/g suffix
+ * (powers of 1024); returns 0 on success and -1 on error
+ */
+int bench_parse_size(const char *str, uint64_t *size);
+
+/*
+ * bench_parse_list -- parse a comma-separated list of sizes into vals
+ * (at most BENCH_LIST_MAX of them); returns the number of the values
+ * or -1 on error
+ */
+int bench_parse_list(const char *str, uint64_t vals[BENCH_LIST_MAX]);
+
+/*
+ * bench_rand -- the next pseudo-random value of the xorshift64* generator
+ * of the (non-zero) seed
+ */
+uint64_t bench_rand(uint64_t *seed);
+
+/*
+ * struct bench_lat -- the latencies (in nanoseconds) of the operations
+ *
+ * The minimum, the maximum, the average and the standard deviation are
+ * exact, the percentiles are calculated from a uniform random sample
+ * (a reservoir) of at most capacity latencies.
+ */
+struct bench_lat {
+	uint64_t count;
+	uint64_t min;
+	uint64_t max;
+	double sum;
+	double sumsq;
+
+	uint64_t *samples;
+	uint64_t nsamples;
+	uint64_t capacity;
+	uint64_t seed;
+	int sorted;
+};
+
+/*
+ * bench_lat_init -- initialize the latencies keeping at most capacity samples;
+ * returns 0 on success and -1 on allocation failure
+ */
+int bench_lat_init(struct bench_lat *lat, uint64_t capacity);
+
+/*
+ * bench_lat_fini -- release the samples of the latencies
+ */
+void bench_lat_fini(struct bench_lat *lat);
+
+/*
+ * bench_lat_reset -- forget all the recorded latencies
+ */
+void bench_lat_reset(struct bench_lat *lat);
+
+/*
+ * bench_lat_record -- record the latency of an operation
+ */
+void bench_lat_record(struct bench_lat *lat, uint64_t ns);
+
+/*
+ * bench_lat_merge -- add the latencies of src to dst (the samples of src
+ * replace the samples of dst in proportion to the number of latencies they
+ * stand for)
+ */
+void bench_lat_merge(struct bench_lat *dst, const struct bench_lat *src);
+
+/*
+ * bench_lat_avg -- the average latency in nanoseconds
+ */
+double bench_lat_avg(const struct bench_lat *lat);
+
+/*
+ * bench_lat_stdev -- the standard deviation of the latencies in nanoseconds
+ */
+double bench_lat_stdev(const struct bench_lat *lat);
+
+/*
+ * bench_lat_percentile -- the latency in nanoseconds which the given
+ * percentage of the sampled latencies does not exceed
+ */
+uint64_t bench_lat_percentile(struct bench_lat *lat, double pct);
+
+/*
+ * struct bench_json -- an output file of the results
+ *
+ * The results are written as a JSON list of rows (flat objects) in
+ * the format of the results of tools/perf (see tools/perf/lib/format),
+ * so the file can be used by report_figures.py and report_create.py as is.
+ */
+struct bench_json {
+	FILE *file;
+	int nrows;
+	int nkeys;
+};
+
+/*
+ * bench_json_open -- open the output file ("-" means stdout); returns 0
+ * on success and -1 on error
+ */
+int bench_json_open(struct bench_json *js, const char *path);
+
+/*
+ * bench_json_close -- finish the list of rows and close the output file;
+ * returns 0 on success and -1 on error
+ */
+int bench_json_close(struct bench_json *js);
+
+/*
+ * bench_json_row_begin, bench_json_row_end -- start and finish a row
+ */
+void bench_json_row_begin(struct bench_json *js);
+void bench_json_row_end(struct bench_json *js);
+
+/*
+ * bench_json_str, bench_json_uint, bench_json_double -- add a value
+ * to the current row
+ */
+void bench_json_str(struct bench_json *js, const char *key, const char *val);
+void bench_json_uint(struct bench_json *js, const char *key, uint64_t val);
+void bench_json_double(struct bench_json *js, const char *key, double val);
+
+/*
+ * bench_json_lat -- add the lat_* values (in microseconds) of the latencies
+ * to the current row
+ */
+void bench_json_lat(struct bench_json *js, struct bench_lat *lat);
+
+/*
+ * bench_print_lat -- print a human-readable summary of the latencies
+ */
+void bench_print_lat(FILE *file, const char *prefix, struct bench_lat *lat);
+
+#endif /* BENCH_COMMON_H */
@@ -0,0 +1,675 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * rpma-bench-conn.c -- the benchmark of the connection setup and teardown
+ *
+ * The same binary is run as a server and as a client:
+ *
+ * - the server accepts the connections from a single thread using epoll
+ *   and deletes them as soon as they are closed by the clients,
+ * - the client opens and closes the given number of connections for every
+ *   given number of threads (the concurrency): every thread opens
+ *   a connection, waits for it to be established, closes and deletes it
+ *   and starts over until the connections run out.
+ *
+ * The durations of the phases of every connection are measured:
+ * - resolve - resolving the address of the server,
+ * - route - resolving the route to the server,
+ * - qp_create - creating the CQs and the QP,
+ * - flush_reg - creating the flushing object (registering its buffer
+ *   of the appliance persistency method),
+ * - handshake - from sending the connection request until the connection
+ *   is established,
+ * - setup - the whole setup from rpma_conn_req_new() until the connection
+ *   is established,
+ * - delete - from rpma_conn_disconnect() until the connection is closed
+ *   and deleted.
+ *
+ * The first five ones are reported by the library
+ * (see rpma_conn_get_setup_times(3)). The results are printed
+ * in a human-readable form and, if requested, written to a JSON file
+ * in the format of the results of tools/perf.
+ */
+
+#include <errno.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <librpma.h>
+
+#include "common-conn.h"
+#include "common-epoll.h"
+#include "bench-common.h"
+
+#define USAGE_STR \
+"usage: %s server <server_address> <port> [<options>]\n\
+       %s client <server_address> <port> [<options>]\n\
+\n\
+server options:\n\
+  -n, --conns=<n>        exit after serving n connections (default: never)\n\
+\n\
+client options:\n\
+  -c, --conns=<n>        connections opened and closed for every number\n\
+                         of threads (default 1000)\n\
+  -t, --threads=<list>   numbers of threads opening the connections\n\
+                         concurrently (default 1)\n\
+  -w, --warmup=<n>       connections opened and closed before measuring\n\
+                         (default 10)\n\
+  -q, --queue=<n>        size of SQ, RQ and CQ (default: librpma defaults)\n\
+  -j, --json=<path>      write the results as JSON ('-' means stdout)\n\
+  -S, --samples=<n>      latency samples kept per phase and thread\n\
+                         (default %u)\n\
+\n\
+a <list> is a comma-separated list of values (e.g. 1,4,16)\n"
+
+/* the maximum number of the epoll events handled at once */
+#define BENCH_EVENTS_MAX 64
+
+/* latency samples kept per phase by the server */
+#define BENCH_SERVER_SAMPLES 65536
+
+enum bench_phase {
+	BENCH_PHASE_RESOLVE,
+	BENCH_PHASE_ROUTE,
+	BENCH_PHASE_QP_CREATE,
+	BENCH_PHASE_FLUSH_REG,
+	BENCH_PHASE_HANDSHAKE,
+	BENCH_PHASE_SETUP,
+	BENCH_PHASE_DELETE,
+	BENCH_PHASE_MAX
+};
+
+static const char *const bench_phase_names[BENCH_PHASE_MAX] = {
+	"resolve",
+	"route",
+	"qp_create",
+	"flush_reg",
+	"handshake",
+	"setup",
+	"delete",
+};
+
+/*
+ * print_phases -- print a human-readable summary of the given phases
+ */
+static void
+print_phases(FILE *file, struct bench_lat *lat, int first, int last)
+{
+	char prefix[32];
+
+	for (int p = first; p <= last; p++) {
+		(void) snprintf(prefix, sizeof(prefix), "   %-9s",
+				bench_phase_names[p]);
+		bench_print_lat(file, prefix, &lat[p]);
+	}
+}
+
+/* the server */
+
+struct server {
+	struct rpma_ep *ep;
+	int epoll;
+	struct custom_event ev_incoming;
+
+	/* the connections closed so far */
+	long served;
+
+	/* the setup phases of the passive side */
+	struct bench_lat lat[BENCH_PHASE_MAX];
+};
+
+struct server_conn {
+	struct server *srv;
+	struct rpma_conn *conn;
+	struct custom_event ev;
+};
+
+/*
+ * server_conn_delete -- stop watching the connection and delete it
+ */
+static void
+server_conn_delete(struct server_conn *sc)
+{
+	struct server *srv = sc->srv;
+
+	if (sc->ev.fd != -1)
+		epoll_delete(srv->epoll, &sc->ev);
+	(void) rpma_conn_disconnect(sc->conn);
+	(void) rpma_conn_delete(&sc->conn);
+	free(sc);
+
+	srv->served++;
+}
+
+/*
+ * server_handle_conn_event -- record the setup times of the established
+ * connection or delete the closed one
+ */
+static void
+server_handle_conn_event(struct custom_event *ce)
+{
+	struct server_conn *sc = ce->arg;
+	struct server *srv = sc->srv;
+	struct rpma_conn_setup_times times;
+	enum rpma_conn_event event = RPMA_CONN_UNDEFINED;
+
+	int ret = rpma_conn_next_event(sc->conn, &event);
+	if (ret == RPMA_E_NO_EVENT)
+		return;
+
+	if (!ret && event == RPMA_CONN_ESTABLISHED) {
+		if (rpma_conn_get_setup_times(sc->conn, &times) == 0) {
+			bench_lat_record(&srv->lat[BENCH_PHASE_QP_CREATE],
+					times.qp_create_ns);
+			bench_lat_record(&srv->lat[BENCH_PHASE_FLUSH_REG],
+					times.flush_reg_ns);
+			bench_lat_record(&srv->lat[BENCH_PHASE_HANDSHAKE],
+					times.handshake_ns);
+		}
+		return;
+	}
+
+	/* the connection is closed, lost or broken */
+	server_conn_delete(sc);
+}
+
+/*
+ * server_handle_incoming -- accept the incoming connection request
+ */
+static void
+server_handle_incoming(struct custom_event *ce)
+{
+	struct server *srv = ce->arg;
+	struct rpma_conn_req *req = NULL;
+	int fd;
+
+	if (rpma_ep_next_conn_req(srv->ep, NULL, &req))
+		return;
+
+	struct server_conn *sc = calloc(1, sizeof(*sc));
+	if (sc == NULL) {
+		(void) rpma_conn_req_delete(&req);
+		return;
+	}
+	sc->srv = srv;
+	sc->ev.fd = -1;
+
+	if (rpma_conn_req_connect(&req, NULL, &sc->conn)) {
+		free(sc);
+		return;
+	}
+
+	if (rpma_conn_get_event_fd(sc->conn, &fd) ||
+			epoll_add(srv->epoll, fd, sc, server_handle_conn_event,
+				&sc->ev)) {
+		sc->ev.fd = -1;
+		server_conn_delete(sc);
+	}
+}
+
+/*
+ * server_main -- accept and delete the connections of the clients
+ */
+static int
+server_main(const char *addr, const char *port, long conns)
+{
+	struct server srv;
+	struct rpma_peer *peer = NULL;
+	struct epoll_event events[BENCH_EVENTS_MAX];
+	int fd;
+	int ret;
+
+	memset(&srv, 0, sizeof(srv));
+	for (int p = 0; p < BENCH_PHASE_MAX; p++) {
+		if (bench_lat_init(&srv.lat[p], BENCH_SERVER_SAMPLES)) {
+			while (p--)
+				bench_lat_fini(&srv.lat[p]);
+			return -1;
+		}
+	}
+
+	ret = server_peer_via_address(addr, &peer);
+	if (ret)
+		goto err_lat_fini;
+
+	srv.epoll = epoll_create1(EPOLL_CLOEXEC);
+	if (srv.epoll == -1) {
+		perror("epoll_create1");
+		ret = -1;
+		goto err_peer_delete;
+	}
+
+	ret = rpma_ep_listen(peer, addr, port, &srv.ep);
+	if (ret)
+		goto err_close;
+
+	ret = rpma_ep_get_fd(srv.ep, &fd);
+	if (!ret)
+		ret = epoll_add(srv.epoll, fd, &srv, server_handle_incoming,
+				&srv.ev_incoming);
+	if (ret)
+		goto err_ep_shutdown;
+
+	(void) printf("server: listening at %s:%s\n", addr, port);
+
+	while (conns < 0 || srv.served < conns) {
+		int n = epoll_wait(srv.epoll, events, BENCH_EVENTS_MAX, -1);
+		if (n == -1) {
+			if (errno == EINTR)
+				continue;
+			perror("epoll_wait");
+			ret = -1;
+			break;
+		}
+
+		for (int i = 0; i < n; i++) {
+			struct custom_event *ce = events[i].data.ptr;
+			ce->func(ce);
+		}
+	}
+
+	(void) printf("server: %ld connections served\n", srv.served);
+	print_phases(stdout, srv.lat, BENCH_PHASE_QP_CREATE,
+			BENCH_PHASE_HANDSHAKE);
+
+	epoll_delete(srv.epoll, &srv.ev_incoming);
+
+err_ep_shutdown:
+	(void) rpma_ep_shutdown(&srv.ep);
+
+err_close:
+	(void) close(srv.epoll);
+
+err_peer_delete:
+	(void) rpma_peer_delete(&peer);
+
+err_lat_fini:
+	for (int p = 0; p < BENCH_PHASE_MAX; p++)
+		bench_lat_fini(&srv.lat[p]);
+
+	return ret;
+}
+
+/* the client */
+
+struct client_args {
+	const char *addr;
+	const char *port;
+	struct rpma_conn_cfg *cfg;
+	uint64_t conns;
+	uint64_t warmup;
+	uint64_t samples;
+};
+
+struct client_shared {
+	const struct client_args *args;
+	struct rpma_peer *peer;
+
+	/* rpma_conn_req_new() is not thread-safe (see THREAD_SAFETY.md) */
+	pthread_mutex_t req_lock;
+
+	/* the number of the connections taken by the threads so far */
+	uint64_t taken;
+};
+
+struct client_thread {
+	pthread_t thread;
+	struct client_shared *shared;
+
+	/* results */
+	struct bench_lat lat[BENCH_PHASE_MAX];
+	uint64_t conns;
+	int ret;
+};
+
+/*
+ * client_cycle -- open a connection, wait for it to be established, close
+ * and delete it and record the durations of its phases (if lat != NULL)
+ */
+static int
+client_cycle(struct client_shared *shared, struct bench_lat *lat)
+{
+	const struct client_args *args = shared->args;
+	struct rpma_conn_req *req = NULL;
+	struct rpma_conn *conn = NULL;
+	struct rpma_conn_setup_times times;
+	enum rpma_conn_event event = RPMA_CONN_UNDEFINED;
+
+	/* the time of waiting for the lock is not counted */
+	pthread_mutex_lock(&shared->req_lock);
+	uint64_t start = bench_now_ns();
+	int ret = rpma_conn_req_new(shared->peer, args->addr, args->port,
+			args->cfg, &req);
+	pthread_mutex_unlock(&shared->req_lock);
+	if (ret)
+		return ret;
+
+	ret = rpma_conn_req_connect(&req, NULL, &conn);
+	if (ret)
+		return ret;
+
+	ret = rpma_conn_next_event(conn, &event);
+	if (!ret && event != RPMA_CONN_ESTABLISHED) {
+		(void) fprintf(stderr,
+			"rpma_conn_next_event returned an unexpected event: %s\n",
+			rpma_utils_conn_event_2str(event));
+		ret = -1;
+	}
+	if (ret) {
+		(void) rpma_conn_delete(&conn);
+		return ret;
+	}
+	uint64_t established = bench_now_ns();
+
+	ret = rpma_conn_get_setup_times(conn, &times);
+	if (ret) {
+		(void) common_disconnect_and_wait_for_conn_close(&conn);
+		return ret;
+	}
+
+	ret = common_disconnect_and_wait_for_conn_close(&conn);
+	uint64_t end = bench_now_ns();
+	if (ret || lat == NULL)
+		return ret;
+
+	bench_lat_record(&lat[BENCH_PHASE_RESOLVE], times.resolve_addr_ns);
+	bench_lat_record(&lat[BENCH_PHASE_ROUTE], times.resolve_route_ns);
+	bench_lat_record(&lat[BENCH_PHASE_QP_CREATE], times.qp_create_ns);
+	bench_lat_record(&lat[BENCH_PHASE_FLUSH_REG], times.flush_reg_ns);
+	bench_lat_record(&lat[BENCH_PHASE_HANDSHAKE], times.handshake_ns);
+	bench_lat_record(&lat[BENCH_PHASE_SETUP], established - start);
+	bench_lat_record(&lat[BENCH_PHASE_DELETE], end - established);
+
+	return 0;
+}
+
+/*
+ * client_thread_func -- open and close the connections until they run out
+ */
+static void *
+client_thread_func(void *arg)
+{
+	struct client_thread *ct = arg;
+	struct client_shared *shared = ct->shared;
+	const struct client_args *args = shared->args;
+
+	while (__atomic_fetch_add(&shared->taken, 1, __ATOMIC_RELAXED) <
+			args->conns) {
+		ct->ret = client_cycle(shared, ct->lat);
+		if (ct->ret) {
+			/* stop the other threads */
+			__atomic_store_n(&shared->taken, args->conns,
+					__ATOMIC_RELAXED);
+			break;
+		}
+		ct->conns++;
+	}
+
+	return NULL;
+}
+
+/*
+ * client_combination -- open and close the connections using the given
+ * number of threads and report the results
+ */
+static int
+client_combination(struct client_shared *shared, unsigned nthreads,
+		struct bench_json *js)
+{
+	const struct client_args *args = shared->args;
+	struct bench_lat lat[BENCH_PHASE_MAX];
+	uint64_t capacity = args->samples < args->conns ?
+			args->samples : args->conns;
+	uint64_t conns = 0;
+	int ret = 0;
+	int p;
+
+	struct client_thread *threads = calloc(nthreads, sizeof(*threads));
+	if (threads == NULL)
+		return -1;
+
+	unsigned n;
+	for (n = 0; n < nthreads; n++) {
+		threads[n].shared = shared;
+		for (p = 0; p < BENCH_PHASE_MAX; p++) {
+			if (bench_lat_init(&threads[n].lat[p], capacity)) {
+				while (p--)
+					bench_lat_fini(&threads[n].lat[p]);
+				ret = -1;
+				goto err_threads_fini;
+			}
+		}
+	}
+
+	for (p = 0; p < BENCH_PHASE_MAX; p++) {
+		if (bench_lat_init(&lat[p], capacity)) {
+			ret = -1;
+			goto err_lat_fini;
+		}
+	}
+
+	for (uint64_t i = 0; i < args->warmup && !ret; i++)
+		ret = client_cycle(shared, NULL);
+	if (ret)
+		goto err_lat_fini;
+
+	shared->taken = 0;
+	uint64_t begin = bench_now_ns();
+
+	unsigned started;
+	for (started = 0; started < nthreads; started++) {
+		ret = pthread_create(&threads[started].thread, NULL,
+				client_thread_func, &threads[started]);
+		if (ret) {
+			(void) fprintf(stderr, "pthread_create: %s\n",
+					strerror(ret));
+			/* stop the already started threads */
+			__atomic_store_n(&shared->taken, args->conns,
+					__ATOMIC_RELAXED);
+			break;
+		}
+	}
+
+	for (unsigned t = 0; t < started; t++) {
+		(void) pthread_join(threads[t].thread, NULL);
+		if (threads[t].ret && !ret)
+			ret = threads[t].ret;
+		for (p = 0; p < BENCH_PHASE_MAX; p++)
+			bench_lat_merge(&lat[p], &threads[t].lat[p]);
+		conns += threads[t].conns;
+	}
+
+	uint64_t elapsed_ns = bench_now_ns() - begin;
+
+	if (ret) {
+		(void) fprintf(stderr, "conn threads %u: failed\n", nthreads);
+		goto err_lat_fini;
+	}
+
+	/* keep stdout clean if the JSON results are written there */
+	FILE *out = (js && js->file == stdout) ? stderr : stdout;
+	double rate = (double)conns / ((double)elapsed_ns / 1e9);
+
+	(void) fprintf(out, "conn threads %u: conns %" PRIu64
+			" rate %.0f conn/s\n", nthreads, conns, rate);
+	print_phases(out, lat, 0, BENCH_PHASE_MAX - 1);
+
+	for (int r = 0; js && r < BENCH_PHASE_MAX; r++) {
+		bench_json_row_begin(js);
+		bench_json_str(js, "op", "conn");
+		bench_json_str(js, "phase", bench_phase_names[r]);
+		bench_json_uint(js, "threads", nthreads);
+		bench_json_uint(js, "ops", conns);
+		bench_json_lat(js, &lat[r]);
+		bench_json_double(js, "iops_avg", rate);
+		bench_json_row_end(js);
+	}
+
+err_lat_fini:
+	while (p--)
+		bench_lat_fini(&lat[p]);
+
+err_threads_fini:
+	while (n--) {
+		for (p = 0; p < BENCH_PHASE_MAX; p++)
+			bench_lat_fini(&threads[n].lat[p]);
+	}
+	free(threads);
+
+	return ret;
+}
+
+static void
+usage(const char *name)
+{
+	(void) fprintf(stderr, USAGE_STR, name, name, BENCH_LAT_SAMPLES);
+}
+
+int
+main(int argc, char *argv[])
+{
+	static const struct option long_options[] = {
+		{"conns", required_argument, NULL, 'n'},
+		{"threads", required_argument, NULL, 't'},
+		{"warmup", required_argument, NULL, 'w'},
+		{"queue", required_argument, NULL, 'q'},
+		{"json", required_argument, NULL, 'j'},
+		{"samples", required_argument, NULL, 'S'},
+		{NULL, 0, NULL, 0}
+	};
+	uint64_t threads[BENCH_LIST_MAX] = {1};
+	int nthreads = 1;
+	uint64_t conns = 0;
+	uint64_t queue = 0;
+	const char *json_path = NULL;
+	struct client_args args = {
+		.conns = 1000,
+		.warmup = 10,
+		.samples = BENCH_LAT_SAMPLES,
+	};
+	int opt;
+
+	if (argc < 2) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	while ((opt = getopt_long(argc - 1, argv + 1, "n:c:t:w:q:j:S:",
+			long_options, NULL)) != -1) {
+		int err = 0;
+
+		switch (opt) {
+		case 'n':
+		case 'c':
+			err = bench_parse_size(optarg, &conns) || conns == 0;
+			break;
+		case 't':
+			err = (nthreads = bench_parse_list(optarg, threads)) < 0;
+			break;
+		case 'w':
+			err = bench_parse_size(optarg, &args.warmup);
+			break;
+		case 'q':
+			err = bench_parse_size(optarg, &queue) || queue == 0 ||
+					queue > UINT32_MAX;
+			break;
+		case 'j':
+			json_path = optarg;
+			break;
+		case 'S':
+			err = bench_parse_size(optarg, &args.samples) ||
+					args.samples == 0;
+			break;
+		default:
+			err = 1;
+			break;
+		}
+
+		if (err) {
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	/* optind counts from argv + 1 */
+	if (argc - 1 - optind != 2) {
+		usage(argv[0]);
+		return 1;
+	}
+	args.addr = argv[1 + optind];
+	args.port = argv[2 + optind];
+
+	if (strcmp(argv[1], "server") == 0)
+		return server_main(args.addr, args.port,
+				conns ? (long)conns : -1) ? 1 : 0;
+	if (strcmp(argv[1], "client") != 0) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	if (conns)
+		args.conns = conns;
+	for (int i = 0; i < nthreads; i++) {
+		if (threads[i] == 0 || threads[i] > UINT16_MAX) {
+			(void) fprintf(stderr, "invalid number of threads: %"
+					PRIu64 "\n", threads[i]);
+			return 1;
+		}
+	}
+
+	struct client_shared shared = {
+		.args = &args,
+	};
+	struct bench_json js;
+	int ret = 0;
+
+	if (queue) {
+		ret = rpma_conn_cfg_new(&args.cfg);
+		if (!ret)
+			ret = rpma_conn_cfg_set_sq_size(args.cfg,
+					(uint32_t)queue);
+		if (!ret)
+			ret = rpma_conn_cfg_set_rq_size(args.cfg,
+					(uint32_t)queue);
+		if (!ret)
+			ret = rpma_conn_cfg_set_cq_size(args.cfg,
+					(uint32_t)queue);
+		if (ret)
+			goto err_cfg_delete;
+	}
+
+	ret = client_peer_via_address(args.addr, &shared.peer);
+	if (ret)
+		goto err_cfg_delete;
+
+	if (json_path && bench_json_open(&js, json_path)) {
+		ret = -1;
+		goto err_peer_delete;
+	}
+
+	pthread_mutex_init(&shared.req_lock, NULL);
+
+	for (int t = 0; t < nthreads && !ret; t++)
+		ret = client_combination(&shared, (unsigned)threads[t],
+				json_path ? &js : NULL);
+
+	pthread_mutex_destroy(&shared.req_lock);
+
+	if (json_path && bench_json_close(&js))
+		ret = -1;
+
+err_peer_delete:
+	(void) rpma_peer_delete(&shared.peer);
+
+err_cfg_delete:
+	if (args.cfg)
+		(void) rpma_conn_cfg_delete(&args.cfg);
+
+	return ret ? 1 : 0;
+}
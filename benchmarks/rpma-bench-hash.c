@@ -0,0 +1,1049 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * rpma-bench-hash.c -- the benchmark of the lookups of the hash example
+ *
+ * The same binary is run as a server and as a client:
+ *
+ * - the server generates nkeys YCSB-like keys ("user" followed by the FNV-1
+ *   hash of the number of the key), builds the hash table of them
+ *   with the parallel build of writehash (see examples/hash/hashbuild.c)
+ *   in DRAM or in a file and serves the table to the clients,
+ * - the client generates the same keys and, for every given distribution
+ *   of the requests (uniform or zipfian), a workload of the lookups of them
+ *   and runs every combination of the given queue depths and numbers
+ *   of threads: every thread opens its own connection to the server and
+ *   looks its share of the workload up with the lookup engine of the hash
+ *   clients (see examples/hash/hashlookup.c) keeping queue depth lookups
+ *   in flight.
+ *
+ * A single thread is the configuration of singlehashclient and more threads
+ * are the configuration of multihashclient (a single server). The latency
+ * of a lookup is counted from posting its first read until its result is
+ * known. The results are printed in a human-readable form and, if requested,
+ * written to a JSON file in the format of the results of tools/perf.
+ */
+
+#include <fcntl.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <librpma.h>
+
+#include "common-conn.h"
+#include "bench-common.h"
+#include "hashbuild.h"
+#include "hashcache.h"
+#include "hashlookup.h"
+
+#define USAGE_STR \
+"usage: %s server <server_address> <port> [<options>]\n\
+       %s client <server_address> <port> [<options>]\n\
+\n\
+server options:\n\
+  -k, --keys=<n>         number of the keys of the table (default 1m)\n\
+  -p, --path=<path>      build the table in the file (default: in DRAM)\n\
+  -B, --build=<n>        threads building the table (default: all CPUs)\n\
+  -n, --conns=<n>        exit after serving n connections (default: never)\n\
+\n\
+client options:\n\
+  -D, --dist=<list>      distributions of the requests: uniform and zipfian\n\
+                         (default uniform,zipfian)\n\
+  -z, --theta=<theta>    the skew of the zipfian distribution (default 0.99)\n\
+  -l, --lookups=<n>      lookups of every combination (default 1m)\n\
+  -w, --warmup=<n>       lookups before every combination (default 0)\n\
+  -q, --qd=<list>        queue depths (default 1,16,64, at most %d)\n\
+  -t, --threads=<list>   numbers of threads (default 1,2,4)\n\
+  -m, --mode=<mode>      segment, two-phase or adaptive (default segment)\n\
+  -c, --cache=<MiB>      size of the cache of the segments (default 0)\n\
+  -r, --seed=<n>         seed of the workloads (default 1)\n\
+  -j, --json=<path>      write the results as JSON ('-' means stdout)\n\
+  -S, --samples=<n>      latency samples kept per thread (default %u)\n\
+\n\
+a <list> is a comma-separated list of values (e.g. 1,16,64)\n"
+
+/* the default skew of the zipfian distribution (as in YCSB) */
+#define BENCH_THETA_DEFAULT 0.99
+
+/* the private data of the response of the server */
+struct bench_hash_resp {
+	struct common_data data;	/* the memory region of the table */
+	uint64_t nkeys;			/* the number of the generated keys */
+};
+
+enum bench_dist {
+	BENCH_DIST_UNIFORM,
+	BENCH_DIST_ZIPFIAN,
+	BENCH_DIST_MAX
+};
+
+static const char *const bench_dist_names[BENCH_DIST_MAX] = {
+	"uniform",
+	"zipfian",
+};
+
+/* the names of the lookup modes (enum lookup_mode) */
+static const char *const bench_mode_names[] = {
+	"segment",
+	"two-phase",
+	"adaptive",
+};
+
+/* the keys */
+
+/*
+ * bench_fnv64 -- the FNV-1 hash of the bytes of the value (as in YCSB)
+ */
+static uint64_t
+bench_fnv64(uint64_t val)
+{
+	uint64_t hash = 0xCBF29CE484222325ULL;
+
+	for (int i = 0; i < 8; i++) {
+		hash ^= val & 0xff;
+		hash *= 1099511628211ULL;
+		val >>= 8;
+	}
+
+	return hash;
+}
+
+/*
+ * bench_keys_new -- generate the names of the keys 0 .. nkeys - 1
+ * (HASH_KEY_MAX + 1 bytes every one)
+ */
+static char *
+bench_keys_new(uint64_t nkeys)
+{
+	char *keys = malloc(nkeys * (HASH_KEY_MAX + 1));
+	if (keys == NULL)
+		return NULL;
+
+	for (uint64_t k = 0; k < nkeys; k++)
+		(void) snprintf(&keys[k * (HASH_KEY_MAX + 1)],
+				HASH_KEY_MAX + 1, "user%" PRIu64,
+				bench_fnv64(k) & INT64_MAX);
+
+	return keys;
+}
+
+/* the server */
+
+struct server {
+	/* the number of the connection threads still running */
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	unsigned active;
+};
+
+struct server_conn {
+	struct server *srv;
+	struct rpma_conn *conn;
+};
+
+/*
+ * server_memset -- zero the slices of the table in DRAM or in a file
+ */
+static void *
+server_memset(void *dest, int c, size_t len, unsigned flags)
+{
+	(void) flags;
+
+	return memset(dest, c, len);
+}
+
+/*
+ * server_persist -- the table is served only as long as the server runs,
+ * so it does not have to be persistent
+ */
+static void
+server_persist(const void *ptr, size_t size)
+{
+	(void) ptr;
+	(void) size;
+}
+
+/*
+ * server_table_new -- map the memory of the table of nkeys keys (in DRAM
+ * if path is NULL) and build the table of the keys
+ */
+static char *
+server_table_new(const char *path, uint64_t nkeys, unsigned nthreads,
+		size_t *size_ptr, struct hash_build_stats *stats)
+{
+	char *keys = NULL;
+	char *trace = NULL;
+	char *addr = NULL;
+	size_t trace_len = 0;
+
+	size_t size = hash_build_size(nkeys);
+
+	/* the keys are loaded from a trace of inserts as writehash does */
+	keys = bench_keys_new(nkeys);
+	trace = malloc(nkeys * (sizeof("INSERT \n") + HASH_KEY_MAX));
+	if (keys == NULL || trace == NULL) {
+		(void) fprintf(stderr, "server: out of memory\n");
+		goto err_free;
+	}
+	for (uint64_t k = 0; k < nkeys; k++)
+		trace_len += (size_t)sprintf(trace + trace_len, "INSERT %s\n",
+				&keys[k * (HASH_KEY_MAX + 1)]);
+
+	if (path) {
+		int fd = open(path, O_RDWR | O_CREAT, 0644);
+		if (fd < 0) {
+			perror(path);
+			goto err_free;
+		}
+		if (ftruncate(fd, (off_t)size)) {
+			perror(path);
+			(void) close(fd);
+			goto err_free;
+		}
+		addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+				fd, 0);
+		(void) close(fd);
+		if (addr == MAP_FAILED) {
+			perror("mmap");
+			addr = NULL;
+			goto err_free;
+		}
+	} else {
+		addr = malloc_aligned(size);
+		if (addr == NULL)
+			goto err_free;
+	}
+
+	if (hash_build(trace, trace_len, addr, size, nthreads, server_memset,
+			0, server_persist, stats)) {
+		if (path)
+			(void) munmap(addr, size);
+		else
+			free(addr);
+		addr = NULL;
+		goto err_free;
+	}
+
+	*size_ptr = size;
+
+err_free:
+	free(trace);
+	free(keys);
+
+	return addr;
+}
+
+/*
+ * server_conn_thread -- wait until the client closes the connection
+ */
+static void *
+server_conn_thread(void *arg)
+{
+	struct server_conn *sc = arg;
+	struct server *srv = sc->srv;
+
+	(void) common_wait_for_conn_close_and_disconnect(&sc->conn);
+	free(sc);
+
+	pthread_mutex_lock(&srv->lock);
+	srv->active--;
+	pthread_cond_signal(&srv->cond);
+	pthread_mutex_unlock(&srv->lock);
+
+	return NULL;
+}
+
+/*
+ * server_accept -- accept the next connection and start its thread
+ */
+static int
+server_accept(struct server *srv, struct rpma_ep *ep,
+		struct rpma_conn_private_data *pdata)
+{
+	pthread_t thread;
+
+	struct server_conn *sc = calloc(1, sizeof(*sc));
+	if (sc == NULL)
+		return -1;
+	sc->srv = srv;
+
+	int ret = server_accept_connection(ep, NULL, pdata, &sc->conn);
+	if (ret) {
+		free(sc);
+		return ret;
+	}
+
+	pthread_mutex_lock(&srv->lock);
+	srv->active++;
+	pthread_mutex_unlock(&srv->lock);
+
+	ret = pthread_create(&thread, NULL, server_conn_thread, sc);
+	if (ret) {
+		pthread_mutex_lock(&srv->lock);
+		srv->active--;
+		pthread_mutex_unlock(&srv->lock);
+		(void) common_disconnect_and_wait_for_conn_close(&sc->conn);
+		free(sc);
+		return -1;
+	}
+	(void) pthread_detach(thread);
+
+	return 0;
+}
+
+/*
+ * server_main -- build the table and serve it to the clients
+ */
+static int
+server_main(const char *addr, const char *port, const char *path,
+		uint64_t nkeys, unsigned nthreads, long conns)
+{
+	struct server srv;
+	struct rpma_peer *peer = NULL;
+	struct rpma_mr_local *mr = NULL;
+	struct rpma_ep *ep = NULL;
+	struct hash_build_stats stats;
+	struct bench_hash_resp resp;
+	size_t mr_desc_size;
+	size_t size = 0;
+	int ret;
+
+	memset(&srv, 0, sizeof(srv));
+	memset(&resp, 0, sizeof(resp));
+	pthread_mutex_init(&srv.lock, NULL);
+	pthread_cond_init(&srv.cond, NULL);
+
+	uint64_t begin = bench_now_ns();
+	char *table = server_table_new(path, nkeys, nthreads, &size, &stats);
+	if (table == NULL)
+		return -1;
+
+	(void) printf("server: %" PRIu64 " keys stored (%" PRIu64
+			" duplicated) in 2^%u home buckets in %.2f s\n",
+			stats.nkeys, stats.duplicates, stats.exponent,
+			(double)(bench_now_ns() - begin) / 1e9);
+
+	ret = server_peer_via_address(addr, &peer);
+	if (ret)
+		goto err_unmap;
+
+	/* only the table is registered, not the space left for doubling it */
+	ret = rpma_mr_reg(peer, table, stats.table_size,
+			RPMA_MR_USAGE_READ_SRC, &mr);
+	if (ret)
+		goto err_peer_delete;
+
+	ret = rpma_mr_get_descriptor_size(mr, &mr_desc_size);
+	if (ret)
+		goto err_mr_dereg;
+	if (mr_desc_size > DESCRIPTORS_MAX_SIZE) {
+		(void) fprintf(stderr, "the memory descriptor is too big\n");
+		ret = -1;
+		goto err_mr_dereg;
+	}
+	resp.data.mr_desc_size = (uint8_t)mr_desc_size;
+	resp.nkeys = nkeys;
+	ret = rpma_mr_get_descriptor(mr, &resp.data.descriptors[0]);
+	if (ret)
+		goto err_mr_dereg;
+
+	ret = rpma_ep_listen(peer, addr, port, &ep);
+	if (ret)
+		goto err_mr_dereg;
+
+	(void) printf("server: listening at %s:%s (%zu bytes)\n",
+			addr, port, stats.table_size);
+
+	struct rpma_conn_private_data pdata = {&resp, sizeof(resp)};
+	for (long served = 0; conns < 0 || served < conns; served++) {
+		ret = server_accept(&srv, ep, &pdata);
+		if (ret)
+			break;
+	}
+
+	/* wait for the connections still being served */
+	pthread_mutex_lock(&srv.lock);
+	while (srv.active)
+		pthread_cond_wait(&srv.cond, &srv.lock);
+	pthread_mutex_unlock(&srv.lock);
+
+	(void) rpma_ep_shutdown(&ep);
+
+err_mr_dereg:
+	(void) rpma_mr_dereg(&mr);
+
+err_peer_delete:
+	(void) rpma_peer_delete(&peer);
+
+err_unmap:
+	if (path)
+		(void) munmap(table, size);
+	else
+		free(table);
+
+	return ret;
+}
+
+/* the client */
+
+struct client_args {
+	const char *addr;
+	const char *port;
+	enum lookup_mode mode;
+	size_t cache_mib;
+	unsigned qd;
+	uint64_t samples;
+
+	/* the workload and the lookups of it warming the engines up */
+	char **workload;
+	uint64_t nlookups;
+	uint64_t nwarmup;
+};
+
+struct client_thread {
+	pthread_t thread;
+	const struct client_args *args;
+	pthread_barrier_t *barrier;
+
+	struct rpma_conn *conn;
+	struct rpma_mr_remote *src_mr;
+	struct lookup_engine *eng;
+
+	/* the share of the workload of the thread */
+	char **keys;
+	size_t nkeys;
+	char **warmup;
+	size_t nwarmup;
+
+	/* results */
+	struct bench_lat lat;
+	struct lookup_stats stats;
+	uint64_t elapsed_ns;
+	int ret;
+};
+
+/*
+ * bench_zipf_zeta -- the sum of 1 / i^theta for i = 1 .. n
+ */
+static double
+bench_zipf_zeta(uint64_t n, double theta)
+{
+	double sum = 0;
+
+	for (uint64_t i = 1; i <= n; i++)
+		sum += 1.0 / pow((double)i, theta);
+
+	return sum;
+}
+
+/*
+ * bench_workload_new -- generate n requests of the keys of the distribution;
+ * the zipfian ranks are generated as by YCSB (Gray et al., "Quickly
+ * Generating Billion-Record Synthetic Databases") and scrambled by their
+ * hash, so the hottest keys are spread over the whole table
+ */
+static char **
+bench_workload_new(char *keys, uint64_t nkeys, enum bench_dist dist,
+		double theta, uint64_t n, uint64_t seed)
+{
+	char **workload = malloc(n * sizeof(*workload));
+	if (workload == NULL)
+		return NULL;
+
+	double zetan = 0, alpha = 0, eta = 0;
+	if (dist == BENCH_DIST_ZIPFIAN) {
+		double zeta2 = 1.0 + pow(0.5, theta);
+		zetan = bench_zipf_zeta(nkeys, theta);
+		alpha = 1.0 / (1.0 - theta);
+		eta = (1.0 - pow(2.0 / (double)nkeys, 1.0 - theta)) /
+				(1.0 - zeta2 / zetan);
+	}
+
+	for (uint64_t i = 0; i < n; i++) {
+		uint64_t k = bench_rand(&seed);
+
+		if (dist == BENCH_DIST_ZIPFIAN) {
+			double u = (double)(k >> 11) / (double)(1ULL << 53);
+			double uz = u * zetan;
+			uint64_t rank;
+			if (uz < 1.0)
+				rank = 0;
+			else if (uz < 1.0 + pow(0.5, theta))
+				rank = 1;
+			else
+				rank = (uint64_t)((double)nkeys *
+					pow(eta * u - eta + 1.0, alpha));
+			k = bench_fnv64(rank);
+		}
+
+		workload[i] = &keys[(k % nkeys) * (HASH_KEY_MAX + 1)];
+	}
+
+	return workload;
+}
+
+/*
+ * client_lat -- record the latency of a lookup of the thread
+ */
+static void
+client_lat(void *arg, uint64_t lat_ns)
+{
+	bench_lat_record(arg, lat_ns);
+}
+
+/*
+ * client_thread_func -- warm up and look the keys of the thread up
+ */
+static void *
+client_thread_func(void *arg)
+{
+	struct client_thread *ct = arg;
+
+	if (ct->nwarmup) {
+		struct lookup_stats stats = {0};
+		ct->ret = lookup_engine_run(ct->eng, ct->warmup, ct->nwarmup,
+				&stats);
+		bench_lat_reset(&ct->lat);
+	}
+
+	/* all the threads start measuring at the same time */
+	(void) pthread_barrier_wait(ct->barrier);
+
+	uint64_t begin = bench_now_ns();
+	if (!ct->ret)
+		ct->ret = lookup_engine_run(ct->eng, ct->keys, ct->nkeys,
+				&ct->stats);
+	ct->elapsed_ns = bench_now_ns() - begin;
+
+	return NULL;
+}
+
+/*
+ * client_thread_fini -- close the connection of the thread
+ */
+static void
+client_thread_fini(struct client_thread *ct)
+{
+	lookup_engine_delete(&ct->eng);
+	if (ct->src_mr)
+		(void) rpma_mr_remote_delete(&ct->src_mr);
+	if (ct->conn)
+		(void) common_disconnect_and_wait_for_conn_close(&ct->conn);
+	bench_lat_fini(&ct->lat);
+}
+
+/*
+ * client_thread_init -- open the connection of the thread and create its
+ * engine (rpma_conn_req_new() and rpma_mr_reg() are not thread-safe,
+ * see THREAD_SAFETY.md)
+ */
+static int
+client_thread_init(struct client_thread *ct, struct rpma_peer *peer,
+		struct rpma_conn_cfg *cfg, struct hash_cache *cache)
+{
+	const struct client_args *args = ct->args;
+	struct rpma_conn_private_data pdata;
+
+	if (bench_lat_init(&ct->lat, args->samples))
+		return -1;
+
+	int ret = client_connect(peer, args->addr, args->port, cfg, NULL,
+			&ct->conn);
+	if (ret)
+		return ret;
+
+	ret = rpma_conn_get_private_data(ct->conn, &pdata);
+	if (ret)
+		return ret;
+	if (pdata.ptr == NULL || pdata.len < sizeof(struct bench_hash_resp)) {
+		(void) fprintf(stderr,
+			"the server has not provided the hash table\n");
+		return -1;
+	}
+
+	struct bench_hash_resp *resp = pdata.ptr;
+	ret = rpma_mr_remote_from_descriptor(&resp->data.descriptors[0],
+			resp->data.mr_desc_size, &ct->src_mr);
+	if (ret)
+		return ret;
+
+	ret = lookup_engine_new(peer, ct->conn, ct->src_mr,
+			resp->data.data_offset, (int)args->qd, args->mode,
+			&ct->eng);
+	if (ret)
+		return ret;
+
+	if (cache)
+		lookup_engine_set_cache(ct->eng, cache, 0);
+	lookup_engine_set_lat(ct->eng, client_lat, &ct->lat);
+
+	return 0;
+}
+
+/*
+ * client_combination -- run one combination of the workload, qd and
+ * the number of threads and report its results
+ */
+static int
+client_combination(struct rpma_peer *peer, const struct client_args *args,
+		const char *dist, unsigned nthreads, struct bench_json *js)
+{
+	struct rpma_conn_cfg *cfg = NULL;
+	struct hash_cache *cache = NULL;
+	pthread_barrier_t barrier;
+	struct bench_lat lat;
+	struct lookup_stats total = {0};
+	uint64_t elapsed_ns = 0;
+	int ret;
+
+	struct client_thread *threads = calloc(nthreads, sizeof(*threads));
+	if (threads == NULL)
+		return -1;
+
+	/* the queues have to fit all the lookups in flight */
+	ret = rpma_conn_cfg_new(&cfg);
+	if (!ret)
+		ret = rpma_conn_cfg_set_sq_size(cfg,
+				(uint32_t)LOOKUP_SQ_SIZE(args->qd));
+	if (!ret)
+		ret = rpma_conn_cfg_set_cq_size(cfg,
+				(uint32_t)LOOKUP_CQ_SIZE(args->qd));
+	if (ret)
+		goto err_free;
+
+	/* every combination starts with an empty cache */
+	if (args->cache_mib) {
+		cache = hash_cache_new(args->cache_mib << 20);
+		if (cache == NULL) {
+			(void) fprintf(stderr,
+				"cannot create a cache of %zu MiB\n",
+				args->cache_mib);
+			ret = -1;
+			goto err_cfg_delete;
+		}
+	}
+
+	if (bench_lat_init(&lat, args->samples)) {
+		ret = -1;
+		goto err_cache_delete;
+	}
+
+	unsigned n;
+	for (n = 0; n < nthreads; n++) {
+		struct client_thread *ct = &threads[n];
+		uint64_t first = args->nlookups * n / nthreads;
+		uint64_t wfirst = args->nwarmup * n / nthreads;
+
+		ct->args = args;
+		ct->barrier = &barrier;
+		ct->keys = &args->workload[first];
+		ct->nkeys = args->nlookups * (n + 1) / nthreads - first;
+		/* the warm-up looks up the first keys of the share */
+		ct->warmup = ct->keys;
+		ct->nwarmup = args->nwarmup * (n + 1) / nthreads - wfirst;
+		ret = client_thread_init(ct, peer, cfg, cache);
+		if (ret) {
+			n++;
+			goto err_threads_fini;
+		}
+	}
+
+	pthread_barrier_init(&barrier, NULL, nthreads);
+
+	for (n = 0; n < nthreads; n++) {
+		ret = pthread_create(&threads[n].thread, NULL,
+				client_thread_func, &threads[n]);
+		if (ret) {
+			/* the barrier would never be passed */
+			(void) fprintf(stderr, "pthread_create: %s\n",
+					strerror(ret));
+			exit(1);
+		}
+	}
+
+	for (n = 0; n < nthreads; n++) {
+		struct client_thread *ct = &threads[n];
+		(void) pthread_join(ct->thread, NULL);
+		if (ct->ret && !ret)
+			ret = ct->ret;
+		bench_lat_merge(&lat, &ct->lat);
+		total.found += ct->stats.found;
+		total.not_found += ct->stats.not_found;
+		total.reads += ct->stats.reads;
+		total.bytes_read += ct->stats.bytes_read;
+		total.two_phase += ct->stats.two_phase;
+		total.cache_hits += ct->stats.cache_hits;
+		if (ct->elapsed_ns > elapsed_ns)
+			elapsed_ns = ct->elapsed_ns;
+	}
+	pthread_barrier_destroy(&barrier);
+
+	const char *client = nthreads == 1 ?
+			"singlehashclient" : "multihashclient";
+	if (ret) {
+		(void) fprintf(stderr, "%s %s qd %u threads %u: failed\n",
+				client, dist, args->qd, nthreads);
+		goto err_threads_fini;
+	}
+
+	/* keep stdout clean if the JSON results are written there */
+	FILE *out = (js && js->file == stdout) ? stderr : stdout;
+	uint64_t lookups = total.found + total.not_found;
+	double iops = (double)lookups / ((double)elapsed_ns / 1e9);
+	double bytes = (double)total.bytes_read / (double)lookups;
+	double reads = (double)total.reads / (double)lookups;
+
+	(void) fprintf(out, "%s %s qd %u threads %u: lookups %" PRIu64
+			" (not found %" PRIu64 ") lookups/s %.0f bytes/lookup %.1f"
+			" reads/lookup %.2f\n",
+			client, dist, args->qd, nthreads, lookups,
+			total.not_found, iops, bytes, reads);
+	if (args->cache_mib)
+		(void) fprintf(out, "   cache hits %" PRIu64 "\n",
+				total.cache_hits);
+	bench_print_lat(out, "   ", &lat);
+
+	if (js) {
+		bench_json_row_begin(js);
+		bench_json_str(js, "op", "hash_lookup");
+		bench_json_str(js, "client", client);
+		bench_json_str(js, "dist", dist);
+		bench_json_str(js, "mode", bench_mode_names[args->mode]);
+		bench_json_uint(js, "threads", nthreads);
+		bench_json_uint(js, "iodepth", args->qd);
+		bench_json_uint(js, "ops", lookups);
+		bench_json_lat(js, &lat);
+		bench_json_double(js, "iops_avg", iops);
+		bench_json_double(js, "bytes_per_op", bytes);
+		bench_json_double(js, "reads_per_op", reads);
+		bench_json_uint(js, "not_found", total.not_found);
+		bench_json_uint(js, "cache_hits", total.cache_hits);
+		bench_json_row_end(js);
+	}
+
+err_threads_fini:
+	while (n--)
+		client_thread_fini(&threads[n]);
+	bench_lat_fini(&lat);
+
+err_cache_delete:
+	hash_cache_delete(&cache);
+
+err_cfg_delete:
+	(void) rpma_conn_cfg_delete(&cfg);
+
+err_free:
+	free(threads);
+
+	return ret;
+}
+
+/*
+ * client_get_nkeys -- get the number of the keys of the table of the server
+ */
+static int
+client_get_nkeys(struct rpma_peer *peer, const struct client_args *args,
+		uint64_t *nkeys)
+{
+	struct rpma_conn *conn = NULL;
+	struct rpma_conn_private_data pdata;
+
+	int ret = client_connect(peer, args->addr, args->port, NULL, NULL,
+			&conn);
+	if (ret)
+		return ret;
+
+	ret = rpma_conn_get_private_data(conn, &pdata);
+	if (!ret && (pdata.ptr == NULL ||
+			pdata.len < sizeof(struct bench_hash_resp))) {
+		(void) fprintf(stderr,
+			"the server has not provided the hash table\n");
+		ret = -1;
+	}
+	if (!ret)
+		*nkeys = ((struct bench_hash_resp *)pdata.ptr)->nkeys;
+
+	(void) common_disconnect_and_wait_for_conn_close(&conn);
+
+	return ret;
+}
+
+/*
+ * client_main -- run all the combinations of the distributions, the queue
+ * depths and the numbers of threads
+ */
+static int
+client_main(struct client_args *args, const enum bench_dist *dists,
+		int ndists, double theta, uint64_t seed, const uint64_t *qd,
+		int nqd, const uint64_t *threads, int nthreads,
+		const char *json_path)
+{
+	struct rpma_peer *peer = NULL;
+	struct bench_json js;
+	char *keys = NULL;
+	uint64_t nkeys = 0;
+
+	int ret = client_peer_via_address(args->addr, &peer);
+	if (ret)
+		return ret;
+
+	/* the keys of the server are generated the same way */
+	ret = client_get_nkeys(peer, args, &nkeys);
+	if (ret)
+		goto err_peer_delete;
+	if (nkeys == 0) {
+		(void) fprintf(stderr, "the table of the server is empty\n");
+		ret = -1;
+		goto err_peer_delete;
+	}
+
+	keys = bench_keys_new(nkeys);
+	if (keys == NULL) {
+		ret = -1;
+		goto err_peer_delete;
+	}
+
+	if (json_path && bench_json_open(&js, json_path)) {
+		ret = -1;
+		goto err_free;
+	}
+
+	for (int d = 0; d < ndists && !ret; d++) {
+		const char *dist = bench_dist_names[dists[d]];
+		args->workload = bench_workload_new(keys, nkeys, dists[d],
+				theta, args->nlookups, seed);
+		if (args->workload == NULL) {
+			ret = -1;
+			break;
+		}
+
+		for (int q = 0; q < nqd && !ret; q++) {
+			for (int t = 0; t < nthreads && !ret; t++) {
+				args->qd = (unsigned)qd[q];
+				ret = client_combination(peer, args, dist,
+						(unsigned)threads[t],
+						json_path ? &js : NULL);
+			}
+		}
+
+		free(args->workload);
+		args->workload = NULL;
+	}
+
+	if (json_path && bench_json_close(&js))
+		ret = -1;
+
+err_free:
+	free(keys);
+
+err_peer_delete:
+	(void) rpma_peer_delete(&peer);
+
+	return ret;
+}
+
+/*
+ * bench_parse_dists -- parse a comma-separated list of the distributions
+ */
+static int
+bench_parse_dists(const char *str, enum bench_dist dists[BENCH_DIST_MAX])
+{
+	char buf[64];
+	int n = 0;
+
+	if (strlen(str) >= sizeof(buf))
+		return -1;
+	strcpy(buf, str);
+
+	char *saveptr = NULL;
+	for (char *tok = strtok_r(buf, ",", &saveptr); tok != NULL;
+			tok = strtok_r(NULL, ",", &saveptr)) {
+		int d;
+		for (d = 0; d < BENCH_DIST_MAX; d++) {
+			if (strcmp(tok, bench_dist_names[d]) == 0)
+				break;
+		}
+		if (d == BENCH_DIST_MAX || n == BENCH_DIST_MAX)
+			return -1;
+		dists[n++] = (enum bench_dist)d;
+	}
+
+	return n ? n : -1;
+}
+
+static void
+usage(const char *name)
+{
+	(void) fprintf(stderr, USAGE_STR, name, name, QUEUE_DEPTH_MAX,
+			BENCH_LAT_SAMPLES);
+}
+
+int
+main(int argc, char *argv[])
+{
+	static const struct option long_options[] = {
+		{"keys", required_argument, NULL, 'k'},
+		{"path", required_argument, NULL, 'p'},
+		{"build", required_argument, NULL, 'B'},
+		{"conns", required_argument, NULL, 'n'},
+		{"dist", required_argument, NULL, 'D'},
+		{"theta", required_argument, NULL, 'z'},
+		{"lookups", required_argument, NULL, 'l'},
+		{"warmup", required_argument, NULL, 'w'},
+		{"qd", required_argument, NULL, 'q'},
+		{"threads", required_argument, NULL, 't'},
+		{"mode", required_argument, NULL, 'm'},
+		{"cache", required_argument, NULL, 'c'},
+		{"seed", required_argument, NULL, 'r'},
+		{"json", required_argument, NULL, 'j'},
+		{"samples", required_argument, NULL, 'S'},
+		{NULL, 0, NULL, 0}
+	};
+	enum bench_dist dists[BENCH_DIST_MAX] = {
+		BENCH_DIST_UNIFORM, BENCH_DIST_ZIPFIAN
+	};
+	uint64_t qd[BENCH_LIST_MAX] = {1, 16, 64};
+	uint64_t threads[BENCH_LIST_MAX] = {1, 2, 4};
+	int ndists = 2, nqd = 3, nthreads = 3;
+	uint64_t nkeys = 1 << 20;
+	uint64_t build = 0;
+	uint64_t seed = 1;
+	uint64_t val;
+	long conns = -1;
+	double theta = BENCH_THETA_DEFAULT;
+	const char *path = NULL;
+	const char *json_path = NULL;
+	char *end;
+	struct client_args args = {
+		.mode = LOOKUP_MODE_SEGMENT,
+		.samples = BENCH_LAT_SAMPLES,
+		.nlookups = 1 << 20,
+	};
+	int opt;
+
+	if (argc < 2) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	while ((opt = getopt_long(argc - 1, argv + 1,
+			"k:p:B:n:D:z:l:w:q:t:m:c:r:j:S:",
+			long_options, NULL)) != -1) {
+		int err = 0;
+
+		switch (opt) {
+		case 'k':
+			err = bench_parse_size(optarg, &nkeys) || nkeys == 0;
+			break;
+		case 'p':
+			path = optarg;
+			break;
+		case 'B':
+			err = bench_parse_size(optarg, &build) || build == 0 ||
+					build > HASH_BUILD_THREADS_MAX;
+			break;
+		case 'n':
+			err = bench_parse_size(optarg, &val) || val == 0;
+			conns = (long)val;
+			break;
+		case 'D':
+			err = (ndists = bench_parse_dists(optarg, dists)) < 0;
+			break;
+		case 'z':
+			theta = strtod(optarg, &end);
+			err = *end != '\0' || !(theta > 0 && theta < 1);
+			break;
+		case 'l':
+			err = bench_parse_size(optarg, &args.nlookups) ||
+					args.nlookups == 0;
+			break;
+		case 'w':
+			err = bench_parse_size(optarg, &args.nwarmup);
+			break;
+		case 'q':
+			err = (nqd = bench_parse_list(optarg, qd)) < 0;
+			break;
+		case 't':
+			err = (nthreads = bench_parse_list(optarg, threads)) < 0;
+			break;
+		case 'm':
+			err = lookup_mode_from_str(optarg, &args.mode);
+			break;
+		case 'c':
+			err = bench_parse_size(optarg, &val);
+			args.cache_mib = (size_t)val;
+			break;
+		case 'r':
+			err = bench_parse_size(optarg, &seed) || seed == 0;
+			break;
+		case 'j':
+			json_path = optarg;
+			break;
+		case 'S':
+			err = bench_parse_size(optarg, &args.samples) ||
+					args.samples == 0;
+			break;
+		default:
+			err = 1;
+			break;
+		}
+
+		if (err) {
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	/* optind counts from argv + 1 */
+	if (argc - 1 - optind != 2) {
+		usage(argv[0]);
+		return 1;
+	}
+	args.addr = argv[1 + optind];
+	args.port = argv[2 + optind];
+
+	if (strcmp(argv[1], "server") == 0) {
+		if (build == 0) {
+			long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+			build = ncpus > 0 ? (uint64_t)ncpus : 1;
+			if (build > HASH_BUILD_THREADS_MAX)
+				build = HASH_BUILD_THREADS_MAX;
+		}
+		return server_main(args.addr, args.port, path, nkeys,
+				(unsigned)build, conns) ? 1 : 0;
+	}
+	if (strcmp(argv[1], "client") != 0) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	for (int i = 0; i < nqd; i++) {
+		if (qd[i] == 0 || qd[i] > QUEUE_DEPTH_MAX) {
+			(void) fprintf(stderr, "invalid queue depth: %" PRIu64
+					"\n", qd[i]);
+			return 1;
+		}
+	}
+	for (int i = 0; i < nthreads; i++) {
+		if (threads[i] == 0 || threads[i] > args.nlookups) {
+			(void) fprintf(stderr, "invalid number of threads: %"
+					PRIu64 "\n", threads[i]);
+			return 1;
+		}
+	}
+	if (args.nwarmup > args.nlookups) {
+		(void) fprintf(stderr,
+			"the warm-up cannot exceed the number of the lookups\n");
+		return 1;
+	}
+
+	return client_main(&args, dists, ndists, theta, seed, qd, nqd,
+			threads, nthreads, json_path) ? 1 : 0;
+}
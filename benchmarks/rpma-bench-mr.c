@@ -0,0 +1,706 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * rpma-bench-mr.c -- the benchmark of the memory registration
+ *
+ * For every given backing type of the memory and every given size
+ * of the region the benchmark maps a fresh region (not touched by the CPU)
+ * and measures:
+ * - reg - rpma_mr_reg() of the whole region,
+ * - advise - rpma_mr_advise() prefetching the whole region
+ *   (the second pass over the combination only),
+ * - first_touch - rpma_read() of the pages of the region which have not been
+ *   accessed since the registration,
+ * - second_touch - rpma_read() of the same pages again,
+ * - dereg - rpma_mr_dereg() of the region.
+ *
+ * rpma_mr_reg() falls back to On-Demand Paging (ODP) when the region cannot
+ * be pinned (e.g. FSDAX). A pinned region is populated by the registration
+ * itself, so first_touch and second_touch are close to each other then,
+ * whereas the first touch of an ODP region includes a page fault
+ * of the RDMA device unless the region has been prefetched.
+ *
+ * The pages are read by a connection looped back to the same process
+ * over the RDMA-capable network interface of the given address.
+ * The results are printed in a human-readable form and, if requested,
+ * written to a JSON file in the format of the results of tools/perf.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <librpma.h>
+
+#include "common-conn.h"
+#include "bench-common.h"
+
+#define USAGE_STR \
+"usage: %s <address> <port> [<options>]\n\
+\n\
+options:\n\
+  -m, --mem=<list>       backing types of the memory: anon, hugepage, fsdax\n\
+                         and devdax (default anon)\n\
+  -p, --path=<path>      file on FSDAX or Device DAX (required by fsdax\n\
+                         and devdax)\n\
+  -s, --size=<list>      sizes of the region (default 4k,64k,1m,16m,256m)\n\
+  -i, --iters=<n>        registrations per combination (default 100)\n\
+  -T, --touches=<n>      pages read per registration (default 16,\n\
+                         0 disables the reads and the prefetching)\n\
+  -j, --json=<path>      write the results as JSON ('-' means stdout)\n\
+\n\
+a <list> is a comma-separated list of values (e.g. 4k,1m,fsdax)\n\
+<address> is the address of the local RDMA-capable network interface\n\
+and <port> is used by the connection reading the pages\n"
+
+/* the size of every read of a page */
+#define BENCH_READ_SIZE 64
+
+/* the page size of the hugepage and the devdax memory */
+#define BENCH_HUGEPAGE_SIZE (2UL << 20)
+
+enum bench_mem {
+	BENCH_MEM_ANON,
+	BENCH_MEM_HUGEPAGE,
+	BENCH_MEM_FSDAX,
+	BENCH_MEM_DEVDAX,
+	BENCH_MEM_MAX
+};
+
+static const char *const bench_mem_names[BENCH_MEM_MAX] = {
+	"anon",
+	"hugepage",
+	"fsdax",
+	"devdax",
+};
+
+enum bench_phase {
+	BENCH_PHASE_REG,
+	BENCH_PHASE_ADVISE,
+	BENCH_PHASE_FIRST_TOUCH,
+	BENCH_PHASE_SECOND_TOUCH,
+	BENCH_PHASE_DEREG,
+	BENCH_PHASE_MAX
+};
+
+static const char *const bench_phase_names[BENCH_PHASE_MAX] = {
+	"reg",
+	"advise",
+	"first_touch",
+	"second_touch",
+	"dereg",
+};
+
+struct bench_args {
+	const char *path;
+	uint64_t iters;
+	uint64_t touches;
+};
+
+/* the connection reading the pages of the registered regions */
+struct bench_loop {
+	struct rpma_ep *ep;
+	struct rpma_conn *conn; /* the reading side */
+	struct rpma_conn *srv_conn; /* the side of the registered regions */
+	struct rpma_cq *cq;
+	struct rpma_mr_local *dst_mr;
+	void *dst;
+};
+
+/*
+ * mem_page_size -- the page size of the backing type
+ */
+static size_t
+mem_page_size(enum bench_mem mem)
+{
+	switch (mem) {
+	case BENCH_MEM_HUGEPAGE:
+	case BENCH_MEM_DEVDAX:
+		return BENCH_HUGEPAGE_SIZE;
+	default:
+		return (size_t)sysconf(_SC_PAGESIZE);
+	}
+}
+
+/*
+ * mem_map -- map a fresh region of the backing type
+ */
+static void *
+mem_map(enum bench_mem mem, int fd, size_t size)
+{
+	static int no_map_sync_reported;
+	void *addr = MAP_FAILED;
+
+	switch (mem) {
+	case BENCH_MEM_ANON:
+		addr = mmap(NULL, size, PROT_READ | PROT_WRITE,
+				MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		break;
+	case BENCH_MEM_HUGEPAGE:
+		addr = mmap(NULL, size, PROT_READ | PROT_WRITE,
+				MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		break;
+	case BENCH_MEM_FSDAX:
+#ifdef MAP_SYNC
+		addr = mmap(NULL, size, PROT_READ | PROT_WRITE,
+				MAP_SHARED_VALIDATE | MAP_SYNC, fd, 0);
+		if (addr != MAP_FAILED || errno != EOPNOTSUPP)
+			break;
+		if (!no_map_sync_reported++)
+			(void) fprintf(stderr,
+				"the file is not on FSDAX - mapping it without MAP_SYNC\n");
+#endif
+		addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+				fd, 0);
+		break;
+	case BENCH_MEM_DEVDAX:
+		addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+				fd, 0);
+		break;
+	default:
+		break;
+	}
+
+	if (addr == MAP_FAILED) {
+		perror("mmap");
+		if (mem == BENCH_MEM_HUGEPAGE)
+			(void) fprintf(stderr,
+				"are enough huge pages reserved (/proc/sys/vm/nr_hugepages)?\n");
+		return NULL;
+	}
+
+	return addr;
+}
+
+/*
+ * mem_open -- open the file backing the memory (if any) and make sure it is
+ * big enough for the given size
+ */
+static int
+mem_open(enum bench_mem mem, const char *path, size_t size)
+{
+	struct stat st;
+	int fd;
+
+	if (mem != BENCH_MEM_FSDAX && mem != BENCH_MEM_DEVDAX)
+		return -1;
+
+	if (path == NULL) {
+		(void) fprintf(stderr, "%s requires --path\n",
+				bench_mem_names[mem]);
+		return -1;
+	}
+
+	fd = open(path, mem == BENCH_MEM_FSDAX ? O_RDWR | O_CREAT : O_RDWR,
+			0600);
+	if (fd == -1) {
+		perror(path);
+		return -1;
+	}
+
+	/* the size of Device DAX cannot be changed */
+	if (mem == BENCH_MEM_DEVDAX)
+		return fd;
+
+	if (fstat(fd, &st) == 0 && (size_t)st.st_size >= size)
+		return fd;
+
+	errno = posix_fallocate(fd, 0, (off_t)size);
+	if (errno) {
+		perror("posix_fallocate");
+		(void) close(fd);
+		return -1;
+	}
+
+	return fd;
+}
+
+/*
+ * loop_connect -- connect the reading side to the side of the registered
+ * regions (both in this process)
+ */
+static int
+loop_connect(struct rpma_peer *peer, const char *addr, const char *port,
+		struct bench_loop *loop)
+{
+	struct rpma_conn_req *req = NULL;
+	struct rpma_conn_req *srv_req = NULL;
+	enum rpma_conn_event event = RPMA_CONN_UNDEFINED;
+
+	loop->dst = malloc_aligned(BENCH_READ_SIZE);
+	if (loop->dst == NULL)
+		return -1;
+
+	int ret = rpma_mr_reg(peer, loop->dst, BENCH_READ_SIZE,
+			RPMA_MR_USAGE_READ_DST, &loop->dst_mr);
+	if (ret)
+		return ret;
+
+	ret = rpma_ep_listen(peer, addr, port, &loop->ep);
+	if (ret)
+		return ret;
+
+	/* connecting does not wait for the other side */
+	ret = rpma_conn_req_new(peer, addr, port, NULL, &req);
+	if (ret)
+		return ret;
+	ret = rpma_conn_req_connect(&req, NULL, &loop->conn);
+	if (ret)
+		return ret;
+
+	ret = rpma_ep_next_conn_req(loop->ep, NULL, &srv_req);
+	if (ret)
+		return ret;
+	ret = rpma_conn_req_connect(&srv_req, NULL, &loop->srv_conn);
+	if (ret)
+		return ret;
+
+	ret = rpma_conn_next_event(loop->conn, &event);
+	if (!ret && event == RPMA_CONN_ESTABLISHED)
+		ret = rpma_conn_next_event(loop->srv_conn, &event);
+	if (!ret && event != RPMA_CONN_ESTABLISHED) {
+		(void) fprintf(stderr,
+			"rpma_conn_next_event returned an unexpected event: %s\n",
+			rpma_utils_conn_event_2str(event));
+		ret = -1;
+	}
+	if (ret)
+		return ret;
+
+	return rpma_conn_get_cq(loop->conn, &loop->cq);
+}
+
+/*
+ * loop_disconnect -- close the connection and release its resources
+ */
+static void
+loop_disconnect(struct bench_loop *loop)
+{
+	if (loop->conn)
+		(void) common_disconnect_and_wait_for_conn_close(&loop->conn);
+	if (loop->srv_conn)
+		(void) common_wait_for_conn_close_and_disconnect(
+				&loop->srv_conn);
+	if (loop->ep)
+		(void) rpma_ep_shutdown(&loop->ep);
+	if (loop->dst_mr)
+		(void) rpma_mr_dereg(&loop->dst_mr);
+	free(loop->dst);
+}
+
+/*
+ * loop_read -- read from the remote region and wait for the completion
+ */
+static int
+loop_read(struct bench_loop *loop, struct rpma_mr_remote *src, size_t offset,
+		size_t len)
+{
+	struct ibv_wc wc;
+	int ret;
+
+	ret = rpma_read(loop->conn, loop->dst_mr, 0, src, offset, len,
+			RPMA_F_COMPLETION_ALWAYS, NULL);
+	if (ret)
+		return ret;
+
+	do {
+		ret = rpma_cq_get_wc(loop->cq, 1, &wc, NULL);
+	} while (ret == RPMA_E_NO_COMPLETION);
+	if (ret)
+		return ret;
+
+	if (wc.status != IBV_WC_SUCCESS) {
+		(void) fprintf(stderr, "rpma_read() failed: %s\n",
+				ibv_wc_status_str(wc.status));
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * mr_prefetch -- prefetch the whole registered region
+ */
+static int
+mr_prefetch(struct rpma_mr_local *mr, size_t size)
+{
+#ifdef IBV_ADVISE_MR_FLAGS_SUPPORTED
+	return rpma_mr_advise(mr, 0, size, IBV_ADVISE_MR_ADVICE_PREFETCH_WRITE,
+			IBV_ADVISE_MR_FLAG_FLUSH);
+#else
+	(void) mr;
+	(void) size;
+
+	return RPMA_E_NOSUPP;
+#endif
+}
+
+/*
+ * bench_touch -- read the given number of pages spread evenly over
+ * the region and record the latencies of the reads
+ */
+static int
+bench_touch(struct bench_loop *loop, struct rpma_mr_remote *src, size_t size,
+		size_t page, uint64_t touches, struct bench_lat *lat)
+{
+	size_t npages = (size + page - 1) / page;
+	size_t len = size < BENCH_READ_SIZE ? size : BENCH_READ_SIZE;
+
+	if (touches > npages)
+		touches = npages;
+
+	for (uint64_t i = 0; i < touches; i++) {
+		size_t offset = (size_t)(i * npages / touches) * page;
+		uint64_t start = bench_now_ns();
+		int ret = loop_read(loop, src, offset, len);
+		if (ret)
+			return ret;
+		bench_lat_record(lat, bench_now_ns() - start);
+	}
+
+	return 0;
+}
+
+/*
+ * bench_iter -- map, register, (prefetch,) touch, deregister and unmap
+ * a region
+ */
+static int
+bench_iter(struct rpma_peer *peer, struct bench_loop *loop,
+		enum bench_mem mem, int fd, size_t size, size_t map_size,
+		const struct bench_args *args, int advise,
+		struct bench_lat *lat)
+{
+	struct rpma_mr_local *mr = NULL;
+	struct rpma_mr_remote *src = NULL;
+	char desc[DESCRIPTORS_MAX_SIZE];
+	size_t desc_size;
+	uint64_t start;
+	int ret;
+
+	void *addr = mem_map(mem, fd, map_size);
+	if (addr == NULL)
+		return -1;
+
+	start = bench_now_ns();
+	ret = rpma_mr_reg(peer, addr, size, RPMA_MR_USAGE_READ_SRC, &mr);
+	if (ret)
+		goto err_unmap;
+	bench_lat_record(&lat[BENCH_PHASE_REG], bench_now_ns() - start);
+
+	if (args->touches == 0)
+		goto dereg;
+
+	if (advise) {
+		start = bench_now_ns();
+		/* e.g. a pinned region cannot be prefetched */
+		ret = mr_prefetch(mr, size) ? RPMA_E_NOSUPP : 0;
+		if (ret)
+			goto err_dereg;
+		bench_lat_record(&lat[BENCH_PHASE_ADVISE],
+				bench_now_ns() - start);
+	}
+
+	ret = rpma_mr_get_descriptor_size(mr, &desc_size);
+	if (!ret && desc_size > DESCRIPTORS_MAX_SIZE)
+		ret = -1;
+	if (!ret)
+		ret = rpma_mr_get_descriptor(mr, desc);
+	if (!ret)
+		ret = rpma_mr_remote_from_descriptor(desc, desc_size, &src);
+	if (ret)
+		goto err_dereg;
+
+	size_t page = mem_page_size(mem);
+	ret = bench_touch(loop, src, size, page, args->touches,
+			&lat[BENCH_PHASE_FIRST_TOUCH]);
+	if (!ret)
+		ret = bench_touch(loop, src, size, page, args->touches,
+				&lat[BENCH_PHASE_SECOND_TOUCH]);
+	(void) rpma_mr_remote_delete(&src);
+	if (ret)
+		goto err_dereg;
+
+dereg:
+	start = bench_now_ns();
+	ret = rpma_mr_dereg(&mr);
+	if (ret)
+		goto err_unmap;
+	bench_lat_record(&lat[BENCH_PHASE_DEREG], bench_now_ns() - start);
+
+	(void) munmap(addr, map_size);
+	return 0;
+
+err_dereg:
+	(void) rpma_mr_dereg(&mr);
+
+err_unmap:
+	(void) munmap(addr, map_size);
+	return ret;
+}
+
+/*
+ * bench_report -- print and write the results of the combination
+ */
+static void
+bench_report(enum bench_mem mem, size_t size, int advise,
+		struct bench_lat *lat, struct bench_json *js)
+{
+	/* keep stdout clean if the JSON results are written there */
+	FILE *out = (js && js->file == stdout) ? stderr : stdout;
+	char prefix[32];
+
+	(void) fprintf(out, "mr %s size %zu prefetch %s:\n",
+			bench_mem_names[mem], size, advise ? "yes" : "no");
+
+	for (int p = 0; p < BENCH_PHASE_MAX; p++) {
+		if (lat[p].count == 0)
+			continue;
+
+		(void) snprintf(prefix, sizeof(prefix), "   %-12s",
+				bench_phase_names[p]);
+		bench_print_lat(out, prefix, &lat[p]);
+
+		if (js == NULL)
+			continue;
+
+		bench_json_row_begin(js);
+		bench_json_str(js, "op", "mr");
+		bench_json_str(js, "mem", bench_mem_names[mem]);
+		bench_json_uint(js, "bs", size);
+		bench_json_uint(js, "prefetch", (uint64_t)advise);
+		bench_json_str(js, "phase", bench_phase_names[p]);
+		bench_json_uint(js, "ops", lat[p].count);
+		bench_json_lat(js, &lat[p]);
+		bench_json_row_end(js);
+	}
+}
+
+/*
+ * bench_combination -- run one combination of the backing type, the size
+ * and prefetching
+ */
+static int
+bench_combination(struct rpma_peer *peer, struct bench_loop *loop,
+		enum bench_mem mem, size_t size, const struct bench_args *args,
+		int advise, struct bench_json *js)
+{
+	struct bench_lat lat[BENCH_PHASE_MAX];
+	size_t page = mem_page_size(mem);
+	/* the hugepage and the devdax mappings have to be aligned */
+	size_t map_size = (size + page - 1) / page * page;
+	int fd = -1;
+	int ret = 0;
+	int p;
+
+	for (p = 0; p < BENCH_PHASE_MAX; p++) {
+		if (bench_lat_init(&lat[p], args->iters * (args->touches + 1))) {
+			ret = -1;
+			goto err_lat_fini;
+		}
+	}
+
+	if (mem == BENCH_MEM_FSDAX || mem == BENCH_MEM_DEVDAX) {
+		fd = mem_open(mem, args->path, map_size);
+		if (fd == -1) {
+			ret = -1;
+			goto err_lat_fini;
+		}
+	}
+
+	for (uint64_t i = 0; i < args->iters && !ret; i++)
+		ret = bench_iter(peer, loop, mem, fd, size, map_size, args,
+				advise, lat);
+
+	if (fd != -1)
+		(void) close(fd);
+
+	if (ret == RPMA_E_NOSUPP && advise) {
+		(void) fprintf(stderr,
+			"mr %s size %zu: prefetching is not supported (the region is not ODP?)\n",
+			bench_mem_names[mem], size);
+		ret = 0;
+	} else if (ret) {
+		(void) fprintf(stderr, "mr %s size %zu prefetch %s: failed\n",
+				bench_mem_names[mem], size,
+				advise ? "yes" : "no");
+	} else {
+		bench_report(mem, size, advise, lat, js);
+	}
+
+err_lat_fini:
+	while (p--)
+		bench_lat_fini(&lat[p]);
+
+	return ret;
+}
+
+/*
+ * bench_parse_mems -- parse a comma-separated list of the backing types
+ */
+static int
+bench_parse_mems(const char *str, enum bench_mem mems[BENCH_MEM_MAX])
+{
+	char buf[64];
+	int n = 0;
+
+	if (strlen(str) >= sizeof(buf))
+		return -1;
+	strcpy(buf, str);
+
+	char *saveptr = NULL;
+	for (char *tok = strtok_r(buf, ",", &saveptr); tok != NULL;
+			tok = strtok_r(NULL, ",", &saveptr)) {
+		int m;
+		for (m = 0; m < BENCH_MEM_MAX; m++) {
+			if (strcmp(tok, bench_mem_names[m]) == 0)
+				break;
+		}
+		if (m == BENCH_MEM_MAX || n == BENCH_MEM_MAX)
+			return -1;
+		mems[n++] = (enum bench_mem)m;
+	}
+
+	return n ? n : -1;
+}
+
+static void
+usage(const char *name)
+{
+	(void) fprintf(stderr, USAGE_STR, name);
+}
+
+int
+main(int argc, char *argv[])
+{
+	static const struct option long_options[] = {
+		{"mem", required_argument, NULL, 'm'},
+		{"path", required_argument, NULL, 'p'},
+		{"size", required_argument, NULL, 's'},
+		{"iters", required_argument, NULL, 'i'},
+		{"touches", required_argument, NULL, 'T'},
+		{"json", required_argument, NULL, 'j'},
+		{NULL, 0, NULL, 0}
+	};
+	enum bench_mem mems[BENCH_MEM_MAX] = {BENCH_MEM_ANON};
+	uint64_t sizes[BENCH_LIST_MAX];
+	int nmems = 1;
+	int nsizes = bench_parse_list("4k,64k,1m,16m,256m", sizes);
+	const char *json_path = NULL;
+	struct bench_args args = {
+		.iters = 100,
+		.touches = 16,
+	};
+	int opt;
+
+	while ((opt = getopt_long(argc, argv, "m:p:s:i:T:j:",
+			long_options, NULL)) != -1) {
+		int err = 0;
+
+		switch (opt) {
+		case 'm':
+			err = (nmems = bench_parse_mems(optarg, mems)) < 0;
+			break;
+		case 'p':
+			args.path = optarg;
+			break;
+		case 's':
+			err = (nsizes = bench_parse_list(optarg, sizes)) < 0;
+			break;
+		case 'i':
+			err = bench_parse_size(optarg, &args.iters) ||
+					args.iters == 0;
+			break;
+		case 'T':
+			err = bench_parse_size(optarg, &args.touches);
+			break;
+		case 'j':
+			json_path = optarg;
+			break;
+		default:
+			err = 1;
+			break;
+		}
+
+		if (err) {
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (argc - optind != 2) {
+		usage(argv[0]);
+		return 1;
+	}
+	const char *addr = argv[optind];
+	const char *port = argv[optind + 1];
+
+	for (int i = 0; i < nsizes; i++) {
+		if (sizes[i] == 0) {
+			(void) fprintf(stderr, "invalid size: 0\n");
+			return 1;
+		}
+	}
+
+	struct rpma_peer *peer = NULL;
+	struct bench_loop loop;
+	struct bench_json js;
+	int is_odp_capable = 0;
+	struct ibv_context *ibv_ctx;
+
+	memset(&loop, 0, sizeof(loop));
+
+	int ret = rpma_utils_get_ibv_context(addr,
+			RPMA_UTIL_IBV_CONTEXT_LOCAL, &ibv_ctx);
+	if (ret)
+		return 1;
+
+	ret = rpma_utils_ibv_context_is_odp_capable(ibv_ctx, &is_odp_capable);
+	if (ret)
+		return 1;
+	(void) fprintf(stderr, "On-Demand Paging is %ssupported\n",
+			is_odp_capable ? "" : "not ");
+
+	ret = rpma_peer_new(ibv_ctx, &peer);
+	if (ret)
+		return 1;
+
+	if (args.touches) {
+		ret = loop_connect(peer, addr, port, &loop);
+		if (ret)
+			goto err_loop_disconnect;
+	}
+
+	if (json_path && bench_json_open(&js, json_path)) {
+		ret = -1;
+		goto err_loop_disconnect;
+	}
+
+	for (int m = 0; m < nmems && !ret; m++) {
+		for (int s = 0; s < nsizes && !ret; s++) {
+			/* the second pass prefetches the regions */
+			for (int advise = 0; advise <= (args.touches ? 1 : 0) &&
+					!ret; advise++) {
+				ret = bench_combination(peer, &loop, mems[m],
+						(size_t)sizes[s], &args, advise,
+						json_path ? &js : NULL);
+			}
+		}
+	}
+
+	if (json_path && bench_json_close(&js))
+		ret = -1;
+
+err_loop_disconnect:
+	loop_disconnect(&loop);
+	(void) rpma_peer_delete(&peer);
+
+	return ret ? 1 : 0;
+}
@@ -0,0 +1,550 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * rpma-bench-overhead.c -- the benchmark of the overhead of the library itself
+ *
+ * The benchmark is linked with the librpma_fake flavor of the library
+ * (the BUILD_FAKE_VERBS CMake option), in which the verbs are provided by
+ * an in-process fake: the work requests are executed by memcpy() and
+ * completed immediately when they are posted. Both sides of the connection
+ * run in this process, so no RDMA-capable hardware is needed and the results
+ * do not depend on the network.
+ *
+ * For every combination of the operations, the block sizes and the queue
+ * depths the benchmark posts queue depth operations at once and polls all
+ * their completions with rpma_cq_get_wc() over and over again and measures
+ * separately the time of the posting calls and the time of the polling ones.
+ *
+ * The operations are:
+ * - read - rpma_read(),
+ * - write - rpma_write(),
+ * - flush - rpma_write() (completed on error only) followed by rpma_flush()
+ *   (RPMA_FLUSH_TYPE_VISIBILITY),
+ * - send - rpma_recv() of the other side followed by rpma_send(),
+ *   the completions of both sides are polled,
+ * - atomic_write - rpma_atomic_write() of 8 bytes.
+ *
+ * The results are printed in a human-readable form and, if requested,
+ * written to a JSON file in the format of the results of tools/perf.
+ */
+
+#include <getopt.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <librpma.h>
+
+#include "common-conn.h"
+#include "bench-common.h"
+
+#define USAGE_STR \
+"usage: %s [<options>]\n\
+\n\
+options:\n\
+  -o, --op=<list>        read, write, flush, send and atomic_write\n\
+                         (default read,write,flush,send)\n\
+  -b, --bs=<list>        block sizes (default 8,4k)\n\
+  -q, --qd=<list>        queue depths (default 1,16, at most %u)\n\
+  -i, --iters=<n>        measured operations of every combination\n\
+                         (default 1m)\n\
+  -w, --warmup=<n>       warm-up operations of every combination\n\
+                         (default 100k)\n\
+  -j, --json=<path>      write the results as JSON ('-' means stdout)\n\
+\n\
+a <list> is a comma-separated list of values (e.g. 64,4k,1m)\n"
+
+/*
+ * the address and the port of the connection; the fake provider resolves
+ * every address to its only device
+ */
+#define BENCH_ADDR "127.0.0.1"
+#define BENCH_PORT "7204"
+
+/* the maximum queue depth (the queues of the connection are sized for it) */
+#define BENCH_QD_MAX 256
+
+enum bench_op {
+	BENCH_OP_READ,
+	BENCH_OP_WRITE,
+	BENCH_OP_FLUSH,
+	BENCH_OP_SEND,
+	BENCH_OP_ATOMIC_WRITE,
+	BENCH_OP_MAX
+};
+
+static const char *const bench_op_names[BENCH_OP_MAX] = {
+	"read",
+	"write",
+	"flush",
+	"send",
+	"atomic_write",
+};
+
+/* the connection of the two sides in this process */
+struct bench_loop {
+	struct rpma_peer *peer;
+	struct rpma_ep *ep;
+	struct rpma_conn *conn; /* the active side */
+	struct rpma_conn *srv_conn; /* the passive side */
+	struct rpma_cq *cq;
+	struct rpma_cq *srv_cq;
+
+	/* the buffers of both sides (BENCH_QD_MAX blocks of the size) */
+	size_t size;
+	void *buf;
+	void *srv_buf;
+	struct rpma_mr_local *mr;
+	struct rpma_mr_local *srv_mr;
+	struct rpma_mr_remote *srv_mr_remote;
+};
+
+/* the results of a combination */
+struct bench_result {
+	uint64_t ops;
+	uint64_t posts; /* the posting calls */
+	uint64_t polls; /* the calls of rpma_cq_get_wc() */
+	uint64_t wcs; /* the completions polled */
+	uint64_t post_ns;
+	uint64_t poll_ns;
+};
+
+/*
+ * loop_connect -- connect both sides of the connection and register their
+ * buffers of the given size
+ */
+static int
+loop_connect(struct bench_loop *loop, size_t size)
+{
+	struct rpma_conn_cfg *cfg = NULL;
+	struct rpma_conn_req *req = NULL;
+	struct rpma_conn_req *srv_req = NULL;
+	enum rpma_conn_event event = RPMA_CONN_UNDEFINED;
+	struct ibv_context *ibv_ctx;
+	char desc[DESCRIPTORS_MAX_SIZE];
+	size_t desc_size;
+
+	loop->size = size;
+	loop->buf = malloc_aligned(size);
+	loop->srv_buf = malloc_aligned(size);
+	if (loop->buf == NULL || loop->srv_buf == NULL)
+		return -1;
+
+	int ret = rpma_utils_get_ibv_context(BENCH_ADDR,
+			RPMA_UTIL_IBV_CONTEXT_LOCAL, &ibv_ctx);
+	if (!ret)
+		ret = rpma_peer_new(ibv_ctx, &loop->peer);
+	if (ret)
+		return ret;
+
+	ret = rpma_mr_reg(loop->peer, loop->buf, size,
+			RPMA_MR_USAGE_READ_DST | RPMA_MR_USAGE_WRITE_SRC |
+			RPMA_MR_USAGE_SEND, &loop->mr);
+	if (!ret)
+		ret = rpma_mr_reg(loop->peer, loop->srv_buf, size,
+				RPMA_MR_USAGE_READ_SRC | RPMA_MR_USAGE_WRITE_DST |
+				RPMA_MR_USAGE_FLUSH_TYPE_VISIBILITY |
+				RPMA_MR_USAGE_RECV, &loop->srv_mr);
+	if (!ret)
+		ret = rpma_mr_get_descriptor_size(loop->srv_mr, &desc_size);
+	if (!ret && desc_size > DESCRIPTORS_MAX_SIZE)
+		ret = -1;
+	if (!ret)
+		ret = rpma_mr_get_descriptor(loop->srv_mr, desc);
+	if (!ret)
+		ret = rpma_mr_remote_from_descriptor(desc, desc_size,
+				&loop->srv_mr_remote);
+	if (ret)
+		return ret;
+
+	/* a flush takes two work requests of the send queue */
+	ret = rpma_conn_cfg_new(&cfg);
+	if (!ret)
+		ret = rpma_conn_cfg_set_sq_size(cfg, 2 * BENCH_QD_MAX);
+	if (!ret)
+		ret = rpma_conn_cfg_set_rq_size(cfg, BENCH_QD_MAX);
+	if (!ret)
+		ret = rpma_conn_cfg_set_cq_size(cfg, 2 * BENCH_QD_MAX);
+	if (!ret)
+		ret = rpma_ep_listen(loop->peer, BENCH_ADDR, BENCH_PORT,
+				&loop->ep);
+	if (ret)
+		goto err_cfg_delete;
+
+	/* connecting does not wait for the other side */
+	ret = rpma_conn_req_new(loop->peer, BENCH_ADDR, BENCH_PORT, cfg, &req);
+	if (!ret)
+		ret = rpma_conn_req_connect(&req, NULL, &loop->conn);
+	if (!ret)
+		ret = rpma_ep_next_conn_req(loop->ep, cfg, &srv_req);
+	if (!ret)
+		ret = rpma_conn_req_connect(&srv_req, NULL, &loop->srv_conn);
+	if (ret)
+		goto err_cfg_delete;
+
+	ret = rpma_conn_next_event(loop->conn, &event);
+	if (!ret && event == RPMA_CONN_ESTABLISHED)
+		ret = rpma_conn_next_event(loop->srv_conn, &event);
+	if (!ret && event != RPMA_CONN_ESTABLISHED) {
+		(void) fprintf(stderr,
+			"rpma_conn_next_event returned an unexpected event: %s\n",
+			rpma_utils_conn_event_2str(event));
+		ret = -1;
+	}
+	if (!ret)
+		ret = rpma_conn_get_cq(loop->conn, &loop->cq);
+	if (!ret)
+		ret = rpma_conn_get_cq(loop->srv_conn, &loop->srv_cq);
+
+err_cfg_delete:
+	(void) rpma_conn_cfg_delete(&cfg);
+	return ret;
+}
+
+/*
+ * loop_disconnect -- close the connection and release its resources
+ */
+static void
+loop_disconnect(struct bench_loop *loop)
+{
+	if (loop->conn)
+		(void) common_disconnect_and_wait_for_conn_close(&loop->conn);
+	if (loop->srv_conn)
+		(void) common_wait_for_conn_close_and_disconnect(
+				&loop->srv_conn);
+	if (loop->ep)
+		(void) rpma_ep_shutdown(&loop->ep);
+	if (loop->srv_mr_remote)
+		(void) rpma_mr_remote_delete(&loop->srv_mr_remote);
+	if (loop->srv_mr)
+		(void) rpma_mr_dereg(&loop->srv_mr);
+	if (loop->mr)
+		(void) rpma_mr_dereg(&loop->mr);
+	if (loop->peer)
+		(void) rpma_peer_delete(&loop->peer);
+	free(loop->srv_buf);
+	free(loop->buf);
+}
+
+/*
+ * bench_post -- post the operation of the given slot; returns the number
+ * of the posting calls or a negative error code
+ */
+static int
+bench_post(struct bench_loop *loop, enum bench_op op, size_t bs,
+		unsigned slot)
+{
+	size_t offset = slot * bs;
+	const void *op_context = (void *)(uintptr_t)slot;
+	int ret;
+
+	switch (op) {
+	case BENCH_OP_READ:
+		ret = rpma_read(loop->conn, loop->mr, offset,
+				loop->srv_mr_remote, offset, bs,
+				RPMA_F_COMPLETION_ALWAYS, op_context);
+		return ret ? ret : 1;
+	case BENCH_OP_WRITE:
+		ret = rpma_write(loop->conn, loop->srv_mr_remote, offset,
+				loop->mr, offset, bs,
+				RPMA_F_COMPLETION_ALWAYS, op_context);
+		return ret ? ret : 1;
+	case BENCH_OP_FLUSH:
+		ret = rpma_write(loop->conn, loop->srv_mr_remote, offset,
+				loop->mr, offset, bs,
+				RPMA_F_COMPLETION_ON_ERROR, NULL);
+		if (!ret)
+			ret = rpma_flush(loop->conn, loop->srv_mr_remote,
+					offset, bs, RPMA_FLUSH_TYPE_VISIBILITY,
+					RPMA_F_COMPLETION_ALWAYS, op_context);
+		return ret ? ret : 2;
+	case BENCH_OP_SEND:
+		ret = rpma_recv(loop->srv_conn, loop->srv_mr, offset, bs,
+				op_context);
+		if (!ret)
+			ret = rpma_send(loop->conn, loop->mr, offset, bs,
+					RPMA_F_COMPLETION_ALWAYS, op_context);
+		return ret ? ret : 2;
+	case BENCH_OP_ATOMIC_WRITE:
+		ret = rpma_atomic_write(loop->conn, loop->srv_mr_remote,
+				offset, (char *)loop->buf + offset,
+				RPMA_F_COMPLETION_ALWAYS, op_context);
+		return ret ? ret : 1;
+	default:
+		return -1;
+	}
+}
+
+/*
+ * bench_poll -- poll the given number of the completions of the CQ
+ */
+static int
+bench_poll(struct rpma_cq *cq, unsigned qd, struct ibv_wc *wc,
+		struct bench_result *res)
+{
+	unsigned done = 0;
+
+	while (done < qd) {
+		int num_entries_got = 0;
+		int ret = rpma_cq_get_wc(cq, (int)(qd - done), wc,
+				&num_entries_got);
+		res->polls++;
+		if (ret == RPMA_E_NO_COMPLETION)
+			continue;
+		if (ret)
+			return ret;
+
+		for (int i = 0; i < num_entries_got; i++) {
+			if (wc[i].status != IBV_WC_SUCCESS) {
+				(void) fprintf(stderr,
+					"the operation failed: %s\n",
+					ibv_wc_status_str(wc[i].status));
+				return -1;
+			}
+		}
+		done += (unsigned)num_entries_got;
+	}
+	res->wcs += done;
+
+	return 0;
+}
+
+/*
+ * bench_run -- run the given number of the operations in batches of queue
+ * depth operations
+ */
+static int
+bench_run(struct bench_loop *loop, enum bench_op op, size_t bs, unsigned qd,
+		uint64_t iters, struct bench_result *res)
+{
+	struct ibv_wc wc[BENCH_QD_MAX];
+
+	memset(res, 0, sizeof(*res));
+
+	while (res->ops < iters) {
+		uint64_t start = bench_now_ns();
+		for (unsigned slot = 0; slot < qd; slot++) {
+			int ret = bench_post(loop, op, bs, slot);
+			if (ret < 0)
+				return ret;
+			res->posts += (uint64_t)ret;
+		}
+		uint64_t posted = bench_now_ns();
+
+		int ret = bench_poll(loop->cq, qd, wc, res);
+		if (!ret && op == BENCH_OP_SEND)
+			ret = bench_poll(loop->srv_cq, qd, wc, res);
+		if (ret)
+			return ret;
+
+		res->post_ns += posted - start;
+		res->poll_ns += bench_now_ns() - posted;
+		res->ops += qd;
+	}
+
+	return 0;
+}
+
+/*
+ * bench_report -- print and write the results of the combination
+ */
+static void
+bench_report(enum bench_op op, size_t bs, unsigned qd,
+		const struct bench_result *res, struct bench_json *js)
+{
+	/* keep stdout clean if the JSON results are written there */
+	FILE *out = (js && js->file == stdout) ? stderr : stdout;
+	double post_ns = (double)res->post_ns / (double)res->posts;
+	double poll_ns = (double)res->poll_ns / (double)res->polls;
+	double op_ns = (double)(res->post_ns + res->poll_ns) /
+			(double)res->ops;
+
+	(void) fprintf(out,
+		"%s bs %zu qd %u: %.1f ns/op, %.1f ns/post, %.1f ns/rpma_cq_get_wc (%.2f wc/call), %.2f Mops/s\n",
+		bench_op_names[op], bs, qd, op_ns, post_ns, poll_ns,
+		(double)res->wcs / (double)res->polls, 1e3 / op_ns);
+
+	if (js == NULL)
+		return;
+
+	bench_json_row_begin(js);
+	bench_json_str(js, "op", bench_op_names[op]);
+	bench_json_uint(js, "bs", bs);
+	bench_json_uint(js, "iodepth", qd);
+	bench_json_uint(js, "ops", res->ops);
+	bench_json_double(js, "ns_per_op", op_ns);
+	bench_json_double(js, "ns_per_post", post_ns);
+	bench_json_double(js, "ns_per_get_wc", poll_ns);
+	bench_json_double(js, "wc_per_get_wc",
+			(double)res->wcs / (double)res->polls);
+	bench_json_double(js, "iops_avg", 1e9 / op_ns);
+	bench_json_row_end(js);
+}
+
+/*
+ * bench_parse_ops -- parse a comma-separated list of the operations
+ */
+static int
+bench_parse_ops(const char *str, enum bench_op ops[BENCH_OP_MAX])
+{
+	char buf[64];
+	int n = 0;
+
+	if (strlen(str) >= sizeof(buf))
+		return -1;
+	strcpy(buf, str);
+
+	char *saveptr = NULL;
+	for (char *tok = strtok_r(buf, ",", &saveptr); tok != NULL;
+			tok = strtok_r(NULL, ",", &saveptr)) {
+		int o;
+		for (o = 0; o < BENCH_OP_MAX; o++) {
+			if (strcmp(tok, bench_op_names[o]) == 0)
+				break;
+		}
+		if (o == BENCH_OP_MAX || n == BENCH_OP_MAX)
+			return -1;
+		ops[n++] = (enum bench_op)o;
+	}
+
+	return n ? n : -1;
+}
+
+static void
+usage(const char *name)
+{
+	(void) fprintf(stderr, USAGE_STR, name, BENCH_QD_MAX);
+}
+
+int
+main(int argc, char *argv[])
+{
+	static const struct option long_options[] = {
+		{"op", required_argument, NULL, 'o'},
+		{"bs", required_argument, NULL, 'b'},
+		{"qd", required_argument, NULL, 'q'},
+		{"iters", required_argument, NULL, 'i'},
+		{"warmup", required_argument, NULL, 'w'},
+		{"json", required_argument, NULL, 'j'},
+		{NULL, 0, NULL, 0}
+	};
+	enum bench_op ops[BENCH_OP_MAX];
+	uint64_t bss[BENCH_LIST_MAX];
+	uint64_t qds[BENCH_LIST_MAX];
+	int nops = bench_parse_ops("read,write,flush,send", ops);
+	int nbss = bench_parse_list("8,4k", bss);
+	int nqds = bench_parse_list("1,16", qds);
+	uint64_t iters = 1 << 20;
+	uint64_t warmup = 100 << 10;
+	const char *json_path = NULL;
+	int opt;
+
+	while ((opt = getopt_long(argc, argv, "o:b:q:i:w:j:",
+			long_options, NULL)) != -1) {
+		int err = 0;
+
+		switch (opt) {
+		case 'o':
+			err = (nops = bench_parse_ops(optarg, ops)) < 0;
+			break;
+		case 'b':
+			err = (nbss = bench_parse_list(optarg, bss)) < 0;
+			break;
+		case 'q':
+			err = (nqds = bench_parse_list(optarg, qds)) < 0;
+			break;
+		case 'i':
+			err = bench_parse_size(optarg, &iters) || iters == 0;
+			break;
+		case 'w':
+			err = bench_parse_size(optarg, &warmup);
+			break;
+		case 'j':
+			json_path = optarg;
+			break;
+		default:
+			err = 1;
+			break;
+		}
+
+		if (err) {
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (optind != argc) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	uint64_t bs_max = 0;
+	for (int i = 0; i < nbss; i++) {
+		if (bss[i] == 0) {
+			(void) fprintf(stderr, "invalid block size: 0\n");
+			return 1;
+		}
+		if (bss[i] > bs_max)
+			bs_max = bss[i];
+	}
+	for (int i = 0; i < nqds; i++) {
+		if (qds[i] == 0 || qds[i] > BENCH_QD_MAX) {
+			(void) fprintf(stderr,
+				"invalid queue depth: %" PRIu64 "\n", qds[i]);
+			return 1;
+		}
+	}
+
+	struct bench_loop loop;
+	struct bench_result res;
+	struct bench_json js;
+
+	memset(&loop, 0, sizeof(loop));
+
+	int ret = loop_connect(&loop, (size_t)bs_max * BENCH_QD_MAX);
+	if (ret)
+		goto err_loop_disconnect;
+
+	if (json_path && bench_json_open(&js, json_path)) {
+		ret = -1;
+		goto err_loop_disconnect;
+	}
+
+	for (int o = 0; o < nops && !ret; o++) {
+		for (int b = 0; b < nbss && !ret; b++) {
+			/* the atomic write writes 8 bytes */
+			if (ops[o] == BENCH_OP_ATOMIC_WRITE && b > 0)
+				break;
+			size_t bs = ops[o] == BENCH_OP_ATOMIC_WRITE ?
+					RPMA_ATOMIC_WRITE_ALIGNMENT :
+					(size_t)bss[b];
+
+			for (int q = 0; q < nqds && !ret; q++) {
+				unsigned qd = (unsigned)qds[q];
+
+				if (warmup)
+					ret = bench_run(&loop, ops[o], bs, qd,
+							warmup, &res);
+				if (!ret)
+					ret = bench_run(&loop, ops[o], bs, qd,
+							iters, &res);
+				if (ret)
+					(void) fprintf(stderr,
+						"%s bs %zu qd %u: failed\n",
+						bench_op_names[ops[o]], bs, qd);
+				else
+					bench_report(ops[o], bs, qd, &res,
+							json_path ? &js : NULL);
+			}
+		}
+	}
+
+	if (json_path && bench_json_close(&js))
+		ret = -1;
+
+err_loop_disconnect:
+	loop_disconnect(&loop);
+
+	return ret ? 1 : 0;
+}
@@ -0,0 +1,1247 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * rpma-bench.c -- the latency and bandwidth benchmark of the librpma
+ * data path operations
+ *
+ * The same binary is run as a server and as a client:
+ *
+ * - the server registers one memory region, sends its descriptor to every
+ *   client in the private data of the connection and (for the send
+ *   operation) echoes the messages of the clients back,
+ * - the client runs every combination of the given block sizes, queue depths
+ *   and numbers of threads: every thread opens its own connections to
+ *   the server, keeps queue depth operations in flight on every one of them
+ *   for the warm-up and for the measured time and busy polls (or waits for
+ *   the completion events of) their completion queues.
+ *
+ * The operations are:
+ * - read - rpma_read() from the memory of the server,
+ * - write - rpma_write() to the memory of the server,
+ * - flush - rpma_write() followed by rpma_flush() (RPMA_FLUSH_TYPE_VISIBILITY)
+ *   of the written range (the appliance persistency method),
+ * - send - rpma_send() to the server and rpma_recv() of its echo
+ *   (a round trip of bs bytes in both directions),
+ * - atomic_write - rpma_atomic_write() of 8 bytes.
+ *
+ * Given more operations, the connections of every thread run them in turn,
+ * so all the threads run the same mix of the operations.
+ *
+ * An operation is completed when the completion of its last work request
+ * is polled and its latency is counted from posting its first work request.
+ * The throughput per thread of every number of threads is compared to the one
+ * of the first number of threads of the block size and the queue depth
+ * (the scaling, 1 - linear) and the combinations scaling worse than requested
+ * are flagged.
+ * The results are printed in a human-readable form and, if requested,
+ * written to a JSON file in the format of the results of tools/perf.
+ */
+
+#include <getopt.h>
+#include <inttypes.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <librpma.h>
+
+#include "common-conn.h"
+#include "bench-common.h"
+
+#define USAGE_STR \
+"usage: %s server <server_address> <port> [<options>]\n\
+       %s client <server_address> <port> [<options>]\n\
+\n\
+server options:\n\
+  -s, --size=<bytes>     size of the memory region of the server (default 64M)\n\
+  -n, --conns=<n>        exit after serving n connections (default: never)\n\
+\n\
+client options:\n\
+  -o, --op=<list>        read, write, flush, send or atomic_write (default read);\n\
+                         more operations are run by the connections in turn\n\
+  -b, --bs=<list>        block sizes (default 4k)\n\
+  -q, --qd=<list>        queue depths (default 1, at most %u)\n\
+  -t, --threads=<list>   numbers of threads (default 1)\n\
+  -c, --conns-per-thread=<n>\n\
+                         connections of every thread (default: the number\n\
+                         of the operations)\n\
+  -W, --wait             wait for the completion events (default: busy poll)\n\
+  -m, --min-scaling=<r>  flag the numbers of threads scaling below r\n\
+                         (0 < r <= 1) and exit with 2 if any\n\
+  -d, --duration=<s>     measured time of every combination (default 10)\n\
+  -w, --warmup=<s>       warm-up time of every combination (default 1)\n\
+  -j, --json=<path>      write the results as JSON ('-' means stdout)\n\
+  -S, --samples=<n>      latency samples kept per thread (default %u)\n\
+\n\
+a <list> is a comma-separated list of values (e.g. 64,4k,1m)\n"
+
+/* the maximum queue depth (the queues of the server are sized for it) */
+#define BENCH_QD_MAX 256
+
+/* the maximum number of completions polled at once */
+#define BENCH_WC_MAX 32
+
+/* how long the client waits for the completion events at once */
+#define BENCH_WAIT_TIMEOUT_MS 1000
+
+/* how many empty polls of the server between the checks of the connection */
+#define BENCH_IDLE_POLLS 4096
+
+#define BENCH_REQ_MAGIC 0x52504d42 /* "RPMB" */
+
+enum bench_op {
+	BENCH_OP_READ,
+	BENCH_OP_WRITE,
+	BENCH_OP_FLUSH,
+	BENCH_OP_SEND,
+	BENCH_OP_ATOMIC_WRITE,
+	BENCH_OP_MAX
+};
+
+static const char *const bench_op_names[BENCH_OP_MAX] = {
+	"read",
+	"write",
+	"flush",
+	"send",
+	"atomic_write",
+};
+
+/* the private data of the connection request of the client */
+struct bench_req {
+	uint32_t magic;
+	uint32_t bs;
+	uint16_t qd;
+	uint8_t op;
+};
+
+/* the server */
+
+struct server {
+	struct rpma_peer *peer;
+	struct rpma_mr_local *mr;
+	void *buf;
+	size_t size;
+
+	/* the descriptor of the memory region sent to every client */
+	struct common_data data;
+
+	/* the number of the connection threads still running */
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	unsigned active;
+};
+
+struct server_conn {
+	struct server *srv;
+	struct rpma_conn *conn;
+	struct bench_req req;
+};
+
+/*
+ * conn_event_pending -- check if an event of the connection is waiting
+ */
+static int
+conn_event_pending(struct rpma_conn *conn)
+{
+	struct pollfd pfd = {0};
+
+	if (rpma_conn_get_event_fd(conn, &pfd.fd))
+		return 1;
+	pfd.events = POLLIN;
+
+	return poll(&pfd, 1, 0) != 0;
+}
+
+/*
+ * server_echo -- send every received message back until the client
+ * disconnects
+ */
+static int
+server_echo(struct server_conn *sc)
+{
+	size_t bs = sc->req.bs;
+	size_t send_offset = sc->req.qd * bs;
+	struct rpma_cq *cq = NULL;
+	struct ibv_wc wc[BENCH_WC_MAX];
+	unsigned idle = 0;
+	int num_got;
+
+	int ret = rpma_conn_get_cq(sc->conn, &cq);
+	if (ret)
+		return ret;
+
+	for (;;) {
+		ret = rpma_cq_get_wc(cq, BENCH_WC_MAX, wc, &num_got);
+		if (ret == RPMA_E_NO_COMPLETION) {
+			if (++idle % BENCH_IDLE_POLLS == 0 &&
+					conn_event_pending(sc->conn))
+				return 0;
+			continue;
+		} else if (ret) {
+			return ret;
+		}
+
+		idle = 0;
+		for (int i = 0; i < num_got; i++) {
+			if (wc[i].status == IBV_WC_WR_FLUSH_ERR)
+				return 0; /* the connection is being closed */
+			if (wc[i].status != IBV_WC_SUCCESS) {
+				(void) fprintf(stderr, "server: %s\n",
+					ibv_wc_status_str(wc[i].status));
+				return -1;
+			}
+			if (wc[i].opcode != IBV_WC_RECV)
+				continue;
+
+			size_t slot = (size_t)wc[i].wr_id;
+			ret = rpma_recv(sc->conn, sc->srv->mr, slot * bs, bs,
+					(void *)(uintptr_t)slot);
+			if (!ret)
+				ret = rpma_send(sc->conn, sc->srv->mr,
+					send_offset, bs,
+					RPMA_F_COMPLETION_ALWAYS, NULL);
+			if (ret)
+				return ret;
+		}
+	}
+}
+
+/*
+ * server_conn_thread -- serve the connection until it is closed
+ */
+static void *
+server_conn_thread(void *arg)
+{
+	struct server_conn *sc = arg;
+	struct server *srv = sc->srv;
+
+	if (sc->req.op == BENCH_OP_SEND)
+		(void) server_echo(sc);
+
+	(void) common_wait_for_conn_close_and_disconnect(&sc->conn);
+	free(sc);
+
+	pthread_mutex_lock(&srv->lock);
+	srv->active--;
+	pthread_cond_signal(&srv->cond);
+	pthread_mutex_unlock(&srv->lock);
+
+	return NULL;
+}
+
+/*
+ * server_accept -- accept the next connection and start its thread;
+ * returns 1 if the connection request was rejected
+ */
+static int
+server_accept(struct server *srv, struct rpma_ep *ep,
+		struct rpma_conn_cfg *cfg)
+{
+	struct rpma_conn_req *req = NULL;
+	struct rpma_conn_private_data pdata;
+	enum rpma_conn_event event = RPMA_CONN_UNDEFINED;
+	pthread_t thread;
+
+	int ret = rpma_ep_next_conn_req(ep, cfg, &req);
+	if (ret)
+		return ret;
+
+	struct server_conn *sc = calloc(1, sizeof(*sc));
+	if (sc == NULL) {
+		(void) rpma_conn_req_delete(&req);
+		return -1;
+	}
+	sc->srv = srv;
+
+	/* reject the requests which are not ours or do not fit */
+	ret = rpma_conn_req_get_private_data(req, &pdata);
+	if (ret || pdata.ptr == NULL || pdata.len < sizeof(sc->req)) {
+		(void) fprintf(stderr, "server: an unknown connection request\n");
+		goto err_req_delete;
+	}
+	memcpy(&sc->req, pdata.ptr, sizeof(sc->req));
+	if (sc->req.magic != BENCH_REQ_MAGIC || sc->req.op >= BENCH_OP_MAX ||
+			sc->req.bs == 0 || sc->req.qd == 0 ||
+			sc->req.qd > BENCH_QD_MAX ||
+			(size_t)(sc->req.qd + 1) * sc->req.bs > srv->size) {
+		(void) fprintf(stderr,
+			"server: an invalid connection request (op %u, bs %u, qd %u)\n",
+			sc->req.op, sc->req.bs, sc->req.qd);
+		goto err_req_delete;
+	}
+
+	/* the receives have to be posted before the client starts sending */
+	if (sc->req.op == BENCH_OP_SEND) {
+		for (size_t slot = 0; slot < sc->req.qd; slot++) {
+			ret = rpma_conn_req_recv(req, srv->mr,
+					slot * sc->req.bs, sc->req.bs,
+					(void *)(uintptr_t)slot);
+			if (ret)
+				goto err_req_delete;
+		}
+	}
+
+	pdata.ptr = &srv->data;
+	pdata.len = sizeof(srv->data);
+	ret = rpma_conn_req_connect(&req, &pdata, &sc->conn);
+	if (ret)
+		goto err_req_delete;
+
+	ret = rpma_conn_next_event(sc->conn, &event);
+	if (!ret && event != RPMA_CONN_ESTABLISHED) {
+		(void) fprintf(stderr,
+			"rpma_conn_next_event returned an unexpected event: %s\n",
+			rpma_utils_conn_event_2str(event));
+		ret = -1;
+	}
+	if (ret)
+		goto err_conn_delete;
+
+	pthread_mutex_lock(&srv->lock);
+	srv->active++;
+	pthread_mutex_unlock(&srv->lock);
+
+	ret = pthread_create(&thread, NULL, server_conn_thread, sc);
+	if (ret) {
+		pthread_mutex_lock(&srv->lock);
+		srv->active--;
+		pthread_mutex_unlock(&srv->lock);
+		(void) common_disconnect_and_wait_for_conn_close(&sc->conn);
+		free(sc);
+		return -1;
+	}
+	(void) pthread_detach(thread);
+
+	return 0;
+
+err_conn_delete:
+	(void) rpma_conn_delete(&sc->conn);
+	free(sc);
+	return ret;
+
+err_req_delete:
+	/* deleting the request rejects it */
+	(void) rpma_conn_req_delete(&req);
+	free(sc);
+	return 1;
+}
+
+/*
+ * server_main -- serve the clients
+ */
+static int
+server_main(const char *addr, const char *port, size_t size, long conns)
+{
+	struct server srv;
+	struct rpma_conn_cfg *cfg = NULL;
+	struct rpma_ep *ep = NULL;
+	size_t mr_desc_size;
+	int ret;
+
+	memset(&srv, 0, sizeof(srv));
+	srv.size = size;
+	pthread_mutex_init(&srv.lock, NULL);
+	pthread_cond_init(&srv.cond, NULL);
+
+	ret = server_peer_via_address(addr, &srv.peer);
+	if (ret)
+		return ret;
+
+	srv.buf = malloc_aligned(size);
+	if (srv.buf == NULL) {
+		ret = -1;
+		goto err_peer_delete;
+	}
+
+	ret = rpma_mr_reg(srv.peer, srv.buf, size,
+			RPMA_MR_USAGE_READ_SRC | RPMA_MR_USAGE_WRITE_DST |
+			RPMA_MR_USAGE_FLUSH_TYPE_VISIBILITY |
+			RPMA_MR_USAGE_SEND | RPMA_MR_USAGE_RECV, &srv.mr);
+	if (ret)
+		goto err_free;
+
+	ret = rpma_mr_get_descriptor_size(srv.mr, &mr_desc_size);
+	if (ret)
+		goto err_mr_dereg;
+	if (mr_desc_size > DESCRIPTORS_MAX_SIZE) {
+		(void) fprintf(stderr, "the memory descriptor is too big\n");
+		ret = -1;
+		goto err_mr_dereg;
+	}
+	srv.data.mr_desc_size = (uint8_t)mr_desc_size;
+	ret = rpma_mr_get_descriptor(srv.mr, &srv.data.descriptors[0]);
+	if (ret)
+		goto err_mr_dereg;
+
+	/* the queues have to fit the deepest queue of the send operation */
+	ret = rpma_conn_cfg_new(&cfg);
+	if (!ret)
+		ret = rpma_conn_cfg_set_sq_size(cfg, BENCH_QD_MAX);
+	if (!ret)
+		ret = rpma_conn_cfg_set_rq_size(cfg, BENCH_QD_MAX);
+	if (!ret)
+		ret = rpma_conn_cfg_set_cq_size(cfg, 2 * BENCH_QD_MAX);
+	if (ret)
+		goto err_cfg_delete;
+
+	ret = rpma_ep_listen(srv.peer, addr, port, &ep);
+	if (ret)
+		goto err_cfg_delete;
+
+	(void) printf("server: listening at %s:%s (%zu bytes)\n",
+			addr, port, size);
+
+	for (long served = 0; conns < 0 || served < conns; ) {
+		ret = server_accept(&srv, ep, cfg);
+		if (ret < 0)
+			break;
+		if (ret == 0)
+			served++;
+	}
+	if (ret > 0)
+		ret = 0;
+
+	/* wait for the connections still being served */
+	pthread_mutex_lock(&srv.lock);
+	while (srv.active)
+		pthread_cond_wait(&srv.cond, &srv.lock);
+	pthread_mutex_unlock(&srv.lock);
+
+	(void) rpma_ep_shutdown(&ep);
+
+err_cfg_delete:
+	(void) rpma_conn_cfg_delete(&cfg);
+
+err_mr_dereg:
+	(void) rpma_mr_dereg(&srv.mr);
+
+err_free:
+	free(srv.buf);
+
+err_peer_delete:
+	(void) rpma_peer_delete(&srv.peer);
+
+	return ret;
+}
+
+/* the client */
+
+struct client_args {
+	const char *addr;
+	const char *port;
+	/* the operations of the connections of every thread (in turn) */
+	enum bench_op ops[BENCH_OP_MAX];
+	unsigned nops;
+	size_t bs;
+	unsigned qd;
+	unsigned conns; /* per thread */
+	int wait; /* wait for the completion events instead of busy polling */
+	uint64_t warmup_ns;
+	uint64_t duration_ns;
+	uint64_t samples;
+};
+
+/* a connection of a client thread and its operation */
+struct client_conn {
+	enum bench_op op;
+
+	/* prepared by the main thread (rpma_conn_req_new()) */
+	struct rpma_conn_req *req;
+
+	struct rpma_conn *conn;
+	struct rpma_cq *cq;
+	struct rpma_mr_remote *remote_mr;
+	size_t remote_size;
+
+	/* the offset of the part of the buffer of the thread it uses */
+	size_t offset;
+
+	/* per operation slot */
+	uint64_t *start;
+	size_t *remote_offset;
+	unsigned inflight;
+};
+
+struct client_thread {
+	pthread_t thread;
+	unsigned tid;
+	const struct client_args *args;
+	pthread_barrier_t *barrier;
+
+	/* prepared by the main thread (rpma_mr_reg() and rpma_conn_req_new()) */
+	struct rpma_mr_local *mr;
+	void *buf;
+	struct client_conn *conns;
+
+	/* the file descriptors of the completion channels (--wait) */
+	struct pollfd *pfds;
+
+	/* results */
+	struct bench_lat lat;
+	uint64_t ops;
+	uint64_t elapsed_ns;
+	int ret;
+};
+
+/* the results of the previous thread counts of bs and qd */
+struct client_scaling {
+	unsigned base_threads; /* 0 - no result yet */
+	double base_iops; /* per thread */
+	double min; /* flag the combinations scaling below it (0 - never) */
+	unsigned nonlinear; /* the number of the flagged combinations */
+};
+
+/*
+ * client_post -- post the operation of the slot of the connection
+ */
+static int
+client_post(struct client_thread *ct, struct client_conn *cc, unsigned slot)
+{
+	const struct client_args *args = ct->args;
+	size_t offset = cc->offset + slot * args->bs;
+	size_t remote_offset = cc->remote_offset[slot];
+	const void *op_context = (void *)(uintptr_t)slot;
+	int ret;
+
+	cc->start[slot] = bench_now_ns();
+
+	switch (cc->op) {
+	case BENCH_OP_READ:
+		return rpma_read(cc->conn, ct->mr, offset, cc->remote_mr,
+				remote_offset, args->bs,
+				RPMA_F_COMPLETION_ALWAYS, op_context);
+	case BENCH_OP_WRITE:
+		return rpma_write(cc->conn, cc->remote_mr, remote_offset,
+				ct->mr, offset, args->bs,
+				RPMA_F_COMPLETION_ALWAYS, op_context);
+	case BENCH_OP_FLUSH:
+		ret = rpma_write(cc->conn, cc->remote_mr, remote_offset,
+				ct->mr, offset, args->bs,
+				RPMA_F_COMPLETION_ON_ERROR, NULL);
+		if (ret)
+			return ret;
+		return rpma_flush(cc->conn, cc->remote_mr, remote_offset,
+				args->bs, RPMA_FLUSH_TYPE_VISIBILITY,
+				RPMA_F_COMPLETION_ALWAYS, op_context);
+	case BENCH_OP_SEND:
+		/* the echo is received to the second half of the buffer */
+		ret = rpma_recv(cc->conn, ct->mr,
+				args->qd * args->bs + offset, args->bs,
+				op_context);
+		if (ret)
+			return ret;
+		return rpma_send(cc->conn, ct->mr, offset, args->bs,
+				RPMA_F_COMPLETION_ALWAYS, NULL);
+	case BENCH_OP_ATOMIC_WRITE:
+		return rpma_atomic_write(cc->conn, cc->remote_mr,
+				remote_offset, (char *)ct->buf + offset,
+				RPMA_F_COMPLETION_ALWAYS, op_context);
+	default:
+		return -1;
+	}
+}
+
+/*
+ * client_wait -- wait for the completion events of the connections
+ * still having operations in flight
+ */
+static int
+client_wait(struct client_thread *ct)
+{
+	const struct client_args *args = ct->args;
+
+	for (unsigned c = 0; c < args->conns; c++)
+		ct->pfds[c].events = ct->conns[c].inflight ? POLLIN : 0;
+
+	int nready = poll(ct->pfds, args->conns, BENCH_WAIT_TIMEOUT_MS);
+	if (nready < 0) {
+		perror("poll");
+		return -1;
+	}
+
+	for (unsigned c = 0; c < args->conns && nready > 0; c++) {
+		if (!(ct->pfds[c].revents & POLLIN))
+			continue;
+		nready--;
+
+		/* acks the event and requests the next one */
+		int ret = rpma_cq_wait(ct->conns[c].cq);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+/*
+ * client_run -- keep qd operations in flight on every connection
+ * for the given time and wait for all of them to complete
+ */
+static int
+client_run(struct client_thread *ct, uint64_t duration_ns)
+{
+	const struct client_args *args = ct->args;
+	struct ibv_wc wc[BENCH_WC_MAX];
+	unsigned inflight = 0;
+	int num_got;
+	int ret;
+
+	uint64_t begin = bench_now_ns();
+	uint64_t end = begin + duration_ns;
+
+	for (unsigned c = 0; c < args->conns; c++) {
+		struct client_conn *cc = &ct->conns[c];
+
+		for (unsigned slot = 0; slot < args->qd; slot++) {
+			ret = client_post(ct, cc, slot);
+			if (ret)
+				return ret;
+			cc->inflight++;
+			inflight++;
+		}
+	}
+
+	while (inflight) {
+		int polled = 0;
+
+		for (unsigned c = 0; c < args->conns; c++) {
+			struct client_conn *cc = &ct->conns[c];
+
+			if (!cc->inflight)
+				continue;
+
+			ret = rpma_cq_get_wc(cc->cq, BENCH_WC_MAX, wc,
+					&num_got);
+			if (ret == RPMA_E_NO_COMPLETION)
+				continue;
+			else if (ret)
+				return ret;
+
+			polled = 1;
+			uint64_t now = bench_now_ns();
+			for (int i = 0; i < num_got; i++) {
+				if (wc[i].status != IBV_WC_SUCCESS) {
+					(void) fprintf(stderr, "client: %s\n",
+						ibv_wc_status_str(
+							wc[i].status));
+					return -1;
+				}
+				/* the send completes when its echo is received */
+				if (cc->op == BENCH_OP_SEND &&
+						wc[i].opcode != IBV_WC_RECV)
+					continue;
+
+				unsigned slot = (unsigned)wc[i].wr_id;
+				bench_lat_record(&ct->lat,
+						now - cc->start[slot]);
+				ct->ops++;
+				cc->inflight--;
+				inflight--;
+
+				if (now >= end)
+					continue;
+
+				ret = client_post(ct, cc, slot);
+				if (ret)
+					return ret;
+				cc->inflight++;
+				inflight++;
+			}
+		}
+
+		if (!polled && args->wait && inflight) {
+			ret = client_wait(ct);
+			if (ret)
+				return ret;
+		}
+	}
+
+	ct->elapsed_ns = bench_now_ns() - begin;
+
+	return 0;
+}
+
+/*
+ * client_connect_conn -- connect the request of the connection and get
+ * the memory region of the server
+ */
+static int
+client_connect_conn(struct client_thread *ct, unsigned c)
+{
+	const struct client_args *args = ct->args;
+	struct client_conn *cc = &ct->conns[c];
+	struct rpma_conn_private_data pdata;
+	enum rpma_conn_event event = RPMA_CONN_UNDEFINED;
+	struct bench_req breq = {
+		.magic = BENCH_REQ_MAGIC,
+		.bs = (uint32_t)args->bs,
+		.qd = (uint16_t)args->qd,
+		.op = (uint8_t)cc->op,
+	};
+
+	pdata.ptr = &breq;
+	pdata.len = sizeof(breq);
+	int ret = rpma_conn_req_connect(&cc->req, &pdata, &cc->conn);
+	if (ret)
+		return ret;
+
+	ret = rpma_conn_next_event(cc->conn, &event);
+	if (!ret && event != RPMA_CONN_ESTABLISHED) {
+		(void) fprintf(stderr,
+			"rpma_conn_next_event returned an unexpected event: %s\n",
+			rpma_utils_conn_event_2str(event));
+		ret = -1;
+	}
+	if (ret)
+		return ret;
+
+	ret = rpma_conn_get_private_data(cc->conn, &pdata);
+	if (ret)
+		return ret;
+	if (pdata.ptr == NULL || pdata.len < sizeof(struct common_data)) {
+		(void) fprintf(stderr,
+			"the server has not provided a memory region\n");
+		return -1;
+	}
+
+	struct common_data *data = pdata.ptr;
+	ret = rpma_mr_remote_from_descriptor(&data->descriptors[0],
+			data->mr_desc_size, &cc->remote_mr);
+	if (ret)
+		return ret;
+
+	ret = rpma_mr_remote_get_size(cc->remote_mr, &cc->remote_size);
+	if (ret)
+		return ret;
+	if (cc->remote_size < args->bs) {
+		(void) fprintf(stderr,
+			"the memory region of the server is too small (%zu < %zu)\n",
+			cc->remote_size, args->bs);
+		return -1;
+	}
+
+	/* the connections and the slots use separate blocks where possible */
+	size_t nblocks = cc->remote_size / args->bs;
+	size_t first = ((size_t)ct->tid * args->conns + c) * args->qd;
+	for (unsigned slot = 0; slot < args->qd; slot++)
+		cc->remote_offset[slot] =
+			((first + slot) % nblocks) * args->bs;
+
+	ret = rpma_conn_get_cq(cc->conn, &cc->cq);
+	if (ret || !args->wait)
+		return ret;
+
+	return rpma_cq_get_fd(cc->cq, &ct->pfds[c].fd);
+}
+
+/*
+ * client_thread_func -- connect, warm up and measure
+ */
+static void *
+client_thread_func(void *arg)
+{
+	struct client_thread *ct = arg;
+	const struct client_args *args = ct->args;
+
+	for (unsigned c = 0; c < args->conns && !ct->ret; c++)
+		ct->ret = client_connect_conn(ct, c);
+
+	/* all the threads start measuring at the same time */
+	(void) pthread_barrier_wait(ct->barrier);
+
+	if (!ct->ret && args->warmup_ns) {
+		ct->ret = client_run(ct, args->warmup_ns);
+		bench_lat_reset(&ct->lat);
+		ct->ops = 0;
+	}
+
+	(void) pthread_barrier_wait(ct->barrier);
+
+	if (!ct->ret)
+		ct->ret = client_run(ct, args->duration_ns);
+
+	for (unsigned c = 0; c < args->conns; c++) {
+		struct client_conn *cc = &ct->conns[c];
+
+		if (cc->remote_mr)
+			(void) rpma_mr_remote_delete(&cc->remote_mr);
+		if (cc->conn)
+			(void) common_disconnect_and_wait_for_conn_close(
+					&cc->conn);
+	}
+
+	return NULL;
+}
+
+/*
+ * client_thread_fini -- release the resources of the thread
+ */
+static void
+client_thread_fini(struct client_thread *ct)
+{
+	const struct client_args *args = ct->args;
+
+	for (unsigned c = 0; ct->conns && c < args->conns; c++) {
+		struct client_conn *cc = &ct->conns[c];
+
+		if (cc->req)
+			(void) rpma_conn_req_delete(&cc->req);
+		free(cc->start);
+		free(cc->remote_offset);
+	}
+	if (ct->mr)
+		(void) rpma_mr_dereg(&ct->mr);
+	free(ct->buf);
+	free(ct->conns);
+	free(ct->pfds);
+	bench_lat_fini(&ct->lat);
+}
+
+/*
+ * client_thread_init -- prepare the resources of the thread which cannot be
+ * created concurrently (see THREAD_SAFETY.md)
+ */
+static int
+client_thread_init(struct client_thread *ct, struct rpma_peer *peer,
+		struct rpma_conn_cfg *cfg)
+{
+	const struct client_args *args = ct->args;
+	/* the send operation receives the echo to the second half */
+	size_t conn_size = 2 * args->qd * args->bs;
+	size_t size = args->conns * conn_size;
+
+	ct->buf = malloc_aligned(size);
+	ct->conns = calloc(args->conns, sizeof(*ct->conns));
+	ct->pfds = calloc(args->conns, sizeof(*ct->pfds));
+	if (ct->buf == NULL || ct->conns == NULL || ct->pfds == NULL ||
+			bench_lat_init(&ct->lat, args->samples))
+		return -1;
+
+	int ret = rpma_mr_reg(peer, ct->buf, size,
+			RPMA_MR_USAGE_READ_DST | RPMA_MR_USAGE_WRITE_SRC |
+			RPMA_MR_USAGE_SEND | RPMA_MR_USAGE_RECV, &ct->mr);
+	if (ret)
+		return ret;
+
+	/* every thread runs the same mix of the operations */
+	for (unsigned c = 0; c < args->conns; c++) {
+		struct client_conn *cc = &ct->conns[c];
+
+		cc->op = args->ops[c % args->nops];
+		cc->offset = c * conn_size;
+		cc->start = calloc(args->qd, sizeof(*cc->start));
+		cc->remote_offset = calloc(args->qd,
+				sizeof(*cc->remote_offset));
+		if (cc->start == NULL || cc->remote_offset == NULL)
+			return -1;
+
+		ret = rpma_conn_req_new(peer, args->addr, args->port, cfg,
+				&cc->req);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+/*
+ * client_op_name -- the name of the operation or "mix" of the operations
+ */
+static const char *
+client_op_name(const struct client_args *args)
+{
+	return args->nops == 1 ? bench_op_names[args->ops[0]] : "mix";
+}
+
+/*
+ * client_combination -- run one combination of bs, qd and the number
+ * of threads and report its results
+ */
+static int
+client_combination(struct rpma_peer *peer, const struct client_args *args,
+		unsigned nthreads, struct client_scaling *sc,
+		struct bench_json *js)
+{
+	struct rpma_conn_cfg *cfg = NULL;
+	pthread_barrier_t barrier;
+	struct bench_lat lat;
+	uint64_t ops = 0;
+	uint64_t elapsed_ns = 0;
+	int ret;
+
+	struct client_thread *threads = calloc(nthreads, sizeof(*threads));
+	if (threads == NULL)
+		return -1;
+
+	/* the flush operation posts two work requests per operation */
+	ret = rpma_conn_cfg_new(&cfg);
+	if (!ret)
+		ret = rpma_conn_cfg_set_sq_size(cfg, 2 * args->qd);
+	if (!ret)
+		ret = rpma_conn_cfg_set_rq_size(cfg, args->qd);
+	if (!ret)
+		ret = rpma_conn_cfg_set_cq_size(cfg, 2 * args->qd);
+	if (ret)
+		goto err_free;
+
+	if (bench_lat_init(&lat, args->samples)) {
+		ret = -1;
+		goto err_cfg_delete;
+	}
+
+	unsigned n;
+	for (n = 0; n < nthreads; n++) {
+		threads[n].tid = n;
+		threads[n].args = args;
+		threads[n].barrier = &barrier;
+		ret = client_thread_init(&threads[n], peer, cfg);
+		if (ret) {
+			n++;
+			goto err_threads_fini;
+		}
+	}
+
+	pthread_barrier_init(&barrier, NULL, nthreads);
+
+	for (n = 0; n < nthreads; n++) {
+		ret = pthread_create(&threads[n].thread, NULL,
+				client_thread_func, &threads[n]);
+		if (ret) {
+			/* the barrier would never be passed */
+			(void) fprintf(stderr, "pthread_create: %s\n",
+					strerror(ret));
+			exit(1);
+		}
+	}
+
+	for (n = 0; n < nthreads; n++) {
+		(void) pthread_join(threads[n].thread, NULL);
+		if (threads[n].ret && !ret)
+			ret = threads[n].ret;
+		bench_lat_merge(&lat, &threads[n].lat);
+		ops += threads[n].ops;
+		if (threads[n].elapsed_ns > elapsed_ns)
+			elapsed_ns = threads[n].elapsed_ns;
+	}
+	pthread_barrier_destroy(&barrier);
+
+	if (ret) {
+		(void) fprintf(stderr, "%s bs %zu qd %u threads %u: failed\n",
+				client_op_name(args), args->bs, args->qd,
+				nthreads);
+		goto err_threads_fini;
+	}
+
+	/* keep stdout clean if the JSON results are written there */
+	FILE *out = (js && js->file == stdout) ? stderr : stdout;
+	double seconds = (double)elapsed_ns / 1e9;
+	double iops = (double)ops / seconds;
+	double bw = iops * (double)args->bs * 8 / 1e9; /* Gb/s */
+
+	/*
+	 * the throughput per thread relative to the one of the first number
+	 * of threads of bs and qd (1 - the linear scaling)
+	 */
+	double per_thread = iops / nthreads;
+	if (sc->base_threads == 0) {
+		sc->base_threads = nthreads;
+		sc->base_iops = per_thread;
+	}
+	double scaling = sc->base_iops > 0 ? per_thread / sc->base_iops : 0;
+	int nonlinear = sc->min > 0 && scaling < sc->min;
+	if (nonlinear)
+		sc->nonlinear++;
+
+	(void) fprintf(out, "%s bs %zu qd %u threads %u conns %u: ops %" PRIu64
+			" iops %.0f bw %.2f Gb/s\n",
+			client_op_name(args), args->bs, args->qd, nthreads,
+			args->conns, ops, iops, bw);
+	bench_print_lat(out, "   ", &lat);
+	if (nthreads != sc->base_threads)
+		(void) fprintf(out,
+			"    scaling %.2f (iops per thread %.0f, %.0f with %u threads)%s\n",
+			scaling, per_thread, sc->base_iops, sc->base_threads,
+			nonlinear ? " NON-LINEAR" : "");
+
+	if (js) {
+		bench_json_row_begin(js);
+		bench_json_str(js, "op", client_op_name(args));
+		bench_json_uint(js, "threads", nthreads);
+		bench_json_uint(js, "conns", args->conns);
+		bench_json_uint(js, "iodepth", args->qd);
+		bench_json_uint(js, "bs", args->bs);
+		bench_json_uint(js, "ops", ops);
+		bench_json_lat(js, &lat);
+		bench_json_double(js, "bw_avg", bw);
+		bench_json_double(js, "iops_avg", iops);
+		bench_json_double(js, "scaling", scaling);
+		bench_json_row_end(js);
+	}
+
+err_threads_fini:
+	while (n--)
+		client_thread_fini(&threads[n]);
+	bench_lat_fini(&lat);
+
+err_cfg_delete:
+	(void) rpma_conn_cfg_delete(&cfg);
+
+err_free:
+	free(threads);
+
+	return ret;
+}
+
+/*
+ * bench_parse_op -- get the operation of the name
+ */
+static int
+bench_parse_op(const char *name, size_t len, enum bench_op *op)
+{
+	for (int i = 0; i < BENCH_OP_MAX; i++) {
+		if (strlen(bench_op_names[i]) == len &&
+				strncmp(name, bench_op_names[i], len) == 0) {
+			*op = (enum bench_op)i;
+			return 0;
+		}
+	}
+
+	return -1;
+}
+
+/*
+ * bench_parse_ops -- get the comma-separated list of the operations
+ */
+static int
+bench_parse_ops(const char *str, struct client_args *args)
+{
+	args->nops = 0;
+	for (;;) {
+		size_t len = strcspn(str, ",");
+
+		if (args->nops == BENCH_OP_MAX ||
+				bench_parse_op(str, len,
+					&args->ops[args->nops]))
+			return -1;
+		args->nops++;
+
+		if (str[len] == '\0')
+			return 0;
+		str += len + 1;
+	}
+}
+
+static void
+usage(const char *name)
+{
+	(void) fprintf(stderr, USAGE_STR, name, name, BENCH_QD_MAX,
+			BENCH_LAT_SAMPLES);
+}
+
+int
+main(int argc, char *argv[])
+{
+	static const struct option long_options[] = {
+		{"size", required_argument, NULL, 's'},
+		{"conns", required_argument, NULL, 'n'},
+		{"op", required_argument, NULL, 'o'},
+		{"bs", required_argument, NULL, 'b'},
+		{"qd", required_argument, NULL, 'q'},
+		{"threads", required_argument, NULL, 't'},
+		{"conns-per-thread", required_argument, NULL, 'c'},
+		{"wait", no_argument, NULL, 'W'},
+		{"min-scaling", required_argument, NULL, 'm'},
+		{"duration", required_argument, NULL, 'd'},
+		{"warmup", required_argument, NULL, 'w'},
+		{"json", required_argument, NULL, 'j'},
+		{"samples", required_argument, NULL, 'S'},
+		{NULL, 0, NULL, 0}
+	};
+	uint64_t bs[BENCH_LIST_MAX] = {4096};
+	uint64_t qd[BENCH_LIST_MAX] = {1};
+	uint64_t threads[BENCH_LIST_MAX] = {1};
+	int nbs = 1, nqd = 1, nthreads = 1;
+	uint64_t size = 64 << 20;
+	uint64_t val;
+	long conns = -1;
+	const char *json_path = NULL;
+	struct client_scaling scaling = {0};
+	char *end;
+	struct client_args args = {
+		.ops = {BENCH_OP_READ},
+		.nops = 1,
+		.warmup_ns = 1000000000ULL,
+		.duration_ns = 10000000000ULL,
+		.samples = BENCH_LAT_SAMPLES,
+	};
+	int opt;
+
+	if (argc < 2) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	while ((opt = getopt_long(argc - 1, argv + 1, "s:n:o:b:q:t:c:Wm:d:w:j:S:",
+			long_options, NULL)) != -1) {
+		int err = 0;
+
+		switch (opt) {
+		case 's':
+			err = bench_parse_size(optarg, &size) || size == 0;
+			break;
+		case 'n':
+			err = bench_parse_size(optarg, &val) || val == 0;
+			conns = (long)val;
+			break;
+		case 'o':
+			err = bench_parse_ops(optarg, &args);
+			break;
+		case 'b':
+			err = (nbs = bench_parse_list(optarg, bs)) < 0;
+			break;
+		case 'q':
+			err = (nqd = bench_parse_list(optarg, qd)) < 0;
+			break;
+		case 't':
+			err = (nthreads = bench_parse_list(optarg, threads)) < 0;
+			break;
+		case 'c':
+			err = bench_parse_size(optarg, &val) || val == 0 ||
+					val > UINT16_MAX;
+			args.conns = (unsigned)val;
+			break;
+		case 'W':
+			args.wait = 1;
+			break;
+		case 'm':
+			scaling.min = strtod(optarg, &end);
+			err = *end != '\0' || !(scaling.min > 0) ||
+					scaling.min > 1;
+			break;
+		case 'd':
+			err = bench_parse_size(optarg, &val) || val == 0;
+			args.duration_ns = val * 1000000000ULL;
+			break;
+		case 'w':
+			err = bench_parse_size(optarg, &val);
+			args.warmup_ns = val * 1000000000ULL;
+			break;
+		case 'j':
+			json_path = optarg;
+			break;
+		case 'S':
+			err = bench_parse_size(optarg, &args.samples) ||
+					args.samples == 0;
+			break;
+		default:
+			err = 1;
+			break;
+		}
+
+		if (err) {
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	/* optind counts from argv + 1 */
+	if (argc - 1 - optind != 2) {
+		usage(argv[0]);
+		return 1;
+	}
+	args.addr = argv[1 + optind];
+	args.port = argv[2 + optind];
+
+	if (strcmp(argv[1], "server") == 0)
+		return server_main(args.addr, args.port, size, conns) ? 1 : 0;
+	if (strcmp(argv[1], "client") != 0) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	/* the atomic write always writes 8 bytes */
+	for (unsigned i = 0; i < args.nops; i++) {
+		if (args.ops[i] != BENCH_OP_ATOMIC_WRITE)
+			continue;
+		if (args.nops > 1) {
+			(void) fprintf(stderr,
+				"atomic_write cannot be mixed with other operations\n");
+			return 1;
+		}
+		bs[0] = 8;
+		nbs = 1;
+	}
+
+	if (args.conns == 0)
+		args.conns = args.nops;
+	if (args.conns % args.nops) {
+		(void) fprintf(stderr,
+			"the connections per thread (%u) have to be a multiple of the number of the operations (%u)\n",
+			args.conns, args.nops);
+		return 1;
+	}
+
+	for (int i = 0; i < nbs; i++) {
+		if (bs[i] == 0 || bs[i] > UINT32_MAX) {
+			(void) fprintf(stderr, "invalid block size: %" PRIu64
+					"\n", bs[i]);
+			return 1;
+		}
+	}
+	for (int i = 0; i < nqd; i++) {
+		if (qd[i] == 0 || qd[i] > BENCH_QD_MAX) {
+			(void) fprintf(stderr, "invalid queue depth: %" PRIu64
+					"\n", qd[i]);
+			return 1;
+		}
+	}
+	for (int i = 0; i < nthreads; i++) {
+		if (threads[i] == 0 || threads[i] > UINT16_MAX) {
+			(void) fprintf(stderr, "invalid number of threads: %"
+					PRIu64 "\n", threads[i]);
+			return 1;
+		}
+	}
+
+	struct rpma_peer *peer = NULL;
+	struct bench_json js;
+	int ret = client_peer_via_address(args.addr, &peer);
+	if (ret)
+		return 1;
+
+	if (json_path && bench_json_open(&js, json_path)) {
+		(void) rpma_peer_delete(&peer);
+		return 1;
+	}
+
+	for (int b = 0; b < nbs && !ret; b++) {
+		for (int q = 0; q < nqd && !ret; q++) {
+			/* the scaling is relative to the first number of threads */
+			scaling.base_threads = 0;
+			for (int t = 0; t < nthreads && !ret; t++) {
+				args.bs = (size_t)bs[b];
+				args.qd = (unsigned)qd[q];
+				ret = client_combination(peer, &args,
+						(unsigned)threads[t], &scaling,
+						json_path ? &js : NULL);
+			}
+		}
+	}
+
+	if (json_path && bench_json_close(&js))
+		ret = -1;
+	(void) rpma_peer_delete(&peer);
+
+	if (ret)
+		return 1;
+	if (scaling.nonlinear) {
+		(void) fprintf(stderr,
+			"%u combination(s) scaling below %.2f of linear\n",
+			scaling.nonlinear, scaling.min);
+		return 2;
+	}
+
+	return 0;
+}
@@ -0,0 +1,66 @@
+#!/usr/bin/env bash
+# SPDX-License-Identifier: BSD-3-Clause
+# Copyright 2022, Intel Corporation
+
+#
+# run-loopback.sh - run a benchmark (rpma-bench or rpma-bench-conn) over
+#                   a loopback of a configured RDMA-capable network interface
+#                   (e.g. SoftRoCE)
+#
+# Usage: run-loopback.sh <benchmark> [IP_address] [port] [<client options>]
+#
+# The server is started in the background, the client is run with the given
+# options (see the usage of the benchmark) and the server is stopped
+# afterwards.
+# If no IP address is given, RPMA_TESTING_IP or the IP address of the first
+# active RDMA-capable network interface is used
+# (see tools/config_softroce.sh for configuring SoftRoCE).
+#
+
+BENCH=$1
+if [ "$BENCH" == "" -o ! -x "$BENCH" ]; then
+	echo "Usage: $0 <benchmark> [IP_address] [port] [<client options>]"
+	exit 1
+fi
+shift
+
+if [[ $1 =~ ^[0-9]+\.[0-9]+\.[0-9]+\.[0-9]+$ ]]; then
+	IP_ADDRESS=$1
+	shift
+fi
+
+PORT="7204"
+if [[ $1 =~ ^[0-9]+$ ]]; then
+	PORT=$1
+	shift
+fi
+
+function get_IP_of_RDMA_interface() {
+	STATE_OK="state ACTIVE physical_state LINK_UP"
+	NETDEV=$(rdma link show | grep -e "$STATE_OK" | head -n1 | cut -d' ' -f8)
+	[ "$NETDEV" == "" ] && return
+	IP_ADDRESS=$(ip address show dev $NETDEV | grep -e inet | grep -v -e inet6 | cut -d' ' -f6 | cut -d/ -f1)
+	echo $IP_ADDRESS
+}
+
+[ "$IP_ADDRESS" == "" ] && IP_ADDRESS=$RPMA_TESTING_IP
+[ "$IP_ADDRESS" == "" ] && IP_ADDRESS=$(get_IP_of_RDMA_interface)
+if [ "$IP_ADDRESS" == "" ]; then
+	echo "Error: not found any RDMA-capable network interface"
+	exit 1
+fi
+
+echo "Notice: running $(basename $BENCH) for IP address $IP_ADDRESS and port $PORT"
+
+$BENCH server $IP_ADDRESS $PORT &
+SERVER_PID=$!
+# wait for the server to start listening
+sleep 1
+
+$BENCH client $IP_ADDRESS $PORT "$@"
+RV=$?
+
+kill $SERVER_PID 2>/dev/null
+wait $SERVER_PID 2>/dev/null
+
+exit $RV
@@ -0,0 +1,566 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * hashbuild.c -- the parallel build of the hash table
+ *
+ * The table is built in parallel directly in its final place:
+ * 1. the trace is split into chunks of whole lines and every thread parses
+ *    its chunk and distributes the keys between the slices of the table
+ *    according to their home buckets,
+ * 2. every thread zeroes its slice of the table (with a non-temporal memset
+ *    in PMem), inserts the keys of its slice and persists the slice once,
+ * 3. the keys which could not be placed inside their slices (the ones near
+ *    the end of a slice) are inserted serially and the header is written.
+ *
+ * The table gets the smallest power of two of home buckets keeping the load
+ * factor under LOAD_FACTOR_MAX and it is doubled if some of the keys still
+ * do not fit.
+ */
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hashbuild.h"
+#include "hopscotch.h"
+
+/* the maximum ratio of the keys to the home buckets */
+#define LOAD_FACTOR_MAX 0.75
+
+/* a key of the trace */
+struct key_ref {
+	const char *key;	/* points into the trace */
+	uint32_t hash;
+	uint8_t len;
+};
+
+struct key_vec {
+	struct key_ref *refs;
+	size_t n;
+	size_t cap;
+};
+
+/* the state shared by all the threads */
+struct build {
+	/* the trace */
+	const char *trace;
+	size_t trace_len;
+
+	/* the table */
+	struct hash_bucket *buckets;
+	uint32_t exponent;
+	size_t nbuckets;	/* the home buckets and the tail ones */
+	hash_memset_fn memset_fn;
+	unsigned memset_flags;
+	hash_persist_fn persist;
+
+	unsigned nthreads;
+	/* keys[p][s] - the keys of the slice s found by the parser p */
+	struct key_vec keys[HASH_BUILD_THREADS_MAX][HASH_BUILD_THREADS_MAX];
+	/* the keys which did not fit into the slice s */
+	struct key_vec overflow[HASH_BUILD_THREADS_MAX];
+};
+
+struct build_thread {
+	struct build *b;
+	unsigned id;
+	pthread_t thread;
+	int ret;
+	uint64_t inserted;
+	uint64_t duplicates;
+};
+
+enum insert_result {
+	INSERT_OK,
+	INSERT_DUPLICATE,
+	INSERT_NO_SPACE,
+};
+
+/*
+ * key_vec_push -- append the key to the vector
+ */
+static int
+key_vec_push(struct key_vec *v, const struct key_ref *ref)
+{
+	if (v->n == v->cap) {
+		size_t cap = v->cap ? 2 * v->cap : 1024;
+		struct key_ref *refs = realloc(v->refs, cap * sizeof(*refs));
+		if (refs == NULL)
+			return -1;
+		v->refs = refs;
+		v->cap = cap;
+	}
+
+	v->refs[v->n++] = *ref;
+
+	return 0;
+}
+
+/*
+ * slice_first -- the first bucket of the slice
+ */
+static size_t
+slice_first(const struct build *b, unsigned s)
+{
+	/* rounded up to match slice_of() */
+	return ((1ULL << b->exponent) * s + b->nthreads - 1) / b->nthreads;
+}
+
+/*
+ * slice_end -- the bucket after the last one of the slice
+ * (the last slice includes the tail buckets)
+ */
+static size_t
+slice_end(const struct build *b, unsigned s)
+{
+	if (s == b->nthreads - 1)
+		return b->nbuckets;
+
+	return slice_first(b, s + 1);
+}
+
+/*
+ * slice_of -- the slice of the home bucket of the key
+ */
+static unsigned
+slice_of(const struct build *b, uint32_t hash)
+{
+	uint64_t home = hash & ((1ULL << b->exponent) - 1);
+
+	return (unsigned)((home * b->nthreads) >> b->exponent);
+}
+
+/*
+ * chunk_start -- the start of the chunk of the trace parsed by the thread
+ * (the chunks consist of whole lines)
+ */
+static size_t
+chunk_start(const struct build *b, unsigned t)
+{
+	if (t == 0)
+		return 0;
+	if (t == b->nthreads)
+		return b->trace_len;
+
+	size_t pos = (b->trace_len * t) / b->nthreads - 1;
+	const char *nl = memchr(b->trace + pos, '\n', b->trace_len - pos);
+
+	return nl ? (size_t)(nl - b->trace) + 1 : b->trace_len;
+}
+
+/*
+ * parse_thread -- parse the "cmd key ..." lines of the chunk and distribute
+ * the keys between the slices
+ */
+static void *
+parse_thread(void *arg)
+{
+	struct build_thread *t = arg;
+	struct build *b = t->b;
+	const char *p = b->trace + chunk_start(b, t->id);
+	const char *end = b->trace + chunk_start(b, t->id + 1);
+
+	while (p < end) {
+		const char *eol = memchr(p, '\n', (size_t)(end - p));
+		if (eol == NULL)
+			eol = end;
+
+		/* skip the command */
+		while (p < eol && *p == ' ')
+			p++;
+		while (p < eol && *p != ' ' && *p != '\r')
+			p++;
+		while (p < eol && *p == ' ')
+			p++;
+
+		/* get the key */
+		const char *key = p;
+		while (p < eol && *p != ' ' && *p != '\r')
+			p++;
+
+		size_t len = (size_t)(p - key);
+		if (len > HASH_KEY_MAX)
+			len = HASH_KEY_MAX;
+
+		if (len > 0) {
+			struct key_ref ref = {key,
+				_jenkins_hash((uint8_t *)key, len),
+				(uint8_t)len};
+			if (key_vec_push(&b->keys[t->id][slice_of(b, ref.hash)],
+					&ref)) {
+				t->ret = -1;
+				return NULL;
+			}
+		}
+
+		p = eol + 1;
+	}
+
+	return NULL;
+}
+
+/*
+ * bucket_move -- move the key and the value of the bucket src to dst
+ * (hopinfo describes the home bucket so it stays in place)
+ */
+static void
+bucket_move(struct hash_bucket *dst, struct hash_bucket *src)
+{
+	uint32_t hopinfo = dst->hopinfo;
+	*dst = *src;
+	dst->hopinfo = hopinfo;
+
+	hopinfo = src->hopinfo;
+	memset(src, 0, sizeof(*src));
+	src->hopinfo = hopinfo;
+}
+
+/*
+ * table_insert -- insert the key into the table using only the buckets
+ * from the range [first, end); the modified buckets are persisted one
+ * by one if persist is not NULL
+ */
+static enum insert_result
+table_insert(struct hash_bucket *buckets, size_t first, size_t end,
+		uint64_t mask, const struct key_ref *ref,
+		hash_persist_fn persist)
+{
+	size_t idx = ref->hash & mask;
+	uint16_t fingerprint = hash_fingerprint(ref->hash);
+	uint32_t tag = hash_tag(fingerprint, ref->len);
+	uint32_t hopinfo;
+
+	if (idx < first || idx >= end)
+		return INSERT_NO_SPACE;
+
+	/* duplicate keys are not allowed */
+	hopinfo = hash_bucket_hopinfo(&buckets[idx]);
+	for (uint32_t m = hopinfo; m; m &= m - 1) {
+		unsigned n = (unsigned)__builtin_ctz(m);
+		if (hash_tag_load(&buckets[idx], n) == tag &&
+				memcmp(buckets[idx + n].key, ref->key,
+				ref->len) == 0)
+			return INSERT_DUPLICATE;
+	}
+
+	/* linear probing to find an empty bucket */
+	size_t i = idx;
+	while (i < end && buckets[i].key_len != 0)
+		i++;
+	if (i == end)
+		return INSERT_NO_SPACE;
+
+	/* move the empty bucket into the neighbourhood of the home one */
+	while (i - idx >= HASH_HOP_NUMBER) {
+		unsigned j;
+		for (j = HASH_HOP_NUMBER - 1; j > 0; j--) {
+			size_t home = i - j;
+			if (home < first)
+				continue;
+
+			uint32_t h = hash_bucket_hopinfo(&buckets[home]);
+			if (h == 0)
+				continue;
+
+			unsigned off = (unsigned)__builtin_ctz(h);
+			if (off >= j)
+				continue;
+
+			bucket_move(&buckets[i], &buckets[home + off]);
+			h &= ~(1U << off);
+			h |= 1U << j;
+			buckets[home].hopinfo = htole32(h);
+			if (persist) {
+				persist(&buckets[i], sizeof(buckets[i]));
+				persist(&buckets[home], sizeof(buckets[home]));
+				persist(&buckets[home + off],
+					sizeof(buckets[home + off]));
+			}
+			i = home + off;
+			break;
+		}
+		if (j == 0)
+			return INSERT_NO_SPACE;
+	}
+
+	hash_bucket_fill(&buckets[i], ref->key, ref->len, ref->key, ref->len,
+			fingerprint);
+	hopinfo = hash_bucket_hopinfo(&buckets[idx]) | (1U << (i - idx));
+	buckets[idx].hopinfo = htole32(hopinfo);
+	if (persist) {
+		persist(&buckets[i], sizeof(buckets[i]));
+		persist(&buckets[idx], sizeof(buckets[idx]));
+	}
+
+	return INSERT_OK;
+}
+
+/*
+ * build_thread -- zero the slice, insert its keys and persist it
+ */
+static void *
+build_thread(void *arg)
+{
+	struct build_thread *t = arg;
+	struct build *b = t->b;
+	size_t first = slice_first(b, t->id);
+	size_t end = slice_end(b, t->id);
+	uint64_t mask = (1ULL << b->exponent) - 1;
+
+	b->memset_fn(&b->buckets[first], 0,
+			(end - first) * sizeof(struct hash_bucket),
+			b->memset_flags);
+
+	for (unsigned p = 0; p < b->nthreads; p++) {
+		struct key_vec *v = &b->keys[p][t->id];
+		for (size_t k = 0; k < v->n; k++) {
+			switch (table_insert(b->buckets, first, end, mask,
+					&v->refs[k], NULL)) {
+			case INSERT_OK:
+				t->inserted++;
+				break;
+			case INSERT_DUPLICATE:
+				t->duplicates++;
+				break;
+			case INSERT_NO_SPACE:
+				if (key_vec_push(&b->overflow[t->id],
+						&v->refs[k])) {
+					t->ret = -1;
+					return NULL;
+				}
+				break;
+			}
+		}
+	}
+
+	b->persist(&b->buckets[first],
+			(end - first) * sizeof(struct hash_bucket));
+
+	return NULL;
+}
+
+/*
+ * run_threads -- run the function in all the threads and join them
+ */
+static int
+run_threads(struct build_thread *threads, unsigned nthreads,
+		void *(*func)(void *))
+{
+	int ret = 0;
+
+	for (unsigned t = 0; t < nthreads; t++) {
+		if (pthread_create(&threads[t].thread, NULL, func,
+				&threads[t])) {
+			nthreads = t;
+			ret = -1;
+			break;
+		}
+	}
+
+	for (unsigned t = 0; t < nthreads; t++) {
+		pthread_join(threads[t].thread, NULL);
+		if (threads[t].ret)
+			ret = threads[t].ret;
+	}
+
+	return ret;
+}
+
+/*
+ * build_release -- release the keys collected by the threads
+ */
+static void
+build_release(struct build *b)
+{
+	for (unsigned p = 0; p < b->nthreads; p++) {
+		for (unsigned s = 0; s < b->nthreads; s++)
+			free(b->keys[p][s].refs);
+		free(b->overflow[p].refs);
+	}
+}
+
+/*
+ * hash_exponent -- the exponent of the smallest table keeping the load factor
+ * for nkeys keys
+ */
+static uint32_t
+hash_exponent(uint64_t nkeys)
+{
+	uint32_t exponent = 1;
+
+	while ((double)nkeys > LOAD_FACTOR_MAX * (double)(1ULL << exponent))
+		exponent++;
+
+	return exponent;
+}
+
+/*
+ * hash_build_size -- the size of the memory the table of nkeys keys may need
+ */
+size_t
+hash_build_size(uint64_t nkeys)
+{
+	return hash_table_size(hash_exponent(nkeys) + 1);
+}
+
+/*
+ * hash_build -- build the table of the keys of the trace
+ */
+int
+hash_build(const char *trace, size_t trace_len, char *addr, size_t size,
+		unsigned nthreads, hash_memset_fn memset_fn,
+		unsigned memset_flags, hash_persist_fn persist,
+		struct hash_build_stats *stats)
+{
+	struct hash_header *hdr = (struct hash_header *)addr;
+	struct build_thread *threads;
+	struct build *b;
+	int ret = -1;
+
+	if (nthreads < 1 || nthreads > HASH_BUILD_THREADS_MAX) {
+		fprintf(stderr, "threads has to be in the range [1, %d]\n",
+				HASH_BUILD_THREADS_MAX);
+		return -1;
+	}
+
+	if (size < HASH_HEADER_SIZE) {
+		fprintf(stderr, "the table does not fit into %zu bytes\n",
+				size);
+		return -1;
+	}
+
+	b = calloc(1, sizeof(*b));
+	threads = calloc(nthreads, sizeof(*threads));
+	if (b == NULL || threads == NULL)
+		goto err_free;
+
+	b->trace = trace;
+	b->trace_len = trace_len;
+	b->buckets = (struct hash_bucket *)(addr +
+			hash_bucket_offset(HASH_HEADER_SIZE, 0));
+	b->memset_fn = memset_fn;
+	b->memset_flags = memset_flags;
+	b->persist = persist;
+	b->nthreads = nthreads;
+
+	for (unsigned t = 0; t < nthreads; t++) {
+		threads[t].b = b;
+		threads[t].id = t;
+	}
+
+	/* count the lines of the trace to size the table */
+	size_t nlines = 0;
+	const char *trace_end = trace + trace_len;
+	for (const char *p = trace; p < trace_end; nlines++) {
+		const char *nl = memchr(p, '\n', (size_t)(trace_end - p));
+		p = nl ? nl + 1 : trace_end;
+	}
+
+	/* invalidate the table until all of its buckets are persistent */
+	memset_fn(hdr, 0, HASH_HEADER_SIZE, 0);
+
+	/* the smallest table keeping the load factor for all the lines */
+	b->exponent = hash_exponent(nlines);
+
+	uint64_t nkeys;
+	uint64_t duplicates;
+	uint64_t spilled;
+	uint64_t failed;
+	size_t table_size;
+
+	for (;;) {
+		b->nbuckets = (1ULL << b->exponent) + HASH_HOP_NUMBER - 1;
+		table_size = hash_table_size(b->exponent);
+		if (size < table_size) {
+			fprintf(stderr,
+				"the table needs %zu bytes but only %zu given\n",
+				table_size, size);
+			goto err_release;
+		}
+
+		for (unsigned t = 0; t < nthreads; t++) {
+			threads[t].ret = 0;
+			threads[t].inserted = 0;
+			threads[t].duplicates = 0;
+			b->overflow[t].n = 0;
+			for (unsigned s = 0; s < nthreads; s++)
+				b->keys[t][s].n = 0;
+		}
+
+		/* the keys are partitioned according to the exponent */
+		if (run_threads(threads, nthreads, parse_thread)) {
+			fprintf(stderr, "parsing the trace failed\n");
+			goto err_release;
+		}
+
+		/*
+		 * Every slice is zeroed before it is built, so the previous
+		 * content of the memory does not have to be cleaned.
+		 */
+		if (run_threads(threads, nthreads, build_thread)) {
+			fprintf(stderr, "building the table failed\n");
+			goto err_release;
+		}
+
+		nkeys = 0;
+		duplicates = 0;
+		spilled = 0;
+		failed = 0;
+		for (unsigned t = 0; t < nthreads; t++) {
+			nkeys += threads[t].inserted;
+			duplicates += threads[t].duplicates;
+		}
+
+		/* insert the keys which did not fit into their slices */
+		for (unsigned s = 0; s < nthreads; s++) {
+			struct key_vec *v = &b->overflow[s];
+			for (size_t k = 0; k < v->n; k++) {
+				switch (table_insert(b->buckets, 0, b->nbuckets,
+						(1ULL << b->exponent) - 1,
+						&v->refs[k], persist)) {
+				case INSERT_OK:
+					nkeys++;
+					spilled++;
+					break;
+				case INSERT_DUPLICATE:
+					duplicates++;
+					break;
+				case INSERT_NO_SPACE:
+					failed++;
+					break;
+				}
+			}
+		}
+
+		if (failed == 0)
+			break;
+
+		/* double the table instead of failing the inserts */
+		printf("%" PRIu64 " keys do not fit into 2^%u home buckets, doubling the table\n",
+				failed, b->exponent);
+		b->exponent++;
+	}
+
+	/* the valid header makes the table visible to the readers */
+	hash_header_init(hdr, b->exponent, nkeys);
+	persist(hdr, sizeof(*hdr));
+
+	stats->nkeys = nkeys;
+	stats->spilled = spilled;
+	stats->duplicates = duplicates;
+	stats->exponent = b->exponent;
+	stats->table_size = table_size;
+	ret = 0;
+
+err_release:
+	build_release(b);
+
+err_free:
+	free(threads);
+	free(b);
+
+	return ret;
+}
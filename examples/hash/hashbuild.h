@@ -0,0 +1,48 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * hashbuild.h -- the parallel build of the hash table (see writehash)
+ */
+
+#ifndef _HASHBUILD_H
+#define _HASHBUILD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "hashformat.h"
+
+/* the maximum number of the threads building a table */
+#define HASH_BUILD_THREADS_MAX 64
+
+/* the memset function of the memory of the table (a pmem2_memset_fn) */
+typedef void *(*hash_memset_fn)(void *dest, int c, size_t len,
+		unsigned flags);
+
+struct hash_build_stats {
+	uint64_t nkeys;		/* the keys stored in the table */
+	uint64_t spilled;	/* the keys stored across the slices */
+	uint64_t duplicates;	/* the keys found more than once */
+	uint32_t exponent;	/* the table has 2^exponent home buckets */
+	size_t table_size;
+};
+
+/*
+ * hash_build_size -- the size of the memory the table of nkeys keys may need
+ * (the smallest table keeping the load factor doubled once)
+ */
+size_t hash_build_size(uint64_t nkeys);
+
+/*
+ * hash_build -- build the table of the keys of the "<cmd> <key> ..." lines
+ * of the trace at addr (at most size bytes) with nthreads threads; the slices
+ * of the table are zeroed by memset_fn called with memset_flags and persisted
+ * by persist and the header is written and persisted last
+ */
+int hash_build(const char *trace, size_t trace_len, char *addr, size_t size,
+		unsigned nthreads, hash_memset_fn memset_fn,
+		unsigned memset_flags, hash_persist_fn persist,
+		struct hash_build_stats *stats);
+
+#endif /* _HASHBUILD_H */
@@ -0,0 +1,313 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * hashcache.c -- the client-side cache of the hot segments of the hash table
+ *
+ * The cache keeps the whole segments (see hashformat.h) read by the lookups
+ * together with the version of their home buckets they were read with.
+ * The version of a home bucket changes whenever any of its keys is modified,
+ * so a cached segment is still valid as long as the version of its home
+ * bucket is the same (see hashlookup.c).
+ *
+ * The cache is split into HASH_CACHE_SHARDS shards selected by the hash
+ * of the home bucket, every one of them with its own lock, a fixed number
+ * of entries, a linear-probing index and a CLOCK hand: a hit sets
+ * the referenced bit of the entry and the hand evicts the first entry
+ * without the bit set, clearing the bits it passes, so the entries used
+ * since the last pass of the hand survive.
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hashcache.h"
+#include "hashformat.h"
+
+#define CACHE_EMPTY UINT32_MAX
+
+struct cache_entry {
+	uint64_t key;		/* the server and the home bucket */
+	uint64_t version;	/* of the home bucket */
+	uint8_t used;
+	uint8_t referenced;	/* hit since the last pass of the hand */
+};
+
+struct cache_shard {
+	pthread_mutex_t lock;
+	struct cache_entry *entries;
+	char *segs;		/* the segment of every entry */
+	uint32_t *index;	/* the entries by their keys */
+	uint32_t index_mask;
+	uint32_t capacity;
+	uint32_t nused;
+	uint32_t hand;
+	struct hash_cache_stats stats;
+} __attribute__((aligned(64)));
+
+struct hash_cache {
+	struct cache_shard shards[HASH_CACHE_SHARDS];
+};
+
+/*
+ * cache_mix -- spread the bits of the key (the finalizer of MurmurHash3)
+ */
+static uint64_t
+cache_mix(uint64_t h)
+{
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 33;
+
+	return h;
+}
+
+/*
+ * cache_key -- the key of the home bucket of the table of the server ns
+ * (the buckets of a memory region smaller than 16 PiB fit in 48 bits)
+ */
+static uint64_t
+cache_key(uint32_t ns, uint64_t home)
+{
+	return ((uint64_t)ns << 48) | home;
+}
+
+/*
+ * cache_shard_of -- the shard of the key
+ */
+static struct cache_shard *
+cache_shard_of(struct hash_cache *cache, uint64_t key)
+{
+	return &cache->shards[cache_mix(key) % HASH_CACHE_SHARDS];
+}
+
+/*
+ * cache_find -- find the position of the key in the index of the shard
+ * or the empty position it would be inserted at
+ */
+static uint32_t
+cache_find(const struct cache_shard *sh, uint64_t key)
+{
+	/* the low bits select the shard, so the index uses the high ones */
+	uint32_t i = (uint32_t)(cache_mix(key) >> 32) & sh->index_mask;
+
+	while (sh->index[i] != CACHE_EMPTY &&
+			sh->entries[sh->index[i]].key != key)
+		i = (i + 1) & sh->index_mask;
+
+	return i;
+}
+
+/*
+ * cache_unindex -- remove the position from the index shifting back
+ * the following entries of the probe sequence
+ */
+static void
+cache_unindex(struct cache_shard *sh, uint32_t i)
+{
+	uint32_t j = i;
+
+	sh->index[i] = CACHE_EMPTY;
+	for (;;) {
+		j = (j + 1) & sh->index_mask;
+		if (sh->index[j] == CACHE_EMPTY)
+			return;
+
+		uint32_t k = (uint32_t)(cache_mix(
+				sh->entries[sh->index[j]].key) >> 32) &
+				sh->index_mask;
+
+		/* the entry can stay if its home position is in (i, j] */
+		if (i <= j ? (i < k && k <= j) : (i < k || k <= j))
+			continue;
+
+		sh->index[i] = sh->index[j];
+		sh->index[j] = CACHE_EMPTY;
+		i = j;
+	}
+}
+
+/*
+ * cache_victim -- get a free entry of the shard evicting one if needed
+ */
+static uint32_t
+cache_victim(struct cache_shard *sh)
+{
+	if (sh->nused < sh->capacity)
+		return sh->nused++;
+
+	for (;;) {
+		uint32_t e = sh->hand;
+		struct cache_entry *entry = &sh->entries[e];
+
+		sh->hand = (sh->hand + 1) % sh->capacity;
+		if (entry->referenced) {
+			entry->referenced = 0;
+			continue;
+		}
+
+		cache_unindex(sh, cache_find(sh, entry->key));
+		entry->used = 0;
+		sh->stats.evictions++;
+
+		return e;
+	}
+}
+
+/*
+ * hash_cache_new -- create a cache of the segments taking at most size bytes
+ */
+struct hash_cache *
+hash_cache_new(size_t size)
+{
+	/* the segment, the entry and up to 4 positions of the index */
+	size_t per_entry = HASH_SEGMENT_SIZE + sizeof(struct cache_entry) +
+			4 * sizeof(uint32_t);
+	size_t capacity = (size - sizeof(struct hash_cache)) /
+			HASH_CACHE_SHARDS / per_entry;
+
+	if (size <= sizeof(struct hash_cache) || capacity == 0 ||
+			capacity >= CACHE_EMPTY / 4)
+		return NULL;
+
+	struct hash_cache *cache;
+	if (posix_memalign((void **)&cache, 64, sizeof(*cache)))
+		return NULL;
+	memset(cache, 0, sizeof(*cache));
+
+	/* the index is kept at most half full */
+	uint32_t index_size = 1;
+	while (index_size < 2 * capacity)
+		index_size <<= 1;
+
+	for (int s = 0; s < HASH_CACHE_SHARDS; s++) {
+		struct cache_shard *sh = &cache->shards[s];
+
+		sh->capacity = (uint32_t)capacity;
+		sh->index_mask = index_size - 1;
+		sh->entries = calloc(capacity, sizeof(*sh->entries));
+		sh->segs = malloc(capacity * HASH_SEGMENT_SIZE);
+		sh->index = malloc(index_size * sizeof(*sh->index));
+		if (sh->entries == NULL || sh->segs == NULL ||
+				sh->index == NULL ||
+				pthread_mutex_init(&sh->lock, NULL)) {
+			free(sh->entries);
+			free(sh->segs);
+			free(sh->index);
+			sh->entries = NULL;
+			hash_cache_delete(&cache);
+			return NULL;
+		}
+		memset(sh->index, 0xff, index_size * sizeof(*sh->index));
+	}
+
+	return cache;
+}
+
+/*
+ * hash_cache_delete -- delete the cache
+ */
+void
+hash_cache_delete(struct hash_cache **cache_ptr)
+{
+	struct hash_cache *cache = *cache_ptr;
+	if (cache == NULL)
+		return;
+
+	for (int s = 0; s < HASH_CACHE_SHARDS; s++) {
+		struct cache_shard *sh = &cache->shards[s];
+		if (sh->entries == NULL)
+			break;
+
+		(void) pthread_mutex_destroy(&sh->lock);
+		free(sh->entries);
+		free(sh->segs);
+		free(sh->index);
+	}
+
+	free(cache);
+	*cache_ptr = NULL;
+}
+
+/*
+ * hash_cache_get -- copy the cached segment of the home bucket
+ */
+int
+hash_cache_get(struct hash_cache *cache, uint32_t ns, uint64_t home,
+		void *seg, uint64_t *version)
+{
+	uint64_t key = cache_key(ns, home);
+	struct cache_shard *sh = cache_shard_of(cache, key);
+	int ret = -1;
+
+	pthread_mutex_lock(&sh->lock);
+
+	uint32_t i = cache_find(sh, key);
+	if (sh->index[i] != CACHE_EMPTY) {
+		struct cache_entry *entry = &sh->entries[sh->index[i]];
+
+		entry->referenced = 1;
+		*version = entry->version;
+		memcpy(seg, sh->segs + (size_t)sh->index[i] * HASH_SEGMENT_SIZE,
+				HASH_SEGMENT_SIZE);
+		ret = 0;
+	}
+
+	pthread_mutex_unlock(&sh->lock);
+
+	return ret;
+}
+
+/*
+ * hash_cache_put -- cache the segment of the home bucket
+ */
+void
+hash_cache_put(struct hash_cache *cache, uint32_t ns, uint64_t home,
+		const void *seg, uint64_t version)
+{
+	uint64_t key = cache_key(ns, home);
+	struct cache_shard *sh = cache_shard_of(cache, key);
+
+	pthread_mutex_lock(&sh->lock);
+
+	uint32_t i = cache_find(sh, key);
+	uint32_t e = sh->index[i];
+	if (e == CACHE_EMPTY) {
+		e = cache_victim(sh);
+		/* the eviction could have shifted the index */
+		i = cache_find(sh, key);
+		sh->index[i] = e;
+		sh->entries[e].key = key;
+		sh->entries[e].used = 1;
+		/* a new entry has to be hit before the hand comes back */
+		sh->entries[e].referenced = 0;
+		sh->stats.inserts++;
+	}
+
+	sh->entries[e].version = version;
+	memcpy(sh->segs + (size_t)e * HASH_SEGMENT_SIZE, seg,
+			HASH_SEGMENT_SIZE);
+
+	pthread_mutex_unlock(&sh->lock);
+}
+
+/*
+ * hash_cache_get_stats -- sum up the statistics of the shards
+ */
+void
+hash_cache_get_stats(struct hash_cache *cache, struct hash_cache_stats *stats)
+{
+	memset(stats, 0, sizeof(*stats));
+
+	for (int s = 0; s < HASH_CACHE_SHARDS; s++) {
+		struct cache_shard *sh = &cache->shards[s];
+
+		pthread_mutex_lock(&sh->lock);
+		stats->inserts += sh->stats.inserts;
+		stats->evictions += sh->stats.evictions;
+		pthread_mutex_unlock(&sh->lock);
+	}
+}
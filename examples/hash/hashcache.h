@@ -0,0 +1,60 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * hashcache.h -- the client-side cache of the hot segments of the hash table
+ */
+
+#ifndef _HASHCACHE_H
+#define _HASHCACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* the cache is split into independently locked shards */
+#define HASH_CACHE_SHARDS 16
+
+struct hash_cache;
+
+struct hash_cache_stats {
+	uint64_t inserts;
+	uint64_t evictions;
+};
+
+/*
+ * hash_cache_new -- create a cache of the segments taking at most size bytes
+ * (the segments, their metadata and the index); returns NULL if size is too
+ * small to keep a single segment per shard or on allocation failure
+ */
+struct hash_cache *hash_cache_new(size_t size);
+
+/*
+ * hash_cache_delete -- delete the cache
+ */
+void hash_cache_delete(struct hash_cache **cache_ptr);
+
+/*
+ * hash_cache_get -- copy the cached segment of the home bucket (home is
+ * the offset of the home bucket in the memory region of the server ns
+ * divided by the bucket size, so the home buckets of all the arrays
+ * of a growing table are told apart) to seg and get the version of the home
+ * bucket it was read with; returns 0 on a hit
+ * and -1 on a miss
+ */
+int hash_cache_get(struct hash_cache *cache, uint32_t ns, uint64_t home,
+		void *seg, uint64_t *version);
+
+/*
+ * hash_cache_put -- cache the segment of the home bucket read with
+ * the given version of the home bucket (replacing the older copy if any)
+ */
+void hash_cache_put(struct hash_cache *cache, uint32_t ns, uint64_t home,
+		const void *seg, uint64_t version);
+
+/*
+ * hash_cache_get_stats -- sum up the statistics of the shards
+ */
+void hash_cache_get_stats(struct hash_cache *cache,
+		struct hash_cache_stats *stats);
+
+#endif /* _HASHCACHE_H */
@@ -0,0 +1,488 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * hashformat.h -- the binary layout of the hopscotch hash table in PMem
+ *
+ * The table starts with a header block followed by the array of 2^exponent
+ * buckets and HASH_HOP_NUMBER - 1 tail buckets, so the neighbourhood of every
+ * home bucket can be read at once. The header holds the offset of the array,
+ * which is not the one right after the header once the table has grown.
+ * Every bucket takes exactly one 64-byte cache line and all the integers
+ * are stored little-endian.
+ *
+ * The fingerprint and the length of the key of a bucket are stored next to
+ * each other, so they are read and compared as a single 32-bit tag. A probe
+ * compares the tags of all the buckets of a segment at once (with AVX2
+ * if the CPU supports it and SSE2 otherwise) and only the candidates it
+ * returns have their keys compared.
+ *
+ * Every bucket carries a version word. A writer (see hashupdate.c) makes
+ * the version of a bucket odd while it modifies the bucket and bumps it to
+ * the next even value afterwards. Every modification of the neighbourhood
+ * of a home bucket is additionally enclosed in such a bump of the version of
+ * the home bucket, so the version of a home bucket is the version of its
+ * whole segment. A one-sided reader retries when it sees an odd version and
+ * validates a miss by re-reading the version of the home bucket. A bucket
+ * is one cache line, so it is read by RDMA as a whole.
+ *
+ * A table served with updates grows online (see hashupdate.c): the header
+ * gets the offset of the next array of 2^(exponent + 1) home buckets and
+ * the keys of every home bucket of the current array are moved to the next
+ * one, after which the version of the old home bucket gets HASH_VERSION_MOVED
+ * set for good. A reader of such a home bucket looks the key up in the next
+ * array and re-reads the header if it does not know the next array yet.
+ * Once all the home buckets are moved, the header makes the next array
+ * the current one. The header is written twice (a backup copy first), so
+ * a torn header is restored from the other copy when the table is opened
+ * and a reader which gets a header not matching its checksum reads it again.
+ */
+
+#ifndef _HASHFORMAT_H
+#define _HASHFORMAT_H
+
+#include <endian.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#define HASH_MAGIC		"RPMAHASH"
+#define HASH_MAGIC_LEN		8
+#define HASH_FORMAT_VERSION	3
+
+/* the buckets of a new table start right after the header block */
+#define HASH_HEADER_SIZE	4096
+
+/* the copy of the header written before the header itself is modified */
+#define HASH_HEADER_BACKUP_OFFSET	256
+
+/*
+ * the rest of the header block after the header is the metadata area
+ * the server publishes to the clients (the shard map, see shardmap.h)
+ */
+#define HASH_META_OFFSET	512
+#define HASH_META_SIZE		(HASH_HEADER_SIZE - HASH_META_OFFSET)
+
+#define HASH_BUCKET_SIZE	64
+#define HASH_HOP_NUMBER		32
+#define HASH_KEY_MAX		24
+#define HASH_VAL_MAX		24
+
+/* the neighbourhood of a home bucket */
+#define HASH_SEGMENT_SIZE	(HASH_HOP_NUMBER * HASH_BUCKET_SIZE)
+
+/* the tag of a bucket: the fingerprint and the length of its key */
+#define HASH_TAG_OFFSET		4
+#define HASH_TAG_MASK		0x00FFFFFFU
+
+/* the offset of the version word in a bucket */
+#define HASH_VERSION_OFFSET	8
+
+/* the keys of the home bucket were moved to the next array of the table */
+#define HASH_VERSION_MOVED	(1ULL << 63)
+
+/* the exponents of the table have to fit in 48 bits */
+#define HASH_EXPONENT_MAX	47
+
+/* the table is updated while it is served (see hash_header.flags) */
+#define HASH_F_UPDATES		(1U << 0)
+
+struct hash_header {
+	char magic[HASH_MAGIC_LEN];
+	uint32_t version;
+	uint32_t bucket_size;
+	uint32_t hop_number;
+	uint32_t exponent;	/* the table has 2^exponent home buckets */
+	uint32_t flags;		/* HASH_F_* */
+	uint64_t nkeys;		/* the keys stored when the table was built */
+	uint64_t buckets;	/* the offset of the array of the buckets */
+	uint64_t next;		/* the offset of the next array or 0 */
+	uint64_t checksum;	/* of the header with this field zeroed */
+};
+
+struct hash_bucket {
+	uint32_t hopinfo;	/* the keys of this home bucket (bit n - n-th) */
+	uint16_t fingerprint;	/* of the key stored in this bucket */
+	uint8_t key_len;	/* 0 if the bucket is empty */
+	uint8_t val_len;
+	uint64_t version;	/* odd while the bucket is modified */
+	char key[HASH_KEY_MAX];
+	char val[HASH_VAL_MAX];
+} __attribute__((aligned(HASH_BUCKET_SIZE)));
+
+_Static_assert(sizeof(struct hash_bucket) == HASH_BUCKET_SIZE,
+		"a bucket has to take exactly one cache line");
+_Static_assert(offsetof(struct hash_bucket, fingerprint) == HASH_TAG_OFFSET &&
+		offsetof(struct hash_bucket, key_len) == HASH_TAG_OFFSET + 2,
+		"the fingerprint and the key length make up the tag");
+_Static_assert(offsetof(struct hash_bucket, version) == HASH_VERSION_OFFSET,
+		"the version word can be read on its own");
+_Static_assert(HASH_HEADER_BACKUP_OFFSET + sizeof(struct hash_header) <=
+		HASH_META_OFFSET,
+		"the header and its copy have to fit in front of the metadata");
+
+/* the function persisting the modified range of the table */
+typedef void (*hash_persist_fn)(const void *ptr, size_t size);
+
+/*
+ * hash_buckets_size -- the size of the array of 2^exponent home buckets
+ * and the tail ones
+ */
+static inline size_t
+hash_buckets_size(uint32_t exponent)
+{
+	return ((1ULL << exponent) + HASH_HOP_NUMBER - 1) * HASH_BUCKET_SIZE;
+}
+
+/*
+ * hash_table_size -- the size of a new table of 2^exponent home buckets
+ */
+static inline size_t
+hash_table_size(uint32_t exponent)
+{
+	return HASH_HEADER_SIZE + hash_buckets_size(exponent);
+}
+
+/*
+ * hash_bucket_offset -- the offset from the table start of the bucket
+ * of the array starting at the given offset
+ */
+static inline size_t
+hash_bucket_offset(uint64_t buckets, uint64_t idx)
+{
+	return buckets + idx * HASH_BUCKET_SIZE;
+}
+
+/*
+ * hash_fingerprint -- the fingerprint of a key of the given hash; it uses
+ * other bits than the ones selecting the home bucket
+ */
+static inline uint16_t
+hash_fingerprint(uint32_t h)
+{
+	return (uint16_t)((h * 0x9E3779B1U) >> 16);
+}
+
+/*
+ * hash_header_checksum -- FNV-1a of the header with the checksum zeroed
+ */
+static inline uint64_t
+hash_header_checksum(const struct hash_header *hdr)
+{
+	struct hash_header tmp = *hdr;
+	tmp.checksum = 0;
+
+	const unsigned char *p = (const unsigned char *)&tmp;
+	uint64_t sum = 0xcbf29ce484222325ULL;
+	for (size_t i = 0; i < sizeof(tmp); i++) {
+		sum ^= p[i];
+		sum *= 0x100000001b3ULL;
+	}
+
+	return sum;
+}
+
+/*
+ * hash_header_init -- fill the header of a table of 2^exponent home buckets
+ */
+static inline void
+hash_header_init(struct hash_header *hdr, uint32_t exponent, uint64_t nkeys)
+{
+	memset(hdr, 0, sizeof(*hdr));
+	memcpy(hdr->magic, HASH_MAGIC, HASH_MAGIC_LEN);
+	hdr->version = htole32(HASH_FORMAT_VERSION);
+	hdr->bucket_size = htole32(HASH_BUCKET_SIZE);
+	hdr->hop_number = htole32(HASH_HOP_NUMBER);
+	hdr->exponent = htole32(exponent);
+	hdr->nkeys = htole64(nkeys);
+	hdr->buckets = htole64(HASH_HEADER_SIZE);
+	hdr->checksum = htole64(hash_header_checksum(hdr));
+}
+
+/*
+ * hash_header_check -- validate the header and get the exponent of
+ * the table; returns 0 if the table can be used and -1 otherwise
+ */
+static inline int
+hash_header_check(const struct hash_header *hdr, uint32_t *exponent)
+{
+	uint32_t exp = le32toh(hdr->exponent);
+	uint64_t buckets = le64toh(hdr->buckets);
+	uint64_t next = le64toh(hdr->next);
+
+	if (memcmp(hdr->magic, HASH_MAGIC, HASH_MAGIC_LEN) != 0 ||
+			le32toh(hdr->version) != HASH_FORMAT_VERSION ||
+			le32toh(hdr->bucket_size) != HASH_BUCKET_SIZE ||
+			le32toh(hdr->hop_number) != HASH_HOP_NUMBER ||
+			exp > HASH_EXPONENT_MAX ||
+			le64toh(hdr->checksum) != hash_header_checksum(hdr))
+		return -1;
+
+	/* the arrays follow the header block and the next one follows both */
+	if (buckets < HASH_HEADER_SIZE || buckets % HASH_BUCKET_SIZE ||
+			buckets > (1ULL << 56))
+		return -1;
+	if (next != 0 && (exp == HASH_EXPONENT_MAX ||
+			next % HASH_BUCKET_SIZE ||
+			next < buckets + hash_buckets_size(exp) ||
+			next > (1ULL << 56)))
+		return -1;
+
+	*exponent = exp;
+
+	return 0;
+}
+
+/*
+ * hash_header_buckets -- get the offset of the array of a valid header
+ */
+static inline uint64_t
+hash_header_buckets(const struct hash_header *hdr)
+{
+	return le64toh(hdr->buckets);
+}
+
+/*
+ * hash_header_next -- get the offset of the array of 2^(exponent + 1)
+ * home buckets the table of a valid header is grown into or 0
+ */
+static inline uint64_t
+hash_header_next(const struct hash_header *hdr)
+{
+	return le64toh(hdr->next);
+}
+
+/*
+ * hash_header_end -- the size a table of a valid header needs
+ */
+static inline size_t
+hash_header_end(const struct hash_header *hdr)
+{
+	uint32_t exponent = le32toh(hdr->exponent);
+	uint64_t next = le64toh(hdr->next);
+
+	if (next != 0)
+		return next + hash_buckets_size(exponent + 1);
+
+	return le64toh(hdr->buckets) + hash_buckets_size(exponent);
+}
+
+/*
+ * hash_header_set_layout -- replace the exponent and the offsets
+ * of the arrays of a valid header
+ */
+static inline void
+hash_header_set_layout(struct hash_header *hdr, uint32_t exponent,
+		uint64_t buckets, uint64_t next)
+{
+	hdr->exponent = htole32(exponent);
+	hdr->buckets = htole64(buckets);
+	hdr->next = htole64(next);
+	hdr->checksum = htole64(hash_header_checksum(hdr));
+}
+
+/*
+ * hash_bucket_fill -- store the key and the value in the bucket
+ * (they are truncated to HASH_KEY_MAX and HASH_VAL_MAX bytes)
+ */
+static inline void
+hash_bucket_fill(struct hash_bucket *b, const char *key, size_t key_len,
+		const char *val, size_t val_len, uint16_t fingerprint)
+{
+	if (key_len > HASH_KEY_MAX)
+		key_len = HASH_KEY_MAX;
+	if (val_len > HASH_VAL_MAX)
+		val_len = HASH_VAL_MAX;
+
+	memset(b->key, 0, sizeof(b->key));
+	memset(b->val, 0, sizeof(b->val));
+	memcpy(b->key, key, key_len);
+	memcpy(b->val, val, val_len);
+	b->key_len = (uint8_t)key_len;
+	b->val_len = (uint8_t)val_len;
+	b->fingerprint = htole16(fingerprint);
+}
+
+/*
+ * hash_header_flags -- get the flags of a valid header
+ */
+static inline uint32_t
+hash_header_flags(const struct hash_header *hdr)
+{
+	return le32toh(hdr->flags);
+}
+
+/*
+ * hash_header_set_flags -- replace the flags of a valid header
+ */
+static inline void
+hash_header_set_flags(struct hash_header *hdr, uint32_t flags)
+{
+	hdr->flags = htole32(flags);
+	hdr->checksum = htole64(hash_header_checksum(hdr));
+}
+
+/*
+ * hash_bucket_version -- get the version of the bucket
+ */
+static inline uint64_t
+hash_bucket_version(const struct hash_bucket *b)
+{
+	return le64toh(__atomic_load_n(&b->version, __ATOMIC_ACQUIRE));
+}
+
+/*
+ * hash_bucket_hopinfo -- get hopinfo of the home bucket
+ */
+static inline uint32_t
+hash_bucket_hopinfo(const struct hash_bucket *b)
+{
+	return le32toh(b->hopinfo);
+}
+
+/*
+ * hash_tag -- the tag of the buckets holding a key of the given fingerprint
+ * and length
+ */
+static inline uint32_t
+hash_tag(uint16_t fingerprint, size_t key_len)
+{
+	return (uint32_t)fingerprint | ((uint32_t)key_len << 16);
+}
+
+/*
+ * hash_tag_load -- read the tag of the n-th bucket of the segment
+ */
+static inline uint32_t
+hash_tag_load(const struct hash_bucket *seg, unsigned n)
+{
+	uint32_t tag;
+	memcpy(&tag, (const char *)&seg[n] + HASH_TAG_OFFSET, sizeof(tag));
+
+	return le32toh(tag) & HASH_TAG_MASK;
+}
+
+#if defined(__x86_64__)
+/*
+ * hash_probe_avx2 -- gather and compare the tags of 8 buckets at a time
+ */
+__attribute__((target("avx2")))
+static inline uint32_t
+hash_probe_avx2(const struct hash_bucket *seg, uint32_t tag)
+{
+	const __m256i vtag = _mm256_set1_epi32((int)tag);
+	const __m256i vmask = _mm256_set1_epi32((int)HASH_TAG_MASK);
+	const __m256i vidx = _mm256_setr_epi32(0, 1 * HASH_BUCKET_SIZE,
+			2 * HASH_BUCKET_SIZE, 3 * HASH_BUCKET_SIZE,
+			4 * HASH_BUCKET_SIZE, 5 * HASH_BUCKET_SIZE,
+			6 * HASH_BUCKET_SIZE, 7 * HASH_BUCKET_SIZE);
+	const char *base = (const char *)seg + HASH_TAG_OFFSET;
+	uint32_t mask = 0;
+
+	for (unsigned i = 0; i < HASH_HOP_NUMBER; i += 8) {
+		__m256i t = _mm256_i32gather_epi32(
+				(const int *)(base + i * HASH_BUCKET_SIZE),
+				vidx, 1);
+		__m256i eq = _mm256_cmpeq_epi32(_mm256_and_si256(t, vmask),
+				vtag);
+		mask |= (uint32_t)_mm256_movemask_ps(
+				_mm256_castsi256_ps(eq)) << i;
+	}
+
+	return mask;
+}
+
+/*
+ * hash_probe_sse2 -- compare the tags of 4 buckets at a time
+ */
+static inline uint32_t
+hash_probe_sse2(const struct hash_bucket *seg, uint32_t tag)
+{
+	const __m128i vtag = _mm_set1_epi32((int)tag);
+	uint32_t mask = 0;
+
+	for (unsigned i = 0; i < HASH_HOP_NUMBER; i += 4) {
+		__m128i t = _mm_setr_epi32((int)hash_tag_load(seg, i),
+				(int)hash_tag_load(seg, i + 1),
+				(int)hash_tag_load(seg, i + 2),
+				(int)hash_tag_load(seg, i + 3));
+		__m128i eq = _mm_cmpeq_epi32(t, vtag);
+		mask |= (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(eq)) << i;
+	}
+
+	return mask;
+}
+#else
+/*
+ * hash_probe_scalar -- compare the tags of the buckets one by one
+ */
+static inline uint32_t
+hash_probe_scalar(const struct hash_bucket *seg, uint32_t tag)
+{
+	uint32_t mask = 0;
+
+	for (unsigned i = 0; i < HASH_HOP_NUMBER; i++) {
+		if (hash_tag_load(seg, i) == tag)
+			mask |= 1U << i;
+	}
+
+	return mask;
+}
+#endif
+
+/*
+ * hash_segment_probe -- get the mask of the buckets of the segment which
+ * are pointed by hopinfo and have the fingerprint and the length of the key;
+ * only the buckets pointed by hopinfo have to be valid
+ */
+static inline uint32_t
+hash_segment_probe(const struct hash_bucket *seg, uint32_t hopinfo,
+		uint16_t fingerprint, size_t key_len)
+{
+	uint32_t tag = hash_tag(fingerprint, key_len);
+
+#if defined(__x86_64__)
+	if (__builtin_cpu_supports("avx2"))
+		return hash_probe_avx2(seg, tag) & hopinfo;
+
+	return hash_probe_sse2(seg, tag) & hopinfo;
+#else
+	return hash_probe_scalar(seg, tag) & hopinfo;
+#endif
+}
+
+/*
+ * hash_segment_find -- find the bucket holding the key among the buckets
+ * of the segment pointed by hopinfo; returns its index or -1
+ */
+static inline int
+hash_segment_find(const struct hash_bucket *seg, uint32_t hopinfo,
+		const char *key, size_t key_len, uint16_t fingerprint)
+{
+	uint32_t candidates = hash_segment_probe(seg, hopinfo, fingerprint,
+			key_len);
+
+	while (candidates) {
+		int i = __builtin_ctz(candidates);
+		if (memcmp(seg[i].key, key, key_len) == 0)
+			return i;
+		candidates &= candidates - 1;
+	}
+
+	return -1;
+}
+
+/*
+ * hash_key_len -- the length of a key as stored in the table
+ */
+static inline size_t
+hash_key_len(const char *key)
+{
+	return strnlen(key, HASH_KEY_MAX);
+}
+
+#endif /* _HASHFORMAT_H */
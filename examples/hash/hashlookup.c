@@ -0,0 +1,1251 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * hashlookup.c -- the pipelined lookup engine of the hash example clients
+ *
+ * The engine keeps up to queue_depth lookups in flight. Every lookup reads
+ * the buckets of its key into its own slot of a registered ring of segments
+ * and the wr_id of its reads carries the index of the slot. Completions
+ * are polled in batches and the keys are checked in the order their reads
+ * complete, after which the slot is refilled with the next key.
+ *
+ * A lookup reads either the whole segment of the key (SEGMENT mode) or
+ * the home bucket first and then only the buckets pointed by its hopinfo
+ * (TWO_PHASE mode). The buckets of the second phase are read by up to
+ * LOOKUP_GATHER_MAX reads of the runs of the adjacent buckets and only
+ * the last of them generates a completion - the reads of one connection
+ * complete in order. In the ADAPTIVE mode the cheaper of the two is picked
+ * per key using the round-trip time measured on the home bucket reads and
+ * the bandwidth measured on the segment reads.
+ *
+ * The header of the table (see hashformat.h) is read and validated when
+ * the engine is created and the number of the home buckets and the offset
+ * of their array are taken from it.
+ *
+ * A table served with updates can grow (see hashupdate.c). A lookup which
+ * reads a home bucket marked as moved continues in the next array if
+ * the engine knows it and otherwise reads the header again (into its own
+ * area behind the ring of the segments, not blocking the lookups in flight)
+ * and restarts once the new header has been read. While the table grows,
+ * every LOOKUP_HEADER_PERIOD-th lookup continued in the next array reads
+ * the header again too, so the engine finds out when the growth is done.
+ *
+ * If the table is updated while it is served (HASH_F_UPDATES), a lookup
+ * is restarted whenever it reads an odd version of the home bucket or
+ * of the bucket holding the key and a miss is confirmed only after one more
+ * read of the version of the home bucket returns the version read first.
+ *
+ * An engine with a cache (see hashcache.h) reads the whole segments
+ * and keeps the segments of the finished lookups in the cache together with
+ * the version of their home buckets. The next lookup of the same home bucket
+ * takes the segment from the cache and, if the table is updated, reads only
+ * the version of the home bucket: every modification of the keys of the home
+ * bucket changes its version, so the cached segment is used only if
+ * the version is still the same and the segment is read again otherwise.
+ *
+ * A multi-get (lookup_engine_mget()) sorts its keys by their home buckets
+ * and reads the keys of the overlapping segments with a single read
+ * of the range of the buckets covering all of them, so the keys sharing
+ * a segment are read once. The reads of as many ranges as fit into the ring
+ * of the segments are posted back to back and only the last of them
+ * generates a completion. The keys which cannot be answered from the ranges
+ * (a bucket being modified or a miss to be confirmed in an updated table)
+ * are finished by the pipelined lookups afterwards.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "common-conn.h"
+#include "hashcache.h"
+#include "hashlookup.h"
+#include "hopscotch.h"
+
+/* the maximum number of completions collected at once */
+#define LOOKUP_WC_BATCH 16
+
+/* every n-th key of the ADAPTIVE mode uses the mode which was not picked */
+#define LOOKUP_EXPLORE_PERIOD 32
+
+/* the weight of a new sample of the moving averages */
+#define LOOKUP_EWMA_ALPHA 0.0625
+
+/* every n-th lookup continued in the next array re-reads the header */
+#define LOOKUP_HEADER_PERIOD 1024
+
+enum lookup_phase {
+	PHASE_SEGMENT,	/* reading the whole segment */
+	PHASE_HOME,	/* reading the home bucket */
+	PHASE_GATHER,	/* reading the buckets pointed by hopinfo */
+	PHASE_VALIDATE,	/* re-reading the version of the home bucket */
+	PHASE_CACHED,	/* reading the version of the cached home bucket */
+};
+
+/* a range of the buckets read by one read of a multi-get */
+struct lookup_range {
+	uint64_t first;		/* the first home bucket of the range */
+	uint64_t last;		/* the last home bucket of the range */
+	size_t offset;		/* the offset of the range in the ring */
+	size_t begin;		/* the first key of the range */
+	size_t end;		/* the key following the last one of the range */
+};
+
+/* an array of the buckets of the table */
+struct lookup_layout {
+	size_t buckets;		/* the offset of the array in src_mr */
+	uint64_t mask;		/* 2^exponent - 1 */
+};
+
+struct lookup_slot {
+	size_t key;		/* the index of the key read into the slot */
+	size_t key_len;
+	size_t home;		/* the offset of the home bucket of the key */
+	uint64_t home_index;	/* the index of the home bucket of the key */
+	int level;		/* the array of the home bucket */
+	uint64_t generation;	/* of the arrays the level refers to */
+	uint16_t fingerprint;	/* of the key */
+	enum lookup_phase phase;
+	uint32_t hopinfo;	/* hopinfo of the home bucket */
+	uint64_t version;	/* of the home bucket */
+	int cacheable;		/* the slot holds the whole segment */
+	uint64_t posted_ns;	/* when the current phase was posted */
+	uint64_t started_ns;	/* when the lookup was started */
+};
+
+struct lookup_engine {
+	struct rpma_conn *conn;
+	struct rpma_cq *cq;
+	struct rpma_mr_remote *src_mr;
+	size_t table_offset;	/* the offset of the table in src_mr */
+	int versioned;		/* the table is updated while it is served */
+
+	/* the current array and the one the table grows into */
+	struct lookup_layout layouts[2];
+	int nlayouts;
+	uint64_t generation;	/* bumped whenever the arrays change */
+	int header_posted;	/* the header is being read again */
+	uint64_t moved;		/* the lookups moved to the next array */
+	enum lookup_mode mode;
+
+	/* the optional cache of the segments (shared by the engines) */
+	struct hash_cache *cache;
+	uint32_t cache_ns;	/* the namespace of the table in the cache */
+
+	/* the optional sink of the latencies of the lookups */
+	lookup_lat_fn lat_fn;
+	void *lat_arg;
+
+	/* the ring of the segments - one slot per lookup in flight */
+	char *dst_ptr;
+	struct rpma_mr_local *dst_mr;
+
+	int queue_depth;
+	struct lookup_slot *slots;
+	int *free_slots;	/* the stack of the free slots */
+	int nfree;
+
+	/* the multi-get in progress (see lookup_engine_mget_post()) */
+	struct lookup_result *results;	/* the results of the keys or NULL */
+	char *const *mget_keys;
+	struct lookup_slot *mget_slots;	/* the keys sorted by home buckets */
+	size_t mget_capacity;
+	size_t mget_nkeys;
+	size_t mget_next;	/* the first key of the next batch */
+	size_t mget_npending;	/* the keys left to the pipelined lookups */
+	struct lookup_range *ranges;	/* the ranges of the posted batch */
+	int nranges;
+
+	/* the measurements of the ADAPTIVE mode */
+	double rtt_ns;		/* latency of a single bucket read */
+	double ns_per_byte;	/* transfer time of a byte */
+	double gather_ratio;	/* lookups which need the second phase */
+	double gather_bytes;	/* bytes read by the second phase */
+	uint64_t decisions;
+};
+
+/*
+ * lookup_now_ns -- get the monotonic time in nanoseconds
+ */
+static uint64_t
+lookup_now_ns(void)
+{
+	struct timespec ts;
+	(void) clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/*
+ * lookup_ewma -- update the moving average with a new sample
+ */
+static void
+lookup_ewma(double *avg, double sample)
+{
+	*avg += LOOKUP_EWMA_ALPHA * (sample - *avg);
+}
+
+/*
+ * lookup_mode_from_str -- parse the name of a lookup mode
+ */
+int
+lookup_mode_from_str(const char *str, enum lookup_mode *mode)
+{
+	if (strcmp(str, "segment") == 0)
+		*mode = LOOKUP_MODE_SEGMENT;
+	else if (strcmp(str, "two-phase") == 0)
+		*mode = LOOKUP_MODE_TWO_PHASE;
+	else if (strcmp(str, "adaptive") == 0)
+		*mode = LOOKUP_MODE_ADAPTIVE;
+	else
+		return -1;
+
+	return 0;
+}
+
+/*
+ * lookup_header_offset -- the offset of the area the header is read into
+ * (right behind the ring of the segments)
+ */
+static size_t
+lookup_header_offset(struct lookup_engine *eng)
+{
+	return (size_t)eng->queue_depth * HASH_SEGMENT_SIZE;
+}
+
+/*
+ * lookup_header_apply -- take the arrays of the table from the header
+ * read into its area; returns -1 if the header is not valid
+ */
+static int
+lookup_header_apply(struct lookup_engine *eng)
+{
+	const struct hash_header *hdr = (const struct hash_header *)
+			(eng->dst_ptr + lookup_header_offset(eng));
+	uint32_t exponent;
+
+	if (hash_header_check(hdr, &exponent))
+		return -1;
+
+	struct lookup_layout layouts[2] = {{0}};
+	int nlayouts = 1;
+	layouts[0].buckets = eng->table_offset + hash_header_buckets(hdr);
+	layouts[0].mask = (1ULL << exponent) - 1;
+	if (hash_header_next(hdr) != 0) {
+		layouts[1].buckets = eng->table_offset + hash_header_next(hdr);
+		layouts[1].mask = (1ULL << (exponent + 1)) - 1;
+		nlayouts = 2;
+	}
+
+	/* the lookups in flight start over only if the arrays have changed */
+	if (nlayouts != eng->nlayouts ||
+			memcmp(layouts, eng->layouts, sizeof(layouts)) != 0) {
+		memcpy(eng->layouts, layouts, sizeof(layouts));
+		eng->nlayouts = nlayouts;
+		eng->generation++;
+	}
+	eng->versioned = !!(hash_header_flags(hdr) & HASH_F_UPDATES);
+
+	return 0;
+}
+
+/*
+ * lookup_header_post -- read the header again unless it is being read
+ * already; the read completes with the index of the area as its wr_id
+ */
+static int
+lookup_header_post(struct lookup_engine *eng, struct lookup_stats *stats)
+{
+	if (eng->header_posted)
+		return 0;
+
+	int ret = rpma_read(eng->conn, eng->dst_mr,
+			lookup_header_offset(eng), eng->src_mr,
+			eng->table_offset, sizeof(struct hash_header),
+			RPMA_F_COMPLETION_ALWAYS,
+			(void *)(uintptr_t)eng->queue_depth);
+	if (ret)
+		return ret;
+
+	eng->header_posted = 1;
+	stats->reads++;
+	stats->bytes_read += sizeof(struct hash_header);
+
+	return 0;
+}
+
+/*
+ * lookup_read_header -- read and validate the header of the table
+ */
+static int
+lookup_read_header(struct lookup_engine *eng)
+{
+	struct ibv_wc wc;
+	int ret;
+
+	ret = rpma_read(eng->conn, eng->dst_mr, lookup_header_offset(eng),
+			eng->src_mr, eng->table_offset,
+			sizeof(struct hash_header), RPMA_F_COMPLETION_ALWAYS,
+			NULL);
+	if (ret)
+		return ret;
+
+	do {
+		ret = rpma_cq_get_wc(eng->cq, 1, &wc, NULL);
+	} while (ret == RPMA_E_NO_COMPLETION);
+	if (ret)
+		return ret;
+
+	if (wc.status != IBV_WC_SUCCESS) {
+		(void) fprintf(stderr, "rpma_read() failed: %s\n",
+				ibv_wc_status_str(wc.status));
+		return -1;
+	}
+
+	if (lookup_header_apply(eng)) {
+		(void) fprintf(stderr,
+				"the remote memory does not contain a valid hash table (format version %d expected)\n",
+				HASH_FORMAT_VERSION);
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * lookup_engine_new -- create an engine keeping up to queue_depth lookups
+ * in flight over the connection
+ */
+int
+lookup_engine_new(struct rpma_peer *peer, struct rpma_conn *conn,
+		struct rpma_mr_remote *src_mr, size_t table_offset,
+		int queue_depth, enum lookup_mode mode,
+		struct lookup_engine **eng_ptr)
+{
+	if (queue_depth < 1 || queue_depth > QUEUE_DEPTH_MAX)
+		return RPMA_E_INVAL;
+
+	struct lookup_engine *eng = calloc(1, sizeof(*eng));
+	if (eng == NULL)
+		return RPMA_E_NOMEM;
+
+	eng->conn = conn;
+	eng->src_mr = src_mr;
+	eng->table_offset = table_offset;
+	eng->queue_depth = queue_depth;
+	eng->mode = mode;
+
+	int ret = rpma_conn_get_cq(conn, &eng->cq);
+	if (ret)
+		goto err_free;
+
+	ret = RPMA_E_NOMEM;
+	eng->slots = calloc((size_t)queue_depth, sizeof(*eng->slots));
+	eng->free_slots = calloc((size_t)queue_depth,
+			sizeof(*eng->free_slots));
+	/* every range takes at least one segment of the ring */
+	eng->ranges = calloc((size_t)queue_depth, sizeof(*eng->ranges));
+	if (eng->slots == NULL || eng->free_slots == NULL ||
+			eng->ranges == NULL)
+		goto err_free;
+
+	/* allocate and register the ring of the segments and the header */
+	size_t ring_size = (size_t)(queue_depth + 1) * HASH_SEGMENT_SIZE;
+	eng->dst_ptr = malloc_aligned(ring_size);
+	if (eng->dst_ptr == NULL)
+		goto err_free;
+
+	ret = rpma_mr_reg(peer, eng->dst_ptr, ring_size,
+			RPMA_MR_USAGE_READ_DST, &eng->dst_mr);
+	if (ret)
+		goto err_free;
+
+	ret = lookup_read_header(eng);
+	if (ret)
+		goto err_mr_dereg;
+
+	for (int slot = 0; slot < queue_depth; slot++)
+		eng->free_slots[eng->nfree++] = slot;
+
+	*eng_ptr = eng;
+
+	return 0;
+
+err_mr_dereg:
+	(void) rpma_mr_dereg(&eng->dst_mr);
+
+err_free:
+	free(eng->dst_ptr);
+	free(eng->ranges);
+	free(eng->free_slots);
+	free(eng->slots);
+	free(eng);
+
+	return ret;
+}
+
+/*
+ * lookup_engine_delete -- delete the engine
+ */
+void
+lookup_engine_delete(struct lookup_engine **eng_ptr)
+{
+	struct lookup_engine *eng = *eng_ptr;
+	if (eng == NULL)
+		return;
+
+	(void) rpma_mr_dereg(&eng->dst_mr);
+	free(eng->dst_ptr);
+	free(eng->mget_slots);
+	free(eng->ranges);
+	free(eng->free_slots);
+	free(eng->slots);
+	free(eng);
+
+	*eng_ptr = NULL;
+}
+
+/*
+ * lookup_engine_set_cache -- make the engine use the cache of the segments
+ */
+void
+lookup_engine_set_cache(struct lookup_engine *eng, struct hash_cache *cache,
+		uint32_t ns)
+{
+	eng->cache = cache;
+	eng->cache_ns = ns;
+}
+
+/*
+ * lookup_engine_set_lat -- pass the latencies of the lookups to lat_fn
+ */
+void
+lookup_engine_set_lat(struct lookup_engine *eng, lookup_lat_fn lat_fn,
+		void *arg)
+{
+	eng->lat_fn = lat_fn;
+	eng->lat_arg = arg;
+}
+
+/*
+ * lookup_hopinfo -- get hopinfo of the home bucket read into the slot
+ */
+static uint32_t
+lookup_hopinfo(const char *seg)
+{
+	return hash_bucket_hopinfo((const struct hash_bucket *)seg);
+}
+
+/*
+ * lookup_match -- find the bucket holding the key of the slot among
+ * the buckets of the segment read into the slot pointed by hopinfo;
+ * returns its index or -1
+ */
+static int
+lookup_match(const char *seg, uint32_t hopinfo, const char *key,
+		const struct lookup_slot *s)
+{
+	return hash_segment_find((const struct hash_bucket *)seg, hopinfo,
+			key, s->key_len, s->fingerprint);
+}
+
+/*
+ * lookup_version -- get the version of the n-th bucket read into the slot
+ */
+static uint64_t
+lookup_version(const char *seg, int n)
+{
+	return hash_bucket_version(&((const struct hash_bucket *)seg)[n]);
+}
+
+/*
+ * lookup_home -- find the home bucket of the key of the slot in the array
+ * of the level of the slot (the current one if the arrays have changed)
+ */
+static void
+lookup_home(struct lookup_engine *eng, struct lookup_slot *s,
+		const char *key)
+{
+	if (s->generation != eng->generation) {
+		s->generation = eng->generation;
+		s->level = 0;
+	}
+
+	const struct lookup_layout *lay = &eng->layouts[s->level];
+	s->key_len = hash_key_len(key);
+
+	uint32_t h = _jenkins_hash((uint8_t *)key, s->key_len);
+	s->fingerprint = hash_fingerprint(h);
+	s->home_index = h & lay->mask;
+	s->home = hash_bucket_offset(lay->buckets, s->home_index);
+}
+
+/*
+ * lookup_cache_index -- the index of the home bucket of the slot
+ * in the cache, unique across all the arrays of the table
+ */
+static uint64_t
+lookup_cache_index(const struct lookup_slot *s)
+{
+	return s->home / HASH_BUCKET_SIZE;
+}
+
+/*
+ * lookup_read -- post a read of len bytes at offset off of the home bucket
+ * of the slot into the same offset of the slot
+ */
+static int
+lookup_read(struct lookup_engine *eng, int slot, size_t home, size_t off,
+		size_t len, int flags, struct lookup_stats *stats)
+{
+	int ret = rpma_read(eng->conn, eng->dst_mr,
+			(size_t)slot * HASH_SEGMENT_SIZE + off,
+			eng->src_mr, home + off, len, flags,
+			(void *)(uintptr_t)slot);
+	if (ret)
+		return ret;
+
+	stats->reads++;
+	stats->bytes_read += len;
+
+	return 0;
+}
+
+/*
+ * lookup_gather -- read the buckets of the segment pointed by hopinfo
+ * (but the home one) with up to LOOKUP_GATHER_MAX reads
+ */
+static int
+lookup_gather(struct lookup_engine *eng, int slot, size_t home,
+		uint32_t hopinfo, struct lookup_stats *stats)
+{
+	unsigned first[HASH_HOP_NUMBER];
+	unsigned last[HASH_HOP_NUMBER];
+	int nruns = 0;
+
+	/* find the runs of the adjacent buckets */
+	for (unsigned i = 1; i < HASH_HOP_NUMBER; i++) {
+		if (!(hopinfo & (1U << i)))
+			continue;
+		if (nruns > 0 && last[nruns - 1] == i - 1) {
+			last[nruns - 1] = i;
+		} else {
+			first[nruns] = last[nruns] = i;
+			nruns++;
+		}
+	}
+
+	/* merge the runs separated by the smallest gaps */
+	while (nruns > LOOKUP_GATHER_MAX) {
+		int min = 0;
+		for (int r = 1; r < nruns - 1; r++) {
+			if (first[r + 1] - last[r] < first[min + 1] - last[min])
+				min = r;
+		}
+		last[min] = last[min + 1];
+		for (int r = min + 1; r < nruns - 1; r++) {
+			first[r] = first[r + 1];
+			last[r] = last[r + 1];
+		}
+		nruns--;
+	}
+
+	for (int r = 0; r < nruns; r++) {
+		/* only the last read generates a completion */
+		int flags = (r == nruns - 1) ? RPMA_F_COMPLETION_ALWAYS :
+				RPMA_F_COMPLETION_ON_ERROR;
+		size_t len = (last[r] - first[r] + 1) * HASH_BUCKET_SIZE;
+		int ret = lookup_read(eng, slot, home, first[r] * HASH_BUCKET_SIZE,
+				len, flags, stats);
+		if (ret)
+			return ret;
+		if (eng->mode == LOOKUP_MODE_ADAPTIVE)
+			lookup_ewma(&eng->gather_bytes, (double)len);
+	}
+
+	return 0;
+}
+
+/*
+ * lookup_pick_two_phase -- decide if the next lookup is done
+ * in the two-phase mode
+ */
+static int
+lookup_pick_two_phase(struct lookup_engine *eng)
+{
+	switch (eng->mode) {
+	case LOOKUP_MODE_SEGMENT:
+		return 0;
+	case LOOKUP_MODE_TWO_PHASE:
+		return 1;
+	default:
+		break;
+	}
+
+	/* measure both of the modes first */
+	uint64_t n = eng->decisions++;
+	if (eng->rtt_ns == 0 || eng->ns_per_byte == 0)
+		return (int)(n & 1);
+
+	/*
+	 * The segment costs one round trip and the transfer of the whole
+	 * segment. The home bucket costs one round trip and the transfer
+	 * of a single bucket and, if needed, the second phase costs another
+	 * round trip and the transfer of the gathered buckets.
+	 */
+	double segment_ns = eng->rtt_ns + HASH_SEGMENT_SIZE * eng->ns_per_byte;
+	double two_phase_ns = eng->rtt_ns + HASH_BUCKET_SIZE * eng->ns_per_byte +
+			eng->gather_ratio * (eng->rtt_ns +
+			eng->gather_bytes * eng->ns_per_byte);
+	int two_phase = two_phase_ns < segment_ns;
+
+	/* keep measuring the mode which was not picked */
+	if (n % LOOKUP_EXPLORE_PERIOD == 0)
+		two_phase = !two_phase;
+
+	return two_phase;
+}
+
+/*
+ * lookup_segment -- read the whole segment of the slot
+ */
+static int
+lookup_segment(struct lookup_engine *eng, int slot,
+		struct lookup_stats *stats)
+{
+	struct lookup_slot *s = &eng->slots[slot];
+
+	s->phase = PHASE_SEGMENT;
+	s->cacheable = (eng->cache != NULL);
+	return lookup_read(eng, slot, s->home, 0, HASH_SEGMENT_SIZE,
+			RPMA_F_COMPLETION_ALWAYS, stats);
+}
+
+/*
+ * lookup_account -- account the result of the lookup of the key
+ * in the segment seg and store it if the results are collected
+ */
+static void
+lookup_account(struct lookup_engine *eng, const struct lookup_slot *s,
+		const char *seg, int found, struct lookup_stats *stats)
+{
+	if (found >= 0)
+		stats->found++;
+	else
+		stats->not_found++;
+
+	if (eng->results == NULL)
+		return;
+
+	struct lookup_result *res = &eng->results[s->key];
+	res->found = (found >= 0);
+	if (found < 0)
+		return;
+
+	const struct hash_bucket *b = &((const struct hash_bucket *)seg)[found];
+	res->val_len = b->val_len;
+	memcpy(res->val, b->val, HASH_VAL_MAX);
+}
+
+/*
+ * lookup_finish -- account the result of the lookup of the slot and cache
+ * its segment if it was read whole; always returns 1 (the lookup is finished)
+ */
+static int
+lookup_finish(struct lookup_engine *eng, int slot, int found,
+		struct lookup_stats *stats)
+{
+	struct lookup_slot *s = &eng->slots[slot];
+	const char *seg = eng->dst_ptr + (size_t)slot * HASH_SEGMENT_SIZE;
+
+	if (s->cacheable) {
+		hash_cache_put(eng->cache, eng->cache_ns,
+				lookup_cache_index(s), seg, s->version);
+		s->cacheable = 0;
+	}
+
+	lookup_account(eng, s, seg, found, stats);
+
+	if (eng->lat_fn)
+		eng->lat_fn(eng->lat_arg, lookup_now_ns() - s->started_ns);
+
+	return 1;
+}
+
+/*
+ * lookup_cached -- look the key of the slot up in the cached segment;
+ * returns 1 if the lookup is finished, 0 if the version of the home bucket
+ * has to be checked first, -1 on a cache miss or a negative value on error
+ */
+static int
+lookup_cached(struct lookup_engine *eng, int slot, const char *key,
+		struct lookup_stats *stats)
+{
+	struct lookup_slot *s = &eng->slots[slot];
+	char *seg = eng->dst_ptr + (size_t)slot * HASH_SEGMENT_SIZE;
+
+	if (hash_cache_get(eng->cache, eng->cache_ns, lookup_cache_index(s),
+			seg, &s->version))
+		return -1;
+
+	s->cacheable = 0;
+
+	/* the table is never modified so the segment is always up to date */
+	if (!eng->versioned) {
+		stats->cache_hits++;
+		return lookup_finish(eng, slot,
+				lookup_match(seg, lookup_hopinfo(seg), key, s),
+				stats);
+	}
+
+	s->phase = PHASE_CACHED;
+	return lookup_read(eng, slot, s->home, HASH_VERSION_OFFSET,
+			sizeof(s->version), RPMA_F_COMPLETION_ALWAYS, stats);
+}
+
+/*
+ * lookup_start -- start the lookup of the key in the slot;
+ * returns 1 if the lookup was finished at once (from the cache)
+ */
+static int
+lookup_start(struct lookup_engine *eng, int slot, const char *key,
+		struct lookup_stats *stats)
+{
+	struct lookup_slot *s = &eng->slots[slot];
+
+	lookup_home(eng, s, key);
+	s->posted_ns = lookup_now_ns();
+	s->cacheable = 0;
+
+	if (eng->cache) {
+		int ret = lookup_cached(eng, slot, key, stats);
+		if (ret != -1)
+			return ret;
+
+		/* only the whole segments can be cached */
+		return lookup_segment(eng, slot, stats);
+	}
+
+	if (lookup_pick_two_phase(eng)) {
+		s->phase = PHASE_HOME;
+		stats->two_phase++;
+		return lookup_read(eng, slot, s->home, 0, HASH_BUCKET_SIZE,
+				RPMA_F_COMPLETION_ALWAYS, stats);
+	}
+
+	return lookup_segment(eng, slot, stats);
+}
+
+/*
+ * lookup_retry -- restart the lookup of the slot which read a bucket being
+ * modified
+ */
+static int
+lookup_retry(struct lookup_engine *eng, int slot, const char *key,
+		struct lookup_stats *stats)
+{
+	stats->retries++;
+
+	return lookup_start(eng, slot, key, stats);
+}
+
+/*
+ * lookup_moved -- continue the lookup of the slot whose home bucket was
+ * moved to the next array; if the engine does not know the array (anymore),
+ * the header is read again before the lookup is restarted - the reads
+ * of one connection complete in order
+ */
+static int
+lookup_moved(struct lookup_engine *eng, int slot, const char *key,
+		struct lookup_stats *stats)
+{
+	struct lookup_slot *s = &eng->slots[slot];
+	int ret;
+
+	if (s->generation == eng->generation &&
+			s->level + 1 < eng->nlayouts) {
+		s->level++;
+		if (++eng->moved % LOOKUP_HEADER_PERIOD == 0) {
+			ret = lookup_header_post(eng, stats);
+			if (ret)
+				return ret;
+		}
+		return lookup_start(eng, slot, key, stats);
+	}
+
+	ret = lookup_header_post(eng, stats);
+	if (ret)
+		return ret;
+
+	s->level = 0;
+	return lookup_retry(eng, slot, key, stats);
+}
+
+/*
+ * lookup_validate -- confirm the miss of the slot by re-reading
+ * the version of the home bucket
+ */
+static int
+lookup_validate(struct lookup_engine *eng, int slot,
+		struct lookup_stats *stats)
+{
+	struct lookup_slot *s = &eng->slots[slot];
+
+	s->phase = PHASE_VALIDATE;
+	return lookup_read(eng, slot, s->home, HASH_VERSION_OFFSET,
+			sizeof(s->version), RPMA_F_COMPLETION_ALWAYS, stats);
+}
+
+/*
+ * lookup_complete -- process the completed read of the slot;
+ * return 1 if the lookup is finished, 0 if it continues
+ * or a negative value on error
+ */
+static int
+lookup_complete(struct lookup_engine *eng, int slot, char *const *keys,
+		struct lookup_stats *stats)
+{
+	struct lookup_slot *s = &eng->slots[slot];
+	const char *seg = eng->dst_ptr + (size_t)slot * HASH_SEGMENT_SIZE;
+	const char *key = keys[s->key];
+	int measure = (eng->mode == LOOKUP_MODE_ADAPTIVE);
+	double latency_ns = 0;
+	int found;	/* the index of the bucket holding the key or -1 */
+	int ret;
+
+	if (measure)
+		latency_ns = (double)(lookup_now_ns() - s->posted_ns);
+
+	/* the home bucket is being modified */
+	if (eng->versioned && (s->phase == PHASE_SEGMENT ||
+			s->phase == PHASE_HOME)) {
+		s->version = lookup_version(seg, 0);
+		if (s->version & 1)
+			return lookup_retry(eng, slot, key, stats);
+		if (s->version & HASH_VERSION_MOVED)
+			return lookup_moved(eng, slot, key, stats);
+	}
+
+	switch (s->phase) {
+	case PHASE_SEGMENT:
+		if (measure && eng->rtt_ns > 0 && latency_ns > eng->rtt_ns)
+			lookup_ewma(&eng->ns_per_byte,
+				(latency_ns - eng->rtt_ns) / HASH_SEGMENT_SIZE);
+		found = lookup_match(seg, lookup_hopinfo(seg), key, s);
+		break;
+
+	case PHASE_HOME:
+		if (measure) {
+			if (eng->rtt_ns == 0)
+				eng->rtt_ns = latency_ns;
+			else
+				lookup_ewma(&eng->rtt_ns, latency_ns);
+		}
+
+		s->hopinfo = lookup_hopinfo(seg);
+		found = lookup_match(seg, s->hopinfo & 1U, key, s);
+		if (found >= 0 || (s->hopinfo & ~1U) == 0) {
+			if (measure)
+				lookup_ewma(&eng->gather_ratio, 0);
+			break;
+		}
+
+		/* the key can be only in the other buckets */
+		if (measure)
+			lookup_ewma(&eng->gather_ratio, 1);
+		s->phase = PHASE_GATHER;
+		s->posted_ns = lookup_now_ns();
+		ret = lookup_gather(eng, slot, s->home, s->hopinfo, stats);
+		return ret;
+
+	case PHASE_GATHER:
+		found = lookup_match(seg, s->hopinfo & ~1U, key, s);
+		break;
+
+	case PHASE_VALIDATE:
+		/* the segment was modified while it was read */
+		if (lookup_version(seg, 0) != s->version)
+			return lookup_retry(eng, slot, key, stats);
+		return lookup_finish(eng, slot, -1, stats);
+
+	case PHASE_CACHED:
+		/* the keys of the home bucket were modified since cached */
+		if (lookup_version(seg, 0) != s->version) {
+			stats->cache_stale++;
+			return lookup_segment(eng, slot, stats);
+		}
+		stats->cache_hits++;
+		return lookup_finish(eng, slot,
+				lookup_match(seg, lookup_hopinfo(seg), key, s),
+				stats);
+
+	default:
+		return -1;
+	}
+
+	if (eng->versioned) {
+		/* the bucket holding the key is being modified */
+		if (found >= 0 && (lookup_version(seg, found) & 1))
+			return lookup_retry(eng, slot, key, stats);
+
+		/* a key being moved can be missed only if the segment changed */
+		if (found < 0)
+			return lookup_validate(eng, slot, stats);
+	}
+
+	return lookup_finish(eng, slot, found, stats);
+}
+
+/*
+ * lookup_pipeline -- look up the keys keeping up to queue_depth lookups
+ * in flight; if pending is not NULL, the n-th lookup continues the lookup
+ * of pending[n] (the keys left by a multi-get) and starts the n-th key
+ * otherwise
+ */
+static int
+lookup_pipeline(struct lookup_engine *eng, char *const *keys,
+		const struct lookup_slot *pending, size_t nkeys,
+		struct lookup_stats *stats)
+{
+	struct ibv_wc wc[LOOKUP_WC_BATCH];
+	size_t next = 0;
+	size_t done = 0;
+	int ret;
+
+	/* the header being read again has to be read before returning */
+	while (done < nkeys || eng->header_posted) {
+		/* keep the pipeline full */
+		while (eng->nfree > 0 && next < nkeys) {
+			int slot = eng->free_slots[--eng->nfree];
+			struct lookup_slot *s = &eng->slots[slot];
+			uint64_t started_ns = eng->lat_fn ? lookup_now_ns() : 0;
+			if (pending == NULL) {
+				s->key = next;
+				s->level = 0;
+				s->started_ns = started_ns;
+				ret = lookup_start(eng, slot, keys[next], stats);
+			} else if (pending[next].phase == PHASE_VALIDATE) {
+				/* only the miss has to be confirmed */
+				*s = pending[next];
+				s->started_ns = started_ns;
+				ret = lookup_validate(eng, slot, stats);
+			} else {
+				s->key = pending[next].key;
+				s->level = 0;
+				s->started_ns = started_ns;
+				ret = lookup_start(eng, slot, keys[s->key],
+						stats);
+			}
+			next++;
+			if (ret == 0)
+				continue;
+
+			eng->free_slots[eng->nfree++] = slot;
+			if (ret < 0)
+				return ret;
+
+			/* found in the cache at once */
+			done++;
+		}
+
+		/* collect a batch of the completions */
+		int num = 0;
+		ret = rpma_cq_get_wc(eng->cq, LOOKUP_WC_BATCH, wc, &num);
+		if (ret == RPMA_E_NO_COMPLETION)
+			continue;
+		if (ret)
+			return ret;
+
+		for (int i = 0; i < num; i++) {
+			if (wc[i].status != IBV_WC_SUCCESS) {
+				(void) fprintf(stderr,
+					"rpma_read() failed: %s\n",
+					ibv_wc_status_str(wc[i].status));
+				return -1;
+			}
+
+			if (wc[i].opcode != IBV_WC_RDMA_READ) {
+				(void) fprintf(stderr,
+					"unexpected wc.opcode value (%d != %d)\n",
+					wc[i].opcode, IBV_WC_RDMA_READ);
+				return -1;
+			}
+
+			/* the header was read again */
+			if (wc[i].wr_id == (uint64_t)eng->queue_depth) {
+				eng->header_posted = 0;
+				/* a header being written is read again later */
+				(void) lookup_header_apply(eng);
+				continue;
+			}
+
+			/* process the read completed in the slot */
+			int slot = (int)wc[i].wr_id;
+			ret = lookup_complete(eng, slot, keys, stats);
+			if (ret < 0)
+				return ret;
+			if (ret == 0)
+				continue;
+
+			/* release the slot */
+			eng->free_slots[eng->nfree++] = slot;
+			done++;
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * lookup_engine_run -- look up all the keys and account the results
+ * in stats
+ */
+int
+lookup_engine_run(struct lookup_engine *eng, char *const *keys,
+		size_t nkeys, struct lookup_stats *stats)
+{
+	return lookup_pipeline(eng, keys, NULL, nkeys, stats);
+}
+
+/*
+ * lookup_home_cmp -- compare the keys by their home buckets
+ */
+static int
+lookup_home_cmp(const void *a, const void *b)
+{
+	const struct lookup_slot *sa = a;
+	const struct lookup_slot *sb = b;
+
+	if (sa->home_index != sb->home_index)
+		return sa->home_index < sb->home_index ? -1 : 1;
+
+	return 0;
+}
+
+/*
+ * lookup_range_size -- the size of the range of the buckets covering
+ * the segments of the home buckets first to last
+ */
+static size_t
+lookup_range_size(uint64_t first, uint64_t last)
+{
+	return (size_t)(last - first + HASH_HOP_NUMBER) * HASH_BUCKET_SIZE;
+}
+
+/*
+ * lookup_mget_batch -- post the reads of the ranges of the next keys
+ * of the multi-get fitting into the ring; only the last read generates
+ * a completion
+ */
+static int
+lookup_mget_batch(struct lookup_engine *eng, struct lookup_stats *stats)
+{
+	size_t ring_size = (size_t)eng->queue_depth * HASH_SEGMENT_SIZE;
+	size_t used = 0;
+	struct lookup_range *r = NULL;
+
+	eng->nranges = 0;
+	while (eng->mget_next < eng->mget_nkeys) {
+		uint64_t home = eng->mget_slots[eng->mget_next].home_index;
+
+		/* extend the range if the segment of the key overlaps it */
+		if (r != NULL && home < r->last + HASH_HOP_NUMBER &&
+				r->offset + lookup_range_size(r->first, home) <=
+				ring_size) {
+			r->last = home;
+			r->end = ++eng->mget_next;
+			continue;
+		}
+
+		if (r != NULL)
+			used = r->offset + lookup_range_size(r->first, r->last);
+		if (used + HASH_SEGMENT_SIZE > ring_size)
+			break;
+
+		/* start a new range */
+		r = &eng->ranges[eng->nranges++];
+		r->first = r->last = home;
+		r->offset = used;
+		r->begin = eng->mget_next;
+		r->end = ++eng->mget_next;
+	}
+
+	for (int i = 0; i < eng->nranges; i++) {
+		r = &eng->ranges[i];
+		size_t len = lookup_range_size(r->first, r->last);
+		int flags = (i == eng->nranges - 1) ?
+				RPMA_F_COMPLETION_ALWAYS :
+				RPMA_F_COMPLETION_ON_ERROR;
+		int ret = rpma_read(eng->conn, eng->dst_mr, r->offset,
+				eng->src_mr,
+				hash_bucket_offset(eng->layouts[0].buckets,
+				r->first), len, flags, NULL);
+		if (ret)
+			return ret;
+
+		stats->reads++;
+		stats->bytes_read += len;
+	}
+
+	return 0;
+}
+
+/*
+ * lookup_mget_complete -- look up the keys of the ranges of the completed
+ * batch; the keys which cannot be answered yet are left to the pipelined
+ * lookups
+ */
+static void
+lookup_mget_complete(struct lookup_engine *eng, char *const *keys,
+		struct lookup_stats *stats)
+{
+	for (int i = 0; i < eng->nranges; i++) {
+		const struct lookup_range *r = &eng->ranges[i];
+
+		for (size_t k = r->begin; k < r->end; k++) {
+			struct lookup_slot *s = &eng->mget_slots[k];
+			const char *seg = eng->dst_ptr + r->offset +
+					(s->home_index - r->first) *
+					HASH_BUCKET_SIZE;
+			const char *key = keys[s->key];
+			int found;
+
+			if (!eng->versioned) {
+				found = lookup_match(seg, lookup_hopinfo(seg),
+						key, s);
+				lookup_account(eng, s, seg, found, stats);
+				continue;
+			}
+
+			/* the home bucket is being modified */
+			s->version = lookup_version(seg, 0);
+			s->phase = PHASE_SEGMENT;
+			if (s->version & 1) {
+				stats->retries++;
+				eng->mget_slots[eng->mget_npending++] = *s;
+				continue;
+			}
+
+			/* the keys were moved to the next array */
+			if (s->version & HASH_VERSION_MOVED) {
+				eng->mget_slots[eng->mget_npending++] = *s;
+				continue;
+			}
+
+			found = lookup_match(seg, lookup_hopinfo(seg), key, s);
+			if (found >= 0 && (lookup_version(seg, found) & 1)) {
+				stats->retries++;
+				eng->mget_slots[eng->mget_npending++] = *s;
+				continue;
+			}
+
+			/* the miss is confirmed by re-reading the version */
+			if (found < 0) {
+				s->phase = PHASE_VALIDATE;
+				eng->mget_slots[eng->mget_npending++] = *s;
+				continue;
+			}
+
+			lookup_account(eng, s, seg, found, stats);
+		}
+	}
+
+	eng->nranges = 0;
+}
+
+/*
+ * lookup_engine_mget_post -- start the multi-get of the keys
+ */
+int
+lookup_engine_mget_post(struct lookup_engine *eng, char *const *keys,
+		size_t nkeys, struct lookup_result *results,
+		struct lookup_stats *stats)
+{
+	if (nkeys > eng->mget_capacity) {
+		struct lookup_slot *mget_slots = realloc(eng->mget_slots,
+				nkeys * sizeof(*mget_slots));
+		if (mget_slots == NULL)
+			return RPMA_E_NOMEM;
+		eng->mget_slots = mget_slots;
+		eng->mget_capacity = nkeys;
+	}
+
+	for (size_t k = 0; k < nkeys; k++) {
+		struct lookup_slot *s = &eng->mget_slots[k];
+
+		memset(s, 0, sizeof(*s));
+		s->key = k;
+		lookup_home(eng, s, keys[k]);
+	}
+	qsort(eng->mget_slots, nkeys, sizeof(*eng->mget_slots),
+			lookup_home_cmp);
+
+	eng->results = results;
+	eng->mget_keys = keys;
+	eng->mget_nkeys = nkeys;
+	eng->mget_next = 0;
+	eng->mget_npending = 0;
+
+	return lookup_mget_batch(eng, stats);
+}
+
+/*
+ * lookup_engine_mget_poll -- complete the posted batch of the multi-get
+ * and post the next one
+ */
+int
+lookup_engine_mget_poll(struct lookup_engine *eng, int wait,
+		struct lookup_stats *stats)
+{
+	struct ibv_wc wc;
+	int ret;
+
+	if (eng->nranges > 0) {
+		do {
+			ret = rpma_cq_get_wc(eng->cq, 1, &wc, NULL);
+		} while (ret == RPMA_E_NO_COMPLETION && wait);
+		if (ret == RPMA_E_NO_COMPLETION)
+			return 0;
+		if (ret)
+			return ret;
+
+		if (wc.status != IBV_WC_SUCCESS) {
+			(void) fprintf(stderr, "rpma_read() failed: %s\n",
+					ibv_wc_status_str(wc.status));
+			return -1;
+		}
+
+		lookup_mget_complete(eng, eng->mget_keys, stats);
+
+		ret = lookup_mget_batch(eng, stats);
+		if (ret)
+			return ret;
+		if (eng->nranges > 0)
+			return 0;
+	}
+
+	/* finish the keys left by the batches */
+	ret = lookup_pipeline(eng, eng->mget_keys, eng->mget_slots,
+			eng->mget_npending, stats);
+	eng->results = NULL;
+	eng->mget_npending = 0;
+
+	return ret ? ret : 1;
+}
+
+/*
+ * lookup_engine_mget -- look up all the keys at once
+ */
+int
+lookup_engine_mget(struct lookup_engine *eng, char *const *keys,
+		size_t nkeys, struct lookup_result *results,
+		struct lookup_stats *stats)
+{
+	int ret = lookup_engine_mget_post(eng, keys, nkeys, results, stats);
+
+	while (ret == 0)
+		ret = lookup_engine_mget_poll(eng, 1, stats);
+
+	return ret < 0 ? ret : 0;
+}
@@ -0,0 +1,144 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * hashlookup.h -- the pipelined lookup engine of the hash example clients
+ */
+
+#ifndef _HASHLOOKUP_H
+#define _HASHLOOKUP_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <librpma.h>
+
+#include "hashformat.h"
+
+/* the number of lookups kept in flight by a single engine */
+#define QUEUE_DEPTH_DEFAULT	64
+#define QUEUE_DEPTH_MAX		128
+
+/* the maximum number of reads of the second phase of a two-phase lookup */
+#define LOOKUP_GATHER_MAX	4
+
+/*
+ * the send and the completion queue sizes required by an engine of the given
+ * queue depth (one more read may be in flight to read the header again)
+ */
+#define LOOKUP_SQ_SIZE(queue_depth) ((queue_depth) * LOOKUP_GATHER_MAX + 1)
+#define LOOKUP_CQ_SIZE(queue_depth) ((queue_depth) + 1)
+
+enum lookup_mode {
+	/* read the whole segment (32 buckets) of a key at once */
+	LOOKUP_MODE_SEGMENT,
+	/*
+	 * read the home bucket first and then only the buckets pointed
+	 * by its hopinfo
+	 */
+	LOOKUP_MODE_TWO_PHASE,
+	/*
+	 * pick one of the above per key comparing the costs estimated
+	 * from the measured round-trip time and bandwidth
+	 */
+	LOOKUP_MODE_ADAPTIVE,
+};
+
+struct lookup_stats {
+	uint64_t found;
+	uint64_t not_found;
+	uint64_t reads;
+	uint64_t bytes_read;
+	uint64_t two_phase;	/* lookups done in the two-phase mode */
+	uint64_t retries;	/* lookups restarted because of the updates */
+	uint64_t cache_hits;	/* lookups done with a cached segment */
+	uint64_t cache_stale;	/* cached segments found out of date */
+};
+
+/* the result of the lookup of one key of a multi-get */
+struct lookup_result {
+	int found;
+	uint8_t val_len;
+	char val[HASH_VAL_MAX];
+};
+
+/* the function the latencies of the lookups are passed to */
+typedef void (*lookup_lat_fn)(void *arg, uint64_t lat_ns);
+
+struct lookup_engine;
+struct hash_cache;
+
+/*
+ * lookup_mode_from_str -- parse the name of a lookup mode
+ * ("segment", "two-phase" or "adaptive")
+ */
+int lookup_mode_from_str(const char *str, enum lookup_mode *mode);
+
+/*
+ * lookup_engine_new -- create an engine keeping up to queue_depth lookups
+ * in flight over the connection; the send queue of the connection has to
+ * be at least LOOKUP_SQ_SIZE(queue_depth) deep and its completion queue
+ * at least LOOKUP_CQ_SIZE(queue_depth) deep; the table starts at table_offset
+ * of src_mr
+ * and its header is read and validated before the engine is returned
+ */
+int lookup_engine_new(struct rpma_peer *peer, struct rpma_conn *conn,
+		struct rpma_mr_remote *src_mr, size_t table_offset,
+		int queue_depth, enum lookup_mode mode,
+		struct lookup_engine **eng_ptr);
+
+/*
+ * lookup_engine_delete -- delete the engine
+ */
+void lookup_engine_delete(struct lookup_engine **eng_ptr);
+
+/*
+ * lookup_engine_set_cache -- make the engine keep the segments it reads
+ * in the cache and use the cached ones (see hashcache.h); ns tells apart
+ * the tables of the different servers sharing the same cache
+ */
+void lookup_engine_set_cache(struct lookup_engine *eng,
+		struct hash_cache *cache, uint32_t ns);
+
+/*
+ * lookup_engine_set_lat -- pass the latency of every pipelined lookup
+ * (from posting its first read until its result is known) to lat_fn
+ */
+void lookup_engine_set_lat(struct lookup_engine *eng, lookup_lat_fn lat_fn,
+		void *arg);
+
+/*
+ * lookup_engine_run -- look up all the keys and account the results
+ * in stats; the keys are completed out of order
+ */
+int lookup_engine_run(struct lookup_engine *eng, char *const *keys,
+		size_t nkeys, struct lookup_stats *stats);
+
+/*
+ * lookup_engine_mget -- look up all the keys at once and store the result
+ * of the n-th key in results[n]; the keys of the overlapping segments are read
+ * by a single read and the reads are posted in batches with only the last
+ * read of a batch signaled
+ */
+int lookup_engine_mget(struct lookup_engine *eng, char *const *keys,
+		size_t nkeys, struct lookup_result *results,
+		struct lookup_stats *stats);
+
+/*
+ * lookup_engine_mget_post -- start the multi-get of the keys posting
+ * the reads of its first batch; the keys and the results have to stay
+ * valid until lookup_engine_mget_poll() returns 1
+ */
+int lookup_engine_mget_post(struct lookup_engine *eng, char *const *keys,
+		size_t nkeys, struct lookup_result *results,
+		struct lookup_stats *stats);
+
+/*
+ * lookup_engine_mget_poll -- complete the posted batch of the multi-get
+ * and post the next one; returns 0 if the multi-get continues (or, if wait
+ * is 0, the batch has not completed yet), 1 when all the results are stored
+ * or a negative value on error
+ */
+int lookup_engine_mget_poll(struct lookup_engine *eng, int wait,
+		struct lookup_stats *stats);
+
+#endif /* _HASHLOOKUP_H */
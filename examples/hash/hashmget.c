@@ -0,0 +1,106 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * hashmget.c -- the multi-get of the keys spread over the hash servers
+ *
+ * The keys are grouped by the servers they are routed to and the multi-get
+ * of every group is posted on the engine of its server (see
+ * lookup_engine_mget_post()) before any of them is waited for, so the reads
+ * of all the servers are in flight at the same time. The results of every
+ * group are scattered back to the input order of the keys.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "hashmget.h"
+
+/*
+ * hash_mget -- look up the keys on the servers the map routes them to
+ */
+int
+hash_mget(struct lookup_engine *const *engines,
+		const struct shard_map *map, char *const *keys, size_t nkeys,
+		struct lookup_result *results, struct lookup_stats *stats)
+{
+	uint32_t nservers = map ? map->nservers : 1;
+	size_t first[SHARD_SERVERS_MAX + 1] = {0};
+	size_t fill[SHARD_SERVERS_MAX];
+	int done[SHARD_SERVERS_MAX] = {0};
+	int ret = 0;
+
+	if (nkeys == 0)
+		return 0;
+
+	/* the keys grouped by the servers and their input positions */
+	char **group_keys = malloc(nkeys * sizeof(*group_keys));
+	size_t *origin = malloc(nkeys * sizeof(*origin));
+	uint32_t *server_of = malloc(nkeys * sizeof(*server_of));
+	struct lookup_result *group_results =
+			calloc(nkeys, sizeof(*group_results));
+	if (group_keys == NULL || origin == NULL || server_of == NULL ||
+			group_results == NULL) {
+		ret = -1;
+		goto err_free;
+	}
+
+	for (size_t k = 0; k < nkeys; k++) {
+		server_of[k] = map ? shard_map_route(map, keys[k],
+				hash_key_len(keys[k])) : 0;
+		first[server_of[k] + 1]++;
+	}
+	for (uint32_t srv = 0; srv < nservers; srv++)
+		first[srv + 1] += first[srv];
+	memcpy(fill, first, sizeof(fill));
+	for (size_t k = 0; k < nkeys; k++) {
+		size_t pos = fill[server_of[k]]++;
+		group_keys[pos] = keys[k];
+		origin[pos] = k;
+	}
+
+	/* post the first batches of all the servers */
+	int ndone = 0;
+	for (uint32_t srv = 0; srv < nservers; srv++) {
+		size_t n = first[srv + 1] - first[srv];
+		if (n == 0) {
+			done[srv] = 1;
+			ndone++;
+			continue;
+		}
+
+		ret = lookup_engine_mget_post(engines[srv],
+				&group_keys[first[srv]], n,
+				&group_results[first[srv]], stats);
+		if (ret)
+			goto err_free;
+	}
+
+	/* complete the batches in the order they come */
+	while (ndone < (int)nservers) {
+		for (uint32_t srv = 0; srv < nservers; srv++) {
+			if (done[srv])
+				continue;
+
+			ret = lookup_engine_mget_poll(engines[srv], 0, stats);
+			if (ret < 0)
+				goto err_free;
+			if (ret == 1) {
+				done[srv] = 1;
+				ndone++;
+			}
+		}
+	}
+	ret = 0;
+
+	for (size_t pos = 0; pos < nkeys; pos++)
+		results[origin[pos]] = group_results[pos];
+
+err_free:
+	free(group_results);
+	free(server_of);
+	free(origin);
+	free(group_keys);
+
+	return ret;
+}
@@ -0,0 +1,23 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * hashmget.h -- the multi-get of the keys spread over the hash servers
+ */
+
+#ifndef _HASHMGET_H
+#define _HASHMGET_H
+
+#include "hashlookup.h"
+#include "shardmap.h"
+
+/*
+ * hash_mget -- look up the keys on the servers the map routes them to
+ * (engines[n] is the engine of the n-th server of the map or the only one
+ * if map is NULL) and store the result of the n-th key in results[n]
+ */
+int hash_mget(struct lookup_engine *const *engines,
+		const struct shard_map *map, char *const *keys, size_t nkeys,
+		struct lookup_result *results, struct lookup_stats *stats);
+
+#endif /* _HASHMGET_H */
@@ -0,0 +1,79 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * hashproto.h -- the client-server protocol of the hash example
+ */
+
+#ifndef _HASHPROTO_H
+#define _HASHPROTO_H
+
+#include <stdint.h>
+
+#include "common-conn.h"
+#include "hashformat.h"
+
+/* the maximum number of connections a single client can open */
+#define HASH_CONNS_MAX 64
+
+/*
+ * The private data of the connection requests of the clients.
+ * A client opens one connection per lookup thread and every one of them
+ * tells the server how many connections the client is going to open,
+ * so the server knows how many of them it has to accept and wait for.
+ */
+struct hash_conn_req {
+	uint8_t nconns;
+};
+
+/*
+ * The private data the server answers the connection requests with.
+ * If the server publishes a shard map (see shardmap.h), its serialized
+ * form of map_len bytes is stored at HASH_META_OFFSET of the table and
+ * map_epoch tells the clients which version of the map the server serves.
+ */
+struct hash_conn_resp {
+	struct common_data data;	/* the memory region of the table */
+	uint32_t map_epoch;
+	uint16_t map_len;		/* 0 if no shard map is published */
+};
+
+/* limited by the private data of rdma_accept() in case of RDMA_PS_TCP */
+_Static_assert(sizeof(struct hash_conn_resp) <= 56,
+		"the response has to fit into the private data");
+
+/*
+ * The updates of the table are sent by the clients as messages
+ * (rpma_send()) and every one of them is answered with a response message.
+ * A connection can have up to HASH_UPDATE_QUEUE_DEPTH updates in flight.
+ */
+#define HASH_UPDATE_QUEUE_DEPTH 16
+
+enum hash_update_op {
+	HASH_UPDATE_PUT = 1,	/* insert the key or replace its value */
+	HASH_UPDATE_DELETE = 2,
+};
+
+enum hash_update_status {
+	HASH_UPDATE_OK = 0,
+	HASH_UPDATE_NOT_FOUND = 1,	/* the deleted key does not exist */
+	HASH_UPDATE_FULL = 2,		/* no space for the inserted key */
+	HASH_UPDATE_INVALID = 3,	/* a malformed request */
+};
+
+struct hash_update_req {
+	uint32_t id;		/* copied to the response */
+	uint8_t op;		/* enum hash_update_op */
+	uint8_t key_len;
+	uint8_t val_len;
+	uint8_t reserved;
+	char key[HASH_KEY_MAX];
+	char val[HASH_VAL_MAX];
+};
+
+struct hash_update_resp {
+	uint32_t id;
+	uint32_t status;	/* enum hash_update_status */
+};
+
+#endif /* _HASHPROTO_H */
@@ -5,26 +5,193 @@
  * hashserver.c -- a server that contains hashtable
  *
  *  The server acts as one of the endpoints that contain the hashtable in pmem and waits for the client to be connected
+ *
+ *  The clients look the keys up with one-sided RDMA reads and send the updates
+ *  of the table as messages, which are applied by one thread per connection
+ *  (see hashupdate.c).
+ *
+ *  If a shard map file is given, the server publishes the map in the metadata
+ *  area of the table (see hashformat.h), so the clients read it with the same
+ *  memory registration, and announces its epoch in the private data.
  */
 
+#include <inttypes.h>
 #include <librpma.h>
+#include <pthread.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include "common-conn.h"
 #include "common-hello.h"
 #include "common-map_file_with_signature_check.h"
 #include "common-pmem_map_file.h"
-#include "hopscotch.h"
+#include "hashformat.h"
+#include "hashproto.h"
+#include "hashupdate.h"
+#include "shardmap.h"
 
 #ifdef USE_PMEM
-#define USAGE_STR "usage: %s <server_address> <port> [<pmem-path>]\n"PMEM_USAGE
+#define USAGE_STR "usage: %s <server_address> <port> [<pmem-path> [<shard-map>]]\n"PMEM_USAGE
 #else
 #define USAGE_STR "usage: %s <server_address> <port>\n"
 #endif /* USE_PMEM */
 
-//Per single RDMA read retrieve the whole segment
-#define SEGMENT_SIZE 2048
+/* the receive buffers followed by the send buffers of a connection */
+#define RECV_OFFSET(i)	((i) * sizeof(struct hash_update_req))
+#define SEND_OFFSET(i)	(HASH_UPDATE_QUEUE_DEPTH * \
+		sizeof(struct hash_update_req) + \
+		(i) * sizeof(struct hash_update_resp))
+#define MSG_SIZE	SEND_OFFSET(HASH_UPDATE_QUEUE_DEPTH)
+
+/* the thread applying the updates received via a connection */
+struct updater {
+	struct hash_table *tbl;
+	struct rpma_conn *conn;
+	struct rpma_mr_local *msg_mr;
+	char *msg_ptr;
+	pthread_t thread;
+	int started;
+	uint64_t applied;
+};
+
+/*
+ * updater_handle -- handle a completion of the connection: apply the received
+ * update and send the response from the same slot or make the slot ready for
+ * the next update when the response is sent
+ */
+static int
+updater_handle(struct updater *upd, const struct ibv_wc *wc)
+{
+	uintptr_t slot = (uintptr_t)wc->wr_id;
+
+	if (slot >= HASH_UPDATE_QUEUE_DEPTH)
+		return -1;
+
+	switch (wc->opcode) {
+	case IBV_WC_RECV: {
+		struct hash_update_req *req = (struct hash_update_req *)
+				(upd->msg_ptr + RECV_OFFSET(slot));
+		struct hash_update_resp *resp = (struct hash_update_resp *)
+				(upd->msg_ptr + SEND_OFFSET(slot));
+
+		resp->id = req->id;
+		if (wc->byte_len < sizeof(*req))
+			resp->status = HASH_UPDATE_INVALID;
+		else
+			resp->status = hash_table_apply(upd->tbl, req);
+		upd->applied++;
+
+		return rpma_send(upd->conn, upd->msg_mr, SEND_OFFSET(slot),
+				sizeof(*resp), RPMA_F_COMPLETION_ALWAYS,
+				(void *)slot);
+	}
+	case IBV_WC_SEND:
+		return rpma_recv(upd->conn, upd->msg_mr, RECV_OFFSET(slot),
+				sizeof(struct hash_update_req), (void *)slot);
+	default:
+		fprintf(stderr, "unexpected wc.opcode value: %d\n",
+				wc->opcode);
+		return -1;
+	}
+}
+
+/*
+ * updater_thread -- apply the updates until the connection is disconnected
+ * (the outstanding receives are flushed then)
+ */
+static void *
+updater_thread(void *arg)
+{
+	struct updater *upd = arg;
+	struct ibv_wc wc[HASH_UPDATE_QUEUE_DEPTH];
+	struct rpma_cq *cq = NULL;
+	int num_got;
+	int ret;
+
+	ret = rpma_conn_get_cq(upd->conn, &cq);
+	if (ret)
+		return NULL;
 
+	for (uintptr_t i = 0; i < HASH_UPDATE_QUEUE_DEPTH; i++) {
+		ret = rpma_recv(upd->conn, upd->msg_mr, RECV_OFFSET(i),
+				sizeof(struct hash_update_req), (void *)i);
+		if (ret)
+			return NULL;
+	}
+
+	while (rpma_cq_wait(cq) == 0) {
+		while ((ret = rpma_cq_get_wc(cq, HASH_UPDATE_QUEUE_DEPTH, wc,
+				&num_got)) == 0) {
+			for (int i = 0; i < num_got; i++) {
+				/* the connection is being disconnected */
+				if (wc[i].status != IBV_WC_SUCCESS)
+					return NULL;
+
+				if (updater_handle(upd, &wc[i]))
+					return NULL;
+			}
+		}
+
+		if (ret != RPMA_E_NO_COMPLETION)
+			break;
+	}
+
+	return NULL;
+}
+
+/*
+ * updater_start -- register the message buffers of the connection and start
+ * its updater thread
+ */
+static int
+updater_start(struct updater *upd, struct rpma_peer *peer,
+		struct hash_table *tbl, struct rpma_conn *conn)
+{
+	int ret;
+
+	upd->tbl = tbl;
+	upd->conn = conn;
+	upd->msg_ptr = malloc_aligned(MSG_SIZE);
+	if (upd->msg_ptr == NULL)
+		return -1;
+
+	ret = rpma_mr_reg(peer, upd->msg_ptr, MSG_SIZE,
+			RPMA_MR_USAGE_SEND | RPMA_MR_USAGE_RECV, &upd->msg_mr);
+	if (ret)
+		goto err_free;
+
+	ret = pthread_create(&upd->thread, NULL, updater_thread, upd);
+	if (ret)
+		goto err_mr_dereg;
+
+	upd->started = 1;
+
+	return 0;
+
+err_mr_dereg:
+	(void) rpma_mr_dereg(&upd->msg_mr);
+
+err_free:
+	free(upd->msg_ptr);
+	upd->msg_ptr = NULL;
+
+	return -1;
+}
+
+/*
+ * updater_stop -- wait for the updater of the disconnected connection and
+ * release its resources
+ */
+static void
+updater_stop(struct updater *upd)
+{
+	if (!upd->started)
+		return;
+
+	(void) pthread_join(upd->thread, NULL);
+	(void) rpma_mr_dereg(&upd->msg_mr);
+	free(upd->msg_ptr);
+	upd->started = 0;
+}
 
 int
 main(int argc, char *argv[])
@@ -48,17 +215,21 @@ main(int argc, char *argv[])
 	/* resources - general */
 	struct rpma_peer *peer = NULL;
 	struct rpma_ep *ep = NULL;
-	struct rpma_conn *conn = NULL;
 
 	/* resources - memory region */
     struct common_mem mem;
 	memset(&mem, 0, sizeof(mem));
 	struct rpma_mr_local *mr = NULL;
 
-	//return the content in char array
-	char segment[SEGMENT_SIZE];
-	char *segpoint = segment;
+	struct hash_header *hdr = NULL;
+	struct hash_table tbl;
+	uint32_t exponent;
 
+	/* resources - connections */
+	struct rpma_conn_cfg *cfg = NULL;
+	struct rpma_conn *conns[HASH_CONNS_MAX] = {NULL};
+	struct updater updaters[HASH_CONNS_MAX];
+	memset(updaters, 0, sizeof(updaters));
 
 #ifdef USE_PMEM
 	if (argc >= 4) {
@@ -67,7 +238,8 @@ main(int argc, char *argv[])
 		ret = common_pmem_map_file(path, 0, &mem);
 		if (ret)
 			goto err_free;
-		segpoint = (uintptr_t)mem.mr_ptr + mem.data_offset;
+		hdr = (struct hash_header *)((char *)mem.mr_ptr +
+				mem.data_offset);
 	}
 #endif /* USE_PMEM */
 	/* if no pmem support or it is not provided */
@@ -75,7 +247,51 @@ main(int argc, char *argv[])
 			return -1;
 	}
 
-    (void) printf("Next value: %s\n", segpoint);
+	/* serve only the tables the clients are able to read */
+	if (hash_table_open(&tbl, hdr, mem.mr_size - mem.data_offset,
+			mem.persist)) {
+		fprintf(stderr,
+			"%s does not contain a valid hash table (format version %d expected, see writehash)\n",
+			argv[3], HASH_FORMAT_VERSION);
+		ret = -1;
+		goto err_free;
+	}
+	exponent = le32toh(hdr->exponent);
+
+	(void) printf("hash table: 2^%u home buckets%s, %" PRIu64 " keys\n",
+			exponent, tbl.next.buckets ? " (growing)" : "",
+			le64toh(hdr->nkeys));
+
+	/* publish the shard map */
+	struct hash_conn_resp resp = {0};
+	if (argc >= 5) {
+		struct shard_map *map = NULL;
+		if (shard_map_load(argv[4], &map)) {
+			ret = -1;
+			goto err_tbl_close;
+		}
+
+		if (shard_map_find(map, addr, port) < 0)
+			fprintf(stderr,
+				"warning: %s:%s is not one of the servers of %s\n",
+				addr, port, argv[4]);
+
+		char *meta = (char *)hdr + HASH_META_OFFSET;
+		size_t len = shard_map_encode(map, meta, HASH_META_SIZE);
+		resp.map_epoch = map->epoch;
+		resp.map_len = (uint16_t)len;
+		(void) printf("shard map: epoch %u, %u servers\n",
+				map->epoch, map->nservers);
+		shard_map_delete(&map);
+
+		if (len == 0) {
+			fprintf(stderr, "%s: the shard map is too big\n",
+					argv[4]);
+			ret = -1;
+			goto err_tbl_close;
+		}
+		mem.persist(meta, len);
+	}
 
 	/*
 	 * lookup an ibv_context via the address and create a new peer using it
@@ -94,7 +310,7 @@ main(int argc, char *argv[])
 	ret = rpma_mr_reg(peer, mem.mr_ptr, mem.mr_size,
 			RPMA_MR_USAGE_READ_SRC, &mr);
 	if (ret)
-		goto err_free;
+		goto err_tbl_close;
 
 	/* get size of the memory region's descriptor */
 	size_t mr_desc_size;
@@ -102,42 +318,103 @@ main(int argc, char *argv[])
 	if (ret)
 		goto err_mr_dereg;
 
-	struct common_data data = {0};
-    data.data_offset = mem.data_offset;// + offsetof(struct hello_t, str);
-	data.mr_desc_size = mr_desc_size;
+	struct common_data *data = &resp.data;
+	data->data_offset = mem.data_offset;
+	data->mr_desc_size = mr_desc_size;
 
 	/* get the memory region's descriptor */
-	ret = rpma_mr_get_descriptor(mr, &data.descriptors[0]);
+	ret = rpma_mr_get_descriptor(mr, &data->descriptors[0]);
 	if (ret)
 		goto err_mr_dereg;
 
 	struct rpma_conn_private_data pdata;
-	pdata.ptr = &data;
-	pdata.len = sizeof(struct common_data);
+	pdata.ptr = &resp;
+	pdata.len = sizeof(resp);
+
+	/* the queues have to hold all the updates in flight and their responses */
+	ret = rpma_conn_cfg_new(&cfg);
+	if (ret)
+		goto err_mr_dereg;
+
+	if ((ret = rpma_conn_cfg_set_sq_size(cfg, HASH_UPDATE_QUEUE_DEPTH)) ||
+			(ret = rpma_conn_cfg_set_rq_size(cfg,
+				HASH_UPDATE_QUEUE_DEPTH)) ||
+			(ret = rpma_conn_cfg_set_cq_size(cfg,
+				2 * HASH_UPDATE_QUEUE_DEPTH)))
+		goto err_cfg_delete;
 
 	/*
 	 * Wait for an incoming connection request, accept it and wait for its
 	 * establishment.
 	 */
-	ret = server_accept_connection(ep, NULL, &pdata, &conn);
+	int nconns = 1;
+	ret = server_accept_connection(ep, cfg, &pdata, &conns[0]);
 	if (ret)
-		goto err_mr_dereg;
+		goto err_cfg_delete;
+
+	/* the client tells how many connections it is going to open */
+	struct rpma_conn_private_data req_pdata;
+	ret = rpma_conn_get_private_data(conns[0], &req_pdata);
+	if (!ret && req_pdata.ptr != NULL &&
+			req_pdata.len >= sizeof(struct hash_conn_req)) {
+		struct hash_conn_req *req = req_pdata.ptr;
+		nconns = req->nconns;
+		if (nconns < 1 || nconns > HASH_CONNS_MAX) {
+			fprintf(stderr, "invalid number of connections: %d\n",
+					nconns);
+			nconns = 1;
+		}
+	}
+
+	int accepted = 1;
+	for (; accepted < nconns; accepted++) {
+		ret = server_accept_connection(ep, cfg, &pdata,
+				&conns[accepted]);
+		if (ret)
+			break;
+	}
 
 	/*
-	 * Between the connection being established and the connection being
-	 * closed the client will perform the RDMA read.
+	 * Between the connections being established and the connections being
+	 * closed the client will perform the RDMA reads and send the updates.
 	 */
+	for (int i = 0; i < accepted; i++) {
+		if (updater_start(&updaters[i], peer, &tbl, conns[i]))
+			fprintf(stderr,
+				"cannot apply the updates of connection #%d\n",
+				i);
+	}
 
 	/*
-	 * Wait for RPMA_CONN_CLOSED, disconnect and delete the connection
-	 * structure.
+	 * Wait for RPMA_CONN_CLOSED, disconnect (what flushes the receives
+	 * the updater is waiting for) and delete the connection structures.
 	 */
-	(void) common_wait_for_conn_close_and_disconnect(&conn);
+	uint64_t applied = 0;
+	for (int i = 0; i < accepted; i++) {
+		enum rpma_conn_event conn_event = RPMA_CONN_UNDEFINED;
+		if (!rpma_conn_next_event(conns[i], &conn_event) &&
+				conn_event != RPMA_CONN_CLOSED)
+			fprintf(stderr,
+				"rpma_conn_next_event returned an unexpected event: %s\n",
+				rpma_utils_conn_event_2str(conn_event));
+		(void) rpma_conn_disconnect(conns[i]);
+		updater_stop(&updaters[i]);
+		applied += updaters[i].applied;
+		(void) rpma_conn_delete(&conns[i]);
+	}
+
+	(void) printf("updates applied: %" PRIu64 "\n", applied);
+
+err_cfg_delete:
+	(void) rpma_conn_cfg_delete(&cfg);
 
 err_mr_dereg:
 	/* deregister the memory region */
 	(void) rpma_mr_dereg(&mr);
 
+err_tbl_close:
+	hash_table_close(&tbl);
+
 err_free:
 #ifdef USE_PMEM
 	if (mem.is_pmem) {
@@ -29,28 +29,47 @@
 #include "common-hello.h"
 #include "common-map_file_with_signature_check.h"
 #include "common-pmem_map_file.h"
+#include "hashlookup.h"
 
 #define MAX_LINE_LENGTH 50
 #define KEY_NUMBERS 1000000
-#define TABLE_SIZE   21 // 2097152 buckets
-#define HOP_NUMBER   32
 
 /* Arguments to pass to thread function */
 typedef struct _thread_data_t {
   int tid;
-  char **keys;
-  int threadgroup;
+  char **keys;		/* the keys routed to the server of the thread */
   int start;
   int end;
   struct rpma_peer *peer;
 
+  /*
+   * every thread opens its own connection to addr:port (unless conn is
+   * already connected) and the server has to serve the map_epoch version
+   * of the shard map
+   */
+  const char *addr;
+  const char *port;
   struct rpma_conn *conn;
-  //struct rpma_mr_local *dst_mr;
-  struct rpma_mr_remote *src_mr;
-  //void *dst_ptr;
+  uint32_t map_epoch;
+  int nconns;
+  int queue_depth;
+  enum lookup_mode mode;
+
+  /* the cache shared by all the threads (or NULL) and the index of the server */
+  struct hash_cache *cache;
+  uint32_t server;
+
+  /* the multi-gets of batch keys on all the servers of the map (if batch > 0) */
+  const struct shard_map *map;
+  int batch;
+
+  /* results */
+  struct lookup_stats stats;
+  int ret;
 } thread_data_t;
 
 
 typedef struct _thread_data_t thread_data_t;
 void *thr_func(void *arg);
+void *mget_thr_func(void *arg);
 #endif /* _HASHTHREAD_H */
\ No newline at end of file
@@ -0,0 +1,671 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * hashupdate.c -- the updates of the hash table applied by the server
+ *
+ * The table is read by the clients with one-sided RDMA reads while it is
+ * modified, so every modified bucket is enclosed in a bump of its version
+ * (see hashformat.h) and a key is never absent from the table while it is
+ * moved: it is stored in the new bucket before it is removed from the old
+ * one. Every step changing the keys of a home bucket is enclosed in a bump
+ * of the version of the home bucket too.
+ *
+ * An insert which does not fit into the neighbourhood of its home bucket
+ * starts the growth of the table into the next array of twice as many home
+ * buckets placed in the free space behind the current one (see hashformat.h).
+ * From then on every update moves the keys of the home bucket of its key
+ * and of the next HASH_MIGRATE_STEP home buckets in order to the next array
+ * before it is applied to the next array. The keys of a home bucket are
+ * stored in the next array before the old home bucket is marked as moved
+ * and only then they are removed from the current array. When the last home
+ * bucket is moved, the next array becomes the current one. The space of
+ * the old arrays is not reused, so the memory of the table has to hold all
+ * the arrays the table grows through.
+ *
+ * Every modified bucket is persisted when it is complete. A crash can leave
+ * odd versions, a half-moved key or a half-moved home bucket behind, which
+ * are fixed up by hash_table_open().
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "hashupdate.h"
+#include "hopscotch.h"
+
+/* the home buckets moved to the next array by every update of a growth */
+#define HASH_MIGRATE_STEP	64
+
+/*
+ * bucket_begin -- mark the bucket as modified (make its version odd)
+ */
+static void
+bucket_begin(struct hash_bucket *b)
+{
+	uint64_t v = le64toh(b->version);
+
+	__atomic_store_n(&b->version, htole64(v + 1), __ATOMIC_RELAXED);
+	/* the odd version has to be visible before any of the changes */
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+/*
+ * bucket_end -- mark the modification of the bucket as complete (make its
+ * version even again) and persist the bucket
+ */
+static void
+bucket_end(struct hash_table *tbl, struct hash_bucket *b)
+{
+	uint64_t v = le64toh(b->version);
+
+	__atomic_store_n(&b->version, htole64(v + 1), __ATOMIC_RELEASE);
+	tbl->persist(b, sizeof(*b));
+}
+
+/*
+ * bucket_clear -- remove the key and the value from the bucket
+ * (hopinfo and the version describe the bucket itself so they stay in place)
+ */
+static void
+bucket_clear(struct hash_bucket *b)
+{
+	b->key_len = 0;
+	b->val_len = 0;
+	b->fingerprint = 0;
+	memset(b->key, 0, sizeof(b->key));
+	memset(b->val, 0, sizeof(b->val));
+}
+
+/*
+ * hopinfo_set -- replace hopinfo of the home bucket
+ */
+static void
+hopinfo_set(struct hash_bucket *home, uint32_t hopinfo)
+{
+	__atomic_store_n(&home->hopinfo, htole32(hopinfo), __ATOMIC_RELAXED);
+}
+
+/*
+ * bucket_move -- move the key of the home bucket from the bucket src to
+ * the empty bucket dst (both in the neighbourhood of the home bucket)
+ */
+static void
+bucket_move(struct hash_table *tbl, struct hash_bucket *home,
+		struct hash_bucket *src, struct hash_bucket *dst)
+{
+	uint32_t hopinfo = hash_bucket_hopinfo(home);
+
+	bucket_begin(home);
+
+	/* store the key in the new bucket... */
+	bucket_begin(dst);
+	memcpy(dst->key, src->key, sizeof(dst->key));
+	memcpy(dst->val, src->val, sizeof(dst->val));
+	dst->fingerprint = src->fingerprint;
+	dst->val_len = src->val_len;
+	dst->key_len = src->key_len;
+	bucket_end(tbl, dst);
+
+	hopinfo |= 1U << (dst - home);
+	hopinfo_set(home, hopinfo);
+	tbl->persist(home, sizeof(*home));
+
+	/* ... and only then remove it from the old one */
+	if (src != home)
+		bucket_begin(src);
+	bucket_clear(src);
+	if (src != home)
+		bucket_end(tbl, src);
+
+	hopinfo &= ~(1U << (src - home));
+	hopinfo_set(home, hopinfo);
+
+	bucket_end(tbl, home);
+}
+
+/*
+ * bucket_find -- find the bucket holding the key among the neighbourhood
+ * of the home bucket
+ */
+static struct hash_bucket *
+bucket_find(struct hash_bucket *home, const char *key, size_t key_len,
+		uint16_t fingerprint)
+{
+	int i = hash_segment_find(home, hash_bucket_hopinfo(home), key,
+			key_len, fingerprint);
+
+	return i < 0 ? NULL : &home[i];
+}
+
+/*
+ * array_put -- insert the key of the hash h into the array or replace
+ * its value
+ */
+static uint32_t
+array_put(struct hash_table *tbl, struct hash_array *arr, const char *key,
+		size_t key_len, const char *val, size_t val_len, uint32_t h)
+{
+	uint16_t fingerprint = hash_fingerprint(h);
+	size_t idx = h & arr->mask;
+	struct hash_bucket *buckets = arr->buckets;
+	struct hash_bucket *home = &buckets[idx];
+	struct hash_bucket *b = bucket_find(home, key, key_len, fingerprint);
+
+	if (b != NULL) {
+		/* replace the value in place */
+		bucket_begin(home);
+		if (b != home)
+			bucket_begin(b);
+		memset(b->val, 0, sizeof(b->val));
+		memcpy(b->val, val, val_len);
+		b->val_len = (uint8_t)val_len;
+		if (b != home)
+			bucket_end(tbl, b);
+		bucket_end(tbl, home);
+
+		return HASH_UPDATE_OK;
+	}
+
+	/* linear probing to find an empty bucket */
+	size_t i = idx;
+	while (i < arr->nbuckets && buckets[i].key_len != 0)
+		i++;
+	if (i == arr->nbuckets)
+		return HASH_UPDATE_FULL;
+
+	/* move the empty bucket into the neighbourhood of the home one */
+	while (i - idx >= HASH_HOP_NUMBER) {
+		unsigned j;
+		for (j = HASH_HOP_NUMBER - 1; j > 0; j--) {
+			size_t home2 = i - j;
+			uint32_t hopinfo = hash_bucket_hopinfo(&buckets[home2]);
+			if (hopinfo == 0)
+				continue;
+
+			unsigned off = (unsigned)__builtin_ctz(hopinfo);
+			if (off >= j)
+				continue;
+
+			bucket_move(tbl, &buckets[home2], &buckets[home2 + off],
+					&buckets[i]);
+			i = home2 + off;
+			break;
+		}
+		if (j == 0)
+			return HASH_UPDATE_FULL;
+	}
+
+	/* store the key and make it visible in hopinfo of its home bucket */
+	bucket_begin(home);
+	if (&buckets[i] != home)
+		bucket_begin(&buckets[i]);
+	hash_bucket_fill(&buckets[i], key, key_len, val, val_len, fingerprint);
+	if (&buckets[i] != home)
+		bucket_end(tbl, &buckets[i]);
+	hopinfo_set(home, hash_bucket_hopinfo(home) | (1U << (i - idx)));
+	bucket_end(tbl, home);
+
+	return HASH_UPDATE_OK;
+}
+
+/*
+ * array_delete -- remove the key of the hash h from the array
+ */
+static uint32_t
+array_delete(struct hash_table *tbl, struct hash_array *arr, const char *key,
+		size_t key_len, uint32_t h)
+{
+	struct hash_bucket *home = &arr->buckets[h & arr->mask];
+	struct hash_bucket *b = bucket_find(home, key, key_len,
+			hash_fingerprint(h));
+
+	if (b == NULL)
+		return HASH_UPDATE_NOT_FOUND;
+
+	/* the key disappears from hopinfo before its bucket is cleared */
+	bucket_begin(home);
+	hopinfo_set(home, hash_bucket_hopinfo(home) & ~(1U << (b - home)));
+	if (b != home)
+		bucket_begin(b);
+	bucket_clear(b);
+	if (b != home)
+		bucket_end(tbl, b);
+	bucket_end(tbl, home);
+
+	return HASH_UPDATE_OK;
+}
+
+/*
+ * array_init -- describe the array of 2^exponent home buckets starting
+ * at the given offset of the table
+ */
+static void
+array_init(struct hash_table *tbl, struct hash_array *arr, uint64_t offset,
+		uint32_t exponent)
+{
+	arr->buckets = (struct hash_bucket *)((char *)tbl->hdr + offset);
+	arr->mask = (1ULL << exponent) - 1;
+	arr->nbuckets = (1ULL << exponent) + HASH_HOP_NUMBER - 1;
+}
+
+/*
+ * array_offset -- the offset of the array from the table start
+ */
+static uint64_t
+array_offset(struct hash_table *tbl, const struct hash_array *arr)
+{
+	return (uint64_t)((char *)arr->buckets - (char *)tbl->hdr);
+}
+
+/*
+ * header_write -- write the new contents of the header, its copy first,
+ * so one of them is valid whenever the write is interrupted
+ */
+static void
+header_write(struct hash_table *tbl, const struct hash_header *hdr)
+{
+	struct hash_header *backup = (struct hash_header *)
+			((char *)tbl->hdr + HASH_HEADER_BACKUP_OFFSET);
+
+	memcpy(backup, hdr, sizeof(*backup));
+	tbl->persist(backup, sizeof(*backup));
+	memcpy(tbl->hdr, hdr, sizeof(*tbl->hdr));
+	tbl->persist(tbl->hdr, sizeof(*tbl->hdr));
+}
+
+/*
+ * header_set_layout -- publish the exponent and the arrays of the table
+ */
+static void
+header_set_layout(struct hash_table *tbl, uint32_t exponent,
+		uint64_t buckets, uint64_t next)
+{
+	struct hash_header hdr = *tbl->hdr;
+
+	hash_header_set_layout(&hdr, exponent, buckets, next);
+	header_write(tbl, &hdr);
+}
+
+/*
+ * home_moved -- check if the keys of the home bucket were moved
+ * to the next array
+ */
+static int
+home_moved(const struct hash_bucket *home)
+{
+	return !!(le64toh(home->version) & HASH_VERSION_MOVED);
+}
+
+/*
+ * home_migrate -- move the keys of the home bucket of the current array
+ * to the next one; returns -1 if they do not fit into the next array
+ */
+static int
+home_migrate(struct hash_table *tbl, uint64_t idx)
+{
+	struct hash_bucket *home = &tbl->cur.buckets[idx];
+	uint32_t hopinfo = hash_bucket_hopinfo(home);
+
+	if (home_moved(home))
+		return 0;
+
+	/* store the keys in the next array... */
+	for (uint32_t m = hopinfo; m; m &= m - 1) {
+		struct hash_bucket *b = &home[__builtin_ctz(m)];
+		uint32_t h = _jenkins_hash((uint8_t *)b->key, b->key_len);
+		if (array_put(tbl, &tbl->next, b->key, b->key_len, b->val,
+				b->val_len, h) == HASH_UPDATE_OK)
+			continue;
+
+		/* the keys of the home bucket stay in the current array */
+		for (uint32_t r = hopinfo & ~m; r; r &= r - 1) {
+			b = &home[__builtin_ctz(r)];
+			h = _jenkins_hash((uint8_t *)b->key, b->key_len);
+			(void) array_delete(tbl, &tbl->next, b->key,
+					b->key_len, h);
+		}
+
+		return -1;
+	}
+
+	/* ... send the readers there... */
+	bucket_begin(home);
+	__atomic_store_n(&home->version,
+			htole64(le64toh(home->version) | HASH_VERSION_MOVED),
+			__ATOMIC_RELAXED);
+	tbl->persist(home, sizeof(*home));
+
+	/* ... and only then remove them from the current one */
+	for (uint32_t m = hopinfo; m; m &= m - 1) {
+		struct hash_bucket *b = &home[__builtin_ctz(m)];
+		if (b != home)
+			bucket_begin(b);
+		bucket_clear(b);
+		if (b != home)
+			bucket_end(tbl, b);
+	}
+	hopinfo_set(home, 0);
+	bucket_end(tbl, home);
+
+	return 0;
+}
+
+/*
+ * table_grow_finish -- make the next array the current one
+ */
+static void
+table_grow_finish(struct hash_table *tbl)
+{
+	header_set_layout(tbl, tbl->exponent + 1,
+			array_offset(tbl, &tbl->next), 0);
+
+	tbl->exponent++;
+	tbl->cur = tbl->next;
+	memset(&tbl->next, 0, sizeof(tbl->next));
+}
+
+/*
+ * table_migrate -- move the keys of up to n home buckets following
+ * the ones moved already and finish the growth after the last one
+ */
+static void
+table_migrate(struct hash_table *tbl, uint64_t n)
+{
+	for (; n > 0 && tbl->migrated <= tbl->cur.mask; n--) {
+		/* the growth is stuck at a home bucket not fitting */
+		if (home_migrate(tbl, tbl->migrated))
+			return;
+		tbl->migrated++;
+	}
+
+	if (tbl->migrated > tbl->cur.mask)
+		table_grow_finish(tbl);
+}
+
+/*
+ * table_grow_start -- start the growth of the table into the zeroed next
+ * array placed behind the current one; returns -1 if it does not fit
+ */
+static int
+table_grow_start(struct hash_table *tbl)
+{
+	uint32_t exponent = tbl->exponent + 1;
+	uint64_t next = array_offset(tbl, &tbl->cur) +
+			hash_buckets_size(tbl->exponent);
+
+	/* the arrays start at the page boundaries as the first one does */
+	next = (next + HASH_HEADER_SIZE - 1) &
+			~((uint64_t)HASH_HEADER_SIZE - 1);
+	if (exponent > HASH_EXPONENT_MAX ||
+			next + hash_buckets_size(exponent) > tbl->size)
+		return -1;
+
+	/* the next array is visible to the readers only once it is empty */
+	array_init(tbl, &tbl->next, next, exponent);
+	memset(tbl->next.buckets, 0, hash_buckets_size(exponent));
+	tbl->persist(tbl->next.buckets, hash_buckets_size(exponent));
+	tbl->migrated = 0;
+
+	header_set_layout(tbl, tbl->exponent, array_offset(tbl, &tbl->cur),
+			next);
+
+	(void) printf("growing the hash table to 2^%u home buckets\n",
+			exponent);
+
+	return 0;
+}
+
+/*
+ * table_array -- get the array the update of the key of the hash h has
+ * to be applied to; the growth in progress is moved forward first
+ */
+static struct hash_array *
+table_array(struct hash_table *tbl, uint32_t h)
+{
+	if (tbl->next.buckets == NULL)
+		return &tbl->cur;
+
+	/* the keys of the home bucket stay where they are if they do not fit */
+	if (home_migrate(tbl, h & tbl->cur.mask))
+		return &tbl->cur;
+
+	table_migrate(tbl, HASH_MIGRATE_STEP);
+
+	return tbl->next.buckets != NULL ? &tbl->next : &tbl->cur;
+}
+
+/*
+ * table_put -- insert the key or replace its value; the table is grown
+ * if the key does not fit
+ */
+static uint32_t
+table_put(struct hash_table *tbl, const char *key, size_t key_len,
+		const char *val, size_t val_len)
+{
+	uint32_t h = _jenkins_hash((uint8_t *)key, key_len);
+	uint32_t status = array_put(tbl, table_array(tbl, h), key, key_len,
+			val, val_len, h);
+
+	if (status != HASH_UPDATE_FULL || tbl->next.buckets != NULL ||
+			table_grow_start(tbl))
+		return status;
+
+	return array_put(tbl, table_array(tbl, h), key, key_len, val,
+			val_len, h);
+}
+
+/*
+ * table_delete -- remove the key
+ */
+static uint32_t
+table_delete(struct hash_table *tbl, const char *key, size_t key_len)
+{
+	uint32_t h = _jenkins_hash((uint8_t *)key, key_len);
+
+	return array_delete(tbl, table_array(tbl, h), key, key_len, h);
+}
+
+/*
+ * array_recover -- fix up what an interrupted update could have left behind
+ * in the array: odd versions, the bits of hopinfo pointing to the cleared
+ * buckets or set in the moved home buckets and the keys stored twice or not
+ * pointed by hopinfo at all (in the old and the new bucket of an interrupted
+ * move or in the home buckets which were being moved to the next array)
+ */
+static void
+array_recover(struct hash_table *tbl, struct hash_array *arr)
+{
+	struct hash_bucket *buckets = arr->buckets;
+
+	for (size_t i = 0; i < arr->nbuckets; i++) {
+		uint64_t v = le64toh(buckets[i].version);
+		if (v & 1) {
+			buckets[i].version = htole64(v + 1);
+			tbl->persist(&buckets[i], sizeof(buckets[i]));
+		}
+	}
+
+	for (size_t i = 0; i <= arr->mask; i++) {
+		struct hash_bucket *home = &buckets[i];
+		uint32_t hopinfo = hash_bucket_hopinfo(home);
+		uint32_t fixed = home_moved(home) ? 0 : hopinfo;
+
+		for (uint32_t m = fixed; m; m &= m - 1) {
+			unsigned n = (unsigned)__builtin_ctz(m);
+			const struct hash_bucket *b = &home[n];
+
+			/* a bit of the bucket which was already cleared */
+			if (b->key_len == 0) {
+				fixed &= ~(1U << n);
+				continue;
+			}
+
+			/* the later copy of a key is the one which was moved */
+			int first = hash_segment_find(home, hopinfo, b->key,
+					b->key_len, le16toh(b->fingerprint));
+			if (first >= 0 && (unsigned)first < n) {
+				bucket_clear(&home[first]);
+				tbl->persist(&home[first], sizeof(home[first]));
+				fixed &= ~(1U << first);
+			}
+		}
+
+		if (fixed != hopinfo) {
+			hopinfo_set(home, fixed);
+			tbl->persist(home, sizeof(*home));
+		}
+	}
+
+	/* the new copy of a key whose move was interrupted before it was set */
+	for (size_t i = 0; i < arr->nbuckets; i++) {
+		struct hash_bucket *b = &buckets[i];
+		if (b->key_len == 0)
+			continue;
+
+		size_t idx = _jenkins_hash((uint8_t *)b->key, b->key_len) &
+				arr->mask;
+		if (i < idx || i - idx >= HASH_HOP_NUMBER ||
+				!(hash_bucket_hopinfo(&buckets[idx]) &
+				(1U << (i - idx)))) {
+			bucket_clear(b);
+			tbl->persist(b, sizeof(*b));
+		}
+	}
+}
+
+/*
+ * hash_table_recover -- fix up both of the arrays of the table and drop
+ * the keys stored in the next array by the interrupted moves of the home
+ * buckets which are not marked as moved, so they stay in the current one
+ */
+static void
+hash_table_recover(struct hash_table *tbl)
+{
+	array_recover(tbl, &tbl->cur);
+	if (tbl->next.buckets == NULL)
+		return;
+
+	array_recover(tbl, &tbl->next);
+
+	for (size_t j = 0; j <= tbl->next.mask; j++) {
+		struct hash_bucket *home = &tbl->next.buckets[j];
+		struct hash_bucket *old = &tbl->cur.buckets[j & tbl->cur.mask];
+		uint32_t hopinfo = hash_bucket_hopinfo(home);
+		if (hopinfo == 0 || home_moved(old))
+			continue;
+
+		for (uint32_t m = hopinfo; m; m &= m - 1) {
+			struct hash_bucket *b = &home[__builtin_ctz(m)];
+			bucket_clear(b);
+			tbl->persist(b, sizeof(*b));
+		}
+		hopinfo_set(home, 0);
+		tbl->persist(home, sizeof(*home));
+	}
+
+	/* the growth continues from the first home bucket not moved yet */
+	while (tbl->migrated <= tbl->cur.mask &&
+			home_moved(&tbl->cur.buckets[tbl->migrated]))
+		tbl->migrated++;
+	if (tbl->migrated > tbl->cur.mask)
+		table_grow_finish(tbl);
+}
+
+/*
+ * hash_table_open -- open the table at addr for updates, recover it and mark
+ * it as updated while served (HASH_F_UPDATES); returns -1 if the table
+ * is not valid
+ */
+int
+hash_table_open(struct hash_table *tbl, void *addr, size_t size,
+		hash_persist_fn persist)
+{
+	struct hash_header *hdr = addr;
+	struct hash_header *backup = (struct hash_header *)
+			((char *)addr + HASH_HEADER_BACKUP_OFFSET);
+	uint32_t exponent;
+
+	if (size < HASH_HEADER_SIZE)
+		return -1;
+
+	/* the header torn by a crash is restored from its copy */
+	if (hash_header_check(hdr, &exponent)) {
+		if (hash_header_check(backup, &exponent))
+			return -1;
+		memcpy(hdr, backup, sizeof(*hdr));
+		persist(hdr, sizeof(*hdr));
+	}
+
+	if (size < hash_header_end(hdr))
+		return -1;
+
+	memset(tbl, 0, sizeof(*tbl));
+	if (pthread_mutex_init(&tbl->lock, NULL))
+		return -1;
+
+	tbl->hdr = hdr;
+	tbl->size = size;
+	tbl->exponent = exponent;
+	tbl->persist = persist;
+	array_init(tbl, &tbl->cur, hash_header_buckets(hdr), exponent);
+	if (hash_header_next(hdr) != 0)
+		array_init(tbl, &tbl->next, hash_header_next(hdr),
+				exponent + 1);
+
+	hash_table_recover(tbl);
+
+	/* the clients have to validate what they read from now on */
+	if (!(hash_header_flags(hdr) & HASH_F_UPDATES)) {
+		struct hash_header updated = *hdr;
+		hash_header_set_flags(&updated,
+				hash_header_flags(hdr) | HASH_F_UPDATES);
+		header_write(tbl, &updated);
+	}
+
+	return 0;
+}
+
+/*
+ * hash_table_close -- release the resources of the table
+ */
+void
+hash_table_close(struct hash_table *tbl)
+{
+	(void) pthread_mutex_destroy(&tbl->lock);
+}
+
+/*
+ * hash_table_apply -- apply the update and return its status
+ * (enum hash_update_status)
+ */
+uint32_t
+hash_table_apply(struct hash_table *tbl, const struct hash_update_req *req)
+{
+	size_t key_len = strnlen(req->key, req->key_len < HASH_KEY_MAX ?
+			req->key_len : HASH_KEY_MAX);
+	uint32_t status;
+
+	if (key_len == 0 || key_len != req->key_len ||
+			req->val_len > HASH_VAL_MAX)
+		return HASH_UPDATE_INVALID;
+
+	pthread_mutex_lock(&tbl->lock);
+
+	switch (req->op) {
+	case HASH_UPDATE_PUT:
+		status = table_put(tbl, req->key, key_len, req->val,
+				req->val_len);
+		break;
+	case HASH_UPDATE_DELETE:
+		status = table_delete(tbl, req->key, key_len);
+		break;
+	default:
+		status = HASH_UPDATE_INVALID;
+		break;
+	}
+
+	pthread_mutex_unlock(&tbl->lock);
+
+	return status;
+}
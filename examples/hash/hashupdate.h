@@ -0,0 +1,56 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * hashupdate.h -- the updates of the hash table applied by the server
+ */
+
+#ifndef _HASHUPDATE_H
+#define _HASHUPDATE_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "hashformat.h"
+#include "hashproto.h"
+
+/* an array of the buckets of the table */
+struct hash_array {
+	struct hash_bucket *buckets;	/* NULL if there is no such array */
+	uint64_t mask;		/* 2^exponent - 1 */
+	size_t nbuckets;	/* the home buckets and the tail ones */
+};
+
+struct hash_table {
+	struct hash_header *hdr;
+	size_t size;		/* the size of the memory of the table */
+	uint32_t exponent;	/* of the current array */
+	struct hash_array cur;	/* the array the keys are stored in */
+	struct hash_array next;	/* the array the table is grown into */
+	uint64_t migrated;	/* the home buckets of cur moved in order */
+	hash_persist_fn persist;
+	pthread_mutex_t lock;	/* serializes the writers */
+};
+
+/*
+ * hash_table_open -- open the table at addr for updates, recover it and mark
+ * it as updated while served (HASH_F_UPDATES); the table can grow up to
+ * the given size; returns -1 if the table is not valid
+ */
+int hash_table_open(struct hash_table *tbl, void *addr, size_t size,
+		hash_persist_fn persist);
+
+/*
+ * hash_table_close -- release the resources of the table
+ */
+void hash_table_close(struct hash_table *tbl);
+
+/*
+ * hash_table_apply -- apply the update and return its status
+ * (enum hash_update_status)
+ */
+uint32_t hash_table_apply(struct hash_table *tbl,
+		const struct hash_update_req *req);
+
+#endif /* _HASHUPDATE_H */
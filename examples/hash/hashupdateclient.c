@@ -0,0 +1,277 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * hashupdateclient.c -- a client that sends the updates of a YCSB trace
+ * to the hash server
+ *
+ * The INSERT and UPDATE commands of the trace are sent as PUT updates (with
+ * the key used as the value, as writehash does) and the DELETE commands as
+ * DELETE updates; the other commands are skipped. Up to
+ * HASH_UPDATE_QUEUE_DEPTH updates are kept in flight - every one of them has
+ * its own slot of a request and a response buffer and the receive of its
+ * response is posted before the request is sent. The server answers
+ * the updates of a connection in order, so the response of an update is
+ * received into its own slot.
+ */
+
+#include <inttypes.h>
+#include <librpma.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "common-conn.h"
+#include "hashproto.h"
+
+#define MAX_LINE_LENGTH 50
+#define KEY_NUMBERS 1000000
+
+#define USAGE_STR "usage: %s <trace_path> <server_address> <port>\n"
+
+/* the request buffers followed by the response buffers */
+#define REQ_OFFSET(i)	((i) * sizeof(struct hash_update_req))
+#define RESP_OFFSET(i)	(HASH_UPDATE_QUEUE_DEPTH * \
+		sizeof(struct hash_update_req) + \
+		(i) * sizeof(struct hash_update_resp))
+#define MSG_SIZE	RESP_OFFSET(HASH_UPDATE_QUEUE_DEPTH)
+
+/*
+ * parse_update -- parse the "cmd key" line of the trace into the update;
+ * returns -1 if the line does not describe an update
+ */
+static int
+parse_update(char *line, struct hash_update_req *req)
+{
+	/* delimiters for input file: cmd key (the key without the newline) */
+	const char s[] = " \r\n";
+	char *cmd = strtok(line, s);
+	char *key = strtok(NULL, s);
+
+	if (cmd == NULL || key == NULL)
+		return -1;
+
+	memset(req, 0, sizeof(*req));
+	if (strcmp(cmd, "INSERT") == 0 || strcmp(cmd, "UPDATE") == 0)
+		req->op = HASH_UPDATE_PUT;
+	else if (strcmp(cmd, "DELETE") == 0)
+		req->op = HASH_UPDATE_DELETE;
+	else
+		return -1;
+
+	req->key_len = (uint8_t)strnlen(key, HASH_KEY_MAX);
+	memcpy(req->key, key, req->key_len);
+	if (req->op == HASH_UPDATE_PUT) {
+		req->val_len = req->key_len;
+		memcpy(req->val, key, req->val_len);
+	}
+
+	return 0;
+}
+
+int
+main(int argc, char *argv[])
+{
+	/* validate parameters */
+	if (argc < 4) {
+		fprintf(stderr, USAGE_STR, argv[0]);
+		exit(-1);
+	}
+
+	/* YCSB trace file */
+	char *path = argv[1];
+	char line[MAX_LINE_LENGTH] = {0};
+	size_t nupdates = 0;
+
+	struct hash_update_req *updates = calloc(KEY_NUMBERS,
+			sizeof(*updates));
+	if (updates == NULL) {
+		perror("calloc");
+		exit(1);
+	}
+
+	/* Open file */
+	FILE *file = fopen(path, "r");
+	if (!file) {
+		perror(path);
+		free(updates);
+		exit(1);
+	}
+
+	/* Get each line until there are none left */
+	while (fgets(line, MAX_LINE_LENGTH, file) && nupdates < KEY_NUMBERS) {
+		if (parse_update(line, &updates[nupdates]))
+			continue;
+		updates[nupdates].id = (uint32_t)nupdates;
+		nupdates++;
+	}
+	(void) fclose(file);
+
+	/* configure logging thresholds to see more details */
+	rpma_log_set_threshold(RPMA_LOG_THRESHOLD, RPMA_LOG_LEVEL_INFO);
+	rpma_log_set_threshold(RPMA_LOG_THRESHOLD_AUX, RPMA_LOG_LEVEL_INFO);
+
+	/* parameters for remote machine */
+	char *addr = argv[2];
+	char *port = argv[3];
+	int ret;
+
+	/* resources - general */
+	struct rpma_peer *peer = NULL;
+	struct rpma_conn_cfg *cfg = NULL;
+	struct rpma_conn *conn = NULL;
+	struct rpma_cq *cq = NULL;
+
+	/* resources - the request and the response buffers */
+	char *msg_ptr = NULL;
+	struct rpma_mr_local *msg_mr = NULL;
+
+	/*
+	 * lookup an ibv_context via the address and create a new peer using it
+	 */
+	ret = client_peer_via_address(addr, &peer);
+	if (ret)
+		goto err_free_updates;
+
+	msg_ptr = malloc_aligned(MSG_SIZE);
+	if (msg_ptr == NULL) {
+		ret = -1;
+		goto err_peer_delete;
+	}
+
+	ret = rpma_mr_reg(peer, msg_ptr, MSG_SIZE,
+			RPMA_MR_USAGE_SEND | RPMA_MR_USAGE_RECV, &msg_mr);
+	if (ret)
+		goto err_free_msg;
+
+	/* the queues have to fit all the updates in flight */
+	ret = rpma_conn_cfg_new(&cfg);
+	if (ret)
+		goto err_mr_dereg;
+
+	if ((ret = rpma_conn_cfg_set_sq_size(cfg, HASH_UPDATE_QUEUE_DEPTH)) ||
+			(ret = rpma_conn_cfg_set_rq_size(cfg,
+				HASH_UPDATE_QUEUE_DEPTH)) ||
+			(ret = rpma_conn_cfg_set_cq_size(cfg,
+				2 * HASH_UPDATE_QUEUE_DEPTH)))
+		goto err_cfg_delete;
+
+	/* establish a new connection to a server listening at addr:port */
+	ret = client_connect(peer, addr, port, cfg, NULL, &conn);
+	if (ret)
+		goto err_cfg_delete;
+
+	ret = rpma_conn_get_cq(conn, &cq);
+	if (ret)
+		goto err_conn_disconnect;
+
+	/* send all the updates keeping up to HASH_UPDATE_QUEUE_DEPTH in flight */
+	uint64_t status[HASH_UPDATE_INVALID + 1] = {0};
+	uint32_t slot_update[HASH_UPDATE_QUEUE_DEPTH];
+	uintptr_t free_slots[HASH_UPDATE_QUEUE_DEPTH];
+	int nfree = 0;
+	size_t next = 0;
+	size_t done = 0;
+	struct ibv_wc wc[HASH_UPDATE_QUEUE_DEPTH];
+	struct timespec t_start, t_end;
+
+	for (uintptr_t i = 0; i < HASH_UPDATE_QUEUE_DEPTH; i++)
+		free_slots[nfree++] = i;
+
+	clock_gettime(CLOCK_MONOTONIC, &t_start);
+
+	while (done < nupdates) {
+		while (nfree > 0 && next < nupdates) {
+			uintptr_t slot = free_slots[--nfree];
+
+			memcpy(msg_ptr + REQ_OFFSET(slot), &updates[next],
+					sizeof(updates[next]));
+			slot_update[slot] = updates[next].id;
+
+			ret = rpma_recv(conn, msg_mr, RESP_OFFSET(slot),
+					sizeof(struct hash_update_resp),
+					(void *)slot);
+			if (ret)
+				goto err_conn_disconnect;
+
+			/* the request is complete once its response arrives */
+			ret = rpma_send(conn, msg_mr, REQ_OFFSET(slot),
+					sizeof(struct hash_update_req),
+					RPMA_F_COMPLETION_ON_ERROR, (void *)slot);
+			if (ret)
+				goto err_conn_disconnect;
+
+			next++;
+		}
+
+		int num_got = 0;
+		ret = rpma_cq_get_wc(cq, HASH_UPDATE_QUEUE_DEPTH, wc, &num_got);
+		if (ret == RPMA_E_NO_COMPLETION)
+			continue;
+		if (ret)
+			goto err_conn_disconnect;
+
+		for (int i = 0; i < num_got; i++) {
+			if (wc[i].status != IBV_WC_SUCCESS) {
+				(void) fprintf(stderr, "%s failed: %s\n",
+					wc[i].opcode == IBV_WC_RECV ?
+					"rpma_recv()" : "rpma_send()",
+					ibv_wc_status_str(wc[i].status));
+				ret = -1;
+				goto err_conn_disconnect;
+			}
+
+			uintptr_t slot = (uintptr_t)wc[i].wr_id;
+			struct hash_update_resp *resp =
+				(struct hash_update_resp *)
+				(msg_ptr + RESP_OFFSET(slot));
+
+			if (resp->id != slot_update[slot] ||
+					resp->status > HASH_UPDATE_INVALID) {
+				(void) fprintf(stderr,
+					"unexpected response: id %" PRIu32
+					", status %" PRIu32 "\n",
+					resp->id, resp->status);
+				ret = -1;
+				goto err_conn_disconnect;
+			}
+
+			status[resp->status]++;
+			free_slots[nfree++] = slot;
+			done++;
+		}
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &t_end);
+	double elapsed = (double)(t_end.tv_sec - t_start.tv_sec) +
+			(double)(t_end.tv_nsec - t_start.tv_nsec) / 1e9;
+
+	printf("updates: %zu, ok: %" PRIu64 ", not found: %" PRIu64
+			", full: %" PRIu64 ", invalid: %" PRIu64 "\n",
+			nupdates, status[HASH_UPDATE_OK],
+			status[HASH_UPDATE_NOT_FOUND], status[HASH_UPDATE_FULL],
+			status[HASH_UPDATE_INVALID]);
+	if (elapsed > 0)
+		printf("updates/s: %.0f\n", (double)nupdates / elapsed);
+
+err_conn_disconnect:
+	(void) common_disconnect_and_wait_for_conn_close(&conn);
+
+err_cfg_delete:
+	(void) rpma_conn_cfg_delete(&cfg);
+
+err_mr_dereg:
+	(void) rpma_mr_dereg(&msg_mr);
+
+err_free_msg:
+	free(msg_ptr);
+
+err_peer_delete:
+	/* delete the peer */
+	(void) rpma_peer_delete(&peer);
+
+err_free_updates:
+	free(updates);
+
+	return ret;
+}
@@ -7,9 +7,10 @@
 
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
-/* Initial size of the hopscotch table. 2^ TABLE_SIZE buckets allocated. */
-#define TABLE_SIZE   21 // 2097152 buckets
+/* Default initial size of the hopscotch table. 2^ exponent buckets allocated. */
+#define HOPSCOTCH_INIT_EXPONENT   21 // 2097152 buckets
 /* Bitmap size used for linear probing in hopscotch hashing */
 #define HOP_NUMBER   32
 
@@ -38,12 +39,14 @@ struct hopscotch_hash_table {
 /*
 * Murmur hash
 */
-uint32_t MurmurOAAT_32(const char* str, uint32_t h)
+static __inline__ uint32_t
+MurmurOAAT_32(const char* str, uint32_t h)
 {
     // One-byte-at-a-time hash based on Murmur's mix
     // Source: https://github.com/aappleby/smhasher/blob/master/src/Hashes.cpp
     for (; *str; ++str) {
-        h ^= *str;
+        int32_t c = *str;
+        h ^= (uint32_t)c;
         h *= 0x5bd1e995;
         h ^= h >> 15;
     }
@@ -52,14 +55,14 @@ uint32_t MurmurOAAT_32(const char* str, uint32_t h)
 
 /* djb2 hash
 */
-uint32_t
+static __inline__ uint32_t
 djhash(uint8_t *str)
 {
     uint32_t hash = 5381;
     int c;
 
-    while (c = *str++)
-        hash = ((hash << 5) + hash) + c; /* hash * 33 + c */
+    while ((c = *str++))
+        hash = ((hash << 5) + hash) + (uint32_t)c; /* hash * 33 + c */
 
     return hash;
 }
@@ -88,25 +91,32 @@ _jenkins_hash(uint8_t *key, size_t len)
 }
 
 /*
- * Initialize the hash table
+ * Allocate zeroed buckets
  */
-struct hopscotch_hash_table *
-hopscotch_init(struct hopscotch_hash_table *ht, size_t keylen)
+static __inline__ struct hopscotch_bucket *
+_hopscotch_buckets_new(size_t exponent)
+{
+    return calloc(1ULL << exponent, sizeof(struct hopscotch_bucket));
+}
+
+/*
+ * Initialize the hash table of 2^exponent buckets
+ */
+static __inline__ struct hopscotch_hash_table *
+hopscotch_init(struct hopscotch_hash_table *ht, size_t exponent, size_t keylen)
 {
-    int exponent;
     struct hopscotch_bucket *buckets;
 
     /* Allocate buckets first */
-    exponent = TABLE_SIZE;
-    buckets = malloc(sizeof(struct hopscotch_bucket) * (1 << exponent));
+    buckets = _hopscotch_buckets_new(exponent);
     if ( NULL == buckets ) {
         return NULL;
     }
-    memset(buckets, 0, sizeof(struct hopscotch_bucket) * (1 << exponent));
 
     if ( NULL == ht ) {
         ht = malloc(sizeof(struct hopscotch_hash_table));
         if ( NULL == ht ) {
+            free(buckets);
             return NULL;
         }
         ht->_allocated = 1;
@@ -123,7 +133,7 @@ hopscotch_init(struct hopscotch_hash_table *ht, size_t keylen)
 /*
  * Release the hash table
  */
-void
+static __inline__ void
 hopscotch_release(struct hopscotch_hash_table *ht)
 {
     free(ht->buckets);
@@ -132,40 +142,35 @@ hopscotch_release(struct hopscotch_hash_table *ht)
     }
 }
 
+/*
+ * Hash of the key
+ */
+static __inline__ uint32_t
+_hopscotch_hash(struct hopscotch_hash_table *ht, char *key)
+{
+    return _jenkins_hash((uint8_t *)key, strnlen(key, ht->keylen));
+}
 
 /*
- * Lookup
+ * Find the bucket of the key among the 2^exponent buckets
  */
-void *
-hopscotch_lookup(struct hopscotch_hash_table *ht, char *key)
+static __inline__ struct hopscotch_bucket *
+_hopscotch_find(struct hopscotch_hash_table *ht,
+    struct hopscotch_bucket *buckets, size_t exponent, char *key)
 {
-    uint32_t h;
     size_t idx;
     size_t i;
-    size_t sz;
 
-    sz = 1ULL << ht->exponent;
-    //h = MurmurOAAT_32(key, SEED);
-    h = _jenkins_hash(key, ht->keylen);
-    idx = h & (sz - 1);
-
-    
-    //printf("%s----%lu----%lu---%lu\n", key, (unsigned long)h, (unsigned long)idx, ht->buckets[idx].hopinfo);
+    idx = _hopscotch_hash(ht, key) & ((1ULL << exponent) - 1);
 
-    if ( !ht->buckets[idx].hopinfo ) {
+    if ( !buckets[idx].hopinfo ) {
         return NULL;
     }
-
-    
     for ( i = 0; i < HOP_NUMBER; i++ ) {
-        if ( ht->buckets[idx].hopinfo & (1 << i) ) {
-            if ( 0 == memcmp(key, ht->buckets[idx + i].key, ht->keylen) ) {
+        if ( buckets[idx].hopinfo & (1U << i) ) {
+            if ( 0 == strncmp(key, buckets[idx + i].key, ht->keylen) ) {
                 /* Found */
-
-              //  printf("%s----%s---%d--%lu---%lu---%lu\n", key,ht->buckets[idx + i].key, i, (unsigned long)h, (unsigned long)idx, ht->buckets[idx].hopinfo);
-
- 
-                return ht->buckets[idx + i].data;
+                return &buckets[idx + i];
             }
         }
     }
@@ -174,10 +179,24 @@ hopscotch_lookup(struct hopscotch_hash_table *ht, char *key)
 }
 
 /*
- * Insert an entry to the hash table
+ * Lookup
  */
-int
-hopscotch_insert(struct hopscotch_hash_table *ht, char *key, char *data)
+static __inline__ void *
+hopscotch_lookup(struct hopscotch_hash_table *ht, char *key)
+{
+    struct hopscotch_bucket *b;
+
+    b = _hopscotch_find(ht, ht->buckets, ht->exponent, key);
+
+    return b ? b->data : NULL;
+}
+
+/*
+ * Insert an entry to the current buckets of the hash table
+ * (the key is known not to exist)
+ */
+static __inline__ int
+_hopscotch_insert(struct hopscotch_hash_table *ht, char *key, char *data)
 {
     uint32_t h;
     size_t idx;
@@ -186,21 +205,10 @@ hopscotch_insert(struct hopscotch_hash_table *ht, char *key, char *data)
     size_t off;
     size_t j;
 
-    /* Ensure the key does not exist.  Duplicate keys are not allowed. */
-    if ( NULL != hopscotch_lookup(ht, key) ) {
-        /* The key already exists. */
-        //printf("the key exisats");
-        return -2;
-    }
-
     sz = 1ULL << ht->exponent;
-    //h = hash(key);
-    //h = MurmurOAAT_32(key, SEED);
-    h = _jenkins_hash(key, ht->keylen);
+    h = _hopscotch_hash(ht, key);
     idx = h & (sz - 1);
 
-   // printf("%lu---------%lu\n", (unsigned long)h, (unsigned long)idx);
-
     /* Linear probing to find an empty bucket */
     for ( i = idx; i < sz; i++ ) {
         if ( NULL == ht->buckets[i].key ) {
@@ -208,7 +216,7 @@ hopscotch_insert(struct hopscotch_hash_table *ht, char *key, char *data)
             while ( i - idx >= HOP_NUMBER ) {
                 for ( j = 1; j < HOP_NUMBER; j++ ) {
                     if ( ht->buckets[i - j].hopinfo ) {
-                        off = __builtin_ctz(ht->buckets[i - j].hopinfo);
+                        off = (size_t)__builtin_ctz(ht->buckets[i - j].hopinfo);
                         if ( off >= j ) {
                             continue;
                         }
@@ -223,7 +231,7 @@ hopscotch_insert(struct hopscotch_hash_table *ht, char *key, char *data)
                     }
                 }
                 if ( j >= HOP_NUMBER ) {
-                    //TODO: resize table;
+                    /* The neighbourhood is full */
                     return -3;
                 }
             }
@@ -234,8 +242,6 @@ hopscotch_insert(struct hopscotch_hash_table *ht, char *key, char *data)
             ht->buckets[idx].hopinfo |= (1ULL << off);
 
             if(ht->buckets[idx].hopinfo>32){
-                //printf("off %lu\n", off);
-                //printf("hopionfo %lu\n", ht->buckets[idx].hopinfo);
                 return -4;
             }
 
@@ -246,48 +252,54 @@ hopscotch_insert(struct hopscotch_hash_table *ht, char *key, char *data)
     return -1;
 }
 
+/*
+ * Insert an entry to the hash table; it fails with -3 when there is no space
+ * for the key in its neighbourhood (see hopscotch_resize())
+ */
+static __inline__ int
+hopscotch_insert(struct hopscotch_hash_table *ht, char *key, char *data)
+{
+    /* Ensure the key does not exist.  Duplicate keys are not allowed. */
+    if ( NULL != hopscotch_lookup(ht, key) ) {
+        /* The key already exists. */
+        return -2;
+    }
+
+    return _hopscotch_insert(ht, key, data);
+}
+
 /*
  * Remove an item
  */
-void *
+static __inline__ void *
 hopscotch_remove(struct hopscotch_hash_table *ht, char *key)
 {
-    uint32_t h;
+    struct hopscotch_bucket *buckets = ht->buckets;
+    size_t exponent = ht->exponent;
+    struct hopscotch_bucket *b;
     size_t idx;
-    size_t i;
-    size_t sz;
     char *data;
 
-    sz = 1ULL << ht->exponent;
-    h = _jenkins_hash(key, ht->keylen);
-    idx = h & (sz - 1);
-
-    if ( !ht->buckets[idx].hopinfo ) {
+    b = _hopscotch_find(ht, buckets, exponent, key);
+    if ( NULL == b ) {
         return NULL;
     }
-    for ( i = 0; i < HOP_NUMBER; i++ ) {
-        if ( ht->buckets[idx].hopinfo & (1 << i) ) {
-            if ( 0 == memcmp(key, ht->buckets[idx + i].key, ht->keylen) ) {
-                /* Found */
-                data = ht->buckets[idx + i].data;
-                ht->buckets[idx].hopinfo &= ~(1ULL << i);
-                ht->buckets[idx + i].key = NULL;
-                ht->buckets[idx + i].data = NULL;
-                return data;
-            }
-        }
-    }
 
-    return NULL;
+    idx = _hopscotch_hash(ht, key) & ((1ULL << exponent) - 1);
+    data = b->data;
+    buckets[idx].hopinfo &= ~(1ULL << (b - &buckets[idx]));
+    b->key = NULL;
+    b->data = NULL;
+
+    return data;
 }
 
 /*
- * Resize the bucket size of the hash table
+ * Resize the bucket size of the hash table at once
  */
-int
+static __inline__ int
 hopscotch_resize(struct hopscotch_hash_table *ht, int delta)
 {
-    size_t sz;
     size_t oexp;
     size_t nexp;
     ssize_t i;
@@ -296,14 +308,12 @@ hopscotch_resize(struct hopscotch_hash_table *ht, int delta)
     int ret;
 
     oexp = ht->exponent;
-    nexp = ht->exponent + delta;
-    sz = 1ULL << nexp;
+    nexp = (size_t)((ssize_t)ht->exponent + delta);
 
-    nbuckets = malloc(sizeof(struct hopscotch_bucket) * sz);
+    nbuckets = _hopscotch_buckets_new(nexp);
     if ( NULL == nbuckets ) {
         return -1;
     }
-    memset(nbuckets, 0, sizeof(struct hopscotch_bucket) * sz);
     obuckets = ht->buckets;
 
     ht->buckets = nbuckets;
@@ -311,8 +321,8 @@ hopscotch_resize(struct hopscotch_hash_table *ht, int delta)
 
     for ( i = 0; i < (1LL << oexp); i++ ) {
         if ( obuckets[i].key ) {
-            ret = hopscotch_insert(ht, obuckets[i].key, obuckets[i].data);
-            if ( ret < 0 ) {
+            ret = _hopscotch_insert(ht, obuckets[i].key, obuckets[i].data);
+            if ( ret < 0 && ret != -4 ) {
                 ht->buckets = obuckets;
                 ht->exponent = oexp;
                 free(nbuckets);
@@ -325,4 +335,4 @@ hopscotch_resize(struct hopscotch_hash_table *ht, int delta)
     return 0;
 }
 
-#endif /* _HOPSCOTCH_H */
\ No newline at end of file
+#endif /* _HOPSCOTCH_H */
@@ -1,11 +1,24 @@
 /*
  * multihashclient.c -- a multithreaded client that fetches hashtable parts from servers
  *
+ * The client connects to the given (seed) server first and reads the shard
+ * map the server publishes (see shardmap.h). Every key is routed to one of
+ * the servers of the map and NUM_THREADS threads per server look up the keys
+ * routed to it. A seed server publishing no shard map is the only server.
+ * All the threads share the optional cache of the segments (see hashcache.h)
+ * in which the tables of the servers are told apart by the server indexes.
+ *
+ * In the multi-get mode (<batch> > 0) every thread connects to all
+ * the servers instead and looks up its share of the keys, in the order
+ * of the trace, with the multi-gets of <batch> keys (see hashmget.h).
  */
 
 
-#include "hopscotch.h"
+#include "hashcache.h"
+#include "hashmget.h"
+#include "hashproto.h"
 #include "hashthread.h"
+#include "shardmap.h"
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <stdlib.h>
@@ -28,414 +41,564 @@
 #include "common-hello.h"
 #include "common-map_file_with_signature_check.h"
 #include "common-pmem_map_file.h"
-#include <stdatomic.h>
 
 #define MAX_LINE_LENGTH 50
 #define KEY_NUMBERS 1000000
-#define TABLE_SIZE   21 // 2097152 buckets
-#define HOP_NUMBER   32
 #define NUM_THREADS 2
 
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
 
-#ifdef USE_PMEM
-#define USAGE_STR "usage: %s <keysfile_path> <server_count> <server_address> <port> [<pmem-path>]\n"PMEM_USAGE
-#else
-#define USAGE_STR "usage: %s <keysfile_path> <server_count> <server_address> <port>\n"
-#endif /* USE_PMEM */
+#define USAGE_STR "usage: %s <keysfile_path> <server_address> <port> [<queue_depth> [<mode> [<cache_MiB> [<batch>]]]]\n" \
+	"where <mode> is segment, two-phase or adaptive (segment by default),\n" \
+	"<cache_MiB> is the size of the cache of the segments (none by default)\n" \
+	"and <batch> is the number of the keys of a multi-get (0 - no multi-gets, by default)\n"
 
-atomic_int cnt;
+/*
+ * server_connect -- open a connection to the server listening at addr:port
+ * announcing the number of the connections the client opens to it
+ */
+static int
+server_connect(struct rpma_peer *peer, const char *addr, const char *port,
+		int nconns, int queue_depth, struct rpma_conn **conn_ptr)
+{
+	struct rpma_conn_cfg *cfg = NULL;
+	int ret;
 
-void *thr_func(void *arg)
+	/* the queues have to fit all the lookups in flight */
+	ret = rpma_conn_cfg_new(&cfg);
+	if (ret)
+		return ret;
+
+	ret = rpma_conn_cfg_set_sq_size(cfg,
+			(uint32_t)LOOKUP_SQ_SIZE(queue_depth));
+	if (!ret)
+		ret = rpma_conn_cfg_set_cq_size(cfg,
+				(uint32_t)LOOKUP_CQ_SIZE(queue_depth));
+
+	/* establish a new connection to a server listening at addr:port */
+	struct hash_conn_req req = {(uint8_t)nconns};
+	struct rpma_conn_private_data req_pdata = {&req, sizeof(req)};
+	if (!ret)
+		ret = client_connect(peer, addr, port, cfg, &req_pdata,
+				conn_ptr);
+
+	(void) rpma_conn_cfg_delete(&cfg);
+
+	return ret;
+}
+
+/*
+ * server_resp -- get the private data the server answered the connection
+ * request with
+ */
+static struct hash_conn_resp *
+server_resp(struct rpma_conn *conn)
 {
-    /*Hash parameters*/
-	size_t sz; 
-    size_t keylen = 24;
-    size_t off;
-    char hop[4];
-    int keysize = 32;
-    int valsize = 27;
-    int hopsize = 4;
-    int metasize = 1;
-	int metadata_size = 5;
-    char hopdest[4];
-    //char key[keylen];
-    char *valid = {'1'};
-	char meta[] = "0";
-	char metadata[5];
-	char key[keylen];
-	uint32_t h;
-    size_t idx;
-    size_t i;
-    size_t k;
-    uint32_t hopinfo;
-	sz = 1ULL << TABLE_SIZE;
-	size_t index = 0;
-    char **keys;
-    struct rpma_conn *conn;
-    struct rpma_mr_local *dst_mr;
-    struct rpma_mr_remote *src_mr;
-    void *dst_ptr; 
-	int start, end;
-	struct rpma_peer *peer;
-
-	//struct ibv_wc wc;
-    thread_data_t *data = (thread_data_t *)arg;
-    keys = data->keys;
-    int tid = data->tid;
-    int threadgroup = data->threadgroup;
-    conn = data->conn;
-    //dst_mr = data->dst_mr;
-    src_mr = data->src_mr;
-	 
-	 peer = data->peer;
-    //dst_ptr = data->dst_ptr;
-	start = data->start;
-	end = data->end;
-    int ret;
-    struct ibv_wc wc;
-
-
-   	/* allocate a memory */
-	dst_ptr = malloc_aligned(2*KILOBYTE);
-	if (dst_ptr == NULL) {
-		ret = -1;
-		printf("dddlol");
+	struct rpma_conn_private_data pdata;
+
+	if (rpma_conn_get_private_data(conn, &pdata) || pdata.ptr == NULL ||
+			pdata.len < sizeof(struct hash_conn_resp)) {
+		fprintf(stderr,
+			"The server has not provided a remote memory region. (the connection's private data is empty)\n");
 		return NULL;
 	}
 
+	return pdata.ptr;
+}
 
-	/* register the memory */
-	ret = rpma_mr_reg(peer, dst_ptr, 2*KILOBYTE, RPMA_MR_USAGE_READ_DST,
-				&dst_mr);
-	if (ret){
-		printf("dddlol");
-		return NULL;}
-
- 	for(k = start; k < end; k++){
-        /*Compute hashcode of key and retrieve segment from PMEM*/
-
-        h = _jenkins_hash(keys[k], keylen);
-
-        idx = h & (sz - 1);
-		
-       // printf("search %d-%d\n", tid, k);
-		
-		/* post an RDMA read operation */
-		ret = rpma_read(conn, dst_mr, 0, src_mr, idx*64, 2*KILOBYTE,
-			RPMA_F_COMPLETION_ALWAYS, NULL);
-		if (ret){
-			printf("read fail");
-			(void) rpma_mr_remote_delete(&src_mr);
-			pthread_exit(NULL);
-		}
+/*
+ * read_shard_map -- read the shard map published by the server; *map_ptr
+ * is set to NULL if the server publishes none
+ */
+static int
+read_shard_map(struct rpma_peer *peer, struct rpma_conn *conn,
+		struct shard_map **map_ptr)
+{
+	struct rpma_mr_remote *src_mr = NULL;
+	struct rpma_mr_local *dst_mr = NULL;
+	struct rpma_cq *cq = NULL;
+	struct ibv_wc wc;
+	char *dst_ptr = NULL;
+	int ret;
 
-	
-
-    	/*Completion queue to correctly receive ordered chars
-		/* get the connection's main CQ */
-		struct rpma_cq *cq = NULL;
-		ret = rpma_conn_get_cq(conn, &cq);
-		if (ret){printf("read fail");
-			pthread_exit(NULL);}
-			//(void) rpma_mr_remote_delete(&src_mr);
-
-			/* wait for the completion to be ready */
-			ret = rpma_cq_wait(cq);
-			if (ret){
-				printf("read fail");
-				(void) rpma_mr_remote_delete(&src_mr);
-				pthread_exit(NULL);
-		    }
-		
-			/* wait for a completion of the RDMA read */
-			ret = rpma_cq_get_wc(cq, 1, &wc, NULL);
-			if (ret){
-				printf("read fail");
-				(void) rpma_mr_remote_delete(&src_mr);
-				pthread_exit(NULL);
-		    }
-
-			if (wc.status != IBV_WC_SUCCESS) {
-				ret = -1;
-				(void) fprintf(stderr, "rpma_read() failed: %s\n",
+	*map_ptr = NULL;
+
+	struct hash_conn_resp *resp = server_resp(conn);
+	if (resp == NULL)
+		return -1;
+	if (resp->map_len == 0)
+		return 0;
+	if (resp->map_len > HASH_META_SIZE)
+		return -1;
+
+	ret = rpma_mr_remote_from_descriptor(&resp->data.descriptors[0],
+			resp->data.mr_desc_size, &src_mr);
+	if (ret)
+		return ret;
+
+	ret = -1;
+	dst_ptr = malloc_aligned(HASH_META_SIZE);
+	if (dst_ptr == NULL)
+		goto err_mr_remote_delete;
+
+	ret = rpma_mr_reg(peer, dst_ptr, HASH_META_SIZE, RPMA_MR_USAGE_READ_DST,
+			&dst_mr);
+	if (ret)
+		goto err_free;
+
+	ret = rpma_conn_get_cq(conn, &cq);
+	if (ret)
+		goto err_mr_dereg;
+
+	ret = rpma_read(conn, dst_mr, 0, src_mr,
+			resp->data.data_offset + HASH_META_OFFSET,
+			resp->map_len, RPMA_F_COMPLETION_ALWAYS, NULL);
+	if (ret)
+		goto err_mr_dereg;
+
+	do {
+		ret = rpma_cq_get_wc(cq, 1, &wc, NULL);
+	} while (ret == RPMA_E_NO_COMPLETION);
+	if (ret)
+		goto err_mr_dereg;
+
+	if (wc.status != IBV_WC_SUCCESS) {
+		(void) fprintf(stderr, "rpma_read() failed: %s\n",
 				ibv_wc_status_str(wc.status));
-				(void) rpma_mr_remote_delete(&src_mr);
-			}
+		ret = -1;
+		goto err_mr_dereg;
+	}
 
-			if (wc.opcode != IBV_WC_RDMA_READ) {
-				ret = -1;
-				(void) fprintf(stderr,
-				"unexpected wc.opcode value (%d != %d)\n",
-				wc.opcode, IBV_WC_RDMA_READ);
-				(void) rpma_mr_remote_delete(&src_mr);
-			}
+	ret = shard_map_decode(dst_ptr, resp->map_len, map_ptr);
+	if (ret)
+		(void) fprintf(stderr,
+				"the server published an invalid shard map\n");
 
+err_mr_dereg:
+	(void) rpma_mr_dereg(&dst_mr);
 
-			/*for(int i=0; i<64; i++){
-			
-			printf( "Read message meta: %c\n", ((char *)dst_ptr)[i]);
+err_free:
+	free(dst_ptr);
 
-			}*/
+err_mr_remote_delete:
+	(void) rpma_mr_remote_delete(&src_mr);
 
-		
-	
-			for(int i=0; i<metadata_size; i++){
-			
-				metadata[i] = ((char *)dst_ptr)[i];
-				//printf( "Read message meta: %c\n", metadata[i]);
-    			//(void) fprintf(stdout, "Read message: %c\n", ((char *)dst_ptr)[i]);
-			}
+	return ret;
+}
 
-		
+/* the connection to a server and the engine of the table it serves */
+struct server_conn {
+	struct rpma_conn *conn;
+	struct rpma_mr_remote *src_mr;
+	struct lookup_engine *eng;
+};
 
-			if ( valid == metadata[0]) {
+/*
+ * server_open -- open a connection to the server (unless conn is already
+ * connected) and create the engine of the table it serves
+ */
+static int
+server_open(thread_data_t *data, const char *addr, const char *port,
+		struct rpma_conn *conn, uint32_t server, struct server_conn *sc)
+{
+	int ret = 0;
 
-        	//Get hopinfo
-            	memcpy(&hopdest, &metadata[1], hopsize);
-            	hopinfo = atoi(hopdest);
+	memset(sc, 0, sizeof(*sc));
+	if (conn == NULL)
+		ret = server_connect(data->peer, addr, port, data->nconns,
+				data->queue_depth, &conn);
+	if (ret)
+		return ret;
+	sc->conn = conn;
 
-     		/* 
-      		 * If hopinfo equals to 1, return current bucket, else traverse through keys
-      		*/
+	/* receive a memory info from the server */
+	struct hash_conn_resp *resp = server_resp(conn);
+	if (resp == NULL)
+		return -1;
 
-            	if(hopinfo == 1){
-                	//Return current bucket
+	/* all the servers have to route the keys the same way */
+	if (resp->map_epoch != data->map_epoch) {
+		fprintf(stderr,
+			"%s:%s serves the shard map epoch %u instead of %u\n",
+			addr, port, resp->map_epoch, data->map_epoch);
+		return -1;
+	}
 
-					for(int i=0; i<keylen; i++){
-			
-						key[i] = ((char *)dst_ptr)[metasize+hopsize+i];
-						//printf( "Read message meta: %c\n", key[i]);
-    					//(void) fprintf(stdout, "Read message: %c\n", ((char *)dst_ptr)[i]);
-					}
+	/*
+	 * Create a remote memory registration structure from the received
+	 * descriptor.
+	 */
+	struct common_data *src_data = &resp->data;
+	ret = rpma_mr_remote_from_descriptor(&src_data->descriptors[0],
+			src_data->mr_desc_size, &sc->src_mr);
+	if (ret)
+		return ret;
 
-					cnt++;
+	ret = lookup_engine_new(data->peer, conn, sc->src_mr,
+			src_data->data_offset, data->queue_depth, data->mode,
+			&sc->eng);
+	if (ret)
+		return ret;
 
-            	}else{
-            
-                	for ( i = 0; i < HOP_NUMBER; i++ ) {
-                    	if ( hopinfo & (1 << i) ) {
+	if (data->cache)
+		lookup_engine_set_cache(sc->eng, data->cache, server);
 
-							for(int j=0; j<keylen; j++){
-			
-								key[j] = ((char *)dst_ptr)[metasize+hopsize+i*64+j];
+	return 0;
+}
+
+/*
+ * server_close -- delete the engine and close the connection
+ */
+static void
+server_close(struct server_conn *sc)
+{
+	lookup_engine_delete(&sc->eng);
+	(void) rpma_mr_remote_delete(&sc->src_mr);
+	if (sc->conn)
+		(void) common_disconnect_and_wait_for_conn_close(&sc->conn);
+}
 
-							}         
+/*
+ * thr_func -- open a connection and look up the keys of the thread
+ * keeping up to queue_depth lookups in flight
+ */
+void *thr_func(void *arg)
+{
+	thread_data_t *data = (thread_data_t *)arg;
+	struct server_conn sc;
 
-                        	if ( 0 == memcmp(keys[k], key, keylen-4) ) {
-                        	/* Found */
-							//printf("found %s-%d-%d\n", key, tid, k);
-							cnt++;
-                        	//return ht->buckets[idx + i].data;
-                        	}
-                    	}
-                	} 
-            	}
+	int ret = server_open(data, data->addr, data->port, data->conn,
+			data->server, &sc);
+	if (!ret)
+		ret = lookup_engine_run(sc.eng, &data->keys[data->start],
+				(size_t)(data->end - data->start), &data->stats);
 
-        	} else{
-        	//Key not found if bucket is empty
-            	printf("Not found\n");
-            	return NULL;
-        	}
-    	}
+	server_close(&sc);
+	data->ret = ret;
 
-		free(dst_ptr);
-    	return NULL;
+	return NULL;
 }
 
+/*
+ * mget_thr_func -- open a connection to every server and look up the keys
+ * of the thread with the multi-gets of up to batch keys
+ */
+void *mget_thr_func(void *arg)
+{
+	thread_data_t *data = (thread_data_t *)arg;
+	const struct shard_map *map = data->map;
+	uint32_t nservers = map ? map->nservers : 1;
+	struct server_conn sc[SHARD_SERVERS_MAX] = {{0}};
+	struct lookup_engine *engines[SHARD_SERVERS_MAX];
+	struct lookup_result *results = NULL;
+	int ret = 0;
+
+	for (uint32_t srv = 0; srv < nservers && !ret; srv++) {
+		/* the seed connection is taken over by one of the threads */
+		struct rpma_conn *conn = (srv == data->server) ?
+				data->conn : NULL;
+		ret = server_open(data, map ? map->servers[srv].addr :
+				data->addr, map ? map->servers[srv].port :
+				data->port, conn, srv, &sc[srv]);
+		engines[srv] = sc[srv].eng;
+	}
+	if (ret)
+		goto err_close;
+
+	results = calloc((size_t)data->batch, sizeof(*results));
+	if (results == NULL) {
+		ret = -1;
+		goto err_close;
+	}
+
+	for (int k = data->start; k < data->end && !ret; k += data->batch) {
+		size_t n = (size_t)MIN(data->batch, data->end - k);
+		ret = hash_mget(engines, map, &data->keys[k], n, results,
+				&data->stats);
+	}
 
+	free(results);
+
+err_close:
+	for (uint32_t srv = 0; srv < nservers; srv++)
+		server_close(&sc[srv]);
+	data->ret = ret;
+
+	return NULL;
+}
 
 int
 main(int argc, char *argv[])
 {
-
 	/* validate parameters */
 	if (argc < 4) {
 		fprintf(stderr, USAGE_STR, argv[0]);
 		exit(-1);
 	}
 
-    /*YCSB trace key file*/ 
-    char *path;
-    path = argv[1];
-
-    /*memory buffer for keys from parsed file*/
-    char line[MAX_LINE_LENGTH] = {0};
-    unsigned int line_count = 0;
-   
-    /*Delimiter for input file: cmd key*/
-    const char s[2] = " "; 
-    char *token = " ";
-    char *keys[KEY_NUMBERS] = {};
-
-	/*Hash parameters*/
-
-	size_t sz; 
-    size_t keylen = 24;
-    size_t off;
-    char hop[4];
-    int keysize = 32;
-    int valsize = 27;
-    int hopsize = 4;
-    int metasize = 1;
-	int metadata_size = 5;
-    char hopdest[4];
-    char *valid = {'1'};
-	char meta[] = "0";
-	char metadata[5];
-	char key[keylen];
-	uint32_t h;
-    size_t idx;
-    size_t i;
-    size_t k;
-    uint32_t hopinfo;
-	sz = 1ULL << TABLE_SIZE;
-	size_t index = 0;
-
-    /*Thread related parameters*/
-    pthread_t thr[NUM_THREADS];
+	/*YCSB trace key file*/
+	char *path = argv[1];
+
+	/*memory buffer for keys from parsed file*/
+	char line[MAX_LINE_LENGTH] = {0};
+	unsigned int line_count = 0;
+
+	/*Delimiters for input file: cmd key (the key without the newline)*/
+	const char s[] = " \r\n";
+	char *token = " ";
+	static char *keys[KEY_NUMBERS];
+
+	/*Thread related parameters*/
+	static pthread_t thr[SHARD_SERVERS_MAX * NUM_THREADS];
 	/*Arguments to pass to thread*/
-    thread_data_t thr_data[NUM_THREADS];
-	int threadgroup = KEY_NUMBERS / NUM_THREADS; //number of queries per thread
-    
-	printf("threadgroup: %d\n", threadgroup);
-
-    /* Open file */
-    FILE *file = fopen(path, "r");
-    
-    if (!file)
-    {
-        perror(path);
-        exit(1);
-    }
-
-    /* Get each line until there are none left */
-    while (fgets(line, MAX_LINE_LENGTH, file) && line_count < KEY_NUMBERS)
-    {
-        /*Get command*/
-        token = strtok(line, s);
-    
-        /*Get key*/
-        token = strtok(NULL, s);
-
-        keys[line_count] = strdup(token);
-
-        line_count++;
-    }
+	static thread_data_t thr_data[SHARD_SERVERS_MAX * NUM_THREADS];
+
+	/* Open file */
+	FILE *file = fopen(path, "r");
+	if (!file) {
+		perror(path);
+		exit(1);
+	}
+
+	/* Get each line until there are none left */
+	while (fgets(line, MAX_LINE_LENGTH, file) && line_count < KEY_NUMBERS) {
+		/*Get command*/
+		token = strtok(line, s);
+
+		/*Get key*/
+		token = strtok(NULL, s);
+		if (token == NULL)
+			continue;
 
+		keys[line_count] = strdup(token);
+
+		line_count++;
+	}
+	(void) fclose(file);
 
 	/* configure logging thresholds to see more details */
 	rpma_log_set_threshold(RPMA_LOG_THRESHOLD, RPMA_LOG_LEVEL_INFO);
 	rpma_log_set_threshold(RPMA_LOG_THRESHOLD_AUX, RPMA_LOG_LEVEL_INFO);
 
-  
-	/* parameters for machines*/
-	int numservers = argv[2];
-	char *addr = argv[3];
-	char *port = argv[4];
 	/* parameters for machines*/
-	char *addr1 = argv[5];
-	char *port1 = argv[6];
+	char *addr = argv[2];
+	char *port = argv[3];
+	int queue_depth = QUEUE_DEPTH_DEFAULT;
+	if (argc >= 5)
+		queue_depth = atoi(argv[4]);
+	if (queue_depth < 1 || queue_depth > QUEUE_DEPTH_MAX) {
+		fprintf(stderr, "queue_depth has to be in the range [1, %d]\n",
+				QUEUE_DEPTH_MAX);
+		exit(-1);
+	}
+	enum lookup_mode mode = LOOKUP_MODE_SEGMENT;
+	if (argc >= 6 && lookup_mode_from_str(argv[5], &mode)) {
+		fprintf(stderr, USAGE_STR, argv[0]);
+		exit(-1);
+	}
+	size_t cache_mib = 0;
+	if (argc >= 7)
+		cache_mib = strtoul(argv[6], NULL, 10);
+	int batch = 0;
+	if (argc >= 8)
+		batch = atoi(argv[7]);
+	if (batch < 0) {
+		fprintf(stderr, USAGE_STR, argv[0]);
+		exit(-1);
+	}
 
 	int ret;
 
-
 	/* resources - general */
 	struct rpma_peer *peer = NULL;
-	struct rpma_conn *conn = NULL;
-	struct ibv_wc wc;
-
-	/*
-	 * resources - memory regions:
-	 * - src_* - a remote one which is a source for the read
-	 * - dst_* - a local, volatile one which is a destination for the read
-	 */
-	struct rpma_mr_local *dst_mr = NULL;
-	struct rpma_mr_remote *src_mr = NULL;
-	//size_t src_size = 0;
-
-	/*memory buffer for read destination*/
-	void *dst_ptr = NULL; 
+	struct rpma_conn *seed_conn = NULL;
+	struct shard_map *map = NULL;
+	char **shard_keys = NULL;
+	struct hash_cache *cache = NULL;
+
+	if (cache_mib > 0) {
+		cache = hash_cache_new(cache_mib << 20);
+		if (cache == NULL) {
+			fprintf(stderr, "cannot create a cache of %zu MiB\n",
+					cache_mib);
+			ret = -1;
+			goto err_free_keys;
+		}
+	}
 
 	/*
 	 * lookup an ibv_context via the address and create a new peer using it
 	 */
 	ret = client_peer_via_address(addr, &peer);
 	if (ret)
-		return ret;
-
+		goto err_cache_delete;
 
+	/*
+	 * The connection to the seed server is the first one of the threads
+	 * of the seed server, so it announces all of them.
+	 */
+	ret = server_connect(peer, addr, port, NUM_THREADS, queue_depth,
+			&seed_conn);
+	if (ret)
+		goto err_peer_delete;
 
-	/* establish a new connection to a server listening at addr:port */
-	ret = client_connect(peer, addr, port, NULL, NULL, &conn);
+	ret = read_shard_map(peer, seed_conn, &map);
 	if (ret)
-		goto err_mr_dereg;
+		goto err_seed_disconnect;
 
-	/* receive a memory info from the server */
-	struct rpma_conn_private_data pdata;
-	ret = rpma_conn_get_private_data(conn, &pdata);
-	if (ret) {
-		goto err_conn_disconnect;
-	} else if (pdata.ptr == NULL) {
+	uint32_t nservers = map ? map->nservers : 1;
+	uint32_t map_epoch = map ? map->epoch : 0;
+	int seed = map ? shard_map_find(map, addr, port) : 0;
+	if (seed < 0) {
 		fprintf(stderr,
-				"The server has not provided a remote memory region. (the connection's private data is empty): %s",
-				strerror(ret));
-		goto err_conn_disconnect;
+			"%s:%s is not one of the servers of its shard map\n",
+			addr, port);
+		ret = -1;
+		goto err_seed_disconnect;
 	}
 
-	/*
-	 * Create a remote memory registration structure from the received
-	 * descriptor.
-	 */
-	struct common_data *src_data = pdata.ptr;
-
-	ret = rpma_mr_remote_from_descriptor(&src_data->descriptors[0],
-			src_data->mr_desc_size, &src_mr);
-	if (ret)
-		goto err_conn_disconnect;
-
-    /*Create threads*/
-    int rc;
-    for (int i = 0; i < NUM_THREADS; ++i) {
-    	thr_data[i].tid = i;
-		thr_data[i].threadgroup = threadgroup;
-		thr_data[i].keys = &keys;
-		thr_data[i].conn = conn;
-		thr_data[i].peer = peer;
-		thr_data[i].src_mr = src_mr;
-        //thr_data[i].dst_ptr = dst_ptr;
-		thr_data[i].start=i*threadgroup;
-		thr_data[i].end=i*threadgroup+threadgroup;
-		//printf(" %s\n", thr_data[i].keys[i*threadgroup+1]);
-    	if ((rc = pthread_create(&thr[i], NULL, thr_func, &thr_data[i]))) {
-      		fprintf(stderr, "error: pthread_create, rc: %d\n", rc);
-      		return EXIT_FAILURE;
-    	}
-    }
-
-  	/* block until all threads complete */
-  	for (i = 0; i < NUM_THREADS; ++i) {
-    	pthread_join(thr[i], NULL);
-  	}
+	/* group the keys by the servers they are routed to */
+	size_t first[SHARD_SERVERS_MAX + 1] = {0};
+	ret = -1;
+	shard_keys = malloc((line_count + 1) * sizeof(*shard_keys));
+	uint32_t *server_of = malloc((line_count + 1) * sizeof(*server_of));
+	if (shard_keys == NULL || server_of == NULL) {
+		free(server_of);
+		goto err_seed_disconnect;
+	}
 
+	for (unsigned int k = 0; k < line_count; k++) {
+		server_of[k] = map ? shard_map_route(map, keys[k],
+				hash_key_len(keys[k])) : 0;
+		first[server_of[k] + 1]++;
+	}
+	for (uint32_t srv = 0; srv < nservers; srv++)
+		first[srv + 1] += first[srv];
+	size_t fill[SHARD_SERVERS_MAX];
+	memcpy(fill, first, sizeof(fill));
+	for (unsigned int k = 0; k < line_count; k++)
+		shard_keys[fill[server_of[k]]++] = keys[k];
+	free(server_of);
+
+	ret = 0;
+	struct timespec t_start, t_end;
+	clock_gettime(CLOCK_MONOTONIC, &t_start);
 
-err_mr_remote_delete:
-	/* delete the remote memory region's structure */
-	(void) rpma_mr_remote_delete(&src_mr);
+	/*
+	 * Create threads - NUM_THREADS per server or, in the multi-get mode,
+	 * NUM_THREADS looking up the keys on all the servers
+	 */
+	int rc;
+	int nthreads = 0;
+	uint32_t ngroups = batch ? 1 : nservers;
+	for (uint32_t srv = 0; srv < ngroups && !ret; srv++) {
+		size_t base = batch ? 0 : first[srv];
+		size_t nkeys = batch ? line_count : first[srv + 1] - first[srv];
+		size_t threadgroup = (nkeys + NUM_THREADS - 1) / NUM_THREADS;
+
+		for (int i = 0; i < NUM_THREADS; ++i) {
+			thread_data_t *data = &thr_data[nthreads];
+			memset(data, 0, sizeof(*data));
+			data->tid = nthreads;
+			data->keys = batch ? keys : shard_keys;
+			data->peer = peer;
+			data->addr = map ? map->servers[srv].addr : addr;
+			data->port = map ? map->servers[srv].port : port;
+			data->map_epoch = map_epoch;
+			data->nconns = NUM_THREADS;
+			data->queue_depth = queue_depth;
+			data->mode = mode;
+			data->cache = cache;
+			data->map = map;
+			data->batch = batch;
+			data->server = batch ? (uint32_t)seed : srv;
+			size_t start = (size_t)i * threadgroup;
+			size_t end = start + threadgroup;
+			data->start = (int)(base + MIN(start, nkeys));
+			data->end = (int)(base + MIN(end, nkeys));
+			/* the seed connection is taken over by the thread */
+			if ((batch || (int)srv == seed) && i == 0) {
+				data->conn = seed_conn;
+				seed_conn = NULL;
+			}
+			if ((rc = pthread_create(&thr[nthreads], NULL,
+					batch ? mget_thr_func : thr_func,
+					data))) {
+				fprintf(stderr, "error: pthread_create, rc: %d\n",
+						rc);
+				if (data->conn)
+					seed_conn = data->conn;
+				ret = -1;
+				break;
+			}
+			nthreads++;
+		}
+	}
 
-err_conn_disconnect:
-	(void) common_disconnect_and_wait_for_conn_close(&conn);
+	/* block until all threads complete */
+	struct lookup_stats total = {0};
+	for (int i = 0; i < nthreads; ++i) {
+		pthread_join(thr[i], NULL);
+		if (thr_data[i].ret)
+			ret = thr_data[i].ret;
+		total.found += thr_data[i].stats.found;
+		total.not_found += thr_data[i].stats.not_found;
+		total.reads += thr_data[i].stats.reads;
+		total.bytes_read += thr_data[i].stats.bytes_read;
+		total.two_phase += thr_data[i].stats.two_phase;
+		total.retries += thr_data[i].stats.retries;
+		total.cache_hits += thr_data[i].stats.cache_hits;
+		total.cache_stale += thr_data[i].stats.cache_stale;
+	}
 
-err_mr_dereg:
-	/* deregister the memory region */
-	(void) rpma_mr_dereg(&dst_mr);
+	clock_gettime(CLOCK_MONOTONIC, &t_end);
+	double elapsed = (double)(t_end.tv_sec - t_start.tv_sec) +
+			(double)(t_end.tv_nsec - t_start.tv_nsec) / 1e9;
+	uint64_t lookups = total.found + total.not_found;
+
+	printf("servers: %u (shard map epoch %u), threads: %d, queue depth: %d\n",
+			nservers, map_epoch, nthreads, queue_depth);
+	for (uint32_t srv = 0; srv < nservers; srv++)
+		printf("  %s:%s - %zu keys\n",
+				map ? map->servers[srv].addr : addr,
+				map ? map->servers[srv].port : port,
+				first[srv + 1] - first[srv]);
+	printf("found: %" PRIu64 ", not found: %" PRIu64 "\n",
+			total.found, total.not_found);
+	printf("reads: %" PRIu64 ", bytes read: %" PRIu64 ", retries: %" PRIu64
+			"\n", total.reads, total.bytes_read, total.retries);
+	if (lookups > 0)
+		printf("bytes/lookup: %.1f, two-phase lookups: %" PRIu64 "\n",
+				(double)total.bytes_read / (double)lookups,
+				total.two_phase);
+	if (cache) {
+		struct hash_cache_stats cstats;
+		hash_cache_get_stats(cache, &cstats);
+		printf("cache hits: %" PRIu64 ", stale: %" PRIu64
+				", inserts: %" PRIu64 ", evictions: %" PRIu64
+				"\n", total.cache_hits, total.cache_stale,
+				cstats.inserts, cstats.evictions);
+	}
+	if (elapsed > 0)
+		printf("lookups/s: %.0f\n", (double)lookups / elapsed);
 
-err_mr_free:
-	/* free the memory */
-	free(dst_ptr);
+err_seed_disconnect:
+	/* the seed connection is left only if no thread took it over */
+	if (seed_conn)
+		(void) common_disconnect_and_wait_for_conn_close(&seed_conn);
+	shard_map_delete(&map);
+	free(shard_keys);
 
 err_peer_delete:
 	/* delete the peer */
 	(void) rpma_peer_delete(&peer);
 
+err_cache_delete:
+	hash_cache_delete(&cache);
+
+err_free_keys:
+	for (unsigned int i = 0; i < line_count; i++)
+		free(keys[i]);
+
 	return ret;
-}
\ No newline at end of file
+}
@@ -1,7 +1,10 @@
 /*
- * readhash.c -- code to read keys from YCSB trace and lookup from hashtable in pmem 
+ * readhash.c -- code to read keys from YCSB trace and lookup from hashtable in pmem
+ *
+ * The hashtable has to be written by writehash (see hashformat.h)
  */
 
+#include "hashformat.h"
 #include "hopscotch.h"
 #include <sys/stat.h>
 #include <fcntl.h>
@@ -14,115 +17,77 @@
 #include <io.h>
 #endif
 #include <libpmem2.h>
-#include <librpma.h>
-#include <stdlib.h>
-#include <stdio.h>
 
 
 #define MAX_LINE_LENGTH 50
 #define KEY_NUMBERS 1000000
-#define TABLE_SIZE   21 // 2097152 buckets
-#define HOP_NUMBER   32
+
 /*
- * Populate hashtable and write to PMEM
+ * Lookup the keys from the trace in the hashtable in PMEM
  */
 int
 main(int argc, const char *const argv[])
 {
-    
-    int fd; //pmem file
+	int fd; //pmem file
 	struct pmem2_config *cfg;
 	struct pmem2_map *map;
 	struct pmem2_source *src;
-	pmem2_persist_fn persist;
 
-    if (argc != 5) {
-		fprintf(stderr, "usage: %s load-file pmem-file offset length\n ", argv[0]);
+	if (argc != 5) {
+		fprintf(stderr,
+			"usage: %s load-file pmem-file offset length\n",
+			argv[0]);
 		exit(1);
 	}
 
-    /*YCSB trace key file*/ 
-    char *path;
-    path = argv[1];
-
-    /*PMEM parameters*/
-	size_t offset = atoi(argv[2]);
-	size_t user_length = atoi(argv[3]);
-	size_t length = user_length;
-    
-
-
-    char line[MAX_LINE_LENGTH] = {0};
-    unsigned int line_count = 0;
-   
-    /*Delimiter for input file: cmd key*/
-    const char s[2] = " "; 
-    char *token = " ";
-    char *keys[KEY_NUMBERS] = {};
-    
-
-    int ret;
-    void *val;
-
-
-      /*Populate the hashtable*/
-    struct hopscotch_hash_table *ht;
-    unsigned int collision = 0;
-    int value = 2008;
-    size_t sz; 
-    size_t keylen = 24;
-
-
-    /* Open file */
-    FILE *file = fopen(path, "r");
-    
-    if (!file)
-    {
-        perror(path);
-        exit(1);
-    }
-
-    /* Initialize with key length 24 bit (32)*/
-   /* ht = hopscotch_init(NULL, keylen);
-    if ( NULL == ht ) {
-         return -1;
-    }*/
-
-    /* Get each line until there are none left */
-    while (fgets(line, MAX_LINE_LENGTH, file))
-    {
-        /*Get command*/
-        token = strtok(line, s);
-    
-        /*Get key*/
-        token = strtok(NULL, s);
-
-        keys[line_count] = strdup(token);
-
-      //  ret = hopscotch_insert(ht, value, value);
-        //printf("line[%06d]: %s\n", line_count, keys[line_count]);
-        line_count++;
-    }
-
-    /*for(int i = 0; i < KEY_NUMBERS; i++){
-        ret = hopscotch_insert(ht, keys[i], keys[i]);
-        if (ret == -4){
-            collision++; //# of relocated buckets
-        }
-    }*/
-
-
-
-   // val = hopscotch_lookup(ht, keys[100471] );
-   // if ( val == keys[100471] ) {
-        /* Failed */
-        //printf("not mstch %s", val);
-       // printf("hop %d\n",ht->buckets[100471].hopinfo);
-        //return -1;
-    //}
-   // printf("match %s", val);
-    
-    /*Write table data to PMEM*/
+	/*YCSB trace key file*/
+	const char *path = argv[1];
+
+	/*PMEM parameters*/
+	size_t offset = strtoull(argv[3], NULL, 0);
+	size_t length = strtoull(argv[4], NULL, 0);
+
+	char line[MAX_LINE_LENGTH] = {0};
+	unsigned int line_count = 0;
+
+	/*Delimiters for input file: cmd key (the key without the newline)*/
+	const char s[] = " \r\n";
+	char *token;
+	static char *keys[KEY_NUMBERS];
+
+	/* Open file */
+	FILE *file = fopen(path, "r");
+	if (!file) {
+		perror(path);
+		exit(1);
+	}
+
+	/* Get each line until there are none left */
+	while (fgets(line, MAX_LINE_LENGTH, file) &&
+			line_count < KEY_NUMBERS) {
+		/*Get command*/
+		token = strtok(line, s);
+
+		/*Get key*/
+		token = strtok(NULL, s);
+		if (token == NULL)
+			continue;
+
+		keys[line_count] = strndup(token, HASH_KEY_MAX);
+		if (keys[line_count] == NULL) {
+			perror("strndup");
+			exit(1);
+		}
+		line_count++;
+	}
+
+	/* Close file */
+	if (fclose(file)) {
+		perror(path);
+		exit(1);
+	}
+
+	/*Map the table data in PMEM*/
 	if ((fd = open(argv[2], O_RDWR)) < 0) {
 		perror("open");
 		exit(1);
@@ -144,13 +109,11 @@ main(int argc, const char *const argv[])
 		exit(1);
 	}
 
-    size_t alignment;
+	size_t alignment;
 
 	if (pmem2_source_alignment(src, &alignment)) {
 		pmem2_perror("pmem2_source_alignment");
 		exit(1);
-	}else{
-		printf("%d\n", alignment);
 	}
 
 	size_t offset_align = offset % alignment;
@@ -180,99 +143,57 @@ main(int argc, const char *const argv[])
 		exit(1);
 	}
 
-    char *addr = pmem2_map_get_address(map);
+	char *addr = pmem2_map_get_address(map);
 	addr += offset_align;
-	size_t size = pmem2_map_get_size(map);
-    size_t off;
-    char hop[4];
-    /* Total bucket size 64*/
-    int keysize = 32;
-    int valsize = 27;
-    int hopsize = 4;
-    int metasize = 1;
-
-    char *valid = {'1'};
-
-
-    /*Hash parameters*/
-    uint32_t h;
-    size_t idx;
-    size_t i;
-    size_t k;
-    uint32_t hopinfo;
-    char hopdest[4];
-    char key[keylen];
-    
-   
-    sz = 1ULL << TABLE_SIZE;
-
-    for(k = 0; k < KEY_NUMBERS; k++){
-
-        /*Compute hashcode of key and retrieve segment from PMEM*/
-
-        h = _jenkins_hash(keys[k], keylen);
-
-        idx = h & (sz - 1);
-
-        //printf("%s----%lu--\n", keys[k], (unsigned long)idx);
-    
-        //Checking if bucket empty
-        if ( valid == addr[idx*64]) {
- 	
-        //Get hopinfo
-            memcpy(&hopdest, &addr[idx*64 + metasize], hopsize);
-            hopinfo = atoi(hopdest);
-
-     /* 
-      * If hopinfo equals to 1, return current bucket, else traverse through keys
-      */
-
-            if(hopinfo == 1){
-                //Return current bucket
-
-                memcpy(&key, &addr[idx*64 + metasize + hopsize], keylen);
-
-                //printf("%s\n", key);
-                //return...
-
-            }else{
-            
-                for ( i = 0; i < HOP_NUMBER; i++ ) {
-                    if ( hopinfo & (1 << i) ) {
-
-                        memcpy(&key, &addr[(idx+i)*64 + metasize + hopsize], keylen);
-
-                        if ( 0 == memcmp(keys[k], key, keylen-4) ) {
-                        /* Found */
-                        
-                        //printf("found");
-                        //printf("%s----%d\n", key, i);
-                        //return ht->buckets[idx + i].data;
-                        }
-                    }
-                } 
-            }
-
-        } else{
-        //Key not found if bucket is empty
-            printf("Not found\n");
-        //return NULL;
-        }
-    }
-
-    
-
-    pmem2_map_delete(&map);
+	size_t size = pmem2_map_get_size(map) - offset_align;
+
+	/* validate the header before touching any of the buckets */
+	uint32_t exponent;
+	const struct hash_header *hdr = (const struct hash_header *)addr;
+	if (size < HASH_HEADER_SIZE || hash_header_check(hdr, &exponent) ||
+			size < hash_header_end(hdr)) {
+		fprintf(stderr,
+			"%s does not contain a valid hash table (format version %d expected)\n",
+			argv[2], HASH_FORMAT_VERSION);
+		exit(1);
+	}
+
+	const struct hash_bucket *buckets = (const struct hash_bucket *)
+			(addr + hash_header_buckets(hdr));
+	uint64_t mask = (1ULL << exponent) - 1;
+	unsigned int found = 0;
+
+	/* the table left by the server in the middle of its growth */
+	const struct hash_bucket *next = NULL;
+	if (hash_header_next(hdr) != 0)
+		next = (const struct hash_bucket *)
+				(addr + hash_header_next(hdr));
+
+	for (unsigned int k = 0; k < line_count; k++) {
+		/*Compute hashcode of key and get its home bucket*/
+		size_t key_len = hash_key_len(keys[k]);
+		uint32_t h = _jenkins_hash((uint8_t *)keys[k], key_len);
+		uint16_t fingerprint = hash_fingerprint(h);
+		const struct hash_bucket *home = &buckets[h & mask];
+		uint64_t version = hash_bucket_version(home);
+		if (next != NULL && (version & HASH_VERSION_MOVED))
+			home = &next[h & (2 * mask + 1)];
+
+		/* check the buckets pointed by hopinfo of the home one */
+		if (hash_segment_find(home, hash_bucket_hopinfo(home), keys[k],
+				key_len, fingerprint) >= 0)
+			found++;
+	}
+
+	printf("found: %u, not found: %u\n", found, line_count - found);
+
+	pmem2_map_delete(&map);
 	pmem2_source_delete(&src);
 	pmem2_config_delete(&cfg);
 	close(fd);
 
-    /* Close file */
-    if (fclose(file))
-    {
-        perror(path);
-        exit(1);
-    }
+	for (unsigned int i = 0; i < line_count; i++)
+		free(keys[i]);
 
-    return 0;
-}
\ No newline at end of file
+	return 0;
+}
@@ -0,0 +1,423 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * shardmap.c -- the consistent-hashing map of the keys to the hash servers
+ *
+ * Every server gets vnodes * weight virtual nodes placed on a ring of 64-bit
+ * hashes by the hash of its "address:port" and the number of the virtual
+ * node. A key belongs to the server of the first virtual node following
+ * the hash of the key on the ring. The positions of the virtual nodes of
+ * a server do not depend on the other servers, so adding or removing
+ * a server moves only the keys which land on its own virtual nodes.
+ * The ring is cut into SHARD_LUT_SIZE ranges of the hashes and the lookup
+ * table keeps the first virtual node of every range, so a key is routed
+ * with one table lookup followed by a short scan.
+ *
+ * The published form of the map (see shard_map_encode()) is a header
+ * followed by one 64-byte entry per server, all the integers little-endian.
+ */
+
+#include <endian.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "shardmap.h"
+
+#define SHARD_MAGIC		"RPMASHRD"
+#define SHARD_MAGIC_LEN		8
+#define SHARD_FORMAT_VERSION	1
+
+/* the lookup table cuts the ring into 2^SHARD_LUT_BITS ranges */
+#define SHARD_LUT_BITS		12
+#define SHARD_LUT_SIZE		(1U << SHARD_LUT_BITS)
+
+#define SHARD_LINE_MAX		128
+
+struct shard_map_hdr {
+	char magic[SHARD_MAGIC_LEN];
+	uint32_t version;
+	uint32_t epoch;
+	uint32_t vnodes;
+	uint32_t nservers;
+	uint64_t checksum;	/* of the map with this field zeroed */
+};
+
+struct shard_map_entry {
+	char addr[SHARD_ADDR_MAX];
+	char port[SHARD_PORT_MAX];
+	uint32_t weight;
+	uint32_t reserved;
+};
+
+_Static_assert(sizeof(struct shard_map_entry) == 64,
+		"an entry of the published map takes 64 bytes");
+
+/*
+ * shard_mix -- the finalizer of MurmurHash3 spreading the bits of a hash
+ */
+static uint64_t
+shard_mix(uint64_t h)
+{
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 33;
+
+	return h;
+}
+
+/*
+ * shard_fnv -- FNV-1a of the buffer continuing from the given hash
+ */
+static uint64_t
+shard_fnv(uint64_t h, const void *buf, size_t len)
+{
+	const unsigned char *p = buf;
+
+	for (size_t i = 0; i < len; i++) {
+		h ^= p[i];
+		h *= 0x100000001b3ULL;
+	}
+
+	return h;
+}
+
+#define SHARD_FNV_INIT 0xcbf29ce484222325ULL
+
+/*
+ * shard_key_hash -- the position of the key on the ring
+ */
+static uint64_t
+shard_key_hash(const char *key, size_t key_len)
+{
+	return shard_mix(shard_fnv(SHARD_FNV_INIT, key, key_len));
+}
+
+/*
+ * shard_point_hash -- the position of the virtual node of the server
+ */
+static uint64_t
+shard_point_hash(const struct shard_server *srv, uint32_t vnode)
+{
+	uint64_t h = shard_fnv(SHARD_FNV_INIT, srv->addr, strlen(srv->addr));
+	h = shard_fnv(h, ":", 1);
+	h = shard_fnv(h, srv->port, strlen(srv->port));
+
+	return shard_mix(h ^ ((vnode + 1) * 0x9E3779B97F4A7C15ULL));
+}
+
+/*
+ * shard_point_cmp -- order the points by their hashes (and the servers
+ * on the very unlikely collisions)
+ */
+static int
+shard_point_cmp(const void *a, const void *b)
+{
+	const struct shard_point *pa = a;
+	const struct shard_point *pb = b;
+
+	if (pa->hash != pb->hash)
+		return pa->hash < pb->hash ? -1 : 1;
+	if (pa->server != pb->server)
+		return pa->server < pb->server ? -1 : 1;
+
+	return 0;
+}
+
+/*
+ * shard_map_build -- place the virtual nodes of the servers on the ring
+ * and fill the lookup table
+ */
+static int
+shard_map_build(struct shard_map *map)
+{
+	size_t npoints = 0;
+
+	for (uint32_t s = 0; s < map->nservers; s++)
+		npoints += (size_t)map->vnodes * map->servers[s].weight;
+
+	map->points = malloc(npoints * sizeof(*map->points));
+	map->lut = malloc(SHARD_LUT_SIZE * sizeof(*map->lut));
+	if (map->points == NULL || map->lut == NULL)
+		return -1;
+
+	map->npoints = 0;
+	for (uint32_t s = 0; s < map->nservers; s++) {
+		uint32_t n = map->vnodes * map->servers[s].weight;
+		for (uint32_t v = 0; v < n; v++) {
+			struct shard_point *p = &map->points[map->npoints++];
+			p->hash = shard_point_hash(&map->servers[s], v);
+			p->server = s;
+		}
+	}
+
+	qsort(map->points, map->npoints, sizeof(*map->points),
+			shard_point_cmp);
+
+	size_t i = 0;
+	for (uint32_t b = 0; b < SHARD_LUT_SIZE; b++) {
+		uint64_t start = (uint64_t)b << (64 - SHARD_LUT_BITS);
+		while (i < map->npoints && map->points[i].hash < start)
+			i++;
+		map->lut[b] = (uint32_t)i;
+	}
+
+	return 0;
+}
+
+/*
+ * shard_map_add -- add the server to the map
+ */
+static int
+shard_map_add(struct shard_map *map, const char *addr, const char *port,
+		uint32_t weight)
+{
+	if (map->nservers == SHARD_SERVERS_MAX ||
+			strlen(addr) >= SHARD_ADDR_MAX ||
+			strlen(port) >= SHARD_PORT_MAX ||
+			weight < 1 || weight > SHARD_WEIGHT_MAX ||
+			shard_map_find(map, addr, port) >= 0)
+		return -1;
+
+	struct shard_server *srv = &map->servers[map->nservers++];
+	strcpy(srv->addr, addr);
+	strcpy(srv->port, port);
+	srv->weight = weight;
+
+	return 0;
+}
+
+/*
+ * shard_map_load -- load the map from a text file
+ */
+int
+shard_map_load(const char *path, struct shard_map **map_ptr)
+{
+	char line[SHARD_LINE_MAX];
+	unsigned lineno = 0;
+
+	FILE *file = fopen(path, "r");
+	if (file == NULL) {
+		perror(path);
+		return -1;
+	}
+
+	struct shard_map *map = calloc(1, sizeof(*map));
+	if (map == NULL) {
+		(void) fclose(file);
+		return -1;
+	}
+	map->vnodes = SHARD_VNODES_DEFAULT;
+
+	while (fgets(line, sizeof(line), file)) {
+		char *comment = strchr(line, '#');
+		if (comment)
+			*comment = '\0';
+
+		char *tok[4];
+		int ntok = 0;
+		for (char *t = strtok(line, " \t\r\n"); t && ntok < 4;
+				t = strtok(NULL, " \t\r\n"))
+			tok[ntok++] = t;
+
+		lineno++;
+		if (ntok == 0)
+			continue;
+
+		if (strcmp(tok[0], "epoch") == 0 && ntok == 2) {
+			map->epoch = (uint32_t)strtoul(tok[1], NULL, 0);
+		} else if (strcmp(tok[0], "vnodes") == 0 && ntok == 2) {
+			map->vnodes = (uint32_t)strtoul(tok[1], NULL, 0);
+		} else if (ntok == 2 || ntok == 3) {
+			uint32_t weight = ntok == 3 ?
+				(uint32_t)strtoul(tok[2], NULL, 0) : 1;
+			if (shard_map_add(map, tok[0], tok[1], weight))
+				goto err_line;
+		} else {
+			goto err_line;
+		}
+	}
+	(void) fclose(file);
+
+	if (map->nservers == 0 || map->vnodes < 1 ||
+			map->vnodes > SHARD_VNODES_MAX) {
+		fprintf(stderr, "%s: no servers or invalid vnodes\n", path);
+		goto err_free;
+	}
+
+	if (shard_map_build(map))
+		goto err_free;
+
+	*map_ptr = map;
+
+	return 0;
+
+err_line:
+	fprintf(stderr, "%s:%u: invalid line (or a duplicated server)\n",
+			path, lineno);
+	(void) fclose(file);
+
+err_free:
+	shard_map_delete(&map);
+
+	return -1;
+}
+
+/*
+ * shard_map_checksum -- FNV-1a of the published map with the checksum zeroed
+ */
+static uint64_t
+shard_map_checksum(const struct shard_map_hdr *hdr,
+		const struct shard_map_entry *entries, uint32_t nservers)
+{
+	struct shard_map_hdr tmp = *hdr;
+	tmp.checksum = 0;
+
+	uint64_t h = shard_fnv(SHARD_FNV_INIT, &tmp, sizeof(tmp));
+
+	return shard_fnv(h, entries, nservers * sizeof(*entries));
+}
+
+/*
+ * shard_map_encode -- serialize the map into the buffer
+ */
+size_t
+shard_map_encode(const struct shard_map *map, void *buf, size_t size)
+{
+	size_t len = sizeof(struct shard_map_hdr) +
+			map->nservers * sizeof(struct shard_map_entry);
+	if (len > size)
+		return 0;
+
+	struct shard_map_hdr *hdr = buf;
+	struct shard_map_entry *entries = (struct shard_map_entry *)(hdr + 1);
+
+	memset(buf, 0, len);
+	memcpy(hdr->magic, SHARD_MAGIC, SHARD_MAGIC_LEN);
+	hdr->version = htole32(SHARD_FORMAT_VERSION);
+	hdr->epoch = htole32(map->epoch);
+	hdr->vnodes = htole32(map->vnodes);
+	hdr->nservers = htole32(map->nservers);
+
+	for (uint32_t s = 0; s < map->nservers; s++) {
+		memcpy(entries[s].addr, map->servers[s].addr, SHARD_ADDR_MAX);
+		memcpy(entries[s].port, map->servers[s].port, SHARD_PORT_MAX);
+		entries[s].weight = htole32(map->servers[s].weight);
+	}
+
+	hdr->checksum = htole64(shard_map_checksum(hdr, entries,
+			map->nservers));
+
+	return len;
+}
+
+/*
+ * shard_map_decode -- validate and deserialize the map
+ */
+int
+shard_map_decode(const void *buf, size_t len, struct shard_map **map_ptr)
+{
+	const struct shard_map_hdr *hdr = buf;
+	const struct shard_map_entry *entries =
+			(const struct shard_map_entry *)(hdr + 1);
+
+	if (len < sizeof(*hdr) ||
+			memcmp(hdr->magic, SHARD_MAGIC, SHARD_MAGIC_LEN) != 0 ||
+			le32toh(hdr->version) != SHARD_FORMAT_VERSION)
+		return -1;
+
+	uint32_t nservers = le32toh(hdr->nservers);
+	if (nservers > SHARD_SERVERS_MAX ||
+			len < sizeof(*hdr) + nservers * sizeof(*entries) ||
+			le64toh(hdr->checksum) !=
+			shard_map_checksum(hdr, entries, nservers))
+		return -1;
+
+	struct shard_map *map = calloc(1, sizeof(*map));
+	if (map == NULL)
+		return -1;
+
+	map->epoch = le32toh(hdr->epoch);
+	map->vnodes = le32toh(hdr->vnodes);
+	if (nservers == 0 || map->vnodes < 1 ||
+			map->vnodes > SHARD_VNODES_MAX)
+		goto err_free;
+
+	for (uint32_t s = 0; s < nservers; s++) {
+		char addr[SHARD_ADDR_MAX + 1] = {0};
+		char port[SHARD_PORT_MAX + 1] = {0};
+		memcpy(addr, entries[s].addr, SHARD_ADDR_MAX);
+		memcpy(port, entries[s].port, SHARD_PORT_MAX);
+		if (shard_map_add(map, addr, port,
+				le32toh(entries[s].weight)))
+			goto err_free;
+	}
+
+	if (shard_map_build(map))
+		goto err_free;
+
+	*map_ptr = map;
+
+	return 0;
+
+err_free:
+	shard_map_delete(&map);
+
+	return -1;
+}
+
+/*
+ * shard_map_delete -- delete the map
+ */
+void
+shard_map_delete(struct shard_map **map_ptr)
+{
+	struct shard_map *map = *map_ptr;
+	if (map == NULL)
+		return;
+
+	free(map->points);
+	free(map->lut);
+	free(map);
+
+	*map_ptr = NULL;
+}
+
+/*
+ * shard_map_route -- get the index of the server the key belongs to
+ */
+uint32_t
+shard_map_route(const struct shard_map *map, const char *key,
+		size_t key_len)
+{
+	uint64_t h = shard_key_hash(key, key_len);
+	size_t i = map->lut[h >> (64 - SHARD_LUT_BITS)];
+
+	while (i < map->npoints && map->points[i].hash < h)
+		i++;
+
+	/* the ring wraps around */
+	if (i == map->npoints)
+		i = 0;
+
+	return map->points[i].server;
+}
+
+/*
+ * shard_map_find -- get the index of the server of the given address
+ */
+int
+shard_map_find(const struct shard_map *map, const char *addr,
+		const char *port)
+{
+	for (uint32_t s = 0; s < map->nservers; s++) {
+		if (strcmp(map->servers[s].addr, addr) == 0 &&
+				strcmp(map->servers[s].port, port) == 0)
+			return (int)s;
+	}
+
+	return -1;
+}
@@ -0,0 +1,89 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * shardmap.h -- the consistent-hashing map of the keys to the hash servers
+ */
+
+#ifndef _SHARDMAP_H
+#define _SHARDMAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SHARD_SERVERS_MAX	32
+#define SHARD_ADDR_MAX		48
+#define SHARD_PORT_MAX		8
+
+/* the virtual nodes of a server per unit of its weight (by default) */
+#define SHARD_VNODES_DEFAULT	256
+#define SHARD_VNODES_MAX	4096
+#define SHARD_WEIGHT_MAX	16
+
+struct shard_server {
+	char addr[SHARD_ADDR_MAX];
+	char port[SHARD_PORT_MAX];
+	uint32_t weight;
+};
+
+/* a virtual node of a server on the ring */
+struct shard_point {
+	uint64_t hash;
+	uint32_t server;
+};
+
+struct shard_map {
+	uint32_t epoch;		/* the version of the map */
+	uint32_t vnodes;	/* the virtual nodes per unit of weight */
+	uint32_t nservers;
+	struct shard_server servers[SHARD_SERVERS_MAX];
+
+	/* the ring - the virtual nodes sorted by their hashes */
+	struct shard_point *points;
+	size_t npoints;
+
+	/* the index of the first point of every range of the hashes */
+	uint32_t *lut;
+};
+
+/*
+ * shard_map_load -- load the map from a text file of the lines:
+ *	epoch <n>
+ *	vnodes <n>
+ *	<address> <port> [<weight>]
+ * ('#' starts a comment); returns 0 on success and -1 otherwise
+ */
+int shard_map_load(const char *path, struct shard_map **map_ptr);
+
+/*
+ * shard_map_encode -- serialize the map into the buffer (the published form
+ * of the map, see shardmap.c); returns the length of the serialized map
+ * or 0 if it does not fit into size bytes
+ */
+size_t shard_map_encode(const struct shard_map *map, void *buf, size_t size);
+
+/*
+ * shard_map_decode -- validate and deserialize the map; returns 0 on success
+ * and -1 otherwise
+ */
+int shard_map_decode(const void *buf, size_t len, struct shard_map **map_ptr);
+
+/*
+ * shard_map_delete -- delete the map
+ */
+void shard_map_delete(struct shard_map **map_ptr);
+
+/*
+ * shard_map_route -- get the index of the server the key belongs to
+ */
+uint32_t shard_map_route(const struct shard_map *map, const char *key,
+		size_t key_len);
+
+/*
+ * shard_map_find -- get the index of the server of the given address
+ * or -1 if the map does not contain it
+ */
+int shard_map_find(const struct shard_map *map, const char *addr,
+		const char *port);
+
+#endif /* _SHARDMAP_H */
@@ -0,0 +1,83 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * shardsplit.c -- split a YCSB trace between the servers of a shard map
+ *
+ * The lines of the trace are routed by their keys the same way
+ * multihashclient routes the lookups (see shardmap.h) and the lines routed
+ * to the n-th server of the map are written to <out-prefix>.<n>, so every
+ * server can load its own keys with writehash.
+ */
+
+#include "hashformat.h"
+#include "shardmap.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#define MAX_LINE_LENGTH 256
+
+int
+main(int argc, const char *const argv[])
+{
+	if (argc != 4) {
+		fprintf(stderr,
+			"usage: %s shard-map load-file out-prefix\n",
+			argv[0]);
+		exit(1);
+	}
+
+	struct shard_map *map = NULL;
+	if (shard_map_load(argv[1], &map))
+		exit(1);
+
+	FILE *in = fopen(argv[2], "r");
+	if (!in) {
+		perror(argv[2]);
+		exit(1);
+	}
+
+	FILE *out[SHARD_SERVERS_MAX] = {NULL};
+	unsigned long nlines[SHARD_SERVERS_MAX] = {0};
+	char path[4096];
+
+	for (uint32_t s = 0; s < map->nservers; s++) {
+		snprintf(path, sizeof(path), "%s.%u", argv[3], s);
+		out[s] = fopen(path, "w");
+		if (!out[s]) {
+			perror(path);
+			exit(1);
+		}
+	}
+
+	char line[MAX_LINE_LENGTH];
+	char key[MAX_LINE_LENGTH];
+	while (fgets(line, sizeof(line), in)) {
+		/* cmd key ... */
+		if (sscanf(line, "%*s %255s", key) != 1)
+			continue;
+
+		uint32_t s = shard_map_route(map, key, hash_key_len(key));
+		if (fputs(line, out[s]) == EOF) {
+			perror("fputs");
+			exit(1);
+		}
+		nlines[s]++;
+	}
+	(void) fclose(in);
+
+	for (uint32_t s = 0; s < map->nservers; s++) {
+		if (fclose(out[s])) {
+			perror("fclose");
+			exit(1);
+		}
+		printf("%s.%u: %s:%s (weight %u) - %lu lines\n", argv[3], s,
+				map->servers[s].addr, map->servers[s].port,
+				map->servers[s].weight, nlines[s]);
+	}
+
+	shard_map_delete(&map);
+
+	return 0;
+}
@@ -8,7 +8,8 @@
  */
 
 
-#include "hopscotch.h"
+#include "hashcache.h"
+#include "hashlookup.h"
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <stdlib.h>
@@ -33,14 +34,10 @@
 
 #define MAX_LINE_LENGTH 50
 #define KEY_NUMBERS 1000000
-#define TABLE_SIZE   21 // 2097152 buckets
-#define HOP_NUMBER   32
 
-#ifdef USE_PMEM
-#define USAGE_STR "usage: %s <keysfile_path> <server_address> <port> [<pmem-path>]\n"PMEM_USAGE
-#else
-#define USAGE_STR "usage: %s <server_address> <port>\n"
-#endif /* USE_PMEM */
+#define USAGE_STR "usage: %s <keysfile_path> <server_address> <port> [<queue_depth> [<mode> [<cache_MiB>]]]\n" \
+	"where <mode> is segment, two-phase or adaptive (segment by default)\n" \
+	"and <cache_MiB> is the size of the cache of the segments (none by default)\n"
 
 int
 main(int argc, char *argv[])
@@ -51,123 +48,115 @@ main(int argc, char *argv[])
 		exit(-1);
 	}
 
-    /*YCSB trace key file*/ 
-    char *path;
-    path = argv[1];
-
-    /*memory buffer for keys from parsed file*/
-    char line[MAX_LINE_LENGTH] = {0};
-    unsigned int line_count = 0;
-   
-    /*Delimiter for input file: cmd key*/
-    const char s[2] = " "; 
-    char *token = " ";
-    char *keys[KEY_NUMBERS] = {};
-
-	/*Hash parameters*/
-
-	size_t sz; 
-    size_t keylen = 24;
-    size_t off;
-    char hop[4];
-    int keysize = 32;
-    int valsize = 27;
-    int hopsize = 4;
-    int metasize = 1;
-	int metadata_size = 5;
-    char hopdest[4];
-    //char key[keylen];
-    char *valid = {'1'};
-	char meta[] = "0";
-	char metadata[5];
-	char key[keylen];
-	uint32_t h;
-    size_t idx;
-    size_t i;
-    size_t k;
-    uint32_t hopinfo;
-	sz = 1ULL << TABLE_SIZE;
-	size_t index = 0;
-
-    //clock_t start, end;
-    //double cpu_time_used;
-    /* Open file */
-    FILE *file = fopen(path, "r");
-    
-    if (!file)
-    {
-        perror(path);
-        exit(1);
-    }
-
-    /* Get each line until there are none left */
-    while (fgets(line, MAX_LINE_LENGTH, file))
-    {
-        /*Get command*/
-        token = strtok(line, s);
-    
-        /*Get key*/
-        token = strtok(NULL, s);
-
-        keys[line_count] = strdup(token);
-
-      //  ret = hopscotch_insert(ht, value, value);
-        //printf("line[%06d]: %s\n", line_count, keys[line_count]);
-        line_count++;
-    }
+	/*YCSB trace key file*/
+	char *path = argv[1];
+
+	/*memory buffer for keys from parsed file*/
+	char line[MAX_LINE_LENGTH] = {0};
+	unsigned int line_count = 0;
+
+	/*Delimiters for input file: cmd key (the key without the newline)*/
+	const char s[] = " \r\n";
+	char *token = " ";
+	static char *keys[KEY_NUMBERS];
+
+	/* Open file */
+	FILE *file = fopen(path, "r");
+	if (!file) {
+		perror(path);
+		exit(1);
+	}
+
+	/* Get each line until there are none left */
+	while (fgets(line, MAX_LINE_LENGTH, file) && line_count < KEY_NUMBERS) {
+		/*Get command*/
+		token = strtok(line, s);
 
+		/*Get key*/
+		token = strtok(NULL, s);
+		if (token == NULL)
+			continue;
+
+		keys[line_count] = strdup(token);
+
+		line_count++;
+	}
+	(void) fclose(file);
 
 	/* configure logging thresholds to see more details */
 	rpma_log_set_threshold(RPMA_LOG_THRESHOLD, RPMA_LOG_LEVEL_INFO);
 	rpma_log_set_threshold(RPMA_LOG_THRESHOLD_AUX, RPMA_LOG_LEVEL_INFO);
 
 	/* parameters for remote machine*/
-	char *addr = argv[2];;
-	char *port = argv[3];;
-	int ret;
+	char *addr = argv[2];
+	char *port = argv[3];
+	int queue_depth = 1;
+	if (argc >= 5)
+		queue_depth = atoi(argv[4]);
+	if (queue_depth < 1 || queue_depth > QUEUE_DEPTH_MAX) {
+		fprintf(stderr, "queue_depth has to be in the range [1, %d]\n",
+				QUEUE_DEPTH_MAX);
+		exit(-1);
+	}
+	enum lookup_mode mode = LOOKUP_MODE_SEGMENT;
+	if (argc >= 6 && lookup_mode_from_str(argv[5], &mode)) {
+		fprintf(stderr, USAGE_STR, argv[0]);
+		exit(-1);
+	}
+	size_t cache_mib = 0;
+	if (argc >= 7)
+		cache_mib = strtoul(argv[6], NULL, 10);
 
+	int ret;
 
 	/* resources - general */
 	struct rpma_peer *peer = NULL;
+	struct rpma_conn_cfg *cfg = NULL;
 	struct rpma_conn *conn = NULL;
-	struct ibv_wc wc;
+	struct lookup_engine *eng = NULL;
+	struct hash_cache *cache = NULL;
 
 	/*
 	 * resources - memory regions:
 	 * - src_* - a remote one which is a source for the read
-	 * - dst_* - a local, volatile one which is a destination for the read
+	 * - the destinations of the reads are owned by the lookup engine
 	 */
-	struct rpma_mr_local *dst_mr = NULL;
 	struct rpma_mr_remote *src_mr = NULL;
-	//size_t src_size = 0;
-
-	/*memory buffer for read destination*/
-	void *dst_ptr = NULL; 
 
 	/*
 	 * lookup an ibv_context via the address and create a new peer using it
 	 */
+	if (cache_mib > 0) {
+		cache = hash_cache_new(cache_mib << 20);
+		if (cache == NULL) {
+			fprintf(stderr, "cannot create a cache of %zu MiB\n",
+					cache_mib);
+			ret = -1;
+			goto err_free_keys;
+		}
+	}
+
 	ret = client_peer_via_address(addr, &peer);
 	if (ret)
-		return ret;
+		goto err_cache_delete;
 
-	/* allocate a memory */
-	dst_ptr = malloc_aligned(2*KILOBYTE);
-	if (dst_ptr == NULL) {
-		ret = -1;
+	/* the queues have to fit all the lookups in flight */
+	ret = rpma_conn_cfg_new(&cfg);
+	if (ret)
 		goto err_peer_delete;
-	}
 
-	/* register the memory */
-	ret = rpma_mr_reg(peer, dst_ptr, 2*KILOBYTE, RPMA_MR_USAGE_READ_DST,
-				&dst_mr);
+	ret = rpma_conn_cfg_set_sq_size(cfg,
+			(uint32_t)LOOKUP_SQ_SIZE(queue_depth));
+	if (!ret)
+		ret = rpma_conn_cfg_set_cq_size(cfg,
+				(uint32_t)LOOKUP_CQ_SIZE(queue_depth));
 	if (ret)
-		goto err_mr_free;
+		goto err_cfg_delete;
 
 	/* establish a new connection to a server listening at addr:port */
-	ret = client_connect(peer, addr, port, NULL, NULL, &conn);
+	ret = client_connect(peer, addr, port, cfg, NULL, &conn);
 	if (ret)
-		goto err_mr_dereg;
+		goto err_cfg_delete;
 
 	/* receive a memory info from the server */
 	struct rpma_conn_private_data pdata;
@@ -176,8 +165,8 @@ main(int argc, char *argv[])
 		goto err_conn_disconnect;
 	} else if (pdata.ptr == NULL) {
 		fprintf(stderr,
-				"The server has not provided a remote memory region. (the connection's private data is empty): %s",
-				strerror(ret));
+			"The server has not provided a remote memory region. (the connection's private data is empty)\n");
+		ret = -1;
 		goto err_conn_disconnect;
 	}
 
@@ -192,124 +181,37 @@ main(int argc, char *argv[])
 	if (ret)
 		goto err_conn_disconnect;
 
-	/* get the remote memory region size */
-
- 
-
-    for(k = 0; k < KEY_NUMBERS; k++){
-        /*Compute hashcode of key and retrieve segment from PMEM*/
-
-        h = _jenkins_hash(keys[k], keylen);
-
-        idx = h & (sz - 1);
-		//printf("%s----%lu--\n", keys[k], (unsigned long)idx);
-
-		/* post an RDMA read operation */
-		ret = rpma_read(conn, dst_mr, 0, src_mr, idx*64, 2*KILOBYTE,
-			RPMA_F_COMPLETION_ALWAYS, NULL);
-		if (ret)
-			goto err_mr_remote_delete;
-
-
-    	/*Completion queue to correctly receive ordered chars
-		/* get the connection's main CQ */
-		struct rpma_cq *cq = NULL;
-		ret = rpma_conn_get_cq(conn, &cq);
-		if (ret)
-			goto err_mr_remote_delete;
-
-		/* wait for the completion to be ready */
-		ret = rpma_cq_wait(cq);
-		if (ret)
-			goto err_mr_remote_delete;
-
-		/* wait for a completion of the RDMA read */
-		ret = rpma_cq_get_wc(cq, 1, &wc, NULL);
-		if (ret)
-			goto err_mr_remote_delete;
-
-		if (wc.status != IBV_WC_SUCCESS) {
-			ret = -1;
-			(void) fprintf(stderr, "rpma_read() failed: %s\n",
-				ibv_wc_status_str(wc.status));
-			goto err_mr_remote_delete;
-		}
-
-		if (wc.opcode != IBV_WC_RDMA_READ) {
-			ret = -1;
-			(void) fprintf(stderr,
-				"unexpected wc.opcode value (%d != %d)\n",
-				wc.opcode, IBV_WC_RDMA_READ);
-			goto err_mr_remote_delete;
-		}
-
+	ret = lookup_engine_new(peer, conn, src_mr, src_data->data_offset,
+			queue_depth, mode, &eng);
+	if (ret)
+		goto err_mr_remote_delete;
 
-		/*for(int i=0; i<64; i++){	
-			
-			printf( "Read message meta: %c\n", ((char *)dst_ptr)[i]);
-  
-		}*/
-	
-		for(int i=0; i<metadata_size; i++){
-			
-			metadata[i] = ((char *)dst_ptr)[i];
+	if (cache)
+		lookup_engine_set_cache(eng, cache, 0);
 
-		}
+	/* look up all the keys */
+	struct lookup_stats stats = {0};
+	ret = lookup_engine_run(eng, keys, line_count, &stats);
+	if (ret)
+		goto err_engine_delete;
+
+	printf("found: %" PRIu64 ", not found: %" PRIu64 "\n",
+			stats.found, stats.not_found);
+	printf("reads: %" PRIu64 ", bytes read: %" PRIu64
+			", two-phase lookups: %" PRIu64 ", retries: %" PRIu64
+			"\n", stats.reads, stats.bytes_read, stats.two_phase,
+			stats.retries);
+	if (cache) {
+		struct hash_cache_stats cstats;
+		hash_cache_get_stats(cache, &cstats);
+		printf("cache hits: %" PRIu64 ", stale: %" PRIu64
+				", inserts: %" PRIu64 ", evictions: %" PRIu64
+				"\n", stats.cache_hits, stats.cache_stale,
+				cstats.inserts, cstats.evictions);
+	}
 
-		if ( valid == metadata[0]) {
-
-        //Get hopinfo
-            memcpy(&hopdest, &metadata[1], hopsize);
-            hopinfo = atoi(hopdest);
- 
-     	/* 
-         * If hopinfo equals to 1, return current bucket, else traverse through keys
-         */
-
-           	if(hopinfo == 1){
-                //Return current bucket
-
-				for(int i=0; i<keylen; i++){       
-			
-					key[i] = ((char *)dst_ptr)[metasize+hopsize+i];
-	
-				}
-                
-                //printf("%s\n", key);
-                //return...
-
-            }else{
-            
-                for ( i = 0; i < HOP_NUMBER; i++ ) {
-                    if ( hopinfo & (1 << i) ) {
-
-						for(int j=0; j<keylen; j++){
-			
-							key[j] = ((char *)dst_ptr)[metasize+hopsize+i*64+j];
-
-						}         
-
-                        if ( 0 == memcmp(keys[k], key, keylen-4) ) {
-                        /* Found */
-                        //printf("found");
-                        //printf("%s----%d\n", key, i);
-                        //return ht->buckets[idx + i].data;
-                        }
-                    }
-                } 
-            }
-
-        } else{
-        //Key not found if bucket is empty
-            printf("Not found\n");
-        //return NULL;
-        }
-    }
-
-
-	/*read from here*/
-
-	
+err_engine_delete:
+	lookup_engine_delete(&eng);
 
 err_mr_remote_delete:
 	/* delete the remote memory region's structure */
@@ -318,17 +220,19 @@ err_mr_remote_delete:
 err_conn_disconnect:
 	(void) common_disconnect_and_wait_for_conn_close(&conn);
 
-err_mr_dereg:
-	/* deregister the memory region */
-	(void) rpma_mr_dereg(&dst_mr);
-
-err_mr_free:
-	/* free the memory */
-	free(dst_ptr);
+err_cfg_delete:
+	(void) rpma_conn_cfg_delete(&cfg);
 
 err_peer_delete:
 	/* delete the peer */
 	(void) rpma_peer_delete(&peer);
 
+err_cache_delete:
+	hash_cache_delete(&cache);
+
+err_free_keys:
+	for (unsigned int i = 0; i < line_count; i++)
+		free(keys[i]);
+
 	return ret;
-}
\ No newline at end of file
+}
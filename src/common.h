@@ -8,11 +8,18 @@
 #ifndef LIBRPMA_COMMON_H
 #define LIBRPMA_COMMON_H
 
+#include <stdint.h>
+#include <time.h>
+
 #define STR_HELPER(x) #x
 #define STR(x) STR_HELPER(x)
 
 #define CLIP_TO_INT(size)	((size) > INT_MAX ? INT_MAX : (int)(size))
 
+/* generate operation completion on success */
+#define RPMA_F_COMPLETION_ON_SUCCESS \
+	(RPMA_F_COMPLETION_ALWAYS & ~RPMA_F_COMPLETION_ON_ERROR)
+
 #ifdef __GNUC__
 #define likely(x)	__builtin_expect(!!(x), 1)
 #define unlikely(x)	__builtin_expect(!!(x), 0)
@@ -21,4 +28,26 @@
 #define unlikely(x)	(x)
 #endif
 
+/*
+ * The statistics counters are updated with relaxed atomics - they do not
+ * order any other memory access, they only have to be tear-free.
+ */
+#define RPMA_STATS_ADD(counter, value) \
+	((void) __atomic_fetch_add(&(counter), (value), __ATOMIC_RELAXED))
+#define RPMA_STATS_INC(counter)	RPMA_STATS_ADD(counter, 1)
+#define RPMA_STATS_GET(counter)	__atomic_load_n(&(counter), __ATOMIC_RELAXED)
+#define RPMA_STATS_RESET(counter) \
+	__atomic_store_n(&(counter), 0, __ATOMIC_RELAXED)
+
+/*
+ * rpma_now_ns -- get the current monotonic time in nanoseconds
+ */
+static inline uint64_t
+rpma_now_ns(void)
+{
+	struct timespec ts;
+	(void) clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
 #endif /* LIBRPMA_COMMON_H */
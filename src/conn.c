@@ -13,8 +13,10 @@
 #include "conn.h"
 #include "debug.h"
 #include "flush.h"
+#include "lat.h"
 #include "log_internal.h"
 #include "mr.h"
+#include "mw.h"
 #include "private_data.h"
 
 #ifdef TEST_MOCK_ALLOC
@@ -32,8 +34,59 @@ struct rpma_conn {
 	struct rpma_flush *flush; /* flushing object */
 
 	bool direct_write_to_pmem; /* direct write to pmem is supported */
+
+	/* statistics counters (the flush ones are kept by the flush object) */
+	struct rpma_conn_stats stats;
+
+	struct rpma_lat *lat; /* latency tracking (optional) */
+
+	/* durations of the setup phases */
+	struct rpma_conn_setup_times setup;
+	uint64_t handshake_start_ns; /* 0 if the handshake is not timed */
 };
 
+/*
+ * rpma_conn_stats_count -- account a posted operation (helper function)
+ */
+static inline void
+rpma_conn_stats_count(struct rpma_conn *conn, int ret, uint64_t *ops,
+		uint64_t *bytes, size_t len)
+{
+	if (unlikely(ret)) {
+		RPMA_STATS_INC(conn->stats.post_errors);
+		return;
+	}
+
+	RPMA_STATS_INC(*ops);
+	RPMA_STATS_ADD(*bytes, (uint64_t)len);
+}
+
+/*
+ * rpma_conn_lat_post -- start measuring the latency of the operation which
+ * is about to be posted if the tracking is enabled (helper function)
+ */
+static inline int
+rpma_conn_lat_post(struct rpma_conn *conn, enum rpma_lat_op op, int flags,
+		const void *op_context)
+{
+	if (likely(conn->lat == NULL) ||
+			!(flags & RPMA_F_COMPLETION_ON_SUCCESS))
+		return -1;
+
+	return rpma_lat_post(conn->lat, op, (uint64_t)op_context);
+}
+
+/*
+ * rpma_conn_lat_cancel -- stop measuring the latency of the operation
+ * which failed to be posted (helper function)
+ */
+static inline void
+rpma_conn_lat_cancel(struct rpma_conn *conn, int ret, int slot)
+{
+	if (unlikely(ret) && slot >= 0)
+		rpma_lat_cancel(conn->lat, slot);
+}
+
 /* internal librpma API */
 
 /*
@@ -69,10 +122,12 @@ rpma_conn_new(struct rpma_peer *peer, struct rdma_cm_id *id,
 		goto err_destroy_evch;
 	}
 
+	uint64_t flush_start_ns = rpma_now_ns();
 	struct rpma_flush *flush;
 	ret = rpma_flush_new(peer, &flush);
 	if (ret)
 		goto err_migrate_id_NULL;
+	uint64_t flush_reg_ns = rpma_now_ns() - flush_start_ns;
 
 	struct rpma_conn *conn = malloc(sizeof(*conn));
 	if (!conn) {
@@ -89,6 +144,11 @@ rpma_conn_new(struct rpma_peer *peer, struct rdma_cm_id *id,
 	conn->data.len = 0;
 	conn->flush = flush;
 	conn->direct_write_to_pmem = false;
+	conn->stats = (struct rpma_conn_stats){0};
+	conn->lat = NULL;
+	conn->setup = (struct rpma_conn_setup_times){0};
+	conn->setup.flush_reg_ns = flush_reg_ns;
+	conn->handshake_start_ns = 0;
 
 	*conn_ptr = conn;
 
@@ -123,6 +183,23 @@ rpma_conn_transfer_private_data(struct rpma_conn *conn,
 	pdata->len = 0;
 }
 
+/*
+ * rpma_conn_set_setup_times -- take the durations of the setup phases done
+ * by the connection request and the time the handshake has started at
+ */
+void
+rpma_conn_set_setup_times(struct rpma_conn *conn,
+		const struct rpma_conn_setup_times *times,
+		uint64_t handshake_start_ns)
+{
+	RPMA_DEBUG_TRACE;
+
+	conn->setup.resolve_addr_ns = times->resolve_addr_ns;
+	conn->setup.resolve_route_ns = times->resolve_route_ns;
+	conn->setup.qp_create_ns = times->qp_create_ns;
+	conn->handshake_start_ns = handshake_start_ns;
+}
+
 /* public librpma API */
 
 /*
@@ -190,6 +267,10 @@ rpma_conn_next_event(struct rpma_conn *conn, enum rpma_conn_event *event)
 	switch (cm_event) {
 		case RDMA_CM_EVENT_ESTABLISHED:
 			*event = RPMA_CONN_ESTABLISHED;
+			if (conn->handshake_start_ns &&
+					conn->setup.handshake_ns == 0)
+				conn->setup.handshake_ns = rpma_now_ns() -
+						conn->handshake_start_ns;
 			break;
 		case RDMA_CM_EVENT_CONNECT_ERROR:
 		case RDMA_CM_EVENT_DEVICE_REMOVAL:
@@ -247,6 +328,8 @@ rpma_conn_wait(struct rpma_conn *conn, int flags, struct rpma_cq **cq, bool *is_
 	if (ibv_get_cq_event(conn->channel, &ev_cq, &ev_ctx))
 		return RPMA_E_NO_COMPLETION;
 
+	RPMA_STATS_INC(conn->stats.events);
+
 	if (conn->cq && (rpma_cq_get_ibv_cq(conn->cq) == ev_cq)) {
 		*cq = conn->cq;
 		if (is_rcq)
@@ -396,6 +479,8 @@ rpma_conn_delete(struct rpma_conn **conn_ptr)
 
 	rdma_destroy_event_channel(conn->evch);
 	rpma_private_data_discard(&conn->data);
+	if (conn->lat)
+		rpma_lat_delete(&conn->lat);
 
 	free(conn);
 	*conn_ptr = NULL;
@@ -415,6 +500,8 @@ err_destroy_comp_channel:
 err_destroy_event_channel:
 	rdma_destroy_event_channel(conn->evch);
 	rpma_private_data_discard(&conn->data);
+	if (conn->lat)
+		rpma_lat_delete(&conn->lat);
 
 	free(conn);
 	*conn_ptr = NULL;
@@ -440,10 +527,18 @@ rpma_read(struct rpma_conn *conn,
 	    len != 0)))
 		return RPMA_E_INVAL;
 
-	return rpma_mr_read(conn->id->qp,
+	int slot = rpma_conn_lat_post(conn, RPMA_LAT_OP_READ, flags,
+			op_context);
+	int ret = rpma_mr_read(conn->id->qp,
 			dst, dst_offset,
 			src, src_offset,
 			len, flags, op_context);
+	rpma_conn_lat_cancel(conn, ret, slot);
+
+	rpma_conn_stats_count(conn, ret, &conn->stats.read_ops,
+			&conn->stats.read_bytes, len);
+
+	return ret;
 }
 
 /*
@@ -464,12 +559,20 @@ rpma_write(struct rpma_conn *conn,
 	    len != 0)))
 		return RPMA_E_INVAL;
 
-	return rpma_mr_write(conn->id->qp,
+	int slot = rpma_conn_lat_post(conn, RPMA_LAT_OP_WRITE, flags,
+			op_context);
+	int ret = rpma_mr_write(conn->id->qp,
 			dst, dst_offset,
 			src, src_offset,
 			len, flags,
 			IBV_WR_RDMA_WRITE, 0,
 			op_context);
+	rpma_conn_lat_cancel(conn, ret, slot);
+
+	rpma_conn_stats_count(conn, ret, &conn->stats.write_ops,
+			&conn->stats.write_bytes, len);
+
+	return ret;
 }
 
 /*
@@ -490,12 +593,20 @@ rpma_write_with_imm(struct rpma_conn *conn,
 	    len != 0)))
 		return RPMA_E_INVAL;
 
-	return rpma_mr_write(conn->id->qp,
+	int slot = rpma_conn_lat_post(conn, RPMA_LAT_OP_WRITE, flags,
+			op_context);
+	int ret = rpma_mr_write(conn->id->qp,
 			dst, dst_offset,
 			src, src_offset,
 			len, flags,
 			IBV_WR_RDMA_WRITE_WITH_IMM, imm,
 			op_context);
+	rpma_conn_lat_cancel(conn, ret, slot);
+
+	rpma_conn_stats_count(conn, ret, &conn->stats.write_ops,
+			&conn->stats.write_bytes, len);
+
+	return ret;
 }
 
 /*
@@ -516,9 +627,14 @@ rpma_atomic_write(struct rpma_conn *conn,
 	if (dst_offset % RPMA_ATOMIC_WRITE_ALIGNMENT != 0)
 		return RPMA_E_INVAL;
 
-	return rpma_mr_atomic_write(conn->id->qp,
+	int ret = rpma_mr_atomic_write(conn->id->qp,
 			dst, dst_offset, src,
 			flags, op_context);
+
+	rpma_conn_stats_count(conn, ret, &conn->stats.atomic_write_ops,
+			&conn->stats.atomic_write_bytes, 8 /* bytes */);
+
+	return ret;
 }
 
 /*
@@ -566,8 +682,15 @@ rpma_flush(struct rpma_conn *conn,
 	}
 
 	rpma_flush_func flush = conn->flush->func;
-	return flush(conn->id->qp, conn->flush, dst, dst_offset,
+	int slot = rpma_conn_lat_post(conn, RPMA_LAT_OP_FLUSH, flags,
+			op_context);
+	int ret = flush(conn->id->qp, conn->flush, dst, dst_offset,
 			len, type, flags, op_context);
+	rpma_conn_lat_cancel(conn, ret, slot);
+	if (unlikely(ret))
+		RPMA_STATS_INC(conn->stats.post_errors);
+
+	return ret;
 }
 
 /*
@@ -585,10 +708,18 @@ rpma_send(struct rpma_conn *conn,
 	    (src == NULL && (offset != 0 || len != 0)))
 		return RPMA_E_INVAL;
 
-	return rpma_mr_send(conn->id->qp,
+	int slot = rpma_conn_lat_post(conn, RPMA_LAT_OP_SEND, flags,
+			op_context);
+	int ret = rpma_mr_send(conn->id->qp,
 			src, offset, len,
 			flags, IBV_WR_SEND,
 			0, op_context);
+	rpma_conn_lat_cancel(conn, ret, slot);
+
+	rpma_conn_stats_count(conn, ret, &conn->stats.send_ops,
+			&conn->stats.send_bytes, len);
+
+	return ret;
 }
 
 /*
@@ -606,10 +737,18 @@ rpma_send_with_imm(struct rpma_conn *conn,
 	    (src == NULL && (offset != 0 || len != 0)))
 		return RPMA_E_INVAL;
 
-	return rpma_mr_send(conn->id->qp,
+	int slot = rpma_conn_lat_post(conn, RPMA_LAT_OP_SEND, flags,
+			op_context);
+	int ret = rpma_mr_send(conn->id->qp,
 			src, offset, len,
 			flags, IBV_WR_SEND_WITH_IMM,
 			imm, op_context);
+	rpma_conn_lat_cancel(conn, ret, slot);
+
+	rpma_conn_stats_count(conn, ret, &conn->stats.send_ops,
+			&conn->stats.send_bytes, len);
+
+	return ret;
 }
 
 /*
@@ -626,9 +765,49 @@ rpma_recv(struct rpma_conn *conn,
 	if (conn == NULL || (dst == NULL && (offset != 0 || len != 0)))
 		return RPMA_E_INVAL;
 
-	return rpma_mr_recv(conn->id->qp,
+	int ret = rpma_mr_recv(conn->id->qp,
 			dst, offset, len,
 			op_context);
+
+	rpma_conn_stats_count(conn, ret, &conn->stats.recv_ops,
+			&conn->stats.recv_bytes, len);
+
+	return ret;
+}
+
+/*
+ * rpma_bind_mw -- initiate binding the memory window to the range of
+ * the memory region
+ */
+int
+rpma_bind_mw(struct rpma_conn *conn, struct rpma_mw *mw,
+	const struct rpma_mr_local *mr, size_t offset, size_t len,
+	int usage, int flags, const void *op_context)
+{
+	RPMA_DEBUG_TRACE;
+	RPMA_FAULT_INJECTION(RPMA_E_INVAL, {});
+
+	if (conn == NULL || mw == NULL || mr == NULL || flags == 0)
+		return RPMA_E_INVAL;
+
+	return rpma_mw_bind(conn->id->qp, mw, mr, offset, len, usage, flags,
+			op_context);
+}
+
+/*
+ * rpma_invalidate_mw -- initiate invalidating the memory window
+ */
+int
+rpma_invalidate_mw(struct rpma_conn *conn, struct rpma_mw *mw, int flags,
+	const void *op_context)
+{
+	RPMA_DEBUG_TRACE;
+	RPMA_FAULT_INJECTION(RPMA_E_INVAL, {});
+
+	if (conn == NULL || mw == NULL || flags == 0)
+		return RPMA_E_INVAL;
+
+	return rpma_mw_invalidate(conn->id->qp, mw, flags, op_context);
 }
 
 /*
@@ -698,3 +877,126 @@ rpma_conn_apply_remote_peer_cfg(struct rpma_conn *conn,
 	return rpma_peer_cfg_get_direct_write_to_pmem(pcfg,
 			&conn->direct_write_to_pmem);
 }
+
+/*
+ * rpma_conn_get_stats -- get the statistics counters of the connection
+ */
+int
+rpma_conn_get_stats(const struct rpma_conn *conn,
+		struct rpma_conn_stats *stats)
+{
+	RPMA_DEBUG_TRACE;
+	RPMA_FAULT_INJECTION(RPMA_E_INVAL, {});
+
+	if (conn == NULL || stats == NULL)
+		return RPMA_E_INVAL;
+
+	stats->read_ops = RPMA_STATS_GET(conn->stats.read_ops);
+	stats->read_bytes = RPMA_STATS_GET(conn->stats.read_bytes);
+	stats->write_ops = RPMA_STATS_GET(conn->stats.write_ops);
+	stats->write_bytes = RPMA_STATS_GET(conn->stats.write_bytes);
+	stats->atomic_write_ops = RPMA_STATS_GET(conn->stats.atomic_write_ops);
+	stats->atomic_write_bytes =
+			RPMA_STATS_GET(conn->stats.atomic_write_bytes);
+	rpma_flush_get_stats(conn->flush, &stats->flush_ops,
+			&stats->flush_bytes);
+	stats->send_ops = RPMA_STATS_GET(conn->stats.send_ops);
+	stats->send_bytes = RPMA_STATS_GET(conn->stats.send_bytes);
+	stats->recv_ops = RPMA_STATS_GET(conn->stats.recv_ops);
+	stats->recv_bytes = RPMA_STATS_GET(conn->stats.recv_bytes);
+	stats->post_errors = RPMA_STATS_GET(conn->stats.post_errors);
+	stats->events = RPMA_STATS_GET(conn->stats.events);
+
+	return 0;
+}
+
+/*
+ * rpma_conn_reset_stats -- zero the statistics counters of the connection
+ */
+int
+rpma_conn_reset_stats(struct rpma_conn *conn)
+{
+	RPMA_DEBUG_TRACE;
+	RPMA_FAULT_INJECTION(RPMA_E_INVAL, {});
+
+	if (conn == NULL)
+		return RPMA_E_INVAL;
+
+	RPMA_STATS_RESET(conn->stats.read_ops);
+	RPMA_STATS_RESET(conn->stats.read_bytes);
+	RPMA_STATS_RESET(conn->stats.write_ops);
+	RPMA_STATS_RESET(conn->stats.write_bytes);
+	RPMA_STATS_RESET(conn->stats.atomic_write_ops);
+	RPMA_STATS_RESET(conn->stats.atomic_write_bytes);
+	rpma_flush_reset_stats(conn->flush);
+	RPMA_STATS_RESET(conn->stats.send_ops);
+	RPMA_STATS_RESET(conn->stats.send_bytes);
+	RPMA_STATS_RESET(conn->stats.recv_ops);
+	RPMA_STATS_RESET(conn->stats.recv_bytes);
+	RPMA_STATS_RESET(conn->stats.post_errors);
+	RPMA_STATS_RESET(conn->stats.events);
+
+	return 0;
+}
+
+/*
+ * rpma_conn_get_setup_times -- get the durations of the connection setup phases
+ */
+int
+rpma_conn_get_setup_times(const struct rpma_conn *conn,
+		struct rpma_conn_setup_times *times)
+{
+	RPMA_DEBUG_TRACE;
+	RPMA_FAULT_INJECTION(RPMA_E_INVAL, {});
+
+	if (conn == NULL || times == NULL)
+		return RPMA_E_INVAL;
+
+	*times = conn->setup;
+
+	return 0;
+}
+
+/*
+ * rpma_conn_enable_lat_hist -- enable tracking latencies of the operations
+ */
+int
+rpma_conn_enable_lat_hist(struct rpma_conn *conn)
+{
+	RPMA_DEBUG_TRACE;
+	RPMA_FAULT_INJECTION(RPMA_E_INVAL, {});
+
+	if (conn == NULL)
+		return RPMA_E_INVAL;
+
+	if (conn->lat)
+		return 0;
+
+	struct rpma_lat *lat;
+	int ret = rpma_lat_new(&lat);
+	if (ret)
+		return ret;
+
+	/* the CQ has to be ready to collect the latencies first */
+	rpma_cq_set_lat(conn->cq, lat);
+	conn->lat = lat;
+
+	return 0;
+}
+
+/*
+ * rpma_conn_get_lat_hist -- get the latency histogram of the operation type
+ */
+int
+rpma_conn_get_lat_hist(const struct rpma_conn *conn, enum rpma_lat_op op,
+		struct rpma_lat_hist *hist)
+{
+	RPMA_DEBUG_TRACE;
+	RPMA_FAULT_INJECTION(RPMA_E_INVAL, {});
+
+	if (conn == NULL || hist == NULL || op < RPMA_LAT_OP_READ ||
+			op >= RPMA_LAT_OP_MAX || conn->lat == NULL)
+		return RPMA_E_INVAL;
+
+	return rpma_lat_hist_merge(hist, rpma_lat_get_hist(conn->lat, op));
+}
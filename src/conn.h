@@ -37,4 +37,16 @@ int rpma_conn_new(struct rpma_peer *peer, struct rdma_cm_id *id,
 void rpma_conn_transfer_private_data(struct rpma_conn *conn,
 		struct rpma_conn_private_data *pdata);
 
+/*
+ * rpma_conn_set_setup_times -- take the durations of the setup phases done
+ * by the connection request (the address and route resolution and the QP
+ * creation) and the time the handshake has started at
+ *
+ * ASSUMPTIONS
+ * - conn != NULL && times != NULL
+ */
+void rpma_conn_set_setup_times(struct rpma_conn *conn,
+		const struct rpma_conn_setup_times *times,
+		uint64_t handshake_start_ns);
+
 #endif /* LIBRPMA_CONN_H */
@@ -40,6 +40,11 @@
  */
 #define RPMA_DEFAULT_SHARED_COMPL_CHANNEL false
 
+/*
+ * By default all CQs use the completion vector #0.
+ */
+#define RPMA_DEFAULT_COMP_VECTOR 0
+
 struct rpma_conn_cfg {
 #ifdef ATOMIC_OPERATIONS_SUPPORTED
 	_Atomic int timeout_ms;		/* connection establishment timeout */
@@ -48,6 +53,7 @@ struct rpma_conn_cfg {
 	_Atomic uint32_t sq_size;	/* SQ size */
 	_Atomic uint32_t rq_size;	/* RQ size */
 	_Atomic bool shared_comp_channel; /* completion channel shared by CQ and RCQ */
+	_Atomic int comp_vector;	/* completion vector of CQ and RCQ */
 #else
 	int timeout_ms;		/* connection establishment timeout */
 	uint32_t cq_size;	/* main CQ size */
@@ -55,6 +61,7 @@ struct rpma_conn_cfg {
 	uint32_t sq_size;	/* SQ size */
 	uint32_t rq_size;	/* RQ size */
 	bool shared_comp_channel; /* completion channel shared by CQ and RCQ */
+	int comp_vector;	/* completion vector of CQ and RCQ */
 #endif /* ATOMIC_OPERATIONS_SUPPORTED */
 };
 
@@ -64,7 +71,8 @@ static struct rpma_conn_cfg Conn_cfg_default  = {
 	.rcq_size = RPMA_DEFAULT_RCQ_SIZE,
 	.sq_size = RPMA_DEFAULT_Q_SIZE,
 	.rq_size = RPMA_DEFAULT_Q_SIZE,
-	.shared_comp_channel = RPMA_DEFAULT_SHARED_COMPL_CHANNEL
+	.shared_comp_channel = RPMA_DEFAULT_SHARED_COMPL_CHANNEL,
+	.comp_vector = RPMA_DEFAULT_COMP_VECTOR
 };
 
 /* internal librpma API */
@@ -142,6 +150,8 @@ rpma_conn_cfg_new(struct rpma_conn_cfg **cfg_ptr)
 		atomic_load_explicit(&Conn_cfg_default.rcq_size, __ATOMIC_SEQ_CST));
 	atomic_init(&(*cfg_ptr)->shared_comp_channel,
 		atomic_load_explicit(&Conn_cfg_default.shared_comp_channel, __ATOMIC_SEQ_CST));
+	atomic_init(&(*cfg_ptr)->comp_vector,
+		atomic_load_explicit(&Conn_cfg_default.comp_vector, __ATOMIC_SEQ_CST));
 #else
 	memcpy(*cfg_ptr, &Conn_cfg_default, sizeof(struct rpma_conn_cfg));
 #endif /* ATOMIC_OPERATIONS_SUPPORTED */
@@ -447,3 +457,46 @@ rpma_conn_cfg_get_compl_channel(const struct rpma_conn_cfg *cfg, bool *shared)
 
 	return 0;
 }
+
+/*
+ * rpma_conn_cfg_set_comp_vector -- set the completion vector of CQ and RCQ
+ */
+int
+rpma_conn_cfg_set_comp_vector(struct rpma_conn_cfg *cfg, int comp_vector)
+{
+	RPMA_DEBUG_TRACE;
+	RPMA_FAULT_INJECTION(RPMA_E_INVAL, {});
+
+	if (cfg == NULL || (comp_vector < 0 &&
+			comp_vector != RPMA_COMP_VECTOR_ROUND_ROBIN))
+		return RPMA_E_INVAL;
+
+#ifdef ATOMIC_OPERATIONS_SUPPORTED
+	atomic_store_explicit(&cfg->comp_vector, comp_vector, __ATOMIC_SEQ_CST);
+#else
+	cfg->comp_vector = comp_vector;
+#endif /* ATOMIC_OPERATIONS_SUPPORTED */
+
+	return 0;
+}
+
+/*
+ * rpma_conn_cfg_get_comp_vector -- get the completion vector of CQ and RCQ
+ */
+int
+rpma_conn_cfg_get_comp_vector(const struct rpma_conn_cfg *cfg, int *comp_vector)
+{
+	RPMA_DEBUG_TRACE;
+	RPMA_FAULT_INJECTION(RPMA_E_INVAL, {});
+
+	if (cfg == NULL || comp_vector == NULL)
+		return RPMA_E_INVAL;
+
+#ifdef ATOMIC_OPERATIONS_SUPPORTED
+	*comp_vector = atomic_load_explicit((_Atomic int *)&cfg->comp_vector, __ATOMIC_SEQ_CST);
+#else
+	*comp_vector = cfg->comp_vector;
+#endif /* ATOMIC_OPERATIONS_SUPPORTED */
+
+	return 0;
+}
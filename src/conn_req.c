@@ -41,6 +41,9 @@ struct rpma_conn_req {
 
 	/* a parent RPMA peer of this request - needed for derivative objects */
 	struct rpma_peer *peer;
+
+	/* durations of the setup phases done by the connection request */
+	struct rpma_conn_setup_times times;
 };
 
 /*
@@ -67,6 +70,40 @@ rpma_snprintf_gid(uint8_t *raw, char *gid, size_t size)
 	return 0;
 }
 
+/*
+ * rpma_conn_req_comp_vector -- resolve and validate the completion vector
+ * to be used by both CQ and RCQ of a new connection (helper function)
+ *
+ * RPMA_COMP_VECTOR_ROUND_ROBIN is resolved by assigning the consecutive
+ * completion vectors of the device to the consecutive connections.
+ */
+static int
+rpma_conn_req_comp_vector(struct ibv_context *ibv_ctx, int *comp_vector)
+{
+	static unsigned Next_comp_vector;
+
+	if (*comp_vector != RPMA_COMP_VECTOR_ROUND_ROBIN) {
+		if (*comp_vector >= ibv_ctx->num_comp_vectors) {
+			RPMA_LOG_ERROR(
+				"completion vector out of range: %i (the device has %i completion vectors)",
+				*comp_vector, ibv_ctx->num_comp_vectors);
+			return RPMA_E_INVAL;
+		}
+
+		return 0;
+	}
+
+	if (ibv_ctx->num_comp_vectors <= 1) {
+		*comp_vector = 0;
+		return 0;
+	}
+
+	unsigned next = __sync_fetch_and_add(&Next_comp_vector, 1);
+	*comp_vector = (int)(next % (unsigned)ibv_ctx->num_comp_vectors);
+
+	return 0;
+}
+
 /*
  * rpma_conn_req_from_id -- allocate a new conn_req object from CM ID and equip
  * the latter with QP and CQ
@@ -84,6 +121,7 @@ rpma_conn_req_from_id(struct rpma_peer *peer, struct rdma_cm_id *id,
 	int ret = 0;
 
 	int cqe, rcqe;
+	int comp_vector = 0;
 	bool shared = false;
 	/* read the main CQ size from the configuration */
 	rpma_conn_cfg_get_cqe(cfg, &cqe);
@@ -91,7 +129,13 @@ rpma_conn_req_from_id(struct rpma_peer *peer, struct rdma_cm_id *id,
 	rpma_conn_cfg_get_rcqe(cfg, &rcqe);
 	/* get if the completion channel should be shared by CQ and RCQ */
 	(void) rpma_conn_cfg_get_compl_channel(cfg, &shared);
+	/* get the completion vector of CQ and RCQ */
+	(void) rpma_conn_cfg_get_comp_vector(cfg, &comp_vector);
+	ret = rpma_conn_req_comp_vector(id->verbs, &comp_vector);
+	if (ret)
+		return ret;
 
+	uint64_t qp_start_ns = rpma_now_ns();
 	struct ibv_comp_channel *channel = NULL;
 	if (shared) {
 		/* create a completion channel */
@@ -104,13 +148,14 @@ rpma_conn_req_from_id(struct rpma_peer *peer, struct rdma_cm_id *id,
 	}
 
 	struct rpma_cq *cq = NULL;
-	ret = rpma_cq_new(id->verbs, cqe, channel, &cq);
+	ret = rpma_cq_new(id->verbs, cqe, comp_vector, channel, &cq);
 	if (ret)
 		goto err_comp_channel_destroy;
 
 	struct rpma_cq *rcq = NULL;
 	if (rcqe) {
-		ret = rpma_cq_new(id->verbs, rcqe, channel, &rcq);
+		ret = rpma_cq_new(id->verbs, rcqe, comp_vector, channel,
+				&rcq);
 		if (ret)
 			goto err_rpma_cq_delete;
 	}
@@ -119,6 +164,7 @@ rpma_conn_req_from_id(struct rpma_peer *peer, struct rdma_cm_id *id,
 	ret = rpma_peer_create_qp(peer, id, cq, rcq, cfg);
 	if (ret)
 		goto err_rpma_rcq_delete;
+	uint64_t qp_create_ns = rpma_now_ns() - qp_start_ns;
 
 	*req_ptr = (struct rpma_conn_req *)malloc(sizeof(struct rpma_conn_req));
 	if (*req_ptr == NULL) {
@@ -161,6 +207,8 @@ rpma_conn_req_from_id(struct rpma_peer *peer, struct rdma_cm_id *id,
 	(*req_ptr)->data.ptr = NULL;
 	(*req_ptr)->data.len = 0;
 	(*req_ptr)->peer = peer;
+	(*req_ptr)->times = (struct rpma_conn_setup_times){0};
+	(*req_ptr)->times.qp_create_ns = qp_create_ns;
 
 	return 0;
 
@@ -210,6 +258,8 @@ rpma_conn_req_accept(struct rpma_conn_req *req,
 	if (ret)
 		goto err_conn_disconnect;
 
+	/* the handshake is timed without creating the connection object */
+	rpma_conn_set_setup_times(conn, &req->times, rpma_now_ns());
 	rpma_conn_transfer_private_data(conn, &req->data);
 
 	*conn_ptr = conn;
@@ -258,6 +308,7 @@ rpma_conn_req_connect_active(struct rpma_conn_req *req,
 		(void) rpma_conn_delete(&conn);
 	});
 
+	rpma_conn_set_setup_times(conn, &req->times, rpma_now_ns());
 	if (rdma_connect(req->id, conn_param)) {
 		RPMA_LOG_ERROR_WITH_ERRNO(errno, "rdma_connect()");
 		(void) rpma_conn_delete(&conn);
@@ -399,23 +450,30 @@ rpma_conn_req_new(struct rpma_peer *peer, const char *addr,
 	}
 
 	/* resolve address */
+	uint64_t start_ns = rpma_now_ns();
 	ret = rpma_info_resolve_addr(info, id, timeout_ms);
 	if (ret)
 		goto err_destroy_id;
+	uint64_t resolve_addr_ns = rpma_now_ns() - start_ns;
 
 	/* resolve route */
 	RPMA_FAULT_INJECTION_GOTO(RPMA_E_PROVIDER, err_destroy_id);
+	start_ns = rpma_now_ns();
 	if (rdma_resolve_route(id, timeout_ms)) {
 		RPMA_LOG_ERROR_WITH_ERRNO(errno, "rdma_resolve_route(timeout_ms=%i)", timeout_ms);
 		ret = RPMA_E_PROVIDER;
 		goto err_destroy_id;
 	}
+	uint64_t resolve_route_ns = rpma_now_ns() - start_ns;
 
 	struct rpma_conn_req *req;
 	ret = rpma_conn_req_from_id(peer, id, cfg, &req);
 	if (ret)
 		goto err_destroy_id;
 
+	req->times.resolve_addr_ns = resolve_addr_ns;
+	req->times.resolve_route_ns = resolve_route_ns;
+
 	*req_ptr = req;
 
 	(void) rpma_info_delete(&info);
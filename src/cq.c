@@ -14,6 +14,7 @@
 #include "common.h"
 #include "cq.h"
 #include "debug.h"
+#include "lat.h"
 #include "log_internal.h"
 
 #ifdef TEST_MOCK_ALLOC
@@ -24,6 +25,9 @@ struct rpma_cq {
 	struct ibv_comp_channel *channel; /* completion channel */
 	bool shared_comp_channel; /* completion channel is shared */
 	struct ibv_cq *cq; /* completion queue */
+	int comp_vector; /* completion vector of the CQ */
+	struct rpma_cq_stats stats; /* statistics counters */
+	struct rpma_lat *lat; /* latency tracking (optional) */
 };
 
 /* internal librpma API */
@@ -40,15 +44,25 @@ rpma_cq_get_ibv_cq(const struct rpma_cq *cq)
 	return cq->cq;
 }
 
+/*
+ * rpma_cq_set_lat -- set the latency tracking object of the CQ
+ */
+void
+rpma_cq_set_lat(struct rpma_cq *cq, struct rpma_lat *lat)
+{
+	cq->lat = lat;
+}
+
 /*
  * rpma_cq_new -- create a completion channel and CQ and then
  * encapsulate them in a rpma_cq object
  *
  * ASSUMPTIONS
  * - ibv_ctx != NULL && cq_ptr != NULL
+ * - 0 <= comp_vector < ibv_ctx->num_comp_vectors or comp_vector == 0
  */
 int
-rpma_cq_new(struct ibv_context *ibv_ctx, int cqe,
+rpma_cq_new(struct ibv_context *ibv_ctx, int cqe, int comp_vector,
 		struct ibv_comp_channel *shared_channel,
 		struct rpma_cq **cq_ptr)
 {
@@ -75,7 +89,7 @@ rpma_cq_new(struct ibv_context *ibv_ctx, int cqe,
 	struct ibv_cq *cq = ibv_create_cq(ibv_ctx, cqe,
 				NULL /* cq_context */,
 				channel /* channel */,
-				0 /* comp_vector */);
+				comp_vector);
 	if (cq == NULL) {
 		RPMA_LOG_ERROR_WITH_ERRNO(errno, "ibv_create_cq()");
 		ret = RPMA_E_PROVIDER;
@@ -100,6 +114,9 @@ rpma_cq_new(struct ibv_context *ibv_ctx, int cqe,
 	(*cq_ptr)->channel = channel;
 	(*cq_ptr)->shared_comp_channel = (shared_channel != NULL);
 	(*cq_ptr)->cq = cq;
+	(*cq_ptr)->comp_vector = comp_vector;
+	(*cq_ptr)->stats = (struct rpma_cq_stats){0};
+	(*cq_ptr)->lat = NULL;
 
 	return 0;
 
@@ -174,6 +191,23 @@ rpma_cq_get_fd(const struct rpma_cq *cq, int *fd)
 	return 0;
 }
 
+/*
+ * rpma_cq_get_comp_vector -- get the completion vector the CQ was created with
+ */
+int
+rpma_cq_get_comp_vector(const struct rpma_cq *cq, int *comp_vector)
+{
+	RPMA_DEBUG_TRACE;
+	RPMA_FAULT_INJECTION(RPMA_E_INVAL, {});
+
+	if (cq == NULL || comp_vector == NULL)
+		return RPMA_E_INVAL;
+
+	*comp_vector = cq->comp_vector;
+
+	return 0;
+}
+
 /*
  * rpma_cq_wait -- wait for a completion event from the CQ and ack
  * the completion event if the completion channel is not shared.
@@ -197,6 +231,8 @@ rpma_cq_wait(struct rpma_cq *cq)
 	if (ibv_get_cq_event(cq->channel, &ev_cq, &ev_ctx))
 		return RPMA_E_NO_COMPLETION;
 
+	RPMA_STATS_INC(cq->stats.events);
+
 	/*
 	 * ACK the collected CQ event.
 	 *
@@ -235,11 +271,13 @@ rpma_cq_get_wc(struct rpma_cq *cq, int num_entries, struct ibv_wc *wc,
 	RPMA_FAULT_INJECTION(RPMA_E_PROVIDER, {});
 
 	int result = ibv_poll_cq(cq->cq, num_entries, wc);
+	RPMA_STATS_INC(cq->stats.polls);
 	if (result == 0) {
 		/*
 		 * There may be an extra CQ event with no completion in the CQ.
 		 */
 		RPMA_LOG_DEBUG("No completion in the CQ");
+		RPMA_STATS_INC(cq->stats.empty_polls);
 		return RPMA_E_NO_COMPLETION;
 	} else if (result < 0) {
 		/* ibv_poll_cq() may return only -1; no errno provided */
@@ -255,8 +293,64 @@ rpma_cq_get_wc(struct rpma_cq *cq, int num_entries, struct ibv_wc *wc,
 	RPMA_FAULT_INJECTION(RPMA_E_NO_COMPLETION, {});
 	RPMA_FAULT_INJECTION(RPMA_E_UNKNOWN, {});
 
+	uint64_t errors = 0;
+	for (int i = 0; i < result; i++) {
+		if (unlikely(wc[i].status != IBV_WC_SUCCESS))
+			errors++;
+	}
+
+	RPMA_STATS_ADD(cq->stats.completions, (uint64_t)result);
+	if (errors)
+		RPMA_STATS_ADD(cq->stats.error_completions, errors);
+
+	if (unlikely(cq->lat != NULL))
+		rpma_lat_complete(cq->lat, wc, result);
+
 	if (num_entries_got)
 		*num_entries_got = result;
 
 	return 0;
 }
+
+/*
+ * rpma_cq_get_stats -- get the statistics counters of the CQ
+ */
+int
+rpma_cq_get_stats(const struct rpma_cq *cq, struct rpma_cq_stats *stats)
+{
+	RPMA_DEBUG_TRACE;
+	RPMA_FAULT_INJECTION(RPMA_E_INVAL, {});
+
+	if (cq == NULL || stats == NULL)
+		return RPMA_E_INVAL;
+
+	stats->polls = RPMA_STATS_GET(cq->stats.polls);
+	stats->empty_polls = RPMA_STATS_GET(cq->stats.empty_polls);
+	stats->completions = RPMA_STATS_GET(cq->stats.completions);
+	stats->error_completions =
+			RPMA_STATS_GET(cq->stats.error_completions);
+	stats->events = RPMA_STATS_GET(cq->stats.events);
+
+	return 0;
+}
+
+/*
+ * rpma_cq_reset_stats -- zero the statistics counters of the CQ
+ */
+int
+rpma_cq_reset_stats(struct rpma_cq *cq)
+{
+	RPMA_DEBUG_TRACE;
+	RPMA_FAULT_INJECTION(RPMA_E_INVAL, {});
+
+	if (cq == NULL)
+		return RPMA_E_INVAL;
+
+	RPMA_STATS_RESET(cq->stats.polls);
+	RPMA_STATS_RESET(cq->stats.empty_polls);
+	RPMA_STATS_RESET(cq->stats.completions);
+	RPMA_STATS_RESET(cq->stats.error_completions);
+	RPMA_STATS_RESET(cq->stats.events);
+
+	return 0;
+}
@@ -20,6 +20,19 @@
  */
 struct ibv_cq *rpma_cq_get_ibv_cq(const struct rpma_cq *cq);
 
+struct rpma_lat;
+
+/*
+ * rpma_cq_set_lat -- set the latency tracking object which records
+ * the latencies of the completions collected from the CQ (or NULL)
+ *
+ * ASSUMPTIONS
+ * - cq != NULL
+ *
+ * The function cannot fail.
+ */
+void rpma_cq_set_lat(struct rpma_cq *cq, struct rpma_lat *lat);
+
 /*
  * ERRORS
  * rpma_cq_new() can fail with the following errors:
@@ -28,7 +41,7 @@ struct ibv_cq *rpma_cq_get_ibv_cq(const struct rpma_cq *cq);
  * ibv_req_notify_cq(3) failed with a provider error
  * - RPMA_E_NOMEM - out of memory
  */
-int rpma_cq_new(struct ibv_context *ibv_ctx, int cqe,
+int rpma_cq_new(struct ibv_context *ibv_ctx, int cqe, int comp_vector,
 		struct ibv_comp_channel *shared_channel,
 		struct rpma_cq **cq_ptr);
 
@@ -0,0 +1,1259 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * fake_verbs.c -- an in-process fake of the libibverbs and librdmacm calls
+ * used by librpma (the BUILD_FAKE_VERBS CMake option)
+ *
+ * The librpma_fake flavor of the library is linked with this file instead of
+ * libibverbs and librdmacm, so the overhead of the library itself can be
+ * measured without any RDMA-capable hardware. All the connections are made
+ * within the process:
+ *
+ * - there is a single fake device and every address resolves to it,
+ * - a connection request is delivered to the endpoint listening on the port
+ *   in the process and the events are passed over pipes, so the file
+ *   descriptors of the event channels can be polled,
+ * - the QPs of the connected CM IDs are linked to each other; the RDMA reads
+ *   and writes are memcpy() from or to the remote address, the sends consume
+ *   the receives posted to the QP of the other side and all the work requests
+ *   are completed immediately (so are the bindings and the invalidations
+ *   of the memory windows),
+ * - a CQ is a ring buffer of the work completions and the completion events
+ *   of the armed CQs are passed over the pipes of the completion channels.
+ *
+ * The memory keys are not validated and there is no flow control: a send
+ * without a receive posted on the other side and a work completion which does
+ * not fit into the CQ complete with an error.
+ */
+
+#define _GNU_SOURCE
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <rdma/rdma_cma.h>
+
+/* the maximum number of the scatter/gather elements of a receive */
+#define FAKE_RECV_SGE_MAX 4
+
+/* the size of the receive queue if the QP capabilities do not give it */
+#define FAKE_RQ_SIZE_DEFAULT 64
+
+/* the maximum number of the endpoints listening at once */
+#define FAKE_LISTENERS_MAX 64
+
+struct fake_evch {
+	struct rdma_event_channel ch;
+	int wfd;
+};
+
+struct fake_comp_channel {
+	struct ibv_comp_channel ch;
+	int wfd;
+};
+
+struct fake_cq {
+	struct ibv_cq cq;
+	pthread_spinlock_t lock;
+	struct ibv_wc *wcs;
+	unsigned size;
+	unsigned head;
+	unsigned tail;
+	int armed;
+};
+
+struct fake_recv {
+	uint64_t wr_id;
+	int num_sge;
+	struct ibv_sge sg_list[FAKE_RECV_SGE_MAX];
+};
+
+struct fake_qp {
+	struct ibv_qp qp;
+	pthread_spinlock_t lock;
+
+	/* the receive queue */
+	struct fake_recv *recvs;
+	unsigned size;
+	unsigned head;
+	unsigned tail;
+
+	/* the QP of the other side of the connection (NULL - not connected) */
+	struct fake_qp *peer;
+};
+
+struct fake_id {
+	struct rdma_cm_id id;
+	uint16_t port; /* bound or resolved */
+	int listening;
+
+	/* the other side of the connection */
+	struct fake_id *peer;
+	struct fake_id *listener; /* of a passive ID */
+	int connected;
+
+	/* the ESTABLISHED event of a passive ID waiting for its migration */
+	int established_pending;
+};
+
+struct fake_event {
+	struct rdma_cm_event ev;
+	uint8_t private_data[UINT8_MAX];
+};
+
+/* the state of the fake device */
+static struct {
+	pthread_mutex_t lock; /* of the connections and the listeners */
+	struct fake_id *listeners[FAKE_LISTENERS_MAX];
+	uint32_t next_key;
+	uint32_t next_qp_num;
+
+	struct ibv_device device;
+	struct verbs_context vctx;
+} Fake = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.device = {
+		.node_type = IBV_NODE_CA,
+		.transport_type = IBV_TRANSPORT_IB,
+		.name = "fake_verbs0",
+		.dev_name = "fake_verbs0",
+	},
+};
+
+/*
+ * fake_pipe -- create a pipe which does not leak into the child processes
+ */
+static int
+fake_pipe(int *rfd, int *wfd)
+{
+	int fds[2];
+
+	if (pipe2(fds, O_CLOEXEC))
+		return -1;
+
+	*rfd = fds[0];
+	*wfd = fds[1];
+
+	return 0;
+}
+
+/*
+ * fake_pipe_read_ptr -- read a pointer from the pipe; it fails with EAGAIN
+ * if the pipe is empty and its read end is non-blocking
+ */
+static int
+fake_pipe_read_ptr(int fd, void **ptr)
+{
+	ssize_t ret;
+
+	do {
+		ret = read(fd, ptr, sizeof(*ptr));
+	} while (ret < 0 && errno == EINTR);
+
+	if (ret != sizeof(*ptr)) {
+		if (ret >= 0)
+			errno = EIO;
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * fake_pipe_write_ptr -- write a pointer to the pipe (atomically)
+ */
+static int
+fake_pipe_write_ptr(int fd, void *ptr)
+{
+	ssize_t ret;
+
+	do {
+		ret = write(fd, &ptr, sizeof(ptr));
+	} while (ret < 0 && errno == EINTR);
+
+	return ret == sizeof(ptr) ? 0 : -1;
+}
+
+/* the completion queues */
+
+/*
+ * fake_cq_push -- add the work completion to the CQ and notify
+ * the completion channel if the CQ is armed
+ */
+static void
+fake_cq_push(struct ibv_cq *ibv_cq, const struct ibv_wc *wc)
+{
+	struct fake_cq *cq = (struct fake_cq *)ibv_cq;
+	int notify = 0;
+
+	pthread_spin_lock(&cq->lock);
+	if (cq->tail - cq->head < cq->size) {
+		cq->wcs[cq->tail % cq->size] = *wc;
+		cq->tail++;
+	}
+	/* else the CQ overrun - the completion is lost */
+	if (cq->armed) {
+		cq->armed = 0;
+		notify = 1;
+	}
+	pthread_spin_unlock(&cq->lock);
+
+	if (notify && ibv_cq->channel) {
+		struct fake_comp_channel *fch = (struct fake_comp_channel *)
+				ibv_cq->channel;
+		(void) fake_pipe_write_ptr(fch->wfd, ibv_cq);
+	}
+}
+
+/*
+ * fake_poll_cq -- the poll_cq operation of the fake device
+ */
+static int
+fake_poll_cq(struct ibv_cq *ibv_cq, int num_entries, struct ibv_wc *wc)
+{
+	struct fake_cq *cq = (struct fake_cq *)ibv_cq;
+	int n = 0;
+
+	pthread_spin_lock(&cq->lock);
+	while (n < num_entries && cq->head != cq->tail) {
+		wc[n++] = cq->wcs[cq->head % cq->size];
+		cq->head++;
+	}
+	pthread_spin_unlock(&cq->lock);
+
+	return n;
+}
+
+/*
+ * fake_req_notify_cq -- the req_notify_cq operation of the fake device
+ */
+static int
+fake_req_notify_cq(struct ibv_cq *ibv_cq, int solicited_only)
+{
+	struct fake_cq *cq = (struct fake_cq *)ibv_cq;
+
+	pthread_spin_lock(&cq->lock);
+	cq->armed = 1;
+	pthread_spin_unlock(&cq->lock);
+
+	return 0;
+}
+
+/* the queue pairs */
+
+/*
+ * fake_sge_copy -- gather the scatter/gather list to or scatter it from
+ * the contiguous memory at addr
+ */
+static size_t
+fake_sge_copy(struct ibv_sge *sg_list, int num_sge, char *addr, int gather)
+{
+	size_t done = 0;
+
+	for (int i = 0; i < num_sge; i++) {
+		void *sge_addr = (void *)(uintptr_t)sg_list[i].addr;
+
+		if (gather)
+			memcpy(addr + done, sge_addr, sg_list[i].length);
+		else
+			memcpy(sge_addr, addr + done, sg_list[i].length);
+		done += sg_list[i].length;
+	}
+
+	return done;
+}
+
+/*
+ * fake_sge_len -- the length of the scatter/gather list
+ */
+static size_t
+fake_sge_len(const struct ibv_sge *sg_list, int num_sge)
+{
+	size_t len = 0;
+
+	for (int i = 0; i < num_sge; i++)
+		len += sg_list[i].length;
+
+	return len;
+}
+
+/*
+ * fake_sge_move -- copy the data of the src scatter/gather list to
+ * the dst one (which is not shorter)
+ */
+static void
+fake_sge_move(struct ibv_sge *dst, int dst_num, const struct ibv_sge *src,
+		int src_num)
+{
+	size_t dst_off = 0;
+	size_t src_off = 0;
+	int d = 0;
+
+	for (int s = 0; s < src_num && d < dst_num; ) {
+		size_t n = src[s].length - src_off;
+		if (n > dst[d].length - dst_off)
+			n = dst[d].length - dst_off;
+
+		memcpy((char *)(uintptr_t)dst[d].addr + dst_off,
+			(char *)(uintptr_t)src[s].addr + src_off, n);
+		src_off += n;
+		dst_off += n;
+
+		if (src_off == src[s].length) {
+			s++;
+			src_off = 0;
+		}
+		if (dst_off == dst[d].length) {
+			d++;
+			dst_off = 0;
+		}
+	}
+}
+
+/*
+ * fake_deliver -- consume a receive of the QP for the message of the send
+ * work request (and for the immediate data of the write with immediate)
+ */
+static enum ibv_wc_status
+fake_deliver(struct fake_qp *qp, struct ibv_send_wr *wr, size_t len)
+{
+	struct ibv_wc wc = {0};
+	struct fake_recv recv;
+
+	pthread_spin_lock(&qp->lock);
+	if (qp->head == qp->tail) {
+		pthread_spin_unlock(&qp->lock);
+		return IBV_WC_RNR_RETRY_EXC_ERR;
+	}
+	recv = qp->recvs[qp->head % qp->size];
+	qp->head++;
+	pthread_spin_unlock(&qp->lock);
+
+	wc.wr_id = recv.wr_id;
+	wc.qp_num = qp->qp.qp_num;
+	wc.status = IBV_WC_SUCCESS;
+	wc.byte_len = (uint32_t)len;
+
+	switch (wr->opcode) {
+	case IBV_WR_SEND_WITH_IMM:
+		wc.wc_flags = IBV_WC_WITH_IMM;
+		wc.imm_data = wr->imm_data;
+		/* fall through */
+	case IBV_WR_SEND:
+		wc.opcode = IBV_WC_RECV;
+		if (len > fake_sge_len(recv.sg_list, recv.num_sge)) {
+			wc.status = IBV_WC_LOC_LEN_ERR;
+			break;
+		}
+		fake_sge_move(recv.sg_list, recv.num_sge, wr->sg_list,
+				wr->num_sge);
+		break;
+	default: /* IBV_WR_RDMA_WRITE_WITH_IMM */
+		wc.opcode = IBV_WC_RECV_RDMA_WITH_IMM;
+		wc.wc_flags = IBV_WC_WITH_IMM;
+		wc.imm_data = wr->imm_data;
+		break;
+	}
+
+	fake_cq_push(qp->qp.recv_cq, &wc);
+
+	return wc.status == IBV_WC_SUCCESS ? IBV_WC_SUCCESS :
+			IBV_WC_REM_OP_ERR;
+}
+
+/*
+ * fake_execute -- execute the work request of the QP connected to peer
+ */
+static enum ibv_wc_status
+fake_execute(struct fake_qp *peer, struct ibv_send_wr *wr,
+		enum ibv_wc_opcode *opcode, size_t *len)
+{
+	char *remote = (char *)(uintptr_t)wr->wr.rdma.remote_addr;
+
+	*len = fake_sge_len(wr->sg_list, wr->num_sge);
+
+	switch (wr->opcode) {
+	case IBV_WR_RDMA_READ:
+		*opcode = IBV_WC_RDMA_READ;
+		(void) fake_sge_copy(wr->sg_list, wr->num_sge, remote, 0);
+		return IBV_WC_SUCCESS;
+	case IBV_WR_RDMA_WRITE:
+	case IBV_WR_RDMA_WRITE_WITH_IMM:
+		*opcode = IBV_WC_RDMA_WRITE;
+		/* the data of an inline write is referenced by the SGEs too */
+		(void) fake_sge_copy(wr->sg_list, wr->num_sge, remote, 1);
+		if (wr->opcode == IBV_WR_RDMA_WRITE)
+			return IBV_WC_SUCCESS;
+		return fake_deliver(peer, wr, 0);
+	case IBV_WR_SEND:
+	case IBV_WR_SEND_WITH_IMM:
+		*opcode = IBV_WC_SEND;
+		return fake_deliver(peer, wr, *len);
+	case IBV_WR_BIND_MW:
+		*opcode = IBV_WC_BIND_MW;
+		*len = 0;
+		wr->bind_mw.mw->rkey = wr->bind_mw.rkey;
+		return IBV_WC_SUCCESS;
+	case IBV_WR_LOCAL_INV:
+		*opcode = IBV_WC_LOCAL_INV;
+		*len = 0;
+		return IBV_WC_SUCCESS;
+	default:
+		*opcode = IBV_WC_SEND;
+		return IBV_WC_REM_INV_REQ_ERR;
+	}
+}
+
+/*
+ * fake_post_send -- the post_send operation of the fake device
+ */
+static int
+fake_post_send(struct ibv_qp *ibv_qp, struct ibv_send_wr *wr,
+		struct ibv_send_wr **bad_wr)
+{
+	struct fake_qp *qp = (struct fake_qp *)ibv_qp;
+
+	for (; wr; wr = wr->next) {
+		struct ibv_wc wc = {0};
+		size_t len = 0;
+		struct fake_qp *peer = __atomic_load_n(&qp->peer,
+				__ATOMIC_ACQUIRE);
+
+		if (peer) {
+			wc.status = fake_execute(peer, wr, &wc.opcode, &len);
+		} else {
+			/* the work requests of a QP in the error state */
+			wc.opcode = IBV_WC_SEND;
+			wc.status = IBV_WC_WR_FLUSH_ERR;
+		}
+
+		if (wc.status == IBV_WC_SUCCESS &&
+				!(wr->send_flags & IBV_SEND_SIGNALED))
+			continue;
+
+		wc.wr_id = wr->wr_id;
+		wc.qp_num = ibv_qp->qp_num;
+		wc.byte_len = (uint32_t)len;
+		fake_cq_push(ibv_qp->send_cq, &wc);
+	}
+
+	*bad_wr = NULL;
+
+	return 0;
+}
+
+/*
+ * fake_post_recv -- the post_recv operation of the fake device
+ */
+static int
+fake_post_recv(struct ibv_qp *ibv_qp, struct ibv_recv_wr *wr,
+		struct ibv_recv_wr **bad_wr)
+{
+	struct fake_qp *qp = (struct fake_qp *)ibv_qp;
+	int ret = 0;
+
+	pthread_spin_lock(&qp->lock);
+	for (; wr; wr = wr->next) {
+		if (qp->tail - qp->head == qp->size ||
+				wr->num_sge > FAKE_RECV_SGE_MAX) {
+			ret = ENOMEM;
+			break;
+		}
+
+		struct fake_recv *recv = &qp->recvs[qp->tail % qp->size];
+		recv->wr_id = wr->wr_id;
+		recv->num_sge = wr->num_sge;
+		memcpy(recv->sg_list, wr->sg_list,
+				(size_t)wr->num_sge * sizeof(*wr->sg_list));
+		qp->tail++;
+	}
+	pthread_spin_unlock(&qp->lock);
+
+	*bad_wr = wr;
+
+	return ret;
+}
+
+/* the device */
+
+/*
+ * fake_query_device_ex -- the query_device_ex operation of the fake device
+ */
+static int
+fake_query_device_ex(struct ibv_context *context,
+		const struct ibv_query_device_ex_input *input,
+		struct ibv_device_attr_ex *attr, size_t attr_size)
+{
+	memset(attr, 0, attr_size);
+	(void) ibv_query_device(context, &attr->orig_attr);
+
+	/* the fake memory regions do not have to be pinned */
+	if (attr_size >= offsetof(struct ibv_device_attr_ex, odp_caps) +
+			sizeof(attr->odp_caps)) {
+		attr->odp_caps.general_caps = IBV_ODP_SUPPORT;
+		attr->odp_caps.per_transport_caps.rc_odp_caps =
+				IBV_ODP_SUPPORT_SEND | IBV_ODP_SUPPORT_RECV |
+				IBV_ODP_SUPPORT_WRITE | IBV_ODP_SUPPORT_READ;
+	}
+
+	return 0;
+}
+
+/*
+ * fake_advise_mr -- the advise_mr operation of the fake device
+ */
+static int
+fake_advise_mr(struct ibv_pd *pd, enum ibv_advise_mr_advice advice,
+		uint32_t flags, struct ibv_sge *sg_list, uint32_t num_sges)
+{
+	return 0;
+}
+
+/*
+ * fake_alloc_mw -- the alloc_mw operation of the fake device
+ */
+static struct ibv_mw *
+fake_alloc_mw(struct ibv_pd *pd, enum ibv_mw_type type)
+{
+	struct ibv_mw *mw = calloc(1, sizeof(*mw));
+	if (mw == NULL)
+		return NULL;
+
+	mw->context = pd->context;
+	mw->pd = pd;
+	mw->type = type;
+	/* the 8 least significant bits are the tag of the binding */
+	mw->handle = __atomic_add_fetch(&Fake.next_key, 1, __ATOMIC_RELAXED);
+	mw->rkey = mw->handle << 8;
+
+	return mw;
+}
+
+/*
+ * fake_dealloc_mw -- the dealloc_mw operation of the fake device
+ */
+static int
+fake_dealloc_mw(struct ibv_mw *mw)
+{
+	free(mw);
+
+	return 0;
+}
+
+/*
+ * fake_context_init -- initialize the context of the fake device
+ */
+static void
+fake_context_init(void)
+{
+	struct verbs_context *vctx = &Fake.vctx;
+
+	vctx->sz = sizeof(*vctx);
+	vctx->query_device_ex = fake_query_device_ex;
+	vctx->advise_mr = fake_advise_mr;
+	vctx->context.device = &Fake.device;
+	vctx->context.abi_compat = __VERBS_ABI_IS_EXTENDED;
+	vctx->context.num_comp_vectors = 1;
+	vctx->context.cmd_fd = -1;
+	vctx->context.async_fd = -1;
+	vctx->context.ops.poll_cq = fake_poll_cq;
+	vctx->context.ops.req_notify_cq = fake_req_notify_cq;
+	vctx->context.ops.post_send = fake_post_send;
+	vctx->context.ops.post_recv = fake_post_recv;
+	vctx->context.ops.alloc_mw = fake_alloc_mw;
+	vctx->context.ops.dealloc_mw = fake_dealloc_mw;
+	pthread_mutex_init(&vctx->context.mutex, NULL);
+}
+
+/*
+ * fake_context -- the context of the fake device
+ */
+static struct ibv_context *
+fake_context(void)
+{
+	static pthread_once_t once = PTHREAD_ONCE_INIT;
+
+	(void) pthread_once(&once, fake_context_init);
+
+	return &Fake.vctx.context;
+}
+
+/* libibverbs */
+
+int
+ibv_query_device(struct ibv_context *context,
+		struct ibv_device_attr *device_attr)
+{
+	memset(device_attr, 0, sizeof(*device_attr));
+	(void) strcpy(device_attr->fw_ver, "0.0.0");
+	device_attr->max_mr_size = UINT64_MAX;
+	device_attr->page_size_cap = (uint64_t)sysconf(_SC_PAGESIZE);
+	device_attr->max_qp = 1 << 16;
+	device_attr->max_qp_wr = 1 << 15;
+	device_attr->max_sge = FAKE_RECV_SGE_MAX;
+	device_attr->max_cq = 1 << 16;
+	device_attr->max_cqe = 1 << 20;
+	device_attr->max_mr = 1 << 20;
+	device_attr->max_pd = 1 << 16;
+	device_attr->max_qp_rd_atom = 128;
+	device_attr->max_qp_init_rd_atom = 128;
+	device_attr->atomic_cap = IBV_ATOMIC_HCA;
+	device_attr->phys_port_cnt = 1;
+
+	return 0;
+}
+
+struct ibv_pd *
+ibv_alloc_pd(struct ibv_context *context)
+{
+	struct ibv_pd *pd = calloc(1, sizeof(*pd));
+	if (pd == NULL)
+		return NULL;
+
+	pd->context = context;
+
+	return pd;
+}
+
+int
+ibv_dealloc_pd(struct ibv_pd *pd)
+{
+	free(pd);
+
+	return 0;
+}
+
+/* ibv_reg_mr() is a macro of verbs.h calling the function */
+#undef ibv_reg_mr
+
+struct ibv_mr *
+ibv_reg_mr_iova2(struct ibv_pd *pd, void *addr, size_t length, uint64_t iova,
+		unsigned access)
+{
+	struct ibv_mr *mr = calloc(1, sizeof(*mr));
+	if (mr == NULL)
+		return NULL;
+
+	mr->context = pd->context;
+	mr->pd = pd;
+	mr->addr = addr;
+	mr->length = length;
+	mr->handle = __atomic_add_fetch(&Fake.next_key, 1, __ATOMIC_RELAXED);
+	mr->lkey = mr->handle;
+	mr->rkey = mr->handle;
+
+	return mr;
+}
+
+struct ibv_mr *
+ibv_reg_mr(struct ibv_pd *pd, void *addr, size_t length, int access)
+{
+	return ibv_reg_mr_iova2(pd, addr, length, (uintptr_t)addr,
+			(unsigned)access);
+}
+
+int
+ibv_dereg_mr(struct ibv_mr *mr)
+{
+	free(mr);
+
+	return 0;
+}
+
+struct ibv_comp_channel *
+ibv_create_comp_channel(struct ibv_context *context)
+{
+	struct fake_comp_channel *fch = calloc(1, sizeof(*fch));
+	if (fch == NULL)
+		return NULL;
+
+	if (fake_pipe(&fch->ch.fd, &fch->wfd)) {
+		free(fch);
+		return NULL;
+	}
+
+	fch->ch.context = context;
+
+	return &fch->ch;
+}
+
+int
+ibv_destroy_comp_channel(struct ibv_comp_channel *channel)
+{
+	struct fake_comp_channel *fch = (struct fake_comp_channel *)channel;
+
+	(void) close(fch->ch.fd);
+	(void) close(fch->wfd);
+	free(fch);
+
+	return 0;
+}
+
+struct ibv_cq *
+ibv_create_cq(struct ibv_context *context, int cqe, void *cq_context,
+		struct ibv_comp_channel *channel, int comp_vector)
+{
+	if (cqe <= 0) {
+		errno = EINVAL;
+		return NULL;
+	}
+
+	struct fake_cq *cq = calloc(1, sizeof(*cq));
+	if (cq == NULL)
+		return NULL;
+
+	cq->size = (unsigned)cqe;
+	cq->wcs = calloc(cq->size, sizeof(*cq->wcs));
+	if (cq->wcs == NULL) {
+		free(cq);
+		return NULL;
+	}
+
+	(void) pthread_spin_init(&cq->lock, PTHREAD_PROCESS_PRIVATE);
+	cq->cq.context = context;
+	cq->cq.channel = channel;
+	cq->cq.cq_context = cq_context;
+	cq->cq.cqe = cqe;
+
+	return &cq->cq;
+}
+
+int
+ibv_destroy_cq(struct ibv_cq *ibv_cq)
+{
+	struct fake_cq *cq = (struct fake_cq *)ibv_cq;
+
+	(void) pthread_spin_destroy(&cq->lock);
+	free(cq->wcs);
+	free(cq);
+
+	return 0;
+}
+
+int
+ibv_get_cq_event(struct ibv_comp_channel *channel, struct ibv_cq **cq,
+		void **cq_context)
+{
+	if (fake_pipe_read_ptr(channel->fd, (void **)cq))
+		return -1;
+
+	*cq_context = (*cq)->cq_context;
+
+	return 0;
+}
+
+void
+ibv_ack_cq_events(struct ibv_cq *cq, unsigned nevents)
+{
+	/* the events are not counted */
+}
+
+/* librdmacm */
+
+/*
+ * fake_port -- the port of the address
+ */
+static uint16_t
+fake_port(const struct sockaddr *addr)
+{
+	if (addr == NULL)
+		return 0;
+
+	if (addr->sa_family == AF_INET6)
+		return ntohs(((const struct sockaddr_in6 *)addr)->sin6_port);
+
+	return ntohs(((const struct sockaddr_in *)addr)->sin_port);
+}
+
+/*
+ * fake_event_post -- pass a new event of the CM ID to its event channel
+ * (the event of a CM ID without an event channel is dropped)
+ */
+static int
+fake_event_post(struct rdma_cm_id *id, struct rdma_cm_id *listen_id,
+		enum rdma_cm_event_type type, int status,
+		const void *private_data, uint8_t private_data_len)
+{
+	struct rdma_event_channel *channel = listen_id ?
+			listen_id->channel : id->channel;
+	if (channel == NULL)
+		return 0;
+
+	struct fake_event *fev = calloc(1, sizeof(*fev));
+	if (fev == NULL)
+		return -1;
+
+	fev->ev.id = id;
+	fev->ev.listen_id = listen_id;
+	fev->ev.event = type;
+	fev->ev.status = status;
+	if (private_data && private_data_len) {
+		memcpy(fev->private_data, private_data, private_data_len);
+		fev->ev.param.conn.private_data = fev->private_data;
+		fev->ev.param.conn.private_data_len = private_data_len;
+	}
+
+	struct fake_evch *fevch = (struct fake_evch *)channel;
+	if (fake_pipe_write_ptr(fevch->wfd, fev)) {
+		free(fev);
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * fake_unlink -- disconnect the QPs of the connection and forget the other
+ * side of it (the caller holds Fake.lock)
+ */
+static void
+fake_unlink(struct fake_id *fid)
+{
+	struct fake_id *peer = fid->peer;
+
+	if (fid->id.qp)
+		__atomic_store_n(&((struct fake_qp *)fid->id.qp)->peer, NULL,
+				__ATOMIC_RELEASE);
+
+	if (peer) {
+		if (peer->id.qp)
+			__atomic_store_n(&((struct fake_qp *)peer->id.qp)->peer,
+					NULL, __ATOMIC_RELEASE);
+		peer->peer = NULL;
+		peer->connected = 0;
+	}
+
+	fid->peer = NULL;
+	fid->connected = 0;
+}
+
+struct rdma_event_channel *
+rdma_create_event_channel(void)
+{
+	struct fake_evch *fevch = calloc(1, sizeof(*fevch));
+	if (fevch == NULL)
+		return NULL;
+
+	if (fake_pipe(&fevch->ch.fd, &fevch->wfd)) {
+		free(fevch);
+		return NULL;
+	}
+
+	return &fevch->ch;
+}
+
+void
+rdma_destroy_event_channel(struct rdma_event_channel *channel)
+{
+	struct fake_evch *fevch = (struct fake_evch *)channel;
+	void *fev;
+
+	/* free the events which have not been got */
+	(void) fcntl(channel->fd, F_SETFL, O_NONBLOCK);
+	while (fake_pipe_read_ptr(channel->fd, &fev) == 0)
+		free(fev);
+
+	(void) close(fevch->ch.fd);
+	(void) close(fevch->wfd);
+	free(fevch);
+}
+
+int
+rdma_create_id(struct rdma_event_channel *channel, struct rdma_cm_id **id,
+		void *context, enum rdma_port_space ps)
+{
+	struct fake_id *fid = calloc(1, sizeof(*fid));
+	if (fid == NULL)
+		return -1;
+
+	fid->id.channel = channel;
+	fid->id.context = context;
+	fid->id.ps = ps;
+	fid->id.qp_type = IBV_QPT_RC;
+	*id = &fid->id;
+
+	return 0;
+}
+
+int
+rdma_destroy_id(struct rdma_cm_id *id)
+{
+	struct fake_id *fid = (struct fake_id *)id;
+
+	pthread_mutex_lock(&Fake.lock);
+	if (fid->listening) {
+		for (int i = 0; i < FAKE_LISTENERS_MAX; i++) {
+			if (Fake.listeners[i] == fid)
+				Fake.listeners[i] = NULL;
+		}
+	}
+	fake_unlink(fid);
+	pthread_mutex_unlock(&Fake.lock);
+
+	free(fid);
+
+	return 0;
+}
+
+int
+rdma_getaddrinfo(
+#ifdef RDMA_GETADDRINFO_OLD_SIGNATURE
+		char *node, char *service,
+#else
+		const char *node, const char *service,
+#endif
+		const struct rdma_addrinfo *hints, struct rdma_addrinfo **res)
+{
+	struct sockaddr_in *sin = calloc(1, sizeof(*sin));
+	struct rdma_addrinfo *rai = calloc(1, sizeof(*rai));
+	char *canonname = node ? strdup(node) : NULL;
+	if (sin == NULL || rai == NULL || (node && canonname == NULL))
+		goto err_free;
+
+	sin->sin_family = AF_INET;
+	if (node && inet_pton(AF_INET, node, &sin->sin_addr) != 1) {
+		free(sin);
+		free(rai);
+		free(canonname);
+		return EAI_NONAME;
+	}
+	if (service)
+		sin->sin_port = htons((uint16_t)strtoul(service, NULL, 10));
+
+	rai->ai_family = AF_INET;
+	rai->ai_qp_type = hints ? hints->ai_qp_type : IBV_QPT_RC;
+	rai->ai_port_space = hints ? hints->ai_port_space : RDMA_PS_TCP;
+	if (hints && (hints->ai_flags & RAI_PASSIVE)) {
+		rai->ai_flags = RAI_PASSIVE;
+		rai->ai_src_addr = (struct sockaddr *)sin;
+		rai->ai_src_len = sizeof(*sin);
+		rai->ai_src_canonname = canonname;
+	} else {
+		rai->ai_dst_addr = (struct sockaddr *)sin;
+		rai->ai_dst_len = sizeof(*sin);
+		rai->ai_dst_canonname = canonname;
+	}
+	*res = rai;
+
+	return 0;
+
+err_free:
+	free(sin);
+	free(rai);
+	free(canonname);
+	return EAI_SYSTEM;
+}
+
+void
+rdma_freeaddrinfo(struct rdma_addrinfo *res)
+{
+	free(res->ai_src_canonname);
+	free(res->ai_dst_canonname);
+	free(res->ai_src_addr);
+	free(res->ai_dst_addr);
+	free(res);
+}
+
+int
+rdma_bind_addr(struct rdma_cm_id *id, struct sockaddr *addr)
+{
+	((struct fake_id *)id)->port = fake_port(addr);
+	id->verbs = fake_context();
+
+	return 0;
+}
+
+int
+rdma_resolve_addr(struct rdma_cm_id *id, struct sockaddr *src_addr,
+		struct sockaddr *dst_addr, int timeout_ms)
+{
+	((struct fake_id *)id)->port = fake_port(dst_addr);
+	id->verbs = fake_context();
+
+	return fake_event_post(id, NULL, RDMA_CM_EVENT_ADDR_RESOLVED, 0,
+			NULL, 0);
+}
+
+int
+rdma_resolve_route(struct rdma_cm_id *id, int timeout_ms)
+{
+	return fake_event_post(id, NULL, RDMA_CM_EVENT_ROUTE_RESOLVED, 0,
+			NULL, 0);
+}
+
+int
+rdma_create_qp(struct rdma_cm_id *id, struct ibv_pd *pd,
+		struct ibv_qp_init_attr *qp_init_attr)
+{
+	struct fake_qp *qp = calloc(1, sizeof(*qp));
+	if (qp == NULL)
+		return -1;
+
+	qp->size = qp_init_attr->cap.max_recv_wr ?
+			qp_init_attr->cap.max_recv_wr : FAKE_RQ_SIZE_DEFAULT;
+	qp->recvs = calloc(qp->size, sizeof(*qp->recvs));
+	if (qp->recvs == NULL) {
+		free(qp);
+		return -1;
+	}
+
+	(void) pthread_spin_init(&qp->lock, PTHREAD_PROCESS_PRIVATE);
+	qp->qp.context = id->verbs;
+	qp->qp.qp_context = qp_init_attr->qp_context;
+	qp->qp.pd = pd;
+	qp->qp.send_cq = qp_init_attr->send_cq;
+	qp->qp.recv_cq = qp_init_attr->recv_cq;
+	qp->qp.srq = qp_init_attr->srq;
+	qp->qp.qp_num = __atomic_add_fetch(&Fake.next_qp_num, 1,
+			__ATOMIC_RELAXED);
+	qp->qp.state = IBV_QPS_RTS;
+	qp->qp.qp_type = qp_init_attr->qp_type;
+
+	id->qp = &qp->qp;
+	id->pd = pd;
+	id->send_cq = qp_init_attr->send_cq;
+	id->recv_cq = qp_init_attr->recv_cq;
+
+	return 0;
+}
+
+void
+rdma_destroy_qp(struct rdma_cm_id *id)
+{
+	struct fake_qp *qp = (struct fake_qp *)id->qp;
+	if (qp == NULL)
+		return;
+
+	pthread_mutex_lock(&Fake.lock);
+	struct fake_id *peer = ((struct fake_id *)id)->peer;
+	if (peer && peer->id.qp)
+		__atomic_store_n(&((struct fake_qp *)peer->id.qp)->peer, NULL,
+				__ATOMIC_RELEASE);
+	id->qp = NULL;
+	pthread_mutex_unlock(&Fake.lock);
+
+	(void) pthread_spin_destroy(&qp->lock);
+	free(qp->recvs);
+	free(qp);
+}
+
+int
+rdma_listen(struct rdma_cm_id *id, int backlog)
+{
+	struct fake_id *fid = (struct fake_id *)id;
+	int slot = -1;
+
+	pthread_mutex_lock(&Fake.lock);
+	for (int i = 0; i < FAKE_LISTENERS_MAX; i++) {
+		if (Fake.listeners[i] == NULL) {
+			if (slot < 0)
+				slot = i;
+		} else if (Fake.listeners[i]->port == fid->port) {
+			pthread_mutex_unlock(&Fake.lock);
+			errno = EADDRINUSE;
+			return -1;
+		}
+	}
+	if (slot < 0) {
+		pthread_mutex_unlock(&Fake.lock);
+		errno = ENOMEM;
+		return -1;
+	}
+	Fake.listeners[slot] = fid;
+	fid->listening = 1;
+	pthread_mutex_unlock(&Fake.lock);
+
+	return 0;
+}
+
+int
+rdma_connect(struct rdma_cm_id *id, struct rdma_conn_param *conn_param)
+{
+	struct fake_id *fid = (struct fake_id *)id;
+	struct fake_id *listener = NULL;
+	int ret;
+
+	pthread_mutex_lock(&Fake.lock);
+	for (int i = 0; i < FAKE_LISTENERS_MAX; i++) {
+		if (Fake.listeners[i] && Fake.listeners[i]->port == fid->port)
+			listener = Fake.listeners[i];
+	}
+	if (listener == NULL) {
+		ret = fake_event_post(id, NULL, RDMA_CM_EVENT_REJECTED,
+				ECONNREFUSED, NULL, 0);
+		pthread_mutex_unlock(&Fake.lock);
+		return ret;
+	}
+
+	/* the passive side of the connection */
+	struct fake_id *pfid = calloc(1, sizeof(*pfid));
+	if (pfid == NULL) {
+		pthread_mutex_unlock(&Fake.lock);
+		return -1;
+	}
+	pfid->id.verbs = fake_context();
+	pfid->id.channel = listener->id.channel;
+	pfid->id.context = listener->id.context;
+	pfid->id.ps = listener->id.ps;
+	pfid->id.qp_type = IBV_QPT_RC;
+	pfid->port = fid->port;
+	pfid->listener = listener;
+	pfid->peer = fid;
+	fid->peer = pfid;
+
+	ret = fake_event_post(&pfid->id, &listener->id,
+			RDMA_CM_EVENT_CONNECT_REQUEST, 0,
+			conn_param ? conn_param->private_data : NULL,
+			conn_param ? conn_param->private_data_len : 0);
+	if (ret) {
+		fid->peer = NULL;
+		free(pfid);
+	}
+	pthread_mutex_unlock(&Fake.lock);
+
+	return ret;
+}
+
+int
+rdma_accept(struct rdma_cm_id *id, struct rdma_conn_param *conn_param)
+{
+	struct fake_id *fid = (struct fake_id *)id;
+	int ret;
+
+	pthread_mutex_lock(&Fake.lock);
+	struct fake_id *peer = fid->peer;
+	if (peer == NULL || id->qp == NULL || peer->id.qp == NULL) {
+		pthread_mutex_unlock(&Fake.lock);
+		errno = peer ? EINVAL : ECONNABORTED;
+		return -1;
+	}
+
+	__atomic_store_n(&((struct fake_qp *)id->qp)->peer,
+			(struct fake_qp *)peer->id.qp, __ATOMIC_RELEASE);
+	__atomic_store_n(&((struct fake_qp *)peer->id.qp)->peer,
+			(struct fake_qp *)id->qp, __ATOMIC_RELEASE);
+	fid->connected = 1;
+	peer->connected = 1;
+
+	ret = fake_event_post(&peer->id, NULL, RDMA_CM_EVENT_ESTABLISHED, 0,
+			conn_param ? conn_param->private_data : NULL,
+			conn_param ? conn_param->private_data_len : 0);
+
+	/* delivered to the event channel the ID is migrated to */
+	fid->established_pending = 1;
+	pthread_mutex_unlock(&Fake.lock);
+
+	return ret;
+}
+
+int
+rdma_reject(struct rdma_cm_id *id, const void *private_data,
+		uint8_t private_data_len)
+{
+	struct fake_id *fid = (struct fake_id *)id;
+	int ret = 0;
+
+	pthread_mutex_lock(&Fake.lock);
+	if (fid->peer)
+		ret = fake_event_post(&fid->peer->id, NULL,
+				RDMA_CM_EVENT_REJECTED, 0, private_data,
+				private_data_len);
+	fake_unlink(fid);
+	pthread_mutex_unlock(&Fake.lock);
+
+	return ret;
+}
+
+int
+rdma_disconnect(struct rdma_cm_id *id)
+{
+	struct fake_id *fid = (struct fake_id *)id;
+	int ret = 0;
+
+	pthread_mutex_lock(&Fake.lock);
+	/* both sides get a single DISCONNECTED event */
+	if (fid->connected) {
+		struct fake_id *peer = fid->peer;
+
+		fake_unlink(fid);
+		ret = fake_event_post(id, NULL, RDMA_CM_EVENT_DISCONNECTED, 0,
+				NULL, 0);
+		if (peer)
+			ret |= fake_event_post(&peer->id, NULL,
+					RDMA_CM_EVENT_DISCONNECTED, 0, NULL, 0);
+	}
+	pthread_mutex_unlock(&Fake.lock);
+
+	return ret;
+}
+
+int
+rdma_get_cm_event(struct rdma_event_channel *channel,
+		struct rdma_cm_event **event)
+{
+	void *fev;
+
+	if (fake_pipe_read_ptr(channel->fd, &fev)) {
+		if (errno == EAGAIN)
+			errno = ENODATA;
+		return -1;
+	}
+
+	*event = fev;
+
+	return 0;
+}
+
+int
+rdma_ack_cm_event(struct rdma_cm_event *event)
+{
+	free(event);
+
+	return 0;
+}
+
+int
+rdma_migrate_id(struct rdma_cm_id *id, struct rdma_event_channel *channel)
+{
+	struct fake_id *fid = (struct fake_id *)id;
+	int ret = 0;
+
+	pthread_mutex_lock(&Fake.lock);
+	id->channel = channel;
+	if (fid->established_pending && channel) {
+		fid->established_pending = 0;
+		if (fid->connected)
+			ret = fake_event_post(id, NULL,
+					RDMA_CM_EVENT_ESTABLISHED, 0, NULL, 0);
+	}
+	pthread_mutex_unlock(&Fake.lock);
+
+	return ret;
+}
+
+const char *
+rdma_event_str(enum rdma_cm_event_type event)
+{
+	switch (event) {
+	case RDMA_CM_EVENT_ADDR_RESOLVED:
+		return "RDMA_CM_EVENT_ADDR_RESOLVED";
+	case RDMA_CM_EVENT_ROUTE_RESOLVED:
+		return "RDMA_CM_EVENT_ROUTE_RESOLVED";
+	case RDMA_CM_EVENT_CONNECT_REQUEST:
+		return "RDMA_CM_EVENT_CONNECT_REQUEST";
+	case RDMA_CM_EVENT_REJECTED:
+		return "RDMA_CM_EVENT_REJECTED";
+	case RDMA_CM_EVENT_ESTABLISHED:
+		return "RDMA_CM_EVENT_ESTABLISHED";
+	case RDMA_CM_EVENT_DISCONNECTED:
+		return "RDMA_CM_EVENT_DISCONNECTED";
+	default:
+		return "UNKNOWN EVENT";
+	}
+}
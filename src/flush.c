@@ -15,6 +15,7 @@
 #include "cmocka_alloc.h"
 #endif
 
+#include "common.h"
 #include "debug.h"
 #include "flush.h"
 #include "log_internal.h"
@@ -33,6 +34,9 @@ struct rpma_flush_internal {
 	rpma_flush_func flush_func;
 	rpma_flush_delete_func delete_func;
 	void *context;
+
+	uint64_t ops; /* number of posted flush operations */
+	uint64_t bytes; /* number of bytes requested to be flushed */
 };
 
 /*
@@ -146,8 +150,15 @@ rpma_flush_apm_do(struct ibv_qp *qp, struct rpma_flush *flush,
 	struct flush_apm *flush_apm =
 			(struct flush_apm *)flush_internal->context;
 
-	return rpma_mr_read(qp, flush_apm->raw_mr, 0, dst, dst_offset,
+	int ret = rpma_mr_read(qp, flush_apm->raw_mr, 0, dst, dst_offset,
 			RAW_SIZE, flags, op_context);
+	if (ret)
+		return ret;
+
+	RPMA_STATS_INC(flush_internal->ops);
+	RPMA_STATS_ADD(flush_internal->bytes, len);
+
+	return 0;
 }
 
 /* internal librpma API */
@@ -171,6 +182,11 @@ rpma_flush_new(struct rpma_peer *peer, struct rpma_flush **flush_ptr)
 		return ret;
 	}
 
+	struct rpma_flush_internal *flush_internal =
+			(struct rpma_flush_internal *)flush;
+	flush_internal->ops = 0;
+	flush_internal->bytes = 0;
+
 	*flush_ptr = flush;
 
 	return 0;
@@ -194,3 +210,30 @@ rpma_flush_delete(struct rpma_flush **flush_ptr)
 	RPMA_FAULT_INJECTION(RPMA_E_INVAL, {});
 	return ret;
 }
+
+/*
+ * rpma_flush_get_stats -- get the flush statistics counters
+ */
+void
+rpma_flush_get_stats(const struct rpma_flush *flush, uint64_t *ops,
+		uint64_t *bytes)
+{
+	const struct rpma_flush_internal *flush_internal =
+			(const struct rpma_flush_internal *)flush;
+
+	*ops = RPMA_STATS_GET(flush_internal->ops);
+	*bytes = RPMA_STATS_GET(flush_internal->bytes);
+}
+
+/*
+ * rpma_flush_reset_stats -- reset the flush statistics counters
+ */
+void
+rpma_flush_reset_stats(struct rpma_flush *flush)
+{
+	struct rpma_flush_internal *flush_internal =
+			(struct rpma_flush_internal *)flush;
+
+	RPMA_STATS_RESET(flush_internal->ops);
+	RPMA_STATS_RESET(flush_internal->bytes);
+}
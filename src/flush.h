@@ -38,4 +38,28 @@ int rpma_flush_new(struct rpma_peer *peer, struct rpma_flush **flush_ptr);
  */
 int rpma_flush_delete(struct rpma_flush **flush_ptr);
 
+/*
+ * rpma_flush_get_stats -- get the number of posted flush operations
+ * and the number of bytes requested to be flushed
+ *
+ * ASSUMPTIONS
+ * - flush != NULL && ops != NULL && bytes != NULL
+ *
+ * ERRORS
+ * rpma_flush_get_stats() cannot fail.
+ */
+void rpma_flush_get_stats(const struct rpma_flush *flush, uint64_t *ops,
+		uint64_t *bytes);
+
+/*
+ * rpma_flush_reset_stats -- zero the flush statistics counters
+ *
+ * ASSUMPTIONS
+ * - flush != NULL
+ *
+ * ERRORS
+ * rpma_flush_reset_stats() cannot fail.
+ */
+void rpma_flush_reset_stats(struct rpma_flush *flush);
+
 #endif /* LIBRPMA_FLUSH_H */
@@ -174,6 +174,29 @@ extern "C" {
  * rpma_mr_remote_from_descriptor(). It creates a remote memory region's
  * structure that allows for Remote Memory Access.
  *
+ * Many memory regions can be described at once using
+ * rpma_mr_get_descriptors(), which creates a table of descriptors.
+ * The table is decoded using rpma_mr_remote_array_from_descriptors()
+ * into an array of remote memory regions created with a single allocation.
+ * A remote memory region containing the given remote address can be found
+ * in the array using rpma_mr_remote_array_find().
+ *
+ * The connection's private data can carry only a few descriptors. In order
+ * to transfer any number of memory region descriptors together with
+ * the peer configuration descriptor, the descriptors can be encoded into
+ * a registered buffer using rpma_meta_new(). Only the descriptor of this
+ * buffer (see rpma_meta_get_descriptor()) is transferred in the private data
+ * and the other side reads the whole buffer using a single rpma_read()
+ * and decodes it using rpma_meta_decode().
+ *
+ * An access to a range of a memory region registered with
+ * RPMA_MR_USAGE_MW_BIND can be granted to the other side of a connection
+ * without registering the range again using a memory window (see
+ * rpma_mw_new()). The memory window is bound to the range using
+ * rpma_bind_mw() and its descriptor (see rpma_mw_get_descriptor()) is
+ * decoded using rpma_mr_remote_from_descriptor() as the descriptor of
+ * a memory region. The access is revoked using rpma_invalidate_mw().
+ *
  * MESSAGING
  *
  * The librpma messaging API allows transferring messages
@@ -359,6 +382,13 @@ extern "C" {
  * can write messages to syslog(3) and stderr(3).
  * The logging threshold level can be set or got using
  * rpma_log_set_threshold() or rpma_log_get_threshold() respectively.
+ * The default logging function can write the messages from a background
+ * thread instead of the calling one, see rpma_log_async_start().
+ * The messages of the levels less severe than the one the library was built
+ * with (the RPMA_LOG_MIN_LEVEL CMake variable, RPMA_LOG_LEVEL_DEBUG
+ * by default) are compiled out and cannot be enabled at runtime.
+ * The optional librpma_release flavor of the library is built with only
+ * RPMA_LOG_LEVEL_FATAL messages compiled in.
  *
  * There is an example of the usage of the logging functions:
  * https://github.com/pmem/rpma/tree/master/examples/log
@@ -800,6 +830,7 @@ struct rpma_mr_remote;
 #define RPMA_MR_USAGE_FLUSH_TYPE_PERSISTENT	(1 << 5)
 #define RPMA_MR_USAGE_SEND			(1 << 6)
 #define RPMA_MR_USAGE_RECV			(1 << 7)
+#define RPMA_MR_USAGE_MW_BIND			(1 << 8)
 
 /** 3
  * rpma_mr_reg - create a local memory registration object
@@ -829,6 +860,8 @@ struct rpma_mr_remote;
  * persistent flush operation
  * - RPMA_MR_USAGE_SEND - memory used for send operation
  * - RPMA_MR_USAGE_RECV - memory used for receive operation
+ * - RPMA_MR_USAGE_MW_BIND - memory the memory windows can be bound to
+ * (please see rpma_bind_mw(3))
  *
  * RETURN VALUE
  * The rpma_mr_reg() function returns 0 on success or a negative error code
@@ -1117,9 +1150,11 @@ int rpma_mr_remote_get_flush_type(const struct rpma_mr_remote *mr,
  * does not set *mr_ptr value to NULL on failure.
  *
  * ERRORS
- * rpma_mr_remote_delete() can fail with the following error:
+ * rpma_mr_remote_delete() can fail with the following errors:
  *
  * - RPMA_E_INVAL - mr_ptr is NULL
+ * - RPMA_E_INVAL - *mr_ptr is a part of an array of remote memory regions
+ * (see rpma_mr_remote_array_from_descriptors(3))
  *
  * SEE ALSO
  * rpma_mr_remote_from_descriptor(3), librpma(7) and https://pmem.io/rpma/
@@ -1127,787 +1162,1916 @@ int rpma_mr_remote_get_flush_type(const struct rpma_mr_remote *mr,
 int rpma_mr_remote_delete(struct rpma_mr_remote **mr_ptr);
 
 /** 3
- * rpma_mr_advise - give advice about an address range in a memory registration
+ * rpma_mr_get_descriptors - get the descriptors of many memory regions
  *
  * SYNOPSIS
  *
  *	#include <librpma.h>
  *
- *	struct rpma_mr_local *mr;
- *	int rpma_mr_advise(struct rpma_mr_local *mr, size_t offset, size_t len,
- *		int advice, uint32_t flags);
+ *	struct rpma_mr_local;
+ *	int rpma_mr_get_descriptors(struct rpma_mr_local *const mrs[],
+ *			int mrs_num, void *desc);
  *
  * DESCRIPTION
- * rpma_mr_advise() gives advice about an address range in a memory
- * registration. The usage parameter specifies the operations that can be
- * performed on the given memory address range.
- * For available advice and flags values please see ibv_advise_mr(3).
+ * rpma_mr_get_descriptors() writes the descriptors of the mrs_num memory
+ * regions one after another (a table of descriptors) to the desc buffer,
+ * which has to be at least mrs_num times rpma_mr_get_descriptor_size(3) bytes
+ * long. On the other side of the connection the table is decoded
+ * using rpma_mr_remote_array_from_descriptors(3).
  *
  * RETURN VALUE
- * The rpma_mr_advise() function returns 0 on success or a negative error code
- * on failure.
+ * The rpma_mr_get_descriptors() function returns 0 on success or a negative
+ * error code on failure.
  *
  * ERRORS
- * rpma_mr_advise() can fail with the following errors:
+ * rpma_mr_get_descriptors() can fail with the following error:
  *
- * - RPMA_E_INVAL - in one of the following:
- *	- the requested range is out of the memory registration bounds
- *	- the memory registration usage does not allow the specific advice
- *	- the flags are invalid
- * - RPMA_E_NOSUPP - the operation is not supported by the system
- * - RPMA_E_PROVIDER - ibv_mr_advise(3) failed for other errors
+ * - RPMA_E_INVAL - mrs, any of its first mrs_num elements or desc is NULL
+ * - RPMA_E_INVAL - mrs_num is not positive
  *
  * SEE ALSO
- * rpma_mr_reg(3), ibv_mr_advise(3), librpma(7) and https://pmem.io/rpma/
+ * rpma_mr_get_descriptor(3), rpma_mr_get_descriptor_size(3),
+ * rpma_mr_remote_array_from_descriptors(3), librpma(7) and
+ * https://pmem.io/rpma/
  */
-int rpma_mr_advise(struct rpma_mr_local *mr, size_t offset, size_t len,
-		int advice, uint32_t flags);
+int rpma_mr_get_descriptors(struct rpma_mr_local *const mrs[], int mrs_num,
+		void *desc);
 
-/* connection configuration */
-
-struct rpma_conn_cfg;
+struct rpma_mr_remote_array;
 
 /** 3
- * rpma_conn_cfg_new - create a new connection configuration object
+ * rpma_mr_remote_array_from_descriptors - create an array of remote memory
+ * regions from a table of descriptors
  *
  * SYNOPSIS
  *
  *	#include <librpma.h>
  *
- *	struct rpma_conn_cfg;
- *	int rpma_conn_cfg_new(struct rpma_conn_cfg **cfg_ptr);
+ *	struct rpma_mr_remote_array;
+ *	int rpma_mr_remote_array_from_descriptors(const void *desc,
+ *			size_t desc_size,
+ *			struct rpma_mr_remote_array **array_ptr);
  *
  * DESCRIPTION
- * rpma_conn_cfg_new() creates a new connection configuration object
- * and fills it with the default values:
- *
- *	.timeout_ms = 1000
- *	.cq_size = 10
- *	.rcq_size = 0
- *	.sq_size = 10
- *	.rq_size = 10
- *	.shared_comp_channel = false
+ * rpma_mr_remote_array_from_descriptors() decodes the table of descriptors
+ * created by rpma_mr_get_descriptors(3) (or by concatenating descriptors
+ * created by rpma_mr_get_descriptor(3)) into an array of remote memory
+ * regions. All the remote memory regions are created using a single
+ * allocation. They are obtained using rpma_mr_remote_array_get(3)
+ * or rpma_mr_remote_array_find(3) and they are valid until the array
+ * is deleted using rpma_mr_remote_array_delete(3). They cannot be deleted
+ * using rpma_mr_remote_delete(3).
  *
  * RETURN VALUE
- * The rpma_conn_cfg_new() function returns 0 on success or a negative
- * error code on failure. rpma_conn_cfg_new() does not set
- * *cfg_ptr value on failure.
+ * The rpma_mr_remote_array_from_descriptors() function returns 0 on success
+ * or a negative error code on failure.
+ * rpma_mr_remote_array_from_descriptors() does not set *array_ptr value
+ * on failure.
  *
  * ERRORS
- * rpma_conn_cfg_new() can fail with the following error:
+ * rpma_mr_remote_array_from_descriptors() can fail with the following errors:
  *
- * - RPMA_E_INVAL - cfg_ptr is NULL
+ * - RPMA_E_INVAL - desc or array_ptr is NULL
+ * - RPMA_E_INVAL - desc_size is not a non-zero multiple of the size
+ * of a memory region descriptor
+ * - RPMA_E_INVAL - the usage of any of the memory regions is not set
  * - RPMA_E_NOMEM - out of memory
  *
  * SEE ALSO
- * rpma_conn_cfg_delete(3), rpma_conn_cfg_get_compl_channel(3),
- * rpma_conn_cfg_get_cq_size(3), rpma_conn_cfg_get_rq_size(3),
- * rpma_conn_cfg_get_sq_size(3), rpma_conn_cfg_get_timeout(3),
- * rpma_conn_cfg_set_compl_channel(3), rpma_conn_cfg_set_cq_size(3),
- * rpma_conn_cfg_set_rq_size(3), rpma_conn_cfg_set_sq_size(3),
- * rpma_conn_cfg_set_timeout(3), rpma_conn_req_new(3), rpma_ep_next_conn_req(3),
- * librpma(7) and https://pmem.io/rpma/
+ * rpma_mr_get_descriptors(3), rpma_mr_remote_array_delete(3),
+ * rpma_mr_remote_array_find(3), rpma_mr_remote_array_get(3),
+ * rpma_mr_remote_array_get_count(3), librpma(7) and https://pmem.io/rpma/
  */
-int rpma_conn_cfg_new(struct rpma_conn_cfg **cfg_ptr);
+int rpma_mr_remote_array_from_descriptors(const void *desc, size_t desc_size,
+		struct rpma_mr_remote_array **array_ptr);
 
 /** 3
- * rpma_conn_cfg_delete - delete the connection configuration object
+ * rpma_mr_remote_array_delete - delete an array of remote memory regions
  *
  * SYNOPSIS
  *
  *	#include <librpma.h>
  *
- *	struct rpma_conn_cfg;
- *	int rpma_conn_cfg_delete(struct rpma_conn_cfg **cfg_ptr);
+ *	struct rpma_mr_remote_array;
+ *	int rpma_mr_remote_array_delete(
+ *			struct rpma_mr_remote_array **array_ptr);
  *
  * DESCRIPTION
- * rpma_conn_cfg_delete() deletes the connection configuration object.
+ * rpma_mr_remote_array_delete() deletes the array of remote memory regions
+ * including all the remote memory regions obtained from it.
  *
  * RETURN VALUE
- * The rpma_conn_cfg_delete() function returns 0 on success or a negative
- * error code on failure. rpma_conn_cfg_delete() sets *cfg_ptr value to NULL
- * on success and on failure.
+ * The rpma_mr_remote_array_delete() function returns 0 on success
+ * or a negative error code on failure. rpma_mr_remote_array_delete()
+ * does not set *array_ptr value to NULL on failure.
  *
  * ERRORS
- * rpma_conn_cfg_delete() can fail with the following error:
+ * rpma_mr_remote_array_delete() can fail with the following error:
  *
- * - RPMA_E_INVAL - cfg_ptr is NULL
+ * - RPMA_E_INVAL - array_ptr is NULL
  *
  * SEE ALSO
- * rpma_conn_cfg_new(3), librpma(7) and https://pmem.io/rpma/
+ * rpma_mr_remote_array_from_descriptors(3), librpma(7) and
+ * https://pmem.io/rpma/
  */
-int rpma_conn_cfg_delete(struct rpma_conn_cfg **cfg_ptr);
+int rpma_mr_remote_array_delete(struct rpma_mr_remote_array **array_ptr);
 
 /** 3
- * rpma_conn_cfg_set_timeout - set connection establishment timeout
+ * rpma_mr_remote_array_get_count - get the number of remote memory regions
  *
  * SYNOPSIS
  *
  *	#include <librpma.h>
  *
- *	struct rpma_conn_cfg;
- *	int rpma_conn_cfg_set_timeout(struct rpma_conn_cfg *cfg,
- *			int timeout_ms);
+ *	struct rpma_mr_remote_array;
+ *	int rpma_mr_remote_array_get_count(
+ *			const struct rpma_mr_remote_array *array, int *count);
  *
  * DESCRIPTION
- * rpma_conn_cfg_set_timeout() sets the connection establishment timeout.
- * If this function is not called, the timeout has
- * the default value (1000) set by rpma_conn_cfg_new(3).
+ * rpma_mr_remote_array_get_count() gets the number of the remote memory
+ * regions in the array.
  *
  * RETURN VALUE
- * The rpma_conn_cfg_set_timeout() function returns 0 on success or a negative
- * error code on failure.
+ * The rpma_mr_remote_array_get_count() function returns 0 on success
+ * or a negative error code on failure. rpma_mr_remote_array_get_count()
+ * does not set *count value on failure.
  *
  * ERRORS
- * rpma_conn_cfg_set_timeout() can fail with the following error:
+ * rpma_mr_remote_array_get_count() can fail with the following error:
  *
- * - RPMA_E_INVAL - cfg is NULL or timeout_ms < 0
+ * - RPMA_E_INVAL - array or count is NULL
  *
  * SEE ALSO
- * rpma_conn_cfg_new(3), rpma_conn_cfg_get_timeout(3), librpma(7) and
- * https://pmem.io/rpma/
+ * rpma_mr_remote_array_from_descriptors(3), rpma_mr_remote_array_get(3),
+ * librpma(7) and https://pmem.io/rpma/
  */
-int rpma_conn_cfg_set_timeout(struct rpma_conn_cfg *cfg, int timeout_ms);
+int rpma_mr_remote_array_get_count(const struct rpma_mr_remote_array *array,
+		int *count);
 
 /** 3
- * rpma_conn_cfg_get_timeout - get connection establishment timeout
+ * rpma_mr_remote_array_get - get a remote memory region from the array
  *
  * SYNOPSIS
  *
  *	#include <librpma.h>
  *
- *	struct rpma_conn_cfg;
- *	int rpma_conn_cfg_get_timeout(const struct rpma_conn_cfg *cfg,
- *			int *timeout_ms);
+ *	struct rpma_mr_remote;
+ *	struct rpma_mr_remote_array;
+ *	int rpma_mr_remote_array_get(struct rpma_mr_remote_array *array,
+ *			int idx, struct rpma_mr_remote **mr_ptr);
  *
  * DESCRIPTION
- * rpma_conn_cfg_get_timeout() gets the connection establishment timeout.
+ * rpma_mr_remote_array_get() gets the remote memory region of the idx index,
+ * which is the index of its descriptor in the table of descriptors.
+ * The remote memory region is a part of the array and it cannot be deleted
+ * using rpma_mr_remote_delete(3).
  *
  * RETURN VALUE
- * The rpma_conn_cfg_get_timeout() function returns 0 on success or a negative
- * error code on failure. rpma_conn_cfg_get_timeout() does not set
- * *timeout_ms value on failure.
+ * The rpma_mr_remote_array_get() function returns 0 on success or a negative
+ * error code on failure. rpma_mr_remote_array_get() does not set *mr_ptr
+ * value on failure.
  *
  * ERRORS
- * rpma_conn_cfg_get_timeout() can fail with the following error:
+ * rpma_mr_remote_array_get() can fail with the following errors:
  *
- * - RPMA_E_INVAL - cfg or timeout_ms is NULL
+ * - RPMA_E_INVAL - array or mr_ptr is NULL
+ * - RPMA_E_INVAL - idx is out of the array bounds
  *
  * SEE ALSO
- * rpma_conn_cfg_new(3), rpma_conn_cfg_set_timeout(3), librpma(7) and
- * https://pmem.io/rpma/
+ * rpma_mr_remote_array_find(3), rpma_mr_remote_array_from_descriptors(3),
+ * rpma_mr_remote_array_get_count(3), librpma(7) and https://pmem.io/rpma/
  */
-int rpma_conn_cfg_get_timeout(const struct rpma_conn_cfg *cfg, int *timeout_ms);
+int rpma_mr_remote_array_get(struct rpma_mr_remote_array *array, int idx,
+		struct rpma_mr_remote **mr_ptr);
 
 /** 3
- * rpma_conn_cfg_set_cq_size - set CQ size for the connection
+ * rpma_mr_remote_array_find - find a remote memory region by a remote address
  *
  * SYNOPSIS
  *
  *	#include <librpma.h>
  *
- *	struct rpma_conn_cfg;
- *	int rpma_conn_cfg_set_cq_size(struct rpma_conn_cfg *cfg,
- *			uint32_t cq_size);
+ *	struct rpma_mr_remote;
+ *	struct rpma_mr_remote_array;
+ *	int rpma_mr_remote_array_find(struct rpma_mr_remote_array *array,
+ *			uint64_t raddr, size_t len,
+ *			struct rpma_mr_remote **mr_ptr, size_t *offset);
  *
  * DESCRIPTION
- * rpma_conn_cfg_set_cq_size() sets the CQ size for the connection.
- * If this function is not called, the cq_size has
- * the default value (10) set by rpma_conn_cfg_new(3).
+ * rpma_mr_remote_array_find() finds the remote memory region containing
+ * the len bytes long range of the remote addresses starting at raddr
+ * and gets the offset of raddr within the found memory region, so they can
+ * be passed directly to e.g. rpma_read(3) or rpma_write(3). The lookup is
+ * a binary search over the memory regions sorted by their addresses.
+ * If the memory regions overlap, any of the memory regions containing
+ * the whole range is found. Even a range of zero length has to start within
+ * a memory region.
  *
  * RETURN VALUE
- * The rpma_conn_cfg_set_cq_size() function returns 0 on success or a negative
- * error code on failure.
+ * The rpma_mr_remote_array_find() function returns 0 on success or a negative
+ * error code on failure. rpma_mr_remote_array_find() does not set *mr_ptr
+ * and *offset values on failure.
  *
  * ERRORS
- * rpma_conn_cfg_set_cq_size() can fail with the following error:
+ * rpma_mr_remote_array_find() can fail with the following errors:
  *
- * - RPMA_E_INVAL - cfg is NULL
+ * - RPMA_E_INVAL - array, mr_ptr or offset is NULL
+ * - RPMA_E_INVAL - no memory region contains the whole range
  *
  * SEE ALSO
- * rpma_conn_cfg_new(3), rpma_conn_cfg_get_cq_size(3), librpma(7) and
- * https://pmem.io/rpma/
+ * rpma_mr_remote_array_from_descriptors(3), rpma_mr_remote_array_get(3),
+ * rpma_read(3), rpma_write(3), librpma(7) and https://pmem.io/rpma/
  */
-int rpma_conn_cfg_set_cq_size(struct rpma_conn_cfg *cfg, uint32_t cq_size);
+int rpma_mr_remote_array_find(struct rpma_mr_remote_array *array,
+		uint64_t raddr, size_t len, struct rpma_mr_remote **mr_ptr,
+		size_t *offset);
 
 /** 3
- * rpma_conn_cfg_get_compl_channel - get if the completion event channel can be shared by CQ and RCQ
+ * rpma_mr_advise - give advice about an address range in a memory registration
  *
  * SYNOPSIS
  *
  *	#include <librpma.h>
  *
- *	struct rpma_conn_cfg;
- *	int rpma_conn_cfg_get_compl_channel(const struct rpma_conn_cfg *cfg,
- *			bool *shared);
+ *	struct rpma_mr_local *mr;
+ *	int rpma_mr_advise(struct rpma_mr_local *mr, size_t offset, size_t len,
+ *		int advice, uint32_t flags);
  *
  * DESCRIPTION
- * rpma_conn_cfg_get_compl_channel() gets if the completion event channel
- * can be shared by CQ and RCQ.
+ * rpma_mr_advise() gives advice about an address range in a memory
+ * registration. The usage parameter specifies the operations that can be
+ * performed on the given memory address range.
+ * For available advice and flags values please see ibv_advise_mr(3).
  *
  * RETURN VALUE
- * The rpma_conn_cfg_get_compl_channel() function returns 0 on success
- * or a negative error code on failure.
- * rpma_conn_cfg_get_compl_channel() does not set *shared value on failure.
+ * The rpma_mr_advise() function returns 0 on success or a negative error code
+ * on failure.
  *
  * ERRORS
- * rpma_conn_cfg_get_compl_channel() can fail with the following error:
+ * rpma_mr_advise() can fail with the following errors:
  *
- * - RPMA_E_INVAL - cfg or shared is NULL
+ * - RPMA_E_INVAL - in one of the following:
+ *	- the requested range is out of the memory registration bounds
+ *	- the memory registration usage does not allow the specific advice
+ *	- the flags are invalid
+ * - RPMA_E_NOSUPP - the operation is not supported by the system
+ * - RPMA_E_PROVIDER - ibv_mr_advise(3) failed for other errors
  *
  * SEE ALSO
- * rpma_conn_cfg_new(3), rpma_conn_wait(3), rpma_conn_cfg_set_compl_channel(3),
- * librpma(7) and https://pmem.io/rpma/
+ * rpma_mr_reg(3), ibv_mr_advise(3), librpma(7) and https://pmem.io/rpma/
  */
-int rpma_conn_cfg_get_compl_channel(const struct rpma_conn_cfg *cfg,
-		bool *shared);
+int rpma_mr_advise(struct rpma_mr_local *mr, size_t offset, size_t len,
+		int advice, uint32_t flags);
+
+/* memory windows */
+
+struct rpma_mw;
 
 /** 3
- * rpma_conn_cfg_set_compl_channel - set if the completion event channel can be shared by CQ and RCQ
+ * rpma_mw_new - create a memory window
  *
  * SYNOPSIS
  *
  *	#include <librpma.h>
  *
- *	struct rpma_conn_cfg;
- *	int rpma_conn_cfg_set_compl_channel(struct rpma_conn_cfg *cfg,
- *			bool shared);
+ *	struct rpma_peer;
+ *	struct rpma_mw;
+ *	int rpma_mw_new(struct rpma_peer *peer, struct rpma_mw **mw_ptr);
  *
  * DESCRIPTION
- * rpma_conn_cfg_set_compl_channel() sets if the completion event channel
- * can be shared by CQ and RCQ or not. The completion event channel
- * is not shared by CQ and RCQ by default. See rpma_conn_cfg_new(3) for details.
+ * rpma_mw_new() allocates a type 2 memory window in the protection domain
+ * of the peer. A memory window grants the other side of a connection
+ * an access to a range of an already registered memory region without
+ * registering the range again. The memory window does not grant any access
+ * until it is bound using rpma_bind_mw(3).
  *
  * RETURN VALUE
- * The rpma_conn_cfg_set_compl_channel() function returns 0 on success or
- * a negative error code on failure.
+ * The rpma_mw_new() function returns 0 on success or a negative error code
+ * on failure. rpma_mw_new() does not set *mw_ptr value on failure.
  *
  * ERRORS
- * rpma_conn_cfg_set_compl_channel() can fail with the following error:
+ * rpma_mw_new() can fail with the following errors:
  *
- * - RPMA_E_INVAL - cfg is NULL
+ * - RPMA_E_INVAL - peer or mw_ptr is NULL
+ * - RPMA_E_NOMEM - out of memory
+ * - RPMA_E_NOSUPP - memory windows are not supported by the device
+ * - RPMA_E_PROVIDER - ibv_alloc_mw(3) failed
  *
  * SEE ALSO
- * rpma_conn_cfg_new(3), rpma_conn_wait(3), rpma_conn_cfg_get_compl_channel(3),
- * librpma(7) and https://pmem.io/rpma/
+ * rpma_bind_mw(3), rpma_mw_delete(3), rpma_peer_new(3), librpma(7) and
+ * https://pmem.io/rpma/
  */
-int rpma_conn_cfg_set_compl_channel(struct rpma_conn_cfg *cfg, bool shared);
+int rpma_mw_new(struct rpma_peer *peer, struct rpma_mw **mw_ptr);
 
 /** 3
- * rpma_conn_cfg_get_cq_size - get CQ size for the connection
+ * rpma_mw_delete - delete a memory window
  *
  * SYNOPSIS
  *
  *	#include <librpma.h>
  *
- *	struct rpma_conn_cfg;
- *	int rpma_conn_cfg_get_cq_size(const struct rpma_conn_cfg *cfg,
- *			uint32_t *cq_size);
+ *	struct rpma_mw;
+ *	int rpma_mw_delete(struct rpma_mw **mw_ptr);
  *
  * DESCRIPTION
- * rpma_conn_cfg_get_cq_size() gets the CQ size for the connection.
+ * rpma_mw_delete() deallocates the memory window. If the memory window is
+ * bound, the access it grants is revoked.
  *
  * RETURN VALUE
- * The rpma_conn_cfg_get_cq_size() function returns 0 on success or a negative
- * error code on failure. rpma_conn_cfg_get_cq_size() does not set
- * *cq_size value on failure.
+ * The rpma_mw_delete() function returns 0 on success or a negative error code
+ * on failure. rpma_mw_delete() does not set *mw_ptr value to NULL on failure.
  *
  * ERRORS
- * rpma_conn_cfg_get_cq_size() can fail with the following error:
+ * rpma_mw_delete() can fail with the following errors:
  *
- * - RPMA_E_INVAL - cfg or cq_size is NULL
+ * - RPMA_E_INVAL - mw_ptr is NULL
+ * - RPMA_E_PROVIDER - ibv_dealloc_mw(3) failed
  *
  * SEE ALSO
- * rpma_conn_cfg_new(3), rpma_conn_cfg_set_cq_size(3), librpma(7) and
- * https://pmem.io/rpma/
+ * rpma_mw_new(3), librpma(7) and https://pmem.io/rpma/
  */
-int rpma_conn_cfg_get_cq_size(const struct rpma_conn_cfg *cfg,
-		uint32_t *cq_size);
+int rpma_mw_delete(struct rpma_mw **mw_ptr);
 
 /** 3
- * rpma_conn_cfg_set_rcq_size - set receive CQ size for the connection
+ * rpma_mw_get_descriptor_size - get size of the memory window descriptor
  *
  * SYNOPSIS
  *
  *	#include <librpma.h>
  *
- *	struct rpma_conn_cfg;
- *	int rpma_conn_cfg_set_rcq_size(struct rpma_conn_cfg *cfg,
- *			uint32_t rcq_size);
+ *	struct rpma_mw;
+ *	int rpma_mw_get_descriptor_size(const struct rpma_mw *mw,
+ *			size_t *desc_size);
  *
  * DESCRIPTION
- * rpma_conn_cfg_set_rcq_size() sets the receive CQ size for the connection.
- * Please see the rpma_conn_get_rcq() for details about the receive CQ.
- * If this function is not called, the rcq_size has
- * the default value (0) set by rpma_conn_cfg_new(3).
+ * rpma_mw_get_descriptor_size() gets size of the memory window descriptor.
+ * It is the same as the size of a memory region descriptor.
  *
  * RETURN VALUE
- * The rpma_conn_cfg_set_rcq_size() function returns 0 on success or
- * a negative error code on failure.
+ * The rpma_mw_get_descriptor_size() function returns 0 on success
+ * or a negative error code on failure. rpma_mw_get_descriptor_size()
+ * does not set *desc_size value on failure.
  *
  * ERRORS
- * rpma_conn_cfg_set_rcq_size() can fail with the following error:
+ * rpma_mw_get_descriptor_size() can fail with the following error:
  *
- * - RPMA_E_INVAL - cfg is NULL
+ * - RPMA_E_INVAL - mw or desc_size is NULL
  *
  * SEE ALSO
- * rpma_conn_cfg_get_rcq_size(3), rpma_conn_cfg_new(3), rpma_conn_get_rcq(3),
- * librpma(7) and https://pmem.io/rpma/
+ * rpma_mw_get_descriptor(3), rpma_mw_new(3), librpma(7) and
+ * https://pmem.io/rpma/
  */
-int rpma_conn_cfg_set_rcq_size(struct rpma_conn_cfg *cfg, uint32_t rcq_size);
+int rpma_mw_get_descriptor_size(const struct rpma_mw *mw, size_t *desc_size);
 
 /** 3
- * rpma_conn_cfg_get_rcq_size - get receive CQ size for the connection
+ * rpma_mw_get_descriptor - get a descriptor of a bound memory window
  *
  * SYNOPSIS
  *
  *	#include <librpma.h>
  *
- *	struct rpma_conn_cfg;
- *	int rpma_conn_cfg_get_rcq_size(const struct rpma_conn_cfg *cfg,
- *			uint32_t *rcq_size);
+ *	struct rpma_mw;
+ *	int rpma_mw_get_descriptor(const struct rpma_mw *mw, void *desc);
  *
  * DESCRIPTION
- * rpma_conn_cfg_get_rcq_size() gets the receive CQ size for the connection.
- * Please see the rpma_conn_get_rcq() for details about the receive CQ.
+ * rpma_mw_get_descriptor() writes a network-transferable description
+ * of the range of the memory region the memory window is bound to.
+ * The descriptor has the same format as the one written by
+ * rpma_mr_get_descriptor(3), so the other side decodes it using
+ * rpma_mr_remote_from_descriptor(3) and accesses the range as any other
+ * remote memory region. The descriptor is valid only after the binding
+ * of the memory window has completed successfully (see rpma_bind_mw(3))
+ * and until the memory window is invalidated, bound again or deleted.
+ * rpma_mw_get_descriptor() does not check whether the binding has completed.
  *
  * RETURN VALUE
- * The rpma_conn_cfg_get_rcq_size() function returns 0 on success or
- * a negative error code on failure. rpma_conn_cfg_get_rcq_size() does not
- * set *rcq_size value on failure.
+ * The rpma_mw_get_descriptor() function returns 0 on success or a negative
+ * error code on failure.
  *
  * ERRORS
- * rpma_conn_cfg_get_rcq_size() can fail with the following error:
+ * rpma_mw_get_descriptor() can fail with the following errors:
  *
- * - RPMA_E_INVAL - cfg or rcq_size is NULL
+ * - RPMA_E_INVAL - mw or desc is NULL
+ * - RPMA_E_INVAL - the memory window is not bound
  *
  * SEE ALSO
- * rpma_conn_cfg_new(3), rpma_conn_cfg_set_rcq_size(3), rpma_conn_get_rcq(3),
- * librpma(7) and https://pmem.io/rpma/
+ * rpma_bind_mw(3), rpma_mr_remote_from_descriptor(3),
+ * rpma_mw_get_descriptor_size(3), librpma(7) and https://pmem.io/rpma/
  */
-int rpma_conn_cfg_get_rcq_size(const struct rpma_conn_cfg *cfg,
-		uint32_t *rcq_size);
+int rpma_mw_get_descriptor(const struct rpma_mw *mw, void *desc);
+
+/* extended metadata exchange */
+
+struct rpma_meta;
 
 /** 3
- * rpma_conn_cfg_set_sq_size - set SQ size for the connection
+ * rpma_meta_new - create a metadata object
  *
  * SYNOPSIS
  *
  *	#include <librpma.h>
  *
- *	struct rpma_conn_cfg;
- *	int rpma_conn_cfg_set_sq_size(struct rpma_conn_cfg *cfg,
- *			uint32_t sq_size);
+ *	struct rpma_mr_local;
+ *	struct rpma_meta;
+ *	struct rpma_peer;
+ *	struct rpma_peer_cfg;
+ *	int rpma_meta_new(struct rpma_peer *peer,
+ *			struct rpma_mr_local *const mrs[], int mrs_num,
+ *			const struct rpma_peer_cfg *pcfg,
+ *			struct rpma_meta **meta_ptr);
  *
  * DESCRIPTION
- * rpma_conn_cfg_set_sq_size() sets the SQ size for the connection.
- * If this function is not called, the sq_size has
- * the default value (10) set by rpma_conn_cfg_new(3).
+ * rpma_meta_new() encodes the descriptors of the mrs_num memory regions
+ * and the descriptor of the peer configuration (if pcfg is not NULL)
+ * into a buffer of an arbitrary size and registers it for RDMA reads.
+ * The connection's private data is too small to carry more than a few
+ * descriptors, so only the descriptor of the metadata
+ * (see rpma_meta_get_descriptor(3)) has to be transferred in it.
+ * The other side of the connection reads the whole metadata using
+ * a single rpma_read(3) and decodes it using rpma_meta_decode(3).
+ *
+ * The metadata is a snapshot of the descriptors taken at the time
+ * of the call. The metadata object has to be kept until all the peers
+ * have read it.
  *
  * RETURN VALUE
- * The rpma_conn_cfg_set_sq_size() function returns 0 on success or a negative
- * error code on failure.
+ * The rpma_meta_new() function returns 0 on success or a negative error code
+ * on failure. rpma_meta_new() does not set *meta_ptr value on failure.
  *
  * ERRORS
- * rpma_conn_cfg_set_sq_size() can fail with the following error:
+ * rpma_meta_new() can fail with the following errors:
  *
- * - RPMA_E_INVAL - cfg is NULL
+ * - RPMA_E_INVAL - peer or meta_ptr is NULL
+ * - RPMA_E_INVAL - mrs_num is negative or bigger than 65535
+ * - RPMA_E_INVAL - mrs or any of its first mrs_num elements is NULL
+ * - RPMA_E_INVAL - mrs_num is 0 and pcfg is NULL
+ * - RPMA_E_NOMEM - out of memory
+ * - RPMA_E_PROVIDER - memory registration failed
  *
  * SEE ALSO
- * rpma_conn_cfg_new(3), rpma_conn_cfg_get_sq_size(3), librpma(7) and
- * https://pmem.io/rpma/
+ * rpma_meta_decode(3), rpma_meta_delete(3), rpma_meta_get_descriptor(3),
+ * rpma_mr_reg(3), rpma_peer_cfg_new(3), librpma(7) and https://pmem.io/rpma/
  */
-int rpma_conn_cfg_set_sq_size(struct rpma_conn_cfg *cfg, uint32_t sq_size);
+int rpma_meta_new(struct rpma_peer *peer, struct rpma_mr_local *const mrs[],
+		int mrs_num, const struct rpma_peer_cfg *pcfg,
+		struct rpma_meta **meta_ptr);
 
 /** 3
- * rpma_conn_cfg_get_sq_size - get SQ size for the connection
+ * rpma_meta_delete - delete a metadata object
  *
  * SYNOPSIS
  *
  *	#include <librpma.h>
  *
- *	struct rpma_conn_cfg;
- *	int rpma_conn_cfg_get_sq_size(const struct rpma_conn_cfg *cfg,
- *			uint32_t *sq_size);
+ *	struct rpma_meta;
+ *	int rpma_meta_delete(struct rpma_meta **meta_ptr);
  *
  * DESCRIPTION
- * rpma_conn_cfg_get_sq_size() gets the SQ size for the connection.
+ * rpma_meta_delete() deregisters the buffer of the metadata and deletes
+ * the metadata object.
  *
  * RETURN VALUE
- * The rpma_conn_cfg_get_sq_size() function returns 0 on success or a negative
- * error code on failure. rpma_conn_cfg_get_sq_size() does not set
- * *sq_size value on failure.
+ * The rpma_meta_delete() function returns 0 on success or a negative error
+ * code on failure. rpma_meta_delete() sets *meta_ptr value to NULL
+ * on success and on failure.
  *
  * ERRORS
- * rpma_conn_cfg_get_sq_size() can fail with the following error:
+ * rpma_meta_delete() can fail with the following errors:
  *
- * - RPMA_E_INVAL - cfg or sq_size is NULL
+ * - RPMA_E_INVAL - meta_ptr is NULL
+ * - RPMA_E_PROVIDER - memory deregistration failed
  *
  * SEE ALSO
- * rpma_conn_cfg_new(3), rpma_conn_cfg_set_sq_size(3), librpma(7) and
- * https://pmem.io/rpma/
+ * rpma_meta_new(3), librpma(7) and https://pmem.io/rpma/
  */
-int rpma_conn_cfg_get_sq_size(const struct rpma_conn_cfg *cfg,
-		uint32_t *sq_size);
+int rpma_meta_delete(struct rpma_meta **meta_ptr);
 
 /** 3
- * rpma_conn_cfg_set_rq_size - set RQ size for the connection
+ * rpma_meta_get_descriptor_size - get size of the metadata descriptor
  *
  * SYNOPSIS
  *
  *	#include <librpma.h>
  *
- *	struct rpma_conn_cfg;
- *	int rpma_conn_cfg_set_rq_size(struct rpma_conn_cfg *cfg,
- *			uint32_t rq_size);
+ *	struct rpma_meta;
+ *	int rpma_meta_get_descriptor_size(const struct rpma_meta *meta,
+ *			size_t *desc_size);
  *
  * DESCRIPTION
- * rpma_conn_cfg_set_rq_size() sets the RQ size for the connection.
- * If this function is not called, the rq_size has
- * the default value (10) set by rpma_conn_cfg_new(3).
+ * rpma_meta_get_descriptor_size() gets size of the metadata descriptor.
  *
  * RETURN VALUE
- * The rpma_conn_cfg_set_rq_size() function returns 0 on success or a negative
+ * The rpma_meta_get_descriptor_size() function returns 0 on success
+ * or a negative error code on failure. rpma_meta_get_descriptor_size()
+ * does not set *desc_size value on failure.
+ *
+ * ERRORS
+ * rpma_meta_get_descriptor_size() can fail with the following error:
+ *
+ * - RPMA_E_INVAL - meta or desc_size is NULL
+ *
+ * SEE ALSO
+ * rpma_meta_get_descriptor(3), rpma_meta_new(3), librpma(7) and
+ * https://pmem.io/rpma/
+ */
+int rpma_meta_get_descriptor_size(const struct rpma_meta *meta,
+		size_t *desc_size);
+
+/** 3
+ * rpma_meta_get_descriptor - get the descriptor of the metadata
+ *
+ * SYNOPSIS
+ *
+ *	#include <librpma.h>
+ *
+ *	struct rpma_meta;
+ *	int rpma_meta_get_descriptor(const struct rpma_meta *meta,
+ *			void *desc);
+ *
+ * DESCRIPTION
+ * rpma_meta_get_descriptor() writes a network-transferable description
+ * of the metadata to the desc buffer, which has to be at least
+ * rpma_meta_get_descriptor_size(3) bytes long. It is the descriptor of
+ * the registered buffer of the metadata, so on the other side
+ * of the connection it is decoded using rpma_mr_remote_from_descriptor(3)
+ * and the size of the metadata is obtained using rpma_mr_remote_get_size(3).
+ * The descriptor is small enough to be transferred in the connection's
+ * private data.
+ *
+ * RETURN VALUE
+ * The rpma_meta_get_descriptor() function returns 0 on success or a negative
+ * error code on failure.
+ *
+ * ERRORS
+ * rpma_meta_get_descriptor() can fail with the following error:
+ *
+ * - RPMA_E_INVAL - meta or desc is NULL
+ *
+ * SEE ALSO
+ * rpma_conn_req_connect(3), rpma_meta_decode(3),
+ * rpma_meta_get_descriptor_size(3), rpma_meta_new(3),
+ * rpma_mr_remote_from_descriptor(3), librpma(7) and https://pmem.io/rpma/
+ */
+int rpma_meta_get_descriptor(const struct rpma_meta *meta, void *desc);
+
+/** 3
+ * rpma_meta_decode - decode the metadata read from the other side
+ *
+ * SYNOPSIS
+ *
+ *	#include <librpma.h>
+ *
+ *	struct rpma_mr_remote;
+ *	struct rpma_peer_cfg;
+ *	int rpma_meta_decode(const void *buf, size_t size,
+ *			struct rpma_mr_remote *mrs[], int *mrs_num,
+ *			struct rpma_peer_cfg **pcfg_ptr);
+ *
+ * DESCRIPTION
+ * rpma_meta_decode() decodes the metadata created by rpma_meta_new(3)
+ * and read from the other side of the connection into the size bytes
+ * long buf buffer. It creates a remote memory region for every memory region
+ * descriptor of the metadata and stores them in the mrs array in the order
+ * they were passed to rpma_meta_new(3). On input *mrs_num is the number of
+ * elements of the mrs array, on output it is the number of the created remote
+ * memory regions. If mrs is NULL, only the number of the memory region
+ * descriptors of the metadata is stored in *mrs_num.
+ *
+ * If pcfg_ptr is not NULL, a peer configuration is created from the peer
+ * configuration descriptor of the metadata and stored in *pcfg_ptr
+ * (or NULL if the metadata has no peer configuration descriptor).
+ *
+ * The created remote memory regions and the peer configuration have to be
+ * deleted using rpma_mr_remote_delete(3) and rpma_peer_cfg_delete(3).
+ *
+ * RETURN VALUE
+ * The rpma_meta_decode() function returns 0 on success or a negative error
+ * code on failure. rpma_meta_decode() does not set *mrs_num, the elements
+ * of mrs nor *pcfg_ptr value on failure.
+ *
+ * ERRORS
+ * rpma_meta_decode() can fail with the following errors:
+ *
+ * - RPMA_E_INVAL - buf or mrs_num is NULL
+ * - RPMA_E_INVAL - buf does not contain the metadata of a supported version
+ * or size is too small
+ * - RPMA_E_INVAL - *mrs_num is smaller than the number of the memory region
+ * descriptors of the metadata
+ * - RPMA_E_INVAL - any of the descriptors is invalid
+ * - RPMA_E_NOMEM - out of memory
+ *
+ * SEE ALSO
+ * rpma_meta_get_descriptor(3), rpma_meta_new(3), rpma_mr_remote_delete(3),
+ * rpma_peer_cfg_delete(3), rpma_read(3), librpma(7) and https://pmem.io/rpma/
+ */
+int rpma_meta_decode(const void *buf, size_t size,
+		struct rpma_mr_remote *mrs[], int *mrs_num,
+		struct rpma_peer_cfg **pcfg_ptr);
+
+/* connection configuration */
+
+struct rpma_conn_cfg;
+
+/** 3
+ * rpma_conn_cfg_new - create a new connection configuration object
+ *
+ * SYNOPSIS
+ *
+ *	#include <librpma.h>
+ *
+ *	struct rpma_conn_cfg;
+ *	int rpma_conn_cfg_new(struct rpma_conn_cfg **cfg_ptr);
+ *
+ * DESCRIPTION
+ * rpma_conn_cfg_new() creates a new connection configuration object
+ * and fills it with the default values:
+ *
+ *	.timeout_ms = 1000
+ *	.cq_size = 10
+ *	.rcq_size = 0
+ *	.sq_size = 10
+ *	.rq_size = 10
+ *	.shared_comp_channel = false
+ *	.comp_vector = 0
+ *
+ * RETURN VALUE
+ * The rpma_conn_cfg_new() function returns 0 on success or a negative
+ * error code on failure. rpma_conn_cfg_new() does not set
+ * *cfg_ptr value on failure.
+ *
+ * ERRORS
+ * rpma_conn_cfg_new() can fail with the following error:
+ *
+ * - RPMA_E_INVAL - cfg_ptr is NULL
+ * - RPMA_E_NOMEM - out of memory
+ *
+ * SEE ALSO
+ * rpma_conn_cfg_delete(3), rpma_conn_cfg_get_comp_vector(3),
+ * rpma_conn_cfg_get_compl_channel(3), rpma_conn_cfg_get_cq_size(3),
+ * rpma_conn_cfg_get_rq_size(3), rpma_conn_cfg_get_sq_size(3),
+ * rpma_conn_cfg_get_timeout(3), rpma_conn_cfg_set_comp_vector(3),
+ * rpma_conn_cfg_set_compl_channel(3), rpma_conn_cfg_set_cq_size(3),
+ * rpma_conn_cfg_set_rq_size(3), rpma_conn_cfg_set_sq_size(3),
+ * rpma_conn_cfg_set_timeout(3), rpma_conn_req_new(3), rpma_ep_next_conn_req(3),
+ * librpma(7) and https://pmem.io/rpma/
+ */
+int rpma_conn_cfg_new(struct rpma_conn_cfg **cfg_ptr);
+
+/** 3
+ * rpma_conn_cfg_delete - delete the connection configuration object
+ *
+ * SYNOPSIS
+ *
+ *	#include <librpma.h>
+ *
+ *	struct rpma_conn_cfg;
+ *	int rpma_conn_cfg_delete(struct rpma_conn_cfg **cfg_ptr);
+ *
+ * DESCRIPTION
+ * rpma_conn_cfg_delete() deletes the connection configuration object.
+ *
+ * RETURN VALUE
+ * The rpma_conn_cfg_delete() function returns 0 on success or a negative
+ * error code on failure. rpma_conn_cfg_delete() sets *cfg_ptr value to NULL
+ * on success and on failure.
+ *
+ * ERRORS
+ * rpma_conn_cfg_delete() can fail with the following error:
+ *
+ * - RPMA_E_INVAL - cfg_ptr is NULL
+ *
+ * SEE ALSO
+ * rpma_conn_cfg_new(3), librpma(7) and https://pmem.io/rpma/
+ */
+int rpma_conn_cfg_delete(struct rpma_conn_cfg **cfg_ptr);
+
+/** 3
+ * rpma_conn_cfg_set_timeout - set connection establishment timeout
+ *
+ * SYNOPSIS
+ *
+ *	#include <librpma.h>
+ *
+ *	struct rpma_conn_cfg;
+ *	int rpma_conn_cfg_set_timeout(struct rpma_conn_cfg *cfg,
+ *			int timeout_ms);
+ *
+ * DESCRIPTION
+ * rpma_conn_cfg_set_timeout() sets the connection establishment timeout.
+ * If this function is not called, the timeout has
+ * the default value (1000) set by rpma_conn_cfg_new(3).
+ *
+ * RETURN VALUE
+ * The rpma_conn_cfg_set_timeout() function returns 0 on success or a negative
+ * error code on failure.
+ *
+ * ERRORS
+ * rpma_conn_cfg_set_timeout() can fail with the following error:
+ *
+ * - RPMA_E_INVAL - cfg is NULL or timeout_ms < 0
+ *
+ * SEE ALSO
+ * rpma_conn_cfg_new(3), rpma_conn_cfg_get_timeout(3), librpma(7) and
+ * https://pmem.io/rpma/
+ */
+int rpma_conn_cfg_set_timeout(struct rpma_conn_cfg *cfg, int timeout_ms);
+
+/** 3
+ * rpma_conn_cfg_get_timeout - get connection establishment timeout
+ *
+ * SYNOPSIS
+ *
+ *	#include <librpma.h>
+ *
+ *	struct rpma_conn_cfg;
+ *	int rpma_conn_cfg_get_timeout(const struct rpma_conn_cfg *cfg,
+ *			int *timeout_ms);
+ *
+ * DESCRIPTION
+ * rpma_conn_cfg_get_timeout() gets the connection establishment timeout.
+ *
+ * RETURN VALUE
+ * The rpma_conn_cfg_get_timeout() function returns 0 on success or a negative
+ * error code on failure. rpma_conn_cfg_get_timeout() does not set
+ * *timeout_ms value on failure.
+ *
+ * ERRORS
+ * rpma_conn_cfg_get_timeout() can fail with the following error:
+ *
+ * - RPMA_E_INVAL - cfg or timeout_ms is NULL
+ *
+ * SEE ALSO
+ * rpma_conn_cfg_new(3), rpma_conn_cfg_set_timeout(3), librpma(7) and
+ * https://pmem.io/rpma/
+ */
+int rpma_conn_cfg_get_timeout(const struct rpma_conn_cfg *cfg, int *timeout_ms);
+
+/** 3
+ * rpma_conn_cfg_set_cq_size - set CQ size for the connection
+ *
+ * SYNOPSIS
+ *
+ *	#include <librpma.h>
+ *
+ *	struct rpma_conn_cfg;
+ *	int rpma_conn_cfg_set_cq_size(struct rpma_conn_cfg *cfg,
+ *			uint32_t cq_size);
+ *
+ * DESCRIPTION
+ * rpma_conn_cfg_set_cq_size() sets the CQ size for the connection.
+ * If this function is not called, the cq_size has
+ * the default value (10) set by rpma_conn_cfg_new(3).
+ *
+ * RETURN VALUE
+ * The rpma_conn_cfg_set_cq_size() function returns 0 on success or a negative
+ * error code on failure.
+ *
+ * ERRORS
+ * rpma_conn_cfg_set_cq_size() can fail with the following error:
+ *
+ * - RPMA_E_INVAL - cfg is NULL
+ *
+ * SEE ALSO
+ * rpma_conn_cfg_new(3), rpma_conn_cfg_get_cq_size(3), librpma(7) and
+ * https://pmem.io/rpma/
+ */
+int rpma_conn_cfg_set_cq_size(struct rpma_conn_cfg *cfg, uint32_t cq_size);
+
+/** 3
+ * rpma_conn_cfg_get_compl_channel - get if the completion event channel can be shared by CQ and RCQ
+ *
+ * SYNOPSIS
+ *
+ *	#include <librpma.h>
+ *
+ *	struct rpma_conn_cfg;
+ *	int rpma_conn_cfg_get_compl_channel(const struct rpma_conn_cfg *cfg,
+ *			bool *shared);
+ *
+ * DESCRIPTION
+ * rpma_conn_cfg_get_compl_channel() gets if the completion event channel
+ * can be shared by CQ and RCQ.
+ *
+ * RETURN VALUE
+ * The rpma_conn_cfg_get_compl_channel() function returns 0 on success
+ * or a negative error code on failure.
+ * rpma_conn_cfg_get_compl_channel() does not set *shared value on failure.
+ *
+ * ERRORS
+ * rpma_conn_cfg_get_compl_channel() can fail with the following error:
+ *
+ * - RPMA_E_INVAL - cfg or shared is NULL
+ *
+ * SEE ALSO
+ * rpma_conn_cfg_new(3), rpma_conn_wait(3), rpma_conn_cfg_set_compl_channel(3),
+ * librpma(7) and https://pmem.io/rpma/
+ */
+int rpma_conn_cfg_get_compl_channel(const struct rpma_conn_cfg *cfg,
+		bool *shared);
+
+/** 3
+ * rpma_conn_cfg_set_compl_channel - set if the completion event channel can be shared by CQ and RCQ
+ *
+ * SYNOPSIS
+ *
+ *	#include <librpma.h>
+ *
+ *	struct rpma_conn_cfg;
+ *	int rpma_conn_cfg_set_compl_channel(struct rpma_conn_cfg *cfg,
+ *			bool shared);
+ *
+ * DESCRIPTION
+ * rpma_conn_cfg_set_compl_channel() sets if the completion event channel
+ * can be shared by CQ and RCQ or not. The completion event channel
+ * is not shared by CQ and RCQ by default. See rpma_conn_cfg_new(3) for details.
+ *
+ * RETURN VALUE
+ * The rpma_conn_cfg_set_compl_channel() function returns 0 on success or
+ * a negative error code on failure.
+ *
+ * ERRORS
+ * rpma_conn_cfg_set_compl_channel() can fail with the following error:
+ *
+ * - RPMA_E_INVAL - cfg is NULL
+ *
+ * SEE ALSO
+ * rpma_conn_cfg_new(3), rpma_conn_wait(3), rpma_conn_cfg_get_compl_channel(3),
+ * librpma(7) and https://pmem.io/rpma/
+ */
+int rpma_conn_cfg_set_compl_channel(struct rpma_conn_cfg *cfg, bool shared);
+
+/*
+ * the completion vector is chosen in the round-robin manner
+ * out of all completion vectors of the device
+ */
+#define RPMA_COMP_VECTOR_ROUND_ROBIN (-1)
+
+/** 3
+ * rpma_conn_cfg_set_comp_vector - set the completion vector of CQ and RCQ
+ *
+ * SYNOPSIS
+ *
+ *	#include <librpma.h>
+ *
+ *	struct rpma_conn_cfg;
+ *	#define RPMA_COMP_VECTOR_ROUND_ROBIN (-1)
+ *	int rpma_conn_cfg_set_comp_vector(struct rpma_conn_cfg *cfg,
+ *			int comp_vector);
+ *
+ * DESCRIPTION
+ * rpma_conn_cfg_set_comp_vector() sets the completion vector used by both
+ * the main CQ and the receive CQ of the connection. The completion vector
+ * selects the interrupt the completion events of the CQs are delivered by,
+ * so spreading connections over many completion vectors (and binding
+ * the respective IRQs to different CPUs) spreads the completion-handling
+ * load over many CPUs. The valid values are from 0 to
+ * (struct ibv_context).num_comp_vectors - 1 of the device. A value out of
+ * this range makes rpma_conn_req_new(3) and rpma_ep_next_conn_req(3) fail
+ * with RPMA_E_INVAL.
+ * If comp_vector is equal to RPMA_COMP_VECTOR_ROUND_ROBIN, every new
+ * connection gets the next completion vector of the device.
+ * If this function is not called, the comp_vector has
+ * the default value (0) set by rpma_conn_cfg_new(3).
+ *
+ * RETURN VALUE
+ * The rpma_conn_cfg_set_comp_vector() function returns 0 on success or
+ * a negative error code on failure.
+ *
+ * ERRORS
+ * rpma_conn_cfg_set_comp_vector() can fail with the following error:
+ *
+ * - RPMA_E_INVAL - cfg is NULL or comp_vector < 0 and is not equal to
+ * RPMA_COMP_VECTOR_ROUND_ROBIN
+ *
+ * SEE ALSO
+ * rpma_conn_cfg_get_comp_vector(3), rpma_conn_cfg_new(3),
+ * rpma_cq_get_comp_vector(3), librpma(7) and https://pmem.io/rpma/
+ */
+int rpma_conn_cfg_set_comp_vector(struct rpma_conn_cfg *cfg, int comp_vector);
+
+/** 3
+ * rpma_conn_cfg_get_comp_vector - get the completion vector of CQ and RCQ
+ *
+ * SYNOPSIS
+ *
+ *	#include <librpma.h>
+ *
+ *	struct rpma_conn_cfg;
+ *	int rpma_conn_cfg_get_comp_vector(const struct rpma_conn_cfg *cfg,
+ *			int *comp_vector);
+ *
+ * DESCRIPTION
+ * rpma_conn_cfg_get_comp_vector() gets the completion vector of the main CQ
+ * and the receive CQ of the connection. It may be equal to
+ * RPMA_COMP_VECTOR_ROUND_ROBIN. Use rpma_cq_get_comp_vector(3) to get
+ * the completion vector actually used by the CQ.
+ *
+ * RETURN VALUE
+ * The rpma_conn_cfg_get_comp_vector() function returns 0 on success or
+ * a negative error code on failure. rpma_conn_cfg_get_comp_vector() does not
+ * set *comp_vector value on failure.
+ *
+ * ERRORS
+ * rpma_conn_cfg_get_comp_vector() can fail with the following error:
+ *
+ * - RPMA_E_INVAL - cfg or comp_vector is NULL
+ *
+ * SEE ALSO
+ * rpma_conn_cfg_new(3), rpma_conn_cfg_set_comp_vector(3),
+ * rpma_cq_get_comp_vector(3), librpma(7) and https://pmem.io/rpma/
+ */
+int rpma_conn_cfg_get_comp_vector(const struct rpma_conn_cfg *cfg,
+		int *comp_vector);
+
+/** 3
+ * rpma_conn_cfg_get_cq_size - get CQ size for the connection
+ *
+ * SYNOPSIS
+ *
+ *	#include <librpma.h>
+ *
+ *	struct rpma_conn_cfg;
+ *	int rpma_conn_cfg_get_cq_size(const struct rpma_conn_cfg *cfg,
+ *			uint32_t *cq_size);
+ *
+ * DESCRIPTION
+ * rpma_conn_cfg_get_cq_size() gets the CQ size for the connection.
+ *
+ * RETURN VALUE
+ * The rpma_conn_cfg_get_cq_size() function returns 0 on success or a negative
+ * error code on failure. rpma_conn_cfg_get_cq_size() does not set
+ * *cq_size value on failure.
+ *
+ * ERRORS
+ * rpma_conn_cfg_get_cq_size() can fail with the following error:
+ *
+ * - RPMA_E_INVAL - cfg or cq_size is NULL
+ *
+ * SEE ALSO
+ * rpma_conn_cfg_new(3), rpma_conn_cfg_set_cq_size(3), librpma(7) and
+ * https://pmem.io/rpma/
+ */
+int rpma_conn_cfg_get_cq_size(const struct rpma_conn_cfg *cfg,
+		uint32_t *cq_size);
+
+/** 3
+ * rpma_conn_cfg_set_rcq_size - set receive CQ size for the connection
+ *
+ * SYNOPSIS
+ *
+ *	#include <librpma.h>
+ *
+ *	struct rpma_conn_cfg;
+ *	int rpma_conn_cfg_set_rcq_size(struct rpma_conn_cfg *cfg,
+ *			uint32_t rcq_size);
+ *
+ * DESCRIPTION
+ * rpma_conn_cfg_set_rcq_size() sets the receive CQ size for the connection.
+ * Please see the rpma_conn_get_rcq() for details about the receive CQ.
+ * If this function is not called, the rcq_size has
+ * the default value (0) set by rpma_conn_cfg_new(3).
+ *
+ * RETURN VALUE
+ * The rpma_conn_cfg_set_rcq_size() function returns 0 on success or
+ * a negative error code on failure.
+ *
+ * ERRORS
+ * rpma_conn_cfg_set_rcq_size() can fail with the following error:
+ *
+ * - RPMA_E_INVAL - cfg is NULL
+ *
+ * SEE ALSO
+ * rpma_conn_cfg_get_rcq_size(3), rpma_conn_cfg_new(3), rpma_conn_get_rcq(3),
+ * librpma(7) and https://pmem.io/rpma/
+ */
+int rpma_conn_cfg_set_rcq_size(struct rpma_conn_cfg *cfg, uint32_t rcq_size);
+
+/** 3
+ * rpma_conn_cfg_get_rcq_size - get receive CQ size for the connection
+ *
+ * SYNOPSIS
+ *
+ *	#include <librpma.h>
+ *
+ *	struct rpma_conn_cfg;
+ *	int rpma_conn_cfg_get_rcq_size(const struct rpma_conn_cfg *cfg,
+ *			uint32_t *rcq_size);
+ *
+ * DESCRIPTION
+ * rpma_conn_cfg_get_rcq_size() gets the receive CQ size for the connection.
+ * Please see the rpma_conn_get_rcq() for details about the receive CQ.
+ *
+ * RETURN VALUE
+ * The rpma_conn_cfg_get_rcq_size() function returns 0 on success or
+ * a negative error code on failure. rpma_conn_cfg_get_rcq_size() does not
+ * set *rcq_size value on failure.
+ *
+ * ERRORS
+ * rpma_conn_cfg_get_rcq_size() can fail with the following error:
+ *
+ * - RPMA_E_INVAL - cfg or rcq_size is NULL
+ *
+ * SEE ALSO
+ * rpma_conn_cfg_new(3), rpma_conn_cfg_set_rcq_size(3), rpma_conn_get_rcq(3),
+ * librpma(7) and https://pmem.io/rpma/
+ */
+int rpma_conn_cfg_get_rcq_size(const struct rpma_conn_cfg *cfg,
+		uint32_t *rcq_size);
+
+/** 3
+ * rpma_conn_cfg_set_sq_size - set SQ size for the connection
+ *
+ * SYNOPSIS
+ *
+ *	#include <librpma.h>
+ *
+ *	struct rpma_conn_cfg;
+ *	int rpma_conn_cfg_set_sq_size(struct rpma_conn_cfg *cfg,
+ *			uint32_t sq_size);
+ *
+ * DESCRIPTION
+ * rpma_conn_cfg_set_sq_size() sets the SQ size for the connection.
+ * If this function is not called, the sq_size has
+ * the default value (10) set by rpma_conn_cfg_new(3).
+ *
+ * RETURN VALUE
+ * The rpma_conn_cfg_set_sq_size() function returns 0 on success or a negative
+ * error code on failure.
+ *
+ * ERRORS
+ * rpma_conn_cfg_set_sq_size() can fail with the following error:
+ *
+ * - RPMA_E_INVAL - cfg is NULL
+ *
+ * SEE ALSO
+ * rpma_conn_cfg_new(3), rpma_conn_cfg_get_sq_size(3), librpma(7) and
+ * https://pmem.io/rpma/
+ */
+int rpma_conn_cfg_set_sq_size(struct rpma_conn_cfg *cfg, uint32_t sq_size);
+
+/** 3
+ * rpma_conn_cfg_get_sq_size - get SQ size for the connection
+ *
+ * SYNOPSIS
+ *
+ *	#include <librpma.h>
+ *
+ *	struct rpma_conn_cfg;
+ *	int rpma_conn_cfg_get_sq_size(const struct rpma_conn_cfg *cfg,
+ *			uint32_t *sq_size);
+ *
+ * DESCRIPTION
+ * rpma_conn_cfg_get_sq_size() gets the SQ size for the connection.
+ *
+ * RETURN VALUE
+ * The rpma_conn_cfg_get_sq_size() function returns 0 on success or a negative
+ * error code on failure. rpma_conn_cfg_get_sq_size() does not set
+ * *sq_size value on failure.
+ *
+ * ERRORS
+ * rpma_conn_cfg_get_sq_size() can fail with the following error:
+ *
+ * - RPMA_E_INVAL - cfg or sq_size is NULL
+ *
+ * SEE ALSO
+ * rpma_conn_cfg_new(3), rpma_conn_cfg_set_sq_size(3), librpma(7) and
+ * https://pmem.io/rpma/
+ */
+int rpma_conn_cfg_get_sq_size(const struct rpma_conn_cfg *cfg,
+		uint32_t *sq_size);
+
+/** 3
+ * rpma_conn_cfg_set_rq_size - set RQ size for the connection
+ *
+ * SYNOPSIS
+ *
+ *	#include <librpma.h>
+ *
+ *	struct rpma_conn_cfg;
+ *	int rpma_conn_cfg_set_rq_size(struct rpma_conn_cfg *cfg,
+ *			uint32_t rq_size);
+ *
+ * DESCRIPTION
+ * rpma_conn_cfg_set_rq_size() sets the RQ size for the connection.
+ * If this function is not called, the rq_size has
+ * the default value (10) set by rpma_conn_cfg_new(3).
+ *
+ * RETURN VALUE
+ * The rpma_conn_cfg_set_rq_size() function returns 0 on success or a negative
+ * error code on failure.
+ *
+ * ERRORS
+ * rpma_conn_cfg_set_rq_size() can fail with the following error:
+ *
+ * - RPMA_E_INVAL - cfg is NULL
+ *
+ * SEE ALSO
+ * rpma_conn_cfg_new(3), rpma_conn_cfg_get_rq_size(3), librpma(7) and
+ * https://pmem.io/rpma/
+ */
+int rpma_conn_cfg_set_rq_size(struct rpma_conn_cfg *cfg, uint32_t rq_size);
+
+/** 3
+ * rpma_conn_cfg_get_rq_size - get RQ size for the connection
+ *
+ * SYNOPSIS
+ *
+ *	#include <librpma.h>
+ *
+ *	struct rpma_conn_cfg;
+ *	int rpma_conn_cfg_get_rq_size(const struct rpma_conn_cfg *cfg,
+ *			uint32_t *rq_size);
+ *
+ * DESCRIPTION
+ * rpma_conn_cfg_get_rq_size() gets the RQ size for the connection.
+ *
+ * RETURN VALUE
+ * The rpma_conn_cfg_get_rq_size() function returns 0 on success or a negative
+ * error code on failure. rpma_conn_cfg_get_rq_size() does not set
+ * *rq_size value on failure.
+ *
+ * ERRORS
+ * rpma_conn_cfg_get_rq_size() can fail with the following error:
+ *
+ * - RPMA_E_INVAL - cfg or rq_size is NULL
+ *
+ * SEE ALSO
+ * rpma_conn_cfg_new(3), rpma_conn_cfg_set_rq_size(3), librpma(7) and
+ * https://pmem.io/rpma/
+ */
+int rpma_conn_cfg_get_rq_size(const struct rpma_conn_cfg *cfg,
+		uint32_t *rq_size);
+
+/* connection */
+
+struct rpma_conn;
+
+/** 3
+ * rpma_conn_get_event_fd - get an event file descriptor of the connection
+ *
+ * SYNOPSIS
+ *
+ *	#include <librpma.h>
+ *
+ *	struct rpma_conn;
+ *	int rpma_conn_get_event_fd(const struct rpma_conn *conn, int *fd);
+ *
+ * DESCRIPTION
+ * rpma_conn_get_event_fd() gets an event file descriptor of the connection.
+ *
+ * RETURN VALUE
+ * The rpma_conn_get_event_fd() function returns 0 on success or a negative
+ * error code on failure. rpma_conn_get_event_fd() does not set
+ * *fd value on failure.
+ *
+ * ERRORS
+ * rpma_conn_get_event_fd() can fail with the following error:
+ *
+ * - RPMA_E_INVAL - conn or fd is NULL
+ *
+ * SEE ALSO
+ * rpma_conn_next_event(3), rpma_conn_req_connect(3), librpma(7) and
+ * https://pmem.io/rpma/
+ */
+int rpma_conn_get_event_fd(const struct rpma_conn *conn, int *fd);
+
+enum rpma_conn_event {
+	RPMA_CONN_UNDEFINED = -1,	/* Undefined connection event */
+	RPMA_CONN_ESTABLISHED,		/* Connection established */
+	RPMA_CONN_CLOSED,		/* Connection closed */
+	RPMA_CONN_LOST,			/* Connection lost */
+	RPMA_CONN_REJECTED,		/* Connection rejected */
+	RPMA_CONN_UNREACHABLE		/* Connection unreachable */
+};
+
+/** 3
+ * rpma_conn_next_event - obtain a connection status
+ *
+ * SYNOPSIS
+ *
+ *	#include <librpma.h>
+ *
+ *	struct rpma_conn;
+ *	enum rpma_conn_event {
+ *		RPMA_CONN_UNDEFINED = -1,
+ *		RPMA_CONN_ESTABLISHED,
+ *		RPMA_CONN_CLOSED,
+ *		RPMA_CONN_LOST,
+ *		RPMA_CONN_REJECTED,
+ *		RPMA_CONN_UNREACHABLE
+ *	};
+ *
+ *	int rpma_conn_next_event(struct rpma_conn *conn,
+ *			enum rpma_conn_event *event);
+ *
+ * DESCRIPTION
+ * rpma_conn_next_event() obtains the next event from the connection.
+ * Types of events:
+ * - RPMA_CONN_UNDEFINED - undefined connection event
+ * - RPMA_CONN_ESTABLISHED - connection established
+ * - RPMA_CONN_CLOSED - connection closed
+ * - RPMA_CONN_LOST - connection lost
+ * - RPMA_CONN_REJECTED - connection rejected
+ * - RPMA_CONN_UNREACHABLE - connection unreachable
+ *
+ * RETURN VALUE
+ * The rpma_conn_next_event() function returns 0 on success or a negative
  * error code on failure.
  *
  * ERRORS
- * rpma_conn_cfg_set_rq_size() can fail with the following error:
+ * rpma_conn_next_event() can fail with the following errors:
+ *
+ * - RPMA_E_INVAL - conn or event is NULL
+ * - RPMA_E_UNKNOWN - unexpected event
+ * - RPMA_E_PROVIDER - rdma_get_cm_event() or rdma_ack_cm_event() failed
+ * - RPMA_E_NOMEM - out of memory
+ *
+ * SEE ALSO
+ * rpma_conn_req_connect(3), rpma_conn_disconnect(3), librpma(7) and
+ * https://pmem.io/rpma/
+ */
+int rpma_conn_next_event(struct rpma_conn *conn, enum rpma_conn_event *event);
+
+/** 3
+ * rpma_utils_conn_event_2str - convert RPMA_CONN_* enum to a string
+ *
+ * SYNOPSIS
+ *
+ *	#include <librpma.h>
+ *
+ *	const char *rpma_utils_conn_event_2str(enum rpma_conn_event conn_event);
+ *
+ *	enum rpma_conn_event {
+ *		RPMA_CONN_UNDEFINED = -1,
+ *		RPMA_CONN_ESTABLISHED,
+ *		RPMA_CONN_CLOSED,
+ *		RPMA_CONN_LOST,
+ *		RPMA_CONN_REJECTED,
+ *		RPMA_CONN_UNREACHABLE
+ *	};
+ *
+ * DESCRIPTION
+ * rpma_utils_conn_event_2str() converts RPMA_CONN_* enum to the const string
+ * representation.
+ *
+ * RETURN VALUE
+ * The rpma_utils_conn_event_2str() function returns the const string
+ * representation of RPMA_CONN_* enums.
+ *
+ * ERRORS
+ * rpma_utils_conn_event_2str() can not fail.
+ *
+ * SEE ALSO
+ * rpma_conn_next_event(3), librpma(7) and https://pmem.io/rpma/
+ */
+const char *rpma_utils_conn_event_2str(enum rpma_conn_event conn_event);
+
+struct rpma_conn_private_data {
+	void *ptr;
+	uint8_t len;
+};
+
+/** 3
+ * rpma_conn_get_private_data - get a pointer to the connection's private data
+ *
+ * SYNOPSIS
+ *
+ *	#include <librpma.h>
+ *
+ *	struct rpma_conn;
+ *	struct rpma_conn_private_data;
+ *	int rpma_conn_get_private_data(const struct rpma_conn *conn,
+ *			struct rpma_conn_private_data *pdata);
+ *
+ * DESCRIPTION
+ * rpma_conn_get_private_data() obtains the pointer to the private data
+ * given by the other side of the connection.
+ *
+ * RETURN VALUE
+ * The rpma_conn_get_private_data() function returns 0 on success or a negative
+ * error code on failure. rpma_conn_get_private_data() does not set
+ * *pdata value on failure.
+ *
+ * ERRORS
+ * rpma_conn_get_private_data() can fail with the following error:
+ *
+ * - RPMA_E_INVAL - conn or pdata is NULL
+ *
+ * SEE ALSO
+ * rpma_conn_req_connect(3), librpma(7) and https://pmem.io/rpma/
+ */
+int rpma_conn_get_private_data(const struct rpma_conn *conn,
+		struct rpma_conn_private_data *pdata);
+
+/** 3
+ * rpma_conn_apply_remote_peer_cfg - apply remote peer cfg to the connection
+ *
+ * SYNOPSIS
+ *
+ *	#include <librpma.h>
+ *
+ *	struct rpma_conn;
+ *	struct rpma_peer_cfg;
+ *	int rpma_conn_apply_remote_peer_cfg(struct rpma_conn *conn,
+ *			const struct rpma_peer_cfg *pcfg);
+ *
+ * DESCRIPTION
+ * rpma_conn_apply_remote_peer_cfg() applies the remote peer configuration
+ * to the connection.
+ *
+ * RETURN VALUE
+ * The rpma_conn_apply_remote_peer_cfg() function returns 0 on success
+ * or a negative error code on failure. rpma_conn_apply_remote_peer_cfg()
+ * does not set *pcfg value on failure.
+ *
+ * ERRORS
+ * rpma_conn_apply_remote_peer_cfg() can fail with the following error:
  *
- * - RPMA_E_INVAL - cfg is NULL
+ * - RPMA_E_INVAL - conn or pcfg are NULL
  *
  * SEE ALSO
- * rpma_conn_cfg_new(3), rpma_conn_cfg_get_rq_size(3), librpma(7) and
+ * rpma_conn_req_connect(3), rpma_peer_cfg_new(3), librpma(7) and
  * https://pmem.io/rpma/
  */
-int rpma_conn_cfg_set_rq_size(struct rpma_conn_cfg *cfg, uint32_t rq_size);
+int rpma_conn_apply_remote_peer_cfg(struct rpma_conn *conn,
+		const struct rpma_peer_cfg *pcfg);
 
 /** 3
- * rpma_conn_cfg_get_rq_size - get RQ size for the connection
+ * rpma_conn_get_qp_num - get the connection's qp_num
  *
  * SYNOPSIS
  *
  *	#include <librpma.h>
  *
- *	struct rpma_conn_cfg;
- *	int rpma_conn_cfg_get_rq_size(const struct rpma_conn_cfg *cfg,
- *			uint32_t *rq_size);
+ *	struct rpma_conn;
+ *	int rpma_conn_get_qp_num(const struct rpma_conn *conn,
+ *			uint32_t *qp_num);
  *
  * DESCRIPTION
- * rpma_conn_cfg_get_rq_size() gets the RQ size for the connection.
+ * rpma_conn_get_qp_num() obtains the unique identifier of the connection.
  *
  * RETURN VALUE
- * The rpma_conn_cfg_get_rq_size() function returns 0 on success or a negative
- * error code on failure. rpma_conn_cfg_get_rq_size() does not set
- * *rq_size value on failure.
+ * The rpma_conn_get_qp_num() function returns 0 on success or a negative
+ * error code on failure. rpma_conn_get_qp_num() does not set *qp_num
+ * value on failure.
  *
  * ERRORS
- * rpma_conn_cfg_get_rq_size() can fail with the following error:
+ * rpma_conn_get_qp_num() can fail with the following error:
  *
- * - RPMA_E_INVAL - cfg or rq_size is NULL
+ * - RPMA_E_INVAL - conn or qp_num is NULL
  *
  * SEE ALSO
- * rpma_conn_cfg_new(3), rpma_conn_cfg_set_rq_size(3), librpma(7) and
- * https://pmem.io/rpma/
+ * rpma_conn_req_new(3), rpma_ep_next_conn_req(3), rpma_conn_req_connect(3),
+ * librpma(7) and https://pmem.io/rpma/
  */
-int rpma_conn_cfg_get_rq_size(const struct rpma_conn_cfg *cfg,
-		uint32_t *rq_size);
+int rpma_conn_get_qp_num(const struct rpma_conn *conn, uint32_t *qp_num);
 
-/* connection */
+struct rpma_cq;
 
-struct rpma_conn;
+/** 3
+ * rpma_conn_get_cq - get the connection's main CQ
+ *
+ * SYNOPSIS
+ *
+ *	#include <librpma.h>
+ *
+ *	struct rpma_conn;
+ *	struct rpma_cq;
+ *	int rpma_conn_get_cq(const struct rpma_conn *conn,
+ *			struct rpma_cq **cq_ptr);
+ *
+ * DESCRIPTION
+ * rpma_conn_get_cq() gets the main CQ from the connection. When the receive
+ * CQ is not present the main CQ allows handling all completions within
+ * the connection. When the receive CQ is present the main CQ allows handling
+ * all completions except rpma_recv(3) completions within the connection.
+ * Please see rpma_conn_get_rcq(3) for details about the receive CQ.
+ *
+ * RETURN VALUE
+ * The rpma_conn_get_cq() function returns 0 on success or a negative error
+ * code on failure. rpma_conn_get_cq() does not set *cq_ptr value on failure.
+ *
+ * ERRORS
+ * rpma_conn_get_cq() can fail with the following error:
+ *
+ * - RPMA_E_INVAL - conn or cq_ptr is NULL
+ *
+ * SEE ALSO
+ * rpma_conn_req_connect(3), rpma_conn_get_rcq(3), rpma_cq_wait(3),
+ * rpma_cq_get_wc(3), rpma_cq_get_fd(3), rpma_recv(3), librpma(7)
+ * and https://pmem.io/rpma/
+ */
+int rpma_conn_get_cq(const struct rpma_conn *conn, struct rpma_cq **cq_ptr);
 
 /** 3
- * rpma_conn_get_event_fd - get an event file descriptor of the connection
+ * rpma_conn_get_rcq -- get the connection's receive CQ
  *
  * SYNOPSIS
  *
  *	#include <librpma.h>
  *
  *	struct rpma_conn;
- *	int rpma_conn_get_event_fd(const struct rpma_conn *conn, int *fd);
+ *	struct rpma_cq;
+ *	int rpma_conn_get_rcq(const struct rpma_conn *conn,
+ *			struct rpma_cq **rcq_ptr);
  *
  * DESCRIPTION
- * rpma_conn_get_event_fd() gets an event file descriptor of the connection.
+ * rpma_conn_get_rcq() gets the receive CQ from the connection. The receive
+ * CQ allows handling all rpma_recv(3) completions within the connection.
+ * It allows separating rpma_recv(3) completions processing path from all other
+ * completions. The receive CQ is created only if the receive CQ size in
+ * the provided connection configuration is greater than 0. When the receive CQ
+ * does not exist for the given connection the *rcq_ptr == NULL.
  *
  * RETURN VALUE
- * The rpma_conn_get_event_fd() function returns 0 on success or a negative
- * error code on failure. rpma_conn_get_event_fd() does not set
- * *fd value on failure.
+ * The rpma_conn_get_rcq() function returns 0 on success or a negative error
+ * code on failure. rpma_conn_get_rcq() does not set *rcq_ptr value on failure.
  *
  * ERRORS
- * rpma_conn_get_event_fd() can fail with the following error:
+ * rpma_conn_get_rcq() can fail with the following error:
  *
- * - RPMA_E_INVAL - conn or fd is NULL
+ * - RPMA_E_INVAL - conn or rcq_ptr is NULL
  *
  * SEE ALSO
- * rpma_conn_next_event(3), rpma_conn_req_connect(3), librpma(7) and
- * https://pmem.io/rpma/
+ * rpma_conn_cfg_set_rcq_size(3), rpma_conn_req_connect(3), rpma_conn_get_cq(3),
+ * rpma_cq_wait(3), rpma_cq_get_wc(3), rpma_cq_get_fd(3), rpma_recv(3),
+ * librpma(7) and https://pmem.io/rpma/
  */
-int rpma_conn_get_event_fd(const struct rpma_conn *conn, int *fd);
+int rpma_conn_get_rcq(const struct rpma_conn *conn, struct rpma_cq **rcq_ptr);
 
-enum rpma_conn_event {
-	RPMA_CONN_UNDEFINED = -1,	/* Undefined connection event */
-	RPMA_CONN_ESTABLISHED,		/* Connection established */
-	RPMA_CONN_CLOSED,		/* Connection closed */
-	RPMA_CONN_LOST,			/* Connection lost */
-	RPMA_CONN_REJECTED,		/* Connection rejected */
-	RPMA_CONN_UNREACHABLE		/* Connection unreachable */
+struct rpma_conn_stats {
+	uint64_t read_ops;
+	uint64_t read_bytes;
+	uint64_t write_ops;
+	uint64_t write_bytes;
+	uint64_t atomic_write_ops;
+	uint64_t atomic_write_bytes;
+	uint64_t flush_ops;
+	uint64_t flush_bytes;
+	uint64_t send_ops;
+	uint64_t send_bytes;
+	uint64_t recv_ops;
+	uint64_t recv_bytes;
+	uint64_t post_errors;
+	uint64_t events;
 };
 
 /** 3
- * rpma_conn_next_event - obtain a connection status
+ * rpma_conn_get_stats - get the statistics counters of the connection
  *
  * SYNOPSIS
  *
  *	#include <librpma.h>
  *
  *	struct rpma_conn;
- *	enum rpma_conn_event {
- *		RPMA_CONN_UNDEFINED = -1,
- *		RPMA_CONN_ESTABLISHED,
- *		RPMA_CONN_CLOSED,
- *		RPMA_CONN_LOST,
- *		RPMA_CONN_REJECTED,
- *		RPMA_CONN_UNREACHABLE
+ *	struct rpma_conn_stats {
+ *		uint64_t read_ops;
+ *		uint64_t read_bytes;
+ *		uint64_t write_ops;
+ *		uint64_t write_bytes;
+ *		uint64_t atomic_write_ops;
+ *		uint64_t atomic_write_bytes;
+ *		uint64_t flush_ops;
+ *		uint64_t flush_bytes;
+ *		uint64_t send_ops;
+ *		uint64_t send_bytes;
+ *		uint64_t recv_ops;
+ *		uint64_t recv_bytes;
+ *		uint64_t post_errors;
+ *		uint64_t events;
  *	};
+ *	int rpma_conn_get_stats(const struct rpma_conn *conn,
+ *			struct rpma_conn_stats *stats);
  *
- *	int rpma_conn_next_event(struct rpma_conn *conn,
- *			enum rpma_conn_event *event);
+ * DESCRIPTION
+ * rpma_conn_get_stats() gets the statistics counters of the connection
+ * accumulated since the connection was created or since the last call to
+ * rpma_conn_reset_stats(3):
+ *
+ * - read_ops, read_bytes - operations and bytes successfully posted
+ * by rpma_read(3)
+ * - write_ops, write_bytes - operations and bytes successfully posted
+ * by rpma_write(3) and rpma_write_with_imm(3)
+ * - atomic_write_ops, atomic_write_bytes - operations and bytes successfully
+ * posted by rpma_atomic_write(3)
+ * - flush_ops, flush_bytes - operations successfully posted by rpma_flush(3)
+ * and bytes requested to be flushed by them
+ * - send_ops, send_bytes - operations and bytes successfully posted
+ * by rpma_send(3) and rpma_send_with_imm(3)
+ * - recv_ops, recv_bytes - receive buffers and their bytes successfully
+ * posted by rpma_recv(3)
+ * - post_errors - operations which passed the arguments validation but
+ * failed to be posted
+ * - events - completion events collected by rpma_conn_wait(3)
+ *
+ * The counters are updated with relaxed atomic operations so they can be
+ * read while other threads are posting operations, but the returned values
+ * do not have to make up a consistent snapshot. The completion-side
+ * counters are kept by the CQs, see rpma_cq_get_stats(3).
+ *
+ * RETURN VALUE
+ * The rpma_conn_get_stats() function returns 0 on success or a negative
+ * error code on failure. rpma_conn_get_stats() does not set *stats value
+ * on failure.
+ *
+ * ERRORS
+ * rpma_conn_get_stats() can fail with the following error:
+ *
+ * - RPMA_E_INVAL - conn or stats is NULL
+ *
+ * SEE ALSO
+ * rpma_conn_reset_stats(3), rpma_cq_get_stats(3), librpma(7) and
+ * https://pmem.io/rpma/
+ */
+int rpma_conn_get_stats(const struct rpma_conn *conn,
+		struct rpma_conn_stats *stats);
+
+/** 3
+ * rpma_conn_reset_stats - zero the statistics counters of the connection
+ *
+ * SYNOPSIS
+ *
+ *	#include <librpma.h>
+ *
+ *	struct rpma_conn;
+ *	int rpma_conn_reset_stats(struct rpma_conn *conn);
  *
  * DESCRIPTION
- * rpma_conn_next_event() obtains the next event from the connection.
- * Types of events:
- * - RPMA_CONN_UNDEFINED - undefined connection event
- * - RPMA_CONN_ESTABLISHED - connection established
- * - RPMA_CONN_CLOSED - connection closed
- * - RPMA_CONN_LOST - connection lost
- * - RPMA_CONN_REJECTED - connection rejected
- * - RPMA_CONN_UNREACHABLE - connection unreachable
+ * rpma_conn_reset_stats() zeroes all the statistics counters of
+ * the connection. The counters of the connection's CQs are not affected,
+ * see rpma_cq_reset_stats(3). Operations posted concurrently with
+ * rpma_conn_reset_stats() may be accounted either before or after the reset.
  *
  * RETURN VALUE
- * The rpma_conn_next_event() function returns 0 on success or a negative
+ * The rpma_conn_reset_stats() function returns 0 on success or a negative
  * error code on failure.
  *
  * ERRORS
- * rpma_conn_next_event() can fail with the following errors:
+ * rpma_conn_reset_stats() can fail with the following error:
  *
- * - RPMA_E_INVAL - conn or event is NULL
- * - RPMA_E_UNKNOWN - unexpected event
- * - RPMA_E_PROVIDER - rdma_get_cm_event() or rdma_ack_cm_event() failed
- * - RPMA_E_NOMEM - out of memory
+ * - RPMA_E_INVAL - conn is NULL
  *
  * SEE ALSO
- * rpma_conn_req_connect(3), rpma_conn_disconnect(3), librpma(7) and
+ * rpma_conn_get_stats(3), rpma_cq_reset_stats(3), librpma(7) and
  * https://pmem.io/rpma/
  */
-int rpma_conn_next_event(struct rpma_conn *conn, enum rpma_conn_event *event);
+int rpma_conn_reset_stats(struct rpma_conn *conn);
+
+struct rpma_conn_setup_times {
+	uint64_t resolve_addr_ns;
+	uint64_t resolve_route_ns;
+	uint64_t qp_create_ns;
+	uint64_t flush_reg_ns;
+	uint64_t handshake_ns;
+};
 
 /** 3
- * rpma_utils_conn_event_2str - convert RPMA_CONN_* enum to a string
+ * rpma_conn_get_setup_times - get the durations of the connection setup phases
  *
  * SYNOPSIS
  *
  *	#include <librpma.h>
  *
- *	const char *rpma_utils_conn_event_2str(enum rpma_conn_event conn_event);
+ *	struct rpma_conn;
+ *	struct rpma_conn_setup_times {
+ *		uint64_t resolve_addr_ns;
+ *		uint64_t resolve_route_ns;
+ *		uint64_t qp_create_ns;
+ *		uint64_t flush_reg_ns;
+ *		uint64_t handshake_ns;
+ *	};
+ *	int rpma_conn_get_setup_times(const struct rpma_conn *conn,
+ *			struct rpma_conn_setup_times *times);
  *
- *	enum rpma_conn_event {
- *		RPMA_CONN_UNDEFINED = -1,
- *		RPMA_CONN_ESTABLISHED,
- *		RPMA_CONN_CLOSED,
- *		RPMA_CONN_LOST,
- *		RPMA_CONN_REJECTED,
- *		RPMA_CONN_UNREACHABLE
+ * DESCRIPTION
+ * rpma_conn_get_setup_times() gets the durations (in nanoseconds of
+ * the monotonic clock) of the phases of setting up the connection:
+ *
+ * - resolve_addr_ns - resolving the address of the server
+ * by rpma_conn_req_new(3)
+ * - resolve_route_ns - resolving the route to the server
+ * by rpma_conn_req_new(3)
+ * - qp_create_ns - creating the CQs and the QP of the connection request
+ * by rpma_conn_req_new(3) or rpma_ep_next_conn_req(3)
+ * - flush_reg_ns - creating the flushing object (including registering
+ * its buffer of the appliance persistency method) by rpma_conn_req_connect(3)
+ * - handshake_ns - the time from sending the connection request (the active
+ * side) or accepting it (the passive side) by rpma_conn_req_connect(3) until
+ * the RPMA_CONN_ESTABLISHED event is obtained by rpma_conn_next_event(3);
+ * on the passive side it starts after the connection object is created,
+ * so it does not include flush_reg_ns
+ *
+ * The address and the route are not resolved on the passive side, so their
+ * durations are 0 there. handshake_ns is 0 until the RPMA_CONN_ESTABLISHED
+ * event is obtained and it includes the time the application takes to call
+ * rpma_conn_next_event(3).
+ *
+ * RETURN VALUE
+ * The rpma_conn_get_setup_times() function returns 0 on success or
+ * a negative error code on failure. rpma_conn_get_setup_times() does not set
+ * *times value on failure.
+ *
+ * ERRORS
+ * rpma_conn_get_setup_times() can fail with the following error:
+ *
+ * - RPMA_E_INVAL - conn or times is NULL
+ *
+ * SEE ALSO
+ * rpma_conn_req_new(3), rpma_conn_req_connect(3), rpma_conn_next_event(3),
+ * rpma_conn_get_stats(3), librpma(7) and https://pmem.io/rpma/
+ */
+int rpma_conn_get_setup_times(const struct rpma_conn *conn,
+		struct rpma_conn_setup_times *times);
+
+/* latency histograms */
+
+enum rpma_lat_op {
+	RPMA_LAT_OP_READ,
+	RPMA_LAT_OP_WRITE,
+	RPMA_LAT_OP_FLUSH,
+	RPMA_LAT_OP_SEND,
+	RPMA_LAT_OP_MAX
+};
+
+struct rpma_lat_hist;
+
+/** 3
+ * rpma_conn_enable_lat_hist - enable tracking latencies of the operations
+ *
+ * SYNOPSIS
+ *
+ *	#include <librpma.h>
+ *
+ *	struct rpma_conn;
+ *	int rpma_conn_enable_lat_hist(struct rpma_conn *conn);
+ *
+ * DESCRIPTION
+ * rpma_conn_enable_lat_hist() enables tracking the latencies of
+ * the operations posted via the connection. The latency of an operation is
+ * the time from posting it until its completion is collected from the main
+ * CQ of the connection by rpma_cq_get_wc(3). The latencies are recorded
+ * in log-linear histograms, one per the operation type:
+ *
+ * - RPMA_LAT_OP_READ - rpma_read(3)
+ * - RPMA_LAT_OP_WRITE - rpma_write(3) and rpma_write_with_imm(3)
+ * - RPMA_LAT_OP_FLUSH - rpma_flush(3)
+ * - RPMA_LAT_OP_SEND - rpma_send(3) and rpma_send_with_imm(3)
+ *
+ * Only the operations posted with the RPMA_F_COMPLETION_ALWAYS flag
+ * and completed successfully are recorded. The operations are matched with
+ * their completions by the op_context values so the op_context values of
+ * the operations in flight should be unique. When tracking is not enabled
+ * the data path is not affected apart from a single branch.
+ *
+ * RETURN VALUE
+ * The rpma_conn_enable_lat_hist() function returns 0 on success or
+ * a negative error code on failure. Enabling the tracking which is already
+ * enabled succeeds and has no effect.
+ *
+ * ERRORS
+ * rpma_conn_enable_lat_hist() can fail with the following errors:
+ *
+ * - RPMA_E_INVAL - conn is NULL
+ * - RPMA_E_NOMEM - out of memory
+ *
+ * SEE ALSO
+ * rpma_conn_get_lat_hist(3), rpma_lat_hist_new(3), librpma(7) and
+ * https://pmem.io/rpma/
+ */
+int rpma_conn_enable_lat_hist(struct rpma_conn *conn);
+
+/** 3
+ * rpma_conn_get_lat_hist - get the latency histogram of the operation type
+ *
+ * SYNOPSIS
+ *
+ *	#include <librpma.h>
+ *
+ *	struct rpma_conn;
+ *	struct rpma_lat_hist;
+ *	enum rpma_lat_op {
+ *		RPMA_LAT_OP_READ,
+ *		RPMA_LAT_OP_WRITE,
+ *		RPMA_LAT_OP_FLUSH,
+ *		RPMA_LAT_OP_SEND,
+ *		RPMA_LAT_OP_MAX
  *	};
+ *	int rpma_conn_get_lat_hist(const struct rpma_conn *conn,
+ *			enum rpma_lat_op op, struct rpma_lat_hist *hist);
  *
  * DESCRIPTION
- * rpma_utils_conn_event_2str() converts RPMA_CONN_* enum to the const string
- * representation.
+ * rpma_conn_get_lat_hist() adds the latencies of the given operation type
+ * recorded for the connection so far to the histogram created by
+ * rpma_lat_hist_new(3). Reset the histogram using rpma_lat_hist_reset(3)
+ * to get a fresh snapshot or keep merging the snapshots of many connections
+ * into a single histogram.
  *
  * RETURN VALUE
- * The rpma_utils_conn_event_2str() function returns the const string
- * representation of RPMA_CONN_* enums.
+ * The rpma_conn_get_lat_hist() function returns 0 on success or a negative
+ * error code on failure.
  *
  * ERRORS
- * rpma_utils_conn_event_2str() can not fail.
+ * rpma_conn_get_lat_hist() can fail with the following error:
+ *
+ * - RPMA_E_INVAL - conn or hist is NULL, op is not a valid operation type or
+ * the tracking is not enabled for the connection
  *
  * SEE ALSO
- * rpma_conn_next_event(3), librpma(7) and https://pmem.io/rpma/
+ * rpma_conn_enable_lat_hist(3), rpma_lat_hist_get_percentile(3), librpma(7)
+ * and https://pmem.io/rpma/
+ */
+int rpma_conn_get_lat_hist(const struct rpma_conn *conn, enum rpma_lat_op op,
+		struct rpma_lat_hist *hist);
+
+/** 3
+ * rpma_lat_hist_new - create a new empty latency histogram
+ *
+ * SYNOPSIS
+ *
+ *	#include <librpma.h>
+ *
+ *	struct rpma_lat_hist;
+ *	int rpma_lat_hist_new(struct rpma_lat_hist **hist_ptr);
+ *
+ * DESCRIPTION
+ * rpma_lat_hist_new() creates a new empty latency histogram. The histogram
+ * covers latencies from 1 ns up to about 137 s with the relative error
+ * not exceeding about 3%. Longer latencies are recorded in the last bucket.
+ *
+ * RETURN VALUE
+ * The rpma_lat_hist_new() function returns 0 on success or a negative
+ * error code on failure. rpma_lat_hist_new() does not set *hist_ptr value
+ * on failure.
+ *
+ * ERRORS
+ * rpma_lat_hist_new() can fail with the following errors:
+ *
+ * - RPMA_E_INVAL - hist_ptr is NULL
+ * - RPMA_E_NOMEM - out of memory
+ *
+ * SEE ALSO
+ * rpma_conn_get_lat_hist(3), rpma_lat_hist_delete(3),
+ * rpma_lat_hist_get_count(3), rpma_lat_hist_get_percentile(3),
+ * rpma_lat_hist_merge(3), rpma_lat_hist_reset(3), librpma(7) and
+ * https://pmem.io/rpma/
  */
-const char *rpma_utils_conn_event_2str(enum rpma_conn_event conn_event);
-
-struct rpma_conn_private_data {
-	void *ptr;
-	uint8_t len;
-};
+int rpma_lat_hist_new(struct rpma_lat_hist **hist_ptr);
 
 /** 3
- * rpma_conn_get_private_data - get a pointer to the connection's private data
+ * rpma_lat_hist_delete - delete the latency histogram
  *
  * SYNOPSIS
  *
  *	#include <librpma.h>
  *
- *	struct rpma_conn;
- *	struct rpma_conn_private_data;
- *	int rpma_conn_get_private_data(const struct rpma_conn *conn,
- *			struct rpma_conn_private_data *pdata);
+ *	struct rpma_lat_hist;
+ *	int rpma_lat_hist_delete(struct rpma_lat_hist **hist_ptr);
  *
  * DESCRIPTION
- * rpma_conn_get_private_data() obtains the pointer to the private data
- * given by the other side of the connection.
+ * rpma_lat_hist_delete() deletes the latency histogram created by
+ * rpma_lat_hist_new(3) and sets *hist_ptr to NULL.
  *
  * RETURN VALUE
- * The rpma_conn_get_private_data() function returns 0 on success or a negative
- * error code on failure. rpma_conn_get_private_data() does not set
- * *pdata value on failure.
+ * The rpma_lat_hist_delete() function returns 0 on success or a negative
+ * error code on failure.
  *
  * ERRORS
- * rpma_conn_get_private_data() can fail with the following error:
+ * rpma_lat_hist_delete() can fail with the following error:
  *
- * - RPMA_E_INVAL - conn or pdata is NULL
+ * - RPMA_E_INVAL - hist_ptr is NULL
  *
  * SEE ALSO
- * rpma_conn_req_connect(3), librpma(7) and https://pmem.io/rpma/
+ * rpma_lat_hist_new(3), librpma(7) and https://pmem.io/rpma/
  */
-int rpma_conn_get_private_data(const struct rpma_conn *conn,
-		struct rpma_conn_private_data *pdata);
+int rpma_lat_hist_delete(struct rpma_lat_hist **hist_ptr);
 
 /** 3
- * rpma_conn_apply_remote_peer_cfg - apply remote peer cfg to the connection
+ * rpma_lat_hist_reset - remove all the values from the latency histogram
  *
  * SYNOPSIS
  *
  *	#include <librpma.h>
  *
- *	struct rpma_conn;
- *	struct rpma_peer_cfg;
- *	int rpma_conn_apply_remote_peer_cfg(struct rpma_conn *conn,
- *			const struct rpma_peer_cfg *pcfg);
+ *	struct rpma_lat_hist;
+ *	int rpma_lat_hist_reset(struct rpma_lat_hist *hist);
  *
  * DESCRIPTION
- * rpma_conn_apply_remote_peer_cfg() applies the remote peer configuration
- * to the connection.
+ * rpma_lat_hist_reset() removes all the values recorded in the histogram.
  *
  * RETURN VALUE
- * The rpma_conn_apply_remote_peer_cfg() function returns 0 on success
- * or a negative error code on failure. rpma_conn_apply_remote_peer_cfg()
- * does not set *pcfg value on failure.
+ * The rpma_lat_hist_reset() function returns 0 on success or a negative
+ * error code on failure.
  *
  * ERRORS
- * rpma_conn_apply_remote_peer_cfg() can fail with the following error:
+ * rpma_lat_hist_reset() can fail with the following error:
  *
- * - RPMA_E_INVAL - conn or pcfg are NULL
+ * - RPMA_E_INVAL - hist is NULL
  *
  * SEE ALSO
- * rpma_conn_req_connect(3), rpma_peer_cfg_new(3), librpma(7) and
- * https://pmem.io/rpma/
+ * rpma_lat_hist_new(3), librpma(7) and https://pmem.io/rpma/
  */
-int rpma_conn_apply_remote_peer_cfg(struct rpma_conn *conn,
-		const struct rpma_peer_cfg *pcfg);
+int rpma_lat_hist_reset(struct rpma_lat_hist *hist);
 
 /** 3
- * rpma_conn_get_qp_num - get the connection's qp_num
+ * rpma_lat_hist_merge - merge two latency histograms
  *
  * SYNOPSIS
  *
  *	#include <librpma.h>
  *
- *	struct rpma_conn;
- *	int rpma_conn_get_qp_num(const struct rpma_conn *conn,
- *			uint32_t *qp_num);
+ *	struct rpma_lat_hist;
+ *	int rpma_lat_hist_merge(struct rpma_lat_hist *dst,
+ *			const struct rpma_lat_hist *src);
  *
  * DESCRIPTION
- * rpma_conn_get_qp_num() obtains the unique identifier of the connection.
+ * rpma_lat_hist_merge() adds all the values recorded in the src histogram
+ * to the dst histogram. It allows e.g. aggregating the latencies collected
+ * by many connections or many threads.
  *
  * RETURN VALUE
- * The rpma_conn_get_qp_num() function returns 0 on success or a negative
- * error code on failure. rpma_conn_get_qp_num() does not set *qp_num
- * value on failure.
+ * The rpma_lat_hist_merge() function returns 0 on success or a negative
+ * error code on failure.
  *
  * ERRORS
- * rpma_conn_get_qp_num() can fail with the following error:
+ * rpma_lat_hist_merge() can fail with the following error:
  *
- * - RPMA_E_INVAL - conn or qp_num is NULL
+ * - RPMA_E_INVAL - dst or src is NULL
  *
  * SEE ALSO
- * rpma_conn_req_new(3), rpma_ep_next_conn_req(3), rpma_conn_req_connect(3),
- * librpma(7) and https://pmem.io/rpma/
+ * rpma_conn_get_lat_hist(3), rpma_lat_hist_new(3), librpma(7) and
+ * https://pmem.io/rpma/
  */
-int rpma_conn_get_qp_num(const struct rpma_conn *conn, uint32_t *qp_num);
-
-struct rpma_cq;
+int rpma_lat_hist_merge(struct rpma_lat_hist *dst,
+		const struct rpma_lat_hist *src);
 
 /** 3
- * rpma_conn_get_cq - get the connection's main CQ
+ * rpma_lat_hist_get_count - get the number of values in the histogram
  *
  * SYNOPSIS
  *
  *	#include <librpma.h>
  *
- *	struct rpma_conn;
- *	struct rpma_cq;
- *	int rpma_conn_get_cq(const struct rpma_conn *conn,
- *			struct rpma_cq **cq_ptr);
+ *	struct rpma_lat_hist;
+ *	int rpma_lat_hist_get_count(const struct rpma_lat_hist *hist,
+ *			uint64_t *count);
  *
  * DESCRIPTION
- * rpma_conn_get_cq() gets the main CQ from the connection. When the receive
- * CQ is not present the main CQ allows handling all completions within
- * the connection. When the receive CQ is present the main CQ allows handling
- * all completions except rpma_recv(3) completions within the connection.
- * Please see rpma_conn_get_rcq(3) for details about the receive CQ.
+ * rpma_lat_hist_get_count() gets the number of values recorded
+ * in the histogram.
  *
  * RETURN VALUE
- * The rpma_conn_get_cq() function returns 0 on success or a negative error
- * code on failure. rpma_conn_get_cq() does not set *cq_ptr value on failure.
+ * The rpma_lat_hist_get_count() function returns 0 on success or a negative
+ * error code on failure. rpma_lat_hist_get_count() does not set *count value
+ * on failure.
  *
  * ERRORS
- * rpma_conn_get_cq() can fail with the following error:
+ * rpma_lat_hist_get_count() can fail with the following error:
  *
- * - RPMA_E_INVAL - conn or cq_ptr is NULL
+ * - RPMA_E_INVAL - hist or count is NULL
  *
  * SEE ALSO
- * rpma_conn_req_connect(3), rpma_conn_get_rcq(3), rpma_cq_wait(3),
- * rpma_cq_get_wc(3), rpma_cq_get_fd(3), rpma_recv(3), librpma(7)
- * and https://pmem.io/rpma/
+ * rpma_lat_hist_get_percentile(3), rpma_lat_hist_new(3), librpma(7) and
+ * https://pmem.io/rpma/
  */
-int rpma_conn_get_cq(const struct rpma_conn *conn, struct rpma_cq **cq_ptr);
+int rpma_lat_hist_get_count(const struct rpma_lat_hist *hist,
+		uint64_t *count);
 
 /** 3
- * rpma_conn_get_rcq -- get the connection's receive CQ
+ * rpma_lat_hist_get_percentile - get a percentile of the latencies
  *
  * SYNOPSIS
  *
  *	#include <librpma.h>
  *
- *	struct rpma_conn;
- *	struct rpma_cq;
- *	int rpma_conn_get_rcq(const struct rpma_conn *conn,
- *			struct rpma_cq **rcq_ptr);
+ *	struct rpma_lat_hist;
+ *	int rpma_lat_hist_get_percentile(const struct rpma_lat_hist *hist,
+ *			double percentile, uint64_t *latency_ns);
  *
  * DESCRIPTION
- * rpma_conn_get_rcq() gets the receive CQ from the connection. The receive
- * CQ allows handling all rpma_recv(3) completions within the connection.
- * It allows separating rpma_recv(3) completions processing path from all other
- * completions. The receive CQ is created only if the receive CQ size in
- * the provided connection configuration is greater than 0. When the receive CQ
- * does not exist for the given connection the *rcq_ptr == NULL.
+ * rpma_lat_hist_get_percentile() gets the latency (in nanoseconds) which
+ * the given percentage of the recorded values does not exceed,
+ * e.g. percentile equal 50.0 gets the median and 99.9 gets the tail
+ * latency. The returned value is the upper bound of the histogram's bucket
+ * so it may exceed the exact latency by up to about 3%. If the histogram
+ * is empty *latency_ns is set to 0.
  *
  * RETURN VALUE
- * The rpma_conn_get_rcq() function returns 0 on success or a negative error
- * code on failure. rpma_conn_get_rcq() does not set *rcq_ptr value on failure.
+ * The rpma_lat_hist_get_percentile() function returns 0 on success or
+ * a negative error code on failure. rpma_lat_hist_get_percentile() does not
+ * set *latency_ns value on failure.
  *
  * ERRORS
- * rpma_conn_get_rcq() can fail with the following error:
+ * rpma_lat_hist_get_percentile() can fail with the following error:
  *
- * - RPMA_E_INVAL - conn or rcq_ptr is NULL
+ * - RPMA_E_INVAL - hist or latency_ns is NULL or percentile is not
+ * in the (0, 100] range
  *
  * SEE ALSO
- * rpma_conn_cfg_set_rcq_size(3), rpma_conn_req_connect(3), rpma_conn_get_cq(3),
- * rpma_cq_wait(3), rpma_cq_get_wc(3), rpma_cq_get_fd(3), rpma_recv(3),
- * librpma(7) and https://pmem.io/rpma/
+ * rpma_lat_hist_get_count(3), rpma_lat_hist_new(3), librpma(7) and
+ * https://pmem.io/rpma/
  */
-int rpma_conn_get_rcq(const struct rpma_conn *conn, struct rpma_cq **rcq_ptr);
+int rpma_lat_hist_get_percentile(const struct rpma_lat_hist *hist,
+		double percentile, uint64_t *latency_ns);
 
 /** 3
  * rpma_conn_disconnect - tear the connection down
@@ -2007,6 +3171,8 @@ struct rpma_conn_req;
  * rpma_conn_req_new() can fail with the following errors:
  *
  * - RPMA_E_INVAL - peer, addr, port or req_ptr is NULL
+ * - RPMA_E_INVAL - the completion vector set in cfg is out of the range
+ *   of the completion vectors of the device
  * - RPMA_E_NOMEM - out of memory
  * - RPMA_E_PROVIDER - rdma_create_id(3), rdma_resolve_addr(3),
  *   rdma_resolve_route(3) or ibv_create_cq(3) failed
@@ -2334,6 +3500,8 @@ int rpma_ep_get_fd(const struct rpma_ep *ep, int *fd);
  *
  * - RPMA_E_INVAL - ep or req_ptr is NULL
  * - RPMA_E_INVAL - obtained an event different than a connection request
+ * - RPMA_E_INVAL - the completion vector set in cfg is out of the range
+ *   of the completion vectors of the device
  * - RPMA_E_PROVIDER - rdma_get_cm_event(3) failed
  * - RPMA_E_NOMEM - out of memory
  * - RPMA_E_NO_EVENT - no next connection request available
@@ -2795,6 +3963,124 @@ int rpma_recv(struct rpma_conn *conn,
 		struct rpma_mr_local *dst, size_t offset, size_t len,
 		const void *op_context);
 
+/** 3
+ * rpma_bind_mw - initiate binding a memory window
+ *
+ * SYNOPSIS
+ *
+ *	#include <librpma.h>
+ *
+ *	struct rpma_conn;
+ *	struct rpma_mw;
+ *	struct rpma_mr_local;
+ *	int rpma_bind_mw(struct rpma_conn *conn, struct rpma_mw *mw,
+ *			const struct rpma_mr_local *mr, size_t offset,
+ *			size_t len, int usage, int flags,
+ *			const void *op_context);
+ *
+ * DESCRIPTION
+ * rpma_bind_mw() initiates binding the memory window to the range of
+ * the local memory region starting at offset of length len. The binding is
+ * posted to the send queue of the connection, so it does not involve
+ * the kernel. The memory region has to be registered with
+ * RPMA_MR_USAGE_MW_BIND. The usage parameter specifies the operations
+ * the other side of the connection can perform on the range and it has to
+ * be a subset of the usage of the memory region expressed as
+ * bitwise-inclusive OR of the following:
+ * - RPMA_MR_USAGE_READ_SRC - memory used as a source of the read operation
+ * - RPMA_MR_USAGE_WRITE_DST - memory used as a destination of
+ * the write operation
+ *
+ * The flush types of the memory region (RPMA_MR_USAGE_FLUSH_TYPE_*) are
+ * granted too, so the range can be flushed as the whole memory region can.
+ *
+ * The memory window can be accessed only via this connection. Every binding
+ * gets a new remote key, so the descriptors of the previous bindings
+ * do not grant any access. The memory window has to be invalidated using
+ * rpma_invalidate_mw(3) before it is bound again.
+ *
+ * The new remote key and the range are taken by the memory window as soon
+ * as the binding is posted, but they grant the access only after
+ * the binding completes successfully. Please wait for the IBV_WC_BIND_MW
+ * completion of the IBV_WC_SUCCESS status before sending the descriptor of
+ * the memory window (see rpma_mw_get_descriptor(3)) to the other side.
+ * If the binding completes with an error, the descriptor grants no access
+ * and the memory window can only be deleted.
+ *
+ * The attribute flags set the completion notification indicator:
+ * - RPMA_F_COMPLETION_ON_ERROR - generate the completion on error
+ * - RPMA_F_COMPLETION_ALWAYS - generate the completion regardless of result of
+ * the operation.
+ *
+ * op_context is returned in the wr_id field of the completion (struct ibv_wc)
+ * of the IBV_WC_BIND_MW opcode.
+ *
+ * RETURN VALUE
+ * The rpma_bind_mw() function returns 0 on success or a negative
+ * error code on failure.
+ *
+ * ERRORS
+ * rpma_bind_mw() can fail with the following errors:
+ *
+ * - RPMA_E_INVAL - conn, mw or mr is NULL or flags == 0
+ * - RPMA_E_INVAL - the memory window is already bound
+ * - RPMA_E_INVAL - mr is not registered with RPMA_MR_USAGE_MW_BIND
+ * - RPMA_E_INVAL - usage is not valid or is not allowed by mr
+ * - RPMA_E_INVAL - len == 0 or the range is out of the mr bounds
+ * - RPMA_E_PROVIDER - ibv_post_send(3) failed
+ *
+ * SEE ALSO
+ * rpma_conn_req_connect(3), rpma_invalidate_mw(3), rpma_mr_reg(3),
+ * rpma_mw_get_descriptor(3), rpma_mw_new(3), librpma(7) and
+ * https://pmem.io/rpma/
+ */
+int rpma_bind_mw(struct rpma_conn *conn, struct rpma_mw *mw,
+		const struct rpma_mr_local *mr, size_t offset, size_t len,
+		int usage, int flags, const void *op_context);
+
+/** 3
+ * rpma_invalidate_mw - initiate invalidating a memory window
+ *
+ * SYNOPSIS
+ *
+ *	#include <librpma.h>
+ *
+ *	struct rpma_conn;
+ *	struct rpma_mw;
+ *	int rpma_invalidate_mw(struct rpma_conn *conn, struct rpma_mw *mw,
+ *			int flags, const void *op_context);
+ *
+ * DESCRIPTION
+ * rpma_invalidate_mw() initiates invalidating the memory window bound
+ * via the connection using rpma_bind_mw(3). Once the invalidation is
+ * completed, the other side cannot access the memory using the descriptor
+ * of the memory window anymore and the memory window can be bound again.
+ *
+ * The attribute flags set the completion notification indicator:
+ * - RPMA_F_COMPLETION_ON_ERROR - generate the completion on error
+ * - RPMA_F_COMPLETION_ALWAYS - generate the completion regardless of result of
+ * the operation.
+ *
+ * op_context is returned in the wr_id field of the completion (struct ibv_wc)
+ * of the IBV_WC_LOCAL_INV opcode.
+ *
+ * RETURN VALUE
+ * The rpma_invalidate_mw() function returns 0 on success or a negative
+ * error code on failure.
+ *
+ * ERRORS
+ * rpma_invalidate_mw() can fail with the following errors:
+ *
+ * - RPMA_E_INVAL - conn or mw is NULL or flags == 0
+ * - RPMA_E_INVAL - the memory window is not bound
+ * - RPMA_E_PROVIDER - ibv_post_send(3) failed
+ *
+ * SEE ALSO
+ * rpma_bind_mw(3), rpma_mw_delete(3), librpma(7) and https://pmem.io/rpma/
+ */
+int rpma_invalidate_mw(struct rpma_conn *conn, struct rpma_mw *mw, int flags,
+		const void *op_context);
+
 /* completion handling */
 
 /** 3
@@ -2836,6 +4122,39 @@ int rpma_recv(struct rpma_conn *conn,
  */
 int rpma_cq_get_fd(const struct rpma_cq *cq, int *fd);
 
+/** 3
+ * rpma_cq_get_comp_vector - get the completion vector of the completion queue
+ *
+ * SYNOPSIS
+ *
+ *	#include <librpma.h>
+ *
+ *	struct rpma_cq;
+ *	int rpma_cq_get_comp_vector(const struct rpma_cq *cq, int *comp_vector);
+ *
+ * DESCRIPTION
+ * rpma_cq_get_comp_vector() gets the completion vector the completion queue
+ * was created with (RPMA_COMP_VECTOR_ROUND_ROBIN is already resolved here).
+ * The completion vector can be mapped to the IRQ and the CPU the completion
+ * events are delivered to using the device-specific IRQ names listed
+ * in /proc/interrupts and the smp_affinity_list files of those IRQs.
+ *
+ * RETURN VALUE
+ * The rpma_cq_get_comp_vector() function returns 0 on success or a negative
+ * error code on failure. rpma_cq_get_comp_vector() does not set *comp_vector
+ * value on failure.
+ *
+ * ERRORS
+ * rpma_cq_get_comp_vector() can fail with the following error:
+ *
+ * - RPMA_E_INVAL - cq or comp_vector is NULL
+ *
+ * SEE ALSO
+ * rpma_conn_cfg_set_comp_vector(3), rpma_conn_get_cq(3),
+ * rpma_conn_get_rcq(3), librpma(7) and https://pmem.io/rpma/
+ */
+int rpma_cq_get_comp_vector(const struct rpma_cq *cq, int *comp_vector);
+
 /** 3
  * rpma_cq_wait - wait for a completion and ack it
  *
@@ -2927,6 +4246,90 @@ int rpma_cq_wait(struct rpma_cq *cq);
 int rpma_cq_get_wc(struct rpma_cq *cq, int num_entries, struct ibv_wc *wc,
 		int *num_entries_got);
 
+struct rpma_cq_stats {
+	uint64_t polls;
+	uint64_t empty_polls;
+	uint64_t completions;
+	uint64_t error_completions;
+	uint64_t events;
+};
+
+/** 3
+ * rpma_cq_get_stats - get the statistics counters of the completion queue
+ *
+ * SYNOPSIS
+ *
+ *	#include <librpma.h>
+ *
+ *	struct rpma_cq;
+ *	struct rpma_cq_stats {
+ *		uint64_t polls;
+ *		uint64_t empty_polls;
+ *		uint64_t completions;
+ *		uint64_t error_completions;
+ *		uint64_t events;
+ *	};
+ *	int rpma_cq_get_stats(const struct rpma_cq *cq,
+ *			struct rpma_cq_stats *stats);
+ *
+ * DESCRIPTION
+ * rpma_cq_get_stats() gets the statistics counters of the CQ accumulated
+ * since the CQ was created or since the last call to rpma_cq_reset_stats(3):
+ *
+ * - polls - number of times the CQ was polled by rpma_cq_get_wc(3)
+ * - empty_polls - polls which returned RPMA_E_NO_COMPLETION
+ * - completions - number of collected completions
+ * - error_completions - collected completions with a status other than
+ * IBV_WC_SUCCESS
+ * - events - completion events collected by rpma_cq_wait(3)
+ *
+ * Completion events collected via the shared completion channel are counted
+ * by the connection, see rpma_conn_get_stats(3). The counters are updated
+ * with relaxed atomic operations and the returned values do not have to make
+ * up a consistent snapshot.
+ *
+ * RETURN VALUE
+ * The rpma_cq_get_stats() function returns 0 on success or a negative error
+ * code on failure. rpma_cq_get_stats() does not set *stats value on failure.
+ *
+ * ERRORS
+ * rpma_cq_get_stats() can fail with the following error:
+ *
+ * - RPMA_E_INVAL - cq or stats is NULL
+ *
+ * SEE ALSO
+ * rpma_conn_get_cq(3), rpma_conn_get_rcq(3), rpma_conn_get_stats(3),
+ * rpma_cq_reset_stats(3), librpma(7) and https://pmem.io/rpma/
+ */
+int rpma_cq_get_stats(const struct rpma_cq *cq, struct rpma_cq_stats *stats);
+
+/** 3
+ * rpma_cq_reset_stats - zero the statistics counters of the completion queue
+ *
+ * SYNOPSIS
+ *
+ *	#include <librpma.h>
+ *
+ *	struct rpma_cq;
+ *	int rpma_cq_reset_stats(struct rpma_cq *cq);
+ *
+ * DESCRIPTION
+ * rpma_cq_reset_stats() zeroes all the statistics counters of the CQ.
+ *
+ * RETURN VALUE
+ * The rpma_cq_reset_stats() function returns 0 on success or a negative
+ * error code on failure.
+ *
+ * ERRORS
+ * rpma_cq_reset_stats() can fail with the following error:
+ *
+ * - RPMA_E_INVAL - cq is NULL
+ *
+ * SEE ALSO
+ * rpma_cq_get_stats(3), librpma(7) and https://pmem.io/rpma/
+ */
+int rpma_cq_reset_stats(struct rpma_cq *cq);
+
 /* error handling */
 
 /** 3
@@ -3172,6 +4575,80 @@ typedef void rpma_log_function(
  */
 int rpma_log_set_function(rpma_log_function *log_function);
 
+/** 3
+ * rpma_log_async_start - write the log messages from a background thread
+ *
+ * SYNOPSIS
+ *
+ *	#include <librpma.h>
+ *
+ *	int rpma_log_async_start(void);
+ *
+ * DESCRIPTION
+ * rpma_log_async_start() switches the default logging function into
+ * the asynchronous mode. In this mode the messages are only formatted on
+ * the calling thread and put into a per-thread lock-free ring. A background
+ * thread started by rpma_log_async_start() takes the messages out of
+ * the rings and writes them to syslog(3) and stderr(3) the same way
+ * the default logging function does. This way the threads generating
+ * the messages (e.g. the ones establishing connections) do not wait
+ * for syslog(3) and stderr(3).
+ *
+ * Each thread can have up to 128 messages waiting to be written.
+ * When the ring of the thread is full the message is dropped
+ * and the number of the dropped messages is logged later on.
+ * Messages are truncated to 255 characters. Messages on
+ * the RPMA_LOG_LEVEL_FATAL level are always written synchronously.
+ *
+ * Calling rpma_log_async_start() when the asynchronous mode is already
+ * started succeeds and has no effect.
+ *
+ * RETURN VALUE
+ * The rpma_log_async_start() function returns 0 on success or a negative
+ * error code on failure.
+ *
+ * ERRORS
+ * rpma_log_async_start() can fail with the following error:
+ *
+ * - RPMA_E_AGAIN - the background thread could not be created or
+ * a user-defined logging function is set (see rpma_log_set_function(3))
+ *
+ * NOTE
+ * rpma_log_async_start() and rpma_log_async_stop(3) are not thread-safe.
+ * The asynchronous mode is stopped automatically when the library is
+ * unloaded.
+ *
+ * SEE ALSO
+ * rpma_log_async_stop(3), rpma_log_set_function(3), librpma(7) and
+ * https://pmem.io/rpma/
+ */
+int rpma_log_async_start(void);
+
+/** 3
+ * rpma_log_async_stop - write the log messages from the calling thread
+ *
+ * SYNOPSIS
+ *
+ *	#include <librpma.h>
+ *
+ *	int rpma_log_async_stop(void);
+ *
+ * DESCRIPTION
+ * rpma_log_async_stop() writes out all the pending messages, stops
+ * the background thread started by rpma_log_async_start(3) and switches
+ * the default logging function back to writing the messages from
+ * the calling thread. Calling rpma_log_async_stop() when the asynchronous
+ * mode is not started succeeds and has no effect.
+ *
+ * RETURN VALUE
+ * The rpma_log_async_stop() function returns 0.
+ *
+ * SEE ALSO
+ * rpma_log_async_start(3), rpma_log_set_function(3), librpma(7) and
+ * https://pmem.io/rpma/
+ */
+int rpma_log_async_stop(void);
+
 #ifdef __cplusplus
 }
 #endif
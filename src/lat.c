@@ -0,0 +1,457 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * lat.c -- librpma per-operation latency tracking and histograms
+ */
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+#include "debug.h"
+#include "lat.h"
+
+#ifdef TEST_MOCK_ALLOC
+#include "cmocka_alloc.h"
+#endif
+
+/*
+ * The histogram is log-linear (HDR-style): every power-of-two range of
+ * latencies is split into RPMA_LAT_SUB_COUNT linear sub-buckets so
+ * the relative error of a recorded value is below 1 / RPMA_LAT_SUB_COUNT
+ * (~3%). Latencies below RPMA_LAT_SUB_COUNT ns are recorded exactly
+ * and latencies of 2^RPMA_LAT_MAX_EXP ns (~137 s) and more are clamped.
+ */
+#define RPMA_LAT_SUB_BITS	5
+#define RPMA_LAT_SUB_COUNT	(1 << RPMA_LAT_SUB_BITS)
+#define RPMA_LAT_MAX_EXP	37
+#define RPMA_LAT_MAX_VALUE	((1ULL << RPMA_LAT_MAX_EXP) - 1)
+#define RPMA_LAT_BUCKETS \
+	((RPMA_LAT_MAX_EXP - RPMA_LAT_SUB_BITS + 1) * RPMA_LAT_SUB_COUNT)
+
+struct rpma_lat_hist {
+	uint64_t total; /* number of recorded values */
+	uint64_t buckets[RPMA_LAT_BUCKETS];
+};
+
+/*
+ * The pending operations are kept in an open-addressing table keyed by
+ * wr_id. A released slot becomes a tombstone which can be reused but never
+ * becomes free again so a lookup can stop at the first free slot. Probing
+ * is also limited to RPMA_LAT_PROBE slots so the completions which are not
+ * tracked (e.g. of atomic writes) stay cheap when tombstones accumulate.
+ */
+#define RPMA_LAT_PENDING_BITS	10
+#define RPMA_LAT_PENDING	(1U << RPMA_LAT_PENDING_BITS)
+#define RPMA_LAT_PENDING_MASK	(RPMA_LAT_PENDING - 1)
+#define RPMA_LAT_PROBE		32
+
+enum rpma_lat_state {
+	RPMA_LAT_SLOT_FREE,	/* never used */
+	RPMA_LAT_SLOT_BUSY,	/* being filled in or consumed */
+	RPMA_LAT_SLOT_READY,
+	RPMA_LAT_SLOT_DELETED,	/* tombstone */
+};
+
+struct rpma_lat_pending {
+	uint64_t wr_id;
+	uint64_t start_ns;
+	uint32_t op;
+	uint32_t state;
+};
+
+struct rpma_lat {
+	struct rpma_lat_hist hist[RPMA_LAT_OP_MAX];
+	struct rpma_lat_pending pending[RPMA_LAT_PENDING];
+};
+
+/*
+ * rpma_lat_hash -- get the home slot of the wr_id (Fibonacci hashing)
+ */
+static inline uint32_t
+rpma_lat_hash(uint64_t wr_id)
+{
+	return (uint32_t)((wr_id * 0x9E3779B97F4A7C15ULL) >>
+			(64 - RPMA_LAT_PENDING_BITS));
+}
+
+/*
+ * rpma_lat_is_unique -- check there is no pending operation with the wr_id
+ * in the rest of its probe sequence starting from the i-th slot
+ */
+static inline bool
+rpma_lat_is_unique(struct rpma_lat *lat, uint32_t home, uint32_t i,
+		uint64_t wr_id)
+{
+	for (; i < RPMA_LAT_PROBE; i++) {
+		struct rpma_lat_pending *p =
+			&lat->pending[(home + i) & RPMA_LAT_PENDING_MASK];
+		uint32_t state = __atomic_load_n(&p->state, __ATOMIC_ACQUIRE);
+
+		if (state == RPMA_LAT_SLOT_FREE)
+			return true;
+
+		if ((state == RPMA_LAT_SLOT_READY ||
+				state == RPMA_LAT_SLOT_BUSY) && p->wr_id == wr_id)
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * rpma_lat_hist_index -- get the bucket of the value
+ */
+static inline unsigned
+rpma_lat_hist_index(uint64_t value)
+{
+	if (value > RPMA_LAT_MAX_VALUE)
+		value = RPMA_LAT_MAX_VALUE;
+
+	if (value < RPMA_LAT_SUB_COUNT)
+		return (unsigned)value;
+
+	unsigned exp = 63 - (unsigned)__builtin_clzll(value);
+	unsigned shift = exp - RPMA_LAT_SUB_BITS;
+	unsigned sub = (unsigned)(value >> shift) & (RPMA_LAT_SUB_COUNT - 1);
+
+	return (shift + 1) * RPMA_LAT_SUB_COUNT + sub;
+}
+
+/*
+ * rpma_lat_hist_highest -- get the highest value recorded in the bucket
+ */
+static inline uint64_t
+rpma_lat_hist_highest(unsigned index)
+{
+	if (index < RPMA_LAT_SUB_COUNT)
+		return index;
+
+	unsigned shift = index / RPMA_LAT_SUB_COUNT - 1;
+	uint64_t sub = index % RPMA_LAT_SUB_COUNT;
+	uint64_t lowest = (RPMA_LAT_SUB_COUNT + sub) << shift;
+
+	return lowest + (1ULL << shift) - 1;
+}
+
+/*
+ * rpma_lat_hist_record -- record the value in the histogram
+ */
+static inline void
+rpma_lat_hist_record(struct rpma_lat_hist *hist, uint64_t value)
+{
+	RPMA_STATS_INC(hist->buckets[rpma_lat_hist_index(value)]);
+	RPMA_STATS_INC(hist->total);
+}
+
+/* internal librpma API */
+
+/*
+ * rpma_lat_new -- allocate a new latency tracking object
+ */
+int
+rpma_lat_new(struct rpma_lat **lat_ptr)
+{
+	RPMA_DEBUG_TRACE;
+	RPMA_FAULT_INJECTION(RPMA_E_NOMEM, {});
+
+	struct rpma_lat *lat = malloc(sizeof(*lat));
+	if (lat == NULL)
+		return RPMA_E_NOMEM;
+
+	memset(lat, 0, sizeof(*lat));
+
+	*lat_ptr = lat;
+
+	return 0;
+}
+
+/*
+ * rpma_lat_delete -- free the latency tracking object
+ */
+void
+rpma_lat_delete(struct rpma_lat **lat_ptr)
+{
+	RPMA_DEBUG_TRACE;
+
+	free(*lat_ptr);
+	*lat_ptr = NULL;
+}
+
+/*
+ * rpma_lat_post -- remember the start time of the operation
+ */
+int
+rpma_lat_post(struct rpma_lat *lat, enum rpma_lat_op op, uint64_t wr_id)
+{
+	uint32_t home = rpma_lat_hash(wr_id);
+
+retry:
+	for (uint32_t i = 0; i < RPMA_LAT_PROBE; i++) {
+		uint32_t slot = (home + i) & RPMA_LAT_PENDING_MASK;
+		struct rpma_lat_pending *p = &lat->pending[slot];
+		uint32_t state = __atomic_load_n(&p->state, __ATOMIC_ACQUIRE);
+
+		/*
+		 * A completion would match the oldest pending operation with
+		 * the same wr_id only by chance so duplicates are not tracked.
+		 */
+		if (state == RPMA_LAT_SLOT_READY ||
+				state == RPMA_LAT_SLOT_BUSY) {
+			if (p->wr_id == wr_id)
+				return -1;
+			continue;
+		}
+
+		if (state == RPMA_LAT_SLOT_DELETED && !rpma_lat_is_unique(lat,
+				home, i + 1, wr_id))
+			return -1;
+
+		if (!__atomic_compare_exchange_n(&p->state, &state,
+				RPMA_LAT_SLOT_BUSY, false,
+				__ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+			goto retry;
+
+		p->wr_id = wr_id;
+		p->op = (uint32_t)op;
+		p->start_ns = rpma_now_ns();
+		__atomic_store_n(&p->state, RPMA_LAT_SLOT_READY,
+				__ATOMIC_RELEASE);
+
+		return (int)slot;
+	}
+
+	/* too many operations in flight - this one will not be accounted */
+	return -1;
+}
+
+/*
+ * rpma_lat_cancel -- forget the operation which failed to be posted
+ */
+void
+rpma_lat_cancel(struct rpma_lat *lat, int slot)
+{
+	if (slot < 0)
+		return;
+
+	__atomic_store_n(&lat->pending[slot].state, RPMA_LAT_SLOT_DELETED,
+			__ATOMIC_RELEASE);
+}
+
+/*
+ * rpma_lat_complete -- record the latencies of the collected completions
+ */
+void
+rpma_lat_complete(struct rpma_lat *lat, const struct ibv_wc *wc,
+		int num_entries)
+{
+	uint64_t now = rpma_now_ns();
+
+	for (int n = 0; n < num_entries; n++) {
+		/*
+		 * receives are not posted by the connection's data path and
+		 * the memory window operations are never tracked
+		 */
+		if (wc[n].opcode & IBV_WC_RECV ||
+				(wc[n].status == IBV_WC_SUCCESS &&
+				(wc[n].opcode == IBV_WC_BIND_MW ||
+				wc[n].opcode == IBV_WC_LOCAL_INV)))
+			continue;
+
+		uint64_t wr_id = wc[n].wr_id;
+		uint32_t home = rpma_lat_hash(wr_id);
+		for (uint32_t i = 0; i < RPMA_LAT_PROBE; i++) {
+			uint32_t slot = (home + i) & RPMA_LAT_PENDING_MASK;
+			struct rpma_lat_pending *p = &lat->pending[slot];
+
+			uint32_t expected = RPMA_LAT_SLOT_READY;
+			uint32_t state = __atomic_load_n(&p->state,
+					__ATOMIC_ACQUIRE);
+			if (state == RPMA_LAT_SLOT_FREE)
+				break;
+			if (state != expected || p->wr_id != wr_id)
+				continue;
+
+			/* claim the slot - there may be many pollers */
+			if (!__atomic_compare_exchange_n(&p->state, &expected,
+					RPMA_LAT_SLOT_BUSY, false,
+					__ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+				continue;
+
+			/* the slot could have been reused in the meantime */
+			if (p->wr_id != wr_id) {
+				__atomic_store_n(&p->state, RPMA_LAT_SLOT_READY,
+						__ATOMIC_RELEASE);
+				continue;
+			}
+
+			uint64_t start_ns = p->start_ns;
+			uint32_t op = p->op;
+			__atomic_store_n(&p->state, RPMA_LAT_SLOT_DELETED,
+					__ATOMIC_RELEASE);
+
+			if (wc[n].status == IBV_WC_SUCCESS)
+				rpma_lat_hist_record(&lat->hist[op],
+					now > start_ns ? now - start_ns : 0);
+			break;
+		}
+	}
+}
+
+/*
+ * rpma_lat_get_hist -- get the histogram of the operation type
+ */
+const struct rpma_lat_hist *
+rpma_lat_get_hist(const struct rpma_lat *lat, enum rpma_lat_op op)
+{
+	return &lat->hist[op];
+}
+
+/* public librpma API */
+
+/*
+ * rpma_lat_hist_new -- create a new empty latency histogram
+ */
+int
+rpma_lat_hist_new(struct rpma_lat_hist **hist_ptr)
+{
+	RPMA_DEBUG_TRACE;
+	RPMA_FAULT_INJECTION(RPMA_E_INVAL, {});
+
+	if (hist_ptr == NULL)
+		return RPMA_E_INVAL;
+
+	RPMA_FAULT_INJECTION(RPMA_E_NOMEM, {});
+	struct rpma_lat_hist *hist = malloc(sizeof(*hist));
+	if (hist == NULL)
+		return RPMA_E_NOMEM;
+
+	memset(hist, 0, sizeof(*hist));
+
+	*hist_ptr = hist;
+
+	return 0;
+}
+
+/*
+ * rpma_lat_hist_delete -- delete the latency histogram
+ */
+int
+rpma_lat_hist_delete(struct rpma_lat_hist **hist_ptr)
+{
+	RPMA_DEBUG_TRACE;
+	RPMA_FAULT_INJECTION(RPMA_E_INVAL, {});
+
+	if (hist_ptr == NULL)
+		return RPMA_E_INVAL;
+
+	free(*hist_ptr);
+	*hist_ptr = NULL;
+
+	return 0;
+}
+
+/*
+ * rpma_lat_hist_reset -- zero the latency histogram
+ */
+int
+rpma_lat_hist_reset(struct rpma_lat_hist *hist)
+{
+	RPMA_DEBUG_TRACE;
+	RPMA_FAULT_INJECTION(RPMA_E_INVAL, {});
+
+	if (hist == NULL)
+		return RPMA_E_INVAL;
+
+	for (unsigned i = 0; i < RPMA_LAT_BUCKETS; i++)
+		RPMA_STATS_RESET(hist->buckets[i]);
+	RPMA_STATS_RESET(hist->total);
+
+	return 0;
+}
+
+/*
+ * rpma_lat_hist_merge -- add all the values recorded in src to dst
+ */
+int
+rpma_lat_hist_merge(struct rpma_lat_hist *dst, const struct rpma_lat_hist *src)
+{
+	RPMA_DEBUG_TRACE;
+	RPMA_FAULT_INJECTION(RPMA_E_INVAL, {});
+
+	if (dst == NULL || src == NULL)
+		return RPMA_E_INVAL;
+
+	uint64_t total = 0;
+	for (unsigned i = 0; i < RPMA_LAT_BUCKETS; i++) {
+		uint64_t count = RPMA_STATS_GET(src->buckets[i]);
+		if (count == 0)
+			continue;
+
+		RPMA_STATS_ADD(dst->buckets[i], count);
+		total += count;
+	}
+
+	/* the total is summed up from the buckets so it matches them */
+	RPMA_STATS_ADD(dst->total, total);
+
+	return 0;
+}
+
+/*
+ * rpma_lat_hist_get_count -- get the number of recorded values
+ */
+int
+rpma_lat_hist_get_count(const struct rpma_lat_hist *hist, uint64_t *count)
+{
+	RPMA_DEBUG_TRACE;
+	RPMA_FAULT_INJECTION(RPMA_E_INVAL, {});
+
+	if (hist == NULL || count == NULL)
+		return RPMA_E_INVAL;
+
+	*count = RPMA_STATS_GET(hist->total);
+
+	return 0;
+}
+
+/*
+ * rpma_lat_hist_get_percentile -- get the latency below or at which
+ * the given percentage of the recorded values are
+ */
+int
+rpma_lat_hist_get_percentile(const struct rpma_lat_hist *hist,
+		double percentile, uint64_t *latency_ns)
+{
+	RPMA_DEBUG_TRACE;
+	RPMA_FAULT_INJECTION(RPMA_E_INVAL, {});
+
+	if (hist == NULL || latency_ns == NULL ||
+			!(percentile > 0.0 && percentile <= 100.0))
+		return RPMA_E_INVAL;
+
+	uint64_t total = RPMA_STATS_GET(hist->total);
+	if (total == 0) {
+		*latency_ns = 0;
+		return 0;
+	}
+
+	/* the rank of the value in the sorted set of the recorded values */
+	uint64_t rank = (uint64_t)(percentile / 100.0 * (double)total + 0.5);
+	if (rank == 0)
+		rank = 1;
+
+	uint64_t seen = 0;
+	unsigned i;
+	for (i = 0; i < RPMA_LAT_BUCKETS - 1; i++) {
+		seen += RPMA_STATS_GET(hist->buckets[i]);
+		if (seen >= rank)
+			break;
+	}
+
+	*latency_ns = rpma_lat_hist_highest(i);
+
+	return 0;
+}
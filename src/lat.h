@@ -0,0 +1,82 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * lat.h -- librpma per-operation latency tracking (internal definitions)
+ */
+
+#ifndef LIBRPMA_LAT_H
+#define LIBRPMA_LAT_H
+
+#include <infiniband/verbs.h>
+
+#include "librpma.h"
+
+struct rpma_lat;
+
+/*
+ * ASSUMPTIONS
+ * - lat_ptr != NULL
+ *
+ * ERRORS
+ * rpma_lat_new() can fail with the following error:
+ *
+ * - RPMA_E_NOMEM - out of memory
+ */
+int rpma_lat_new(struct rpma_lat **lat_ptr);
+
+/*
+ * ASSUMPTIONS
+ * - lat_ptr != NULL
+ *
+ * The function cannot fail.
+ */
+void rpma_lat_delete(struct rpma_lat **lat_ptr);
+
+/*
+ * rpma_lat_post -- remember the start time of the operation identified by
+ * wr_id; it has to be called before the operation is posted since
+ * the completion may be collected before the posting function returns.
+ * It returns the slot number which has to be passed to rpma_lat_cancel()
+ * if posting the operation fails or -1 if the operation will not be
+ * accounted because there is no free slot near its home slot or another
+ * pending operation has the same wr_id.
+ *
+ * ASSUMPTIONS
+ * - lat != NULL
+ *
+ * The function cannot fail.
+ */
+int rpma_lat_post(struct rpma_lat *lat, enum rpma_lat_op op, uint64_t wr_id);
+
+/*
+ * ASSUMPTIONS
+ * - lat != NULL
+ *
+ * The function cannot fail.
+ */
+void rpma_lat_cancel(struct rpma_lat *lat, int slot);
+
+/*
+ * rpma_lat_complete -- match the collected completions with the posted
+ * operations and record the latencies of the successful ones
+ *
+ * ASSUMPTIONS
+ * - lat != NULL && wc != NULL
+ *
+ * The function cannot fail.
+ */
+void rpma_lat_complete(struct rpma_lat *lat, const struct ibv_wc *wc,
+		int num_entries);
+
+/*
+ * ASSUMPTIONS
+ * - lat != NULL && op < RPMA_LAT_OP_MAX
+ *
+ * ERRORS
+ * rpma_lat_get_hist() cannot fail.
+ */
+const struct rpma_lat_hist *rpma_lat_get_hist(const struct rpma_lat *lat,
+		enum rpma_lat_op op);
+
+#endif /* LIBRPMA_LAT_H */
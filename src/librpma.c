@@ -6,6 +6,7 @@
  */
 
 #include "librpma.h"
+#include "log_async.h"
 #include "log_internal.h"
 
 /*
@@ -35,5 +36,6 @@ __attribute__((destructor)) static void
 #endif
 librpma_fini(void)
 {
+	rpma_log_async_fini();
 	rpma_log_fini();
 }
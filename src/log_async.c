@@ -0,0 +1,399 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * log_async.c -- the asynchronous logging backend
+ *
+ * The messages are formatted on the calling thread and pushed into
+ * a single-producer single-consumer ring owned by this thread. The rings of
+ * all the threads are drained by a background thread which writes
+ * the messages out using the output stage of the default logging function,
+ * so neither syslog(3) nor writing to stderr(3) is done on the calling
+ * thread.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include "common.h"
+#include "log_async.h"
+#include "log_default.h"
+#include "log_internal.h"
+
+/* the number of messages a single thread can have pending */
+#define RPMA_LOG_ASYNC_SLOTS		128
+#define RPMA_LOG_ASYNC_SLOTS_MASK	(RPMA_LOG_ASYNC_SLOTS - 1)
+/* the maximum length of a message (longer ones are truncated) */
+#define RPMA_LOG_ASYNC_MSG_MAX		256
+/* how long the drainer sleeps when there is nothing to write out */
+#define RPMA_LOG_ASYNC_IDLE_NS		1000000 /* 1 ms */
+
+struct rpma_log_async_record {
+	struct timespec time;
+	const char *file_name; /* __FILE__ - a string literal */
+	const char *function_name; /* __func__ - a static string */
+	int line_no;
+	enum rpma_log_level level;
+	long tid; /* thread ID of the producer */
+	char message[RPMA_LOG_ASYNC_MSG_MAX];
+};
+
+struct rpma_log_async_ring {
+	struct rpma_log_async_ring *next; /* the list of all the rings */
+	long tid; /* thread ID of the owner (used only by the owner) */
+	bool owned; /* the ring is owned by a live thread */
+
+	/* written only by the owner (the producer) */
+	uint64_t head __attribute__((aligned(64)));
+	/* written only by the drainer (the consumer) */
+	uint64_t tail __attribute__((aligned(64)));
+
+	struct rpma_log_async_record records[RPMA_LOG_ASYNC_SLOTS];
+};
+
+/* the list of the rings of all the threads which have ever logged */
+static struct rpma_log_async_ring *Rings;
+
+/* the ring of the calling thread */
+static __thread struct rpma_log_async_ring *Ring;
+
+/* releases the ring of an exiting thread */
+static pthread_key_t Ring_key;
+static pthread_once_t Ring_key_once = PTHREAD_ONCE_INIT;
+static bool Ring_key_created;
+
+/* the number of the messages dropped because of the full ring */
+static uint64_t Dropped;
+
+static pthread_t Drainer;
+static bool Running; /* the drainer is running */
+static bool Stopping; /* the drainer has to drain and exit */
+
+/*
+ * The producers which have loaded rpma_log_async_function() before
+ * rpma_log_async_stop() switched back to the synchronous mode are
+ * counted so the drainer is not stopped before they are done.
+ */
+static uint64_t Producers;
+static bool Quiescing = true; /* the new messages are written synchronously */
+
+/*
+ * rpma_log_async_ring_release -- mark the ring of the exiting thread as free
+ * so it can be taken over by another thread
+ */
+static void
+rpma_log_async_ring_release(void *arg)
+{
+	struct rpma_log_async_ring *ring = arg;
+
+	__atomic_store_n(&ring->owned, false, __ATOMIC_RELEASE);
+}
+
+/*
+ * rpma_log_async_key_create -- create the key releasing the rings
+ */
+static void
+rpma_log_async_key_create(void)
+{
+	Ring_key_created = (pthread_key_create(&Ring_key,
+			rpma_log_async_ring_release) == 0);
+}
+
+/*
+ * rpma_log_async_ring_get -- get the ring of the calling thread; take over
+ * a ring released by an exited thread or allocate a new one if needed
+ */
+static struct rpma_log_async_ring *
+rpma_log_async_ring_get(void)
+{
+	if (likely(Ring != NULL))
+		return Ring;
+
+	struct rpma_log_async_ring *ring;
+	for (ring = __atomic_load_n(&Rings, __ATOMIC_ACQUIRE); ring != NULL;
+			ring = ring->next) {
+		bool expected = false;
+		if (__atomic_compare_exchange_n(&ring->owned, &expected, true,
+				false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+			break;
+	}
+
+	if (ring == NULL) {
+		ring = malloc(sizeof(*ring));
+		if (ring == NULL)
+			return NULL;
+
+		ring->owned = true;
+		ring->head = 0;
+		ring->tail = 0;
+		ring->next = __atomic_load_n(&Rings, __ATOMIC_RELAXED);
+		while (!__atomic_compare_exchange_n(&Rings, &ring->next, ring,
+				false, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+			;
+	}
+
+	ring->tid = syscall(SYS_gettid);
+	if (Ring_key_created)
+		(void) pthread_setspecific(Ring_key, ring);
+	Ring = ring;
+
+	return ring;
+}
+
+/*
+ * rpma_log_async_drain -- write out all the pending messages;
+ * returns the number of the written messages
+ */
+static uint64_t
+rpma_log_async_drain(void)
+{
+	uint64_t written = 0;
+
+	for (struct rpma_log_async_ring *ring =
+			__atomic_load_n(&Rings, __ATOMIC_ACQUIRE);
+			ring != NULL; ring = ring->next) {
+		uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+		uint64_t tail = ring->tail;
+
+		for (; tail != head; tail++) {
+			struct rpma_log_async_record *rec =
+				&ring->records[tail & RPMA_LOG_ASYNC_SLOTS_MASK];
+			rpma_log_default_output(rec->level, &rec->time,
+				rec->tid, rec->file_name, rec->line_no,
+				rec->function_name, rec->message);
+			written++;
+		}
+
+		/* release the slots to the producer */
+		__atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+	}
+
+	uint64_t dropped = __atomic_exchange_n(&Dropped, 0, __ATOMIC_RELAXED);
+	if (unlikely(dropped)) {
+		char message[64];
+		(void) snprintf(message, sizeof(message),
+			"%" PRIu64 " log message(s) dropped\n", dropped);
+		rpma_log_default_output(RPMA_LOG_LEVEL_WARNING, NULL, 0,
+			NULL, 0, NULL, message);
+	}
+
+	return written;
+}
+
+/*
+ * rpma_log_async_drainer -- the background thread writing out the messages
+ */
+static void *
+rpma_log_async_drainer(void *arg)
+{
+	const struct timespec idle = {0, RPMA_LOG_ASYNC_IDLE_NS};
+
+	while (!__atomic_load_n(&Stopping, __ATOMIC_ACQUIRE)) {
+		if (rpma_log_async_drain() == 0)
+			(void) nanosleep(&idle, NULL);
+	}
+
+	/* write out everything what was logged before stopping */
+	(void) rpma_log_async_drain();
+
+	return NULL;
+}
+
+/*
+ * rpma_log_async_push -- push the formatted message into the ring
+ * of the calling thread or write it out synchronously if it has to
+ */
+static void
+rpma_log_async_push(enum rpma_log_level level, const char *file_name,
+	const int line_no, const char *function_name,
+	const char *message_format, va_list arg)
+{
+	/*
+	 * A fatal message has to get out even if the process is about to
+	 * crash and so does every message if there is no memory for the ring
+	 * or the drainer is not running.
+	 */
+	struct rpma_log_async_ring *ring = NULL;
+	bool sync = (level == RPMA_LOG_LEVEL_FATAL ||
+			__atomic_load_n(&Quiescing, __ATOMIC_SEQ_CST));
+	if (likely(!sync)) {
+		ring = rpma_log_async_ring_get();
+		sync = (ring == NULL);
+	}
+
+	char message[RPMA_LOG_ASYNC_MSG_MAX];
+	struct rpma_log_async_record *rec = NULL;
+	uint64_t head = 0;
+	if (likely(!sync)) {
+		head = ring->head;
+		if (unlikely(head - __atomic_load_n(&ring->tail,
+				__ATOMIC_ACQUIRE) >= RPMA_LOG_ASYNC_SLOTS)) {
+			/* the ring is full - the message is lost */
+			__atomic_fetch_add(&Dropped, 1, __ATOMIC_RELAXED);
+			return;
+		}
+		rec = &ring->records[head & RPMA_LOG_ASYNC_SLOTS_MASK];
+	}
+
+	int ret = vsnprintf(sync ? message : rec->message,
+			RPMA_LOG_ASYNC_MSG_MAX, message_format, arg);
+	if (ret < 0)
+		return;
+
+	if (unlikely(sync)) {
+		rpma_log_default_output(level, NULL, 0, file_name, line_no,
+				function_name, message);
+		return;
+	}
+
+	/* the vDSO clock does not enter the kernel */
+	(void) clock_gettime(CLOCK_REALTIME, &rec->time);
+	rec->file_name = file_name;
+	rec->function_name = function_name;
+	rec->line_no = line_no;
+	rec->level = level;
+	rec->tid = ring->tid;
+
+	/* publish the record to the drainer */
+	__atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+/* internal librpma API */
+
+/*
+ * rpma_log_async_function -- the logging function pushing the formatted
+ * message into the ring of the calling thread
+ */
+void
+rpma_log_async_function(enum rpma_log_level level, const char *file_name,
+	const int line_no, const char *function_name,
+	const char *message_format, ...)
+{
+	if (RPMA_LOG_DISABLED == level)
+		return;
+
+	__atomic_fetch_add(&Producers, 1, __ATOMIC_SEQ_CST);
+
+	va_list arg;
+	va_start(arg, message_format);
+	rpma_log_async_push(level, file_name, line_no, function_name,
+			message_format, arg);
+	va_end(arg);
+
+	__atomic_fetch_sub(&Producers, 1, __ATOMIC_RELEASE);
+}
+
+/*
+ * rpma_log_async_fini -- stop the drainer and free all the rings
+ * which are not owned by other threads
+ */
+void
+rpma_log_async_fini(void)
+{
+	/* the drainer writes out all the pending messages before it exits */
+	(void) rpma_log_async_stop();
+
+	/* no destructor can be called after the library is unloaded */
+	if (Ring_key_created) {
+		(void) pthread_key_delete(Ring_key);
+		Ring_key_created = false;
+	}
+
+	/*
+	 * The rings of the other live threads are still pointed to by their
+	 * thread-local variables so they are left orphaned instead of freed.
+	 */
+	struct rpma_log_async_ring *ring = Rings;
+	Rings = NULL;
+	while (ring) {
+		struct rpma_log_async_ring *next = ring->next;
+		bool expected = false;
+		if (ring != Ring && __atomic_compare_exchange_n(&ring->owned,
+				&expected, true, false, __ATOMIC_ACQUIRE,
+				__ATOMIC_RELAXED))
+			free(ring);
+		ring = next;
+	}
+
+	/* the ring of the calling thread even if it has been orphaned */
+	free(Ring);
+	Ring = NULL;
+}
+
+/* public librpma log API */
+
+/*
+ * rpma_log_async_start -- start the background thread and switch
+ * the default logging to the asynchronous mode
+ */
+int
+rpma_log_async_start(void)
+{
+	if (Running)
+		return 0;
+
+	(void) pthread_once(&Ring_key_once, rpma_log_async_key_create);
+
+	__atomic_store_n(&Stopping, false, __ATOMIC_RELAXED);
+	int ret = pthread_create(&Drainer, NULL, rpma_log_async_drainer, NULL);
+	if (ret) {
+		RPMA_LOG_ERROR_WITH_ERRNO(ret, "pthread_create()");
+		return RPMA_E_AGAIN;
+	}
+	Running = true;
+
+	/* the drainer is running so the messages can be pushed again */
+	__atomic_store_n(&Quiescing, false, __ATOMIC_SEQ_CST);
+
+	rpma_log_function *old = Rpma_log_function;
+	if (old != rpma_log_default_function ||
+			!__sync_bool_compare_and_swap(&Rpma_log_function,
+				old, rpma_log_async_function)) {
+		/* a user-defined function is set or it is being changed */
+		(void) rpma_log_async_stop();
+		return RPMA_E_AGAIN;
+	}
+
+	return 0;
+}
+
+/*
+ * rpma_log_async_stop -- write out all the pending messages, stop
+ * the background thread and switch back to the synchronous mode
+ */
+int
+rpma_log_async_stop(void)
+{
+	if (!Running)
+		return 0;
+
+	/* the new messages are written synchronously from now on */
+	(void) __sync_bool_compare_and_swap(&Rpma_log_function,
+			rpma_log_async_function, rpma_log_default_function);
+
+	/*
+	 * Wait for the producers which could have missed the switch.
+	 * The ones which are even later write synchronously until
+	 * rpma_log_async_start() is called again.
+	 */
+	__atomic_store_n(&Quiescing, true, __ATOMIC_SEQ_CST);
+	while (__atomic_load_n(&Producers, __ATOMIC_SEQ_CST))
+		(void) sched_yield();
+
+	__atomic_store_n(&Stopping, true, __ATOMIC_RELEASE);
+	(void) pthread_join(Drainer, NULL);
+	Running = false;
+
+	return 0;
+}
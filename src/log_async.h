@@ -0,0 +1,30 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * log_async.h -- the asynchronous logging backend (internal definitions)
+ */
+
+#ifndef LIBRPMA_LOG_ASYNC_H
+#define LIBRPMA_LOG_ASYNC_H
+
+#include "librpma.h"
+
+/*
+ * rpma_log_async_function -- the logging function used when the asynchronous
+ * mode is started; see rpma_log_async_start(3)
+ */
+void rpma_log_async_function(enum rpma_log_level level, const char *file_name,
+	const int line_no, const char *function_name,
+	const char *message_format, ...);
+
+/*
+ * rpma_log_async_fini -- stop the asynchronous mode if it is started,
+ * write out the pending messages and free all its resources except
+ * the rings of the other threads which are still alive
+ *
+ * The function cannot fail.
+ */
+void rpma_log_async_fini(void);
+
+#endif /* LIBRPMA_LOG_ASYNC_H */
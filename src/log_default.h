@@ -8,12 +8,18 @@
 #ifndef LIBRPMA_LOG_DEFAULT_H
 #define LIBRPMA_LOG_DEFAULT_H
 
+#include <time.h>
+
 #include "librpma.h"
 
 void rpma_log_default_function(enum rpma_log_level level, const char *file_name,
 	const int line_no, const char *function_name,
 	const char *message_format, ...);
 
+void rpma_log_default_output(enum rpma_log_level level,
+	const struct timespec *time, long tid, const char *file_name,
+	const int line_no, const char *function_name, const char *message);
+
 void rpma_log_default_init(void);
 
 void rpma_log_default_fini(void);
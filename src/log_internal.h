@@ -11,8 +11,19 @@
 #include <stdlib.h>
 #include <string.h>
 #include "librpma.h"
+#include "common.h"
 #include "log_default.h"
 
+/*
+ * The least severe level compiled into the library (set by the CMake
+ * RPMA_LOG_MIN_LEVEL variable). The messages of the less severe levels are
+ * compiled out entirely, together with evaluation of their arguments,
+ * so they cost nothing even if rpma_log_set_threshold(3) enables them.
+ */
+#ifndef RPMA_LOG_MIN_LEVEL
+#define RPMA_LOG_MIN_LEVEL RPMA_LOG_LEVEL_DEBUG
+#endif
+
 /* pointer to the logging function */
 extern rpma_log_function *Rpma_log_function;
 
@@ -23,10 +34,16 @@ void rpma_log_init();
 
 void rpma_log_fini();
 
+/*
+ * 'level' is always a constant so the first condition is resolved
+ * at compile time and the whole block is dropped if it is false.
+ */
 #define RPMA_LOG(level, format, ...) \
 	do { \
-		if (level <= Rpma_log_threshold[RPMA_LOG_THRESHOLD] && \
-				NULL != Rpma_log_function) { \
+		if ((level) <= RPMA_LOG_MIN_LEVEL && \
+				unlikely((level) <= \
+				Rpma_log_threshold[RPMA_LOG_THRESHOLD] && \
+				NULL != Rpma_log_function)) { \
 			Rpma_log_function(level, __FILE__, __LINE__, __func__, \
 					format, ##__VA_ARGS__); \
 		} \
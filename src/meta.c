@@ -0,0 +1,310 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * meta.c -- librpma extended metadata exchange implementation
+ *
+ * The metadata is encoded as follows (all fields are little-endian):
+ *
+ * - uint32_t magic (RPMA_META_MAGIC)
+ * - uint16_t version (RPMA_META_VERSION)
+ * - uint16_t number of memory region descriptors
+ * - uint16_t size of a memory region descriptor
+ * - uint16_t size of the peer configuration descriptor (0 if none)
+ * - the peer configuration descriptor
+ * - the memory region descriptors (a table of descriptors, see
+ *   rpma_mr_get_descriptors())
+ */
+
+#include <endian.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "librpma.h"
+#include "debug.h"
+#include "log_internal.h"
+
+#ifdef TEST_MOCK_ALLOC
+#include "cmocka_alloc.h"
+#endif
+
+#define RPMA_META_MAGIC		0x4154454dU /* "META" */
+#define RPMA_META_VERSION	1
+#define RPMA_META_HDR_SIZE	(sizeof(uint32_t) + 4 * sizeof(uint16_t))
+
+struct rpma_meta {
+	void *buf; /* the encoded metadata */
+	struct rpma_mr_local *mr; /* the registered buffer */
+};
+
+/*
+ * rpma_meta_put16 -- store a 16-bit value as little-endian (helper function)
+ */
+static inline char *
+rpma_meta_put16(char *buff, uint16_t value)
+{
+	uint16_t le = htole16(value);
+	memcpy(buff, &le, sizeof(uint16_t));
+
+	return buff + sizeof(uint16_t);
+}
+
+/*
+ * rpma_meta_get16 -- load a little-endian 16-bit value (helper function)
+ */
+static inline const char *
+rpma_meta_get16(const char *buff, uint16_t *value)
+{
+	uint16_t le;
+	memcpy(&le, buff, sizeof(uint16_t));
+	*value = le16toh(le);
+
+	return buff + sizeof(uint16_t);
+}
+
+/* public librpma API */
+
+/*
+ * rpma_meta_new -- encode the descriptors of the memory regions and
+ * of the peer configuration into a buffer and register it for RDMA reads
+ */
+int
+rpma_meta_new(struct rpma_peer *peer, struct rpma_mr_local *const mrs[],
+		int mrs_num, const struct rpma_peer_cfg *pcfg,
+		struct rpma_meta **meta_ptr)
+{
+	RPMA_DEBUG_TRACE;
+	RPMA_FAULT_INJECTION(RPMA_E_INVAL, {});
+
+	if (peer == NULL || meta_ptr == NULL || mrs_num < 0 ||
+			mrs_num > UINT16_MAX || (mrs_num > 0 && mrs == NULL) ||
+			(mrs_num == 0 && pcfg == NULL))
+		return RPMA_E_INVAL;
+
+	size_t mr_desc_size = 0;
+	size_t pcfg_desc_size = 0;
+	int ret;
+
+	for (int i = 0; i < mrs_num; ++i) {
+		if (mrs[i] == NULL)
+			return RPMA_E_INVAL;
+	}
+
+	if (mrs_num > 0) {
+		ret = rpma_mr_get_descriptor_size(mrs[0], &mr_desc_size);
+		if (ret)
+			return ret;
+	}
+
+	if (pcfg) {
+		ret = rpma_peer_cfg_get_descriptor_size(pcfg, &pcfg_desc_size);
+		if (ret)
+			return ret;
+	}
+
+	size_t size = RPMA_META_HDR_SIZE + pcfg_desc_size +
+			(size_t)mrs_num * mr_desc_size;
+
+	struct rpma_meta *meta = malloc(sizeof(*meta));
+	if (meta == NULL)
+		return RPMA_E_NOMEM;
+
+	char *buff = malloc(size);
+	if (buff == NULL) {
+		ret = RPMA_E_NOMEM;
+		goto err_free_meta;
+	}
+
+	/* encode the header */
+	uint32_t magic = htole32(RPMA_META_MAGIC);
+	memcpy(buff, &magic, sizeof(uint32_t));
+	char *pos = buff + sizeof(uint32_t);
+	pos = rpma_meta_put16(pos, RPMA_META_VERSION);
+	pos = rpma_meta_put16(pos, (uint16_t)mrs_num);
+	pos = rpma_meta_put16(pos, (uint16_t)mr_desc_size);
+	pos = rpma_meta_put16(pos, (uint16_t)pcfg_desc_size);
+
+	/* encode the descriptors */
+	if (pcfg) {
+		ret = rpma_peer_cfg_get_descriptor(pcfg, pos);
+		if (ret)
+			goto err_free_buff;
+		pos += pcfg_desc_size;
+	}
+
+	if (mrs_num > 0) {
+		ret = rpma_mr_get_descriptors(mrs, mrs_num, pos);
+		if (ret)
+			goto err_free_buff;
+	}
+
+	ret = rpma_mr_reg(peer, buff, size, RPMA_MR_USAGE_READ_SRC, &meta->mr);
+	if (ret)
+		goto err_free_buff;
+
+	meta->buf = buff;
+	*meta_ptr = meta;
+
+	RPMA_LOG_INFO("new rpma_meta(mrs_num=%i, pcfg=%s, size=%zu)",
+			mrs_num, pcfg ? "yes" : "no", size);
+
+	return 0;
+
+err_free_buff:
+	free(buff);
+
+err_free_meta:
+	free(meta);
+
+	return ret;
+}
+
+/*
+ * rpma_meta_delete -- deregister and free the metadata buffer
+ */
+int
+rpma_meta_delete(struct rpma_meta **meta_ptr)
+{
+	RPMA_DEBUG_TRACE;
+
+	if (meta_ptr == NULL)
+		return RPMA_E_INVAL;
+
+	struct rpma_meta *meta = *meta_ptr;
+	if (meta == NULL)
+		return 0;
+
+	int ret = rpma_mr_dereg(&meta->mr);
+
+	free(meta->buf);
+	free(meta);
+	*meta_ptr = NULL;
+
+	RPMA_FAULT_INJECTION(RPMA_E_PROVIDER, {});
+	return ret;
+}
+
+/*
+ * rpma_meta_get_descriptor_size -- get size of the metadata descriptor
+ */
+int
+rpma_meta_get_descriptor_size(const struct rpma_meta *meta,
+		size_t *desc_size)
+{
+	RPMA_DEBUG_TRACE;
+	RPMA_FAULT_INJECTION(RPMA_E_INVAL, {});
+
+	if (meta == NULL || desc_size == NULL)
+		return RPMA_E_INVAL;
+
+	return rpma_mr_get_descriptor_size(meta->mr, desc_size);
+}
+
+/*
+ * rpma_meta_get_descriptor -- get the descriptor of the metadata, which is
+ * the descriptor of the registered metadata buffer
+ */
+int
+rpma_meta_get_descriptor(const struct rpma_meta *meta, void *desc)
+{
+	RPMA_DEBUG_TRACE;
+	RPMA_FAULT_INJECTION(RPMA_E_INVAL, {});
+
+	if (meta == NULL || desc == NULL)
+		return RPMA_E_INVAL;
+
+	return rpma_mr_get_descriptor(meta->mr, desc);
+}
+
+/*
+ * rpma_meta_decode -- decode the metadata read from the remote side into
+ * the remote memory regions and the peer configuration
+ */
+int
+rpma_meta_decode(const void *buf, size_t size, struct rpma_mr_remote *mrs[],
+		int *mrs_num, struct rpma_peer_cfg **pcfg_ptr)
+{
+	RPMA_DEBUG_TRACE;
+	RPMA_FAULT_INJECTION(RPMA_E_INVAL, {});
+
+	if (buf == NULL || mrs_num == NULL)
+		return RPMA_E_INVAL;
+
+	if (size < RPMA_META_HDR_SIZE) {
+		RPMA_LOG_ERROR(
+			"incorrect size of the metadata: %zu bytes (should be at least: %zu bytes)",
+			size, RPMA_META_HDR_SIZE);
+		return RPMA_E_INVAL;
+	}
+
+	/* decode the header */
+	uint32_t magic;
+	uint16_t version, num, mr_desc_size, pcfg_desc_size;
+	memcpy(&magic, buf, sizeof(uint32_t));
+	const char *pos = (const char *)buf + sizeof(uint32_t);
+	pos = rpma_meta_get16(pos, &version);
+	pos = rpma_meta_get16(pos, &num);
+	pos = rpma_meta_get16(pos, &mr_desc_size);
+	pos = rpma_meta_get16(pos, &pcfg_desc_size);
+
+	if (le32toh(magic) != RPMA_META_MAGIC || version != RPMA_META_VERSION) {
+		RPMA_LOG_ERROR("not a metadata of a supported version (%u)",
+				version);
+		return RPMA_E_INVAL;
+	}
+
+	if (size < RPMA_META_HDR_SIZE + pcfg_desc_size +
+			(size_t)num * mr_desc_size) {
+		RPMA_LOG_ERROR(
+			"incorrect size of the metadata: %zu bytes (should be at least: %zu bytes)",
+			size, RPMA_META_HDR_SIZE + pcfg_desc_size +
+			(size_t)num * mr_desc_size);
+		return RPMA_E_INVAL;
+	}
+
+	/* only the number of the memory regions is queried */
+	if (mrs == NULL) {
+		*mrs_num = num;
+		return 0;
+	}
+
+	if (*mrs_num < num) {
+		RPMA_LOG_ERROR(
+			"too small array of the remote memory regions: %i (the metadata has: %u)",
+			*mrs_num, num);
+		return RPMA_E_INVAL;
+	}
+
+	struct rpma_peer_cfg *pcfg = NULL;
+	int ret;
+	if (pcfg_ptr && pcfg_desc_size) {
+		ret = rpma_peer_cfg_from_descriptor(pos, pcfg_desc_size, &pcfg);
+		if (ret)
+			return ret;
+	}
+	pos += pcfg_desc_size;
+
+	int i;
+	for (i = 0; i < num; ++i) {
+		ret = rpma_mr_remote_from_descriptor(pos, mr_desc_size,
+				&mrs[i]);
+		if (ret)
+			goto err_remote_delete_all;
+		pos += mr_desc_size;
+	}
+
+	*mrs_num = num;
+	if (pcfg_ptr)
+		*pcfg_ptr = pcfg;
+
+	return 0;
+
+err_remote_delete_all:
+	while (i--)
+		(void) rpma_mr_remote_delete(&mrs[i]);
+	if (pcfg)
+		(void) rpma_peer_cfg_delete(&pcfg);
+
+	return ret;
+}
@@ -8,9 +8,11 @@
 
 #include <endian.h>
 #include <inttypes.h>
+#include <limits.h>
 #include <stdlib.h>
 
 #include "librpma.h"
+#include "common.h"
 #include "debug.h"
 #include "log_internal.h"
 #include "mr.h"
@@ -26,26 +28,26 @@
 #define SIZEOF_IN_BITS(type)	(8 * sizeof(type))
 #define MAX_VALUE_OF(type)	((1 << SIZEOF_IN_BITS(type)) - 1)
 
-#define RPMA_MR_DESC_SIZE (2 * sizeof(uint64_t) + sizeof(uint32_t) \
-			+ sizeof(uint8_t))
-
-/* a bit-wise OR of all allowed values */
-#define USAGE_ALL_ALLOWED (RPMA_MR_USAGE_READ_SRC | RPMA_MR_USAGE_READ_DST |\
+/* a bit-wise OR of all allowed values passed in the descriptor */
+#define USAGE_DESC_ALLOWED (RPMA_MR_USAGE_READ_SRC | RPMA_MR_USAGE_READ_DST |\
 		RPMA_MR_USAGE_WRITE_SRC | RPMA_MR_USAGE_WRITE_DST |\
 		RPMA_MR_USAGE_SEND | RPMA_MR_USAGE_RECV |\
 		RPMA_MR_USAGE_FLUSH_TYPE_VISIBILITY |\
 		RPMA_MR_USAGE_FLUSH_TYPE_PERSISTENT)
 
+/*
+ * a bit-wise OR of all allowed values
+ * (RPMA_MR_USAGE_MW_BIND concerns only the local memory region)
+ */
+#define USAGE_ALL_ALLOWED (USAGE_DESC_ALLOWED | RPMA_MR_USAGE_MW_BIND)
+
 /*
  * Make sure the size of the usage field in the rpma_mr_get_descriptor()
  * and rpma_mr_remote_from_descriptor() functions ('uint8_t' as for now)
- * is big enough to store all possible 'RPMA_MR_USAGE_*' values.
+ * is big enough to store all possible 'RPMA_MR_USAGE_*' values passed
+ * in the descriptor.
  */
-STATIC_ASSERT(USAGE_ALL_ALLOWED <= MAX_VALUE_OF(uint8_t), usage_too_small);
-
-/* generate operation completion on success */
-#define RPMA_F_COMPLETION_ON_SUCCESS \
-	(RPMA_F_COMPLETION_ALWAYS & ~RPMA_F_COMPLETION_ON_ERROR)
+STATIC_ASSERT(USAGE_DESC_ALLOWED <= MAX_VALUE_OF(uint8_t), usage_too_small);
 
 struct rpma_mr_local {
 	struct ibv_mr *ibv_mr; /* an IBV memory registration object */
@@ -57,10 +59,130 @@ struct rpma_mr_remote {
 	uint64_t size; /* the size of the memory being registered */
 	uint32_t rkey; /* remote key of the memory region */
 	int usage; /* usage of the memory region */
+	int in_array; /* a part of rpma_mr_remote_array (cannot be deleted) */
+};
+
+struct rpma_mr_remote_array {
+	int count; /* the number of the memory regions */
+	int overlap; /* any of the memory regions overlap */
+	/* the memory regions sorted by their base virtual addresses */
+	struct rpma_mr_remote **sorted;
+	struct rpma_mr_remote mrs[]; /* the memory regions in the given order */
 };
 
+/*
+ * rpma_mr_encode -- encode the memory region into the descriptor
+ */
+static inline void
+rpma_mr_encode(const struct rpma_mr_local *mr, char *buff)
+{
+	rpma_mr_encode_desc((uint64_t)mr->ibv_mr->addr,
+			(uint64_t)mr->ibv_mr->length, mr->ibv_mr->rkey,
+			mr->usage, buff);
+}
+
+/*
+ * rpma_mr_decode -- decode the descriptor into the remote memory region
+ *
+ * ERRORS
+ * rpma_mr_decode() can fail with the following error:
+ *
+ * - RPMA_E_INVAL - the usage of the memory region is not set
+ */
+static int
+rpma_mr_decode(const char *buff, struct rpma_mr_remote *mr)
+{
+	uint64_t raddr;
+	uint64_t size;
+	uint32_t rkey;
+
+	memcpy(&raddr, buff, sizeof(uint64_t));
+	buff += sizeof(uint64_t);
+
+	memcpy(&size, buff, sizeof(uint64_t));
+	buff += sizeof(uint64_t);
+
+	memcpy(&rkey, buff, sizeof(uint32_t));
+	buff += sizeof(uint32_t);
+
+	uint8_t usage = *(uint8_t *)buff;
+
+	if (usage == 0) {
+		RPMA_LOG_ERROR("usage type of memory is not set");
+		return RPMA_E_INVAL;
+	}
+
+	mr->raddr = le64toh(raddr);
+	mr->size = le64toh(size);
+	mr->rkey = le32toh(rkey);
+	mr->usage = usage;
+	mr->in_array = 0;
+
+	return 0;
+}
+
+/*
+ * rpma_mr_remote_cmp -- compare the base virtual addresses of the remote
+ * memory regions (a qsort(3) comparison function)
+ */
+static int
+rpma_mr_remote_cmp(const void *a, const void *b)
+{
+	const struct rpma_mr_remote *mr_a = *(struct rpma_mr_remote *const *)a;
+	const struct rpma_mr_remote *mr_b = *(struct rpma_mr_remote *const *)b;
+
+	if (mr_a->raddr < mr_b->raddr)
+		return -1;
+
+	return mr_a->raddr > mr_b->raddr;
+}
+
 /* internal librpma API */
 
+/*
+ * rpma_mr_encode_desc -- encode the base virtual address, the length,
+ * the remote key and the usage of a memory region into the descriptor
+ */
+void
+rpma_mr_encode_desc(uint64_t addr, uint64_t length, uint32_t rkey,
+	int usage, void *desc)
+{
+	char *buff = (char *)desc;
+
+	addr = htole64(addr);
+	memcpy(buff, &addr, sizeof(uint64_t));
+	buff += sizeof(uint64_t);
+
+	length = htole64(length);
+	memcpy(buff, &length, sizeof(uint64_t));
+	buff += sizeof(uint64_t);
+
+	rkey = htole32(rkey);
+	memcpy(buff, &rkey, sizeof(uint32_t));
+	buff += sizeof(uint32_t);
+
+	*((uint8_t *)buff) = (uint8_t)(usage & USAGE_DESC_ALLOWED);
+}
+
+/*
+ * rpma_mr_get_ibv_mr -- get the IBV memory registration object
+ * of the local memory region
+ */
+struct ibv_mr *
+rpma_mr_get_ibv_mr(const struct rpma_mr_local *mr)
+{
+	return mr->ibv_mr;
+}
+
+/*
+ * rpma_mr_get_usage -- get the usage of the local memory region
+ */
+int
+rpma_mr_get_usage(const struct rpma_mr_local *mr)
+{
+	return mr->usage;
+}
+
 /*
  * rpma_mr_read -- post an RDMA read from src to dst
  */
@@ -428,21 +550,7 @@ rpma_mr_get_descriptor(const struct rpma_mr_local *mr, void *desc)
 	if (mr == NULL || desc == NULL)
 		return RPMA_E_INVAL;
 
-	char *buff = (char *)desc;
-
-	uint64_t addr = htole64((uint64_t)mr->ibv_mr->addr);
-	memcpy(buff, &addr, sizeof(uint64_t));
-	buff += sizeof(uint64_t);
-
-	uint64_t length = htole64((uint64_t)mr->ibv_mr->length);
-	memcpy(buff, &length, sizeof(uint64_t));
-	buff += sizeof(uint64_t);
-
-	uint32_t rkey = htole32(mr->ibv_mr->rkey);
-	memcpy(buff, &rkey, sizeof(uint32_t));
-	buff += sizeof(uint32_t);
-
-	*((uint8_t *)buff) = (uint8_t)mr->usage;
+	rpma_mr_encode(mr, (char *)desc);
 
 	return 0;
 }
@@ -461,12 +569,6 @@ rpma_mr_remote_from_descriptor(const void *desc,
 	if (desc == NULL || mr_ptr == NULL)
 		return RPMA_E_INVAL;
 
-	char *buff = (char *)desc;
-
-	uint64_t raddr;
-	uint64_t size;
-	uint32_t rkey;
-
 	if (desc_size < RPMA_MR_DESC_SIZE) {
 		RPMA_LOG_ERROR(
 			"incorrect size of the descriptor: %i bytes (should be at least: %i bytes)",
@@ -474,35 +576,21 @@ rpma_mr_remote_from_descriptor(const void *desc,
 		return RPMA_E_INVAL;
 	}
 
-	memcpy(&raddr, buff, sizeof(uint64_t));
-	buff += sizeof(uint64_t);
-
-	memcpy(&size, buff, sizeof(uint64_t));
-	buff += sizeof(uint64_t);
-
-	memcpy(&rkey, buff, sizeof(uint32_t));
-	buff += sizeof(uint32_t);
-
-	uint8_t usage = *(uint8_t *)buff;
-
-	if (usage == 0) {
-		RPMA_LOG_ERROR("usage type of memory is not set");
-		return RPMA_E_INVAL;
-	}
+	struct rpma_mr_remote decoded;
+	int ret = rpma_mr_decode(desc, &decoded);
+	if (ret)
+		return ret;
 
 	struct rpma_mr_remote *mr = malloc(sizeof(struct rpma_mr_remote));
 	if (mr == NULL)
 		return RPMA_E_NOMEM;
 
-	mr->raddr = le64toh(raddr);
-	mr->size = le64toh(size);
-	mr->rkey = le32toh(rkey);
-	mr->usage = usage;
+	*mr = decoded;
 	*mr_ptr = mr;
 
 	RPMA_LOG_INFO("new rpma_mr_remote(raddr=0x%" PRIx64 ", size=%" PRIu64
 			", rkey=0x%" PRIx32 ", usage=0x%" PRIx8 ")",
-			raddr, size, rkey, usage);
+			mr->raddr, mr->size, mr->rkey, (uint8_t)mr->usage);
 
 	return 0;
 }
@@ -589,6 +677,12 @@ rpma_mr_remote_delete(struct rpma_mr_remote **mr_ptr)
 	if (*mr_ptr == NULL)
 		return 0;
 
+	if ((*mr_ptr)->in_array) {
+		RPMA_LOG_ERROR(
+			"the remote memory region is a part of an array (use rpma_mr_remote_array_delete())");
+		return RPMA_E_INVAL;
+	}
+
 	free(*mr_ptr);
 	*mr_ptr = NULL;
 
@@ -596,6 +690,199 @@ rpma_mr_remote_delete(struct rpma_mr_remote **mr_ptr)
 	return 0;
 }
 
+/*
+ * rpma_mr_get_descriptors -- get the descriptors of many memory regions
+ * (a table of descriptors)
+ */
+int
+rpma_mr_get_descriptors(struct rpma_mr_local *const mrs[], int mrs_num,
+		void *desc)
+{
+	RPMA_DEBUG_TRACE;
+	RPMA_FAULT_INJECTION(RPMA_E_INVAL, {});
+
+	if (mrs == NULL || mrs_num <= 0 || desc == NULL)
+		return RPMA_E_INVAL;
+
+	for (int i = 0; i < mrs_num; ++i) {
+		if (mrs[i] == NULL)
+			return RPMA_E_INVAL;
+	}
+
+	char *buff = (char *)desc;
+	for (int i = 0; i < mrs_num; ++i) {
+		rpma_mr_encode(mrs[i], buff);
+		buff += RPMA_MR_DESC_SIZE;
+	}
+
+	return 0;
+}
+
+/*
+ * rpma_mr_remote_array_from_descriptors -- create an array of remote memory
+ * regions from a table of descriptors using a single allocation
+ */
+int
+rpma_mr_remote_array_from_descriptors(const void *desc, size_t desc_size,
+		struct rpma_mr_remote_array **array_ptr)
+{
+	RPMA_DEBUG_TRACE;
+	RPMA_FAULT_INJECTION(RPMA_E_INVAL, {});
+
+	if (desc == NULL || array_ptr == NULL)
+		return RPMA_E_INVAL;
+
+	if (desc_size == 0 || desc_size % RPMA_MR_DESC_SIZE ||
+			desc_size / RPMA_MR_DESC_SIZE > INT_MAX) {
+		RPMA_LOG_ERROR(
+			"incorrect size of the descriptors: %zu bytes (should be a non-zero multiple of: %zu bytes)",
+			desc_size, RPMA_MR_DESC_SIZE);
+		return RPMA_E_INVAL;
+	}
+
+	int count = (int)(desc_size / RPMA_MR_DESC_SIZE);
+
+	/* the sorted pointers are placed right after the memory regions */
+	struct rpma_mr_remote_array *array = malloc(
+			sizeof(struct rpma_mr_remote_array) +
+			(size_t)count * (sizeof(struct rpma_mr_remote) +
+			sizeof(struct rpma_mr_remote *)));
+	if (array == NULL)
+		return RPMA_E_NOMEM;
+
+	array->count = count;
+	array->sorted = (struct rpma_mr_remote **)&array->mrs[count];
+
+	const char *buff = (const char *)desc;
+	for (int i = 0; i < count; ++i) {
+		int ret = rpma_mr_decode(buff, &array->mrs[i]);
+		if (ret) {
+			free(array);
+			return ret;
+		}
+		array->mrs[i].in_array = 1;
+		array->sorted[i] = &array->mrs[i];
+		buff += RPMA_MR_DESC_SIZE;
+	}
+
+	qsort(array->sorted, (size_t)count, sizeof(struct rpma_mr_remote *),
+			rpma_mr_remote_cmp);
+
+	array->overlap = 0;
+	for (int i = 1; i < count; ++i) {
+		const struct rpma_mr_remote *prev = array->sorted[i - 1];
+		if (array->sorted[i]->raddr - prev->raddr < prev->size) {
+			array->overlap = 1;
+			break;
+		}
+	}
+
+	*array_ptr = array;
+
+	RPMA_LOG_INFO("new rpma_mr_remote_array(count=%i)", count);
+
+	return 0;
+}
+
+/*
+ * rpma_mr_remote_array_delete -- delete the array of remote memory regions
+ */
+int
+rpma_mr_remote_array_delete(struct rpma_mr_remote_array **array_ptr)
+{
+	RPMA_DEBUG_TRACE;
+
+	if (array_ptr == NULL)
+		return RPMA_E_INVAL;
+
+	free(*array_ptr);
+	*array_ptr = NULL;
+
+	RPMA_FAULT_INJECTION(RPMA_E_INVAL, {});
+	return 0;
+}
+
+/*
+ * rpma_mr_remote_array_get_count -- get the number of the remote memory
+ * regions in the array
+ */
+int
+rpma_mr_remote_array_get_count(const struct rpma_mr_remote_array *array,
+		int *count)
+{
+	RPMA_DEBUG_TRACE;
+	RPMA_FAULT_INJECTION(RPMA_E_INVAL, {});
+
+	if (array == NULL || count == NULL)
+		return RPMA_E_INVAL;
+
+	*count = array->count;
+
+	return 0;
+}
+
+/*
+ * rpma_mr_remote_array_get -- get the remote memory region of the given index
+ */
+int
+rpma_mr_remote_array_get(struct rpma_mr_remote_array *array, int idx,
+		struct rpma_mr_remote **mr_ptr)
+{
+	RPMA_DEBUG_TRACE;
+	RPMA_FAULT_INJECTION(RPMA_E_INVAL, {});
+
+	if (array == NULL || mr_ptr == NULL || idx < 0 || idx >= array->count)
+		return RPMA_E_INVAL;
+
+	*mr_ptr = &array->mrs[idx];
+
+	return 0;
+}
+
+/*
+ * rpma_mr_remote_array_find -- find the remote memory region containing
+ * the given range of remote addresses (a binary search)
+ */
+int
+rpma_mr_remote_array_find(struct rpma_mr_remote_array *array, uint64_t raddr,
+		size_t len, struct rpma_mr_remote **mr_ptr, size_t *offset)
+{
+	RPMA_DEBUG_TRACE;
+	RPMA_FAULT_INJECTION(RPMA_E_INVAL, {});
+
+	if (array == NULL || mr_ptr == NULL || offset == NULL)
+		return RPMA_E_INVAL;
+
+	/* find the first memory region starting above raddr */
+	int lo = 0;
+	int hi = array->count;
+	while (lo < hi) {
+		int mid = lo + (hi - lo) / 2;
+		if (array->sorted[mid]->raddr <= raddr)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	/*
+	 * Check the memory region starting at or right below raddr. The ones
+	 * below it are checked only if any of the memory regions overlap.
+	 */
+	while (lo-- > 0) {
+		struct rpma_mr_remote *mr = array->sorted[lo];
+		uint64_t off = raddr - mr->raddr;
+		if (off < mr->size && len <= mr->size - off) {
+			*mr_ptr = mr;
+			*offset = (size_t)off;
+			return 0;
+		}
+		if (!array->overlap)
+			break;
+	}
+
+	return RPMA_E_INVAL;
+}
+
 /*
  * rpma_mr_remote_get_flush_type -- get a flush type supported
  * by the remote memory region
@@ -12,6 +12,9 @@
 
 #include <infiniband/verbs.h>
 
+#define RPMA_MR_DESC_SIZE (2 * sizeof(uint64_t) + sizeof(uint32_t) \
+			+ sizeof(uint8_t))
+
 /*
  * ASSUMPTIONS
  * - qp != NULL && flags != 0
@@ -91,4 +94,26 @@ int rpma_mr_recv(struct ibv_qp *qp,
 	struct rpma_mr_local *dst,  size_t offset,
 	size_t len, const void *op_context);
 
+/*
+ * ASSUMPTIONS
+ * - desc != NULL
+ *
+ * The usage flags which are not passed in the descriptor (e.g.
+ * RPMA_MR_USAGE_MW_BIND) are skipped.
+ */
+void rpma_mr_encode_desc(uint64_t addr, uint64_t length, uint32_t rkey,
+	int usage, void *desc);
+
+/*
+ * ASSUMPTIONS
+ * - mr != NULL
+ */
+struct ibv_mr *rpma_mr_get_ibv_mr(const struct rpma_mr_local *mr);
+
+/*
+ * ASSUMPTIONS
+ * - mr != NULL
+ */
+int rpma_mr_get_usage(const struct rpma_mr_local *mr);
+
 #endif /* LIBRPMA_MR_H */
@@ -0,0 +1,287 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * mw.c -- librpma memory window-related implementations
+ *
+ * A type 2 memory window grants the remote side an access to a sub-range of
+ * an already registered memory region. The window is bound and invalidated
+ * by the work requests posted to the send queue of a connection, so granting
+ * and revoking the access does not involve the kernel.
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdlib.h>
+
+#include "librpma.h"
+#include "common.h"
+#include "debug.h"
+#include "log_internal.h"
+#include "mr.h"
+#include "mw.h"
+#include "peer.h"
+
+#ifdef TEST_MOCK_ALLOC
+#include "cmocka_alloc.h"
+#endif
+
+/* the usage which can be granted by a memory window */
+#define MW_USAGE_ALLOWED (RPMA_MR_USAGE_READ_SRC | RPMA_MR_USAGE_WRITE_DST)
+
+/* the flush types of the memory region which the memory window inherits */
+#define MW_USAGE_FLUSH_TYPES (RPMA_MR_USAGE_FLUSH_TYPE_VISIBILITY |\
+		RPMA_MR_USAGE_FLUSH_TYPE_PERSISTENT)
+
+struct rpma_mw {
+	struct ibv_mw *ibv_mw; /* an IBV memory window object */
+	uint32_t rkey; /* the remote key of the current (or last) binding */
+	int bound; /* the memory window is bound */
+
+	/* the bound memory */
+	uint64_t raddr; /* the base virtual address */
+	uint64_t size; /* the size */
+	int usage; /* the usage granted to the remote side */
+};
+
+/* internal librpma API */
+
+/*
+ * rpma_mw_bind -- post binding the memory window to the range of
+ * the memory region
+ */
+int
+rpma_mw_bind(struct ibv_qp *qp, struct rpma_mw *mw,
+	const struct rpma_mr_local *mr, size_t offset, size_t len,
+	int usage, int flags, const void *op_context)
+{
+	RPMA_DEBUG_TRACE;
+
+	struct ibv_mr *ibv_mr = rpma_mr_get_ibv_mr(mr);
+	int mr_usage = rpma_mr_get_usage(mr);
+
+	if (mw->bound) {
+		RPMA_LOG_ERROR(
+			"the memory window is already bound (please invalidate it first)");
+		return RPMA_E_INVAL;
+	}
+
+	if (!(mr_usage & RPMA_MR_USAGE_MW_BIND)) {
+		RPMA_LOG_ERROR(
+			"the memory region is not registered with RPMA_MR_USAGE_MW_BIND");
+		return RPMA_E_INVAL;
+	}
+
+	if (usage == 0 || (usage & ~MW_USAGE_ALLOWED) || (usage & ~mr_usage)) {
+		RPMA_LOG_ERROR(
+			"usage (0x%x) is not allowed for the memory window over the memory region of usage 0x%x",
+			usage, mr_usage);
+		return RPMA_E_INVAL;
+	}
+
+	if (len == 0 || offset > ibv_mr->length ||
+			len > ibv_mr->length - offset) {
+		RPMA_LOG_ERROR(
+			"the range (offset=%zu, len=%zu) is out of the memory region bounds (size=%zu)",
+			offset, len, ibv_mr->length);
+		return RPMA_E_INVAL;
+	}
+
+	/* the flush types are inherited from the memory region */
+	usage |= mr_usage & MW_USAGE_FLUSH_TYPES;
+
+	/* APM type of flush requires the same access as RPMA_MR_USAGE_READ_SRC */
+	unsigned access = 0;
+	if (usage & (RPMA_MR_USAGE_READ_SRC | MW_USAGE_FLUSH_TYPES))
+		access |= IBV_ACCESS_REMOTE_READ;
+	if (usage & RPMA_MR_USAGE_WRITE_DST)
+		access |= IBV_ACCESS_REMOTE_WRITE;
+
+	struct ibv_send_wr wr;
+	wr.wr_id = (uint64_t)op_context;
+	wr.next = NULL;
+	wr.sg_list = NULL;
+	wr.num_sge = 0;
+	wr.opcode = IBV_WR_BIND_MW;
+	wr.send_flags = (flags & RPMA_F_COMPLETION_ON_SUCCESS) ?
+		IBV_SEND_SIGNALED : 0;
+
+	/* every binding gets a new remote key so the old ones get revoked */
+	wr.bind_mw.mw = mw->ibv_mw;
+	wr.bind_mw.rkey = ibv_inc_rkey(mw->rkey);
+	wr.bind_mw.bind_info.mr = ibv_mr;
+	wr.bind_mw.bind_info.addr = (uint64_t)((uintptr_t)ibv_mr->addr + offset);
+	wr.bind_mw.bind_info.length = (uint64_t)len;
+	wr.bind_mw.bind_info.mw_access_flags = access;
+
+	struct ibv_send_wr *bad_wr;
+	RPMA_FAULT_INJECTION(RPMA_E_PROVIDER, {});
+	int ret = ibv_post_send(qp, &wr, &bad_wr);
+	if (ret) {
+		RPMA_LOG_ERROR_WITH_ERRNO(ret,
+			"ibv_post_send(addr=0x%" PRIx64 ", length=%" PRIu64
+			", rkey=0x%" PRIx32 ", mw_access_flags=0x%x, wr_id=0x%"
+			PRIx64 ", opcode=IBV_WR_BIND_MW, send_flags=%s)",
+			wr.bind_mw.bind_info.addr, wr.bind_mw.bind_info.length,
+			wr.bind_mw.rkey, access, wr.wr_id,
+			(flags & RPMA_F_COMPLETION_ON_SUCCESS) ?
+				"IBV_SEND_SIGNALED" : "0");
+		return RPMA_E_PROVIDER;
+	}
+
+	/* the binding grants the access only once it completes successfully */
+	mw->rkey = wr.bind_mw.rkey;
+	mw->raddr = wr.bind_mw.bind_info.addr;
+	mw->size = wr.bind_mw.bind_info.length;
+	mw->usage = usage;
+	mw->bound = 1;
+
+	return 0;
+}
+
+/*
+ * rpma_mw_invalidate -- post invalidating the memory window
+ */
+int
+rpma_mw_invalidate(struct ibv_qp *qp, struct rpma_mw *mw, int flags,
+	const void *op_context)
+{
+	RPMA_DEBUG_TRACE;
+
+	if (!mw->bound) {
+		RPMA_LOG_ERROR("the memory window is not bound");
+		return RPMA_E_INVAL;
+	}
+
+	struct ibv_send_wr wr;
+	wr.wr_id = (uint64_t)op_context;
+	wr.next = NULL;
+	wr.sg_list = NULL;
+	wr.num_sge = 0;
+	wr.opcode = IBV_WR_LOCAL_INV;
+	wr.send_flags = (flags & RPMA_F_COMPLETION_ON_SUCCESS) ?
+		IBV_SEND_SIGNALED : 0;
+	wr.invalidate_rkey = mw->rkey;
+
+	struct ibv_send_wr *bad_wr;
+	RPMA_FAULT_INJECTION(RPMA_E_PROVIDER, {});
+	int ret = ibv_post_send(qp, &wr, &bad_wr);
+	if (ret) {
+		RPMA_LOG_ERROR_WITH_ERRNO(ret,
+			"ibv_post_send(invalidate_rkey=0x%" PRIx32 ", wr_id=0x%"
+			PRIx64 ", opcode=IBV_WR_LOCAL_INV, send_flags=%s)",
+			wr.invalidate_rkey, wr.wr_id,
+			(flags & RPMA_F_COMPLETION_ON_SUCCESS) ?
+				"IBV_SEND_SIGNALED" : "0");
+		return RPMA_E_PROVIDER;
+	}
+
+	mw->bound = 0;
+
+	return 0;
+}
+
+/* public librpma API */
+
+/*
+ * rpma_mw_new -- allocate a new type 2 memory window
+ */
+int
+rpma_mw_new(struct rpma_peer *peer, struct rpma_mw **mw_ptr)
+{
+	RPMA_DEBUG_TRACE;
+	RPMA_FAULT_INJECTION(RPMA_E_NOMEM, {});
+
+	if (peer == NULL || mw_ptr == NULL)
+		return RPMA_E_INVAL;
+
+	struct rpma_mw *mw = malloc(sizeof(struct rpma_mw));
+	if (mw == NULL)
+		return RPMA_E_NOMEM;
+
+	struct ibv_mw *ibv_mw;
+	int ret = rpma_peer_mw_alloc(peer, &ibv_mw);
+	if (ret) {
+		free(mw);
+		return ret;
+	}
+
+	mw->ibv_mw = ibv_mw;
+	mw->rkey = ibv_mw->rkey;
+	mw->bound = 0;
+	mw->raddr = 0;
+	mw->size = 0;
+	mw->usage = 0;
+	*mw_ptr = mw;
+
+	return 0;
+}
+
+/*
+ * rpma_mw_delete -- deallocate the memory window
+ */
+int
+rpma_mw_delete(struct rpma_mw **mw_ptr)
+{
+	RPMA_DEBUG_TRACE;
+
+	if (mw_ptr == NULL)
+		return RPMA_E_INVAL;
+
+	struct rpma_mw *mw = *mw_ptr;
+	if (mw == NULL)
+		return 0;
+
+	int ret = 0;
+	errno = ibv_dealloc_mw(mw->ibv_mw);
+	if (errno) {
+		RPMA_LOG_ERROR_WITH_ERRNO(errno, "ibv_dealloc_mw()");
+		ret = RPMA_E_PROVIDER;
+	}
+
+	free(mw);
+	*mw_ptr = NULL;
+
+	RPMA_FAULT_INJECTION(RPMA_E_PROVIDER, {});
+	return ret;
+}
+
+/*
+ * rpma_mw_get_descriptor_size -- get size of the memory window descriptor
+ */
+int
+rpma_mw_get_descriptor_size(const struct rpma_mw *mw, size_t *desc_size)
+{
+	RPMA_DEBUG_TRACE;
+	RPMA_FAULT_INJECTION(RPMA_E_INVAL, {});
+
+	if (mw == NULL || desc_size == NULL)
+		return RPMA_E_INVAL;
+
+	*desc_size = RPMA_MR_DESC_SIZE;
+
+	return 0;
+}
+
+/*
+ * rpma_mw_get_descriptor -- get the descriptor of the bound memory window
+ * (the descriptor of a remote memory region)
+ */
+int
+rpma_mw_get_descriptor(const struct rpma_mw *mw, void *desc)
+{
+	RPMA_DEBUG_TRACE;
+	RPMA_FAULT_INJECTION(RPMA_E_INVAL, {});
+
+	if (mw == NULL || desc == NULL)
+		return RPMA_E_INVAL;
+
+	if (!mw->bound) {
+		RPMA_LOG_ERROR("the memory window is not bound");
+		return RPMA_E_INVAL;
+	}
+
+	rpma_mr_encode_desc(mw->raddr, mw->size, mw->rkey, mw->usage, desc);
+
+	return 0;
+}
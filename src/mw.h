@@ -0,0 +1,46 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * mw.h -- librpma memory window-related internal definitions
+ */
+
+#ifndef LIBRPMA_MW_H
+#define LIBRPMA_MW_H
+
+#include "librpma.h"
+
+#include <infiniband/verbs.h>
+
+/*
+ * ASSUMPTIONS
+ * - qp != NULL && mw != NULL && mr != NULL && flags != 0
+ *
+ * ERRORS
+ * rpma_mw_bind() can fail with the following errors:
+ *
+ * - RPMA_E_INVAL - the memory window is already bound
+ * - RPMA_E_INVAL - mr is not registered with RPMA_MR_USAGE_MW_BIND
+ * - RPMA_E_INVAL - usage is 0, is not a subset of RPMA_MR_USAGE_READ_SRC |
+ *                  RPMA_MR_USAGE_WRITE_DST or is not allowed by mr
+ * - RPMA_E_INVAL - len == 0 or the range is out of the mr bounds
+ * - RPMA_E_PROVIDER - ibv_post_send(3) failed
+ */
+int rpma_mw_bind(struct ibv_qp *qp, struct rpma_mw *mw,
+	const struct rpma_mr_local *mr, size_t offset, size_t len,
+	int usage, int flags, const void *op_context);
+
+/*
+ * ASSUMPTIONS
+ * - qp != NULL && mw != NULL && flags != 0
+ *
+ * ERRORS
+ * rpma_mw_invalidate() can fail with the following errors:
+ *
+ * - RPMA_E_INVAL - the memory window is not bound
+ * - RPMA_E_PROVIDER - ibv_post_send(3) failed
+ */
+int rpma_mw_invalidate(struct ibv_qp *qp, struct rpma_mw *mw, int flags,
+	const void *op_context);
+
+#endif /* LIBRPMA_MW_H */
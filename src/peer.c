@@ -75,6 +75,9 @@ rpma_peer_usage_to_access(struct rpma_peer *peer, int usage)
 	if (usage & RPMA_MR_USAGE_RECV)
 		access |= IBV_ACCESS_LOCAL_WRITE;
 
+	if (usage & RPMA_MR_USAGE_MW_BIND)
+		access |= IBV_ACCESS_MW_BIND;
+
 	/*
 	 * There is no IBV_ACCESS_* value to be set for RPMA_MR_USAGE_SEND.
 	 */
@@ -214,6 +217,29 @@ rpma_peer_mr_reg(struct rpma_peer *peer, struct ibv_mr **ibv_mr_ptr,
 #endif
 }
 
+/*
+ * rpma_peer_mw_alloc -- allocate a type 2 memory window using ibv_alloc_mw()
+ */
+int
+rpma_peer_mw_alloc(struct rpma_peer *peer, struct ibv_mw **ibv_mw_ptr)
+{
+	RPMA_DEBUG_TRACE;
+	RPMA_FAULT_INJECTION(RPMA_E_PROVIDER, {});
+
+	*ibv_mw_ptr = ibv_alloc_mw(peer->pd, IBV_MW_TYPE_2);
+	if (*ibv_mw_ptr != NULL)
+		return 0;
+
+	if (errno == EOPNOTSUPP) {
+		RPMA_LOG_ERROR(
+			"memory windows are not supported by the device: ibv_alloc_mw(type=IBV_MW_TYPE_2)");
+		return RPMA_E_NOSUPP;
+	}
+
+	RPMA_LOG_ERROR_WITH_ERRNO(errno, "ibv_alloc_mw(type=IBV_MW_TYPE_2)");
+	return RPMA_E_PROVIDER;
+}
+
 /* public librpma API */
 
 /*
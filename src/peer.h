@@ -38,4 +38,16 @@ int rpma_peer_create_qp(struct rpma_peer *peer, struct rdma_cm_id *id,
 int rpma_peer_mr_reg(struct rpma_peer *peer, struct ibv_mr **ibv_mr_ptr,
 		void *addr, size_t length, int usage);
 
+/*
+ * ASSUMPTIONS
+ * - peer != NULL && ibv_mw_ptr != NULL && peer->pd != NULL
+ *
+ * ERRORS
+ * rpma_peer_mw_alloc() can fail with the following errors:
+ *
+ * - RPMA_E_NOSUPP - memory windows are not supported by the device
+ * - RPMA_E_PROVIDER - allocating the memory window failed
+ */
+int rpma_peer_mw_alloc(struct rpma_peer *peer, struct ibv_mw **ibv_mw_ptr);
+
 #endif /* LIBRPMA_PEER_H */
@@ -32,6 +32,12 @@ rpma_conn_cfg_common_prestate_init(void *prestate, struct mtt_result *tr)
 		return;
 	}
 
+	if ((ret = rpma_conn_cfg_set_comp_vector(pr->cfg_ptr,
+			RPMA_CONN_CFG_COMMON_COMP_VECTOR_EXP))) {
+		MTT_RPMA_ERR(tr, "rpma_conn_cfg_set_comp_vector", ret);
+		return;
+	}
+
 	if ((ret = rpma_conn_cfg_set_cq_size(pr->cfg_ptr, RPMA_CONN_CFG_COMMON_Q_SIZE_EXP))) {
 		MTT_RPMA_ERR(tr, "rpma_conn_cfg_set_cq_size", ret);
 		return;
@@ -18,6 +18,9 @@
 /* the expected completion channel state */
 #define RPMA_CONN_CFG_COMMON_IS_SHARED true
 
+/* the expected completion vector */
+#define RPMA_CONN_CFG_COMMON_COMP_VECTOR_EXP 1
+
 struct rpma_conn_cfg_common_prestate {
 	struct rpma_conn_cfg *cfg_ptr;
 };
@@ -0,0 +1,38 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * rpma_conn_cfg_set_comp_vector.c -- rpma_conn_cfg_set_comp_vector multithreaded test
+ */
+
+#include <stdlib.h>
+#include <librpma.h>
+
+#include "mtt.h"
+#include "rpma_conn_cfg_common.h"
+
+/*
+ * thread -- set connection completion vector and check if its value is as expected
+ */
+void
+thread(unsigned id, void *prestate, void *state, struct mtt_result *tr)
+{
+	struct rpma_conn_cfg_common_prestate *pr =
+		(struct rpma_conn_cfg_common_prestate *)prestate;
+	int ret;
+	int comp_vector = RPMA_CONN_CFG_COMMON_COMP_VECTOR_EXP;
+
+	if ((ret = rpma_conn_cfg_set_comp_vector(pr->cfg_ptr, comp_vector))) {
+		MTT_RPMA_ERR(tr, "rpma_conn_cfg_set_comp_vector", ret);
+		return;
+	}
+
+	if ((ret = rpma_conn_cfg_get_comp_vector(pr->cfg_ptr, &comp_vector))) {
+		MTT_RPMA_ERR(tr, "rpma_conn_cfg_get_comp_vector", ret);
+		return;
+	}
+
+	if (comp_vector != RPMA_CONN_CFG_COMMON_COMP_VECTOR_EXP)
+		MTT_ERR_MSG(tr, "Invalid completion vector: %d instead of %d", -1,
+			comp_vector, RPMA_CONN_CFG_COMMON_COMP_VECTOR_EXP);
+}
@@ -24,6 +24,7 @@ struct ibv_cq Ibv_rcq;
 struct ibv_cq Ibv_cq_unknown;
 struct ibv_qp Ibv_qp;
 struct ibv_mr Ibv_mr;
+struct ibv_mw Ibv_mw = {&Ibv_context};
 
 /*
  * ibv_query_device -- ibv_query_device() mock
@@ -79,7 +80,7 @@ ibv_create_cq(struct ibv_context *ibv_ctx, int cqe, void *cq_context,
 	assert_ptr_equal(ibv_ctx, MOCK_VERBS);
 	check_expected(cqe);
 	assert_ptr_equal(channel, MOCK_COMP_CHANNEL);
-	assert_int_equal(comp_vector, 0);
+	check_expected(comp_vector);
 
 	struct ibv_cq *cq = mock_type(struct ibv_cq *);
 	if (!cq) {
@@ -178,6 +179,35 @@ ibv_reg_mr(struct ibv_pd *pd, void *addr, size_t length, int access)
 	return mr;
 }
 
+/*
+ * ibv_alloc_mw_mock -- ibv_alloc_mw() mock
+ */
+struct ibv_mw *
+ibv_alloc_mw_mock(struct ibv_pd *pd, enum ibv_mw_type type)
+{
+	check_expected_ptr(pd);
+	assert_int_equal(type, IBV_MW_TYPE_2);
+
+	struct ibv_mw *mw = mock_type(struct ibv_mw *);
+	if (mw == NULL) {
+		errno = mock_type(int);
+		return NULL;
+	}
+
+	return mw;
+}
+
+/*
+ * ibv_dealloc_mw_mock -- ibv_dealloc_mw() mock
+ */
+int
+ibv_dealloc_mw_mock(struct ibv_mw *mw)
+{
+	assert_ptr_equal(mw, MOCK_IBV_MW);
+
+	return mock_type(int); /* errno */
+}
+
 /*
  * ibv_req_notify_cq_mock -- ibv_req_notify_cq() mock
  */
@@ -267,7 +297,12 @@ ibv_post_send_mock(struct ibv_qp *qp, struct ibv_send_wr *wr,
 	assert_int_equal(wr->opcode, args->opcode);
 	assert_int_equal(wr->send_flags, args->send_flags);
 	assert_int_equal(wr->wr_id, args->wr_id);
-	if (args->opcode != IBV_WR_SEND &&
+	if (args->opcode == IBV_WR_BIND_MW) {
+		assert_int_equal(wr->bind_mw.bind_info.addr, args->remote_addr);
+		assert_int_equal(wr->bind_mw.rkey, args->rkey);
+	} else if (args->opcode == IBV_WR_LOCAL_INV) {
+		assert_int_equal(wr->invalidate_rkey, args->rkey);
+	} else if (args->opcode != IBV_WR_SEND &&
 	    args->opcode != IBV_WR_SEND_WITH_IMM) {
 		assert_int_equal(wr->wr.rdma.remote_addr, args->remote_addr);
 		assert_int_equal(wr->wr.rdma.rkey, args->rkey);
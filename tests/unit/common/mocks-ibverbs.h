@@ -22,6 +22,7 @@ extern struct ibv_cq Ibv_rcq;
 extern struct ibv_cq Ibv_cq_unknown;
 extern struct ibv_qp Ibv_qp;
 extern struct ibv_mr Ibv_mr;
+extern struct ibv_mw Ibv_mw;
 
 /* random values or pointers to mocked IBV entities */
 #define MOCK_VERBS		(&Verbs_context.context)
@@ -32,6 +33,7 @@ extern struct ibv_mr Ibv_mr;
 #define MOCK_IBV_PD		(struct ibv_pd *)&Ibv_pd
 #define MOCK_QP			(struct ibv_qp *)&Ibv_qp
 #define MOCK_MR			(struct ibv_mr *)&Ibv_mr
+#define MOCK_IBV_MW		(struct ibv_mw *)&Ibv_mw
 
 struct ibv_alloc_pd_mock_args {
 	int validate_params;
@@ -73,6 +75,10 @@ int ibv_post_send_mock(struct ibv_qp *qp, struct ibv_send_wr *wr,
 int ibv_post_recv_mock(struct ibv_qp *qp, struct ibv_recv_wr *wr,
 			struct ibv_recv_wr **bad_wr);
 
+struct ibv_mw *ibv_alloc_mw_mock(struct ibv_pd *pd, enum ibv_mw_type type);
+
+int ibv_dealloc_mw_mock(struct ibv_mw *mw);
+
 int ibv_req_notify_cq_mock(struct ibv_cq *cq, int solicited_only);
 
 #ifdef IBV_ADVISE_MR_SUPPORTED
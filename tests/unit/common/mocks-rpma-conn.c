@@ -80,3 +80,15 @@ rpma_conn_transfer_private_data(struct rpma_conn *conn,
 	check_expected(pdata->ptr);
 	check_expected(pdata->len);
 }
+
+/*
+ * rpma_conn_set_setup_times -- rpma_conn_set_setup_times() mock
+ */
+void
+rpma_conn_set_setup_times(struct rpma_conn *conn,
+		const struct rpma_conn_setup_times *times,
+		uint64_t handshake_start_ns)
+{
+	assert_non_null(conn);
+	assert_non_null(times);
+}
@@ -116,3 +116,19 @@ rpma_conn_cfg_get_compl_channel(const struct rpma_conn_cfg *cfg, bool *shared)
 	*shared = args->shared;
 	return 0;
 }
+
+/*
+ * rpma_conn_cfg_get_comp_vector -- rpma_conn_cfg_get_comp_vector() mock
+ */
+int
+rpma_conn_cfg_get_comp_vector(const struct rpma_conn_cfg *cfg, int *comp_vector)
+{
+	struct conn_cfg_get_mock_args *args =
+			mock_type(struct conn_cfg_get_mock_args *);
+
+	assert_ptr_equal(cfg, args->cfg);
+	assert_non_null(comp_vector);
+
+	*comp_vector = args->comp_vector;
+	return 0;
+}
@@ -20,6 +20,7 @@
 #define MOCK_SQ_SIZE_DEFAULT	11
 #define MOCK_RQ_SIZE_DEFAULT	12
 #define MOCK_SHARED_DEFAULT	false
+#define MOCK_COMP_VECTOR_DEFAULT	0
 
 #define MOCK_TIMEOUT_MS_CUSTOM	4034
 #define MOCK_CQ_SIZE_CUSTOM	13
@@ -27,6 +28,9 @@
 #define MOCK_SQ_SIZE_CUSTOM	14
 #define MOCK_RQ_SIZE_CUSTOM	15
 #define MOCK_SHARED_CUSTOM	true
+#define MOCK_COMP_VECTOR_CUSTOM	3
+/* the number of the completion vectors of the MOCK_VERBS device */
+#define MOCK_NUM_COMP_VECTORS	4
 
 struct conn_cfg_get_mock_args {
 	struct rpma_conn_cfg *cfg;
@@ -36,6 +40,7 @@ struct conn_cfg_get_mock_args {
 	uint32_t cq_size;
 	uint32_t rcq_size;
 	bool shared;
+	int comp_vector;
 };
 
 /* current hardcoded values */
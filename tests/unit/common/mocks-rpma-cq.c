@@ -44,12 +44,13 @@ rpma_cq_wait(struct rpma_cq *cq)
  * rpma_cq_new -- rpma_cq_new() mock
  */
 int
-rpma_cq_new(struct ibv_context *ibv_ctx, int cqe,
+rpma_cq_new(struct ibv_context *ibv_ctx, int cqe, int comp_vector,
 		struct ibv_comp_channel *shared_channel,
 		struct rpma_cq **cq_ptr)
 {
 	assert_non_null(ibv_ctx);
 	check_expected(cqe);
+	check_expected(comp_vector);
 	check_expected(shared_channel);
 	assert_non_null(cq_ptr);
 
@@ -96,3 +97,13 @@ rpma_cq_get_ibv_cq(const struct rpma_cq *cq)
 
 	return mock_type(struct ibv_cq *);
 }
+
+/*
+ * rpma_cq_set_lat -- rpma_cq_set_lat() mock
+ */
+void
+rpma_cq_set_lat(struct rpma_cq *cq, struct rpma_lat *lat)
+{
+	check_expected_ptr(cq);
+	check_expected_ptr(lat);
+}
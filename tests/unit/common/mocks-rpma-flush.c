@@ -72,3 +72,28 @@ rpma_flush_delete(struct rpma_flush **flush_ptr)
 
 	return ret;
 }
+
+/*
+ * rpma_flush_get_stats -- rpma_flush_get_stats() mock
+ */
+void
+rpma_flush_get_stats(const struct rpma_flush *flush, uint64_t *ops,
+		uint64_t *bytes)
+{
+	assert_ptr_equal(flush, MOCK_FLUSH);
+	assert_non_null(ops);
+	assert_non_null(bytes);
+
+	*ops = mock_type(uint64_t);
+	*bytes = mock_type(uint64_t);
+}
+
+/*
+ * rpma_flush_reset_stats -- rpma_flush_reset_stats() mock
+ */
+void
+rpma_flush_reset_stats(struct rpma_flush *flush)
+{
+	assert_ptr_equal(flush, MOCK_FLUSH);
+	function_called();
+}
@@ -0,0 +1,101 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * mocks-rpma-lat.c -- librpma lat.c module mocks
+ */
+
+#include <librpma.h>
+
+#include "cmocka_headers.h"
+#include "lat.h"
+#include "mocks-rpma-lat.h"
+#include "test-common.h"
+
+/*
+ * rpma_lat_new -- rpma_lat_new() mock
+ */
+int
+rpma_lat_new(struct rpma_lat **lat_ptr)
+{
+	assert_non_null(lat_ptr);
+
+	struct rpma_lat *lat = mock_type(struct rpma_lat *);
+	if (lat == NULL)
+		return RPMA_E_NOMEM;
+
+	*lat_ptr = lat;
+
+	return 0;
+}
+
+/*
+ * rpma_lat_delete -- rpma_lat_delete() mock
+ */
+void
+rpma_lat_delete(struct rpma_lat **lat_ptr)
+{
+	assert_non_null(lat_ptr);
+	check_expected_ptr(*lat_ptr);
+
+	*lat_ptr = NULL;
+}
+
+/*
+ * rpma_lat_post -- rpma_lat_post() mock
+ */
+int
+rpma_lat_post(struct rpma_lat *lat, enum rpma_lat_op op, uint64_t wr_id)
+{
+	check_expected_ptr(lat);
+	check_expected(op);
+	check_expected(wr_id);
+
+	return mock_type(int);
+}
+
+/*
+ * rpma_lat_cancel -- rpma_lat_cancel() mock
+ */
+void
+rpma_lat_cancel(struct rpma_lat *lat, int slot)
+{
+	check_expected_ptr(lat);
+	check_expected(slot);
+}
+
+/*
+ * rpma_lat_complete -- rpma_lat_complete() mock
+ */
+void
+rpma_lat_complete(struct rpma_lat *lat, const struct ibv_wc *wc,
+		int num_entries)
+{
+	assert_non_null(wc);
+	check_expected_ptr(lat);
+	check_expected(num_entries);
+}
+
+/*
+ * rpma_lat_get_hist -- rpma_lat_get_hist() mock
+ */
+const struct rpma_lat_hist *
+rpma_lat_get_hist(const struct rpma_lat *lat, enum rpma_lat_op op)
+{
+	check_expected_ptr(lat);
+	check_expected(op);
+
+	return MOCK_LAT_HIST_SRC;
+}
+
+/*
+ * rpma_lat_hist_merge -- rpma_lat_hist_merge() mock
+ */
+int
+rpma_lat_hist_merge(struct rpma_lat_hist *dst, const struct rpma_lat_hist *src)
+{
+	check_expected_ptr(dst);
+	check_expected_ptr(src);
+
+	return mock_type(int);
+}
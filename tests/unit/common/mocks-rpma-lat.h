@@ -0,0 +1,16 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * mocks-rpma-lat.h -- librpma lat.c module mocks
+ */
+
+#ifndef MOCKS_RPMA_LAT_H
+#define MOCKS_RPMA_LAT_H
+
+#define MOCK_LAT		(struct rpma_lat *)0xA7A7
+#define MOCK_LAT_HIST		(struct rpma_lat_hist *)0xA7B7
+#define MOCK_LAT_HIST_SRC	(const struct rpma_lat_hist *)0xA7C7
+#define MOCK_LAT_SLOT		0x1A7
+
+#endif /* MOCKS_RPMA_LAT_H */
@@ -0,0 +1,18 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * mocks-rpma-log_async.c -- librpma log_async.c module mocks
+ */
+
+#include "cmocka_headers.h"
+#include "log_async.h"
+
+/*
+ * rpma_log_async_fini -- rpma_log_async_fini() mock
+ */
+void
+rpma_log_async_fini(void)
+{
+	function_called();
+}
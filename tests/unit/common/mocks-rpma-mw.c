@@ -0,0 +1,55 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * mocks-rpma-mw.c -- librpma mw.c module mocks
+ */
+
+#include <librpma.h>
+
+#include "cmocka_headers.h"
+#include "mw.h"
+
+/*
+ * rpma_mw_bind -- rpma_mw_bind() mock
+ */
+int
+rpma_mw_bind(struct ibv_qp *qp, struct rpma_mw *mw,
+	const struct rpma_mr_local *mr, size_t offset, size_t len,
+	int usage, int flags, const void *op_context)
+{
+	assert_non_null(qp);
+	assert_non_null(mw);
+	assert_non_null(mr);
+	assert_int_not_equal(flags, 0);
+
+	check_expected_ptr(qp);
+	check_expected_ptr(mw);
+	check_expected_ptr(mr);
+	check_expected(offset);
+	check_expected(len);
+	check_expected(usage);
+	check_expected(flags);
+	check_expected_ptr(op_context);
+
+	return mock_type(int);
+}
+
+/*
+ * rpma_mw_invalidate -- rpma_mw_invalidate() mock
+ */
+int
+rpma_mw_invalidate(struct ibv_qp *qp, struct rpma_mw *mw, int flags,
+	const void *op_context)
+{
+	assert_non_null(qp);
+	assert_non_null(mw);
+	assert_int_not_equal(flags, 0);
+
+	check_expected_ptr(qp);
+	check_expected_ptr(mw);
+	check_expected(flags);
+	check_expected_ptr(op_context);
+
+	return mock_type(int);
+}
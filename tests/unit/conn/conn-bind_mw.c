@@ -0,0 +1,131 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * conn-bind_mw.c -- the rpma_bind_mw() unit tests
+ *
+ * APIs covered:
+ * - rpma_bind_mw()
+ */
+
+#include "conn-common.h"
+#include "mocks-ibverbs.h"
+#include "mocks-rdma_cm.h"
+
+/*
+ * bind_mw__conn_NULL - NULL conn is invalid
+ */
+static void
+bind_mw__conn_NULL(void **unused)
+{
+	/* run test */
+	int ret = rpma_bind_mw(NULL, MOCK_RPMA_MW, MOCK_RPMA_MR_LOCAL,
+				MOCK_LOCAL_OFFSET, MOCK_LEN, MOCK_MW_USAGE,
+				MOCK_FLAGS, MOCK_OP_CONTEXT);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+}
+
+/*
+ * bind_mw__mw_NULL - NULL mw is invalid
+ */
+static void
+bind_mw__mw_NULL(void **unused)
+{
+	/* run test */
+	int ret = rpma_bind_mw(MOCK_CONN, NULL, MOCK_RPMA_MR_LOCAL,
+				MOCK_LOCAL_OFFSET, MOCK_LEN, MOCK_MW_USAGE,
+				MOCK_FLAGS, MOCK_OP_CONTEXT);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+}
+
+/*
+ * bind_mw__mr_NULL - NULL mr is invalid
+ */
+static void
+bind_mw__mr_NULL(void **unused)
+{
+	/* run test */
+	int ret = rpma_bind_mw(MOCK_CONN, MOCK_RPMA_MW, NULL,
+				MOCK_LOCAL_OFFSET, MOCK_LEN, MOCK_MW_USAGE,
+				MOCK_FLAGS, MOCK_OP_CONTEXT);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+}
+
+/*
+ * bind_mw__flags_0 - flags == 0 is invalid
+ */
+static void
+bind_mw__flags_0(void **unused)
+{
+	/* run test */
+	int ret = rpma_bind_mw(MOCK_CONN, MOCK_RPMA_MW, MOCK_RPMA_MR_LOCAL,
+				MOCK_LOCAL_OFFSET, MOCK_LEN, MOCK_MW_USAGE,
+				0, MOCK_OP_CONTEXT);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+}
+
+/*
+ * bind_mw__success - happy day scenario
+ */
+static void
+bind_mw__success(void **cstate_ptr)
+{
+	struct conn_test_state *cstate = *cstate_ptr;
+
+	/* configure mocks */
+	expect_value(rpma_mw_bind, qp, MOCK_QP);
+	expect_value(rpma_mw_bind, mw, MOCK_RPMA_MW);
+	expect_value(rpma_mw_bind, mr, MOCK_RPMA_MR_LOCAL);
+	expect_value(rpma_mw_bind, offset, MOCK_LOCAL_OFFSET);
+	expect_value(rpma_mw_bind, len, MOCK_LEN);
+	expect_value(rpma_mw_bind, usage, MOCK_MW_USAGE);
+	expect_value(rpma_mw_bind, flags, MOCK_FLAGS);
+	expect_value(rpma_mw_bind, op_context, MOCK_OP_CONTEXT);
+	will_return(rpma_mw_bind, MOCK_OK);
+
+	/* run test */
+	int ret = rpma_bind_mw(cstate->conn, MOCK_RPMA_MW, MOCK_RPMA_MR_LOCAL,
+				MOCK_LOCAL_OFFSET, MOCK_LEN, MOCK_MW_USAGE,
+				MOCK_FLAGS, MOCK_OP_CONTEXT);
+
+	/* verify the results */
+	assert_int_equal(ret, MOCK_OK);
+}
+
+/*
+ * group_setup_bind_mw -- prepare resources for all tests in the group
+ */
+static int
+group_setup_bind_mw(void **unused)
+{
+	/* set value of QP in mock of CM ID */
+	Cm_id.qp = MOCK_QP;
+
+	return 0;
+}
+
+static const struct CMUnitTest tests_bind_mw[] = {
+	/* rpma_bind_mw() unit tests */
+	cmocka_unit_test(bind_mw__conn_NULL),
+	cmocka_unit_test(bind_mw__mw_NULL),
+	cmocka_unit_test(bind_mw__mr_NULL),
+	cmocka_unit_test(bind_mw__flags_0),
+	cmocka_unit_test_setup_teardown(bind_mw__success,
+		setup__conn_new, teardown__conn_delete),
+	cmocka_unit_test(NULL)
+};
+
+int
+main(int argc, char *argv[])
+{
+	return cmocka_run_group_tests(tests_bind_mw, group_setup_bind_mw,
+			NULL);
+}
@@ -15,6 +15,8 @@
 
 #define MOCK_RPMA_MR_REMOTE	((struct rpma_mr_remote *)0xC412)
 #define MOCK_REMOTE_OFFSET	(size_t)0xC414
+#define MOCK_RPMA_MW		((struct rpma_mw *)0xC419)
+#define MOCK_MW_USAGE		RPMA_MR_USAGE_READ_SRC
 #define MOCK_OFFSET_ALIGNED	(size_t)((MOCK_REMOTE_OFFSET / \
 		RPMA_ATOMIC_WRITE_ALIGNMENT) * RPMA_ATOMIC_WRITE_ALIGNMENT)
 #define MOCK_FD			0x00FD
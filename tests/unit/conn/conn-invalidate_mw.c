@@ -0,0 +1,107 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * conn-invalidate_mw.c -- the rpma_invalidate_mw() unit tests
+ *
+ * APIs covered:
+ * - rpma_invalidate_mw()
+ */
+
+#include "conn-common.h"
+#include "mocks-ibverbs.h"
+#include "mocks-rdma_cm.h"
+
+/*
+ * invalidate_mw__conn_NULL - NULL conn is invalid
+ */
+static void
+invalidate_mw__conn_NULL(void **unused)
+{
+	/* run test */
+	int ret = rpma_invalidate_mw(NULL, MOCK_RPMA_MW, MOCK_FLAGS,
+				MOCK_OP_CONTEXT);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+}
+
+/*
+ * invalidate_mw__mw_NULL - NULL mw is invalid
+ */
+static void
+invalidate_mw__mw_NULL(void **unused)
+{
+	/* run test */
+	int ret = rpma_invalidate_mw(MOCK_CONN, NULL, MOCK_FLAGS,
+				MOCK_OP_CONTEXT);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+}
+
+/*
+ * invalidate_mw__flags_0 - flags == 0 is invalid
+ */
+static void
+invalidate_mw__flags_0(void **unused)
+{
+	/* run test */
+	int ret = rpma_invalidate_mw(MOCK_CONN, MOCK_RPMA_MW, 0,
+				MOCK_OP_CONTEXT);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+}
+
+/*
+ * invalidate_mw__success - happy day scenario
+ */
+static void
+invalidate_mw__success(void **cstate_ptr)
+{
+	struct conn_test_state *cstate = *cstate_ptr;
+
+	/* configure mocks */
+	expect_value(rpma_mw_invalidate, qp, MOCK_QP);
+	expect_value(rpma_mw_invalidate, mw, MOCK_RPMA_MW);
+	expect_value(rpma_mw_invalidate, flags, MOCK_FLAGS);
+	expect_value(rpma_mw_invalidate, op_context, MOCK_OP_CONTEXT);
+	will_return(rpma_mw_invalidate, MOCK_OK);
+
+	/* run test */
+	int ret = rpma_invalidate_mw(cstate->conn, MOCK_RPMA_MW, MOCK_FLAGS,
+				MOCK_OP_CONTEXT);
+
+	/* verify the results */
+	assert_int_equal(ret, MOCK_OK);
+}
+
+/*
+ * group_setup_invalidate_mw -- prepare resources for all tests in the group
+ */
+static int
+group_setup_invalidate_mw(void **unused)
+{
+	/* set value of QP in mock of CM ID */
+	Cm_id.qp = MOCK_QP;
+
+	return 0;
+}
+
+static const struct CMUnitTest tests_invalidate_mw[] = {
+	/* rpma_invalidate_mw() unit tests */
+	cmocka_unit_test(invalidate_mw__conn_NULL),
+	cmocka_unit_test(invalidate_mw__mw_NULL),
+	cmocka_unit_test(invalidate_mw__flags_0),
+	cmocka_unit_test_setup_teardown(invalidate_mw__success,
+		setup__conn_new, teardown__conn_delete),
+	cmocka_unit_test(NULL)
+};
+
+int
+main(int argc, char *argv[])
+{
+	return cmocka_run_group_tests(tests_invalidate_mw,
+			group_setup_invalidate_mw, NULL);
+}
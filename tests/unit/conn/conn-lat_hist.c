@@ -0,0 +1,245 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * conn-lat_hist.c -- the rpma_conn_enable_lat_hist() and
+ * rpma_conn_get_lat_hist() unit tests
+ *
+ * APIs covered:
+ * - rpma_conn_enable_lat_hist()
+ * - rpma_conn_get_lat_hist()
+ */
+
+#include "conn-common.h"
+#include "mocks-ibverbs.h"
+#include "mocks-rdma_cm.h"
+#include "mocks-rpma-lat.h"
+
+/*
+ * enable_lat_hist__conn_NULL -- NULL conn is invalid
+ */
+static void
+enable_lat_hist__conn_NULL(void **unused)
+{
+	/* run test */
+	int ret = rpma_conn_enable_lat_hist(NULL);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+}
+
+/*
+ * enable_lat_hist__lat_new_ENOMEM -- rpma_lat_new() fails with ENOMEM
+ */
+static void
+enable_lat_hist__lat_new_ENOMEM(void **cstate_ptr)
+{
+	struct conn_test_state *cstate = *cstate_ptr;
+
+	/* configure mocks */
+	will_return(rpma_lat_new, NULL);
+
+	/* run test */
+	int ret = rpma_conn_enable_lat_hist(cstate->conn);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_NOMEM);
+}
+
+/*
+ * get_lat_hist__conn_NULL -- NULL conn is invalid
+ */
+static void
+get_lat_hist__conn_NULL(void **unused)
+{
+	/* run test */
+	int ret = rpma_conn_get_lat_hist(NULL, RPMA_LAT_OP_READ,
+			MOCK_LAT_HIST);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+}
+
+/*
+ * get_lat_hist__hist_NULL -- NULL hist is invalid
+ */
+static void
+get_lat_hist__hist_NULL(void **unused)
+{
+	/* run test */
+	int ret = rpma_conn_get_lat_hist(MOCK_CONN, RPMA_LAT_OP_READ, NULL);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+}
+
+/*
+ * get_lat_hist__op_invalid -- RPMA_LAT_OP_MAX is not a valid operation type
+ */
+static void
+get_lat_hist__op_invalid(void **unused)
+{
+	/* run test */
+	int ret = rpma_conn_get_lat_hist(MOCK_CONN, RPMA_LAT_OP_MAX,
+			MOCK_LAT_HIST);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+}
+
+/*
+ * get_lat_hist__not_enabled -- the tracking has to be enabled first
+ */
+static void
+get_lat_hist__not_enabled(void **cstate_ptr)
+{
+	struct conn_test_state *cstate = *cstate_ptr;
+
+	/* run test */
+	int ret = rpma_conn_get_lat_hist(cstate->conn, RPMA_LAT_OP_READ,
+			MOCK_LAT_HIST);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+}
+
+/*
+ * lat_hist__lifecycle -- enable the tracking, post a successful read,
+ * a failed write and a read without the completion and get the histogram
+ */
+static void
+lat_hist__lifecycle(void **cstate_ptr)
+{
+	struct conn_test_state *cstate = *cstate_ptr;
+
+	/* configure mocks */
+	will_return(rpma_lat_new, MOCK_LAT);
+	expect_value(rpma_cq_set_lat, cq, MOCK_RPMA_CQ);
+	expect_value(rpma_cq_set_lat, lat, MOCK_LAT);
+
+	/* run test */
+	int ret = rpma_conn_enable_lat_hist(cstate->conn);
+	assert_int_equal(ret, MOCK_OK);
+
+	/* enabling it again has no effect */
+	ret = rpma_conn_enable_lat_hist(cstate->conn);
+	assert_int_equal(ret, MOCK_OK);
+
+	/* configure mocks - a successful read */
+	expect_value(rpma_lat_post, lat, MOCK_LAT);
+	expect_value(rpma_lat_post, op, RPMA_LAT_OP_READ);
+	expect_value(rpma_lat_post, wr_id, (uint64_t)MOCK_OP_CONTEXT);
+	will_return(rpma_lat_post, MOCK_LAT_SLOT);
+	expect_value(rpma_mr_read, qp, MOCK_QP);
+	expect_value(rpma_mr_read, dst, MOCK_RPMA_MR_LOCAL);
+	expect_value(rpma_mr_read, dst_offset, MOCK_LOCAL_OFFSET);
+	expect_value(rpma_mr_read, src, MOCK_RPMA_MR_REMOTE);
+	expect_value(rpma_mr_read, src_offset, MOCK_REMOTE_OFFSET);
+	expect_value(rpma_mr_read, len, MOCK_LEN);
+	expect_value(rpma_mr_read, flags, MOCK_FLAGS);
+	expect_value(rpma_mr_read, op_context, MOCK_OP_CONTEXT);
+	will_return(rpma_mr_read, MOCK_OK);
+
+	/* run test */
+	ret = rpma_read(cstate->conn, MOCK_RPMA_MR_LOCAL, MOCK_LOCAL_OFFSET,
+			MOCK_RPMA_MR_REMOTE, MOCK_REMOTE_OFFSET,
+			MOCK_LEN, MOCK_FLAGS, MOCK_OP_CONTEXT);
+	assert_int_equal(ret, MOCK_OK);
+
+	/* configure mocks - a failed write is not accounted */
+	expect_value(rpma_lat_post, lat, MOCK_LAT);
+	expect_value(rpma_lat_post, op, RPMA_LAT_OP_WRITE);
+	expect_value(rpma_lat_post, wr_id, (uint64_t)MOCK_OP_CONTEXT);
+	will_return(rpma_lat_post, MOCK_LAT_SLOT);
+	expect_value(rpma_mr_write, qp, MOCK_QP);
+	expect_value(rpma_mr_write, dst, MOCK_RPMA_MR_REMOTE);
+	expect_value(rpma_mr_write, dst_offset, MOCK_REMOTE_OFFSET);
+	expect_value(rpma_mr_write, src, MOCK_RPMA_MR_LOCAL);
+	expect_value(rpma_mr_write, src_offset, MOCK_LOCAL_OFFSET);
+	expect_value(rpma_mr_write, len, MOCK_LEN);
+	expect_value(rpma_mr_write, flags, MOCK_FLAGS);
+	expect_value(rpma_mr_write, operation, IBV_WR_RDMA_WRITE);
+	expect_value(rpma_mr_write, imm, 0);
+	expect_value(rpma_mr_write, op_context, MOCK_OP_CONTEXT);
+	will_return(rpma_mr_write, RPMA_E_PROVIDER);
+	expect_value(rpma_lat_cancel, lat, MOCK_LAT);
+	expect_value(rpma_lat_cancel, slot, MOCK_LAT_SLOT);
+
+	/* run test */
+	ret = rpma_write(cstate->conn, MOCK_RPMA_MR_REMOTE, MOCK_REMOTE_OFFSET,
+			MOCK_RPMA_MR_LOCAL, MOCK_LOCAL_OFFSET,
+			MOCK_LEN, MOCK_FLAGS, MOCK_OP_CONTEXT);
+	assert_int_equal(ret, RPMA_E_PROVIDER);
+
+	/* configure mocks - a read completed only on error is not measured */
+	expect_value(rpma_mr_read, qp, MOCK_QP);
+	expect_value(rpma_mr_read, dst, MOCK_RPMA_MR_LOCAL);
+	expect_value(rpma_mr_read, dst_offset, MOCK_LOCAL_OFFSET);
+	expect_value(rpma_mr_read, src, MOCK_RPMA_MR_REMOTE);
+	expect_value(rpma_mr_read, src_offset, MOCK_REMOTE_OFFSET);
+	expect_value(rpma_mr_read, len, MOCK_LEN);
+	expect_value(rpma_mr_read, flags, RPMA_F_COMPLETION_ON_ERROR);
+	expect_value(rpma_mr_read, op_context, MOCK_OP_CONTEXT);
+	will_return(rpma_mr_read, MOCK_OK);
+
+	/* run test */
+	ret = rpma_read(cstate->conn, MOCK_RPMA_MR_LOCAL, MOCK_LOCAL_OFFSET,
+			MOCK_RPMA_MR_REMOTE, MOCK_REMOTE_OFFSET,
+			MOCK_LEN, RPMA_F_COMPLETION_ON_ERROR, MOCK_OP_CONTEXT);
+	assert_int_equal(ret, MOCK_OK);
+
+	/* configure mocks - get the histogram */
+	expect_value(rpma_lat_get_hist, lat, MOCK_LAT);
+	expect_value(rpma_lat_get_hist, op, RPMA_LAT_OP_READ);
+	expect_value(rpma_lat_hist_merge, dst, MOCK_LAT_HIST);
+	expect_value(rpma_lat_hist_merge, src, MOCK_LAT_HIST_SRC);
+	will_return(rpma_lat_hist_merge, MOCK_OK);
+
+	/* run test */
+	ret = rpma_conn_get_lat_hist(cstate->conn, RPMA_LAT_OP_READ,
+			MOCK_LAT_HIST);
+
+	/* verify the results */
+	assert_int_equal(ret, MOCK_OK);
+
+	/* the tracking object is deleted along with the connection */
+	expect_value(rpma_lat_delete, *lat_ptr, MOCK_LAT);
+}
+
+/*
+ * group_setup_lat_hist -- prepare resources for all tests in the group
+ */
+static int
+group_setup_lat_hist(void **unused)
+{
+	/* set value of QP in mock of CM ID */
+	Cm_id.qp = MOCK_QP;
+
+	return group_setup_common_conn(NULL);
+}
+
+static const struct CMUnitTest tests_lat_hist[] = {
+	/* rpma_conn_enable_lat_hist() unit tests */
+	cmocka_unit_test(enable_lat_hist__conn_NULL),
+	cmocka_unit_test_setup_teardown(enable_lat_hist__lat_new_ENOMEM,
+		setup__conn_new, teardown__conn_delete),
+
+	/* rpma_conn_get_lat_hist() unit tests */
+	cmocka_unit_test(get_lat_hist__conn_NULL),
+	cmocka_unit_test(get_lat_hist__hist_NULL),
+	cmocka_unit_test(get_lat_hist__op_invalid),
+	cmocka_unit_test_setup_teardown(get_lat_hist__not_enabled,
+		setup__conn_new, teardown__conn_delete),
+
+	/* rpma_conn_enable/get_lat_hist() lifecycle */
+	cmocka_unit_test_setup_teardown(lat_hist__lifecycle,
+		setup__conn_new, teardown__conn_delete),
+	cmocka_unit_test(NULL)
+};
+
+int
+main(int argc, char *argv[])
+{
+	return cmocka_run_group_tests(tests_lat_hist, group_setup_lat_hist,
+			NULL);
+}
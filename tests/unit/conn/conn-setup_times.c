@@ -0,0 +1,164 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * conn-setup_times.c -- the rpma_conn_get_setup_times() unit tests
+ *
+ * APIs covered:
+ * - rpma_conn_get_setup_times()
+ * - rpma_conn_set_setup_times()
+ */
+
+#include <string.h>
+
+#include "conn-common.h"
+#include "mocks-ibverbs.h"
+#include "mocks-rdma_cm.h"
+
+#define MOCK_RESOLVE_ADDR_NS	(uint64_t)0x5E01
+#define MOCK_RESOLVE_ROUTE_NS	(uint64_t)0x5E02
+#define MOCK_QP_CREATE_NS	(uint64_t)0x5E03
+#define MOCK_FLUSH_REG_NS	(uint64_t)0x5E04
+#define MOCK_HANDSHAKE_NS	(uint64_t)0x5E05
+#define MOCK_HANDSHAKE_START_NS	(uint64_t)1
+
+/*
+ * get_setup_times__conn_NULL -- NULL conn is invalid
+ */
+static void
+get_setup_times__conn_NULL(void **unused)
+{
+	/* run test */
+	struct rpma_conn_setup_times times;
+	int ret = rpma_conn_get_setup_times(NULL, &times);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+}
+
+/*
+ * get_setup_times__times_NULL -- NULL times is invalid
+ */
+static void
+get_setup_times__times_NULL(void **unused)
+{
+	/* run test */
+	int ret = rpma_conn_get_setup_times(MOCK_CONN, NULL);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+}
+
+/*
+ * get_setup_times__new -- a new connection has only the duration of creating
+ * the flushing object set
+ */
+static void
+get_setup_times__new(void **cstate_ptr)
+{
+	struct conn_test_state *cstate = *cstate_ptr;
+
+	/* run test */
+	struct rpma_conn_setup_times times;
+	memset(&times, 0xff, sizeof(times));
+	int ret = rpma_conn_get_setup_times(cstate->conn, &times);
+
+	/* verify the results */
+	assert_int_equal(ret, MOCK_OK);
+	assert_int_equal(times.resolve_addr_ns, 0);
+	assert_int_equal(times.resolve_route_ns, 0);
+	assert_int_equal(times.qp_create_ns, 0);
+	assert_int_not_equal(times.flush_reg_ns, UINT64_MAX);
+	assert_int_equal(times.handshake_ns, 0);
+}
+
+/*
+ * setup_times__ESTABLISHED -- the durations taken from the connection request
+ * are kept and the handshake is timed until the RPMA_CONN_ESTABLISHED event
+ */
+static void
+setup_times__ESTABLISHED(void **cstate_ptr)
+{
+	struct conn_test_state *cstate = *cstate_ptr;
+
+	/* run test - take the durations from the connection request */
+	struct rpma_conn_setup_times req_times = {
+		.resolve_addr_ns = MOCK_RESOLVE_ADDR_NS,
+		.resolve_route_ns = MOCK_RESOLVE_ROUTE_NS,
+		.qp_create_ns = MOCK_QP_CREATE_NS,
+		/* the ones below are not taken from the connection request */
+		.flush_reg_ns = MOCK_FLUSH_REG_NS,
+		.handshake_ns = MOCK_HANDSHAKE_NS
+	};
+	rpma_conn_set_setup_times(cstate->conn, &req_times,
+			MOCK_HANDSHAKE_START_NS);
+
+	struct rpma_conn_setup_times times;
+	int ret = rpma_conn_get_setup_times(cstate->conn, &times);
+
+	/* verify the results */
+	assert_int_equal(ret, MOCK_OK);
+	assert_int_equal(times.resolve_addr_ns, MOCK_RESOLVE_ADDR_NS);
+	assert_int_equal(times.resolve_route_ns, MOCK_RESOLVE_ROUTE_NS);
+	assert_int_equal(times.qp_create_ns, MOCK_QP_CREATE_NS);
+	assert_int_not_equal(times.flush_reg_ns, MOCK_FLUSH_REG_NS);
+	assert_int_equal(times.handshake_ns, 0);
+
+	/* configure mocks for rpma_conn_next_event() */
+	expect_value(rdma_get_cm_event, channel, MOCK_EVCH);
+	struct rdma_cm_event event;
+	event.event = RDMA_CM_EVENT_ESTABLISHED;
+	event.param.conn.private_data = NULL;
+	event.param.conn.private_data_len = 0;
+	will_return(rdma_get_cm_event, &event);
+	will_return(rpma_private_data_store, MOCK_OK);
+	expect_value(rdma_ack_cm_event, event, &event);
+	will_return(rdma_ack_cm_event, MOCK_OK);
+
+	/* run test - obtain the RPMA_CONN_ESTABLISHED event */
+	enum rpma_conn_event c_event = RPMA_CONN_UNDEFINED;
+	ret = rpma_conn_next_event(cstate->conn, &c_event);
+	assert_int_equal(ret, MOCK_OK);
+	assert_int_equal(c_event, RPMA_CONN_ESTABLISHED);
+
+	ret = rpma_conn_get_setup_times(cstate->conn, &times);
+
+	/* verify the results */
+	assert_int_equal(ret, MOCK_OK);
+	assert_int_equal(times.resolve_addr_ns, MOCK_RESOLVE_ADDR_NS);
+	assert_int_equal(times.resolve_route_ns, MOCK_RESOLVE_ROUTE_NS);
+	assert_int_equal(times.qp_create_ns, MOCK_QP_CREATE_NS);
+	assert_true(times.handshake_ns > 0);
+}
+
+/*
+ * group_setup_setup_times -- prepare resources for all tests in the group
+ */
+static int
+group_setup_setup_times(void **unused)
+{
+	/* set value of QP in mock of CM ID */
+	Cm_id.qp = MOCK_QP;
+
+	return group_setup_common_conn(NULL);
+}
+
+static const struct CMUnitTest tests_setup_times[] = {
+	/* rpma_conn_get_setup_times() unit tests */
+	cmocka_unit_test(get_setup_times__conn_NULL),
+	cmocka_unit_test(get_setup_times__times_NULL),
+	cmocka_unit_test_setup_teardown(get_setup_times__new,
+		setup__conn_new, teardown__conn_delete),
+
+	/* rpma_conn_set/get_setup_times() lifecycle */
+	cmocka_unit_test_setup_teardown(setup_times__ESTABLISHED,
+		setup__conn_new, teardown__conn_delete),
+	cmocka_unit_test(NULL)
+};
+
+int
+main(int argc, char *argv[])
+{
+	return cmocka_run_group_tests(tests_setup_times,
+			group_setup_setup_times, NULL);
+}
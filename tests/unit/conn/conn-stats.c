@@ -0,0 +1,236 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * conn-stats.c -- the rpma_conn_get_stats() and rpma_conn_reset_stats()
+ * unit tests
+ *
+ * APIs covered:
+ * - rpma_conn_get_stats()
+ * - rpma_conn_reset_stats()
+ */
+
+#include <string.h>
+
+#include "conn-common.h"
+#include "mocks-ibverbs.h"
+#include "mocks-rdma_cm.h"
+
+#define MOCK_FLUSH_OPS		(uint64_t)0x5701
+#define MOCK_FLUSH_BYTES	(uint64_t)0x5702
+
+/*
+ * get_stats__conn_NULL -- NULL conn is invalid
+ */
+static void
+get_stats__conn_NULL(void **unused)
+{
+	/* run test */
+	struct rpma_conn_stats stats;
+	int ret = rpma_conn_get_stats(NULL, &stats);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+}
+
+/*
+ * get_stats__stats_NULL -- NULL stats is invalid
+ */
+static void
+get_stats__stats_NULL(void **unused)
+{
+	/* run test */
+	int ret = rpma_conn_get_stats(MOCK_CONN, NULL);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+}
+
+/*
+ * reset_stats__conn_NULL -- NULL conn is invalid
+ */
+static void
+reset_stats__conn_NULL(void **unused)
+{
+	/* run test */
+	int ret = rpma_conn_reset_stats(NULL);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+}
+
+/*
+ * get_stats__new -- a new connection has all the counters zeroed
+ * except the ones provided by the flush object
+ */
+static void
+get_stats__new(void **cstate_ptr)
+{
+	struct conn_test_state *cstate = *cstate_ptr;
+
+	/* configure mocks */
+	will_return(rpma_flush_get_stats, MOCK_FLUSH_OPS);
+	will_return(rpma_flush_get_stats, MOCK_FLUSH_BYTES);
+
+	/* run test */
+	struct rpma_conn_stats stats;
+	memset(&stats, 0xff, sizeof(stats));
+	int ret = rpma_conn_get_stats(cstate->conn, &stats);
+
+	/* verify the results */
+	assert_int_equal(ret, MOCK_OK);
+	assert_int_equal(stats.read_ops, 0);
+	assert_int_equal(stats.read_bytes, 0);
+	assert_int_equal(stats.write_ops, 0);
+	assert_int_equal(stats.write_bytes, 0);
+	assert_int_equal(stats.atomic_write_ops, 0);
+	assert_int_equal(stats.atomic_write_bytes, 0);
+	assert_int_equal(stats.flush_ops, MOCK_FLUSH_OPS);
+	assert_int_equal(stats.flush_bytes, MOCK_FLUSH_BYTES);
+	assert_int_equal(stats.send_ops, 0);
+	assert_int_equal(stats.send_bytes, 0);
+	assert_int_equal(stats.recv_ops, 0);
+	assert_int_equal(stats.recv_bytes, 0);
+	assert_int_equal(stats.post_errors, 0);
+	assert_int_equal(stats.events, 0);
+}
+
+/*
+ * stats__lifecycle -- posted operations are accounted and zeroed
+ * by rpma_conn_reset_stats()
+ */
+static void
+stats__lifecycle(void **cstate_ptr)
+{
+	struct conn_test_state *cstate = *cstate_ptr;
+
+	/* configure mocks - a successful read */
+	expect_value(rpma_mr_read, qp, MOCK_QP);
+	expect_value(rpma_mr_read, dst, MOCK_RPMA_MR_LOCAL);
+	expect_value(rpma_mr_read, dst_offset, MOCK_LOCAL_OFFSET);
+	expect_value(rpma_mr_read, src, MOCK_RPMA_MR_REMOTE);
+	expect_value(rpma_mr_read, src_offset, MOCK_REMOTE_OFFSET);
+	expect_value(rpma_mr_read, len, MOCK_LEN);
+	expect_value(rpma_mr_read, flags, MOCK_FLAGS);
+	expect_value(rpma_mr_read, op_context, MOCK_OP_CONTEXT);
+	will_return(rpma_mr_read, MOCK_OK);
+
+	/* configure mocks - a failed write */
+	expect_value(rpma_mr_write, qp, MOCK_QP);
+	expect_value(rpma_mr_write, dst, MOCK_RPMA_MR_REMOTE);
+	expect_value(rpma_mr_write, dst_offset, MOCK_REMOTE_OFFSET);
+	expect_value(rpma_mr_write, src, MOCK_RPMA_MR_LOCAL);
+	expect_value(rpma_mr_write, src_offset, MOCK_LOCAL_OFFSET);
+	expect_value(rpma_mr_write, len, MOCK_LEN);
+	expect_value(rpma_mr_write, flags, MOCK_FLAGS);
+	expect_value(rpma_mr_write, operation, IBV_WR_RDMA_WRITE);
+	expect_value(rpma_mr_write, imm, 0);
+	expect_value(rpma_mr_write, op_context, MOCK_OP_CONTEXT);
+	will_return(rpma_mr_write, RPMA_E_PROVIDER);
+
+	/* configure mocks - a successful send */
+	expect_value(rpma_mr_send, qp, MOCK_QP);
+	expect_value(rpma_mr_send, src, MOCK_RPMA_MR_LOCAL);
+	expect_value(rpma_mr_send, offset, MOCK_LOCAL_OFFSET);
+	expect_value(rpma_mr_send, len, MOCK_LEN);
+	expect_value(rpma_mr_send, flags, MOCK_FLAGS);
+	expect_value(rpma_mr_send, operation, IBV_WR_SEND);
+	expect_value(rpma_mr_send, imm, 0);
+	expect_value(rpma_mr_send, op_context, MOCK_OP_CONTEXT);
+	will_return(rpma_mr_send, MOCK_OK);
+
+	/* configure mocks - a successful recv */
+	expect_value(rpma_mr_recv, qp, MOCK_QP);
+	expect_value(rpma_mr_recv, dst, MOCK_RPMA_MR_LOCAL);
+	expect_value(rpma_mr_recv, offset, MOCK_LOCAL_OFFSET);
+	expect_value(rpma_mr_recv, len, MOCK_LEN);
+	expect_value(rpma_mr_recv, op_context, MOCK_OP_CONTEXT);
+	will_return(rpma_mr_recv, MOCK_OK);
+
+	/* post the operations */
+	int ret = rpma_read(cstate->conn, MOCK_RPMA_MR_LOCAL, MOCK_LOCAL_OFFSET,
+				MOCK_RPMA_MR_REMOTE, MOCK_REMOTE_OFFSET,
+				MOCK_LEN, MOCK_FLAGS, MOCK_OP_CONTEXT);
+	assert_int_equal(ret, MOCK_OK);
+	ret = rpma_write(cstate->conn, MOCK_RPMA_MR_REMOTE, MOCK_REMOTE_OFFSET,
+				MOCK_RPMA_MR_LOCAL, MOCK_LOCAL_OFFSET,
+				MOCK_LEN, MOCK_FLAGS, MOCK_OP_CONTEXT);
+	assert_int_equal(ret, RPMA_E_PROVIDER);
+	ret = rpma_send(cstate->conn, MOCK_RPMA_MR_LOCAL, MOCK_LOCAL_OFFSET,
+				MOCK_LEN, MOCK_FLAGS, MOCK_OP_CONTEXT);
+	assert_int_equal(ret, MOCK_OK);
+	ret = rpma_recv(cstate->conn, MOCK_RPMA_MR_LOCAL, MOCK_LOCAL_OFFSET,
+				MOCK_LEN, MOCK_OP_CONTEXT);
+	assert_int_equal(ret, MOCK_OK);
+
+	/* run test - get the counters */
+	will_return(rpma_flush_get_stats, 0);
+	will_return(rpma_flush_get_stats, 0);
+	struct rpma_conn_stats stats;
+	ret = rpma_conn_get_stats(cstate->conn, &stats);
+
+	/* verify the results */
+	assert_int_equal(ret, MOCK_OK);
+	assert_int_equal(stats.read_ops, 1);
+	assert_int_equal(stats.read_bytes, MOCK_LEN);
+	assert_int_equal(stats.write_ops, 0);
+	assert_int_equal(stats.write_bytes, 0);
+	assert_int_equal(stats.send_ops, 1);
+	assert_int_equal(stats.send_bytes, MOCK_LEN);
+	assert_int_equal(stats.recv_ops, 1);
+	assert_int_equal(stats.recv_bytes, MOCK_LEN);
+	assert_int_equal(stats.post_errors, 1);
+
+	/* run test - reset the counters */
+	expect_function_call(rpma_flush_reset_stats);
+	ret = rpma_conn_reset_stats(cstate->conn);
+	assert_int_equal(ret, MOCK_OK);
+
+	will_return(rpma_flush_get_stats, 0);
+	will_return(rpma_flush_get_stats, 0);
+	ret = rpma_conn_get_stats(cstate->conn, &stats);
+
+	/* verify the results */
+	assert_int_equal(ret, MOCK_OK);
+	assert_int_equal(stats.read_ops, 0);
+	assert_int_equal(stats.read_bytes, 0);
+	assert_int_equal(stats.send_ops, 0);
+	assert_int_equal(stats.send_bytes, 0);
+	assert_int_equal(stats.recv_ops, 0);
+	assert_int_equal(stats.recv_bytes, 0);
+	assert_int_equal(stats.post_errors, 0);
+}
+
+/*
+ * group_setup_stats -- prepare resources for all tests in the group
+ */
+static int
+group_setup_stats(void **unused)
+{
+	/* set value of QP in mock of CM ID */
+	Cm_id.qp = MOCK_QP;
+
+	return group_setup_common_conn(NULL);
+}
+
+static const struct CMUnitTest tests_stats[] = {
+	/* rpma_conn_get_stats() unit tests */
+	cmocka_unit_test(get_stats__conn_NULL),
+	cmocka_unit_test(get_stats__stats_NULL),
+	cmocka_unit_test_setup_teardown(get_stats__new,
+		setup__conn_new, teardown__conn_delete),
+
+	/* rpma_conn_reset_stats() unit tests */
+	cmocka_unit_test(reset_stats__conn_NULL),
+
+	/* rpma_conn_get/reset_stats() lifecycle */
+	cmocka_unit_test_setup_teardown(stats__lifecycle,
+		setup__conn_new, teardown__conn_delete),
+	cmocka_unit_test(NULL)
+};
+
+int
+main(int argc, char *argv[])
+{
+	return cmocka_run_group_tests(tests_stats, group_setup_stats, NULL);
+}
@@ -0,0 +1,156 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * conn_cfg-comp_vector.c -- the rpma_conn_cfg_set/get_comp_vector()
+ *		unit tests
+ *
+ * APIs covered:
+ * - rpma_conn_cfg_set_comp_vector()
+ * - rpma_conn_cfg_get_comp_vector()
+ */
+
+#include "conn_cfg-common.h"
+#include "test-common.h"
+
+#define MOCK_COMP_VECTOR	5
+
+/*
+ * set__cfg_NULL -- NULL cfg is invalid
+ */
+static void
+set__cfg_NULL(void **unused)
+{
+	/* run test */
+	int ret = rpma_conn_cfg_set_comp_vector(NULL, MOCK_COMP_VECTOR);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+}
+
+/*
+ * set__comp_vector_negative -- a negative comp_vector other than
+ * RPMA_COMP_VECTOR_ROUND_ROBIN is invalid
+ */
+static void
+set__comp_vector_negative(void **cstate_ptr)
+{
+	struct conn_cfg_test_state *cstate = *cstate_ptr;
+
+	/* run test */
+	int ret = rpma_conn_cfg_set_comp_vector(cstate->cfg, -2);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+}
+
+/*
+ * get__cfg_NULL -- NULL cfg is invalid
+ */
+static void
+get__cfg_NULL(void **unused)
+{
+	/* run test */
+	int comp_vector;
+	int ret = rpma_conn_cfg_get_comp_vector(NULL, &comp_vector);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+}
+
+/*
+ * get__comp_vector_NULL -- NULL comp_vector is invalid
+ */
+static void
+get__comp_vector_NULL(void **cstate_ptr)
+{
+	struct conn_cfg_test_state *cstate = *cstate_ptr;
+
+	/* run test */
+	int ret = rpma_conn_cfg_get_comp_vector(cstate->cfg, NULL);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+}
+
+/*
+ * get_default__success -- get the default value
+ */
+static void
+get_default__success(void **cstate_ptr)
+{
+	struct conn_cfg_test_state *cstate = *cstate_ptr;
+
+	/* run test */
+	int comp_vector = -1;
+	int ret = rpma_conn_cfg_get_comp_vector(cstate->cfg, &comp_vector);
+
+	/* verify the results */
+	assert_int_equal(ret, MOCK_OK);
+	assert_int_equal(comp_vector, 0);
+}
+
+/*
+ * comp_vector__lifecycle -- happy day scenario
+ */
+static void
+comp_vector__lifecycle(void **cstate_ptr)
+{
+	struct conn_cfg_test_state *cstate = *cstate_ptr;
+
+	/* run test */
+	int ret = rpma_conn_cfg_set_comp_vector(cstate->cfg, MOCK_COMP_VECTOR);
+
+	/* verify the results */
+	assert_int_equal(ret, MOCK_OK);
+	int comp_vector;
+	ret = rpma_conn_cfg_get_comp_vector(cstate->cfg, &comp_vector);
+	assert_int_equal(ret, MOCK_OK);
+	assert_int_equal(comp_vector, MOCK_COMP_VECTOR);
+}
+
+/*
+ * comp_vector__round_robin -- RPMA_COMP_VECTOR_ROUND_ROBIN is stored as is
+ */
+static void
+comp_vector__round_robin(void **cstate_ptr)
+{
+	struct conn_cfg_test_state *cstate = *cstate_ptr;
+
+	/* run test */
+	int ret = rpma_conn_cfg_set_comp_vector(cstate->cfg,
+			RPMA_COMP_VECTOR_ROUND_ROBIN);
+
+	/* verify the results */
+	assert_int_equal(ret, MOCK_OK);
+	int comp_vector;
+	ret = rpma_conn_cfg_get_comp_vector(cstate->cfg, &comp_vector);
+	assert_int_equal(ret, MOCK_OK);
+	assert_int_equal(comp_vector, RPMA_COMP_VECTOR_ROUND_ROBIN);
+}
+
+static const struct CMUnitTest test_comp_vector[] = {
+	/* rpma_conn_cfg_set_comp_vector() unit tests */
+	cmocka_unit_test(set__cfg_NULL),
+	cmocka_unit_test_setup_teardown(set__comp_vector_negative,
+		setup__conn_cfg, teardown__conn_cfg),
+
+	/* rpma_conn_cfg_get_comp_vector() unit tests */
+	cmocka_unit_test(get__cfg_NULL),
+	cmocka_unit_test_setup_teardown(get__comp_vector_NULL,
+		setup__conn_cfg, teardown__conn_cfg),
+	cmocka_unit_test_setup_teardown(get_default__success,
+		setup__conn_cfg, teardown__conn_cfg),
+
+	/* rpma_conn_cfg_set/get_comp_vector() lifecycle */
+	cmocka_unit_test_setup_teardown(comp_vector__lifecycle,
+		setup__conn_cfg, teardown__conn_cfg),
+	cmocka_unit_test_setup_teardown(comp_vector__round_robin,
+		setup__conn_cfg, teardown__conn_cfg),
+};
+
+int
+main(int argc, char *argv[])
+{
+	return cmocka_run_group_tests(test_comp_vector, NULL, NULL);
+}
@@ -18,7 +18,8 @@ struct conn_req_new_test_state Conn_req_new_conn_cfg_default = {
 	.get_args.timeout_ms = RPMA_DEFAULT_TIMEOUT_MS,
 	.get_args.cq_size = MOCK_CQ_SIZE_DEFAULT,
 	.get_args.rcq_size = MOCK_RCQ_SIZE_DEFAULT,
-	.get_args.shared = MOCK_SHARED_DEFAULT
+	.get_args.shared = MOCK_SHARED_DEFAULT,
+	.get_args.comp_vector = MOCK_COMP_VECTOR_DEFAULT
 };
 
 struct conn_req_new_test_state Conn_req_new_conn_cfg_custom = {
@@ -26,21 +27,24 @@ struct conn_req_new_test_state Conn_req_new_conn_cfg_custom = {
 	.get_args.timeout_ms = MOCK_TIMEOUT_MS_CUSTOM,
 	.get_args.cq_size = MOCK_CQ_SIZE_CUSTOM,
 	.get_args.rcq_size = MOCK_RCQ_SIZE_CUSTOM,
-	.get_args.shared = MOCK_SHARED_CUSTOM
+	.get_args.shared = MOCK_SHARED_CUSTOM,
+	.get_args.comp_vector = MOCK_COMP_VECTOR_CUSTOM
 };
 
 struct conn_req_test_state Conn_req_conn_cfg_default = {
 	.get_args.cfg = MOCK_CONN_CFG_DEFAULT,
 	.get_args.cq_size = MOCK_CQ_SIZE_DEFAULT,
 	.get_args.rcq_size = MOCK_RCQ_SIZE_DEFAULT,
-	.get_args.shared = MOCK_SHARED_DEFAULT
+	.get_args.shared = MOCK_SHARED_DEFAULT,
+	.get_args.comp_vector = MOCK_COMP_VECTOR_DEFAULT
 };
 
 struct conn_req_test_state Conn_req_conn_cfg_custom = {
 	.get_args.cfg = MOCK_CONN_CFG_CUSTOM,
 	.get_args.cq_size = MOCK_CQ_SIZE_CUSTOM,
 	.get_args.rcq_size = MOCK_RCQ_SIZE_CUSTOM,
-	.get_args.shared = MOCK_SHARED_CUSTOM
+	.get_args.shared = MOCK_SHARED_CUSTOM,
+	.get_args.comp_vector = MOCK_COMP_VECTOR_CUSTOM
 };
 
 /*
@@ -54,6 +58,7 @@ configure_conn_req_new(void **cstate_ptr)
 			*cstate_ptr : &Conn_req_new_conn_cfg_default;
 
 	cstate->id.verbs = MOCK_VERBS;
+	MOCK_VERBS->num_comp_vectors = MOCK_NUM_COMP_VECTORS;
 	cstate->id.qp = MOCK_QP;
 	cstate->id.route.path_rec = MOCK_PATH_REC;
 
@@ -72,6 +77,7 @@ configure_conn_req(void **cstate_ptr)
 
 	cstate->event.event = RDMA_CM_EVENT_CONNECT_REQUEST;
 	cstate->id.verbs = MOCK_VERBS;
+	MOCK_VERBS->num_comp_vectors = MOCK_NUM_COMP_VECTORS;
 	cstate->id.route.path_rec = MOCK_PATH_REC;
 	cstate->event.id = &cstate->id;
 
@@ -92,13 +98,18 @@ setup__conn_req_from_cm_event(void **cstate_ptr)
 	will_return(rpma_conn_cfg_get_cqe, &cstate->get_args);
 	will_return(rpma_conn_cfg_get_rcqe, &cstate->get_args);
 	will_return(rpma_conn_cfg_get_compl_channel, &cstate->get_args);
+	will_return(rpma_conn_cfg_get_comp_vector, &cstate->get_args);
 	if (cstate->get_args.shared)
 		will_return(ibv_create_comp_channel, MOCK_COMP_CHANNEL);
 	expect_value(rpma_cq_new, cqe, cstate->get_args.cq_size);
+	expect_value(rpma_cq_new, comp_vector,
+			cstate->get_args.comp_vector);
 	expect_value(rpma_cq_new, shared_channel, MOCK_GET_CHANNEL(cstate));
 	will_return(rpma_cq_new, MOCK_RPMA_CQ);
 	if (cstate->get_args.rcq_size) {
 		expect_value(rpma_cq_new, cqe, cstate->get_args.rcq_size);
+		expect_value(rpma_cq_new, comp_vector,
+				cstate->get_args.comp_vector);
 		expect_value(rpma_cq_new, shared_channel,
 				MOCK_GET_CHANNEL(cstate));
 		will_return(rpma_cq_new, MOCK_RPMA_RCQ);
@@ -180,13 +191,18 @@ setup__conn_req_new(void **cstate_ptr)
 	will_return(rpma_conn_cfg_get_cqe, &cstate->get_args);
 	will_return(rpma_conn_cfg_get_rcqe, &cstate->get_args);
 	will_return(rpma_conn_cfg_get_compl_channel, &cstate->get_args);
+	will_return(rpma_conn_cfg_get_comp_vector, &cstate->get_args);
 	if (cstate->get_args.shared)
 		will_return(ibv_create_comp_channel, MOCK_COMP_CHANNEL);
 	expect_value(rpma_cq_new, cqe, cstate->get_args.cq_size);
+	expect_value(rpma_cq_new, comp_vector,
+			cstate->get_args.comp_vector);
 	expect_value(rpma_cq_new, shared_channel, MOCK_GET_CHANNEL(cstate));
 	will_return(rpma_cq_new, MOCK_RPMA_CQ);
 	if (cstate->get_args.rcq_size) {
 		expect_value(rpma_cq_new, cqe, cstate->get_args.rcq_size);
+		expect_value(rpma_cq_new, comp_vector,
+				cstate->get_args.comp_vector);
 		expect_value(rpma_cq_new, shared_channel,
 				MOCK_GET_CHANNEL(cstate));
 		will_return(rpma_cq_new, MOCK_RPMA_RCQ);
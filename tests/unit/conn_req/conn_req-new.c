@@ -272,6 +272,45 @@ new__resolve_route_ERRNO_subsequent_ERRNO2(void **unused)
 	assert_null(req);
 }
 
+/*
+ * new__comp_vector_out_of_range -- the completion vector is out of range
+ * of the completion vectors of the device
+ */
+static void
+new__comp_vector_out_of_range(void **unused)
+{
+	struct conn_req_new_test_state cstate_out_of_range =
+			Conn_req_new_conn_cfg_custom;
+	cstate_out_of_range.get_args.comp_vector = MOCK_NUM_COMP_VECTORS;
+	struct conn_req_new_test_state *cstate = &cstate_out_of_range;
+	configure_conn_req_new((void **)&cstate);
+
+	/* configure mocks */
+	will_return(rpma_conn_cfg_get_timeout, &cstate->get_args);
+	will_return(rpma_info_new, MOCK_INFO);
+	will_return(rdma_create_id, &cstate->id);
+	expect_value(rpma_info_resolve_addr, id, &cstate->id);
+	expect_value(rpma_info_resolve_addr, timeout_ms,
+			cstate->get_args.timeout_ms);
+	will_return(rpma_info_resolve_addr, MOCK_OK);
+	expect_value(rdma_resolve_route, timeout_ms, cstate->get_args.timeout_ms);
+	will_return(rdma_resolve_route, MOCK_OK);
+	will_return(rpma_conn_cfg_get_cqe, &cstate->get_args);
+	will_return(rpma_conn_cfg_get_rcqe, &cstate->get_args);
+	will_return(rpma_conn_cfg_get_compl_channel, &cstate->get_args);
+	will_return(rpma_conn_cfg_get_comp_vector, &cstate->get_args);
+	will_return(rdma_destroy_id, MOCK_OK);
+
+	/* run test */
+	struct rpma_conn_req *req = NULL;
+	int ret = rpma_conn_req_new(MOCK_PEER, MOCK_IP_ADDRESS, MOCK_PORT,
+			MOCK_GET_CONN_CFG(cstate), &req);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+	assert_null(req);
+}
+
 /*
  * new__cq_new_ERRNO -- rpma_cq_new(cqe) fails with MOCK_ERRNO
  */
@@ -298,9 +337,12 @@ new__cq_new_ERRNO(void **cstate_ptr)
 	will_return(rpma_conn_cfg_get_cqe, &cstate->get_args);
 	will_return(rpma_conn_cfg_get_rcqe, &cstate->get_args);
 	will_return(rpma_conn_cfg_get_compl_channel, &cstate->get_args);
+	will_return(rpma_conn_cfg_get_comp_vector, &cstate->get_args);
 	if (cstate->get_args.shared)
 		will_return(ibv_create_comp_channel, MOCK_COMP_CHANNEL);
 	expect_value(rpma_cq_new, cqe, cstate->get_args.cq_size);
+	expect_value(rpma_cq_new, comp_vector,
+			cstate->get_args.comp_vector);
 	expect_value(rpma_cq_new, shared_channel, MOCK_GET_CHANNEL(cstate));
 	will_return(rpma_cq_new, NULL);
 	will_return(rpma_cq_new, RPMA_E_PROVIDER);
@@ -346,9 +388,12 @@ new__cq_new_ERRNO_subsequent_ERRNO2(void **cstate_ptr)
 	will_return(rpma_conn_cfg_get_cqe, &cstate->get_args);
 	will_return(rpma_conn_cfg_get_rcqe, &cstate->get_args);
 	will_return(rpma_conn_cfg_get_compl_channel, &cstate->get_args);
+	will_return(rpma_conn_cfg_get_comp_vector, &cstate->get_args);
 	if (cstate->get_args.shared)
 		will_return(ibv_create_comp_channel, MOCK_COMP_CHANNEL);
 	expect_value(rpma_cq_new, cqe, cstate->get_args.cq_size);
+	expect_value(rpma_cq_new, comp_vector,
+			cstate->get_args.comp_vector);
 	expect_value(rpma_cq_new, shared_channel, MOCK_GET_CHANNEL(cstate));
 	will_return(rpma_cq_new, NULL);
 	will_return(rpma_cq_new, RPMA_E_PROVIDER);
@@ -393,12 +438,17 @@ new__rcq_new_ERRNO(void **unused)
 	will_return(rpma_conn_cfg_get_cqe, &cstate->get_args);
 	will_return(rpma_conn_cfg_get_rcqe, &cstate->get_args);
 	will_return(rpma_conn_cfg_get_compl_channel, &cstate->get_args);
+	will_return(rpma_conn_cfg_get_comp_vector, &cstate->get_args);
 	if (cstate->get_args.shared)
 		will_return(ibv_create_comp_channel, MOCK_COMP_CHANNEL);
 	expect_value(rpma_cq_new, cqe, cstate->get_args.cq_size);
+	expect_value(rpma_cq_new, comp_vector,
+			cstate->get_args.comp_vector);
 	expect_value(rpma_cq_new, shared_channel, MOCK_GET_CHANNEL(cstate));
 	will_return(rpma_cq_new, MOCK_RPMA_CQ);
 	expect_value(rpma_cq_new, cqe, cstate->get_args.rcq_size);
+	expect_value(rpma_cq_new, comp_vector,
+			cstate->get_args.comp_vector);
 	expect_value(rpma_cq_new, shared_channel, MOCK_GET_CHANNEL(cstate));
 	will_return(rpma_cq_new, NULL);
 	will_return(rpma_cq_new, RPMA_E_PROVIDER);
@@ -447,12 +497,17 @@ new__rcq_new_ERRNO_subsequent_ERRNO2(void **unused)
 	will_return(rpma_conn_cfg_get_cqe, &cstate->get_args);
 	will_return(rpma_conn_cfg_get_rcqe, &cstate->get_args);
 	will_return(rpma_conn_cfg_get_compl_channel, &cstate->get_args);
+	will_return(rpma_conn_cfg_get_comp_vector, &cstate->get_args);
 	if (cstate->get_args.shared)
 		will_return(ibv_create_comp_channel, MOCK_COMP_CHANNEL);
 	expect_value(rpma_cq_new, cqe, cstate->get_args.cq_size);
+	expect_value(rpma_cq_new, comp_vector,
+			cstate->get_args.comp_vector);
 	expect_value(rpma_cq_new, shared_channel, MOCK_GET_CHANNEL(cstate));
 	will_return(rpma_cq_new, MOCK_RPMA_CQ);
 	expect_value(rpma_cq_new, cqe, cstate->get_args.rcq_size);
+	expect_value(rpma_cq_new, comp_vector,
+			cstate->get_args.comp_vector);
 	expect_value(rpma_cq_new, shared_channel, MOCK_GET_CHANNEL(cstate));
 	will_return(rpma_cq_new, NULL);
 	will_return(rpma_cq_new, RPMA_E_PROVIDER);
@@ -501,13 +556,18 @@ new__peer_create_qp_ERRNO(void **cstate_ptr)
 	will_return(rpma_conn_cfg_get_cqe, &cstate->get_args);
 	will_return(rpma_conn_cfg_get_rcqe, &cstate->get_args);
 	will_return(rpma_conn_cfg_get_compl_channel, &cstate->get_args);
+	will_return(rpma_conn_cfg_get_comp_vector, &cstate->get_args);
 	if (cstate->get_args.shared)
 		will_return(ibv_create_comp_channel, MOCK_COMP_CHANNEL);
 	expect_value(rpma_cq_new, cqe, cstate->get_args.cq_size);
+	expect_value(rpma_cq_new, comp_vector,
+			cstate->get_args.comp_vector);
 	expect_value(rpma_cq_new, shared_channel, MOCK_GET_CHANNEL(cstate));
 	will_return(rpma_cq_new, MOCK_RPMA_CQ);
 	if (cstate->get_args.rcq_size) {
 		expect_value(rpma_cq_new, cqe, cstate->get_args.rcq_size);
+		expect_value(rpma_cq_new, comp_vector,
+				cstate->get_args.comp_vector);
 		expect_value(rpma_cq_new, shared_channel,
 				MOCK_GET_CHANNEL(cstate));
 		will_return(rpma_cq_new, MOCK_RPMA_RCQ);
@@ -563,13 +623,18 @@ new__peer_create_qp_ERRNO_subsequent_ERRNO2(void **cstate_ptr)
 	will_return(rpma_conn_cfg_get_cqe, &cstate->get_args);
 	will_return(rpma_conn_cfg_get_rcqe, &cstate->get_args);
 	will_return(rpma_conn_cfg_get_compl_channel, &cstate->get_args);
+	will_return(rpma_conn_cfg_get_comp_vector, &cstate->get_args);
 	if (cstate->get_args.shared)
 		will_return(ibv_create_comp_channel, MOCK_COMP_CHANNEL);
 	expect_value(rpma_cq_new, cqe, cstate->get_args.cq_size);
+	expect_value(rpma_cq_new, comp_vector,
+			cstate->get_args.comp_vector);
 	expect_value(rpma_cq_new, shared_channel, MOCK_GET_CHANNEL(cstate));
 	will_return(rpma_cq_new, MOCK_RPMA_CQ);
 	if (cstate->get_args.rcq_size) {
 		expect_value(rpma_cq_new, cqe, cstate->get_args.rcq_size);
+		expect_value(rpma_cq_new, comp_vector,
+				cstate->get_args.comp_vector);
 		expect_value(rpma_cq_new, shared_channel,
 				MOCK_GET_CHANNEL(cstate));
 		will_return(rpma_cq_new, MOCK_RPMA_RCQ);
@@ -630,13 +695,18 @@ new__malloc_ERRNO(void **cstate_ptr)
 	will_return(rpma_conn_cfg_get_cqe, &cstate->get_args);
 	will_return(rpma_conn_cfg_get_rcqe, &cstate->get_args);
 	will_return(rpma_conn_cfg_get_compl_channel, &cstate->get_args);
+	will_return(rpma_conn_cfg_get_comp_vector, &cstate->get_args);
 	if (cstate->get_args.shared)
 		will_return(ibv_create_comp_channel, MOCK_COMP_CHANNEL);
 	expect_value(rpma_cq_new, cqe, cstate->get_args.cq_size);
+	expect_value(rpma_cq_new, comp_vector,
+			cstate->get_args.comp_vector);
 	expect_value(rpma_cq_new, shared_channel, MOCK_GET_CHANNEL(cstate));
 	will_return(rpma_cq_new, MOCK_RPMA_CQ);
 	if (cstate->get_args.rcq_size) {
 		expect_value(rpma_cq_new, cqe, cstate->get_args.rcq_size);
+		expect_value(rpma_cq_new, comp_vector,
+				cstate->get_args.comp_vector);
 		expect_value(rpma_cq_new, shared_channel,
 			MOCK_GET_CHANNEL(cstate));
 		will_return(rpma_cq_new, MOCK_RPMA_RCQ);
@@ -693,13 +763,18 @@ new__malloc_ERRNO_subsequent_ERRNO2(void **cstate_ptr)
 	will_return(rpma_conn_cfg_get_cqe, &cstate->get_args);
 	will_return(rpma_conn_cfg_get_rcqe, &cstate->get_args);
 	will_return(rpma_conn_cfg_get_compl_channel, &cstate->get_args);
+	will_return(rpma_conn_cfg_get_comp_vector, &cstate->get_args);
 	if (cstate->get_args.shared)
 		will_return(ibv_create_comp_channel, MOCK_COMP_CHANNEL);
 	expect_value(rpma_cq_new, cqe, cstate->get_args.cq_size);
+	expect_value(rpma_cq_new, comp_vector,
+			cstate->get_args.comp_vector);
 	expect_value(rpma_cq_new, shared_channel, MOCK_GET_CHANNEL(cstate));
 	will_return(rpma_cq_new, MOCK_RPMA_CQ);
 	if (cstate->get_args.rcq_size) {
 		expect_value(rpma_cq_new, cqe, cstate->get_args.rcq_size);
+		expect_value(rpma_cq_new, comp_vector,
+				cstate->get_args.comp_vector);
 		expect_value(rpma_cq_new, shared_channel,
 				MOCK_GET_CHANNEL(cstate));
 		will_return(rpma_cq_new, MOCK_RPMA_RCQ);
@@ -760,6 +835,7 @@ static const struct CMUnitTest test_new[] = {
 	cmocka_unit_test(new__resolve_addr_ERRNO_subsequent_ERRNO2),
 	cmocka_unit_test(new__resolve_route_ERRNO),
 	cmocka_unit_test(new__resolve_route_ERRNO_subsequent_ERRNO2),
+	cmocka_unit_test(new__comp_vector_out_of_range),
 	CONN_REQ_NEW_TEST_WITH_AND_WITHOUT_RCQ(new__cq_new_ERRNO),
 	CONN_REQ_NEW_TEST_WITH_AND_WITHOUT_RCQ(
 		new__cq_new_ERRNO_subsequent_ERRNO2),
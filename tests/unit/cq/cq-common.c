@@ -35,6 +35,7 @@ setup__cq_new(void **cq_ptr)
 	if (!cstate->shared_channel)
 		will_return(ibv_create_comp_channel, MOCK_COMP_CHANNEL);
 	expect_value(ibv_create_cq, cqe, MOCK_CQ_SIZE_DEFAULT);
+	expect_value(ibv_create_cq, comp_vector, MOCK_COMP_VECTOR_CUSTOM);
 	will_return(ibv_create_cq, MOCK_IBV_CQ);
 	expect_value(ibv_req_notify_cq_mock, cq, MOCK_IBV_CQ);
 	will_return(ibv_req_notify_cq_mock, MOCK_OK);
@@ -43,7 +44,8 @@ setup__cq_new(void **cq_ptr)
 	/* run test */
 	struct rpma_cq *cq = NULL;
 	int ret = rpma_cq_new(MOCK_VERBS, MOCK_CQ_SIZE_DEFAULT,
-				cstate->shared_channel, &cq);
+				MOCK_COMP_VECTOR_CUSTOM, cstate->shared_channel,
+				&cq);
 
 	/* verify the result */
 	assert_int_equal(ret, MOCK_OK);
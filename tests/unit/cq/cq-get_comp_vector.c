@@ -0,0 +1,80 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * cq-get_comp_vector.c -- the rpma_cq_get_comp_vector() unit tests
+ *
+ * API covered:
+ * - rpma_cq_get_comp_vector()
+ */
+
+#include "librpma.h"
+#include "cmocka_headers.h"
+#include "mocks-ibverbs.h"
+#include "mocks-rpma-conn_cfg.h"
+#include "cq-common.h"
+
+/*
+ * get_comp_vector__cq_NULL -- cq NULL is invalid
+ */
+static void
+get_comp_vector__cq_NULL(void **unused)
+{
+	/* run test */
+	int comp_vector = 0;
+	int ret = rpma_cq_get_comp_vector(NULL, &comp_vector);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+}
+
+/*
+ * get_comp_vector__comp_vector_NULL -- comp_vector NULL is invalid
+ */
+static void
+get_comp_vector__comp_vector_NULL(void **cq_ptr)
+{
+	struct cq_test_state *cstate = *cq_ptr;
+	struct rpma_cq *cq = cstate->cq;
+
+	/* run test */
+	int ret = rpma_cq_get_comp_vector(cq, NULL);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+}
+
+/*
+ * get_comp_vector__success -- happy day scenario
+ */
+static void
+get_comp_vector__success(void **cq_ptr)
+{
+	struct cq_test_state *cstate = *cq_ptr;
+	struct rpma_cq *cq = cstate->cq;
+
+	/* run test */
+	int comp_vector = 0;
+	int ret = rpma_cq_get_comp_vector(cq, &comp_vector);
+
+	/* verify the results */
+	assert_int_equal(ret, 0);
+	assert_int_equal(comp_vector, MOCK_COMP_VECTOR_CUSTOM);
+}
+
+static const struct CMUnitTest tests_get_comp_vector[] = {
+	/* rpma_cq_get_comp_vector() unit tests */
+	cmocka_unit_test(get_comp_vector__cq_NULL),
+	cmocka_unit_test_setup_teardown(get_comp_vector__comp_vector_NULL,
+		setup__cq_new, teardown__cq_delete),
+	cmocka_unit_test_setup_teardown(get_comp_vector__success,
+		setup__cq_new, teardown__cq_delete),
+	cmocka_unit_test(NULL)
+};
+
+int
+main(int argc, char *argv[])
+{
+	return cmocka_run_group_tests(tests_get_comp_vector,
+			group_setup_common_cq, NULL);
+}
@@ -14,6 +14,7 @@
 
 #include "cmocka_headers.h"
 #include "mocks-ibverbs.h"
+#include "mocks-rpma-lat.h"
 #include "cq-common.h"
 
 static enum ibv_wc_opcode opcodes[] = {
@@ -289,6 +290,44 @@ get_wc__success_all_opcodes(void **cq_ptr)
 	}
 }
 
+/*
+ * get_wc__lat -- the collected completions are passed to the latency
+ * tracking object if it is set
+ */
+static void
+get_wc__lat(void **cq_ptr)
+{
+	struct cq_test_state *cstate = *cq_ptr;
+	struct rpma_cq *cq = cstate->cq;
+	struct ibv_wc orig_wc[2];
+	memset(orig_wc, 0, sizeof(orig_wc));
+	orig_wc[0].wr_id = (uint64_t)MOCK_OP_CONTEXT;
+	orig_wc[0].status = IBV_WC_SUCCESS;
+	orig_wc[0].opcode = IBV_WC_RDMA_READ;
+	orig_wc[1].wr_id = (uint64_t)MOCK_OP_CONTEXT;
+	orig_wc[1].status = IBV_WC_SUCCESS;
+	orig_wc[1].opcode = IBV_WC_RDMA_WRITE;
+
+	/* configure mocks */
+	expect_value(poll_cq, cq, MOCK_IBV_CQ);
+	expect_value(poll_cq, num_entries, 2);
+	will_return(poll_cq, 2);
+	will_return(poll_cq, orig_wc);
+	expect_value(rpma_lat_complete, lat, MOCK_LAT);
+	expect_value(rpma_lat_complete, num_entries, 2);
+
+	/* run test */
+	rpma_cq_set_lat(cq, MOCK_LAT);
+	struct ibv_wc wc[2];
+	int num_entries_got = 0;
+	int ret = rpma_cq_get_wc(cq, 2, wc, &num_entries_got);
+	rpma_cq_set_lat(cq, NULL);
+
+	/* verify the result */
+	assert_int_equal(ret, 0);
+	assert_int_equal(num_entries_got, 2);
+}
+
 /*
  * group_setup_get -- prepare resources for all tests in the group
  */
@@ -321,6 +360,8 @@ static const struct CMUnitTest tests_get_wc[] = {
 		setup__cq_new, teardown__cq_delete),
 	cmocka_unit_test_setup_teardown(get_wc__success_all_opcodes,
 		setup__cq_new, teardown__cq_delete),
+	cmocka_unit_test_setup_teardown(get_wc__lat,
+		setup__cq_new, teardown__cq_delete),
 	cmocka_unit_test(NULL)
 };
 
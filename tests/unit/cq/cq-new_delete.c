@@ -32,7 +32,8 @@ new__create_comp_channel_ERRNO(void **unused)
 	will_return(ibv_create_comp_channel, MOCK_ERRNO);
 
 	/* run test */
-	int ret = rpma_cq_new(MOCK_VERBS, MOCK_CQ_SIZE_DEFAULT, NULL, &cq);
+	int ret = rpma_cq_new(MOCK_VERBS, MOCK_CQ_SIZE_DEFAULT,
+			MOCK_COMP_VECTOR_DEFAULT, NULL, &cq);
 
 	/* verify the result */
 	assert_int_equal(ret, RPMA_E_PROVIDER);
@@ -49,12 +50,14 @@ new__create_cq_ERRNO(void **unused)
 	/* configure mocks */
 	will_return(ibv_create_comp_channel, MOCK_COMP_CHANNEL);
 	expect_value(ibv_create_cq, cqe, MOCK_CQ_SIZE_DEFAULT);
+	expect_value(ibv_create_cq, comp_vector, MOCK_COMP_VECTOR_DEFAULT);
 	will_return(ibv_create_cq, NULL);
 	will_return(ibv_create_cq, MOCK_ERRNO);
 	will_return(ibv_destroy_comp_channel, MOCK_OK);
 
 	/* run test */
-	int ret = rpma_cq_new(MOCK_VERBS, MOCK_CQ_SIZE_DEFAULT, NULL, &cq);
+	int ret = rpma_cq_new(MOCK_VERBS, MOCK_CQ_SIZE_DEFAULT,
+			MOCK_COMP_VECTOR_DEFAULT, NULL, &cq);
 
 	/* verify the result */
 	assert_int_equal(ret, RPMA_E_PROVIDER);
@@ -72,12 +75,14 @@ new__create_cq_ERRNO_subsequent_ERRNO2(void **unused)
 	/* configure mocks */
 	will_return(ibv_create_comp_channel, MOCK_COMP_CHANNEL);
 	expect_value(ibv_create_cq, cqe, MOCK_CQ_SIZE_DEFAULT);
+	expect_value(ibv_create_cq, comp_vector, MOCK_COMP_VECTOR_DEFAULT);
 	will_return(ibv_create_cq, NULL);
 	will_return(ibv_create_cq, MOCK_ERRNO);
 	will_return(ibv_destroy_comp_channel, MOCK_ERRNO2);
 
 	/* run test */
-	int ret = rpma_cq_new(MOCK_VERBS, MOCK_CQ_SIZE_DEFAULT, NULL, &cq);
+	int ret = rpma_cq_new(MOCK_VERBS, MOCK_CQ_SIZE_DEFAULT,
+			MOCK_COMP_VECTOR_DEFAULT, NULL, &cq);
 
 	/* verify the result */
 	assert_int_equal(ret, RPMA_E_PROVIDER);
@@ -94,6 +99,7 @@ new__req_notify_cq_ERRNO(void **unused)
 	/* configure mocks */
 	will_return(ibv_create_comp_channel, MOCK_COMP_CHANNEL);
 	expect_value(ibv_create_cq, cqe, MOCK_CQ_SIZE_DEFAULT);
+	expect_value(ibv_create_cq, comp_vector, MOCK_COMP_VECTOR_DEFAULT);
 	will_return(ibv_create_cq, MOCK_IBV_CQ);
 	expect_value(ibv_req_notify_cq_mock, cq, MOCK_IBV_CQ);
 	will_return(ibv_req_notify_cq_mock, MOCK_ERRNO);
@@ -101,7 +107,8 @@ new__req_notify_cq_ERRNO(void **unused)
 	will_return(ibv_destroy_comp_channel, MOCK_OK);
 
 	/* run test */
-	int ret = rpma_cq_new(MOCK_VERBS, MOCK_CQ_SIZE_DEFAULT, NULL, &cq);
+	int ret = rpma_cq_new(MOCK_VERBS, MOCK_CQ_SIZE_DEFAULT,
+			MOCK_COMP_VECTOR_DEFAULT, NULL, &cq);
 
 	/* verify the result */
 	assert_int_equal(ret, RPMA_E_PROVIDER);
@@ -120,6 +127,7 @@ new__req_notify_cq_ERRNO_subsequent_ERRNO2(void **unused)
 	/* configure mocks */
 	will_return(ibv_create_comp_channel, MOCK_COMP_CHANNEL);
 	expect_value(ibv_create_cq, cqe, MOCK_CQ_SIZE_DEFAULT);
+	expect_value(ibv_create_cq, comp_vector, MOCK_COMP_VECTOR_DEFAULT);
 	will_return(ibv_create_cq, MOCK_IBV_CQ);
 	expect_value(ibv_req_notify_cq_mock, cq, MOCK_IBV_CQ);
 	will_return(ibv_req_notify_cq_mock, MOCK_ERRNO);
@@ -127,7 +135,8 @@ new__req_notify_cq_ERRNO_subsequent_ERRNO2(void **unused)
 	will_return(ibv_destroy_comp_channel, MOCK_ERRNO2);
 
 	/* run test */
-	int ret = rpma_cq_new(MOCK_VERBS, MOCK_CQ_SIZE_DEFAULT, NULL, &cq);
+	int ret = rpma_cq_new(MOCK_VERBS, MOCK_CQ_SIZE_DEFAULT,
+			MOCK_COMP_VECTOR_DEFAULT, NULL, &cq);
 
 	/* verify the result */
 	assert_int_equal(ret, RPMA_E_PROVIDER);
@@ -144,6 +153,7 @@ new__malloc_ERRNO(void **unused)
 	/* configure mocks */
 	will_return(ibv_create_comp_channel, MOCK_COMP_CHANNEL);
 	expect_value(ibv_create_cq, cqe, MOCK_CQ_SIZE_DEFAULT);
+	expect_value(ibv_create_cq, comp_vector, MOCK_COMP_VECTOR_DEFAULT);
 	will_return(ibv_create_cq, MOCK_IBV_CQ);
 	expect_value(ibv_req_notify_cq_mock, cq, MOCK_IBV_CQ);
 	will_return(ibv_req_notify_cq_mock, MOCK_OK);
@@ -152,7 +162,8 @@ new__malloc_ERRNO(void **unused)
 	will_return(ibv_destroy_comp_channel, MOCK_OK);
 
 	/* run test */
-	int ret = rpma_cq_new(MOCK_VERBS, MOCK_CQ_SIZE_DEFAULT, NULL, &cq);
+	int ret = rpma_cq_new(MOCK_VERBS, MOCK_CQ_SIZE_DEFAULT,
+			MOCK_COMP_VECTOR_DEFAULT, NULL, &cq);
 
 	/* verify the result */
 	assert_int_equal(ret, RPMA_E_NOMEM);
@@ -171,6 +182,7 @@ new__malloc_ERRNO_subsequent_ERRNO2(void **unused)
 	/* configure mocks */
 	will_return(ibv_create_comp_channel, MOCK_COMP_CHANNEL);
 	expect_value(ibv_create_cq, cqe, MOCK_CQ_SIZE_DEFAULT);
+	expect_value(ibv_create_cq, comp_vector, MOCK_COMP_VECTOR_DEFAULT);
 	will_return(ibv_create_cq, MOCK_IBV_CQ);
 	expect_value(ibv_req_notify_cq_mock, cq, MOCK_IBV_CQ);
 	will_return(ibv_req_notify_cq_mock, MOCK_OK);
@@ -179,7 +191,8 @@ new__malloc_ERRNO_subsequent_ERRNO2(void **unused)
 	will_return(ibv_destroy_comp_channel, MOCK_ERRNO2);
 
 	/* run test */
-	int ret = rpma_cq_new(MOCK_VERBS, MOCK_CQ_SIZE_DEFAULT, NULL, &cq);
+	int ret = rpma_cq_new(MOCK_VERBS, MOCK_CQ_SIZE_DEFAULT,
+			MOCK_COMP_VECTOR_DEFAULT, NULL, &cq);
 
 	/* verify the result */
 	assert_int_equal(ret, RPMA_E_NOMEM);
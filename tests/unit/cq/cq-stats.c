@@ -0,0 +1,197 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * cq-stats.c -- the rpma_cq_get_stats() and rpma_cq_reset_stats() unit tests
+ *
+ * APIs covered:
+ * - rpma_cq_get_stats()
+ * - rpma_cq_reset_stats()
+ */
+
+#include <string.h>
+
+#include "librpma.h"
+#include "cmocka_headers.h"
+#include "mocks-ibverbs.h"
+#include "cq-common.h"
+
+/*
+ * poll_cq -- mock of ibv_poll_cq()
+ */
+static int
+poll_cq(struct ibv_cq *cq, int num_entries, struct ibv_wc *wc)
+{
+	check_expected_ptr(cq);
+	assert_non_null(wc);
+
+	int result = mock_type(int);
+	for (int i = 0; i < result; i++) {
+		memset(&wc[i], 0, sizeof(struct ibv_wc));
+		wc[i].status = mock_type(enum ibv_wc_status);
+	}
+
+	return result;
+}
+
+/*
+ * get_stats__cq_NULL -- NULL cq is invalid
+ */
+static void
+get_stats__cq_NULL(void **unused)
+{
+	/* run test */
+	struct rpma_cq_stats stats;
+	int ret = rpma_cq_get_stats(NULL, &stats);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+}
+
+/*
+ * get_stats__stats_NULL -- NULL stats is invalid
+ */
+static void
+get_stats__stats_NULL(void **cq_ptr)
+{
+	struct cq_test_state *cstate = *cq_ptr;
+
+	/* run test */
+	int ret = rpma_cq_get_stats(cstate->cq, NULL);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+}
+
+/*
+ * reset_stats__cq_NULL -- NULL cq is invalid
+ */
+static void
+reset_stats__cq_NULL(void **unused)
+{
+	/* run test */
+	int ret = rpma_cq_reset_stats(NULL);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+}
+
+/*
+ * get_stats__new -- a new CQ has all the counters zeroed
+ */
+static void
+get_stats__new(void **cq_ptr)
+{
+	struct cq_test_state *cstate = *cq_ptr;
+
+	/* run test */
+	struct rpma_cq_stats stats;
+	memset(&stats, 0xff, sizeof(stats));
+	int ret = rpma_cq_get_stats(cstate->cq, &stats);
+
+	/* verify the results */
+	assert_int_equal(ret, MOCK_OK);
+	assert_int_equal(stats.polls, 0);
+	assert_int_equal(stats.empty_polls, 0);
+	assert_int_equal(stats.completions, 0);
+	assert_int_equal(stats.error_completions, 0);
+	assert_int_equal(stats.events, 0);
+}
+
+/*
+ * stats__lifecycle -- polls, completions and events are accounted
+ * and zeroed by rpma_cq_reset_stats()
+ */
+static void
+stats__lifecycle(void **cq_ptr)
+{
+	struct cq_test_state *cstate = *cq_ptr;
+	struct rpma_cq *cq = cstate->cq;
+	struct ibv_wc wc[2];
+	int num_entries_got;
+
+	/* configure mocks - an empty poll */
+	expect_value(poll_cq, cq, MOCK_IBV_CQ);
+	will_return(poll_cq, 0);
+
+	/* configure mocks - a poll with one successful and one failed WC */
+	expect_value(poll_cq, cq, MOCK_IBV_CQ);
+	will_return(poll_cq, 2);
+	will_return(poll_cq, IBV_WC_SUCCESS);
+	will_return(poll_cq, IBV_WC_REM_ACCESS_ERR);
+
+	/* configure mocks - a completion event */
+	expect_value(ibv_get_cq_event, channel, MOCK_COMP_CHANNEL);
+	will_return(ibv_get_cq_event, MOCK_OK);
+	will_return(ibv_get_cq_event, MOCK_IBV_CQ);
+	expect_value(ibv_ack_cq_events, cq, MOCK_IBV_CQ);
+	expect_value(ibv_req_notify_cq_mock, cq, MOCK_IBV_CQ);
+	will_return(ibv_req_notify_cq_mock, MOCK_OK);
+
+	/* run test */
+	int ret = rpma_cq_get_wc(cq, 2, wc, &num_entries_got);
+	assert_int_equal(ret, RPMA_E_NO_COMPLETION);
+	ret = rpma_cq_get_wc(cq, 2, wc, &num_entries_got);
+	assert_int_equal(ret, MOCK_OK);
+	ret = rpma_cq_wait(cq);
+	assert_int_equal(ret, MOCK_OK);
+
+	struct rpma_cq_stats stats;
+	ret = rpma_cq_get_stats(cq, &stats);
+
+	/* verify the results */
+	assert_int_equal(ret, MOCK_OK);
+	assert_int_equal(stats.polls, 2);
+	assert_int_equal(stats.empty_polls, 1);
+	assert_int_equal(stats.completions, 2);
+	assert_int_equal(stats.error_completions, 1);
+	assert_int_equal(stats.events, 1);
+
+	/* run test - reset the counters */
+	ret = rpma_cq_reset_stats(cq);
+	assert_int_equal(ret, MOCK_OK);
+	ret = rpma_cq_get_stats(cq, &stats);
+
+	/* verify the results */
+	assert_int_equal(ret, MOCK_OK);
+	assert_int_equal(stats.polls, 0);
+	assert_int_equal(stats.empty_polls, 0);
+	assert_int_equal(stats.completions, 0);
+	assert_int_equal(stats.error_completions, 0);
+	assert_int_equal(stats.events, 0);
+}
+
+/*
+ * group_setup_stats -- prepare resources for all tests in the group
+ */
+static int
+group_setup_stats(void **unused)
+{
+	/* set the poll_cq callback in mock of IBV CQ */
+	MOCK_VERBS->ops.poll_cq = poll_cq;
+
+	return group_setup_common_cq(NULL);
+}
+
+static const struct CMUnitTest tests_stats[] = {
+	/* rpma_cq_get_stats() unit tests */
+	cmocka_unit_test(get_stats__cq_NULL),
+	cmocka_unit_test_setup_teardown(get_stats__stats_NULL,
+		setup__cq_new, teardown__cq_delete),
+	cmocka_unit_test_setup_teardown(get_stats__new,
+		setup__cq_new, teardown__cq_delete),
+
+	/* rpma_cq_reset_stats() unit tests */
+	cmocka_unit_test(reset_stats__cq_NULL),
+
+	/* rpma_cq_get/reset_stats() lifecycle */
+	cmocka_unit_test_setup_teardown(stats__lifecycle,
+		setup__cq_new, teardown__cq_delete),
+	cmocka_unit_test(NULL)
+};
+
+int
+main(int argc, char *argv[])
+{
+	return cmocka_run_group_tests(tests_stats, group_setup_stats, NULL);
+}
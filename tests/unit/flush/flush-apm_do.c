@@ -6,6 +6,8 @@
  *
  * API covered:
  * - rpma_flush_apm_do
+ * - rpma_flush_get_stats
+ * - rpma_flush_reset_stats
  */
 
 #include "cmocka_headers.h"
@@ -42,6 +44,58 @@ apm_do__success(void **fstate_ptr)
 	assert_int_equal(ret, MOCK_OK);
 }
 
+/*
+ * apm_do__stats -- rpma_flush_apm_do() updates the flush statistics
+ * counters only on success
+ */
+static void
+apm_do__stats(void **fstate_ptr)
+{
+	struct flush_test_state *fstate = *fstate_ptr;
+	uint64_t ops = 1, bytes = 1;
+
+	/* a new flush object has the counters zeroed */
+	rpma_flush_get_stats(fstate->flush, &ops, &bytes);
+	assert_int_equal(ops, 0);
+	assert_int_equal(bytes, 0);
+
+	/* configure mocks */
+	for (int i = 0; i < 2; i++) {
+		expect_value(rpma_mr_read, qp, MOCK_QP);
+		expect_value(rpma_mr_read, dst, MOCK_RPMA_MR_LOCAL);
+		expect_value(rpma_mr_read, dst_offset, 0);
+		expect_value(rpma_mr_read, src, MOCK_RPMA_MR_REMOTE);
+		expect_value(rpma_mr_read, src_offset, MOCK_REMOTE_OFFSET);
+		expect_value(rpma_mr_read, len, MOCK_RAW_LEN);
+		expect_value(rpma_mr_read, flags, MOCK_FLAGS);
+		expect_value(rpma_mr_read, op_context, MOCK_OP_CONTEXT);
+	}
+	will_return(rpma_mr_read, MOCK_OK);
+	will_return(rpma_mr_read, RPMA_E_PROVIDER);
+
+	/* run test */
+	int ret = fstate->flush->func(MOCK_QP, fstate->flush,
+			MOCK_RPMA_MR_REMOTE, MOCK_REMOTE_OFFSET,
+			MOCK_LEN, RPMA_FLUSH_TYPE_VISIBILITY,
+			MOCK_FLAGS, MOCK_OP_CONTEXT);
+	assert_int_equal(ret, MOCK_OK);
+	ret = fstate->flush->func(MOCK_QP, fstate->flush,
+			MOCK_RPMA_MR_REMOTE, MOCK_REMOTE_OFFSET,
+			MOCK_LEN, RPMA_FLUSH_TYPE_VISIBILITY,
+			MOCK_FLAGS, MOCK_OP_CONTEXT);
+	assert_int_equal(ret, RPMA_E_PROVIDER);
+
+	/* verify the results */
+	rpma_flush_get_stats(fstate->flush, &ops, &bytes);
+	assert_int_equal(ops, 1);
+	assert_int_equal(bytes, MOCK_LEN);
+
+	rpma_flush_reset_stats(fstate->flush);
+	rpma_flush_get_stats(fstate->flush, &ops, &bytes);
+	assert_int_equal(ops, 0);
+	assert_int_equal(bytes, 0);
+}
+
 int
 main(int argc, char *argv[])
 {
@@ -51,6 +105,8 @@ main(int argc, char *argv[])
 		/* rpma_flush_apm_do() unit tests */
 		cmocka_unit_test_setup_teardown(apm_do__success,
 			setup__flush_new, teardown__flush_delete),
+		cmocka_unit_test_setup_teardown(apm_do__stats,
+			setup__flush_new, teardown__flush_delete),
 	};
 
 	int ret = cmocka_run_group_tests(tests, NULL, NULL);
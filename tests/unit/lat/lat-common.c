@@ -0,0 +1,128 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * lat-common.c -- the latency tracking unit tests common functions
+ */
+
+#include <string.h>
+#include <time.h>
+
+#include "lat-common.h"
+
+/*
+ * __wrap_clock_gettime -- clock_gettime() mock
+ */
+int
+__wrap_clock_gettime(clockid_t __clock_id, struct timespec *__tp)
+{
+	assert_int_equal(__clock_id, CLOCK_MONOTONIC);
+	assert_non_null(__tp);
+
+	uint64_t ns = mock_type(uint64_t);
+	__tp->tv_sec = (time_t)(ns / 1000000000);
+	__tp->tv_nsec = (long)(ns % 1000000000);
+
+	return 0;
+}
+
+/*
+ * setup__lat_new -- prepare a new latency tracking object
+ */
+int
+setup__lat_new(void **lat_ptr)
+{
+	/* configure mocks */
+	will_return(__wrap__test_malloc, MOCK_OK);
+
+	/* prepare an object */
+	struct rpma_lat *lat = NULL;
+	int ret = rpma_lat_new(&lat);
+
+	/* verify the results */
+	assert_int_equal(ret, MOCK_OK);
+	assert_non_null(lat);
+
+	*lat_ptr = lat;
+
+	return 0;
+}
+
+/*
+ * teardown__lat_delete -- delete the latency tracking object
+ */
+int
+teardown__lat_delete(void **lat_ptr)
+{
+	struct rpma_lat *lat = *lat_ptr;
+
+	rpma_lat_delete(&lat);
+	assert_null(lat);
+
+	*lat_ptr = NULL;
+
+	return 0;
+}
+
+/*
+ * setup__hist_new -- prepare a new empty latency histogram
+ */
+int
+setup__hist_new(void **hist_ptr)
+{
+	/* configure mocks */
+	will_return(__wrap__test_malloc, MOCK_OK);
+
+	/* prepare an object */
+	struct rpma_lat_hist *hist = NULL;
+	int ret = rpma_lat_hist_new(&hist);
+
+	/* verify the results */
+	assert_int_equal(ret, MOCK_OK);
+	assert_non_null(hist);
+
+	*hist_ptr = hist;
+
+	return 0;
+}
+
+/*
+ * teardown__hist_delete -- delete the latency histogram
+ */
+int
+teardown__hist_delete(void **hist_ptr)
+{
+	struct rpma_lat_hist *hist = *hist_ptr;
+
+	int ret = rpma_lat_hist_delete(&hist);
+
+	/* verify the results */
+	assert_int_equal(ret, MOCK_OK);
+	assert_null(hist);
+
+	*hist_ptr = NULL;
+
+	return 0;
+}
+
+/*
+ * lat_record -- post the operation and complete it successfully
+ * after latency_ns nanoseconds
+ */
+void
+lat_record(struct rpma_lat *lat, enum rpma_lat_op op, uint64_t wr_id,
+		uint64_t latency_ns)
+{
+	will_return(__wrap_clock_gettime, MOCK_START_NS);
+	int slot = rpma_lat_post(lat, op, wr_id);
+	assert_true(slot >= 0);
+
+	struct ibv_wc wc;
+	memset(&wc, 0, sizeof(wc));
+	wc.wr_id = wr_id;
+	wc.status = IBV_WC_SUCCESS;
+	wc.opcode = IBV_WC_RDMA_READ;
+
+	will_return(__wrap_clock_gettime, MOCK_START_NS + latency_ns);
+	rpma_lat_complete(lat, &wc, 1);
+}
@@ -0,0 +1,30 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * lat-common.h -- the latency tracking unit tests common definitions
+ */
+
+#ifndef LAT_COMMON_H
+#define LAT_COMMON_H
+
+#include <infiniband/verbs.h>
+
+#include "cmocka_headers.h"
+#include "lat.h"
+#include "librpma.h"
+#include "test-common.h"
+
+#define MOCK_START_NS	(uint64_t)1000000000000
+#define MOCK_WR_ID	(uint64_t)MOCK_OP_CONTEXT
+
+int setup__lat_new(void **lat_ptr);
+int teardown__lat_delete(void **lat_ptr);
+
+int setup__hist_new(void **hist_ptr);
+int teardown__hist_delete(void **hist_ptr);
+
+void lat_record(struct rpma_lat *lat, enum rpma_lat_op op, uint64_t wr_id,
+		uint64_t latency_ns);
+
+#endif /* LAT_COMMON_H */
@@ -0,0 +1,299 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * lat-hist.c -- the latency histogram unit tests
+ *
+ * APIs covered:
+ * - rpma_lat_hist_new()
+ * - rpma_lat_hist_delete()
+ * - rpma_lat_hist_reset()
+ * - rpma_lat_hist_merge()
+ * - rpma_lat_hist_get_count()
+ * - rpma_lat_hist_get_percentile()
+ */
+
+#include "lat-common.h"
+
+/* the highest value of the last bucket - all longer latencies are clamped */
+#define LAT_MAX_NS	((1ULL << 37) - 1)
+
+/*
+ * hist_fill -- record the given latencies in the histogram
+ */
+static void
+hist_fill(struct rpma_lat_hist *hist, const uint64_t *latencies, int num)
+{
+	struct rpma_lat *lat = NULL;
+	will_return(__wrap__test_malloc, MOCK_OK);
+	assert_int_equal(rpma_lat_new(&lat), MOCK_OK);
+
+	for (int i = 0; i < num; i++)
+		lat_record(lat, RPMA_LAT_OP_READ, MOCK_WR_ID, latencies[i]);
+
+	int ret = rpma_lat_hist_merge(hist,
+			rpma_lat_get_hist(lat, RPMA_LAT_OP_READ));
+	assert_int_equal(ret, MOCK_OK);
+
+	rpma_lat_delete(&lat);
+}
+
+/*
+ * hist_percentile -- get the percentile which has to succeed
+ */
+static uint64_t
+hist_percentile(const struct rpma_lat_hist *hist, double percentile)
+{
+	uint64_t latency_ns = UINT64_MAX;
+	int ret = rpma_lat_hist_get_percentile(hist, percentile, &latency_ns);
+	assert_int_equal(ret, MOCK_OK);
+
+	return latency_ns;
+}
+
+/*
+ * new__hist_ptr_NULL -- NULL hist_ptr is invalid
+ */
+static void
+new__hist_ptr_NULL(void **unused)
+{
+	/* run test */
+	int ret = rpma_lat_hist_new(NULL);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+}
+
+/*
+ * new__malloc_ERRNO -- malloc() fails with MOCK_ERRNO
+ */
+static void
+new__malloc_ERRNO(void **unused)
+{
+	/* configure mocks */
+	will_return(__wrap__test_malloc, MOCK_ERRNO);
+
+	/* run test */
+	struct rpma_lat_hist *hist = NULL;
+	int ret = rpma_lat_hist_new(&hist);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_NOMEM);
+	assert_null(hist);
+}
+
+/*
+ * delete__hist_ptr_NULL -- NULL hist_ptr is invalid
+ */
+static void
+delete__hist_ptr_NULL(void **unused)
+{
+	/* run test */
+	int ret = rpma_lat_hist_delete(NULL);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+}
+
+/*
+ * reset__hist_NULL -- NULL hist is invalid
+ */
+static void
+reset__hist_NULL(void **unused)
+{
+	/* run test */
+	int ret = rpma_lat_hist_reset(NULL);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+}
+
+/*
+ * merge__NULL -- NULL dst or src is invalid
+ */
+static void
+merge__NULL(void **hist_ptr)
+{
+	struct rpma_lat_hist *hist = *hist_ptr;
+
+	/* run test */
+	int ret_dst = rpma_lat_hist_merge(NULL, hist);
+	int ret_src = rpma_lat_hist_merge(hist, NULL);
+
+	/* verify the results */
+	assert_int_equal(ret_dst, RPMA_E_INVAL);
+	assert_int_equal(ret_src, RPMA_E_INVAL);
+}
+
+/*
+ * get_count__NULL -- NULL hist or count is invalid
+ */
+static void
+get_count__NULL(void **hist_ptr)
+{
+	struct rpma_lat_hist *hist = *hist_ptr;
+
+	/* run test */
+	uint64_t count = 0;
+	int ret_hist = rpma_lat_hist_get_count(NULL, &count);
+	int ret_count = rpma_lat_hist_get_count(hist, NULL);
+
+	/* verify the results */
+	assert_int_equal(ret_hist, RPMA_E_INVAL);
+	assert_int_equal(ret_count, RPMA_E_INVAL);
+}
+
+/*
+ * get_percentile__invalid -- NULL hist or latency_ns or percentile out
+ * of the (0, 100] range is invalid
+ */
+static void
+get_percentile__invalid(void **hist_ptr)
+{
+	struct rpma_lat_hist *hist = *hist_ptr;
+	uint64_t latency_ns = 0;
+
+	/* run test & verify the results */
+	assert_int_equal(rpma_lat_hist_get_percentile(NULL, 50.0, &latency_ns),
+			RPMA_E_INVAL);
+	assert_int_equal(rpma_lat_hist_get_percentile(hist, 50.0, NULL),
+			RPMA_E_INVAL);
+	assert_int_equal(rpma_lat_hist_get_percentile(hist, 0.0, &latency_ns),
+			RPMA_E_INVAL);
+	assert_int_equal(rpma_lat_hist_get_percentile(hist, 100.1,
+			&latency_ns), RPMA_E_INVAL);
+}
+
+/*
+ * get_percentile__empty -- an empty histogram has all the percentiles
+ * equal 0
+ */
+static void
+get_percentile__empty(void **hist_ptr)
+{
+	struct rpma_lat_hist *hist = *hist_ptr;
+
+	/* verify the results */
+	assert_int_equal(hist_percentile(hist, 50.0), 0);
+	assert_int_equal(hist_percentile(hist, 100.0), 0);
+}
+
+/*
+ * get_percentile__values -- the short latencies are exact and the longer
+ * ones are rounded up to the upper bound of their bucket
+ */
+static void
+get_percentile__values(void **hist_ptr)
+{
+	struct rpma_lat_hist *hist = *hist_ptr;
+	uint64_t latencies[100];
+	for (int i = 0; i < 100; i++)
+		latencies[i] = (uint64_t)i + 1;
+
+	/* run test */
+	hist_fill(hist, latencies, 100);
+
+	/* verify the results */
+	uint64_t count = 0;
+	assert_int_equal(rpma_lat_hist_get_count(hist, &count), MOCK_OK);
+	assert_int_equal(count, 100);
+	assert_int_equal(hist_percentile(hist, 1.0), 1);
+	assert_int_equal(hist_percentile(hist, 50.0), 50);
+	/* 100 is recorded in the [100, 101] bucket */
+	assert_int_equal(hist_percentile(hist, 100.0), 101);
+}
+
+/*
+ * get_percentile__clamped -- latencies above the range are recorded
+ * in the last bucket
+ */
+static void
+get_percentile__clamped(void **hist_ptr)
+{
+	struct rpma_lat_hist *hist = *hist_ptr;
+	uint64_t latencies[] = {1000, LAT_MAX_NS + 1, UINT32_MAX * 1000ULL};
+
+	/* run test */
+	hist_fill(hist, latencies, 3);
+
+	/* verify the results */
+	assert_true(hist_percentile(hist, 30.0) >= 1000);
+	assert_true(hist_percentile(hist, 30.0) <= 1000 + 1000 / 32);
+	assert_int_equal(hist_percentile(hist, 100.0), LAT_MAX_NS);
+}
+
+/*
+ * merge_reset__success -- merging adds the values and resetting
+ * removes them all
+ */
+static void
+merge_reset__success(void **hist_ptr)
+{
+	struct rpma_lat_hist *hist = *hist_ptr;
+	uint64_t latencies[] = {10, 20, 30};
+	hist_fill(hist, latencies, 3);
+
+	struct rpma_lat_hist *sum = NULL;
+	setup__hist_new((void **)&sum);
+
+	/* run test */
+	assert_int_equal(rpma_lat_hist_merge(sum, hist), MOCK_OK);
+	assert_int_equal(rpma_lat_hist_merge(sum, hist), MOCK_OK);
+
+	/* verify the results */
+	uint64_t count = 0;
+	assert_int_equal(rpma_lat_hist_get_count(sum, &count), MOCK_OK);
+	assert_int_equal(count, 6);
+	assert_int_equal(hist_percentile(sum, 50.0), 20);
+
+	/* run test */
+	assert_int_equal(rpma_lat_hist_reset(sum), MOCK_OK);
+
+	/* verify the results */
+	assert_int_equal(rpma_lat_hist_get_count(sum, &count), MOCK_OK);
+	assert_int_equal(count, 0);
+	assert_int_equal(hist_percentile(sum, 100.0), 0);
+
+	teardown__hist_delete((void **)&sum);
+}
+
+static const struct CMUnitTest tests_hist[] = {
+	/* rpma_lat_hist_new() unit tests */
+	cmocka_unit_test(new__hist_ptr_NULL),
+	cmocka_unit_test(new__malloc_ERRNO),
+
+	/* rpma_lat_hist_delete() unit tests */
+	cmocka_unit_test(delete__hist_ptr_NULL),
+
+	/* rpma_lat_hist_reset() unit tests */
+	cmocka_unit_test(reset__hist_NULL),
+
+	/* rpma_lat_hist_merge() unit tests */
+	cmocka_unit_test_setup_teardown(merge__NULL,
+		setup__hist_new, teardown__hist_delete),
+
+	/* rpma_lat_hist_get_count() unit tests */
+	cmocka_unit_test_setup_teardown(get_count__NULL,
+		setup__hist_new, teardown__hist_delete),
+
+	/* rpma_lat_hist_get_percentile() unit tests */
+	cmocka_unit_test_setup_teardown(get_percentile__invalid,
+		setup__hist_new, teardown__hist_delete),
+	cmocka_unit_test_setup_teardown(get_percentile__empty,
+		setup__hist_new, teardown__hist_delete),
+	cmocka_unit_test_setup_teardown(get_percentile__values,
+		setup__hist_new, teardown__hist_delete),
+	cmocka_unit_test_setup_teardown(get_percentile__clamped,
+		setup__hist_new, teardown__hist_delete),
+
+	/* rpma_lat_hist_merge/reset() lifecycle */
+	cmocka_unit_test_setup_teardown(merge_reset__success,
+		setup__hist_new, teardown__hist_delete),
+	cmocka_unit_test(NULL)
+};
+
+int
+main(int argc, char *argv[])
+{
+	return cmocka_run_group_tests(tests_hist, NULL, NULL);
+}
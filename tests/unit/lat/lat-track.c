@@ -0,0 +1,326 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * lat-track.c -- the latency tracking unit tests
+ *
+ * APIs covered:
+ * - rpma_lat_new()
+ * - rpma_lat_delete()
+ * - rpma_lat_post()
+ * - rpma_lat_cancel()
+ * - rpma_lat_complete()
+ * - rpma_lat_get_hist()
+ */
+
+#include <string.h>
+
+#include "lat-common.h"
+
+#define MOCK_PENDING_MAX	1024
+
+/*
+ * lat_count -- get the number of latencies recorded for the operation type
+ */
+static uint64_t
+lat_count(struct rpma_lat *lat, enum rpma_lat_op op)
+{
+	uint64_t count = UINT64_MAX;
+	int ret = rpma_lat_hist_get_count(rpma_lat_get_hist(lat, op), &count);
+	assert_int_equal(ret, MOCK_OK);
+
+	return count;
+}
+
+/*
+ * lat_wc -- prepare a work completion
+ */
+static void
+lat_wc(struct ibv_wc *wc, uint64_t wr_id, enum ibv_wc_status status,
+		enum ibv_wc_opcode opcode)
+{
+	memset(wc, 0, sizeof(*wc));
+	wc->wr_id = wr_id;
+	wc->status = status;
+	wc->opcode = opcode;
+}
+
+/*
+ * new__malloc_ERRNO -- malloc() fails with MOCK_ERRNO
+ */
+static void
+new__malloc_ERRNO(void **unused)
+{
+	/* configure mocks */
+	will_return(__wrap__test_malloc, MOCK_ERRNO);
+
+	/* run test */
+	struct rpma_lat *lat = NULL;
+	int ret = rpma_lat_new(&lat);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_NOMEM);
+	assert_null(lat);
+}
+
+/*
+ * new__empty -- a new object has all the histograms empty
+ */
+static void
+new__empty(void **lat_ptr)
+{
+	struct rpma_lat *lat = *lat_ptr;
+
+	/* verify the results */
+	for (int op = RPMA_LAT_OP_READ; op < RPMA_LAT_OP_MAX; op++)
+		assert_int_equal(lat_count(lat, op), 0);
+}
+
+/*
+ * complete__success -- a completed operation is recorded in the histogram
+ * of its type only
+ */
+static void
+complete__success(void **lat_ptr)
+{
+	struct rpma_lat *lat = *lat_ptr;
+
+	/* run test */
+	lat_record(lat, RPMA_LAT_OP_FLUSH, MOCK_WR_ID, 1000);
+
+	/* verify the results */
+	assert_int_equal(lat_count(lat, RPMA_LAT_OP_READ), 0);
+	assert_int_equal(lat_count(lat, RPMA_LAT_OP_WRITE), 0);
+	assert_int_equal(lat_count(lat, RPMA_LAT_OP_FLUSH), 1);
+	assert_int_equal(lat_count(lat, RPMA_LAT_OP_SEND), 0);
+}
+
+/*
+ * complete__error -- a failed operation is not recorded but its slot
+ * is released
+ */
+static void
+complete__error(void **lat_ptr)
+{
+	struct rpma_lat *lat = *lat_ptr;
+
+	/* configure mocks */
+	will_return(__wrap_clock_gettime, MOCK_START_NS);
+	int slot = rpma_lat_post(lat, RPMA_LAT_OP_READ, MOCK_WR_ID);
+	assert_true(slot >= 0);
+
+	struct ibv_wc wc;
+	lat_wc(&wc, MOCK_WR_ID, IBV_WC_REM_ACCESS_ERR, IBV_WC_RDMA_READ);
+	will_return(__wrap_clock_gettime, MOCK_START_NS + 1000);
+
+	/* run test */
+	rpma_lat_complete(lat, &wc, 1);
+
+	/* verify the results */
+	assert_int_equal(lat_count(lat, RPMA_LAT_OP_READ), 0);
+
+	/* the same slot is reused by the next operation */
+	will_return(__wrap_clock_gettime, MOCK_START_NS);
+	assert_int_equal(rpma_lat_post(lat, RPMA_LAT_OP_READ, MOCK_WR_ID),
+			slot);
+	rpma_lat_cancel(lat, slot);
+}
+
+/*
+ * complete__canceled -- a canceled operation is not recorded
+ */
+static void
+complete__canceled(void **lat_ptr)
+{
+	struct rpma_lat *lat = *lat_ptr;
+
+	/* configure mocks */
+	will_return(__wrap_clock_gettime, MOCK_START_NS);
+	int slot = rpma_lat_post(lat, RPMA_LAT_OP_WRITE, MOCK_WR_ID);
+	assert_true(slot >= 0);
+	rpma_lat_cancel(lat, slot);
+
+	struct ibv_wc wc;
+	lat_wc(&wc, MOCK_WR_ID, IBV_WC_SUCCESS, IBV_WC_RDMA_WRITE);
+	will_return(__wrap_clock_gettime, MOCK_START_NS + 1000);
+
+	/* run test */
+	rpma_lat_complete(lat, &wc, 1);
+
+	/* verify the results */
+	assert_int_equal(lat_count(lat, RPMA_LAT_OP_WRITE), 0);
+}
+
+/*
+ * complete__recv_unknown -- receive completions and completions
+ * of unknown operations do not consume the pending operations
+ */
+static void
+complete__recv_unknown(void **lat_ptr)
+{
+	struct rpma_lat *lat = *lat_ptr;
+
+	/* configure mocks */
+	will_return(__wrap_clock_gettime, MOCK_START_NS);
+	int slot = rpma_lat_post(lat, RPMA_LAT_OP_SEND, MOCK_WR_ID);
+	assert_true(slot >= 0);
+
+	struct ibv_wc wc[3];
+	lat_wc(&wc[0], MOCK_WR_ID, IBV_WC_SUCCESS, IBV_WC_RECV);
+	lat_wc(&wc[1], MOCK_WR_ID + 1, IBV_WC_SUCCESS, IBV_WC_SEND);
+	lat_wc(&wc[2], MOCK_WR_ID, IBV_WC_SUCCESS, IBV_WC_SEND);
+	will_return(__wrap_clock_gettime, MOCK_START_NS + 1000);
+
+	/* run test */
+	rpma_lat_complete(lat, wc, 2);
+
+	/* verify the results */
+	assert_int_equal(lat_count(lat, RPMA_LAT_OP_SEND), 0);
+
+	/* configure mocks */
+	will_return(__wrap_clock_gettime, MOCK_START_NS + 2000);
+
+	/* run test */
+	rpma_lat_complete(lat, &wc[2], 1);
+
+	/* verify the results */
+	assert_int_equal(lat_count(lat, RPMA_LAT_OP_SEND), 1);
+}
+
+/*
+ * post__full -- an operation posted when all the slots near its home slot
+ * are taken is not tracked
+ */
+static void
+post__full(void **lat_ptr)
+{
+	struct rpma_lat *lat = *lat_ptr;
+	int slots[MOCK_PENDING_MAX];
+	uint64_t n;
+
+	/* run test */
+	for (n = 0; n < MOCK_PENDING_MAX; n++) {
+		will_return_maybe(__wrap_clock_gettime, MOCK_START_NS);
+		slots[n] = rpma_lat_post(lat, RPMA_LAT_OP_READ, n);
+		if (slots[n] < 0)
+			break;
+	}
+
+	/* verify the results */
+	assert_true(n < MOCK_PENDING_MAX);
+
+	for (uint64_t i = 0; i < n; i++)
+		rpma_lat_cancel(lat, slots[i]);
+}
+
+/*
+ * post__duplicate -- an operation with the wr_id of a pending operation
+ * is not tracked and the completion is matched with the first one
+ */
+static void
+post__duplicate(void **lat_ptr)
+{
+	struct rpma_lat *lat = *lat_ptr;
+
+	/* configure mocks */
+	will_return(__wrap_clock_gettime, MOCK_START_NS);
+	int slot = rpma_lat_post(lat, RPMA_LAT_OP_WRITE, MOCK_WR_ID);
+	assert_true(slot >= 0);
+
+	/* run test */
+	int dup = rpma_lat_post(lat, RPMA_LAT_OP_READ, MOCK_WR_ID);
+
+	/* verify the results */
+	assert_int_equal(dup, -1);
+
+	/* configure mocks */
+	struct ibv_wc wc[2];
+	lat_wc(&wc[0], MOCK_WR_ID, IBV_WC_SUCCESS, IBV_WC_RDMA_WRITE);
+	lat_wc(&wc[1], MOCK_WR_ID, IBV_WC_SUCCESS, IBV_WC_RDMA_READ);
+	will_return(__wrap_clock_gettime, MOCK_START_NS + 1000);
+
+	/* run test */
+	rpma_lat_complete(lat, wc, 2);
+
+	/* verify the results */
+	assert_int_equal(lat_count(lat, RPMA_LAT_OP_WRITE), 1);
+	assert_int_equal(lat_count(lat, RPMA_LAT_OP_READ), 0);
+}
+
+/*
+ * post__duplicate_tombstone -- a duplicate is detected also behind
+ * a released slot
+ */
+static void
+post__duplicate_tombstone(void **lat_ptr)
+{
+	struct rpma_lat *lat = *lat_ptr;
+	int homes[MOCK_PENDING_MAX + 1];
+	uint64_t first = 0;
+	uint64_t second;
+
+	/*
+	 * find two wr_ids of the same home slot - when only released slots
+	 * are in the table every operation takes its home slot
+	 */
+	for (second = 0; second <= MOCK_PENDING_MAX; second++) {
+		will_return(__wrap_clock_gettime, MOCK_START_NS);
+		homes[second] = rpma_lat_post(lat, RPMA_LAT_OP_READ, second);
+		assert_true(homes[second] >= 0);
+		rpma_lat_cancel(lat, homes[second]);
+
+		for (first = 0; first < second; first++) {
+			if (homes[first] == homes[second])
+				break;
+		}
+		if (first < second)
+			break;
+	}
+
+	/* configure mocks */
+	will_return(__wrap_clock_gettime, MOCK_START_NS);
+	int slot1 = rpma_lat_post(lat, RPMA_LAT_OP_READ, first);
+	assert_int_equal(slot1, homes[first]);
+	will_return(__wrap_clock_gettime, MOCK_START_NS);
+	int slot2 = rpma_lat_post(lat, RPMA_LAT_OP_READ, second);
+	assert_true(slot2 >= 0);
+	assert_int_not_equal(slot2, slot1);
+	rpma_lat_cancel(lat, slot1);
+
+	/* run test */
+	int dup = rpma_lat_post(lat, RPMA_LAT_OP_READ, second);
+
+	/* verify the results */
+	assert_int_equal(dup, -1);
+	rpma_lat_cancel(lat, slot2);
+}
+
+static const struct CMUnitTest tests_track[] = {
+	/* rpma_lat_new() unit tests */
+	cmocka_unit_test(new__malloc_ERRNO),
+	cmocka_unit_test_setup_teardown(new__empty,
+		setup__lat_new, teardown__lat_delete),
+
+	/* rpma_lat_post/cancel/complete() unit tests */
+	cmocka_unit_test_setup_teardown(complete__success,
+		setup__lat_new, teardown__lat_delete),
+	cmocka_unit_test_setup_teardown(complete__error,
+		setup__lat_new, teardown__lat_delete),
+	cmocka_unit_test_setup_teardown(complete__canceled,
+		setup__lat_new, teardown__lat_delete),
+	cmocka_unit_test_setup_teardown(complete__recv_unknown,
+		setup__lat_new, teardown__lat_delete),
+	cmocka_unit_test_setup_teardown(post__full,
+		setup__lat_new, teardown__lat_delete),
+	cmocka_unit_test_setup_teardown(post__duplicate,
+		setup__lat_new, teardown__lat_delete),
+	cmocka_unit_test_setup_teardown(post__duplicate_tombstone,
+		setup__lat_new, teardown__lat_delete),
+	cmocka_unit_test(NULL)
+};
+
+int
+main(int argc, char *argv[])
+{
+	return cmocka_run_group_tests(tests_track, NULL, NULL);
+}
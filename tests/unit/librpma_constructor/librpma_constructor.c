@@ -26,6 +26,7 @@ init__success(void **unused)
 static void
 fini__success(void **unused)
 {
+	expect_function_call(rpma_log_async_fini);
 	expect_function_call(rpma_log_fini);
 	librpma_fini();
 }
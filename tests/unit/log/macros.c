@@ -61,6 +61,13 @@ setup_threshold(void **level_ptr)
 	expect_string(mock_log_function, function_name, "log__all"); \
 	expect_string(mock_log_function, output, MOCK_MESSAGE "\n") \
 
+/*
+ * LOG_EXPECTED -- a message is logged if its level is compiled in and
+ * the primary threshold is not lower than it
+ */
+#define LOG_EXPECTED(l, primary) \
+	((l) <= RPMA_LOG_MIN_LEVEL && (l) <= (primary))
+
 /*
  * log__all -- happy day scenario
  */
@@ -80,22 +87,22 @@ log__all(void **level_ptr)
 					RPMA_LOG_THRESHOLD_AUX, secondary))
 			;
 
-		if (RPMA_LOG_LEVEL_NOTICE <= primary) {
+		if (LOG_EXPECTED(RPMA_LOG_LEVEL_NOTICE, primary)) {
 			MOCK_CONFIGURE_LOG_FUNC(RPMA_LOG_LEVEL_NOTICE);
 		}
 		RPMA_LOG_NOTICE("%s", MOCK_MESSAGE);
 
-		if (RPMA_LOG_LEVEL_WARNING <= primary) {
+		if (LOG_EXPECTED(RPMA_LOG_LEVEL_WARNING, primary)) {
 			MOCK_CONFIGURE_LOG_FUNC(RPMA_LOG_LEVEL_WARNING);
 		}
 		RPMA_LOG_WARNING("%s", MOCK_MESSAGE);
 
-		if (RPMA_LOG_LEVEL_ERROR <= primary) {
+		if (LOG_EXPECTED(RPMA_LOG_LEVEL_ERROR, primary)) {
 			MOCK_CONFIGURE_LOG_FUNC(RPMA_LOG_LEVEL_ERROR);
 		}
 		RPMA_LOG_ERROR("%s", MOCK_MESSAGE);
 
-		if (RPMA_LOG_LEVEL_FATAL <= primary) {
+		if (LOG_EXPECTED(RPMA_LOG_LEVEL_FATAL, primary)) {
 			MOCK_CONFIGURE_LOG_FUNC(RPMA_LOG_LEVEL_FATAL);
 		}
 		RPMA_LOG_FATAL("%s", MOCK_MESSAGE);
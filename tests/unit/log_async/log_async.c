@@ -0,0 +1,376 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * log_async.c -- the asynchronous logging backend unit tests
+ *
+ * APIs covered:
+ * - rpma_log_async_start()
+ * - rpma_log_async_stop()
+ * - rpma_log_async_function()
+ * - rpma_log_async_fini()
+ */
+
+#include <pthread.h>
+#include <string.h>
+
+#include "cmocka_headers.h"
+#include "log_async.h"
+#include "log_internal.h"
+#include "test-common.h"
+
+#define MOCK_FILE_NAME		"foo_bar.c"
+#define MOCK_LINE_NUMBER	199
+#define MOCK_FUNCTION_NAME	"foo_bar()"
+#define MOCK_RING_SIZE		128
+#define MOCK_OUTPUT_MAX		(MOCK_RING_SIZE + 8)
+#define MOCK_MESSAGE_MAX	256
+
+enum rpma_log_level Rpma_log_threshold[] = {
+		RPMA_LOG_LEVEL_DEBUG,	/* RPMA_LOG_THRESHOLD */
+		RPMA_LOG_DISABLED	/* RPMA_LOG_THRESHOLD_AUX */
+};
+
+rpma_log_function *Rpma_log_function;
+
+/*
+ * The outputs are written by the drainer thread and verified after
+ * rpma_log_async_stop() has joined it so cmocka is not called from
+ * the drainer thread.
+ */
+struct output {
+	enum rpma_log_level level;
+	bool with_time;
+	long tid;
+	const char *file_name;
+	int line_no;
+	char message[MOCK_MESSAGE_MAX];
+};
+
+static struct output Outputs[MOCK_OUTPUT_MAX];
+static int Outputs_num;
+
+/*
+ * The steps of the test thread or the drainer thread which the test
+ * waits for or lets them make.
+ */
+static pthread_mutex_t Thread_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t Thread_cond = PTHREAD_COND_INITIALIZER;
+static int Thread_step;
+
+/* the drainer blocks in the first output until it is let go */
+static bool Output_block;
+
+/*
+ * thread_step_wait -- wait until the other thread makes the step
+ */
+static void
+thread_step_wait(int step)
+{
+	pthread_mutex_lock(&Thread_lock);
+	while (Thread_step < step)
+		pthread_cond_wait(&Thread_cond, &Thread_lock);
+	pthread_mutex_unlock(&Thread_lock);
+}
+
+/*
+ * thread_step_done -- let the other thread know the step is done
+ */
+static void
+thread_step_done(int step)
+{
+	pthread_mutex_lock(&Thread_lock);
+	Thread_step = step;
+	pthread_cond_broadcast(&Thread_cond);
+	pthread_mutex_unlock(&Thread_lock);
+}
+
+/*
+ * rpma_log_default_output -- rpma_log_default_output() mock
+ */
+void
+rpma_log_default_output(enum rpma_log_level level,
+	const struct timespec *time, long tid, const char *file_name,
+	const int line_no, const char *function_name, const char *message)
+{
+	if (Outputs_num == MOCK_OUTPUT_MAX)
+		return;
+
+	if (Output_block) {
+		Output_block = false;
+		thread_step_done(1);
+		thread_step_wait(2);
+	}
+
+	struct output *out = &Outputs[Outputs_num++];
+	out->level = level;
+	out->with_time = (time != NULL);
+	out->tid = tid;
+	out->file_name = file_name;
+	out->line_no = line_no;
+	strncpy(out->message, message, MOCK_MESSAGE_MAX - 1);
+}
+
+/*
+ * rpma_log_default_function -- rpma_log_default_function() mock
+ */
+void
+rpma_log_default_function(enum rpma_log_level level, const char *file_name,
+	const int line_no, const char *function_name,
+	const char *message_format, ...)
+{
+	assert_true(0);
+}
+
+/*
+ * user_function -- a user-defined logging function
+ */
+static void
+user_function(enum rpma_log_level level, const char *file_name,
+	const int line_no, const char *function_name,
+	const char *message_format, ...)
+{
+	assert_true(0);
+}
+
+/*
+ * setup_outputs -- start with the default logging function and no outputs
+ */
+static int
+setup_outputs(void **unused)
+{
+	Rpma_log_function = rpma_log_default_function;
+	memset(Outputs, 0, sizeof(Outputs));
+	Outputs_num = 0;
+	Output_block = false;
+	Thread_step = 0;
+
+	return 0;
+}
+
+/*
+ * start__user_function -- the asynchronous mode cannot replace
+ * a user-defined logging function
+ */
+static void
+start__user_function(void **unused)
+{
+	Rpma_log_function = user_function;
+
+	/* run test */
+	int ret = rpma_log_async_start();
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_AGAIN);
+	assert_ptr_equal(Rpma_log_function, user_function);
+	assert_int_equal(rpma_log_async_stop(), MOCK_OK);
+}
+
+/*
+ * stop__not_started -- stopping when not started has no effect
+ */
+static void
+stop__not_started(void **unused)
+{
+	/* run test */
+	int ret = rpma_log_async_stop();
+
+	/* verify the results */
+	assert_int_equal(ret, MOCK_OK);
+	assert_ptr_equal(Rpma_log_function, rpma_log_default_function);
+}
+
+/*
+ * start_stop__lifecycle -- the messages logged in the asynchronous mode
+ * are written out by the background thread
+ */
+static void
+start_stop__lifecycle(void **unused)
+{
+	/* run test */
+	assert_int_equal(rpma_log_async_start(), MOCK_OK);
+	assert_ptr_equal(Rpma_log_function, rpma_log_async_function);
+	/* starting again has no effect */
+	assert_int_equal(rpma_log_async_start(), MOCK_OK);
+
+	for (int i = 0; i < 3; i++)
+		Rpma_log_function(RPMA_LOG_LEVEL_NOTICE, MOCK_FILE_NAME,
+			MOCK_LINE_NUMBER + i, MOCK_FUNCTION_NAME,
+			"message #%d\n", i);
+
+	assert_int_equal(rpma_log_async_stop(), MOCK_OK);
+
+	/* verify the results */
+	assert_ptr_equal(Rpma_log_function, rpma_log_default_function);
+	assert_int_equal(Outputs_num, 3);
+	for (int i = 0; i < 3; i++) {
+		char message[MOCK_MESSAGE_MAX];
+		snprintf(message, sizeof(message), "message #%d\n", i);
+		assert_int_equal(Outputs[i].level, RPMA_LOG_LEVEL_NOTICE);
+		assert_true(Outputs[i].with_time);
+		assert_true(Outputs[i].tid > 0);
+		assert_string_equal(Outputs[i].file_name, MOCK_FILE_NAME);
+		assert_int_equal(Outputs[i].line_no, MOCK_LINE_NUMBER + i);
+		assert_string_equal(Outputs[i].message, message);
+	}
+}
+
+/*
+ * function__fatal -- fatal messages are written out synchronously
+ */
+static void
+function__fatal(void **unused)
+{
+	/* run test */
+	rpma_log_async_function(RPMA_LOG_LEVEL_FATAL, MOCK_FILE_NAME,
+			MOCK_LINE_NUMBER, MOCK_FUNCTION_NAME, "fatal\n");
+
+	/* verify the results */
+	assert_int_equal(Outputs_num, 1);
+	assert_int_equal(Outputs[0].level, RPMA_LOG_LEVEL_FATAL);
+	assert_false(Outputs[0].with_time);
+	assert_string_equal(Outputs[0].message, "fatal\n");
+}
+
+/*
+ * function__after_stop -- the messages logged by a producer which has
+ * loaded the asynchronous function before rpma_log_async_stop()
+ * are written out synchronously
+ */
+static void
+function__after_stop(void **unused)
+{
+	assert_int_equal(rpma_log_async_start(), MOCK_OK);
+	rpma_log_function *function = Rpma_log_function;
+	assert_int_equal(rpma_log_async_stop(), MOCK_OK);
+
+	/* run test */
+	function(RPMA_LOG_LEVEL_ERROR, MOCK_FILE_NAME, MOCK_LINE_NUMBER,
+			MOCK_FUNCTION_NAME, "late\n");
+
+	/* verify the results */
+	assert_ptr_equal(function, rpma_log_async_function);
+	assert_int_equal(Outputs_num, 1);
+	assert_int_equal(Outputs[0].level, RPMA_LOG_LEVEL_ERROR);
+	assert_false(Outputs[0].with_time);
+	assert_string_equal(Outputs[0].message, "late\n");
+}
+
+/*
+ * function__ring_full -- the messages which do not fit into the ring
+ * are dropped and the number of them is reported
+ */
+static void
+function__ring_full(void **unused)
+{
+	/* block the drainer in writing out the first message */
+	Output_block = true;
+	assert_int_equal(rpma_log_async_start(), MOCK_OK);
+	rpma_log_async_function(RPMA_LOG_LEVEL_ERROR, MOCK_FILE_NAME,
+			MOCK_LINE_NUMBER, MOCK_FUNCTION_NAME, "error\n");
+	thread_step_wait(1);
+
+	/* run test */
+	for (int i = 0; i < MOCK_RING_SIZE + 2; i++)
+		rpma_log_async_function(RPMA_LOG_LEVEL_ERROR, MOCK_FILE_NAME,
+			MOCK_LINE_NUMBER, MOCK_FUNCTION_NAME, "error\n");
+	thread_step_done(2);
+	assert_int_equal(rpma_log_async_stop(), MOCK_OK);
+
+	/*
+	 * verify the results - the drops are reported right after
+	 * the message the drainer was blocked in
+	 */
+	assert_int_equal(Outputs_num, MOCK_RING_SIZE + 1);
+	assert_int_equal(Outputs[1].level, RPMA_LOG_LEVEL_WARNING);
+	assert_string_equal(Outputs[1].message, "3 log message(s) dropped\n");
+	for (int i = 2; i < Outputs_num; i++)
+		assert_string_equal(Outputs[i].message, "error\n");
+}
+
+/*
+ * thread_log -- log a message, wait for rpma_log_async_fini() and log
+ * another one which is written out synchronously since the drainer
+ * is not running anymore
+ */
+static void *
+thread_log(void *arg)
+{
+	rpma_log_async_function(RPMA_LOG_LEVEL_ERROR, MOCK_FILE_NAME,
+		MOCK_LINE_NUMBER, MOCK_FUNCTION_NAME, "before\n");
+	thread_step_done(1);
+
+	thread_step_wait(2);
+	rpma_log_async_function(RPMA_LOG_LEVEL_ERROR, MOCK_FILE_NAME,
+		MOCK_LINE_NUMBER, MOCK_FUNCTION_NAME, "after\n");
+	rpma_log_async_fini();
+
+	return NULL;
+}
+
+/*
+ * fini__ring_of_live_thread -- the pending messages are written out and
+ * the ring of a thread which is still alive is not freed
+ */
+static void
+fini__ring_of_live_thread(void **unused)
+{
+	assert_int_equal(rpma_log_async_start(), MOCK_OK);
+	pthread_t thread;
+	assert_int_equal(pthread_create(&thread, NULL, thread_log, NULL), 0);
+	thread_step_wait(1);
+
+	/* run test */
+	rpma_log_async_fini();
+	thread_step_done(2);
+	assert_int_equal(pthread_join(thread, NULL), 0);
+
+	/* verify the results */
+	assert_ptr_equal(Rpma_log_function, rpma_log_default_function);
+	assert_int_equal(Outputs_num, 2);
+	assert_true(Outputs[0].with_time);
+	assert_string_equal(Outputs[0].message, "before\n");
+	assert_false(Outputs[1].with_time);
+	assert_string_equal(Outputs[1].message, "after\n");
+}
+
+/*
+ * group_teardown_log_async -- free all the rings
+ */
+static int
+group_teardown_log_async(void **unused)
+{
+	rpma_log_async_fini();
+
+	return 0;
+}
+
+static const struct CMUnitTest tests_log_async[] = {
+	/* rpma_log_async_start/stop() unit tests */
+	cmocka_unit_test_setup_teardown(start__user_function,
+		setup_outputs, NULL),
+	cmocka_unit_test_setup_teardown(stop__not_started,
+		setup_outputs, NULL),
+	cmocka_unit_test_setup_teardown(start_stop__lifecycle,
+		setup_outputs, NULL),
+
+	/* rpma_log_async_function() unit tests */
+	cmocka_unit_test_setup_teardown(function__fatal,
+		setup_outputs, NULL),
+	cmocka_unit_test_setup_teardown(function__after_stop,
+		setup_outputs, NULL),
+	cmocka_unit_test_setup_teardown(function__ring_full,
+		setup_outputs, NULL),
+
+	/* rpma_log_async_fini() unit tests */
+	cmocka_unit_test_setup_teardown(fini__ring_of_live_thread,
+		setup_outputs, NULL),
+	cmocka_unit_test(NULL)
+};
+
+int
+main(int argc, char *argv[])
+{
+	return cmocka_run_group_tests(tests_log_async, NULL,
+			group_teardown_log_async);
+}
@@ -0,0 +1,260 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * meta-common.c -- the meta unit tests common functions
+ */
+
+#include <string.h>
+
+#include "librpma.h"
+#include "meta-common.h"
+
+struct rpma_mr_local *const Mock_mrs[MOCK_MRS_NUM] = {MOCK_MR_1, MOCK_MR_2};
+
+/* the buffer registered by the last call to rpma_mr_reg() */
+static void *Mock_reg_ptr;
+
+/*
+ * rpma_mr_reg -- rpma_mr_reg() mock
+ */
+int
+rpma_mr_reg(struct rpma_peer *peer, void *ptr, size_t size, int usage,
+	struct rpma_mr_local **mr_ptr)
+{
+	check_expected_ptr(peer);
+	check_expected(size);
+	check_expected(usage);
+	assert_non_null(ptr);
+	assert_non_null(mr_ptr);
+
+	int ret = mock_type(int);
+	if (ret)
+		return ret;
+
+	Mock_reg_ptr = ptr;
+	*mr_ptr = MOCK_META_MR;
+
+	return 0;
+}
+
+/*
+ * rpma_mr_dereg -- rpma_mr_dereg() mock
+ */
+int
+rpma_mr_dereg(struct rpma_mr_local **mr_ptr)
+{
+	assert_non_null(mr_ptr);
+	assert_ptr_equal(*mr_ptr, MOCK_META_MR);
+
+	*mr_ptr = NULL;
+
+	return mock_type(int);
+}
+
+/*
+ * rpma_mr_get_descriptor_size -- rpma_mr_get_descriptor_size() mock
+ */
+int
+rpma_mr_get_descriptor_size(const struct rpma_mr_local *mr, size_t *desc_size)
+{
+	assert_non_null(mr);
+	assert_non_null(desc_size);
+
+	*desc_size = MOCK_MR_DESC_SIZE;
+
+	return 0;
+}
+
+/*
+ * rpma_mr_get_descriptor -- rpma_mr_get_descriptor() mock, it fills
+ * the descriptor with the lowest byte of the mr pointer
+ */
+int
+rpma_mr_get_descriptor(const struct rpma_mr_local *mr, void *desc)
+{
+	assert_non_null(mr);
+	assert_non_null(desc);
+
+	memset(desc, (int)((uintptr_t)mr & 0xFF), MOCK_MR_DESC_SIZE);
+
+	return 0;
+}
+
+/*
+ * rpma_mr_get_descriptors -- rpma_mr_get_descriptors() mock, it fills
+ * every descriptor with the lowest byte of the respective mr pointer
+ */
+int
+rpma_mr_get_descriptors(struct rpma_mr_local *const mrs[], int mrs_num,
+		void *desc)
+{
+	assert_non_null(mrs);
+	assert_int_equal(mrs_num, MOCK_MRS_NUM);
+	assert_non_null(desc);
+
+	char *buff = desc;
+	for (int i = 0; i < mrs_num; ++i) {
+		memset(buff, (int)((uintptr_t)mrs[i] & 0xFF), MOCK_MR_DESC_SIZE);
+		buff += MOCK_MR_DESC_SIZE;
+	}
+
+	return 0;
+}
+
+/*
+ * rpma_mr_remote_from_descriptor -- rpma_mr_remote_from_descriptor() mock
+ */
+int
+rpma_mr_remote_from_descriptor(const void *desc,
+		size_t desc_size, struct rpma_mr_remote **mr_ptr)
+{
+	assert_non_null(desc);
+	assert_int_equal(desc_size, MOCK_MR_DESC_SIZE);
+	assert_non_null(mr_ptr);
+
+	int desc_byte = *(const uint8_t *)desc;
+	check_expected(desc_byte);
+
+	int ret = mock_type(int);
+	if (ret)
+		return ret;
+
+	*mr_ptr = mock_type(struct rpma_mr_remote *);
+
+	return 0;
+}
+
+/*
+ * rpma_mr_remote_delete -- rpma_mr_remote_delete() mock
+ */
+int
+rpma_mr_remote_delete(struct rpma_mr_remote **mr_ptr)
+{
+	assert_non_null(mr_ptr);
+
+	struct rpma_mr_remote *mr = *mr_ptr;
+	check_expected_ptr(mr);
+	*mr_ptr = NULL;
+
+	return 0;
+}
+
+/*
+ * rpma_peer_cfg_get_descriptor_size -- rpma_peer_cfg_get_descriptor_size()
+ * mock
+ */
+int
+rpma_peer_cfg_get_descriptor_size(const struct rpma_peer_cfg *pcfg,
+		size_t *desc_size)
+{
+	assert_ptr_equal(pcfg, MOCK_PEER_PCFG);
+	assert_non_null(desc_size);
+
+	*desc_size = MOCK_PCFG_DESC_SIZE;
+
+	return 0;
+}
+
+/*
+ * rpma_peer_cfg_get_descriptor -- rpma_peer_cfg_get_descriptor() mock
+ */
+int
+rpma_peer_cfg_get_descriptor(const struct rpma_peer_cfg *pcfg, void *desc)
+{
+	assert_ptr_equal(pcfg, MOCK_PEER_PCFG);
+	assert_non_null(desc);
+
+	*(uint8_t *)desc = MOCK_PCFG_DESC;
+
+	return 0;
+}
+
+/*
+ * rpma_peer_cfg_from_descriptor -- rpma_peer_cfg_from_descriptor() mock
+ */
+int
+rpma_peer_cfg_from_descriptor(const void *desc, size_t desc_size,
+		struct rpma_peer_cfg **pcfg_ptr)
+{
+	assert_non_null(desc);
+	assert_int_equal(desc_size, MOCK_PCFG_DESC_SIZE);
+	assert_int_equal(*(const uint8_t *)desc, MOCK_PCFG_DESC);
+	assert_non_null(pcfg_ptr);
+
+	int ret = mock_type(int);
+	if (ret)
+		return ret;
+
+	*pcfg_ptr = MOCK_PEER_PCFG;
+
+	return 0;
+}
+
+/*
+ * rpma_peer_cfg_delete -- rpma_peer_cfg_delete() mock
+ */
+int
+rpma_peer_cfg_delete(struct rpma_peer_cfg **pcfg_ptr)
+{
+	assert_non_null(pcfg_ptr);
+	assert_ptr_equal(*pcfg_ptr, MOCK_PEER_PCFG);
+
+	*pcfg_ptr = NULL;
+
+	return 0;
+}
+
+/*
+ * setup__meta_new -- prepare a valid rpma_meta object
+ */
+int
+setup__meta_new(void **mstate_ptr)
+{
+	static struct meta_test_state mstate;
+
+	/* configure mocks */
+	will_return(__wrap__test_malloc, MOCK_OK);
+	will_return(__wrap__test_malloc, MOCK_OK);
+	expect_value(rpma_mr_reg, peer, MOCK_PEER);
+	expect_value(rpma_mr_reg, size, MOCK_META_SIZE);
+	expect_value(rpma_mr_reg, usage, RPMA_MR_USAGE_READ_SRC);
+	will_return(rpma_mr_reg, MOCK_OK);
+
+	/* run test */
+	mstate.meta = NULL;
+	int ret = rpma_meta_new(MOCK_PEER, Mock_mrs, MOCK_MRS_NUM,
+			MOCK_PEER_PCFG, &mstate.meta);
+
+	/* verify the results */
+	assert_int_equal(ret, MOCK_OK);
+	assert_non_null(mstate.meta);
+	mstate.buf = Mock_reg_ptr;
+
+	*mstate_ptr = &mstate;
+
+	return 0;
+}
+
+/*
+ * teardown__meta_delete -- delete the rpma_meta object
+ */
+int
+teardown__meta_delete(void **mstate_ptr)
+{
+	struct meta_test_state *mstate = *mstate_ptr;
+
+	/* configure mocks */
+	will_return(rpma_mr_dereg, MOCK_OK);
+
+	/* run test */
+	int ret = rpma_meta_delete(&mstate->meta);
+
+	/* verify the results */
+	assert_int_equal(ret, MOCK_OK);
+	assert_null(mstate->meta);
+
+	*mstate_ptr = NULL;
+
+	return 0;
+}
@@ -0,0 +1,41 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * meta-common.h -- the meta unit tests common definitions
+ */
+
+#ifndef META_COMMON_H
+#define META_COMMON_H
+
+#include "cmocka_headers.h"
+#include "test-common.h"
+
+#define MOCK_MR_1		((struct rpma_mr_local *)0xC401)
+#define MOCK_MR_2		((struct rpma_mr_local *)0xC402)
+#define MOCK_MRS_NUM		2
+#define MOCK_META_MR		((struct rpma_mr_local *)0xC4FF)
+#define MOCK_MR_REMOTE_1	((struct rpma_mr_remote *)0xC501)
+#define MOCK_MR_REMOTE_2	((struct rpma_mr_remote *)0xC502)
+#define MOCK_MR_DESC_SIZE	((size_t)21)
+#define MOCK_PCFG_DESC_SIZE	((size_t)1)
+#define MOCK_PCFG_DESC		0xA5
+#define MOCK_META_DESC_SIZE	MOCK_MR_DESC_SIZE
+/* the header, the peer configuration descriptor and two MR descriptors */
+#define MOCK_META_SIZE		((size_t)12 + MOCK_PCFG_DESC_SIZE + \
+				MOCK_MRS_NUM * MOCK_MR_DESC_SIZE)
+
+extern struct rpma_mr_local *const Mock_mrs[MOCK_MRS_NUM];
+
+/*
+ * All the resources used between setup__meta_new and teardown__meta_delete
+ */
+struct meta_test_state {
+	struct rpma_meta *meta;
+	void *buf; /* the registered buffer of the metadata */
+};
+
+int setup__meta_new(void **mstate_ptr);
+int teardown__meta_delete(void **mstate_ptr);
+
+#endif /* META_COMMON_H */
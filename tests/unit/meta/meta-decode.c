@@ -0,0 +1,299 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * meta-decode.c -- the rpma_meta_decode() unit tests
+ *
+ * API covered:
+ * - rpma_meta_decode()
+ */
+
+#include <string.h>
+
+#include "librpma.h"
+#include "meta-common.h"
+
+/*
+ * decode__buf_NULL -- NULL buf is invalid
+ */
+static void
+decode__buf_NULL(void **unused)
+{
+	/* run test */
+	struct rpma_mr_remote *mrs[MOCK_MRS_NUM];
+	int mrs_num = MOCK_MRS_NUM;
+	int ret = rpma_meta_decode(NULL, MOCK_META_SIZE, mrs, &mrs_num, NULL);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+	assert_int_equal(mrs_num, MOCK_MRS_NUM);
+}
+
+/*
+ * decode__mrs_num_NULL -- NULL mrs_num is invalid
+ */
+static void
+decode__mrs_num_NULL(void **mstate_ptr)
+{
+	struct meta_test_state *mstate = *mstate_ptr;
+
+	/* run test */
+	struct rpma_mr_remote *mrs[MOCK_MRS_NUM];
+	int ret = rpma_meta_decode(mstate->buf, MOCK_META_SIZE, mrs, NULL,
+			NULL);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+}
+
+/*
+ * decode__size_too_small -- the size of the metadata is too small
+ */
+static void
+decode__size_too_small(void **mstate_ptr)
+{
+	struct meta_test_state *mstate = *mstate_ptr;
+
+	/* run test */
+	struct rpma_mr_remote *mrs[MOCK_MRS_NUM];
+	int mrs_num = MOCK_MRS_NUM;
+	int ret = rpma_meta_decode(mstate->buf, MOCK_META_SIZE - 1, mrs,
+			&mrs_num, NULL);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+	assert_int_equal(mrs_num, MOCK_MRS_NUM);
+}
+
+/*
+ * decode__no_header -- the buffer is smaller than the header
+ */
+static void
+decode__no_header(void **mstate_ptr)
+{
+	struct meta_test_state *mstate = *mstate_ptr;
+
+	/* run test */
+	int mrs_num = 0;
+	int ret = rpma_meta_decode(mstate->buf, 1, NULL, &mrs_num, NULL);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+	assert_int_equal(mrs_num, 0);
+}
+
+/*
+ * decode__magic_invalid -- the buffer does not contain the metadata
+ */
+static void
+decode__magic_invalid(void **mstate_ptr)
+{
+	struct meta_test_state *mstate = *mstate_ptr;
+	char buf[MOCK_META_SIZE];
+	memcpy(buf, mstate->buf, MOCK_META_SIZE);
+	buf[0] ^= 0xFF;
+
+	/* run test */
+	int mrs_num = 0;
+	int ret = rpma_meta_decode(buf, MOCK_META_SIZE, NULL, &mrs_num, NULL);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+	assert_int_equal(mrs_num, 0);
+}
+
+/*
+ * decode__mrs_num_too_small -- the mrs array is too small
+ */
+static void
+decode__mrs_num_too_small(void **mstate_ptr)
+{
+	struct meta_test_state *mstate = *mstate_ptr;
+
+	/* run test */
+	struct rpma_mr_remote *mrs[MOCK_MRS_NUM];
+	int mrs_num = MOCK_MRS_NUM - 1;
+	int ret = rpma_meta_decode(mstate->buf, MOCK_META_SIZE, mrs, &mrs_num,
+			NULL);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+	assert_int_equal(mrs_num, MOCK_MRS_NUM - 1);
+}
+
+/*
+ * decode__mrs_num_query -- NULL mrs queries the number of memory regions
+ */
+static void
+decode__mrs_num_query(void **mstate_ptr)
+{
+	struct meta_test_state *mstate = *mstate_ptr;
+
+	/* run test */
+	int mrs_num = 0;
+	int ret = rpma_meta_decode(mstate->buf, MOCK_META_SIZE, NULL, &mrs_num,
+			NULL);
+
+	/* verify the results */
+	assert_int_equal(ret, MOCK_OK);
+	assert_int_equal(mrs_num, MOCK_MRS_NUM);
+}
+
+/*
+ * decode__peer_cfg_from_descriptor_ERRNO --
+ * rpma_peer_cfg_from_descriptor() fails with RPMA_E_NOMEM
+ */
+static void
+decode__peer_cfg_from_descriptor_ERRNO(void **mstate_ptr)
+{
+	struct meta_test_state *mstate = *mstate_ptr;
+
+	/* configure mocks */
+	will_return(rpma_peer_cfg_from_descriptor, RPMA_E_NOMEM);
+
+	/* run test */
+	struct rpma_mr_remote *mrs[MOCK_MRS_NUM];
+	struct rpma_peer_cfg *pcfg = NULL;
+	int mrs_num = MOCK_MRS_NUM;
+	int ret = rpma_meta_decode(mstate->buf, MOCK_META_SIZE, mrs, &mrs_num,
+			&pcfg);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_NOMEM);
+	assert_null(pcfg);
+}
+
+/*
+ * decode__mr_remote_from_descriptor_ERRNO --
+ * rpma_mr_remote_from_descriptor() of the second memory region fails with
+ * RPMA_E_NOMEM, so all the already created objects have to be deleted
+ */
+static void
+decode__mr_remote_from_descriptor_ERRNO(void **mstate_ptr)
+{
+	struct meta_test_state *mstate = *mstate_ptr;
+
+	/* configure mocks */
+	will_return(rpma_peer_cfg_from_descriptor, MOCK_OK);
+	expect_value(rpma_mr_remote_from_descriptor, desc_byte,
+			(uintptr_t)MOCK_MR_1 & 0xFF);
+	will_return(rpma_mr_remote_from_descriptor, MOCK_OK);
+	will_return(rpma_mr_remote_from_descriptor, MOCK_MR_REMOTE_1);
+	expect_value(rpma_mr_remote_from_descriptor, desc_byte,
+			(uintptr_t)MOCK_MR_2 & 0xFF);
+	will_return(rpma_mr_remote_from_descriptor, RPMA_E_NOMEM);
+	expect_value(rpma_mr_remote_delete, mr, MOCK_MR_REMOTE_1);
+
+	/* run test */
+	struct rpma_mr_remote *mrs[MOCK_MRS_NUM];
+	struct rpma_peer_cfg *pcfg = NULL;
+	int mrs_num = MOCK_MRS_NUM;
+	int ret = rpma_meta_decode(mstate->buf, MOCK_META_SIZE, mrs, &mrs_num,
+			&pcfg);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_NOMEM);
+	assert_int_equal(mrs_num, MOCK_MRS_NUM);
+	assert_null(pcfg);
+}
+
+/*
+ * decode__success -- happy day scenario
+ */
+static void
+decode__success(void **mstate_ptr)
+{
+	struct meta_test_state *mstate = *mstate_ptr;
+
+	/* configure mocks */
+	will_return(rpma_peer_cfg_from_descriptor, MOCK_OK);
+	expect_value(rpma_mr_remote_from_descriptor, desc_byte,
+			(uintptr_t)MOCK_MR_1 & 0xFF);
+	will_return(rpma_mr_remote_from_descriptor, MOCK_OK);
+	will_return(rpma_mr_remote_from_descriptor, MOCK_MR_REMOTE_1);
+	expect_value(rpma_mr_remote_from_descriptor, desc_byte,
+			(uintptr_t)MOCK_MR_2 & 0xFF);
+	will_return(rpma_mr_remote_from_descriptor, MOCK_OK);
+	will_return(rpma_mr_remote_from_descriptor, MOCK_MR_REMOTE_2);
+
+	/* run test */
+	struct rpma_mr_remote *mrs[MOCK_MRS_NUM + 1] = {NULL};
+	struct rpma_peer_cfg *pcfg = NULL;
+	int mrs_num = MOCK_MRS_NUM + 1;
+	int ret = rpma_meta_decode(mstate->buf, MOCK_META_SIZE, mrs, &mrs_num,
+			&pcfg);
+
+	/* verify the results */
+	assert_int_equal(ret, MOCK_OK);
+	assert_int_equal(mrs_num, MOCK_MRS_NUM);
+	assert_ptr_equal(mrs[0], MOCK_MR_REMOTE_1);
+	assert_ptr_equal(mrs[1], MOCK_MR_REMOTE_2);
+	assert_null(mrs[2]);
+	assert_ptr_equal(pcfg, MOCK_PEER_PCFG);
+}
+
+/*
+ * decode__pcfg_ptr_NULL -- the peer configuration is not decoded if
+ * pcfg_ptr is NULL
+ */
+static void
+decode__pcfg_ptr_NULL(void **mstate_ptr)
+{
+	struct meta_test_state *mstate = *mstate_ptr;
+
+	/* configure mocks */
+	expect_value(rpma_mr_remote_from_descriptor, desc_byte,
+			(uintptr_t)MOCK_MR_1 & 0xFF);
+	will_return(rpma_mr_remote_from_descriptor, MOCK_OK);
+	will_return(rpma_mr_remote_from_descriptor, MOCK_MR_REMOTE_1);
+	expect_value(rpma_mr_remote_from_descriptor, desc_byte,
+			(uintptr_t)MOCK_MR_2 & 0xFF);
+	will_return(rpma_mr_remote_from_descriptor, MOCK_OK);
+	will_return(rpma_mr_remote_from_descriptor, MOCK_MR_REMOTE_2);
+
+	/* run test */
+	struct rpma_mr_remote *mrs[MOCK_MRS_NUM];
+	int mrs_num = MOCK_MRS_NUM;
+	int ret = rpma_meta_decode(mstate->buf, MOCK_META_SIZE, mrs, &mrs_num,
+			NULL);
+
+	/* verify the results */
+	assert_int_equal(ret, MOCK_OK);
+	assert_int_equal(mrs_num, MOCK_MRS_NUM);
+	assert_ptr_equal(mrs[0], MOCK_MR_REMOTE_1);
+	assert_ptr_equal(mrs[1], MOCK_MR_REMOTE_2);
+}
+
+static const struct CMUnitTest test_decode[] = {
+	/* rpma_meta_decode() unit tests */
+	cmocka_unit_test(decode__buf_NULL),
+	cmocka_unit_test_setup_teardown(decode__mrs_num_NULL,
+		setup__meta_new, teardown__meta_delete),
+	cmocka_unit_test_setup_teardown(decode__size_too_small,
+		setup__meta_new, teardown__meta_delete),
+	cmocka_unit_test_setup_teardown(decode__no_header,
+		setup__meta_new, teardown__meta_delete),
+	cmocka_unit_test_setup_teardown(decode__magic_invalid,
+		setup__meta_new, teardown__meta_delete),
+	cmocka_unit_test_setup_teardown(decode__mrs_num_too_small,
+		setup__meta_new, teardown__meta_delete),
+	cmocka_unit_test_setup_teardown(decode__mrs_num_query,
+		setup__meta_new, teardown__meta_delete),
+	cmocka_unit_test_setup_teardown(
+		decode__peer_cfg_from_descriptor_ERRNO,
+		setup__meta_new, teardown__meta_delete),
+	cmocka_unit_test_setup_teardown(
+		decode__mr_remote_from_descriptor_ERRNO,
+		setup__meta_new, teardown__meta_delete),
+	cmocka_unit_test_setup_teardown(decode__success,
+		setup__meta_new, teardown__meta_delete),
+	cmocka_unit_test_setup_teardown(decode__pcfg_ptr_NULL,
+		setup__meta_new, teardown__meta_delete),
+	cmocka_unit_test(NULL)
+};
+
+int
+main(int argc, char *argv[])
+{
+	return cmocka_run_group_tests(test_decode, NULL, NULL);
+}
@@ -0,0 +1,129 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * meta-descriptor.c -- the metadata descriptor unit tests
+ *
+ * APIs covered:
+ * - rpma_meta_get_descriptor_size()
+ * - rpma_meta_get_descriptor()
+ */
+
+#include "librpma.h"
+#include "meta-common.h"
+
+/*
+ * get_desc_size__meta_NULL -- NULL meta is invalid
+ */
+static void
+get_desc_size__meta_NULL(void **unused)
+{
+	/* run test */
+	size_t desc_size;
+	int ret = rpma_meta_get_descriptor_size(NULL, &desc_size);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+}
+
+/*
+ * get_desc_size__desc_size_NULL -- NULL desc_size is invalid
+ */
+static void
+get_desc_size__desc_size_NULL(void **mstate_ptr)
+{
+	struct meta_test_state *mstate = *mstate_ptr;
+
+	/* run test */
+	int ret = rpma_meta_get_descriptor_size(mstate->meta, NULL);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+}
+
+/*
+ * get_desc_size__success -- happy day scenario
+ */
+static void
+get_desc_size__success(void **mstate_ptr)
+{
+	struct meta_test_state *mstate = *mstate_ptr;
+
+	/* run test */
+	size_t desc_size = 0;
+	int ret = rpma_meta_get_descriptor_size(mstate->meta, &desc_size);
+
+	/* verify the results */
+	assert_int_equal(ret, MOCK_OK);
+	assert_int_equal(desc_size, MOCK_META_DESC_SIZE);
+}
+
+/*
+ * get_desc__meta_NULL -- NULL meta is invalid
+ */
+static void
+get_desc__meta_NULL(void **unused)
+{
+	/* run test */
+	char desc[MOCK_META_DESC_SIZE];
+	int ret = rpma_meta_get_descriptor(NULL, desc);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+}
+
+/*
+ * get_desc__desc_NULL -- NULL desc is invalid
+ */
+static void
+get_desc__desc_NULL(void **mstate_ptr)
+{
+	struct meta_test_state *mstate = *mstate_ptr;
+
+	/* run test */
+	int ret = rpma_meta_get_descriptor(mstate->meta, NULL);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+}
+
+/*
+ * get_desc__success -- the descriptor of the metadata is the descriptor
+ * of its registered buffer
+ */
+static void
+get_desc__success(void **mstate_ptr)
+{
+	struct meta_test_state *mstate = *mstate_ptr;
+
+	/* run test */
+	char desc[MOCK_META_DESC_SIZE] = {0};
+	int ret = rpma_meta_get_descriptor(mstate->meta, desc);
+
+	/* verify the results */
+	assert_int_equal(ret, MOCK_OK);
+	assert_int_equal((uint8_t)desc[0], (uintptr_t)MOCK_META_MR & 0xFF);
+}
+
+static const struct CMUnitTest test_descriptor[] = {
+	/* rpma_meta_get_descriptor_size() unit tests */
+	cmocka_unit_test(get_desc_size__meta_NULL),
+	cmocka_unit_test_setup_teardown(get_desc_size__desc_size_NULL,
+		setup__meta_new, teardown__meta_delete),
+	cmocka_unit_test_setup_teardown(get_desc_size__success,
+		setup__meta_new, teardown__meta_delete),
+
+	/* rpma_meta_get_descriptor() unit tests */
+	cmocka_unit_test(get_desc__meta_NULL),
+	cmocka_unit_test_setup_teardown(get_desc__desc_NULL,
+		setup__meta_new, teardown__meta_delete),
+	cmocka_unit_test_setup_teardown(get_desc__success,
+		setup__meta_new, teardown__meta_delete),
+	cmocka_unit_test(NULL)
+};
+
+int
+main(int argc, char *argv[])
+{
+	return cmocka_run_group_tests(test_descriptor, NULL, NULL);
+}
@@ -0,0 +1,286 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * meta-new.c -- the rpma_meta_new() and rpma_meta_delete() unit tests
+ *
+ * APIs covered:
+ * - rpma_meta_new()
+ * - rpma_meta_delete()
+ */
+
+#include "librpma.h"
+#include "meta-common.h"
+
+/*
+ * new__peer_NULL -- NULL peer is invalid
+ */
+static void
+new__peer_NULL(void **unused)
+{
+	/* run test */
+	struct rpma_meta *meta = NULL;
+	int ret = rpma_meta_new(NULL, Mock_mrs, MOCK_MRS_NUM, MOCK_PEER_PCFG,
+			&meta);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+	assert_null(meta);
+}
+
+/*
+ * new__meta_ptr_NULL -- NULL meta_ptr is invalid
+ */
+static void
+new__meta_ptr_NULL(void **unused)
+{
+	/* run test */
+	int ret = rpma_meta_new(MOCK_PEER, Mock_mrs, MOCK_MRS_NUM,
+			MOCK_PEER_PCFG, NULL);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+}
+
+/*
+ * new__mrs_num_negative -- negative mrs_num is invalid
+ */
+static void
+new__mrs_num_negative(void **unused)
+{
+	/* run test */
+	struct rpma_meta *meta = NULL;
+	int ret = rpma_meta_new(MOCK_PEER, Mock_mrs, -1, MOCK_PEER_PCFG,
+			&meta);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+	assert_null(meta);
+}
+
+/*
+ * new__mrs_NULL -- NULL mrs is invalid if mrs_num > 0
+ */
+static void
+new__mrs_NULL(void **unused)
+{
+	/* run test */
+	struct rpma_meta *meta = NULL;
+	int ret = rpma_meta_new(MOCK_PEER, NULL, MOCK_MRS_NUM, MOCK_PEER_PCFG,
+			&meta);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+	assert_null(meta);
+}
+
+/*
+ * new__mr_NULL -- NULL element of mrs is invalid
+ */
+static void
+new__mr_NULL(void **unused)
+{
+	struct rpma_mr_local *const mrs[] = {MOCK_MR_1, NULL};
+
+	/* run test */
+	struct rpma_meta *meta = NULL;
+	int ret = rpma_meta_new(MOCK_PEER, mrs, 2, MOCK_PEER_PCFG, &meta);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+	assert_null(meta);
+}
+
+/*
+ * new__empty -- no memory regions and no peer configuration is invalid
+ */
+static void
+new__empty(void **unused)
+{
+	/* run test */
+	struct rpma_meta *meta = NULL;
+	int ret = rpma_meta_new(MOCK_PEER, NULL, 0, NULL, &meta);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+	assert_null(meta);
+}
+
+/*
+ * new__malloc_ERRNO -- malloc() of the object fails with MOCK_ERRNO
+ */
+static void
+new__malloc_ERRNO(void **unused)
+{
+	/* configure mocks */
+	will_return(__wrap__test_malloc, MOCK_ERRNO);
+
+	/* run test */
+	struct rpma_meta *meta = NULL;
+	int ret = rpma_meta_new(MOCK_PEER, Mock_mrs, MOCK_MRS_NUM,
+			MOCK_PEER_PCFG, &meta);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_NOMEM);
+	assert_null(meta);
+}
+
+/*
+ * new__malloc_buf_ERRNO -- malloc() of the buffer fails with MOCK_ERRNO
+ */
+static void
+new__malloc_buf_ERRNO(void **unused)
+{
+	/* configure mocks */
+	will_return(__wrap__test_malloc, MOCK_OK);
+	will_return(__wrap__test_malloc, MOCK_ERRNO);
+
+	/* run test */
+	struct rpma_meta *meta = NULL;
+	int ret = rpma_meta_new(MOCK_PEER, Mock_mrs, MOCK_MRS_NUM,
+			MOCK_PEER_PCFG, &meta);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_NOMEM);
+	assert_null(meta);
+}
+
+/*
+ * new__mr_reg_ERRNO -- rpma_mr_reg() fails with RPMA_E_PROVIDER
+ */
+static void
+new__mr_reg_ERRNO(void **unused)
+{
+	/* configure mocks */
+	will_return(__wrap__test_malloc, MOCK_OK);
+	will_return(__wrap__test_malloc, MOCK_OK);
+	expect_value(rpma_mr_reg, peer, MOCK_PEER);
+	expect_value(rpma_mr_reg, size, MOCK_META_SIZE);
+	expect_value(rpma_mr_reg, usage, RPMA_MR_USAGE_READ_SRC);
+	will_return(rpma_mr_reg, RPMA_E_PROVIDER);
+
+	/* run test */
+	struct rpma_meta *meta = NULL;
+	int ret = rpma_meta_new(MOCK_PEER, Mock_mrs, MOCK_MRS_NUM,
+			MOCK_PEER_PCFG, &meta);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_PROVIDER);
+	assert_null(meta);
+}
+
+/*
+ * new__pcfg_only -- the metadata of only a peer configuration
+ */
+static void
+new__pcfg_only(void **unused)
+{
+	/* configure mocks */
+	will_return(__wrap__test_malloc, MOCK_OK);
+	will_return(__wrap__test_malloc, MOCK_OK);
+	expect_value(rpma_mr_reg, peer, MOCK_PEER);
+	expect_value(rpma_mr_reg, size,
+			MOCK_META_SIZE - MOCK_MRS_NUM * MOCK_MR_DESC_SIZE);
+	expect_value(rpma_mr_reg, usage, RPMA_MR_USAGE_READ_SRC);
+	will_return(rpma_mr_reg, MOCK_OK);
+	will_return(rpma_mr_dereg, MOCK_OK);
+
+	/* run test */
+	struct rpma_meta *meta = NULL;
+	int ret = rpma_meta_new(MOCK_PEER, NULL, 0, MOCK_PEER_PCFG, &meta);
+
+	/* verify the results */
+	assert_int_equal(ret, MOCK_OK);
+	assert_non_null(meta);
+
+	ret = rpma_meta_delete(&meta);
+	assert_int_equal(ret, MOCK_OK);
+	assert_null(meta);
+}
+
+/*
+ * delete__meta_ptr_NULL -- NULL meta_ptr is invalid
+ */
+static void
+delete__meta_ptr_NULL(void **unused)
+{
+	/* run test */
+	int ret = rpma_meta_delete(NULL);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+}
+
+/*
+ * delete__meta_NULL -- NULL *meta_ptr should exit quickly
+ */
+static void
+delete__meta_NULL(void **unused)
+{
+	/* run test */
+	struct rpma_meta *meta = NULL;
+	int ret = rpma_meta_delete(&meta);
+
+	/* verify the results */
+	assert_int_equal(ret, MOCK_OK);
+	assert_null(meta);
+}
+
+/*
+ * delete__mr_dereg_ERRNO -- rpma_mr_dereg() fails with RPMA_E_PROVIDER
+ */
+static void
+delete__mr_dereg_ERRNO(void **unused)
+{
+	struct meta_test_state *mstate;
+	assert_int_equal(setup__meta_new((void **)&mstate), 0);
+
+	/* configure mocks */
+	will_return(rpma_mr_dereg, RPMA_E_PROVIDER);
+
+	/* run test */
+	int ret = rpma_meta_delete(&mstate->meta);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_PROVIDER);
+	assert_null(mstate->meta);
+}
+
+/*
+ * new__lifecycle -- happy day scenario
+ */
+static void
+new__lifecycle(void **mstate_ptr)
+{
+	/* the thing is done by setup__meta_new() and teardown__meta_delete() */
+}
+
+static const struct CMUnitTest test_new[] = {
+	/* rpma_meta_new() unit tests */
+	cmocka_unit_test(new__peer_NULL),
+	cmocka_unit_test(new__meta_ptr_NULL),
+	cmocka_unit_test(new__mrs_num_negative),
+	cmocka_unit_test(new__mrs_NULL),
+	cmocka_unit_test(new__mr_NULL),
+	cmocka_unit_test(new__empty),
+	cmocka_unit_test(new__malloc_ERRNO),
+	cmocka_unit_test(new__malloc_buf_ERRNO),
+	cmocka_unit_test(new__mr_reg_ERRNO),
+	cmocka_unit_test(new__pcfg_only),
+
+	/* rpma_meta_delete() unit tests */
+	cmocka_unit_test(delete__meta_ptr_NULL),
+	cmocka_unit_test(delete__meta_NULL),
+	cmocka_unit_test(delete__mr_dereg_ERRNO),
+
+	/* rpma_meta_new()/_delete() lifecycle */
+	cmocka_unit_test_setup_teardown(new__lifecycle,
+		setup__meta_new, teardown__meta_delete),
+	cmocka_unit_test(NULL)
+};
+
+int
+main(int argc, char *argv[])
+{
+	return cmocka_run_group_tests(test_new, NULL, NULL);
+}
@@ -433,6 +433,12 @@ static struct prestate prestate =
 		{RPMA_MR_USAGE_READ_SRC | RPMA_MR_USAGE_FLUSH_TYPE_PERSISTENT,
 		IBV_ACCESS_REMOTE_READ, NULL};
 
+/* RPMA_MR_USAGE_MW_BIND is a local-only usage not present in descriptors */
+static struct prestate prestate_mw_bind =
+		{RPMA_MR_USAGE_READ_SRC | RPMA_MR_USAGE_FLUSH_TYPE_PERSISTENT |
+		RPMA_MR_USAGE_MW_BIND,
+		IBV_ACCESS_REMOTE_READ | IBV_ACCESS_MW_BIND, NULL};
+
 static const struct CMUnitTest tests_descriptor[] = {
 	/* rpma_mr_get_descriptor_size() unit test */
 	cmocka_unit_test(get_descriptor_size__mr_NULL),
@@ -487,6 +493,9 @@ static const struct CMUnitTest tests_descriptor[] = {
 		setup__reg_success, teardown__dereg_success,
 		&prestate),
 	cmocka_unit_test(remote_from_descriptor__desc_alignment),
+	{ "get_descriptor__usage_MW_BIND", get_descriptor__desc_alignment,
+		setup__reg_success, teardown__dereg_success,
+		&prestate_mw_bind},
 	cmocka_unit_test(NULL)
 };
 
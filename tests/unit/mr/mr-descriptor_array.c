@@ -0,0 +1,615 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * mr-descriptor_array.c -- the tables of memory region descriptors unit tests
+ *
+ * APIs covered:
+ * - rpma_mr_get_descriptors()
+ * - rpma_mr_remote_array_from_descriptors()
+ * - rpma_mr_remote_array_delete()
+ * - rpma_mr_remote_array_get_count()
+ * - rpma_mr_remote_array_get()
+ * - rpma_mr_remote_array_find()
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <infiniband/verbs.h>
+
+#include "mocks-rpma-peer.h"
+#include "mr-common.h"
+#include "test-common.h"
+
+#define MOCK_LOW_RADDR		(uint64_t)0x1000
+#define MOCK_LOW_SIZE		(size_t)0x1000
+
+/*
+ * a descriptor of a memory region placed below the one of Desc_exp_pmem
+ * (raddr == MOCK_LOW_RADDR, size == MOCK_LOW_SIZE)
+ */
+static const char Desc_exp_low[] = {
+	0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x13, 0x12, 0x11, 0x10,
+	0x11};
+
+/*
+ * a table of descriptors in a not sorted order:
+ * [0] - Desc_exp_pmem
+ * [1] - Desc_exp_low
+ */
+static char Desc_table[2 * MR_DESC_SIZE];
+
+/* rpma_mr_get_descriptors() unit test */
+
+/*
+ * get_descriptors__mrs_NULL - NULL mrs is invalid
+ */
+static void
+get_descriptors__mrs_NULL(void **unused)
+{
+	char desc[MR_DESC_SIZE];
+
+	/* run test */
+	int ret = rpma_mr_get_descriptors(NULL, 1, desc);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+}
+
+/*
+ * get_descriptors__mrs_num_0 - mrs_num == 0 is invalid
+ */
+static void
+get_descriptors__mrs_num_0(void **pprestate)
+{
+	struct prestate *prestate = *pprestate;
+	struct rpma_mr_local *mrs[] = {prestate->mr};
+	char desc[MR_DESC_SIZE];
+
+	/* run test */
+	int ret = rpma_mr_get_descriptors(mrs, 0, desc);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+}
+
+/*
+ * get_descriptors__mr_NULL - NULL element of mrs is invalid
+ */
+static void
+get_descriptors__mr_NULL(void **pprestate)
+{
+	struct prestate *prestate = *pprestate;
+	struct rpma_mr_local *mrs[] = {prestate->mr, NULL};
+	char desc[2 * MR_DESC_SIZE];
+
+	/* run test */
+	int ret = rpma_mr_get_descriptors(mrs, 2, desc);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+}
+
+/*
+ * get_descriptors__desc_NULL - NULL desc is invalid
+ */
+static void
+get_descriptors__desc_NULL(void **pprestate)
+{
+	struct prestate *prestate = *pprestate;
+	struct rpma_mr_local *mrs[] = {prestate->mr};
+
+	/* run test */
+	int ret = rpma_mr_get_descriptors(mrs, 1, NULL);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+}
+
+/*
+ * get_descriptors__success - the table consists of the descriptors
+ * of all the memory regions
+ */
+static void
+get_descriptors__success(void **pprestate)
+{
+	struct prestate *prestate = *pprestate;
+	struct rpma_mr_local *mrs[] = {prestate->mr, prestate->mr};
+	char desc[2 * MR_DESC_SIZE];
+
+	/* run test */
+	int ret = rpma_mr_get_descriptors(mrs, 2, desc);
+
+	/* verify the results */
+	assert_int_equal(ret, MOCK_OK);
+	assert_memory_equal(desc, Desc_exp_pmem, MR_DESC_SIZE);
+	assert_memory_equal(desc + MR_DESC_SIZE, Desc_exp_pmem, MR_DESC_SIZE);
+}
+
+/* rpma_mr_remote_array_from_descriptors() unit test */
+
+/*
+ * remote_array_from_descriptors__desc_NULL - NULL desc is invalid
+ */
+static void
+remote_array_from_descriptors__desc_NULL(void **unused)
+{
+	/* run test */
+	struct rpma_mr_remote_array *array = NULL;
+	int ret = rpma_mr_remote_array_from_descriptors(NULL,
+			sizeof(Desc_table), &array);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+	assert_null(array);
+}
+
+/*
+ * remote_array_from_descriptors__array_ptr_NULL - NULL array_ptr is invalid
+ */
+static void
+remote_array_from_descriptors__array_ptr_NULL(void **unused)
+{
+	/* run test */
+	int ret = rpma_mr_remote_array_from_descriptors(Desc_table,
+			sizeof(Desc_table), NULL);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+}
+
+/*
+ * remote_array_from_descriptors__invalid_desc_size - desc_size has to be
+ * a non-zero multiple of the size of a descriptor
+ */
+static void
+remote_array_from_descriptors__invalid_desc_size(void **unused)
+{
+	size_t desc_sizes[] = {0, INVALID_MR_DESC_SIZE, MR_DESC_SIZE + 1,
+			sizeof(Desc_table) - 1};
+
+	for (int i = 0; i < (int)(sizeof(desc_sizes) / sizeof(size_t)); ++i) {
+		/* run test */
+		struct rpma_mr_remote_array *array = NULL;
+		int ret = rpma_mr_remote_array_from_descriptors(Desc_table,
+				desc_sizes[i], &array);
+
+		/* verify the results */
+		assert_int_equal(ret, RPMA_E_INVAL);
+		assert_null(array);
+	}
+}
+
+/*
+ * remote_array_from_descriptors__malloc_ERRNO - malloc() fails with MOCK_ERRNO
+ */
+static void
+remote_array_from_descriptors__malloc_ERRNO(void **unused)
+{
+	/* configure mock */
+	will_return(__wrap__test_malloc, MOCK_ERRNO);
+
+	/* run test */
+	struct rpma_mr_remote_array *array = NULL;
+	int ret = rpma_mr_remote_array_from_descriptors(Desc_table,
+			sizeof(Desc_table), &array);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_NOMEM);
+	assert_null(array);
+}
+
+/*
+ * remote_array_from_descriptors__buff_usage_equal_zero - a descriptor
+ * with no usage set makes the whole table invalid
+ */
+static void
+remote_array_from_descriptors__buff_usage_equal_zero(void **unused)
+{
+	char desc_invalid[2 * MR_DESC_SIZE];
+	memcpy(desc_invalid, Desc_table, sizeof(desc_invalid));
+
+	/* set usage of the second descriptor to 0 */
+	desc_invalid[2 * MR_DESC_SIZE - 1] = 0;
+
+	/* configure mock */
+	will_return(__wrap__test_malloc, MOCK_OK);
+
+	/* run test */
+	struct rpma_mr_remote_array *array = NULL;
+	int ret = rpma_mr_remote_array_from_descriptors(desc_invalid,
+			sizeof(desc_invalid), &array);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+	assert_null(array);
+}
+
+/* rpma_mr_remote_array_delete() unit test */
+
+/*
+ * remote_array_delete__array_ptr_NULL - NULL array_ptr is invalid
+ */
+static void
+remote_array_delete__array_ptr_NULL(void **unused)
+{
+	/* run test */
+	int ret = rpma_mr_remote_array_delete(NULL);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+}
+
+/*
+ * remote_array_delete__array_NULL - NULL *array_ptr should exit quickly
+ */
+static void
+remote_array_delete__array_NULL(void **unused)
+{
+	/* run test */
+	struct rpma_mr_remote_array *array = NULL;
+	int ret = rpma_mr_remote_array_delete(&array);
+
+	/* verify the results */
+	assert_int_equal(ret, MOCK_OK);
+	assert_null(array);
+}
+
+/*
+ * setup__remote_array -- create an array of remote memory regions based
+ * on the pre-prepared table of descriptors
+ */
+static int
+setup__remote_array(void **array_ptr)
+{
+	/* configure mock */
+	will_return(__wrap__test_malloc, MOCK_OK);
+
+	/* create an array based on the pre-prepared table */
+	struct rpma_mr_remote_array *array = NULL;
+	int ret = rpma_mr_remote_array_from_descriptors(Desc_table,
+			sizeof(Desc_table), &array);
+
+	/* verify the results */
+	assert_int_equal(ret, MOCK_OK);
+	assert_non_null(array);
+
+	*array_ptr = array;
+
+	return 0;
+}
+
+/*
+ * teardown__remote_array -- delete the array of remote memory regions
+ */
+static int
+teardown__remote_array(void **array_ptr)
+{
+	struct rpma_mr_remote_array *array = *array_ptr;
+
+	/* delete the array */
+	int ret = rpma_mr_remote_array_delete(&array);
+	assert_int_equal(ret, MOCK_OK);
+	assert_null(array);
+
+	*array_ptr = NULL;
+
+	return 0;
+}
+
+/* rpma_mr_remote_array_get_count() unit test */
+
+/*
+ * remote_array_get_count__array_NULL - NULL array is invalid
+ */
+static void
+remote_array_get_count__array_NULL(void **unused)
+{
+	/* run test */
+	int count = 0;
+	int ret = rpma_mr_remote_array_get_count(NULL, &count);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+}
+
+/*
+ * remote_array_get_count__count_NULL - NULL count is invalid
+ */
+static void
+remote_array_get_count__count_NULL(void **array_ptr)
+{
+	/* run test */
+	int ret = rpma_mr_remote_array_get_count(*array_ptr, NULL);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+}
+
+/*
+ * remote_array_get_count__success - happy day scenario
+ */
+static void
+remote_array_get_count__success(void **array_ptr)
+{
+	/* run test */
+	int count = 0;
+	int ret = rpma_mr_remote_array_get_count(*array_ptr, &count);
+
+	/* verify the results */
+	assert_int_equal(ret, MOCK_OK);
+	assert_int_equal(count, 2);
+}
+
+/* rpma_mr_remote_array_get() unit test */
+
+/*
+ * remote_array_get__idx_out_of_range - idx has to be in the range of
+ * <0, count)
+ */
+static void
+remote_array_get__idx_out_of_range(void **array_ptr)
+{
+	int idxs[] = {-1, 2};
+
+	for (int i = 0; i < 2; ++i) {
+		/* run test */
+		struct rpma_mr_remote *mr = NULL;
+		int ret = rpma_mr_remote_array_get(*array_ptr, idxs[i], &mr);
+
+		/* verify the results */
+		assert_int_equal(ret, RPMA_E_INVAL);
+		assert_null(mr);
+	}
+}
+
+/*
+ * remote_array_get__success - the memory regions are kept in the order
+ * of the table of descriptors
+ */
+static void
+remote_array_get__success(void **array_ptr)
+{
+	struct rpma_mr_remote *mr = NULL;
+	size_t size = 0;
+	int flush_type = 0;
+
+	/* run test */
+	int ret = rpma_mr_remote_array_get(*array_ptr, 0, &mr);
+
+	/* verify the results */
+	assert_int_equal(ret, MOCK_OK);
+	assert_int_equal(rpma_mr_remote_get_size(mr, &size), MOCK_OK);
+	assert_int_equal(size, MOCK_SIZE);
+	assert_int_equal(rpma_mr_remote_get_flush_type(mr, &flush_type),
+			MOCK_OK);
+	assert_int_equal(flush_type, RPMA_MR_USAGE_FLUSH_TYPE_PERSISTENT);
+
+	/* run test */
+	ret = rpma_mr_remote_array_get(*array_ptr, 1, &mr);
+
+	/* verify the results */
+	assert_int_equal(ret, MOCK_OK);
+	assert_int_equal(rpma_mr_remote_get_size(mr, &size), MOCK_OK);
+	assert_int_equal(size, MOCK_LOW_SIZE);
+	assert_int_equal(rpma_mr_remote_get_flush_type(mr, &flush_type),
+			MOCK_OK);
+	assert_int_equal(flush_type, RPMA_MR_USAGE_FLUSH_TYPE_VISIBILITY);
+}
+
+/*
+ * remote_array_get__remote_delete - a memory region of an array cannot be
+ * deleted on its own
+ */
+static void
+remote_array_get__remote_delete(void **array_ptr)
+{
+	struct rpma_mr_remote *mr = NULL;
+	int ret = rpma_mr_remote_array_get(*array_ptr, 0, &mr);
+	assert_int_equal(ret, MOCK_OK);
+
+	/* run test */
+	ret = rpma_mr_remote_delete(&mr);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+	assert_non_null(mr);
+}
+
+/* rpma_mr_remote_array_find() unit test */
+
+/*
+ * remote_array_find__array_NULL - NULL array is invalid
+ */
+static void
+remote_array_find__array_NULL(void **unused)
+{
+	/* run test */
+	struct rpma_mr_remote *mr = NULL;
+	size_t offset = 0;
+	int ret = rpma_mr_remote_array_find(NULL, MOCK_LOW_RADDR, MOCK_LEN,
+			&mr, &offset);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+	assert_null(mr);
+}
+
+/*
+ * remote_array_find__mr_ptr_NULL_offset_NULL - NULL mr_ptr and NULL offset
+ * are invalid
+ */
+static void
+remote_array_find__mr_ptr_NULL_offset_NULL(void **array_ptr)
+{
+	size_t offset = 0;
+	struct rpma_mr_remote *mr = NULL;
+
+	/* run test */
+	int ret = rpma_mr_remote_array_find(*array_ptr, MOCK_LOW_RADDR, 1,
+			NULL, &offset);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+
+	/* run test */
+	ret = rpma_mr_remote_array_find(*array_ptr, MOCK_LOW_RADDR, 1,
+			&mr, NULL);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+	assert_null(mr);
+}
+
+/*
+ * remote_array_find__success - find the memory regions containing
+ * the given ranges
+ */
+static void
+remote_array_find__success(void **array_ptr)
+{
+	struct rpma_mr_remote *mr_exp = NULL;
+	struct rpma_mr_remote *mr = NULL;
+	size_t offset = 0;
+
+	/* the beginning of the lower memory region */
+	int ret = rpma_mr_remote_array_get(*array_ptr, 1, &mr_exp);
+	assert_int_equal(ret, MOCK_OK);
+
+	/* run test */
+	ret = rpma_mr_remote_array_find(*array_ptr, MOCK_LOW_RADDR,
+			MOCK_LOW_SIZE, &mr, &offset);
+
+	/* verify the results */
+	assert_int_equal(ret, MOCK_OK);
+	assert_ptr_equal(mr, mr_exp);
+	assert_int_equal(offset, 0);
+
+	/* the middle of the higher memory region */
+	ret = rpma_mr_remote_array_get(*array_ptr, 0, &mr_exp);
+	assert_int_equal(ret, MOCK_OK);
+
+	/* run test */
+	ret = rpma_mr_remote_array_find(*array_ptr,
+			MOCK_RADDR + MOCK_DST_OFFSET, MOCK_LEN, &mr, &offset);
+
+	/* verify the results */
+	assert_int_equal(ret, MOCK_OK);
+	assert_ptr_equal(mr, mr_exp);
+	assert_int_equal(offset, MOCK_DST_OFFSET);
+}
+
+/*
+ * remote_array_find__not_found - the ranges which are not contained
+ * in any of the memory regions
+ */
+static void
+remote_array_find__not_found(void **array_ptr)
+{
+	struct {
+		uint64_t raddr;
+		size_t len;
+	} ranges[] = {
+		/* below all the memory regions */
+		{MOCK_LOW_RADDR - 1, 1},
+		/* crossing the end of the lower memory region */
+		{MOCK_LOW_RADDR + MOCK_LOW_SIZE - 1, 2},
+		/* in the gap between the memory regions */
+		{MOCK_LOW_RADDR + MOCK_LOW_SIZE, 1},
+		/* above all the memory regions */
+		{MOCK_RADDR + MOCK_SIZE, 1},
+		/* zero length right past the end of the memory regions */
+		{MOCK_LOW_RADDR + MOCK_LOW_SIZE, 0},
+		{MOCK_RADDR + MOCK_SIZE, 0},
+	};
+
+	for (int i = 0; i < (int)(sizeof(ranges) / sizeof(ranges[0])); ++i) {
+		/* run test */
+		struct rpma_mr_remote *mr = NULL;
+		size_t offset = 0;
+		int ret = rpma_mr_remote_array_find(*array_ptr, ranges[i].raddr,
+				ranges[i].len, &mr, &offset);
+
+		/* verify the results */
+		assert_int_equal(ret, RPMA_E_INVAL);
+		assert_null(mr);
+	}
+}
+
+static struct prestate prestate =
+		{RPMA_MR_USAGE_READ_SRC | RPMA_MR_USAGE_FLUSH_TYPE_PERSISTENT,
+		IBV_ACCESS_REMOTE_READ, NULL};
+
+static const struct CMUnitTest tests_descriptor_array[] = {
+	/* rpma_mr_get_descriptors() unit test */
+	cmocka_unit_test(get_descriptors__mrs_NULL),
+	cmocka_unit_test_prestate_setup_teardown(
+		get_descriptors__mrs_num_0,
+		setup__reg_success,
+		teardown__dereg_success,
+		&prestate),
+	cmocka_unit_test_prestate_setup_teardown(
+		get_descriptors__mr_NULL,
+		setup__reg_success,
+		teardown__dereg_success,
+		&prestate),
+	cmocka_unit_test_prestate_setup_teardown(
+		get_descriptors__desc_NULL,
+		setup__reg_success,
+		teardown__dereg_success,
+		&prestate),
+	cmocka_unit_test_prestate_setup_teardown(
+		get_descriptors__success,
+		setup__reg_success,
+		teardown__dereg_success,
+		&prestate),
+
+	/* rpma_mr_remote_array_from_descriptors() unit test */
+	cmocka_unit_test(remote_array_from_descriptors__desc_NULL),
+	cmocka_unit_test(remote_array_from_descriptors__array_ptr_NULL),
+	cmocka_unit_test(remote_array_from_descriptors__invalid_desc_size),
+	cmocka_unit_test(remote_array_from_descriptors__malloc_ERRNO),
+	cmocka_unit_test(
+		remote_array_from_descriptors__buff_usage_equal_zero),
+
+	/* rpma_mr_remote_array_delete() unit test */
+	cmocka_unit_test(remote_array_delete__array_ptr_NULL),
+	cmocka_unit_test(remote_array_delete__array_NULL),
+
+	/* rpma_mr_remote_array_get_count() unit test */
+	cmocka_unit_test(remote_array_get_count__array_NULL),
+	cmocka_unit_test_setup_teardown(remote_array_get_count__count_NULL,
+		setup__remote_array, teardown__remote_array),
+	cmocka_unit_test_setup_teardown(remote_array_get_count__success,
+		setup__remote_array, teardown__remote_array),
+
+	/* rpma_mr_remote_array_get() unit test */
+	cmocka_unit_test_setup_teardown(remote_array_get__idx_out_of_range,
+		setup__remote_array, teardown__remote_array),
+	cmocka_unit_test_setup_teardown(remote_array_get__success,
+		setup__remote_array, teardown__remote_array),
+	cmocka_unit_test_setup_teardown(remote_array_get__remote_delete,
+		setup__remote_array, teardown__remote_array),
+
+	/* rpma_mr_remote_array_find() unit test */
+	cmocka_unit_test(remote_array_find__array_NULL),
+	cmocka_unit_test_setup_teardown(
+		remote_array_find__mr_ptr_NULL_offset_NULL,
+		setup__remote_array, teardown__remote_array),
+	cmocka_unit_test_setup_teardown(remote_array_find__success,
+		setup__remote_array, teardown__remote_array),
+	cmocka_unit_test_setup_teardown(remote_array_find__not_found,
+		setup__remote_array, teardown__remote_array),
+	cmocka_unit_test(NULL)
+};
+
+int
+main(int argc, char *argv[])
+{
+	memcpy(Desc_table, Desc_exp_pmem, MR_DESC_SIZE);
+	memcpy(Desc_table + MR_DESC_SIZE, Desc_exp_low, MR_DESC_SIZE);
+
+	return cmocka_run_group_tests(tests_descriptor_array, NULL, NULL);
+}
@@ -0,0 +1,304 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * mw-bind.c -- the memory window bind/invalidate unit tests
+ *
+ * APIs covered:
+ * - rpma_mw_bind()
+ * - rpma_mw_invalidate()
+ */
+
+#include "mr.h"
+#include "mw.h"
+#include "mw-common.h"
+
+/*
+ * bind__already_bound -- binding the bound memory window is invalid
+ */
+static void
+bind__already_bound(void **mw_ptr)
+{
+	struct rpma_mw *mw = *mw_ptr;
+
+	/* configure mocks */
+	will_return(rpma_mr_get_usage, MOCK_MR_USAGE);
+
+	/* run test */
+	int ret = rpma_mw_bind(MOCK_QP, mw, MOCK_RPMA_MR_LOCAL,
+			MOCK_MW_OFFSET, MOCK_MW_LEN, MOCK_MW_USAGE,
+			RPMA_F_COMPLETION_ALWAYS, MOCK_OP_CONTEXT);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+}
+
+/*
+ * bind__mr_usage_no_MW_BIND -- the memory region registered without
+ * RPMA_MR_USAGE_MW_BIND cannot be used for binding
+ */
+static void
+bind__mr_usage_no_MW_BIND(void **mw_ptr)
+{
+	struct rpma_mw *mw = *mw_ptr;
+
+	/* configure mocks */
+	will_return(rpma_mr_get_usage,
+		MOCK_MR_USAGE & ~RPMA_MR_USAGE_MW_BIND);
+
+	/* run test */
+	int ret = rpma_mw_bind(MOCK_QP, mw, MOCK_RPMA_MR_LOCAL,
+			MOCK_MW_OFFSET, MOCK_MW_LEN, MOCK_MW_USAGE,
+			RPMA_F_COMPLETION_ALWAYS, MOCK_OP_CONTEXT);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+}
+
+/*
+ * bind__usage_invalid -- the usage which cannot be granted by
+ * the memory window is invalid
+ */
+static void
+bind__usage_invalid(void **mw_ptr)
+{
+	struct rpma_mw *mw = *mw_ptr;
+	int usages[] = {
+		0,
+		RPMA_MR_USAGE_SEND,
+		RPMA_MR_USAGE_READ_SRC | RPMA_MR_USAGE_READ_DST,
+		RPMA_MR_USAGE_FLUSH_TYPE_PERSISTENT,
+	};
+
+	for (int i = 0; i < sizeof(usages) / sizeof(usages[0]); ++i) {
+		/* configure mocks */
+		will_return(rpma_mr_get_usage, MOCK_MR_USAGE);
+
+		/* run test */
+		int ret = rpma_mw_bind(MOCK_QP, mw, MOCK_RPMA_MR_LOCAL,
+				MOCK_MW_OFFSET, MOCK_MW_LEN, usages[i],
+				RPMA_F_COMPLETION_ALWAYS, MOCK_OP_CONTEXT);
+
+		/* verify the results */
+		assert_int_equal(ret, RPMA_E_INVAL);
+	}
+}
+
+/*
+ * bind__usage_not_allowed_by_mr -- the usage not allowed by the memory
+ * region cannot be granted by the memory window
+ */
+static void
+bind__usage_not_allowed_by_mr(void **mw_ptr)
+{
+	struct rpma_mw *mw = *mw_ptr;
+
+	/* configure mocks */
+	will_return(rpma_mr_get_usage,
+		RPMA_MR_USAGE_READ_SRC | RPMA_MR_USAGE_MW_BIND);
+
+	/* run test */
+	int ret = rpma_mw_bind(MOCK_QP, mw, MOCK_RPMA_MR_LOCAL,
+			MOCK_MW_OFFSET, MOCK_MW_LEN, RPMA_MR_USAGE_WRITE_DST,
+			RPMA_F_COMPLETION_ALWAYS, MOCK_OP_CONTEXT);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+}
+
+/*
+ * bind__range_invalid -- the empty range and the range exceeding
+ * the memory region are invalid
+ */
+static void
+bind__range_invalid(void **mw_ptr)
+{
+	struct rpma_mw *mw = *mw_ptr;
+	struct {
+		size_t offset;
+		size_t len;
+	} ranges[] = {
+		{MOCK_MW_OFFSET, 0},
+		{MOCK_MR_LEN, 1},
+		{MOCK_MR_LEN + 1, MOCK_MW_LEN},
+		{MOCK_MW_OFFSET, MOCK_MR_LEN},
+		{MOCK_MW_OFFSET, SIZE_MAX},
+	};
+
+	for (int i = 0; i < sizeof(ranges) / sizeof(ranges[0]); ++i) {
+		/* configure mocks */
+		will_return(rpma_mr_get_usage, MOCK_MR_USAGE);
+
+		/* run test */
+		int ret = rpma_mw_bind(MOCK_QP, mw, MOCK_RPMA_MR_LOCAL,
+				ranges[i].offset, ranges[i].len, MOCK_MW_USAGE,
+				RPMA_F_COMPLETION_ALWAYS, MOCK_OP_CONTEXT);
+
+		/* verify the results */
+		assert_int_equal(ret, RPMA_E_INVAL);
+	}
+}
+
+/*
+ * bind__post_send_ERRNO -- ibv_post_send() fails with MOCK_ERRNO
+ */
+static void
+bind__post_send_ERRNO(void **mw_ptr)
+{
+	struct rpma_mw *mw = *mw_ptr;
+
+	/* configure mocks */
+	struct ibv_post_send_mock_args args;
+	configure_mw_bind(&args, IBV_SEND_SIGNALED, MOCK_ERRNO);
+
+	/* run test */
+	int ret = rpma_mw_bind(MOCK_QP, mw, MOCK_RPMA_MR_LOCAL,
+			MOCK_MW_OFFSET, MOCK_MW_LEN, MOCK_MW_USAGE,
+			RPMA_F_COMPLETION_ALWAYS, MOCK_OP_CONTEXT);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_PROVIDER);
+
+	/* the memory window is still not bound */
+	ret = rpma_mw_invalidate(MOCK_QP, mw, RPMA_F_COMPLETION_ALWAYS,
+			MOCK_OP_CONTEXT);
+	assert_int_equal(ret, RPMA_E_INVAL);
+}
+
+/*
+ * bind__COMPL_ON_ERROR_success -- happy day scenario
+ * with send_flags == 0 for RPMA_F_COMPLETION_ON_ERROR
+ */
+static void
+bind__COMPL_ON_ERROR_success(void **mw_ptr)
+{
+	struct rpma_mw *mw = *mw_ptr;
+
+	/* configure mocks */
+	struct ibv_post_send_mock_args args;
+	configure_mw_bind(&args, 0, MOCK_OK);
+
+	/* run test */
+	int ret = rpma_mw_bind(MOCK_QP, mw, MOCK_RPMA_MR_LOCAL,
+			MOCK_MW_OFFSET, MOCK_MW_LEN, MOCK_MW_USAGE,
+			RPMA_F_COMPLETION_ON_ERROR, MOCK_OP_CONTEXT);
+
+	/* verify the results */
+	assert_int_equal(ret, MOCK_OK);
+}
+
+/*
+ * invalidate__not_bound -- invalidating the not bound memory window
+ * is invalid
+ */
+static void
+invalidate__not_bound(void **mw_ptr)
+{
+	struct rpma_mw *mw = *mw_ptr;
+
+	/* run test */
+	int ret = rpma_mw_invalidate(MOCK_QP, mw, RPMA_F_COMPLETION_ALWAYS,
+			MOCK_OP_CONTEXT);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+}
+
+/*
+ * invalidate__post_send_ERRNO -- ibv_post_send() fails with MOCK_ERRNO
+ */
+static void
+invalidate__post_send_ERRNO(void **mw_ptr)
+{
+	struct rpma_mw *mw = *mw_ptr;
+
+	/* configure mocks */
+	struct ibv_post_send_mock_args args;
+	args.qp = MOCK_QP;
+	args.opcode = IBV_WR_LOCAL_INV;
+	args.send_flags = IBV_SEND_SIGNALED; /* for RPMA_F_COMPLETION_ALWAYS */
+	args.wr_id = (uint64_t)MOCK_OP_CONTEXT;
+	args.rkey = MOCK_MW_RKEY_BOUND;
+	args.ret = MOCK_ERRNO;
+	will_return(ibv_post_send_mock, &args);
+
+	/* run test */
+	int ret = rpma_mw_invalidate(MOCK_QP, mw, RPMA_F_COMPLETION_ALWAYS,
+			MOCK_OP_CONTEXT);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_PROVIDER);
+}
+
+/*
+ * invalidate__success -- happy day scenario; the memory window can be
+ * bound again with the next remote key
+ */
+static void
+invalidate__success(void **mw_ptr)
+{
+	struct rpma_mw *mw = *mw_ptr;
+
+	/* configure mocks */
+	struct ibv_post_send_mock_args args;
+	args.qp = MOCK_QP;
+	args.opcode = IBV_WR_LOCAL_INV;
+	args.send_flags = 0; /* for RPMA_F_COMPLETION_ON_ERROR */
+	args.wr_id = (uint64_t)MOCK_OP_CONTEXT;
+	args.rkey = MOCK_MW_RKEY_BOUND;
+	args.ret = MOCK_OK;
+	will_return(ibv_post_send_mock, &args);
+
+	/* run test */
+	int ret = rpma_mw_invalidate(MOCK_QP, mw, RPMA_F_COMPLETION_ON_ERROR,
+			MOCK_OP_CONTEXT);
+
+	/* verify the results */
+	assert_int_equal(ret, MOCK_OK);
+
+	/* configure mocks */
+	struct ibv_post_send_mock_args args_bind;
+	configure_mw_bind(&args_bind, IBV_SEND_SIGNALED, MOCK_OK);
+	args_bind.rkey = ibv_inc_rkey(MOCK_MW_RKEY_BOUND);
+
+	/* bind the memory window again */
+	ret = rpma_mw_bind(MOCK_QP, mw, MOCK_RPMA_MR_LOCAL,
+			MOCK_MW_OFFSET, MOCK_MW_LEN, MOCK_MW_USAGE,
+			RPMA_F_COMPLETION_ALWAYS, MOCK_OP_CONTEXT);
+
+	/* verify the results */
+	assert_int_equal(ret, MOCK_OK);
+}
+
+int
+main(int argc, char *argv[])
+{
+	const struct CMUnitTest tests[] = {
+		/* rpma_mw_bind() unit tests */
+		cmocka_unit_test_setup_teardown(bind__already_bound,
+			setup__mw_bound, teardown__mw_delete),
+		cmocka_unit_test_setup_teardown(bind__mr_usage_no_MW_BIND,
+			setup__mw_new, teardown__mw_delete),
+		cmocka_unit_test_setup_teardown(bind__usage_invalid,
+			setup__mw_new, teardown__mw_delete),
+		cmocka_unit_test_setup_teardown(bind__usage_not_allowed_by_mr,
+			setup__mw_new, teardown__mw_delete),
+		cmocka_unit_test_setup_teardown(bind__range_invalid,
+			setup__mw_new, teardown__mw_delete),
+		cmocka_unit_test_setup_teardown(bind__post_send_ERRNO,
+			setup__mw_new, teardown__mw_delete),
+		cmocka_unit_test_setup_teardown(bind__COMPL_ON_ERROR_success,
+			setup__mw_new, teardown__mw_delete),
+		/* the happy day scenario is done by setup__mw_bound() */
+
+		/* rpma_mw_invalidate() unit tests */
+		cmocka_unit_test_setup_teardown(invalidate__not_bound,
+			setup__mw_new, teardown__mw_delete),
+		cmocka_unit_test_setup_teardown(invalidate__post_send_ERRNO,
+			setup__mw_bound, teardown__mw_delete),
+		cmocka_unit_test_setup_teardown(invalidate__success,
+			setup__mw_bound, teardown__mw_delete),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
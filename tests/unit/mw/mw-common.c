@@ -0,0 +1,173 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * mw-common.c -- the memory window unit tests common functions
+ */
+
+#include "mocks-ibverbs.h"
+#include "mocks-stdlib.h"
+#include "mr.h"
+#include "mw.h"
+#include "mw-common.h"
+#include "peer.h"
+
+static struct ibv_mr Mock_ibv_mr = {
+	.addr = (void *)MOCK_MR_ADDR,
+	.length = MOCK_MR_LEN,
+};
+
+/*
+ * rpma_peer_mw_alloc -- rpma_peer_mw_alloc() mock
+ */
+int
+rpma_peer_mw_alloc(struct rpma_peer *peer, struct ibv_mw **ibv_mw_ptr)
+{
+	assert_ptr_equal(peer, MOCK_PEER);
+	assert_non_null(ibv_mw_ptr);
+
+	int ret = mock_type(int);
+	if (ret) {
+		*ibv_mw_ptr = NULL;
+		return ret;
+	}
+
+	Ibv_mw.rkey = MOCK_MW_RKEY;
+	*ibv_mw_ptr = MOCK_IBV_MW;
+
+	return 0;
+}
+
+/*
+ * rpma_mr_get_ibv_mr -- rpma_mr_get_ibv_mr() mock
+ */
+struct ibv_mr *
+rpma_mr_get_ibv_mr(const struct rpma_mr_local *mr)
+{
+	assert_ptr_equal(mr, MOCK_RPMA_MR_LOCAL);
+
+	return &Mock_ibv_mr;
+}
+
+/*
+ * rpma_mr_get_usage -- rpma_mr_get_usage() mock
+ */
+int
+rpma_mr_get_usage(const struct rpma_mr_local *mr)
+{
+	assert_ptr_equal(mr, MOCK_RPMA_MR_LOCAL);
+
+	return mock_type(int);
+}
+
+/*
+ * rpma_mr_encode_desc -- rpma_mr_encode_desc() mock
+ */
+void
+rpma_mr_encode_desc(uint64_t addr, uint64_t length, uint32_t rkey,
+	int usage, void *desc)
+{
+	check_expected(addr);
+	check_expected(length);
+	check_expected(rkey);
+	check_expected(usage);
+	check_expected_ptr(desc);
+}
+
+/*
+ * configure_mw_bind -- configure the mocks of binding the memory window
+ * at MOCK_MW_OFFSET of the memory region
+ */
+void
+configure_mw_bind(struct ibv_post_send_mock_args *args, unsigned send_flags,
+	int ret)
+{
+	args->qp = MOCK_QP;
+	args->opcode = IBV_WR_BIND_MW;
+	args->send_flags = send_flags;
+	args->wr_id = (uint64_t)MOCK_OP_CONTEXT;
+	args->remote_addr = MOCK_MR_ADDR + MOCK_MW_OFFSET;
+	args->rkey = MOCK_MW_RKEY_BOUND;
+	args->ret = ret;
+	will_return(rpma_mr_get_usage, MOCK_MR_USAGE);
+	will_return(ibv_post_send_mock, args);
+}
+
+/*
+ * setup__mw_new -- allocate a new memory window
+ */
+int
+setup__mw_new(void **mw_ptr)
+{
+	/*
+	 * ibv_post_send() and ibv_dealloc_mw() are defined as static inline
+	 * functions in <infiniband/verbs.h> calling the function pointers
+	 * of the verbs context so these pointers are set to the mocks.
+	 */
+	MOCK_VERBS->ops.post_send = ibv_post_send_mock;
+	Ibv_qp.context = MOCK_VERBS;
+	Ibv_context.ops.dealloc_mw = ibv_dealloc_mw_mock;
+
+	/* configure mocks */
+	will_return(__wrap__test_malloc, MOCK_OK);
+	will_return(rpma_peer_mw_alloc, MOCK_OK);
+
+	/* prepare an object */
+	struct rpma_mw *mw = NULL;
+	int ret = rpma_mw_new(MOCK_PEER, &mw);
+
+	/* verify the results */
+	assert_int_equal(ret, MOCK_OK);
+	assert_non_null(mw);
+
+	*mw_ptr = mw;
+
+	return 0;
+}
+
+/*
+ * teardown__mw_delete -- delete the memory window
+ */
+int
+teardown__mw_delete(void **mw_ptr)
+{
+	struct rpma_mw *mw = *mw_ptr;
+
+	/* configure mocks */
+	will_return(ibv_dealloc_mw_mock, MOCK_OK);
+
+	/* delete the object */
+	int ret = rpma_mw_delete(&mw);
+
+	/* verify the results */
+	assert_int_equal(ret, MOCK_OK);
+	assert_null(mw);
+
+	*mw_ptr = NULL;
+
+	return 0;
+}
+
+/*
+ * setup__mw_bound -- allocate a new memory window and bind it
+ * to the memory region
+ */
+int
+setup__mw_bound(void **mw_ptr)
+{
+	setup__mw_new(mw_ptr);
+
+	/* configure mocks */
+	struct ibv_post_send_mock_args args;
+	configure_mw_bind(&args, IBV_SEND_SIGNALED, MOCK_OK);
+
+	/* bind the memory window */
+	int ret = rpma_mw_bind(MOCK_QP, *mw_ptr, MOCK_RPMA_MR_LOCAL,
+			MOCK_MW_OFFSET, MOCK_MW_LEN, MOCK_MW_USAGE,
+			RPMA_F_COMPLETION_ALWAYS, MOCK_OP_CONTEXT);
+
+	/* verify the results */
+	assert_int_equal(ret, MOCK_OK);
+
+	return 0;
+}
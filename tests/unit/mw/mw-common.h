@@ -0,0 +1,42 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * mw-common.h -- the memory window unit tests common definitions
+ */
+
+#ifndef MW_COMMON_H
+#define MW_COMMON_H
+
+#include <infiniband/verbs.h>
+
+#include "cmocka_headers.h"
+#include "librpma.h"
+#include "mocks-ibverbs.h"
+#include "test-common.h"
+
+#define MOCK_MR_ADDR		(uint64_t)0x0001020304050000
+#define MOCK_MR_LEN		(size_t)0x10000
+#define MOCK_MR_USAGE \
+	((int)(RPMA_MR_USAGE_READ_SRC | RPMA_MR_USAGE_WRITE_DST |\
+	RPMA_MR_USAGE_FLUSH_TYPE_PERSISTENT | RPMA_MR_USAGE_MW_BIND))
+
+#define MOCK_MW_OFFSET		(size_t)0x100
+#define MOCK_MW_LEN		(size_t)0x200
+#define MOCK_MW_USAGE		RPMA_MR_USAGE_READ_SRC
+/* the usage of the bound memory window (the flush type is inherited) */
+#define MOCK_MW_USAGE_BOUND \
+	((int)(RPMA_MR_USAGE_READ_SRC | RPMA_MR_USAGE_FLUSH_TYPE_PERSISTENT))
+#define MOCK_MW_RKEY		(uint32_t)0x10111200
+/* the key of the first binding - ibv_inc_rkey(MOCK_MW_RKEY) */
+#define MOCK_MW_RKEY_BOUND	(uint32_t)0x10111201
+
+int setup__mw_new(void **mw_ptr);
+int teardown__mw_delete(void **mw_ptr);
+
+int setup__mw_bound(void **mw_ptr);
+
+void configure_mw_bind(struct ibv_post_send_mock_args *args,
+	unsigned send_flags, int ret);
+
+#endif /* MW_COMMON_H */
@@ -0,0 +1,146 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * mw-descriptor.c -- the memory window descriptor unit tests
+ *
+ * APIs covered:
+ * - rpma_mw_get_descriptor_size()
+ * - rpma_mw_get_descriptor()
+ */
+
+#include "mw-common.h"
+
+#define MOCK_MW			(struct rpma_mw *)0xC412
+#define MOCK_DESC		(void *)0xC418
+#define MR_DESC_SIZE		21
+
+/*
+ * get_descriptor_size__mw_NULL -- NULL mw is invalid
+ */
+static void
+get_descriptor_size__mw_NULL(void **unused)
+{
+	/* run test */
+	size_t desc_size = 0;
+	int ret = rpma_mw_get_descriptor_size(NULL, &desc_size);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+	assert_int_equal(desc_size, 0);
+}
+
+/*
+ * get_descriptor_size__desc_size_NULL -- NULL desc_size is invalid
+ */
+static void
+get_descriptor_size__desc_size_NULL(void **unused)
+{
+	/* run test */
+	int ret = rpma_mw_get_descriptor_size(MOCK_MW, NULL);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+}
+
+/*
+ * get_descriptor_size__success -- the size of the memory window descriptor
+ * is the size of the memory region descriptor
+ */
+static void
+get_descriptor_size__success(void **unused)
+{
+	/* run test */
+	size_t desc_size = 0;
+	int ret = rpma_mw_get_descriptor_size(MOCK_MW, &desc_size);
+
+	/* verify the results */
+	assert_int_equal(ret, MOCK_OK);
+	assert_int_equal(desc_size, MR_DESC_SIZE);
+}
+
+/*
+ * get_descriptor__mw_NULL -- NULL mw is invalid
+ */
+static void
+get_descriptor__mw_NULL(void **unused)
+{
+	/* run test */
+	int ret = rpma_mw_get_descriptor(NULL, MOCK_DESC);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+}
+
+/*
+ * get_descriptor__desc_NULL -- NULL desc is invalid
+ */
+static void
+get_descriptor__desc_NULL(void **unused)
+{
+	/* run test */
+	int ret = rpma_mw_get_descriptor(MOCK_MW, NULL);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+}
+
+/*
+ * get_descriptor__not_bound -- the not bound memory window has
+ * no descriptor
+ */
+static void
+get_descriptor__not_bound(void **mw_ptr)
+{
+	struct rpma_mw *mw = *mw_ptr;
+
+	/* run test */
+	int ret = rpma_mw_get_descriptor(mw, MOCK_DESC);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+}
+
+/*
+ * get_descriptor__success -- the descriptor of the bound memory window
+ * describes the bound range
+ */
+static void
+get_descriptor__success(void **mw_ptr)
+{
+	struct rpma_mw *mw = *mw_ptr;
+
+	/* configure mocks */
+	expect_value(rpma_mr_encode_desc, addr, MOCK_MR_ADDR + MOCK_MW_OFFSET);
+	expect_value(rpma_mr_encode_desc, length, MOCK_MW_LEN);
+	expect_value(rpma_mr_encode_desc, rkey, MOCK_MW_RKEY_BOUND);
+	expect_value(rpma_mr_encode_desc, usage, MOCK_MW_USAGE_BOUND);
+	expect_value(rpma_mr_encode_desc, desc, MOCK_DESC);
+
+	/* run test */
+	int ret = rpma_mw_get_descriptor(mw, MOCK_DESC);
+
+	/* verify the results */
+	assert_int_equal(ret, MOCK_OK);
+}
+
+int
+main(int argc, char *argv[])
+{
+	const struct CMUnitTest tests[] = {
+		/* rpma_mw_get_descriptor_size() unit tests */
+		cmocka_unit_test(get_descriptor_size__mw_NULL),
+		cmocka_unit_test(get_descriptor_size__desc_size_NULL),
+		cmocka_unit_test(get_descriptor_size__success),
+
+		/* rpma_mw_get_descriptor() unit tests */
+		cmocka_unit_test(get_descriptor__mw_NULL),
+		cmocka_unit_test(get_descriptor__desc_NULL),
+		cmocka_unit_test_setup_teardown(get_descriptor__not_bound,
+			setup__mw_new, teardown__mw_delete),
+		cmocka_unit_test_setup_teardown(get_descriptor__success,
+			setup__mw_bound, teardown__mw_delete),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
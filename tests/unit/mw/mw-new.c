@@ -0,0 +1,165 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * mw-new.c -- the memory window new/delete unit tests
+ *
+ * APIs covered:
+ * - rpma_mw_new()
+ * - rpma_mw_delete()
+ */
+
+#include "mw-common.h"
+#include "mocks-stdlib.h"
+
+/*
+ * new__peer_NULL -- NULL peer is invalid
+ */
+static void
+new__peer_NULL(void **unused)
+{
+	/* run test */
+	struct rpma_mw *mw = NULL;
+	int ret = rpma_mw_new(NULL, &mw);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+	assert_null(mw);
+}
+
+/*
+ * new__mw_ptr_NULL -- NULL mw_ptr is invalid
+ */
+static void
+new__mw_ptr_NULL(void **unused)
+{
+	/* run test */
+	int ret = rpma_mw_new(MOCK_PEER, NULL);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+}
+
+/*
+ * new__malloc_ERRNO -- malloc() fails with ENOMEM
+ */
+static void
+new__malloc_ERRNO(void **unused)
+{
+	/* configure mocks */
+	will_return(__wrap__test_malloc, ENOMEM);
+
+	/* run test */
+	struct rpma_mw *mw = NULL;
+	int ret = rpma_mw_new(MOCK_PEER, &mw);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_NOMEM);
+	assert_null(mw);
+}
+
+/*
+ * new__peer_mw_alloc_ERRNO -- rpma_peer_mw_alloc() fails
+ */
+static void
+new__peer_mw_alloc_ERRNO(void **unused)
+{
+	int errors[] = {RPMA_E_PROVIDER, RPMA_E_NOSUPP};
+
+	for (int i = 0; i < 2; ++i) {
+		/* configure mocks */
+		will_return(__wrap__test_malloc, MOCK_OK);
+		will_return(rpma_peer_mw_alloc, errors[i]);
+
+		/* run test */
+		struct rpma_mw *mw = NULL;
+		int ret = rpma_mw_new(MOCK_PEER, &mw);
+
+		/* verify the results */
+		assert_int_equal(ret, errors[i]);
+		assert_null(mw);
+	}
+}
+
+/*
+ * new__success -- happy day scenario
+ */
+static void
+new__success(void **unused)
+{
+	/*
+	 * The whole thing is done by setup__mw_new()
+	 * and teardown__mw_delete().
+	 */
+}
+
+/*
+ * delete__mw_ptr_NULL -- NULL mw_ptr is invalid
+ */
+static void
+delete__mw_ptr_NULL(void **unused)
+{
+	/* run test */
+	int ret = rpma_mw_delete(NULL);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_INVAL);
+}
+
+/*
+ * delete__mw_NULL -- NULL *mw_ptr should exit quickly
+ */
+static void
+delete__mw_NULL(void **unused)
+{
+	/* run test */
+	struct rpma_mw *mw = NULL;
+	int ret = rpma_mw_delete(&mw);
+
+	/* verify the results */
+	assert_int_equal(ret, MOCK_OK);
+	assert_null(mw);
+}
+
+/*
+ * delete__dealloc_mw_ERRNO -- ibv_dealloc_mw() fails with MOCK_ERRNO
+ */
+static void
+delete__dealloc_mw_ERRNO(void **unused)
+{
+	/* WA for cmocka/issues#47 */
+	struct rpma_mw *mw = NULL;
+	assert_int_equal(setup__mw_new((void **)&mw), 0);
+	assert_non_null(mw);
+
+	/* configure mocks */
+	will_return(ibv_dealloc_mw_mock, MOCK_ERRNO);
+
+	/* run test */
+	int ret = rpma_mw_delete(&mw);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_PROVIDER);
+	assert_null(mw);
+}
+
+int
+main(int argc, char *argv[])
+{
+	const struct CMUnitTest tests[] = {
+		/* rpma_mw_new() unit tests */
+		cmocka_unit_test(new__peer_NULL),
+		cmocka_unit_test(new__mw_ptr_NULL),
+		cmocka_unit_test(new__malloc_ERRNO),
+		cmocka_unit_test(new__peer_mw_alloc_ERRNO),
+		cmocka_unit_test_setup_teardown(new__success,
+			setup__mw_new, teardown__mw_delete),
+
+		/* rpma_mw_delete() unit tests */
+		cmocka_unit_test(delete__mw_ptr_NULL),
+		cmocka_unit_test(delete__mw_NULL),
+		cmocka_unit_test(delete__dealloc_mw_ERRNO),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
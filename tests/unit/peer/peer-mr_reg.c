@@ -69,6 +69,15 @@ static struct prestate prestates[] = {
 		RPMA_MR_USAGE_RECV,
 			IBV_ACCESS_LOCAL_WRITE,
 				MOCK_ODP_CAPABLE},
+	/* 10-11) non-iWARP and iWARP are the same */
+	{IBV_TRANSPORT_IB,
+		RPMA_MR_USAGE_MW_BIND,
+			IBV_ACCESS_MW_BIND,
+				MOCK_ODP_CAPABLE},
+	{IBV_TRANSPORT_IWARP,
+		RPMA_MR_USAGE_MW_BIND,
+			IBV_ACCESS_MW_BIND,
+				MOCK_ODP_CAPABLE},
 };
 
 /*
@@ -262,6 +271,10 @@ main(int argc, char *argv[])
 				setup__peer, teardown__peer, prestates + 8},
 		{ "mr_reg__USAGE_RECV_iWARP", mr_reg__success,
 				setup__peer, teardown__peer, prestates + 9},
+		{ "mr_reg__USAGE_MW_BIND_IB", mr_reg__success,
+				setup__peer, teardown__peer, prestates + 10},
+		{ "mr_reg__USAGE_MW_BIND_iWARP", mr_reg__success,
+				setup__peer, teardown__peer, prestates + 11},
 		cmocka_unit_test_prestate_setup_teardown(
 				mr_reg__success_odp,
 				setup__peer, teardown__peer, &prestate_OdpCapable),
@@ -0,0 +1,128 @@
+// SPDX-License-Identifier: BSD-3-Clause
+/* Copyright 2022, Intel Corporation */
+
+/*
+ * peer-mw_alloc.c -- a peer unit test
+ *
+ * API covered:
+ * - rpma_peer_mw_alloc()
+ */
+
+#include <infiniband/verbs.h>
+
+#include "cmocka_headers.h"
+#include "mocks-ibverbs.h"
+#include "mocks-rpma-utils.h"
+#include "peer.h"
+#include "peer-common.h"
+#include "test-common.h"
+
+/*
+ * mw_alloc__alloc_mw_ERRNO -- ibv_alloc_mw() fails with MOCK_ERRNO
+ */
+static void
+mw_alloc__alloc_mw_ERRNO(void **pprestate)
+{
+	struct prestate *prestate = *pprestate;
+
+	/* configure mocks */
+	Ibv_context.ops.alloc_mw = ibv_alloc_mw_mock;
+	expect_value(ibv_alloc_mw_mock, pd, MOCK_IBV_PD);
+	will_return(ibv_alloc_mw_mock, NULL);
+	will_return(ibv_alloc_mw_mock, MOCK_ERRNO);
+
+	/* run test */
+	struct ibv_mw *mw = NULL;
+	int ret = rpma_peer_mw_alloc(prestate->peer, &mw);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_PROVIDER);
+	assert_null(mw);
+}
+
+/*
+ * mw_alloc__alloc_mw_EOPNOTSUPP -- ibv_alloc_mw() fails with EOPNOTSUPP
+ */
+static void
+mw_alloc__alloc_mw_EOPNOTSUPP(void **pprestate)
+{
+	struct prestate *prestate = *pprestate;
+
+	/* configure mocks */
+	Ibv_context.ops.alloc_mw = ibv_alloc_mw_mock;
+	expect_value(ibv_alloc_mw_mock, pd, MOCK_IBV_PD);
+	will_return(ibv_alloc_mw_mock, NULL);
+	will_return(ibv_alloc_mw_mock, EOPNOTSUPP);
+
+	/* run test */
+	struct ibv_mw *mw = NULL;
+	int ret = rpma_peer_mw_alloc(prestate->peer, &mw);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_NOSUPP);
+	assert_null(mw);
+}
+
+/*
+ * mw_alloc__no_alloc_mw -- the provider does not implement ibv_alloc_mw()
+ */
+static void
+mw_alloc__no_alloc_mw(void **pprestate)
+{
+	struct prestate *prestate = *pprestate;
+
+	/* configure mocks */
+	Ibv_context.ops.alloc_mw = NULL;
+
+	/* run test */
+	struct ibv_mw *mw = NULL;
+	int ret = rpma_peer_mw_alloc(prestate->peer, &mw);
+
+	/* verify the results */
+	assert_int_equal(ret, RPMA_E_NOSUPP);
+	assert_null(mw);
+}
+
+/*
+ * mw_alloc__success -- happy day scenario
+ */
+static void
+mw_alloc__success(void **pprestate)
+{
+	struct prestate *prestate = *pprestate;
+
+	/* configure mocks */
+	Ibv_context.ops.alloc_mw = ibv_alloc_mw_mock;
+	expect_value(ibv_alloc_mw_mock, pd, MOCK_IBV_PD);
+	will_return(ibv_alloc_mw_mock, MOCK_IBV_MW);
+
+	/* run test */
+	struct ibv_mw *mw = NULL;
+	int ret = rpma_peer_mw_alloc(prestate->peer, &mw);
+
+	/* verify the results */
+	assert_int_equal(ret, MOCK_OK);
+	assert_ptr_equal(mw, MOCK_IBV_MW);
+}
+
+int
+main(int argc, char *argv[])
+{
+	const struct CMUnitTest tests[] = {
+		/* rpma_peer_mw_alloc() unit tests */
+		cmocka_unit_test_prestate_setup_teardown(
+				mw_alloc__alloc_mw_ERRNO,
+				setup__peer, teardown__peer, &prestate_OdpCapable),
+		cmocka_unit_test_prestate_setup_teardown(
+				mw_alloc__alloc_mw_EOPNOTSUPP,
+				setup__peer, teardown__peer, &prestate_OdpCapable),
+		cmocka_unit_test_prestate_setup_teardown(
+				mw_alloc__no_alloc_mw,
+				setup__peer, teardown__peer, &prestate_OdpCapable),
+		cmocka_unit_test_prestate_setup_teardown(
+				mw_alloc__success,
+				setup__peer, teardown__peer, &prestate_OdpCapable),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -297,7 +297,19 @@ class Requirement:
             return req['direct_write_to_pmem'] == \
                 config['REMOTE_DIRECT_WRITE_TO_PMEM']
 
+    class __SoftRoCE:
+        """The SoftRoCE-specific checks"""
+
+        @classmethod
+        def is_met(cls, req, config):
+            # SoftRoCE (rxe) is a software RDMA provider running over
+            # a regular network interface (e.g. the loopback one). The data
+            # never goes through an RNIC so Direct Write to PMem is not
+            # possible at all.
+            return not req['direct_write_to_pmem']
+
     __PLATFORMS = {
         "Cascade Lake": __CascadeLake,
-        "Ice Lake": __IceLake
+        "Ice Lake": __IceLake,
+        "SoftRoCE": __SoftRoCE
     }
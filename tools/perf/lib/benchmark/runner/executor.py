@@ -12,17 +12,19 @@
 
 from .fio import FioRunner
 from .ib_read import IbReadRunner
+from .rpma_bench import RpmaBenchRunner
 
 class Executor:
     """The benchmark runner executor
 
-    Depending on the workload to run it either invokes
-    `lib.benchmark.runner.fio` or `lib.benchmark.runner.ib_read`.
+    Depending on the workload to run it invokes `lib.benchmark.runner.fio`,
+    `lib.benchmark.runner.ib_read` or `lib.benchmark.runner.rpma_bench`.
     """
 
     __RUNNERS = {
         'fio': FioRunner,
-        'ib_read': IbReadRunner
+        'ib_read': IbReadRunner,
+        'rpma_bench': RpmaBenchRunner
     }
 
     @classmethod
@@ -0,0 +1,287 @@
+#!/usr/bin/env python3
+#
+# SPDX-License-Identifier: BSD-3-Clause
+# Copyright 2022, Intel Corporation
+#
+
+#
+# rpma_bench.py
+#
+
+"""the rpma-bench runner (EXPERIMENTAL)"""
+
+import json
+import os
+import random
+import shutil
+import subprocess
+import tempfile
+import time
+from datetime import datetime
+from os.path import join
+from ...common import json_from_file
+from ...remote_cmd import RemoteCmd
+from .common import UNKNOWN_VALUE_MSG, NO_X_AXIS_MSG, MISSING_KEY_MSG, \
+                    BS_VALUES, run_pre_command, run_post_command, \
+                    result_append, result_is_done, print_start_message, \
+                    verify_oneseries
+
+class RpmaBenchRunner:
+    """the rpma-bench runner
+
+    The runner executes the `rpma-bench` binary (see benchmarks/ in the root
+    directory of the repository) as the server on the remote side and as
+    the client on the local side. The client writes its results directly
+    in the format of the rows of the results (see `lib.format`).
+    """
+    def __validate(self):
+        """validate the object and readiness of the env"""
+        # check if the local rpma-bench is present
+        if shutil.which(self.__bench_path) is None:
+            raise ValueError("cannot find the local rpma-bench: {}"
+                             .format(self.__bench_path))
+        # check if the remote rpma-bench is present
+        if 'SERVER_IP' not in self.__config:
+            raise ValueError(MISSING_KEY_MSG.format('SERVER_IP'))
+        if not self.__skip_remote_cmds:
+            output = RemoteCmd.run_sync(self.__config,
+                                        ['which', self.__r_bench_path])
+            if output.exit_status != 0:
+                raise ValueError("cannot find the remote rpma-bench: {}"
+                                 .format(self.__r_bench_path))
+
+    def __init__(self, benchmark, config, idfile):
+        self.__benchmark = benchmark
+        self.__config = config
+        self.__idfile = idfile
+        self.__server = None
+        # set dumping commands
+        self.__dump_cmds = self.__config.get('DEBUG_DUMP_CMDS', False)
+        self.__skip_running_tools = \
+            self.__config.get('DEBUG_SKIP_RUNNING_TOOLS', False)
+        self.__skip_remote_cmds = \
+            self.__config.get('DEBUG_SKIP_REMOTE_CMDS', False)
+        verify_oneseries(self.__benchmark.oneseries, self.__ONESERIES_REQUIRED)
+        # pick the settings predefined for the chosen mode
+        self.__tool = self.__benchmark.oneseries['tool']
+        self.__mode = self.__benchmark.oneseries['mode']
+        self.__op = self.__benchmark.oneseries['rw']
+        self.__settings = self.__SETTINGS_BY_MODE.get(self.__mode, None)
+        if not isinstance(self.__settings, dict):
+            raise ValueError(UNKNOWN_VALUE_MSG.format('mode', self.__mode))
+        # path to the local and the remote rpma-bench
+        self.__bench_path = join(self.__config.get('RPMA_BENCH_PATH', ''),
+                                 'rpma-bench')
+        self.__r_bench_path = \
+            join(self.__config.get('REMOTE_RPMA_BENCH_PATH', ''),
+                 'rpma-bench')
+        # find the x-axis key
+        self.__x_key = None
+        for x_key in self.__X_KEYS:
+            if isinstance(self.__settings.get(x_key), list):
+                self.__x_key = x_key
+                break
+        if self.__x_key is None:
+            raise NotImplementedError(NO_X_AXIS_MSG.format(self.__mode))
+        # the atomic write always writes 8 bytes
+        if self.__op == 'atomic_write':
+            if self.__x_key == 'bs':
+                raise ValueError('the atomic_write operation cannot be run'
+                                 ' for different block sizes (mode {})'
+                                 .format(self.__mode))
+            self.__settings = {**self.__settings, 'bs': 8}
+        # load the already collected results
+        try:
+            self.__results = json_from_file(idfile)
+        except FileNotFoundError:
+            self.__results = {'input_file': idfile, 'json': []}
+        self.__data = self.__results['json']
+        self.__validate()
+
+    def __server_start(self, settings):
+        """Start the server on the remote side (using RemoteCmd)
+           and keep an object allowing to control the server.
+        """
+        print('[op: {}, size: {}, threads: {}, iodepth: {}] '\
+              '(duration: ~{}s)'
+              .format(self.__op, settings['bs'], settings['threads'],
+                      settings['iodepth'], settings['duration']))
+        r_numa_n = str(self.__config['REMOTE_JOB_NUMA'])
+        # the server exits after serving all the threads of the client
+        args = ['numactl', '-N', r_numa_n, self.__r_bench_path, 'server',
+                self.__config['SERVER_IP'], str(settings['port']),
+                '--conns=' + str(settings['threads'])]
+        # dump a command to the log file
+        if self.__dump_cmds:
+            with open(settings['logfile_server'], 'a', encoding='utf-8') as log:
+                log.write("[server]$ {}".format(' '.join(args)))
+        if not (self.__skip_running_tools or self.__skip_remote_cmds):
+            self.__server = RemoteCmd.run_async(self.__config, args)
+            time.sleep(0.1) # wait 0.1 sec for server to start listening
+
+    def __server_stop(self, settings):
+        """wait until server finishes"""
+        if self.__skip_running_tools or self.__server is None:
+            return
+        self.__server.wait()
+        stdout = self.__server.stdout.read().decode().strip()
+        stderr = self.__server.stderr.read().decode().strip()
+        with open(settings['logfile_server'], 'a', encoding='utf-8') as log:
+            log.write('\nstdout:\n{}\nstderr:\n{}\n'.format(stdout, stderr))
+
+    @staticmethod
+    def __probably_no_server(error: subprocess.CalledProcessError) -> bool:
+        """If the following error message was found in the stderr,
+           it can indicate that the server has not been started yet.
+        """
+        return 'Connection rejected' in error.stderr or \
+            'Connection unreachable' in error.stderr
+
+    def __random_results(self, settings) -> dict:
+        """generate a random row of data"""
+        keys = ['ops', 'lat_min', 'lat_max', 'lat_avg', 'lat_stdev',
+                'lat_pctl_99.0', 'lat_pctl_99.9', 'lat_pctl_99.99',
+                'lat_pctl_99.999', 'bw_avg', 'iops_avg']
+        result = {k: random.randint(0, 10) for k in keys}
+        result.update({'op': self.__op, 'threads': settings['threads'],
+                       'iodepth': settings['iodepth'], 'bs': settings['bs']})
+        return result
+
+    def __client_run(self, settings):
+        """run the client (locally) and wait till the end of execution"""
+        if self.__skip_running_tools:
+            return self.__random_results(settings)
+        numa_n = str(self.__config['JOB_NUMA'])
+        duration = 1 if self.__config.get('DEBUG_SHORT_RUNTIME', False) \
+            else self.__config.get('RPMA_BENCH_DURATION', settings['duration'])
+        fd, json_path = tempfile.mkstemp(prefix='rpma_bench_', suffix='.json')
+        os.close(fd)
+        args = ['numactl', '-N', numa_n, self.__bench_path, 'client',
+                self.__config['SERVER_IP'], str(settings['port']),
+                '--op=' + self.__op, '--bs=' + str(settings['bs']),
+                '--qd=' + str(settings['iodepth']),
+                '--threads=' + str(settings['threads']),
+                '--duration=' + str(duration), '--json=' + json_path]
+        # dump a command to the log file
+        if self.__dump_cmds:
+            with open(settings['logfile_client'], 'a', encoding='utf-8') as log:
+                log.write("[client]$ {}".format(' '.join(args)))
+
+        # try to connect with the server 10 times at most
+        counter = 1
+        while True:
+            try:
+                ret = subprocess.run(args, check=True,
+                                     stdout=subprocess.PIPE,
+                                     stderr=subprocess.PIPE,
+                                     encoding='utf-8')
+                break
+            except subprocess.CalledProcessError as err:
+                if not self.__probably_no_server(err) or counter == 10:
+                    print('\nstdout:\n{}\nstderr:\n{}\n'
+                          .format(err.stdout, err.stderr))
+                    os.remove(json_path)
+                    self.__server_stop(settings)
+                    run_post_command(self.__config,
+                                     self.__benchmark.oneseries)
+                    raise # re-raise the current exception
+                print('Retrying #{} ...'.format(counter))
+                time.sleep(0.1) # wait 0.1 sec for server to start listening
+                counter = counter + 1
+
+        # save the output in the log file
+        with open(settings['logfile_client'], 'a', encoding='utf-8') as log:
+            log.write('\nstdout:\n{}\nstderr:\n{}\n'
+                      .format(ret.stdout, ret.stderr))
+        with open(json_path, 'r', encoding='utf-8') as file:
+            rows = json.load(file)
+        os.remove(json_path)
+        # a single combination of bs, iodepth and threads is run at once
+        return rows[0]
+
+    def __result_append(self, _, y_value: dict):
+        """append new result to internal __data and the '__idfile' file"""
+        result_append(self.__data, self.__idfile, y_value)
+
+    def __result_is_done(self, x_value: int):
+        """check if the result for the given x value is already collected"""
+        return result_is_done(self.__data, self.__x_key, x_value)
+
+    def __set_log_files_names(self):
+        """set names of log files"""
+        time_stamp = datetime.now().strftime("%Y-%m-%d-%H:%M:%S.%f")
+        name = '/tmp/{}_{}_{}-{}'.format(self.__tool, self.__op, self.__mode,
+                                         time_stamp)
+        self.__settings['logfile_server'] = name + '-server.log'
+        self.__settings['logfile_client'] = name + '-client.log'
+        print('Server log: {}'.format(self.__settings['logfile_server']))
+        print('Client log: {}'.format(self.__settings['logfile_client']))
+
+    def run(self):
+        """collects the `benchmark` results using `rpma-bench`
+
+        For each of the x values:
+
+        1. starts the `rpma-bench` server on the remote side.
+        2. starts and waits for the `rpma-bench` client to the end.
+            - the results are collected and written to the `idfile` file.
+        3. waits for the `rpma-bench` server to exit (it exits after
+           the connections of all the threads of the client are closed).
+        """
+        print_start_message(self.__mode, self.__benchmark.oneseries,
+                            self.__config)
+        self.__set_log_files_names()
+        # benchmarks are run for all x values one-by-one
+        for x_value in self.__settings[self.__x_key]:
+            if self.__result_is_done(x_value):
+                continue
+            # prepare settings for the current x-axis value
+            settings = self.__settings.copy()
+            settings[self.__x_key] = x_value
+            settings['port'] = self.__config.get('RPMA_BENCH_PORT', 7204)
+            pre_cmd = run_pre_command(self.__config,
+                                      self.__benchmark.oneseries, x_value)
+            self.__server_start(settings)
+            y_value = self.__client_run(settings)
+            self.__server_stop(settings)
+            run_post_command(self.__config, self.__benchmark.oneseries, pre_cmd)
+            self.__result_append(x_value, y_value)
+
+    __ONESERIES_REQUIRED = {
+        'tool': ['rpma_bench'],
+        'mode': ['lat', 'bw-bs', 'bw-dp-exp', 'bw-th'],
+        'rw': ['read', 'write', 'flush', 'send', 'atomic_write'],
+        'filetype': ['malloc']
+    }
+
+    __X_KEYS = ['threads', 'bs', 'iodepth']
+
+    # the measured time of every x value [s]
+    __DURATION = 60
+
+    __SETTINGS_BY_MODE = {
+        'lat': {
+            'threads': 1,
+            'bs': BS_VALUES,
+            'iodepth': 1,
+            'duration': __DURATION
+        },
+        'bw-bs': {
+            'threads': 1,
+            'bs': BS_VALUES,
+            'iodepth': 2,
+            'duration': __DURATION
+        },
+        'bw-dp-exp': {
+            'threads': 1,
+            'bs': 4096,
+            'iodepth': [1, 2, 4, 8, 16, 32, 64, 128],
+            'duration': __DURATION
+        },
+        'bw-th': {
+            'threads': [1, 2, 4, 8, 12],
+            'bs': 4096,
+            'iodepth': 2,
+            'duration': __DURATION
+        }
+    }
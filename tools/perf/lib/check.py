@@ -0,0 +1,224 @@
+#!/usr/bin/env python3
+#
+# SPDX-License-Identifier: BSD-3-Clause
+# Copyright 2022, Intel Corporation
+#
+
+#
+# check.py
+#
+
+"""checking benchmarks results against a baseline (EXPERIMENTAL)
+
+The same set of figures is benchmarked a few times (runs) in order to estimate
+the noise of every data point. The collected samples can be either stored as
+a new baseline or checked against the existing one.
+
+A baseline is a JSON file of the following form:
+
+```json
+{
+    "runs": 3,
+    "tolerances": {
+        "default": 10,
+        "lat_pctl_99.9": 25
+    },
+    "figures": {
+        "<file>.<key>": {
+            "x": "bs",
+            "y": "lat_avg",
+            "series": {
+                "<label>": [[<x>, <mean>, <stdev>], ...]
+            }
+        }
+    }
+}
+```
+
+Where `tolerances` are the allowed changes (in percents of the baseline value)
+of the y-axis values, per the y-axis key with the `default` value for all
+the other keys. A data point regresses when it changes for the worse
+(see `Check.higher_is_better()`) by more than its tolerance and by more than
+`Check.NOISE_SIGMAS` standard errors of the difference of the means
+of the runs at the same time, so the noise of the measurements does not make
+the check fail.
+"""
+
+import json
+import math
+
+#: the tolerance of the y-axis keys not listed in the baseline [%]
+DEFAULT_TOLERANCE = 10
+
+def collect(benches: list) -> dict:
+    """collect the samples of all data points from all runs
+
+    Args:
+        benches: a list of completed `lib.bench.Bench` objects (runs) of
+          the same set of figures
+
+    Returns:
+        A dictionary `{figure_id: {'x': x, 'y': y, 'series':
+        {label: {x_value: [y_value, ...]}}}}` where the list of the y values
+        contains one value per run.
+    """
+    samples = {}
+    for bench in benches:
+        for figure in bench.figures:
+            figure_id = '{}.{}'.format(figure.file, figure.key)
+            fig = samples.setdefault(figure_id, {
+                'x': figure.argx, 'y': figure.argy, 'series': {}})
+            for oneseries in figure.results:
+                points = fig['series'].setdefault(oneseries['label'], {})
+                for x_value, y_value in oneseries['points']:
+                    points.setdefault(x_value, []).append(y_value)
+    return samples
+
+def mean_stdev(values: list) -> tuple:
+    """the mean and the (sample) standard deviation of the values"""
+    mean = sum(values) / len(values)
+    if len(values) < 2:
+        return mean, 0.0
+    var = sum((v - mean) ** 2 for v in values) / (len(values) - 1)
+    return mean, math.sqrt(var)
+
+def new_baseline(samples: dict, runs: int, tolerances: dict = None) -> dict:
+    """create a baseline of the collected samples
+
+    Args:
+        samples: the samples of the data points (see `collect()`)
+        runs: the number of runs the samples come from
+        tolerances: the tolerances of the baseline (if `None`, the default
+          tolerance is used for all the y-axis keys)
+
+    Returns:
+        A baseline (see the module description).
+    """
+    figures = {}
+    for figure_id, fig in samples.items():
+        series = {}
+        for label, points in fig['series'].items():
+            series[label] = [[x_value, *mean_stdev(y_values)]
+                             for x_value, y_values in points.items()]
+        figures[figure_id] = {'x': fig['x'], 'y': fig['y'], 'series': series}
+    if tolerances is None:
+        tolerances = {'default': DEFAULT_TOLERANCE}
+    return {'runs': runs, 'tolerances': tolerances, 'figures': figures}
+
+class Check:
+    """a check of the collected samples against a baseline"""
+
+    #: the number of the standard errors the noise may change a value by
+    NOISE_SIGMAS = 3
+
+    #: the prefixes of the y-axis keys the higher values of which are better
+    __HIGHER_IS_BETTER = ('bw_', 'iops_')
+
+    OK = 'ok'
+    IMPROVED = 'improved'
+    REGRESSION = 'REGRESSION'
+    MISSING = 'MISSING'
+    NEW = 'new'
+
+    def __init__(self, baseline: dict, samples: dict, runs: int,
+                 tolerances: dict = None):
+        """Args:
+            baseline: the baseline (see the module description)
+            samples: the samples of the data points (see `collect()`)
+            runs: the number of runs the samples come from
+            tolerances: the tolerances overriding the ones of the baseline
+        """
+        self.__tolerances = {'default': DEFAULT_TOLERANCE,
+                             **baseline.get('tolerances', {}),
+                             **(tolerances or {})}
+        self.__rows = []
+        base_runs = baseline.get('runs', 1)
+        new = new_baseline(samples, runs)['figures']
+        for figure_id, base_fig in baseline['figures'].items():
+            new_fig = new.get(figure_id, {'series': {}})
+            for label, base_points in base_fig['series'].items():
+                new_points = {p[0]: p[1:]
+                              for p in new_fig['series'].get(label, [])}
+                for x_value, base_mean, base_stdev in base_points:
+                    row = {'figure': figure_id, 'label': label,
+                           'x': base_fig['x'], 'x_value': x_value,
+                           'y': base_fig['y'], 'base': base_mean,
+                           'new': None, 'change': None}
+                    if x_value not in new_points:
+                        row['status'] = self.MISSING
+                    else:
+                        new_mean, new_stdev = new_points.pop(x_value)
+                        noise = self.NOISE_SIGMAS * math.sqrt(
+                            base_stdev ** 2 / base_runs +
+                            new_stdev ** 2 / runs)
+                        row.update(self.__verdict(base_fig['y'], base_mean,
+                                                  new_mean, noise))
+                    self.__rows.append(row)
+                # the points which are not in the baseline
+                for x_value, (new_mean, _) in new_points.items():
+                    self.__rows.append({
+                        'figure': figure_id, 'label': label,
+                        'x': base_fig['x'], 'x_value': x_value,
+                        'y': base_fig['y'], 'base': None, 'new': new_mean,
+                        'change': None, 'status': self.NEW})
+
+    @classmethod
+    def higher_is_better(cls, y_key: str) -> bool:
+        """Are the higher values of the y-axis key better?
+
+        The higher bandwidth and IOPS are better. The lower values of all
+        the other keys (e.g. latencies or CPU load) are better.
+        """
+        return y_key.startswith(cls.__HIGHER_IS_BETTER)
+
+    def tolerance(self, y_key: str) -> float:
+        """the tolerance of the y-axis key [%]"""
+        return self.__tolerances.get(y_key, self.__tolerances['default'])
+
+    def __verdict(self, y_key: str, base: float, new: float,
+                  noise: float) -> dict:
+        """judge the change of a data point"""
+        # the change for the worse is positive
+        worse = base - new if self.higher_is_better(y_key) else new - base
+        change = 100 * (new - base) / base if base else 0.0
+        allowed = abs(base) * self.tolerance(y_key) / 100
+        if worse > allowed and worse > noise:
+            status = self.REGRESSION
+        elif -worse > allowed and -worse > noise:
+            status = self.IMPROVED
+        else:
+            status = self.OK
+        return {'new': new, 'change': change, 'status': status}
+
+    @property
+    def rows(self) -> list:
+        """the verdicts of all the data points (a list of dicts)"""
+        return [row.copy() for row in self.__rows]
+
+    def passed(self) -> bool:
+        """Has no data point regressed or gone missing?"""
+        return all(row['status'] not in (self.REGRESSION, self.MISSING)
+                   for row in self.__rows)
+
+    def report(self) -> str:
+        """a human-readable report of the check"""
+        lines = []
+        for row in self.__rows:
+            base = '-' if row['base'] is None else '{:.2f}'.format(row['base'])
+            new = '-' if row['new'] is None else '{:.2f}'.format(row['new'])
+            change = '' if row['change'] is None else \
+                ' ({:+.1f}%, tolerance {}%)'.format(row['change'],
+                                                   self.tolerance(row['y']))
+            lines.append('{}: {} [{}={}] {}: {} -> {}{} {}'.format(
+                row['figure'], row['label'], row['x'], row['x_value'],
+                row['y'], base, new, change, row['status']))
+        failed = [row for row in self.__rows
+                  if row['status'] in (self.REGRESSION, self.MISSING)]
+        lines.append('Check {}: {} of {} data points regressed or missing.'
+                     .format('passed' if not failed else 'FAILED',
+                             len(failed), len(self.__rows)))
+        return '\n'.join(lines)
+
+    def to_json(self) -> str:
+        """the verdicts of all the data points as JSON"""
+        return json.dumps(self.__rows, indent=4)
@@ -26,12 +26,23 @@ together, please see `lib`.
 
 When this script is done with all required benchmarks you will probably continue
 processing the results with `report_figures` and `report_create`.
+
+The `check` command runs the set of benchmarks a few times and checks
+the results against a baseline (see `lib.check`). It exits with 1 when any
+data point regresses (or is missing) and with 2 when the benchmarking is not
+complete, so it can be used to catch the performance regressions before
+a release.
 """
 
 import argparse
+import json
+import os
+import sys
+from copy import deepcopy
 
 from lib.common import json_from_file, dir_path
 from lib.bench import Bench
+from lib.check import Check, collect, new_baseline
 
 PARSER = argparse.ArgumentParser(
     description="Executes a set of benchmarks (EXPERIMENTAL)")
@@ -59,9 +70,90 @@ PARSER_C.add_argument('--bench', type=json_from_file, required=True,
 PARSER_C.add_argument('--skip_undone', dest='skip_undone', action='store_true',
                       help='skip not yet done benchmarks')
 
+PARSER_K = SUBPARSERS.add_parser('check', help='''run a set of benchmarks a few times and check the results against a baseline''')
+PARSER_K.add_argument('--config', type=json_from_file, required=True,
+                      help='''a config.json file describing the configuration of the benchmarking system''')
+PARSER_K.add_argument('--figures', type=json_from_file, required=True,
+                      help='''a set of JSON files describing what benchmarks are required to be done in a form of figures containing series of data points''',
+                      nargs='+')
+PARSER_K.add_argument('--baseline', type=str, required=True,
+                      help='''a baseline JSON file the results are checked against (or written to with --update_baseline)''')
+PARSER_K.add_argument('--result_dir', type=dir_path, required=True,
+                      help='''a directory where the intermediate and final products of all the runs will be stored (an interrupted check is resumed)''')
+PARSER_K.add_argument('--runs', type=int, default=3,
+                      help='''a number of runs of the set of benchmarks used to estimate the noise of the results (default: 3)''')
+PARSER_K.add_argument('--tolerance', type=str, default=[], nargs='+',
+                      metavar='KEY=PERCENT',
+                      help='''the allowed change of the values of the y-axis key in percents overriding the tolerance of the baseline (e.g. lat_avg=15 or default=10)''')
+PARSER_K.add_argument('--update_baseline', dest='update_baseline',
+                      action='store_true',
+                      help='''write the results as a new baseline instead of checking them''')
+PARSER_K.add_argument('--dummy_results', dest='dummy_results',
+                      action='store_true',
+                      help='''generate dummy results instead of running actual benchmarks''')
+
+def parse_tolerances(tolerances: list) -> dict:
+    """parse the KEY=PERCENT tolerances"""
+    output = {}
+    for tolerance in tolerances:
+        key, sep, value = tolerance.partition('=')
+        if not sep or not key:
+            raise ValueError('Invalid tolerance: ' + tolerance)
+        output[key] = float(value)
+    return output
+
+def check(args) -> int:
+    """run the benchmarks `args.runs` times and check the results against
+    the baseline (or write them down as a new baseline)
+
+    Returns:
+        0 if the check has passed, 1 if it has failed and 2 if
+        the benchmarking is not complete.
+    """
+    if args.runs < 1:
+        raise ValueError('--runs has to be at least 1')
+    tolerances = parse_tolerances(args.tolerance)
+    args.config['json']['dummy_results'] = args.dummy_results
+    benches = []
+    for run in range(args.runs):
+        print('Run {} of {}'.format(run + 1, args.runs))
+        run_dir = dir_path(os.path.join(args.result_dir,
+                                        'run_{}'.format(run)))
+        # resume the run if it has been interrupted
+        cache = os.path.join(run_dir, 'bench.json')
+        if os.path.isfile(cache):
+            bench = Bench.carry_on(json_from_file(cache))
+        else:
+            bench = Bench.new(deepcopy(args.config), args.figures, run_dir)
+            bench.cache()
+        if not bench.run():
+            print('Benchmarking incomplete.')
+            return 2
+        benches.append(bench)
+    samples = collect(benches)
+    if args.update_baseline:
+        # keep the tolerances of the existing baseline
+        if os.path.isfile(args.baseline):
+            old = json_from_file(args.baseline)['json']
+            tolerances = {**old.get('tolerances', {}), **tolerances}
+        baseline = new_baseline(samples, args.runs, tolerances or None)
+        with open(args.baseline, 'w', encoding='utf-8') as file:
+            json.dump(baseline, file, indent=4)
+        print('Baseline written: ' + args.baseline)
+        return 0
+    baseline = json_from_file(args.baseline)['json']
+    result = Check(baseline, samples, args.runs, tolerances)
+    print(result.report())
+    with open(os.path.join(args.result_dir, 'check.json'), 'w',
+              encoding='utf-8') as file:
+        file.write(result.to_json())
+    return 0 if result.passed() else 1
+
 def main():
     """I'm main"""
     args = PARSER.parse_args()
+    if args.command == "check":
+        sys.exit(check(args))
     if args.command == "run":
         # modify config according to command line arguments
         args.config['json']['dummy_results'] = args.dummy_results
@@ -24,6 +24,10 @@ __ONESERIES_IB_READ = \
     'mode': 'lat', 'rw': 'read', 'filetype': 'malloc',
     'requirements': {'direct_write_to_pmem': True}}}
 
+__ONESERIES_RPMA_BENCH = \
+    {**__ONESERIES_DUMMY, **{'tool': 'rpma_bench', 'mode': 'lat',
+    'rw': 'read', 'filetype': 'malloc'}}
+
 @pytest.fixture(scope='function', name='oneseries_dummy')
 def __oneseries_dummy():
     """provide a oneseries dummy"""
@@ -44,6 +48,11 @@ def __oneseries_ib_read():
     """provide a fio oneseries"""
     return __ONESERIES_IB_READ.copy()
 
+@pytest.fixture(scope='function', name='oneseries_rpma_bench')
+def __oneseries_rpma_bench():
+    """provide an rpma_bench oneseries"""
+    return __ONESERIES_RPMA_BENCH.copy()
+
 @pytest.fixture(scope='function')
 def benchmark_dummy(oneseries_dummy):
     """create a dummy Benchmark instance"""
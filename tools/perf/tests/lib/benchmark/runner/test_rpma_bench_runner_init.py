@@ -0,0 +1,95 @@
+#!/usr/bin/env python3
+#
+# SPDX-License-Identifier: BSD-3-Clause
+# Copyright 2022, Intel Corporation
+#
+
+"""test_rpma_bench_runner_init.py
+   -- lib.benchmark.runner.rpma_bench.RpmaBenchRunner init tests"""
+
+import shutil
+import pytest
+
+import lib.benchmark
+import lib.benchmark.runner
+import lib.benchmark.runner.rpma_bench
+
+from lib.remote_cmd import RemoteCmd
+from lib.benchmark.runner.rpma_bench import RpmaBenchRunner
+
+__CONFIG_RPMA_BENCH = {'SERVER_IP': 'SERVER_IP'}
+
+@pytest.fixture(scope='function', name='config_rpma_bench')
+def __config_rpma_bench():
+    """provide an rpma_bench config"""
+    return __CONFIG_RPMA_BENCH.copy()
+
+def which_mock(path: str) -> str:
+    """mock of shutil.which()"""
+    assert path == 'rpma-bench'
+    return path
+
+def run_sync_mock(_arg1, _arg2) -> RemoteCmd:
+    """mock of RemoteCmd.run_sync()"""
+    return RemoteCmd(None, None, None, exit_status=0)
+
+def test_rpma_bench_runner_init(oneseries_rpma_bench, config_rpma_bench,
+        monkeypatch):
+    """test proper initialization of RpmaBenchRunner object
+       with all mandatory parameters
+    """
+    def run_mock(_self) -> None:
+        """mock of RpmaBenchRunner.run()"""
+
+    monkeypatch.setattr(shutil, 'which', which_mock)
+    monkeypatch.setattr(RemoteCmd, 'run_sync', run_sync_mock)
+    monkeypatch.setattr(RpmaBenchRunner, 'run', run_mock)
+
+    benchmark = lib.benchmark.Benchmark(oneseries_rpma_bench)
+    runner = RpmaBenchRunner(benchmark, config_rpma_bench, 'idfile')
+    runner.run()
+
+    #pylint: disable=protected-access
+    #pylint: disable=no-member
+    assert runner._RpmaBenchRunner__benchmark == benchmark
+    assert runner._RpmaBenchRunner__config == config_rpma_bench
+    assert runner._RpmaBenchRunner__idfile == 'idfile'
+    assert runner._RpmaBenchRunner__tool == oneseries_rpma_bench['tool']
+    assert runner._RpmaBenchRunner__mode == oneseries_rpma_bench['mode']
+    assert runner._RpmaBenchRunner__op == oneseries_rpma_bench['rw']
+    #pylint: enable=no-member
+    #pylint: enable=protected-access
+
+@pytest.mark.parametrize('key', ['tool', 'mode', 'rw', 'filetype'])
+def test_rpma_bench_runner_init_oneseries_incomplete(oneseries_rpma_bench,
+        config_rpma_bench, key):
+    """failed initialization of RpmaBenchRunner object - incomplete oneseries"""
+    oneseries = {**oneseries_rpma_bench}
+    oneseries.pop(key)
+    benchmark = lib.benchmark.Benchmark(oneseries)
+    with pytest.raises(ValueError):
+        RpmaBenchRunner(benchmark, config_rpma_bench, 'idfile')
+
+@pytest.mark.parametrize('key', ['tool', 'mode', 'rw', 'filetype'])
+def test_rpma_bench_runner_init_wrong_value(oneseries_rpma_bench,
+        config_rpma_bench, key):
+    """failed initialization of RpmaBenchRunner object -
+       - invalid value provided
+    """
+    oneseries = {**oneseries_rpma_bench}
+    oneseries[key] = 'an incorrect value'
+    benchmark = lib.benchmark.Benchmark(oneseries)
+    with pytest.raises(ValueError):
+        RpmaBenchRunner(benchmark, config_rpma_bench, 'idfile')
+
+def test_rpma_bench_runner_init_atomic_write_bs(oneseries_rpma_bench,
+        config_rpma_bench, monkeypatch):
+    """failed initialization of RpmaBenchRunner object -
+       - the atomic write for different block sizes
+    """
+    monkeypatch.setattr(shutil, 'which', which_mock)
+    monkeypatch.setattr(RemoteCmd, 'run_sync', run_sync_mock)
+    oneseries = {**oneseries_rpma_bench, 'rw': 'atomic_write', 'mode': 'lat'}
+    benchmark = lib.benchmark.Benchmark(oneseries)
+    with pytest.raises(ValueError):
+        RpmaBenchRunner(benchmark, config_rpma_bench, 'idfile')
@@ -0,0 +1,7 @@
+#!/usr/bin/env python3
+#
+# SPDX-License-Identifier: BSD-3-Clause
+# Copyright 2022, Intel Corporation
+#
+
+"""__init__.py -- required for python imports (intentionally empty)"""
@@ -0,0 +1,78 @@
+#!/usr/bin/env python3
+#
+# SPDX-License-Identifier: BSD-3-Clause
+# Copyright 2022, Intel Corporation
+#
+
+"""test_check.py -- lib.check tests"""
+
+import json
+
+import pytest
+
+from lib.check import Check, DEFAULT_TOLERANCE, mean_stdev, new_baseline
+
+FIGURE_ID = 'file.lat_avg'
+LABEL = 'rpma_read()'
+
+def samples_of(y_key, points):
+    """the samples of a single-series figure"""
+    return {FIGURE_ID: {'x': 'bs', 'y': y_key,
+                        'series': {LABEL: points}}}
+
+def check_of(y_key, base_points, new_points, tolerances=None):
+    """check the new samples against the baseline of the base samples"""
+    baseline = new_baseline(samples_of(y_key, base_points), 3)
+    # a baseline is written to and read from a JSON file
+    baseline = json.loads(json.dumps(baseline))
+    return Check(baseline, samples_of(y_key, new_points), 3, tolerances)
+
+def statuses(check):
+    """the statuses of all the data points"""
+    return [row['status'] for row in check.rows]
+
+def test_mean_stdev():
+    """the mean and the sample standard deviation"""
+    assert mean_stdev([2, 4, 6]) == (4, 2)
+    assert mean_stdev([5]) == (5, 0)
+
+def test_new_baseline():
+    """the baseline holds the mean and the stdev of every data point"""
+    baseline = new_baseline(samples_of('lat_avg', {64: [2, 4, 6]}), 3)
+    assert baseline['runs'] == 3
+    assert baseline['tolerances'] == {'default': DEFAULT_TOLERANCE}
+    assert baseline['figures'][FIGURE_ID]['series'][LABEL] == [[64, 4, 2]]
+
+@pytest.mark.parametrize('y_key, new, exp',
+    [('lat_avg', 100, Check.OK), ('lat_avg', 105, Check.OK),
+     ('lat_avg', 150, Check.REGRESSION), ('lat_avg', 50, Check.IMPROVED),
+     ('bw_avg', 50, Check.REGRESSION), ('bw_avg', 150, Check.IMPROVED),
+     ('iops_avg', 105, Check.OK)])
+def test_verdict(y_key, new, exp):
+    """the direction of the change depends on the y-axis key"""
+    check = check_of(y_key, {64: [100, 100, 100]}, {64: [new, new, new]})
+    assert statuses(check) == [exp]
+    assert check.passed() == (exp != Check.REGRESSION)
+
+def test_noise():
+    """a change within the noise of the runs is not a regression"""
+    check = check_of('lat_avg', {64: [50, 100, 150]}, {64: [90, 130, 170]})
+    assert statuses(check) == [Check.OK]
+    assert check.passed()
+
+def test_tolerance():
+    """the tolerances given to the check override the ones of the baseline"""
+    check = check_of('lat_avg', {64: [100, 100, 100]},
+                     {64: [130, 130, 130]}, {'lat_avg': 50})
+    assert check.tolerance('lat_avg') == 50
+    assert check.tolerance('bw_avg') == DEFAULT_TOLERANCE
+    assert statuses(check) == [Check.OK]
+
+def test_missing_and_new():
+    """a missing data point fails the check whereas a new one does not"""
+    check = check_of('lat_avg', {64: [100, 100, 100]},
+                     {128: [100, 100, 100]})
+    assert sorted(statuses(check)) == sorted([Check.MISSING, Check.NEW])
+    assert not check.passed()
+    assert check.report().endswith(
+        'Check FAILED: 1 of 2 data points regressed or missing.')
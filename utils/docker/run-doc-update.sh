@@ -76,7 +76,7 @@ set_up_repo ${ORIGIN_RPMA} ${UPSTREAM_RPMA} rpma ${SOURCE_BRANCH}
 # build docs
 mkdir ${WORKDIR}/rpma/build
 cd ${WORKDIR}/rpma/build
-cmake -DBUILD_TESTS=OFF -DBUILD_EXAMPLES=OFF ..
+cmake -DBUILD_TESTS=OFF -DBUILD_EXAMPLES=OFF -DBUILD_BENCHMARKS=OFF ..
 make -j$(nproc) doc
 # copy Markdown files outside the repo
 cp -R doc/md ${WORKDIR}